@@ -23,6 +23,7 @@
 #include "itkBSplineKernelFunction.h"
 #include "itkArray.h"
 #include "itkArray2D.h"
+#include "itkMath.h"
 
 namespace itk
 {
@@ -75,6 +76,10 @@ public:
   /** Spline order. */
   static constexpr unsigned int SplineOrder = VSplineOrder;
 
+  /** Number of weights, known at compile time. */
+  static constexpr unsigned int NumberOfWeights =
+    static_cast< unsigned int >( Math::UnsignedPower( VSplineOrder + 1, VSpaceDimension ) );
+
   /** OutputType type alias support. */
   using WeightsType = Array< double >;
 
@@ -33,9 +33,7 @@ BSplineInterpolationWeightFunction< TCoordRep, VSpaceDimension, VSplineOrder >
 ::BSplineInterpolationWeightFunction()
 {
   // Initialize the number of weights;
-  m_NumberOfWeights =
-    static_cast< unsigned int >( std::pow( static_cast< double >( SplineOrder + 1 ),
-                                          static_cast< double >( SpaceDimension ) ) );
+  m_NumberOfWeights = NumberOfWeights;
 
   // Initialize support region is a hypercube of length SplineOrder + 1
   m_SupportSize.Fill(SplineOrder + 1);
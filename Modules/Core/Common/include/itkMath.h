@@ -740,6 +740,14 @@ ITKCommon_EXPORT unsigned long      GreatestPrimeFactor( unsigned long n );
 ITKCommon_EXPORT unsigned long long GreatestPrimeFactor( unsigned long long n );
 
 
+/** Return base raised to the power exponent, for unsigned integers. This is
+ * a constant expression when the arguments are, e.g. to size arrays. */
+constexpr uintmax_t UnsignedPower( const uintmax_t base, const uintmax_t exponent )
+{
+  return ( exponent == 0 ) ? 1 : base * UnsignedPower( base, exponent - 1 );
+}
+
+
 /*==========================================
  * Alias the vnl_math functions in the itk::Math
  * namespace. If possible, use the std:: equivalents
@@ -275,7 +275,24 @@ public:
   void ComputeJacobianFromBSplineWeightsWithRespectToPosition(
     const InputPointType &, WeightsType &, ParameterIndexArrayType & ) const;
 
-  void ComputeJacobianWithRespectToParameters( const InputPointType &, JacobianType & ) const override = 0;
+  /** Compute the Jacobian with respect to the parameters at a point, from
+   * its sparse form. */
+  void ComputeJacobianWithRespectToParameters( const InputPointType &, JacobianType & ) const override;
+
+  /** Return the number of weights of the support region, which is the number
+   * of parameters each row of the sparse Jacobian depends on. */
+  NumberOfParametersType GetNumberOfSparseJacobianParameters() const override
+  {
+    return WeightsFunctionType::NumberOfWeights;
+  }
+
+  /** Compute the sparse Jacobian with respect to the parameters at a point,
+   * without allocating memory. Row d holds the interpolation weights of the
+   * support region, at the parameters of the coefficients of dimension d.
+   * The Jacobian is zero where the support region does not lie totally
+   * within the grid. */
+  NumberOfParametersType ComputeSparseJacobianWithRespectToParameters( const InputPointType &,
+    ParametersValueType * weights, NumberOfParametersType * parameterIndices ) const override;
 
   void ComputeJacobianWithRespectToPosition( const InputPointType &, JacobianType & ) const override
   {
@@ -305,6 +305,93 @@ BSplineBaseTransform<TParametersValueType, NDimensions, VSplineOrder>
     }
 }
 
+template<typename TParametersValueType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+BSplineBaseTransform<TParametersValueType, NDimensions, VSplineOrder>
+::ComputeJacobianWithRespectToParameters( const InputPointType & point,
+  JacobianType & jacobian ) const
+{
+  // Zero all components of jacobian
+  jacobian.SetSize( SpaceDimension, this->GetNumberOfParameters() );
+  jacobian.Fill( 0.0 );
+
+  constexpr unsigned int NumberOfWeights = WeightsFunctionType::NumberOfWeights;
+  FixedArray<ParametersValueType, SpaceDimension * NumberOfWeights>    weights;
+  FixedArray<NumberOfParametersType, SpaceDimension * NumberOfWeights> parameterIndices;
+  const NumberOfParametersType numberOfWeights = this->ComputeSparseJacobianWithRespectToParameters( point,
+    weights.GetDataPointer(), parameterIndices.GetDataPointer() );
+
+  for( unsigned int d = 0; d < SpaceDimension; d++ )
+    {
+    for( NumberOfParametersType k = 0; k < numberOfWeights; k++ )
+      {
+      jacobian( d, parameterIndices[d * NumberOfWeights + k] ) = weights[d * NumberOfWeights + k];
+      }
+    }
+}
+
+template<typename TParametersValueType, unsigned int NDimensions, unsigned int VSplineOrder>
+typename BSplineBaseTransform<TParametersValueType, NDimensions, VSplineOrder>::NumberOfParametersType
+BSplineBaseTransform<TParametersValueType, NDimensions, VSplineOrder>
+::ComputeSparseJacobianWithRespectToParameters( const InputPointType & point,
+  ParametersValueType * weights, NumberOfParametersType * parameterIndices ) const
+{
+  ContinuousIndexType index;
+  this->m_CoefficientImages[0]->TransformPhysicalPointToContinuousIndex( point, index );
+
+  // NOTE: if the support region does not lie totally within the grid we
+  // assume zero displacement, hence a zero Jacobian.
+  if( !this->InsideValidRegion( index ) )
+    {
+    return 0;
+    }
+
+  // Compute the interpolation weights in a buffer on the stack.
+  constexpr unsigned int NumberOfWeights = WeightsFunctionType::NumberOfWeights;
+  FixedArray<double, NumberOfWeights> supportWeightsBuffer;
+  WeightsType supportWeights( supportWeightsBuffer.GetDataPointer(), NumberOfWeights, false );
+  IndexType supportIndex;
+  this->m_WeightsFunction->Evaluate( index, supportWeights, supportIndex );
+
+  // The parameters of each dimension are the coefficients of the grid, with
+  // the first dimension varying the fastest, as it does for the weights of
+  // the support region.
+  const RegionType & gridRegion = this->m_CoefficientImages[0]->GetLargestPossibleRegion();
+  OffsetValueType strides[SpaceDimension];
+  OffsetValueType parameterIndex = 0;
+  OffsetValueType numberOfParametersPerDimension = 1;
+  for( unsigned int d = 0; d < SpaceDimension; d++ )
+    {
+    strides[d] = numberOfParametersPerDimension;
+    parameterIndex += ( supportIndex[d] - gridRegion.GetIndex()[d] ) * numberOfParametersPerDimension;
+    numberOfParametersPerDimension *= static_cast<OffsetValueType>( gridRegion.GetSize()[d] );
+    }
+
+  unsigned int supportOffset[SpaceDimension] = {};
+  for( unsigned int k = 0; k < NumberOfWeights; k++ )
+    {
+    for( unsigned int d = 0; d < SpaceDimension; d++ )
+      {
+      weights[d * NumberOfWeights + k] = static_cast<ParametersValueType>( supportWeights[k] );
+      parameterIndices[d * NumberOfWeights + k] =
+        static_cast<NumberOfParametersType>( parameterIndex + d * numberOfParametersPerDimension );
+      }
+
+    // Go to the next coefficient of the support region.
+    for( unsigned int d = 0; d < SpaceDimension; d++ )
+      {
+      if( ++supportOffset[d] <= SplineOrder )
+        {
+        parameterIndex += strides[d];
+        break;
+        }
+      supportOffset[d] = 0;
+      parameterIndex -= SplineOrder * strides[d];
+      }
+    }
+  return NumberOfWeights;
+}
+
 template<typename TParametersValueType, unsigned int NDimensions, unsigned int VSplineOrder>
 unsigned int
 BSplineBaseTransform<TParametersValueType, NDimensions, VSplineOrder>
@@ -336,8 +423,12 @@ typename BSplineBaseTransform<TParametersValueType, NDimensions, VSplineOrder>
 BSplineBaseTransform<TParametersValueType, NDimensions, VSplineOrder>
 ::TransformPoint(const InputPointType & point) const
 {
-  WeightsType             weights( this->m_WeightsFunction->GetNumberOfWeights() );
-  ParameterIndexArrayType indices( this->m_WeightsFunction->GetNumberOfWeights() );
+  // The weights and indices are kept in buffers on the stack.
+  constexpr unsigned int NumberOfWeights = WeightsFunctionType::NumberOfWeights;
+  FixedArray<double, NumberOfWeights>        weightsBuffer;
+  FixedArray<unsigned long, NumberOfWeights> indicesBuffer;
+  WeightsType             weights( weightsBuffer.GetDataPointer(), NumberOfWeights, false );
+  ParameterIndexArrayType indices( indicesBuffer.GetDataPointer(), NumberOfWeights, false );
   OutputPointType         outputPoint;
   bool                    inside;
 
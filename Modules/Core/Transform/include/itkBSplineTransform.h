@@ -238,9 +238,6 @@ public:
   void TransformPoint( const InputPointType & inputPoint, OutputPointType & outputPoint,
     WeightsType & weights, ParameterIndexArrayType & indices, bool & inside ) const override;
 
-  /** Compute the Jacobian in one position. */
-  void ComputeJacobianWithRespectToParameters( const InputPointType &, JacobianType & ) const override;
-
   /** Return the number of parameters that completely define the Transfom. */
   NumberOfParametersType GetNumberOfParameters() const override;
 
@@ -22,7 +22,6 @@
 
 #include "itkContinuousIndex.h"
 #include "itkImageScanlineConstIterator.h"
-#include "itkImageRegionConstIteratorWithIndex.h"
 
 namespace itk
 {
@@ -559,72 +558,6 @@ BSplineTransform<TParametersValueType, NDimensions, VSplineOrder>
     }
 }
 
-template<typename TParametersValueType, unsigned int NDimensions, unsigned int VSplineOrder>
-void
-BSplineTransform<TParametersValueType, NDimensions, VSplineOrder>
-::ComputeJacobianWithRespectToParameters( const InputPointType & point,
-  JacobianType & jacobian ) const
-{
-  // Zero all components of jacobian
-  jacobian.SetSize( SpaceDimension, this->GetNumberOfParameters() );
-  jacobian.Fill( 0.0 );
-  RegionType   supportRegion;
-  SizeType     supportSize;
-  supportSize.Fill( SplineOrder + 1 );
-  supportRegion.SetSize( supportSize );
-
-  ContinuousIndexType index;
-  this->m_CoefficientImages[0]->
-    TransformPhysicalPointToContinuousIndex( point, index );
-
-  // NOTE: if the support region does not lie totally within the grid we assume
-  // zero displacement and do no computations beyond zeroing out the value
-  // return the input point
-  if( !this->InsideValidRegion( index ) )
-    {
-    return;
-    }
-
-  // Compute interpolation weights
-  WeightsType weights( this->m_WeightsFunction->GetNumberOfWeights() );
-
-  IndexType supportIndex;
-  this->m_WeightsFunction->Evaluate( index, weights, supportIndex );
-
-  supportRegion.SetIndex( supportIndex );
-
-  IndexType startIndex =
-    this->m_CoefficientImages[0]->GetLargestPossibleRegion().GetIndex();
-
-  SizeType cumulativeGridSizes;
-  cumulativeGridSizes[0] = ( this->m_TransformDomainMeshSize[0] + SplineOrder );
-  for( unsigned int d = 1; d < SpaceDimension; d++ )
-    {
-    cumulativeGridSizes[d] = cumulativeGridSizes[d-1] * ( this->m_TransformDomainMeshSize[d] + SplineOrder );
-    }
-
-  SizeValueType numberOfParametersPerDimension = this->GetNumberOfParametersPerDimension();
-
-  ImageRegionConstIteratorWithIndex<ImageType> It( this->m_CoefficientImages[0], supportRegion );
-  unsigned long counter = 0;
-  for( It.GoToBegin(); !It.IsAtEnd(); ++It )
-    {
-    typename ImageType::OffsetType currentIndex = It.GetIndex() - startIndex;
-
-    unsigned long number = currentIndex[0];
-    for( unsigned int d = 1; d < SpaceDimension; d++ )
-      {
-      number += ( currentIndex[d] * cumulativeGridSizes[d-1] );
-      }
-
-    for( unsigned int d = 0; d < SpaceDimension; d++ )
-      {
-      jacobian( d, number + d * numberOfParametersPerDimension ) = weights[counter];
-      }
-    counter++;
-    }
-}
-
 template<typename TParametersValueType, unsigned int NDimensions, unsigned int VSplineOrder>
 void
 BSplineTransform<TParametersValueType, NDimensions, VSplineOrder>
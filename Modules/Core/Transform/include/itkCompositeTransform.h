@@ -19,8 +19,11 @@
 #define itkCompositeTransform_h
 
 #include "itkMultiTransform.h"
+#include "itkSimpleFastMutexLock.h"
 
+#include <atomic>
 #include <deque>
+#include <vector>
 
 namespace itk
 {
@@ -81,6 +84,14 @@ namespace itk
  * sub transform and adding them to a composite transform in reverse order.
  * The m_TransformsToOptimizeFlags is copied in reverse for the inverse.
  *
+ * Linear sub-transforms:
+ * TransformPoint applies each contiguous run of linear sub-transforms (see
+ * Transform::IsLinear) as a single matrix and offset, instead of calling
+ * each of them in turn. The matrices and offsets are computed again on the
+ * first call that follows a change of the queue or of any sub-transform,
+ * as reported by their modification times. Nested composite transforms are
+ * applied as a whole.
+ *
  * \ingroup ITKTransform
  */
 template<typename TParametersValueType=double, unsigned int NDimensions = 3>
@@ -142,6 +153,9 @@ public:
   using InputSymmetricSecondRankTensorType = typename Superclass::InputSymmetricSecondRankTensorType;
   using OutputSymmetricSecondRankTensorType = typename Superclass::OutputSymmetricSecondRankTensorType;
 
+  /** Matrix type. */
+  using MatrixType = typename Superclass::MatrixType;
+
   /** Transform queue type */
   using TransformQueueType = typename Superclass::TransformQueueType;
 
@@ -415,8 +429,35 @@ protected:
   mutable TransformsToOptimizeFlagsType m_TransformsToOptimizeFlags;
 
 private:
+  /** A step of TransformPoint: a sub-transform, or a run of linear
+   * sub-transforms collapsed into a matrix and an offset when m_Transform
+   * is null. */
+  struct TransformPointStep
+  {
+    const TransformType *m_Transform;
+    MatrixType           m_Matrix;
+    OutputVectorType     m_Offset;
+  };
+  using TransformPointStepsType = std::vector<TransformPointStep>;
+
+  /** Whether neither the queue nor any sub-transform were modified since
+   * the steps were computed. */
+  bool TransformPointStepsAreUpToDate() const;
+
+  /** Compute the steps again, if they are not up to date. */
+  void UpdateTransformPointSteps() const;
+
+  /** Get the matrix and offset of a linear sub-transform. Return false for
+   * the other sub-transforms. */
+  static bool GetMatrixAndOffset( const TransformType *transform, MatrixType & matrix, OutputVectorType & offset );
+
   mutable ModifiedTimeType m_PreviousTransformsToOptimizeUpdateTime;
 
+  /** The steps of TransformPoint, in the order they are applied, and the
+   * time they were computed at, zero before they are first computed. */
+  mutable TransformPointStepsType       m_TransformPointSteps;
+  mutable std::atomic<ModifiedTimeType> m_TransformPointStepsTime;
+  mutable SimpleFastMutexLock           m_TransformPointStepsLock;
 };
 
 } // end namespace itk
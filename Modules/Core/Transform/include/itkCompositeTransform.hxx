@@ -19,6 +19,8 @@
 #define itkCompositeTransform_hxx
 
 #include "itkCompositeTransform.h"
+#include "itkMatrixOffsetTransformBase.h"
+#include "itkMutexLockHolder.h"
 
 namespace itk
 {
@@ -26,7 +28,8 @@ namespace itk
 
 template
 <typename TParametersValueType, unsigned int NDimensions>
-CompositeTransform<TParametersValueType, NDimensions>::CompositeTransform()
+CompositeTransform<TParametersValueType, NDimensions>::CompositeTransform() :
+  m_TransformPointStepsTime( 0 )
 {
   this->m_TransformsToOptimizeFlags.clear();
   this->m_TransformsToOptimizeQueue.clear();
@@ -85,21 +88,144 @@ typename CompositeTransform<TParametersValueType, NDimensions>
 CompositeTransform<TParametersValueType, NDimensions>
 ::TransformPoint( const InputPointType& inputPoint ) const
 {
+  if( !this->TransformPointStepsAreUpToDate() )
+    {
+    this->UpdateTransformPointSteps();
+    }
 
-  /* Apply in reverse queue order.  */
-  typename TransformQueueType::const_iterator it( this->m_TransformQueue.end() );
-  const typename TransformQueueType::const_iterator beginit( this->m_TransformQueue.begin() );
+  /* Apply in reverse queue order, with the runs of linear transforms
+   * collapsed. */
   OutputPointType outputPoint( inputPoint );
-  do
+  for( const TransformPointStep & step : this->m_TransformPointSteps )
     {
-    it--;
-    outputPoint = (*it)->TransformPoint( outputPoint );
+    if( step.m_Transform )
+      {
+      outputPoint = step.m_Transform->TransformPoint( outputPoint );
+      }
+    else
+      {
+      outputPoint = step.m_Matrix * outputPoint + step.m_Offset;
+      }
     }
-  while( it != beginit );
   return outputPoint;
 }
 
 
+template
+<typename TParametersValueType, unsigned int NDimensions>
+bool
+CompositeTransform<TParametersValueType, NDimensions>
+::TransformPointStepsAreUpToDate() const
+{
+  const ModifiedTimeType stepsTime = this->m_TransformPointStepsTime.load( std::memory_order_acquire );
+  if( stepsTime == 0 || this->GetMTime() > stepsTime )
+    {
+    return false;
+    }
+  for( const TransformTypePointer & transform : this->m_TransformQueue )
+    {
+    if( transform->GetMTime() > stepsTime )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+
+template
+<typename TParametersValueType, unsigned int NDimensions>
+void
+CompositeTransform<TParametersValueType, NDimensions>
+::UpdateTransformPointSteps() const
+{
+  MutexLockHolder<SimpleFastMutexLock> holder( this->m_TransformPointStepsLock );
+
+  // Another thread may have computed the steps in the meantime.
+  if( this->TransformPointStepsAreUpToDate() )
+    {
+    return;
+    }
+
+  // Any later modification is more recent than this time stamp.
+  TimeStamp stepsTime;
+  stepsTime.Modified();
+
+  this->m_TransformPointSteps.clear();
+  for( auto it = this->m_TransformQueue.rbegin(); it != this->m_TransformQueue.rend(); ++it )
+    {
+    TransformPointStep step;
+    if( Self::GetMatrixAndOffset( *it, step.m_Matrix, step.m_Offset ) )
+      {
+      if( !this->m_TransformPointSteps.empty() && this->m_TransformPointSteps.back().m_Transform == nullptr )
+        {
+        // Compose with the run of linear transforms applied before.
+        TransformPointStep & run = this->m_TransformPointSteps.back();
+        run.m_Offset = step.m_Matrix * run.m_Offset + step.m_Offset;
+        run.m_Matrix = step.m_Matrix * run.m_Matrix;
+        continue;
+        }
+      step.m_Transform = nullptr;
+      }
+    else
+      {
+      step.m_Transform = *it;
+      }
+    this->m_TransformPointSteps.push_back( step );
+    }
+
+  this->m_TransformPointStepsTime.store( stepsTime.GetMTime(), std::memory_order_release );
+}
+
+
+template
+<typename TParametersValueType, unsigned int NDimensions>
+bool
+CompositeTransform<TParametersValueType, NDimensions>
+::GetMatrixAndOffset( const TransformType *transform, MatrixType & matrix, OutputVectorType & offset )
+{
+  // Nested composite transforms keep their own steps up to date.
+  if( !transform->IsLinear() || dynamic_cast<const Superclass *>( transform ) )
+    {
+    return false;
+    }
+
+  using MatrixOffsetTransformType = MatrixOffsetTransformBase<TParametersValueType, NDimensions, NDimensions>;
+  const auto * matrixOffsetTransform = dynamic_cast<const MatrixOffsetTransformType *>( transform );
+  if( matrixOffsetTransform )
+    {
+    matrix = matrixOffsetTransform->GetMatrix();
+    offset = matrixOffsetTransform->GetOffset();
+    return true;
+    }
+
+  // Other linear transforms, such as the translation and identity
+  // transforms, are probed.
+  try
+    {
+    InputPointType origin;
+    origin.Fill( NumericTraits<ScalarType>::ZeroValue() );
+    offset = transform->TransformPoint( origin ).GetVectorFromOrigin();
+    for( unsigned int i = 0; i < NDimensions; i++ )
+      {
+      InputVectorType axis;
+      axis.Fill( NumericTraits<ScalarType>::ZeroValue() );
+      axis[i] = NumericTraits<ScalarType>::OneValue();
+      const OutputVectorType column = transform->TransformVector( axis );
+      for( unsigned int j = 0; j < NDimensions; j++ )
+        {
+        matrix[j][i] = column[j];
+        }
+      }
+    }
+  catch( ExceptionObject & )
+    {
+    return false;
+    }
+  return true;
+}
+
+
 template<typename TParametersValueType, unsigned int NDimensions>
 typename CompositeTransform<TParametersValueType, NDimensions>
 ::OutputVectorType
@@ -1088,6 +1214,7 @@ CompositeTransform<TParametersValueType, NDimensions>
   this->m_TransformQueue = transformQueue;
   this->m_TransformsToOptimizeQueue = transformsToOptimizeQueue;
   this->m_TransformsToOptimizeFlags = transformsToOptimizeFlags;
+  this->Modified();
 }
 
 
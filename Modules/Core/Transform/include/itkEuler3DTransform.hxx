@@ -170,6 +170,7 @@ Euler3DTransform<TParametersValueType>
   m_AngleZ = angleZ;
   this->ComputeMatrix();
   this->ComputeOffset();
+  this->Modified();
 }
 
 // Compose
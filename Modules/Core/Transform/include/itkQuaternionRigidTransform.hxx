@@ -67,6 +67,7 @@ QuaternionRigidTransform<TParametersValueType>::SetRotation(const VnlQuaternionT
   m_Rotation        = rotation;
 
   this->ComputeMatrix();
+  this->Modified();
 }
 
 // Set the parameters in order to fit an Identity transform
@@ -202,6 +202,7 @@ ScaleSkewVersor3DTransform<TParametersValueType>
 {
   m_Scale = scale;
   this->ComputeMatrix();
+  this->Modified();
 }
 
 template<typename TParametersValueType>
@@ -211,6 +212,7 @@ ScaleSkewVersor3DTransform<TParametersValueType>
 {
   m_Skew = skew;
   this->ComputeMatrix();
+  this->Modified();
 }
 
 // Compute the matrix
@@ -101,6 +101,9 @@ ScaleTransform<TParametersValueType, NDimensions>
     {
     m_Scale[i] *= other->m_Scale[i];
     }
+  this->ComputeMatrix();
+  this->ComputeOffset();
+  this->Modified();
 }
 
 
@@ -113,6 +116,9 @@ ScaleTransform<TParametersValueType, NDimensions>
     {
     m_Scale[i] *= scale[i];
     }
+  this->ComputeMatrix();
+  this->ComputeOffset();
+  this->Modified();
 }
 
 
@@ -187,6 +187,7 @@ ScaleVersor3DTransform<TParametersValueType>
 {
   m_Scale = scale;
   this->ComputeMatrix();
+  this->Modified();
 }
 
 // // THIS is different from VersorRigid3DTransform;
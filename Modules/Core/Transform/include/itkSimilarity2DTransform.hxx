@@ -121,6 +121,7 @@ Similarity2DTransform<TParametersValueType>
   m_Scale = scale;
   this->ComputeMatrix();
   this->ComputeOffset();
+  this->Modified();
 }
 
 
@@ -69,6 +69,7 @@ Similarity3DTransform<TParametersValueType>
 {
   m_Scale = scale;
   this->ComputeMatrix();
+  this->Modified();
 }
 
 // Directly set the matrix
@@ -504,6 +504,38 @@ public:
     this->ComputeJacobianWithRespectToParameters(p, jacobian);
   }
 
+  /** Return the number of parameters each row of the sparse Jacobian with
+   * respect to the parameters may depend on, see
+   * ComputeSparseJacobianWithRespectToParameters. Zero for transforms that
+   * do not provide a sparse Jacobian, which is the default. */
+  virtual NumberOfParametersType GetNumberOfSparseJacobianParameters() const
+  {
+    return 0;
+  }
+
+  /** Compute the Jacobian with respect to the parameters at \c p in sparse
+   * form, into buffers provided by the caller, without allocating memory.
+   * This is meant for transforms whose Jacobian at a point only depends on
+   * a few of their parameters, e.g. the B-spline transforms, for which the
+   * dense Jacobian is mostly zeros.
+   *
+   * Both \c weights and \c parameterIndices must hold
+   * NOutputDimensions * GetNumberOfSparseJacobianParameters() values.
+   * With n = GetNumberOfSparseJacobianParameters() and the returned count
+   * m, the Jacobian element of row d at the parameter
+   * parameterIndices[d * n + k] is weights[d * n + k], for k < m, and the
+   * other elements of row d are zero. A parameter index appears at most
+   * once in a row. A count of zero means that the Jacobian is zero at \c p.
+   *
+   * \c weights and \c parameterIndices are assumed to be thread-local
+   * buffers. Throws for transforms that do not provide a sparse Jacobian. */
+  virtual NumberOfParametersType ComputeSparseJacobianWithRespectToParameters(const InputPointType & itkNotUsed(p),
+    ParametersValueType * itkNotUsed(weights), NumberOfParametersType * itkNotUsed(parameterIndices) ) const
+  {
+    itkExceptionMacro(
+      "ComputeSparseJacobianWithRespectToParameters is unimplemented for " << this->GetNameOfClass() );
+  }
+
 
   /** This provides the ability to get a local jacobian value
    *  in a dense/local transform, e.g. DisplacementFieldTransform. For such
@@ -120,7 +120,7 @@ public:
    * value specified by the user. */
   void SetOffset(const OutputVectorType & offset)
   {
-    m_Offset = offset; return;
+    m_Offset = offset; this->Modified(); return;
   }
 
   /** Compose with another TranslationTransform. */
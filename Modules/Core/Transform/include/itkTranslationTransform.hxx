@@ -220,6 +220,7 @@ void
 TranslationTransform<TParametersValueType, NDimensions>::SetIdentity()
 {
   m_Offset.Fill(0.0);
+  this->Modified();
 }
 
 } // end namespace itk
@@ -104,6 +104,7 @@ VersorTransform<TParametersValueType>
   m_Versor = versor;
   this->ComputeMatrix();
   this->ComputeOffset();
+  this->Modified();
 }
 
 /** Set Rotational Part */
@@ -115,6 +116,7 @@ VersorTransform<TParametersValueType>
   m_Versor.Set(axis, angle);
   this->ComputeMatrix();
   this->ComputeOffset();
+  this->Modified();
 }
 
 /** Set Identity */
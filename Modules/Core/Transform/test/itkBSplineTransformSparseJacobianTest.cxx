@@ -0,0 +1,208 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkAffineTransform.h"
+#include "itkBSplineDeformableTransform.h"
+#include "itkBSplineTransform.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Compare the sparse Jacobians of the B-spline transforms, and their dense
+ * Jacobians, to reference Jacobians. Since the displacement of a B-spline
+ * transform is linear in its parameters, the reference Jacobian column of
+ * a parameter is the displacement with this parameter set to one and the
+ * others to zero.
+ */
+
+namespace
+{
+using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+
+template<typename TTransform>
+bool TestSparseJacobian( const char * name, TTransform * transform, double pointRange, GeneratorType * generator )
+{
+  using ParametersType = typename TTransform::ParametersType;
+  using ParametersValueType = typename TTransform::ParametersValueType;
+  using NumberOfParametersType = typename TTransform::NumberOfParametersType;
+  using JacobianType = typename TTransform::JacobianType;
+  using PointType = typename TTransform::InputPointType;
+  constexpr unsigned int Dimension = TTransform::SpaceDimension;
+
+  const NumberOfParametersType numberOfParameters = transform->GetNumberOfParameters();
+  const NumberOfParametersType rowSize = transform->GetNumberOfSparseJacobianParameters();
+  if( rowSize != transform->GetNumberOfWeights() )
+    {
+    std::cerr << name << ": wrong number of sparse Jacobian parameters " << rowSize << std::endl;
+    return false;
+    }
+
+  std::vector<PointType> points( 20 );
+  for( PointType & point : points )
+    {
+    for( unsigned int d = 0; d < Dimension; d++ )
+      {
+      point[d] = generator->GetUniformVariate( -0.1 * pointRange, 1.1 * pointRange );
+      }
+    }
+
+  // The reference Jacobians, column by column
+  std::vector<JacobianType> referenceJacobians( points.size(), JacobianType( Dimension, numberOfParameters ) );
+  ParametersType parameters( numberOfParameters );
+  for( NumberOfParametersType p = 0; p < numberOfParameters; p++ )
+    {
+    parameters.Fill( 0.0 );
+    parameters[p] = 1.0;
+    transform->SetParametersByValue( parameters );
+    for( unsigned int n = 0; n < points.size(); n++ )
+      {
+      const PointType outputPoint = transform->TransformPoint( points[n] );
+      for( unsigned int d = 0; d < Dimension; d++ )
+        {
+        referenceJacobians[n]( d, p ) = outputPoint[d] - points[n][d];
+        }
+      }
+    }
+
+  for( NumberOfParametersType p = 0; p < numberOfParameters; p++ )
+    {
+    parameters[p] = generator->GetUniformVariate( -1.0, 1.0 );
+    }
+  transform->SetParametersByValue( parameters );
+
+  bool passed = true;
+  unsigned int numberOfPointsInside = 0;
+  std::vector<ParametersValueType> weights( Dimension * rowSize );
+  std::vector<NumberOfParametersType> parameterIndices( Dimension * rowSize );
+  JacobianType jacobian;
+  for( unsigned int n = 0; n < points.size(); n++ )
+    {
+    const NumberOfParametersType numberOfWeights =
+      transform->ComputeSparseJacobianWithRespectToParameters( points[n], weights.data(), parameterIndices.data() );
+    if( numberOfWeights > 0 )
+      {
+      ++numberOfPointsInside;
+      }
+
+    JacobianType sparseJacobian( Dimension, numberOfParameters );
+    sparseJacobian.Fill( 0.0 );
+    for( unsigned int d = 0; d < Dimension; d++ )
+      {
+      for( NumberOfParametersType k = 0; k < numberOfWeights; k++ )
+        {
+        sparseJacobian( d, parameterIndices[d * rowSize + k] ) += weights[d * rowSize + k];
+        }
+      }
+
+    transform->ComputeJacobianWithRespectToParameters( points[n], jacobian );
+
+    double maximumSparseError = 0.0;
+    double maximumDenseError = 0.0;
+    for( unsigned int d = 0; d < Dimension; d++ )
+      {
+      for( NumberOfParametersType p = 0; p < numberOfParameters; p++ )
+        {
+        maximumSparseError = std::max( maximumSparseError,
+          std::abs( static_cast<double>( sparseJacobian( d, p ) - referenceJacobians[n]( d, p ) ) ) );
+        maximumDenseError = std::max( maximumDenseError,
+          std::abs( static_cast<double>( jacobian( d, p ) - referenceJacobians[n]( d, p ) ) ) );
+        }
+      }
+    if( maximumSparseError > 1e-6 || maximumDenseError > 1e-6 )
+      {
+      std::cerr << name << ": the Jacobians differ at " << points[n] << ", sparse " << maximumSparseError
+                << ", dense " << maximumDenseError << std::endl;
+      passed = false;
+      }
+    }
+
+  std::cout << name << ": " << numberOfPointsInside << " of " << points.size()
+            << " points inside the grid" << std::endl;
+  if( numberOfPointsInside == 0 || numberOfPointsInside == points.size() )
+    {
+    std::cerr << name << ": the points must be both inside and outside the grid" << std::endl;
+    passed = false;
+    }
+  return passed;
+}
+
+template<typename TParametersValueType, unsigned int VDimension, unsigned int VSplineOrder>
+bool TestBSplineTransform( const char * name, GeneratorType * generator )
+{
+  using TransformType = itk::BSplineTransform<TParametersValueType, VDimension, VSplineOrder>;
+  typename TransformType::Pointer transform = TransformType::New();
+
+  typename TransformType::PhysicalDimensionsType physicalDimensions;
+  physicalDimensions.Fill( 10.0 );
+  typename TransformType::MeshSizeType meshSize;
+  meshSize.Fill( 3 );
+  meshSize[0] = 4;
+  typename TransformType::OriginType origin;
+  origin.Fill( 1.0 );
+  typename TransformType::DirectionType direction;
+  using RotationType = itk::AffineTransform<double, VDimension>;
+  typename RotationType::Pointer rotation = RotationType::New();
+  rotation->Rotate( 0, 1, 0.3 );
+  direction = rotation->GetMatrix();
+
+  transform->SetTransformDomainOrigin( origin );
+  transform->SetTransformDomainPhysicalDimensions( physicalDimensions );
+  transform->SetTransformDomainMeshSize( meshSize );
+  transform->SetTransformDomainDirection( direction );
+
+  return TestSparseJacobian( name, transform.GetPointer(), 10.0, generator );
+}
+}
+
+int itkBSplineTransformSparseJacobianTest( int, char * [] )
+{
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 2018 );
+
+  bool passed = true;
+  passed = TestBSplineTransform<double, 2, 3>( "2D cubic BSplineTransform", generator ) && passed;
+  passed = TestBSplineTransform<double, 3, 3>( "3D cubic BSplineTransform", generator ) && passed;
+  passed = TestBSplineTransform<double, 3, 2>( "3D quadratic BSplineTransform", generator ) && passed;
+  passed = TestBSplineTransform<float, 3, 3>( "3D cubic single precision BSplineTransform", generator ) && passed;
+
+  // A grid region which does not start at the origin
+  using DeformableTransformType = itk::BSplineDeformableTransform<double, 2, 3>;
+  DeformableTransformType::Pointer deformableTransform = DeformableTransformType::New();
+  DeformableTransformType::RegionType::IndexType gridIndex = {{ 2, -1 }};
+  DeformableTransformType::RegionType::SizeType gridSize = {{ 8, 7 }};
+  DeformableTransformType::SpacingType gridSpacing;
+  gridSpacing.Fill( 2.0 );
+  DeformableTransformType::OriginType gridOrigin;
+  gridOrigin.Fill( -3.0 );
+  deformableTransform->SetGridSpacing( gridSpacing );
+  deformableTransform->SetGridOrigin( gridOrigin );
+  deformableTransform->SetGridRegion( DeformableTransformType::RegionType( gridIndex, gridSize ) );
+  passed = TestSparseJacobian( "2D cubic BSplineDeformableTransform", deformableTransform.GetPointer(), 12.0,
+                               generator ) && passed;
+
+  // Transforms without a sparse Jacobian
+  using AffineTransformType = itk::AffineTransform<double, 3>;
+  AffineTransformType::Pointer affineTransform = AffineTransformType::New();
+  TEST_EXPECT_EQUAL( affineTransform->GetNumberOfSparseJacobianParameters(), 0u );
+  AffineTransformType::ParametersValueType weights[3];
+  AffineTransformType::NumberOfParametersType parameterIndices[3];
+  TRY_EXPECT_EXCEPTION( affineTransform->ComputeSparseJacobianWithRespectToParameters(
+    AffineTransformType::InputPointType(), weights, parameterIndices ) );
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,256 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkAffineTransform.h"
+#include "itkBSplineTransform.h"
+#include "itkCompositeTransform.h"
+#include "itkEuler3DTransform.h"
+#include "itkIdentityTransform.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkQuaternionRigidTransform.h"
+#include "itkScaleSkewVersor3DTransform.h"
+#include "itkScaleTransform.h"
+#include "itkScaleVersor3DTransform.h"
+#include "itkSimilarity3DTransform.h"
+#include "itkTranslationTransform.h"
+
+/*
+ * Compare the points mapped by composite transforms, whose runs of linear
+ * sub-transforms are collapsed, with the points mapped by their
+ * sub-transforms in turn, after the sub-transforms or the queue are
+ * modified, also through setters other than SetParameters, and with a
+ * nested composite transform.
+ */
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using CompositeType = itk::CompositeTransform<double, Dimension>;
+using TransformType = CompositeType::TransformType;
+using PointType = CompositeType::InputPointType;
+using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+
+void RandomizeParameters( TransformType * transform, double range, GeneratorType * generator )
+{
+  TransformType::ParametersType parameters = transform->GetParameters();
+  for( unsigned int i = 0; i < parameters.Size(); ++i )
+    {
+    parameters[i] += generator->GetUniformVariate( -range, range );
+    }
+  transform->SetParameters( parameters );
+}
+
+PointType ReferenceTransformPoint( const CompositeType * composite, const PointType & point )
+{
+  PointType outputPoint = point;
+  for( int i = static_cast<int>( composite->GetNumberOfTransforms() ) - 1; i >= 0; --i )
+    {
+    outputPoint = composite->GetNthTransformConstPointer( i )->TransformPoint( outputPoint );
+    }
+  return outputPoint;
+}
+
+bool Compare( const char * name, const CompositeType * composite, bool expectedLinear, GeneratorType * generator )
+{
+  double maximumError = 0.0;
+  for( unsigned int n = 0; n < 100; ++n )
+    {
+    PointType point;
+    for( unsigned int d = 0; d < Dimension; ++d )
+      {
+      point[d] = generator->GetUniformVariate( -10.0, 20.0 );
+      }
+    const PointType outputPoint = composite->TransformPoint( point );
+    const PointType referencePoint = ReferenceTransformPoint( composite, point );
+    maximumError = std::max( maximumError, outputPoint.EuclideanDistanceTo( referencePoint ) );
+    }
+  const bool isLinear = composite->IsLinear();
+  const bool isLinearCategory = composite->GetTransformCategory() == CompositeType::Linear;
+  std::cout << name << ": maximum difference " << maximumError << ", linear " << isLinear << std::endl;
+  if( maximumError > 1e-10 || isLinear != expectedLinear || isLinearCategory != expectedLinear )
+    {
+    std::cerr << name << ": the composite transform differs from its sub-transforms" << std::endl;
+    return false;
+    }
+  return true;
+}
+}
+
+int itkCompositeTransformLinearRunsTest( int, char * [] )
+{
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 2018 );
+
+  using AffineType = itk::AffineTransform<double, Dimension>;
+  AffineType::Pointer affine = AffineType::New();
+  AffineType::InputPointType center;
+  center.Fill( 4.0 );
+  affine->SetCenter( center );
+  RandomizeParameters( affine, 0.2, generator );
+
+  using TranslationType = itk::TranslationTransform<double, Dimension>;
+  TranslationType::Pointer translation = TranslationType::New();
+  RandomizeParameters( translation, 5.0, generator );
+
+  using EulerType = itk::Euler3DTransform<double>;
+  EulerType::Pointer euler = EulerType::New();
+  RandomizeParameters( euler, 0.5, generator );
+
+  using IdentityType = itk::IdentityTransform<double, Dimension>;
+  IdentityType::Pointer identity = IdentityType::New();
+
+  using BSplineType = itk::BSplineTransform<double, Dimension, 3>;
+  BSplineType::Pointer bspline = BSplineType::New();
+  BSplineType::PhysicalDimensionsType physicalDimensions;
+  physicalDimensions.Fill( 30.0 );
+  BSplineType::MeshSizeType meshSize;
+  meshSize.Fill( 4 );
+  BSplineType::OriginType origin;
+  origin.Fill( -10.0 );
+  bspline->SetTransformDomainOrigin( origin );
+  bspline->SetTransformDomainPhysicalDimensions( physicalDimensions );
+  bspline->SetTransformDomainMeshSize( meshSize );
+  RandomizeParameters( bspline, 1.0, generator );
+
+  bool passed = true;
+
+  // Linear transforms only
+  CompositeType::Pointer composite = CompositeType::New();
+  composite->AddTransform( affine );
+  composite->AddTransform( translation );
+  composite->AddTransform( euler );
+  passed = Compare( "Linear transforms", composite, true, generator ) && passed;
+
+  // The collapsed transforms follow the sub-transforms.
+  RandomizeParameters( affine, 0.2, generator );
+  RandomizeParameters( translation, 5.0, generator );
+  passed = Compare( "Modified linear transforms", composite, true, generator ) && passed;
+  center.Fill( -3.0 );
+  affine->SetCenter( center );
+  passed = Compare( "Modified center", composite, true, generator ) && passed;
+
+  // Runs of linear transforms around a non-linear transform
+  composite->AddTransform( bspline );
+  composite->AddTransform( identity );
+  composite->AddTransform( translation );
+  passed = Compare( "Runs around a BSpline transform", composite, false, generator ) && passed;
+  RandomizeParameters( euler, 0.5, generator );
+  RandomizeParameters( bspline, 1.0, generator );
+  passed = Compare( "Modified runs around a BSpline transform", composite, false, generator ) && passed;
+
+  // The collapsed transforms follow the queue.
+  composite->RemoveTransform();
+  composite->RemoveTransform();
+  composite->RemoveTransform();
+  passed = Compare( "Removed transforms", composite, true, generator ) && passed;
+  composite->ClearTransformQueue();
+  composite->AddTransform( identity );
+  passed = Compare( "Identity transform", composite, true, generator ) && passed;
+
+  // A nested composite transform is applied as a whole, and follows its
+  // own sub-transforms.
+  using ScaleType = itk::ScaleTransform<double, Dimension>;
+  ScaleType::Pointer scale = ScaleType::New();
+  RandomizeParameters( scale, 0.3, generator );
+  CompositeType::Pointer nested = CompositeType::New();
+  nested->AddTransform( scale );
+  nested->AddTransform( translation );
+  composite->AddTransform( affine );
+  composite->AddTransform( nested );
+  composite->AddTransform( euler );
+  passed = Compare( "Nested composite transform", composite, true, generator ) && passed;
+  RandomizeParameters( scale, 0.3, generator );
+  passed = Compare( "Modified nested composite transform", composite, true, generator ) && passed;
+  composite->FlattenTransformQueue();
+  RandomizeParameters( translation, 5.0, generator );
+  passed = Compare( "Flattened queue", composite, true, generator ) && passed;
+
+  // The collapsed transforms follow the setters of the sub-transforms.
+  composite->ClearTransformQueue();
+  TranslationType::OutputVectorType offset;
+  offset.Fill( 0.0 );
+  offset[0] = 1.0;
+  translation->SetOffset( offset );
+  euler->SetIdentity();
+  composite->AddTransform( translation );
+  composite->AddTransform( euler );
+  passed = Compare( "Translation and Euler transforms", composite, true, generator ) && passed;
+  euler->SetRotation( 0.0, 0.0, itk::Math::pi_over_2 );
+  PointType unitPoint;
+  unitPoint.Fill( 0.0 );
+  unitPoint[0] = 1.0;
+  const PointType rotatedPoint = composite->TransformPoint( unitPoint );
+  std::cout << "Rotated point: " << rotatedPoint << std::endl;
+  if( std::abs( rotatedPoint[0] - 1.0 ) > 1e-10 || std::abs( rotatedPoint[1] - 1.0 ) > 1e-10
+      || std::abs( rotatedPoint[2] ) > 1e-10 )
+    {
+    std::cerr << "The composite transform does not follow Euler3DTransform::SetRotation" << std::endl;
+    passed = false;
+    }
+  passed = Compare( "Euler3DTransform::SetRotation", composite, true, generator ) && passed;
+  offset[1] = 2.0;
+  translation->SetOffset( offset );
+  passed = Compare( "TranslationTransform::SetOffset", composite, true, generator ) && passed;
+
+  ScaleType::ScaleType scaleFactors;
+  scaleFactors.Fill( 1.5 );
+  composite->AddTransform( scale );
+  passed = Compare( "Scale transform", composite, true, generator ) && passed;
+  scale->Scale( scaleFactors );
+  passed = Compare( "ScaleTransform::Scale", composite, true, generator ) && passed;
+
+  using SimilarityType = itk::Similarity3DTransform<double>;
+  SimilarityType::Pointer similarity = SimilarityType::New();
+  composite->AddTransform( similarity );
+  passed = Compare( "Similarity transform", composite, true, generator ) && passed;
+  SimilarityType::AxisType axis;
+  axis.Fill( 1.0 );
+  similarity->SetRotation( axis, 0.4 );
+  passed = Compare( "VersorTransform::SetRotation", composite, true, generator ) && passed;
+  similarity->SetScale( 0.7 );
+  passed = Compare( "Similarity3DTransform::SetScale", composite, true, generator ) && passed;
+
+  using ScaleVersorType = itk::ScaleVersor3DTransform<double>;
+  ScaleVersorType::Pointer scaleVersor = ScaleVersorType::New();
+  composite->AddTransform( scaleVersor );
+  passed = Compare( "Scale versor transform", composite, true, generator ) && passed;
+  ScaleVersorType::ScaleVectorType scaleVector;
+  scaleVector.Fill( 1.2 );
+  scaleVersor->SetScale( scaleVector );
+  passed = Compare( "ScaleVersor3DTransform::SetScale", composite, true, generator ) && passed;
+
+  using ScaleSkewVersorType = itk::ScaleSkewVersor3DTransform<double>;
+  ScaleSkewVersorType::Pointer scaleSkewVersor = ScaleSkewVersorType::New();
+  composite->AddTransform( scaleSkewVersor );
+  passed = Compare( "Scale skew versor transform", composite, true, generator ) && passed;
+  ScaleSkewVersorType::SkewVectorType skew;
+  skew.Fill( 0.1 );
+  scaleSkewVersor->SetSkew( skew );
+  passed = Compare( "ScaleSkewVersor3DTransform::SetSkew", composite, true, generator ) && passed;
+  scaleSkewVersor->SetScale( scaleVector );
+  passed = Compare( "ScaleSkewVersor3DTransform::SetScale", composite, true, generator ) && passed;
+
+  using QuaternionType = itk::QuaternionRigidTransform<double>;
+  QuaternionType::Pointer quaternion = QuaternionType::New();
+  composite->AddTransform( quaternion );
+  passed = Compare( "Quaternion transform", composite, true, generator ) && passed;
+  quaternion->SetRotation( QuaternionType::VnlQuaternionType( 0.1, 0.2, 0.3, 0.9 ).normalize() );
+  passed = Compare( "QuaternionRigidTransform::SetRotation", composite, true, generator ) && passed;
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,124 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPruningImageFilter3D_h
+#define itkBinaryPruningImageFilter3D_h
+
+#include "itkImageToImageFilter.h"
+
+namespace itk
+{
+/** \class BinaryPruningImageFilter3D
+ *
+ * \brief This filter removes "spurs" of less than a certain
+ * length in a 3D skeleton.
+ *
+ * The input is assumed to be a binary image, typically the output of
+ * BinaryThinningImageFilter3D. At each of the Iteration iterations, the
+ * voxels of the object with less than 2 of their 26 neighbors in the
+ * object are removed, so the spurs of less than Iteration voxels are
+ * removed, and the other branches are shortened by Iteration voxels at
+ * their free ends. The remaining voxels keep their input value. The
+ * pixels outside of the image are considered as background.
+ *
+ * Unlike BinaryPruningImageFilter, which removes the voxels in place
+ * during a raster scan, each iteration removes the voxels which are ends
+ * in the result of the previous iteration. The voxels of an iteration are
+ * processed in parallel, and the result does not depend on the scan order
+ * or on the number of threads.
+ *
+ * \sa BinaryPruningImageFilter
+ * \sa BinaryThinningImageFilter3D
+ * \ingroup ImageEnhancement MathematicalMorphologyImageFilters
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+
+template< typename TInputImage, typename TOutputImage = TInputImage >
+class ITK_TEMPLATE_EXPORT BinaryPruningImageFilter3D:
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(BinaryPruningImageFilter3D);
+
+  /** Standard class type aliases. */
+  using Self = BinaryPruningImageFilter3D;
+  using Superclass = ImageToImageFilter< TInputImage, TOutputImage >;
+  using Pointer = SmartPointer< Self >;
+  using ConstPointer = SmartPointer< const Self >;
+
+  /** Method for creation through the object factory */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(BinaryPruningImageFilter3D, ImageToImageFilter);
+
+  /** Type for input image. */
+  using InputImageType = TInputImage;
+
+  /** Type for output image. */
+  using OutputImageType = TOutputImage;
+
+  /** Type for the region of the input image. */
+  using RegionType = typename InputImageType::RegionType;
+
+  /** Type for the pixels of the images. */
+  using InputPixelType = typename InputImageType::PixelType;
+  using OutputPixelType = typename OutputImageType::PixelType;
+
+  /** Set/Get the iteration value */
+  itkSetMacro(Iteration, unsigned int);
+  itkGetConstMacro(Iteration, unsigned int);
+
+  /** ImageDimension enumeration   */
+  static constexpr unsigned int InputImageDimension = TInputImage::ImageDimension;
+  static constexpr unsigned int OutputImageDimension = TOutputImage::ImageDimension;
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  // Begin concept checking
+  itkConceptMacro( SameDimensionCheck,
+                   ( Concept::SameDimension< InputImageDimension, OutputImageDimension > ) );
+  itkConceptMacro( ThreeDimensionCheck,
+                   ( Concept::SameDimension< InputImageDimension, 3 > ) );
+  itkConceptMacro( InputConvertibleToOutputCheck,
+                   ( Concept::Convertible< InputPixelType, OutputPixelType > ) );
+  // End concept checking
+#endif
+
+protected:
+  BinaryPruningImageFilter3D();
+  ~BinaryPruningImageFilter3D() override {}
+  void PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** The whole input is needed. */
+  void GenerateInputRequestedRegion() override;
+
+  /** The whole output is produced. */
+  void EnlargeOutputRequestedRegion(DataObject *) override;
+
+  /** Compute the pruned image. */
+  void GenerateData() override;
+
+private:
+  unsigned int m_Iteration;
+}; // end of BinaryPruningImageFilter3D class
+} //end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBinaryPruningImageFilter3D.hxx"
+#endif
+
+#endif
@@ -0,0 +1,208 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryPruningImageFilter3D_hxx
+#define itkBinaryPruningImageFilter3D_hxx
+
+#include "itkBinaryPruningImageFilter3D.h"
+#include "itkImageScanlineIterator.h"
+#include "itkProgressReporter.h"
+#include <array>
+#include <atomic>
+#include <vector>
+
+namespace itk
+{
+template< typename TInputImage, typename TOutputImage >
+BinaryPruningImageFilter3D< TInputImage, TOutputImage >
+::BinaryPruningImageFilter3D() :
+  m_Iteration(3)
+{
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BinaryPruningImageFilter3D< TInputImage, TOutputImage >
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType * input = const_cast< InputImageType * >( this->GetInput() );
+  if ( input )
+    {
+    input->SetRequestedRegion( input->GetLargestPossibleRegion() );
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BinaryPruningImageFilter3D< TInputImage, TOutputImage >
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  this->GetOutput()
+  ->SetRequestedRegion( this->GetOutput()->GetLargestPossibleRegion() );
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BinaryPruningImageFilter3D< TInputImage, TOutputImage >
+::GenerateData()
+{
+  this->AllocateOutputs();
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType *      output = this->GetOutput();
+  const RegionType       region = output->GetRequestedRegion();
+
+  ProgressReporter progress(this, 0, m_Iteration + 1);
+
+  // the object, with a border of background so that the neighbors of the
+  // voxels of the image are always in the buffer, and the object after
+  // the current iteration
+  std::array< OffsetValueType, 3 > strides;
+  strides[0] = 1;
+  strides[1] = region.GetSize(0) + 2;
+  strides[2] = strides[1] * ( region.GetSize(1) + 2 );
+  std::vector< unsigned char > object( strides[2] * ( region.GetSize(2) + 2 ), 0 );
+  std::vector< unsigned char > pruned( object.size(), 0 );
+  std::array< OffsetValueType, 26 > neighborOffsets;
+  unsigned int n = 0;
+  for ( OffsetValueType z = -1; z <= 1; z++ )
+    {
+    for ( OffsetValueType y = -1; y <= 1; y++ )
+      {
+      for ( OffsetValueType x = -1; x <= 1; x++ )
+        {
+        if ( x != 0 || y != 0 || z != 0 )
+          {
+          neighborOffsets[n++] = x * strides[0] + y * strides[1] + z * strides[2];
+          }
+        }
+      }
+    }
+  const auto positionOf = [&](const typename RegionType::IndexType & index) -> OffsetValueType
+    {
+    OffsetValueType position = 0;
+    for ( unsigned int d = 0; d < 3; d++ )
+      {
+      position += ( index[d] - region.GetIndex(d) + 1 ) * strides[d];
+      }
+    return position;
+    };
+
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+  multiThreader->template ParallelizeImageRegion< InputImageDimension >(
+    region,
+    [&](const RegionType & threadRegion)
+      {
+      ImageScanlineConstIterator< InputImageType > it( input, threadRegion );
+      while ( !it.IsAtEnd() )
+        {
+        OffsetValueType position = positionOf( it.GetIndex() );
+        while ( !it.IsAtEndOfLine() )
+          {
+          object[position++] = ( it.Get() != NumericTraits< InputPixelType >::ZeroValue() );
+          ++it;
+          }
+        it.NextLine();
+        }
+      },
+    nullptr);
+  progress.CompletedPixel();
+
+  // each iteration reads the object and writes the pruned object, so the
+  // slices can be processed in any order
+  ImageRegion< 1 > slices;
+  slices.SetIndex( 0, 1 );
+  slices.SetSize( 0, region.GetSize(2) );
+  for ( unsigned int iteration = 0; iteration < m_Iteration; iteration++ )
+    {
+    std::atomic< SizeValueType > removed( 0 );
+    multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+    multiThreader->template ParallelizeImageRegion< 1 >(
+      slices,
+      [&](const ImageRegion< 1 > & threadSlices)
+        {
+        SizeValueType localRemoved = 0;
+        for ( IndexValueType z = threadSlices.GetIndex(0); z < threadSlices.GetIndex(0) + static_cast< IndexValueType >( threadSlices.GetSize(0) ); z++ )
+          {
+          for ( SizeValueType y = 1; y <= region.GetSize(1); y++ )
+            {
+            OffsetValueType position = z * strides[2] + y * strides[1] + 1;
+            for ( SizeValueType x = 0; x < region.GetSize(0); x++, position++ )
+              {
+              unsigned int count = 0;
+              if ( object[position] )
+                {
+                for ( unsigned int i = 0; i < 26 && count < 2; i++ )
+                  {
+                  count += object[position + neighborOffsets[i]];
+                  }
+                localRemoved += ( count < 2 );
+                }
+              pruned[position] = ( count >= 2 );
+              }
+            }
+          }
+        removed += localRemoved;
+        },
+      nullptr);
+    object.swap( pruned );
+    progress.CompletedPixel();
+    if ( removed == 0 )
+      {
+      break;
+      }
+    }
+
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+  multiThreader->template ParallelizeImageRegion< OutputImageDimension >(
+    region,
+    [&](const RegionType & threadRegion)
+      {
+      ImageScanlineConstIterator< InputImageType > it( input, threadRegion );
+      ImageScanlineIterator< OutputImageType >     ot( output, threadRegion );
+      while ( !it.IsAtEnd() )
+        {
+        OffsetValueType position = positionOf( it.GetIndex() );
+        while ( !it.IsAtEndOfLine() )
+          {
+          ot.Set( object[position++] ? static_cast< OutputPixelType >( it.Get() )
+                                     : NumericTraits< OutputPixelType >::ZeroValue() );
+          ++it;
+          ++ot;
+          }
+        it.NextLine();
+        ot.NextLine();
+        }
+      },
+    nullptr);
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BinaryPruningImageFilter3D< TInputImage, TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Iteration: " << m_Iteration << std::endl;
+}
+} // end namespace itk
+
+#endif
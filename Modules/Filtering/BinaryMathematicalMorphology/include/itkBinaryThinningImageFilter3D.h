@@ -0,0 +1,177 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryThinningImageFilter3D_h
+#define itkBinaryThinningImageFilter3D_h
+
+#include "itkImageToImageFilter.h"
+#include <array>
+#include <vector>
+
+namespace itk
+{
+/** \class BinaryThinningImageFilter3D
+ *
+ * \brief Compute the curve skeleton of a 3D binary image.
+ *
+ * The input is assumed to be a binary image: every non zero pixel
+ * belongs to the object. The output is a one voxel thick skeleton of the
+ * object with the same topology, with (26, 6) connectivity: the number
+ * of 26-connected components of the object, of 6-connected components
+ * of the background, and of tunnels are preserved. The output background
+ * values are 0, and the foreground values are 1. The pixels outside of
+ * the image are considered as background.
+ *
+ * The object is peeled by directional sub-iterations: the border voxels
+ * of the object in one of the 6 face directions are removed if they are
+ * simple and not the end of a curve, then the next direction is
+ * processed, until no voxel can be removed. The border voxels of a
+ * direction are the voxels whose neighbor in the direction was in the
+ * background before the direction was processed, so that the object is
+ * peeled by one layer at a time and the skeleton is centered. A voxel is simple if the
+ * Euler characteristic of the object, computed with a lookup table over
+ * the 8 octants of its neighborhood as in
+ *
+ * T.C. Lee, R.L. Kashyap and C.N. Chu.
+ * Building skeleton models via 3-D medial surface/axis thinning algorithms.
+ * CVGIP: Graphical Models and Image Processing, 56(6):462-478, 1994.
+ *
+ * does not change when it is removed, and if its 26 neighbors in the
+ * object are 26-connected.
+ *
+ * Each direction is processed in 8 subfields: the voxels with the same
+ * parity of their indices along the three dimensions. The neighborhood of
+ * a voxel does not contain any other voxel of its subfield, so the voxels
+ * of a subfield are removed in parallel, and the skeleton does not depend
+ * on the number of threads.
+ *
+ * \sa BinaryThinningImageFilter
+ * \sa BinaryPruningImageFilter3D
+ * \ingroup ImageEnhancement MathematicalMorphologyImageFilters
+ * \ingroup ITKBinaryMathematicalMorphology
+ */
+
+template< typename TInputImage, typename TOutputImage = TInputImage >
+class ITK_TEMPLATE_EXPORT BinaryThinningImageFilter3D:
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(BinaryThinningImageFilter3D);
+
+  /** Standard class type aliases. */
+  using Self = BinaryThinningImageFilter3D;
+  using Superclass = ImageToImageFilter< TInputImage, TOutputImage >;
+  using Pointer = SmartPointer< Self >;
+  using ConstPointer = SmartPointer< const Self >;
+
+  /** Method for creation through the object factory */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(BinaryThinningImageFilter3D, ImageToImageFilter);
+
+  /** Type for input image. */
+  using InputImageType = TInputImage;
+
+  /** Type for output image: Skeleton of the object.  */
+  using OutputImageType = TOutputImage;
+
+  /** Type for the region of the input image. */
+  using RegionType = typename InputImageType::RegionType;
+
+  /** Type for the size of the input image. */
+  using SizeType = typename RegionType::SizeType;
+
+  /** Type for the pixels of the images. */
+  using InputPixelType = typename InputImageType::PixelType;
+  using OutputPixelType = typename OutputImageType::PixelType;
+
+  /** ImageDimension enumeration   */
+  static constexpr unsigned int InputImageDimension = TInputImage::ImageDimension;
+  static constexpr unsigned int OutputImageDimension = TOutputImage::ImageDimension;
+
+  /** Get the number of sub-iterations over the 6 directions done by the
+   * last execution, including the last one, which removes nothing. */
+  itkGetConstMacro(NumberOfIterations, unsigned int);
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  // Begin concept checking
+  itkConceptMacro( SameDimensionCheck,
+                   ( Concept::SameDimension< InputImageDimension, OutputImageDimension > ) );
+  itkConceptMacro( ThreeDimensionCheck,
+                   ( Concept::SameDimension< InputImageDimension, 3 > ) );
+  // End concept checking
+#endif
+
+protected:
+  BinaryThinningImageFilter3D();
+  ~BinaryThinningImageFilter3D() override {}
+  void PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** The whole input is needed. */
+  void GenerateInputRequestedRegion() override;
+
+  /** The whole output is produced. */
+  void EnlargeOutputRequestedRegion(DataObject *) override;
+
+  /** Compute thinning Image. */
+  void GenerateData() override;
+
+private:
+  // the buffer holds the object with a one voxel thick border of
+  // background, so that the neighbors of the voxels of the image are
+  // always in the buffer: 1 in the object, 2 for the voxels removed in
+  // the current direction, and 0 in the background
+  using BufferType = std::vector< unsigned char >;
+
+  /** Remove the simple border voxels of a subfield in a direction, and
+   * return the number of removed voxels. */
+  SizeValueType ThinSubfield(unsigned int direction, unsigned int subfield);
+
+  /** Whether the voxel at the given position of the buffer can be
+   * removed. */
+  bool IsDeletable(OffsetValueType position) const;
+
+  unsigned int m_NumberOfIterations;
+
+  // the change of the Euler characteristic, multiplied by 8, in an
+  // octant when the center voxel is removed, indexed by the 7 other
+  // voxels of the octant
+  std::array< int, 128 > m_EulerTable;
+
+  // the 26 neighbors which are 26-adjacent to each neighbor, as bit masks
+  std::array< uint32_t, 26 > m_Adjacency;
+
+  // the 26 neighbors, the offsets in the buffer of the 26 neighbors, the
+  // 7 neighbors of each octant as indices in the 26 neighbors, and the
+  // offsets of the 6 face neighbors, in the order of the directions
+  std::array< Offset< 3 >, 26 >                  m_Neighbors;
+  std::array< OffsetValueType, 26 >              m_NeighborOffsets;
+  std::array< std::array< unsigned int, 7 >, 8 > m_Octants;
+  std::array< OffsetValueType, 6 >               m_FaceOffsets;
+
+  BufferType                       m_Buffer;
+  std::array< SizeValueType, 3 >   m_Size;
+  std::array< OffsetValueType, 3 > m_Strides;
+}; // end of BinaryThinningImageFilter3D class
+} //end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBinaryThinningImageFilter3D.hxx"
+#endif
+
+#endif
@@ -0,0 +1,382 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryThinningImageFilter3D_hxx
+#define itkBinaryThinningImageFilter3D_hxx
+
+#include "itkBinaryThinningImageFilter3D.h"
+#include "itkImageScanlineIterator.h"
+#include "itkProgressReporter.h"
+#include <algorithm>
+#include <atomic>
+
+namespace itk
+{
+template< typename TInputImage, typename TOutputImage >
+BinaryThinningImageFilter3D< TInputImage, TOutputImage >
+::BinaryThinningImageFilter3D() :
+  m_NumberOfIterations(0)
+{
+  // the 26 neighbors, and the neighbors adjacent to each of them
+  unsigned int n = 0;
+  for ( int z = -1; z <= 1; z++ )
+    {
+    for ( int y = -1; y <= 1; y++ )
+      {
+      for ( int x = -1; x <= 1; x++ )
+        {
+        if ( x != 0 || y != 0 || z != 0 )
+          {
+          m_Neighbors[n][0] = x;
+          m_Neighbors[n][1] = y;
+          m_Neighbors[n][2] = z;
+          n++;
+          }
+        }
+      }
+    }
+  for ( unsigned int i = 0; i < 26; i++ )
+    {
+    m_Adjacency[i] = 0;
+    for ( unsigned int j = 0; j < 26; j++ )
+      {
+      bool isAdjacent = ( i != j );
+      for ( unsigned int d = 0; d < 3; d++ )
+        {
+        isAdjacent = isAdjacent && std::abs( m_Neighbors[i][d] - m_Neighbors[j][d] ) <= 1;
+        }
+      if ( isAdjacent )
+        {
+        m_Adjacency[i] |= uint32_t( 1 ) << j;
+        }
+      }
+    }
+
+  // the octants: the voxel k of the octant of signs s is the neighbor
+  // with the offset s[d] * the bit d of k + 1
+  for ( unsigned int o = 0; o < 8; o++ )
+    {
+    for ( unsigned int k = 0; k < 7; k++ )
+      {
+      Offset< 3 > offset;
+      for ( unsigned int d = 0; d < 3; d++ )
+        {
+        const int sign = ( o >> d ) & 1 ? 1 : -1;
+        offset[d] = ( ( k + 1 ) >> d ) & 1 ? sign : 0;
+        }
+      for ( unsigned int i = 0; i < 26; i++ )
+        {
+        if ( m_Neighbors[i] == offset )
+          {
+          m_Octants[o][k] = i;
+          }
+        }
+      }
+    }
+
+  // The object is the union of the closed unit cubes of its voxels. The
+  // vertex of the center voxel at the center of an octant, its 3 edges and
+  // 3 faces along this vertex, and the voxel itself are removed from the
+  // object with the center voxel if no other voxel of the octant contains
+  // them. They are shared by 1, 2, 4 and 8 octants.
+  for ( unsigned int configuration = 0; configuration < 128; configuration++ )
+    {
+    int change = 0;
+    for ( unsigned int cell = 0; cell < 8; cell++ )
+      {
+      // the voxels of the octant which contain the cell extended along the
+      // dimensions of the bits of cell
+      bool isRemoved = true;
+      unsigned int dimension = 0;
+      for ( unsigned int k = 1; k < 8; k++ )
+        {
+        if ( ( k & cell ) == 0 && ( ( configuration >> ( k - 1 ) ) & 1 ) )
+          {
+          isRemoved = false;
+          }
+        }
+      for ( unsigned int d = 0; d < 3; d++ )
+        {
+        dimension += ( cell >> d ) & 1;
+        }
+      if ( isRemoved )
+        {
+        change += ( dimension % 2 ? -1 : 1 ) * ( 8 >> dimension );
+        }
+      }
+    m_EulerTable[configuration] = change;
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BinaryThinningImageFilter3D< TInputImage, TOutputImage >
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType * input = const_cast< InputImageType * >( this->GetInput() );
+  if ( input )
+    {
+    input->SetRequestedRegion( input->GetLargestPossibleRegion() );
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BinaryThinningImageFilter3D< TInputImage, TOutputImage >
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  this->GetOutput()
+  ->SetRequestedRegion( this->GetOutput()->GetLargestPossibleRegion() );
+}
+
+template< typename TInputImage, typename TOutputImage >
+bool
+BinaryThinningImageFilter3D< TInputImage, TOutputImage >
+::IsDeletable(OffsetValueType position) const
+{
+  const unsigned char * center = m_Buffer.data() + position;
+  uint32_t     neighbors = 0;
+  unsigned int count = 0;
+  for ( unsigned int i = 0; i < 26; i++ )
+    {
+    if ( center[m_NeighborOffsets[i]] == 1 )
+      {
+      neighbors |= uint32_t( 1 ) << i;
+      count++;
+      }
+    }
+
+  // keep the ends of the curves
+  if ( count <= 1 )
+    {
+    return false;
+    }
+
+  // the Euler characteristic must not change
+  int change = 0;
+  for ( unsigned int o = 0; o < 8; o++ )
+    {
+    unsigned int configuration = 0;
+    for ( unsigned int k = 0; k < 7; k++ )
+      {
+      configuration |= ( ( neighbors >> m_Octants[o][k] ) & 1 ) << k;
+      }
+    change += m_EulerTable[configuration];
+    }
+  if ( change != 0 )
+    {
+    return false;
+    }
+
+  // the neighbors in the object must be 26-connected
+  uint32_t reached = neighbors & ( ~neighbors + 1 );
+  uint32_t front = reached;
+  while ( front )
+    {
+    uint32_t next = 0;
+    for ( unsigned int i = 0; i < 26; i++ )
+      {
+      if ( ( front >> i ) & 1 )
+        {
+        next |= m_Adjacency[i];
+        }
+      }
+    front = next & neighbors & ~reached;
+    reached |= front;
+    }
+  return reached == neighbors;
+}
+
+template< typename TInputImage, typename TOutputImage >
+SizeValueType
+BinaryThinningImageFilter3D< TInputImage, TOutputImage >
+::ThinSubfield(unsigned int direction, unsigned int subfield)
+{
+  // the first voxel of the subfield along each dimension, in the buffer,
+  // and the number of slices of the subfield
+  std::array< SizeValueType, 3 > first;
+  for ( unsigned int d = 0; d < 3; d++ )
+    {
+    first[d] = 1 + ( ( subfield >> d ) & 1 );
+    }
+  if ( first[2] > m_Size[2] )
+    {
+    return 0;
+    }
+  ImageRegion< 1 > slices;
+  slices.SetIndex( 0, 0 );
+  slices.SetSize( 0, ( m_Size[2] - first[2] ) / 2 + 1 );
+
+  const OffsetValueType face = m_FaceOffsets[direction];
+  std::atomic< SizeValueType > removed( 0 );
+
+  // the voxels of the subfield are not neighbors, so they can be removed
+  // in any order. The removed voxels are marked with 2, to stay in the
+  // object for the border test until the end of the direction.
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+  multiThreader->template ParallelizeImageRegion< 1 >(
+    slices,
+    [&](const ImageRegion< 1 > & region)
+      {
+      SizeValueType localRemoved = 0;
+      for ( IndexValueType s = region.GetIndex(0); s < region.GetIndex(0) + static_cast< IndexValueType >( region.GetSize(0) ); s++ )
+        {
+        const SizeValueType z = first[2] + 2 * s;
+        for ( SizeValueType y = first[1]; y <= m_Size[1]; y += 2 )
+          {
+          OffsetValueType position = z * m_Strides[2] + y * m_Strides[1] + first[0];
+          for ( SizeValueType x = first[0]; x <= m_Size[0]; x += 2, position += 2 )
+            {
+            if ( m_Buffer[position] == 1 && m_Buffer[position + face] == 0 && this->IsDeletable( position ) )
+              {
+              m_Buffer[position] = 2;
+              localRemoved++;
+              }
+            }
+          }
+        }
+      removed += localRemoved;
+      },
+    nullptr);
+
+  return removed;
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BinaryThinningImageFilter3D< TInputImage, TOutputImage >
+::GenerateData()
+{
+  this->AllocateOutputs();
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType *      output = this->GetOutput();
+  const RegionType       region = output->GetRequestedRegion();
+
+  ProgressReporter progress(this, 0, 1);
+
+  // the buffer, with a border of background
+  m_Strides[0] = 1;
+  for ( unsigned int d = 0; d < 3; d++ )
+    {
+    m_Size[d] = region.GetSize(d);
+    if ( d < 2 )
+      {
+      m_Strides[d + 1] = m_Strides[d] * ( m_Size[d] + 2 );
+      }
+    }
+  m_Buffer.assign( m_Strides[2] * ( m_Size[2] + 2 ), 0 );
+  for ( unsigned int i = 0; i < 26; i++ )
+    {
+    m_NeighborOffsets[i] = 0;
+    for ( unsigned int d = 0; d < 3; d++ )
+      {
+      m_NeighborOffsets[i] += m_Neighbors[i][d] * m_Strides[d];
+      }
+    }
+  for ( unsigned int d = 0; d < 3; d++ )
+    {
+    m_FaceOffsets[2 * d] = -m_Strides[d];
+    m_FaceOffsets[2 * d + 1] = m_Strides[d];
+    }
+  const auto positionOf = [&](const typename RegionType::IndexType & index) -> OffsetValueType
+    {
+    OffsetValueType position = 0;
+    for ( unsigned int d = 0; d < 3; d++ )
+      {
+      position += ( index[d] - region.GetIndex(d) + 1 ) * m_Strides[d];
+      }
+    return position;
+    };
+
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+  multiThreader->template ParallelizeImageRegion< InputImageDimension >(
+    region,
+    [&](const RegionType & threadRegion)
+      {
+      ImageScanlineConstIterator< InputImageType > it( input, threadRegion );
+      while ( !it.IsAtEnd() )
+        {
+        OffsetValueType position = positionOf( it.GetIndex() );
+        while ( !it.IsAtEndOfLine() )
+          {
+          m_Buffer[position++] = ( it.Get() != NumericTraits< InputPixelType >::ZeroValue() );
+          ++it;
+          }
+        it.NextLine();
+        }
+      },
+    nullptr);
+
+  // peel the object until no voxel can be removed
+  m_NumberOfIterations = 0;
+  SizeValueType removed;
+  do
+    {
+    removed = 0;
+    for ( unsigned int direction = 0; direction < 6; direction++ )
+      {
+      for ( unsigned int subfield = 0; subfield < 8; subfield++ )
+        {
+        removed += this->ThinSubfield( direction, subfield );
+        }
+      std::replace( m_Buffer.begin(), m_Buffer.end(), 2, 0 );
+      }
+    m_NumberOfIterations++;
+    }
+  while ( removed > 0 );
+
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+  multiThreader->template ParallelizeImageRegion< OutputImageDimension >(
+    region,
+    [&](const RegionType & threadRegion)
+      {
+      ImageScanlineIterator< OutputImageType > it( output, threadRegion );
+      while ( !it.IsAtEnd() )
+        {
+        OffsetValueType position = positionOf( it.GetIndex() );
+        while ( !it.IsAtEndOfLine() )
+          {
+          it.Set( m_Buffer[position++] ? NumericTraits< OutputPixelType >::OneValue()
+                                       : NumericTraits< OutputPixelType >::ZeroValue() );
+          ++it;
+          }
+        it.NextLine();
+        }
+      },
+    nullptr);
+
+  BufferType().swap( m_Buffer );
+  progress.CompletedPixel();
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BinaryThinningImageFilter3D< TInputImage, TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfIterations: " << m_NumberOfIterations << std::endl;
+}
+} // end namespace itk
+
+#endif
@@ -0,0 +1,118 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBinaryPruningImageFilter3D.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTestingMacros.h"
+
+// Prune a skeleton made of a line with two spurs and of a loop, and
+// compare with the expected result, for several numbers of threads.
+int itkBinaryPruningImageFilter3DTest( int, char * [] )
+{
+  using ImageType = itk::Image< unsigned char, 3 >;
+  using IndexType = ImageType::IndexType;
+
+  ImageType::SizeType size = {{ 40, 30, 20 }};
+  ImageType::Pointer input = ImageType::New();
+  input->SetRegions( size );
+  input->Allocate( true );
+  ImageType::Pointer expected = ImageType::New();
+  expected->SetRegions( size );
+  expected->Allocate( true );
+
+  // a line starting at the border of the image, shortened at both ends
+  for( itk::IndexValueType x = 0; x < 30; x++ )
+    {
+    const IndexType index = {{ x, 10, 10 }};
+    input->SetPixel( index, 7 );
+    if( x >= 4 && x < 26 )
+      {
+      expected->SetPixel( index, 7 );
+      }
+    }
+  // a diagonal spur of 3 voxels, which keeps the voxel touching the line,
+  // and a spur of 6 voxels, shortened
+  for( itk::IndexValueType i = 1; i <= 3; i++ )
+    {
+    const IndexType index = {{ 10 + i, 10 + i, 10 + i }};
+    input->SetPixel( index, 7 );
+    if( i == 1 )
+      {
+      expected->SetPixel( index, 7 );
+      }
+    }
+  for( itk::IndexValueType i = 1; i <= 6; i++ )
+    {
+    const IndexType index = {{ 20, 10, 10 - i }};
+    input->SetPixel( index, 7 );
+    if( i <= 2 )
+      {
+      expected->SetPixel( index, 7 );
+      }
+    }
+  // a loop, which has no end
+  for( itk::IndexValueType i = 0; i < 8; i++ )
+    {
+    const IndexType indices[4] = { {{ 30 + i, 20, 15 }}, {{ 38, 20 + i, 15 }},
+                                   {{ 38 - i, 28, 15 }}, {{ 30, 28 - i, 15 }} };
+    for( const IndexType & index : indices )
+      {
+      input->SetPixel( index, 9 );
+      expected->SetPixel( index, 9 );
+      }
+    }
+
+  using FilterType = itk::BinaryPruningImageFilter3D< ImageType >;
+  FilterType::Pointer filter = FilterType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( filter, BinaryPruningImageFilter3D, ImageToImageFilter );
+  TEST_SET_GET_VALUE( 3u, filter->GetIteration() );
+  filter->SetIteration( 4 );
+  TEST_SET_GET_VALUE( 4u, filter->GetIteration() );
+  filter->SetInput( input );
+
+  for( unsigned int threads = 1; threads < 8; threads += 3 )
+    {
+    filter->SetNumberOfThreads( threads );
+    filter->Modified();
+    TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+    unsigned int differences = 0;
+    itk::ImageRegionConstIterator< ImageType > eIt( expected, expected->GetBufferedRegion() );
+    itk::ImageRegionConstIterator< ImageType > oIt( filter->GetOutput(), expected->GetBufferedRegion() );
+    for( ; !eIt.IsAtEnd(); ++eIt, ++oIt )
+      {
+      differences += ( eIt.Get() != oIt.Get() );
+      }
+    std::cout << threads << " threads: " << differences << " differences" << std::endl;
+    TEST_EXPECT_EQUAL( differences, 0u );
+    }
+
+  // more iterations than needed to remove all the ends: the loop remains,
+  // and the line from x = 10 to 21 with the voxels of the spurs touching
+  // it, which are on cycles of 3 voxels with the line
+  filter->SetIteration( 100 );
+  TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+  unsigned int count = 0;
+  itk::ImageRegionConstIterator< ImageType > oIt( filter->GetOutput(), expected->GetBufferedRegion() );
+  for( ; !oIt.IsAtEnd(); ++oIt )
+    {
+    count += ( oIt.Get() != 0 );
+    }
+  TEST_EXPECT_EQUAL( count, 46u );
+
+  return EXIT_SUCCESS;
+}
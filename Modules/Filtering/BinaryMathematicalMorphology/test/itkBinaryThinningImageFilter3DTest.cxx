@@ -0,0 +1,228 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBinaryThinningImageFilter3D.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+#include <queue>
+
+namespace
+{
+using ImageType = itk::Image< unsigned char, 3 >;
+using IndexType = ImageType::IndexType;
+using OffsetType = ImageType::OffsetType;
+
+// The image with a border of background, as a vector.
+std::vector< bool > Padded( const ImageType * image, itk::OffsetValueType strides[3] )
+{
+  const ImageType::SizeType size = image->GetLargestPossibleRegion().GetSize();
+  strides[0] = 1;
+  strides[1] = size[0] + 2;
+  strides[2] = strides[1] * ( size[1] + 2 );
+  std::vector< bool > padded( strides[2] * ( size[2] + 2 ), false );
+  itk::ImageRegionConstIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    padded[( it.GetIndex()[0] + 1 ) + ( it.GetIndex()[1] + 1 ) * strides[1] + ( it.GetIndex()[2] + 1 ) * strides[2]] =
+      it.Get() != 0;
+    }
+  return padded;
+}
+
+// The number of components of the object, or of the background, with the
+// neighbors with at most maximumNonZero non zero offsets.
+unsigned int CountComponents( const ImageType * image, bool object, unsigned int maximumNonZero )
+{
+  itk::OffsetValueType strides[3];
+  const std::vector< bool > padded = Padded( image, strides );
+  std::vector< itk::OffsetValueType > neighbors;
+  for( int z = -1; z <= 1; z++ )
+    {
+    for( int y = -1; y <= 1; y++ )
+      {
+      for( int x = -1; x <= 1; x++ )
+        {
+        const unsigned int nonZero = ( x != 0 ) + ( y != 0 ) + ( z != 0 );
+        if( nonZero > 0 && nonZero <= maximumNonZero )
+          {
+          neighbors.push_back( x + y * strides[1] + z * strides[2] );
+          }
+        }
+      }
+    }
+  std::vector< bool > isVisited( padded.size(), false );
+  unsigned int components = 0;
+  const auto size = static_cast< itk::OffsetValueType >( padded.size() );
+  for( itk::OffsetValueType start = 0; start < size; start++ )
+    {
+    if( padded[start] != object || isVisited[start] )
+      {
+      continue;
+      }
+    components++;
+    std::queue< itk::OffsetValueType > queue;
+    queue.push( start );
+    isVisited[start] = true;
+    while( !queue.empty() )
+      {
+      const itk::OffsetValueType position = queue.front();
+      queue.pop();
+      for( itk::OffsetValueType neighbor : neighbors )
+        {
+        const itk::OffsetValueType next = position + neighbor;
+        if( next >= 0 && next < size && padded[next] == object && !isVisited[next] )
+          {
+          isVisited[next] = true;
+          queue.push( next );
+          }
+        }
+      }
+    }
+  return components;
+}
+
+// The Euler characteristic of the union of the closed unit cubes of the
+// voxels of the object, by counting the vertices, edges, faces and cubes.
+int EulerCharacteristic( const ImageType * image )
+{
+  itk::OffsetValueType strides[3];
+  const std::vector< bool > padded = Padded( image, strides );
+  const ImageType::SizeType size = image->GetLargestPossibleRegion().GetSize();
+  int characteristic = 0;
+  for( unsigned int cell = 0; cell < 8; cell++ )
+    {
+    const int sign = ( ( cell & 1 ) + ( ( cell >> 1 ) & 1 ) + ( ( cell >> 2 ) & 1 ) ) % 2 ? -1 : 1;
+    for( itk::OffsetValueType z = 1; z <= static_cast< itk::OffsetValueType >( size[2] ) + 1; z++ )
+      {
+      for( itk::OffsetValueType y = 1; y <= static_cast< itk::OffsetValueType >( size[1] ) + 1; y++ )
+        {
+        for( itk::OffsetValueType x = 1; x <= static_cast< itk::OffsetValueType >( size[0] ) + 1; x++ )
+          {
+          // the cell starting at the vertex (x, y, z) and extended along the
+          // dimensions of the bits of cell is in the voxels before the
+          // vertex along the other dimensions
+          bool isInObject = false;
+          for( unsigned int before = 0; before < 8; before++ )
+            {
+            if( ( before & cell ) == 0 )
+              {
+              isInObject = isInObject || padded[( x - ( before & 1 ) ) + ( y - ( ( before >> 1 ) & 1 ) ) * strides[1]
+                                                 + ( z - ( ( before >> 2 ) & 1 ) ) * strides[2]];
+              }
+            }
+          characteristic += isInObject ? sign : 0;
+          }
+        }
+      }
+    }
+  return characteristic;
+}
+}
+
+// Thin a ring, a ball, a bent tube and a block with a tunnel, and check
+// that the topology is preserved, that the skeleton is thin, and that it
+// does not depend on the number of threads.
+int itkBinaryThinningImageFilter3DTest( int, char * [] )
+{
+  ImageType::SizeType size = {{ 60, 50, 40 }};
+  ImageType::Pointer input = ImageType::New();
+  input->SetRegions( size );
+  input->Allocate( true );
+  itk::ImageRegionIteratorWithIndex< ImageType > it( input, input->GetBufferedRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0];
+    const double y = it.GetIndex()[1];
+    const double z = it.GetIndex()[2];
+    // a torus
+    const double ring = std::sqrt( ( x - 15 ) * ( x - 15 ) + ( y - 15 ) * ( y - 15 ) ) - 10;
+    const bool isInRing = ring * ring + ( z - 10 ) * ( z - 10 ) < 9;
+    // a ball, touching the border of the image
+    const bool isInBall = ( x - 45 ) * ( x - 45 ) + ( y - 12 ) * ( y - 12 ) + ( z - 5 ) * ( z - 5 ) < 64;
+    // a tube bent along a quarter of a circle
+    const double bend = std::sqrt( ( x - 10 ) * ( x - 10 ) + ( z - 10 ) * ( z - 10 ) ) - 22;
+    const bool isInTube = x > 10 && z > 10 && bend * bend + ( y - 38 ) * ( y - 38 ) < 12;
+    // a block with a tunnel
+    const bool isInBlock = x >= 40 && x < 56 && y >= 28 && y < 46 && z >= 20 && z < 36
+                           && !( x >= 45 && x < 50 && z >= 25 && z < 30 );
+    it.Set( ( isInRing || isInBall || isInTube || isInBlock ) ? 255 : 0 );
+    }
+
+  using FilterType = itk::BinaryThinningImageFilter3D< ImageType >;
+  FilterType::Pointer filter = FilterType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( filter, BinaryThinningImageFilter3D, ImageToImageFilter );
+  filter->SetInput( input );
+  filter->SetNumberOfThreads( 1 );
+  TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+  ImageType::Pointer skeleton = filter->GetOutput();
+  skeleton->DisconnectPipeline();
+  std::cout << "Iterations: " << filter->GetNumberOfIterations() << std::endl;
+  TEST_EXPECT_TRUE( filter->GetNumberOfIterations() > 1 );
+
+  // the topology
+  TEST_EXPECT_EQUAL( CountComponents( skeleton, true, 3 ), CountComponents( input, true, 3 ) );
+  TEST_EXPECT_EQUAL( CountComponents( skeleton, false, 1 ), CountComponents( input, false, 1 ) );
+  TEST_EXPECT_EQUAL( EulerCharacteristic( skeleton ), EulerCharacteristic( input ) );
+  std::cout << "Components: " << CountComponents( skeleton, true, 3 ) << ", Euler characteristic: "
+            << EulerCharacteristic( skeleton ) << std::endl;
+
+  // a subset of the input, which is thin
+  unsigned int inputCount = 0;
+  unsigned int skeletonCount = 0;
+  unsigned int thickBlocks = 0;
+  itk::ImageRegionConstIteratorWithIndex< ImageType > sIt( skeleton, skeleton->GetBufferedRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it, ++sIt )
+    {
+    inputCount += ( it.Get() != 0 );
+    skeletonCount += ( sIt.Get() != 0 );
+    TEST_EXPECT_TRUE( sIt.Get() == 0 || ( sIt.Get() == 1 && it.Get() != 0 ) );
+    bool isThick = true;
+    for( unsigned int corner = 0; corner < 8; corner++ )
+      {
+      IndexType index = sIt.GetIndex();
+      for( unsigned int d = 0; d < 3; d++ )
+        {
+        index[d] += ( corner >> d ) & 1;
+        }
+      isThick = isThick && skeleton->GetLargestPossibleRegion().IsInside( index ) && skeleton->GetPixel( index );
+      }
+    thickBlocks += isThick;
+    }
+  std::cout << "Voxels: " << inputCount << " -> " << skeletonCount << std::endl;
+  TEST_EXPECT_EQUAL( thickBlocks, 0u );
+
+  // the same skeleton with several threads
+  for( unsigned int threads = 2; threads < 8; threads += 3 )
+    {
+    filter->SetNumberOfThreads( threads );
+    filter->Modified();
+    TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+    unsigned int differences = 0;
+    itk::ImageRegionConstIterator< ImageType > oIt( filter->GetOutput(), skeleton->GetBufferedRegion() );
+    for( sIt.GoToBegin(); !sIt.IsAtEnd(); ++sIt, ++oIt )
+      {
+      differences += ( sIt.Get() != oIt.Get() );
+      }
+    std::cout << threads << " threads: " << differences << " differences" << std::endl;
+    TEST_EXPECT_EQUAL( differences, 0u );
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryBallDilateImageFilter_h
+#define itkBinaryBallDilateImageFilter_h
+
+#include "itkBinaryBallMorphologyImageFilter.h"
+
+namespace itk
+{
+/** \class BinaryBallDilateImageFilter
+ * \brief Binary dilation by a ball, with a cost independent of the radius
+ * for large balls.
+ *
+ * The foreground is dilated by the ball: a pixel becomes foreground when a
+ * foreground pixel lies within Radius. The other pixels keep their input
+ * value. Pixels outside the image are considered as background.
+ *
+ * Large radii are processed by thresholding a Euclidean distance map; see
+ * BinaryBallMorphologyImageFilter for the selection of the algorithm.
+ *
+ * \sa BinaryDilateImageFilter, BinaryBallErodeImageFilter
+ * \ingroup ITKDistanceMap
+ */
+template< typename TInputImage, typename TOutputImage = TInputImage >
+class ITK_TEMPLATE_EXPORT BinaryBallDilateImageFilter:
+  public BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(BinaryBallDilateImageFilter);
+
+  /** Standard class type aliases. */
+  using Self = BinaryBallDilateImageFilter;
+  using Superclass = BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >;
+  using Pointer = SmartPointer< Self >;
+  using ConstPointer = SmartPointer< const Self >;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(BinaryBallDilateImageFilter, BinaryBallMorphologyImageFilter);
+
+  using InputImageType = typename Superclass::InputImageType;
+  using OutputImageType = typename Superclass::OutputImageType;
+  using InputPixelType = typename Superclass::InputPixelType;
+  using OutputPixelType = typename Superclass::OutputPixelType;
+  using OutputImageRegionType = typename Superclass::OutputImageRegionType;
+  using KernelType = typename Superclass::KernelType;
+  using DistanceImageType = typename Superclass::DistanceImageType;
+
+protected:
+  BinaryBallDilateImageFilter() {}
+  ~BinaryBallDilateImageFilter() override {}
+
+  void GenerateData() override;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBinaryBallDilateImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryBallDilateImageFilter_hxx
+#define itkBinaryBallDilateImageFilter_hxx
+
+#include "itkBinaryBallDilateImageFilter.h"
+#include "itkBinaryDilateImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkProgressAccumulator.h"
+#include "itkMath.h"
+
+namespace itk
+{
+template< typename TInputImage, typename TOutputImage >
+void
+BinaryBallDilateImageFilter< TInputImage, TOutputImage >
+::GenerateData()
+{
+  if ( !this->GetUseDistanceMap() )
+    {
+    ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
+    progress->SetMiniPipelineFilter(this);
+
+    using StructuringElementFilterType = BinaryDilateImageFilter< InputImageType, OutputImageType, KernelType >;
+    typename StructuringElementFilterType::Pointer filter = StructuringElementFilterType::New();
+    filter->SetInput( this->GetInput() );
+    filter->SetKernel( this->GetKernel() );
+    filter->SetForegroundValue( this->GetForegroundValue() );
+    filter->SetBackgroundValue( this->GetBackgroundValue() );
+    filter->SetNumberOfThreads( this->GetNumberOfThreads() );
+    progress->RegisterInternalFilter(filter, 1.0f);
+
+    filter->GraftOutput( this->GetOutput() );
+    filter->Update();
+    this->GraftOutput( filter->GetOutput() );
+    return;
+    }
+
+  const typename DistanceImageType::Pointer distance = this->ComputeSquaredDistanceMap(true);
+
+  this->AllocateOutputs();
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType *      output = this->GetOutput();
+  const double           squaredRadius = this->GetSquaredRadiusWithTolerance();
+  const InputPixelType   foregroundValue = this->GetForegroundValue();
+
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->template ParallelizeImageRegion< OutputImageType::ImageDimension >(
+    output->GetRequestedRegion(),
+    [&](const OutputImageRegionType & region)
+      {
+      // a pixel is dilated when a foreground pixel lies within the radius
+      ImageRegionConstIterator< InputImageType >    inIt( input, region );
+      ImageRegionConstIterator< DistanceImageType > distIt( distance, region );
+      ImageRegionIterator< OutputImageType >        outIt( output, region );
+      for ( ; !outIt.IsAtEnd(); ++inIt, ++distIt, ++outIt )
+        {
+        const InputPixelType value = inIt.Get();
+        if ( Math::ExactlyEquals( value, foregroundValue )
+             || distIt.Get() <= squaredRadius )
+          {
+          outIt.Set( static_cast< OutputPixelType >( foregroundValue ) );
+          }
+        else
+          {
+          outIt.Set( static_cast< OutputPixelType >( value ) );
+          }
+        }
+      },
+    nullptr);
+}
+} // end namespace itk
+
+#endif
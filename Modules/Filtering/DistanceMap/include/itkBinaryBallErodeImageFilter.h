@@ -0,0 +1,79 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryBallErodeImageFilter_h
+#define itkBinaryBallErodeImageFilter_h
+
+#include "itkBinaryBallMorphologyImageFilter.h"
+
+namespace itk
+{
+/** \class BinaryBallErodeImageFilter
+ * \brief Binary erosion by a ball, with a cost independent of the radius
+ * for large balls.
+ *
+ * The foreground is eroded by the ball: a foreground pixel is kept when no
+ * background pixel lies within Radius, and is set to BackgroundValue
+ * otherwise. The other pixels keep their input value. Pixels outside the
+ * image are considered as foreground, as in BinaryErodeImageFilter.
+ *
+ * Large radii are processed by thresholding a Euclidean distance map; see
+ * BinaryBallMorphologyImageFilter for the selection of the algorithm.
+ *
+ * \sa BinaryErodeImageFilter, BinaryBallDilateImageFilter
+ * \ingroup ITKDistanceMap
+ */
+template< typename TInputImage, typename TOutputImage = TInputImage >
+class ITK_TEMPLATE_EXPORT BinaryBallErodeImageFilter:
+  public BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(BinaryBallErodeImageFilter);
+
+  /** Standard class type aliases. */
+  using Self = BinaryBallErodeImageFilter;
+  using Superclass = BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >;
+  using Pointer = SmartPointer< Self >;
+  using ConstPointer = SmartPointer< const Self >;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(BinaryBallErodeImageFilter, BinaryBallMorphologyImageFilter);
+
+  using InputImageType = typename Superclass::InputImageType;
+  using OutputImageType = typename Superclass::OutputImageType;
+  using InputPixelType = typename Superclass::InputPixelType;
+  using OutputPixelType = typename Superclass::OutputPixelType;
+  using OutputImageRegionType = typename Superclass::OutputImageRegionType;
+  using KernelType = typename Superclass::KernelType;
+  using DistanceImageType = typename Superclass::DistanceImageType;
+
+protected:
+  BinaryBallErodeImageFilter() {}
+  ~BinaryBallErodeImageFilter() override {}
+
+  void GenerateData() override;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBinaryBallErodeImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,162 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryBallMorphologyImageFilter_h
+#define itkBinaryBallMorphologyImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkFlatStructuringElement.h"
+
+namespace itk
+{
+/** \class BinaryBallMorphologyImageFilter
+ * \brief Base class for binary morphology with a ball of arbitrary radius.
+ *
+ * The structuring element is the ball made of the pixels whose center lies
+ * within Radius of the center pixel. The radius is expressed in physical
+ * units when UseImageSpacing is on, and in pixels otherwise, so anisotropic
+ * images can be processed with a true Euclidean ball.
+ *
+ * Two algorithms are available:
+ *
+ * - STRUCTURING_ELEMENT builds the ball as a FlatStructuringElement and runs
+ *   the classical BinaryDilateImageFilter/BinaryErodeImageFilter. Its cost
+ *   grows with the surface of the ball.
+ * - DISTANCE_MAP thresholds the exact squared Euclidean distance computed by
+ *   SignedMaurerDistanceMapImageFilter. Its cost does not depend on the
+ *   radius, and the separable passes are multithreaded.
+ *
+ * Both produce the same output. With the default AUTOMATIC algorithm, the
+ * distance map is used as soon as the radius, in pixels along the finest
+ * axis, reaches DistanceMapRadiusThreshold.
+ *
+ * Pixels with the value ForegroundValue are the foreground; all the other
+ * pixels are background.
+ *
+ * \sa BinaryBallDilateImageFilter, BinaryBallErodeImageFilter
+ * \sa SignedMaurerDistanceMapImageFilter
+ * \ingroup ITKDistanceMap
+ */
+template< typename TInputImage, typename TOutputImage >
+class ITK_TEMPLATE_EXPORT BinaryBallMorphologyImageFilter:
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(BinaryBallMorphologyImageFilter);
+
+  /** Standard class type aliases. */
+  using Self = BinaryBallMorphologyImageFilter;
+  using Superclass = ImageToImageFilter< TInputImage, TOutputImage >;
+  using Pointer = SmartPointer< Self >;
+  using ConstPointer = SmartPointer< const Self >;
+
+  /** Runtime information support. */
+  itkTypeMacro(BinaryBallMorphologyImageFilter, ImageToImageFilter);
+
+  static constexpr unsigned int ImageDimension = TInputImage::ImageDimension;
+
+  using InputImageType = TInputImage;
+  using OutputImageType = TOutputImage;
+  using InputPixelType = typename InputImageType::PixelType;
+  using OutputPixelType = typename OutputImageType::PixelType;
+  using OutputImageRegionType = typename OutputImageType::RegionType;
+  using SpacingType = typename InputImageType::SpacingType;
+
+  /** Structuring element used by the STRUCTURING_ELEMENT algorithm. */
+  using KernelType = FlatStructuringElement< ImageDimension >;
+
+  /** Image of squared distances used by the DISTANCE_MAP algorithm. */
+  using DistanceImageType = Image< double, ImageDimension >;
+
+  enum AlgorithmType {
+    AUTOMATIC = 0,
+    STRUCTURING_ELEMENT = 1,
+    DISTANCE_MAP = 2
+    };
+
+  /** Radius of the ball, in physical units if UseImageSpacing is on, in
+   * pixels otherwise. Defaults to 1. */
+  itkSetMacro(Radius, double);
+  itkGetConstMacro(Radius, double);
+
+  /** Use the image spacing to measure the radius. Defaults to off. */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstReferenceMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** Value considered as foreground. Defaults to the maximum value of
+   * InputPixelType. */
+  itkSetMacro(ForegroundValue, InputPixelType);
+  itkGetConstMacro(ForegroundValue, InputPixelType);
+
+  /** Value written in place of the removed foreground pixels. Defaults to
+   * the minimum value of OutputPixelType. */
+  itkSetMacro(BackgroundValue, OutputPixelType);
+  itkGetConstMacro(BackgroundValue, OutputPixelType);
+
+  /** Algorithm used to compute the output. Defaults to AUTOMATIC. */
+  itkSetMacro(Algorithm, int);
+  itkGetConstMacro(Algorithm, int);
+
+  /** Radius, in pixels along the finest axis, from which the AUTOMATIC
+   * algorithm uses the distance map. Defaults to 5. */
+  itkSetMacro(DistanceMapRadiusThreshold, double);
+  itkGetConstMacro(DistanceMapRadiusThreshold, double);
+
+  /** Return true if the next update will use the distance map. */
+  bool GetUseDistanceMap() const;
+
+  /** Build the ball used by the STRUCTURING_ELEMENT algorithm for the
+   * current input. */
+  KernelType GetKernel() const;
+
+protected:
+  BinaryBallMorphologyImageFilter();
+  ~BinaryBallMorphologyImageFilter() override {}
+
+  void PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** The whole input is needed to compute the distances. */
+  void GenerateInputRequestedRegion() override;
+  void EnlargeOutputRequestedRegion(DataObject *) override;
+
+  /** Squared distance from each pixel to the nearest pixel equal to the
+   * foreground value, when toForeground is true, or different from it
+   * otherwise. The distance is measured with the same units as Radius. */
+  typename DistanceImageType::Pointer ComputeSquaredDistanceMap(bool toForeground);
+
+  /** Squared radius, with a relative tolerance for the rounding of the
+   * distance computations. */
+  double GetSquaredRadiusWithTolerance() const;
+
+  SpacingType GetUnitSpacing() const;
+
+private:
+  double          m_Radius;
+  bool            m_UseImageSpacing;
+  InputPixelType  m_ForegroundValue;
+  OutputPixelType m_BackgroundValue;
+  int             m_Algorithm;
+  double          m_DistanceMapRadiusThreshold;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBinaryBallMorphologyImageFilter.hxx"
+#endif
+
+#endif
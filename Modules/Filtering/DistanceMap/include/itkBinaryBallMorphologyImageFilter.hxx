@@ -0,0 +1,196 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBinaryBallMorphologyImageFilter_hxx
+#define itkBinaryBallMorphologyImageFilter_hxx
+
+#include "itkBinaryBallMorphologyImageFilter.h"
+#include "itkBinaryThresholdImageFilter.h"
+#include "itkSignedMaurerDistanceMapImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkProgressAccumulator.h"
+#include "itkMath.h"
+
+namespace itk
+{
+template< typename TInputImage, typename TOutputImage >
+BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >
+::BinaryBallMorphologyImageFilter():
+  m_Radius(1.0),
+  m_UseImageSpacing(false),
+  m_ForegroundValue( NumericTraits< InputPixelType >::max() ),
+  m_BackgroundValue( NumericTraits< OutputPixelType >::NonpositiveMin() ),
+  m_Algorithm(AUTOMATIC),
+  m_DistanceMapRadiusThreshold(5.0)
+{
+}
+
+template< typename TInputImage, typename TOutputImage >
+typename BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >::SpacingType
+BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >
+::GetUnitSpacing() const
+{
+  SpacingType spacing;
+  spacing.Fill(1.0);
+  if ( m_UseImageSpacing && this->GetInput() != nullptr )
+    {
+    spacing = this->GetInput()->GetSpacing();
+    }
+  return spacing;
+}
+
+template< typename TInputImage, typename TOutputImage >
+bool
+BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >
+::GetUseDistanceMap() const
+{
+  if ( m_Algorithm != AUTOMATIC )
+    {
+    return m_Algorithm == DISTANCE_MAP;
+    }
+  const SpacingType spacing = this->GetUnitSpacing();
+  double            finest = spacing[0];
+  for ( unsigned int d = 1; d < ImageDimension; d++ )
+    {
+    finest = std::min( finest, static_cast< double >( spacing[d] ) );
+    }
+  return m_Radius / finest >= m_DistanceMapRadiusThreshold;
+}
+
+template< typename TInputImage, typename TOutputImage >
+double
+BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >
+::GetSquaredRadiusWithTolerance() const
+{
+  return m_Radius * m_Radius * ( 1.0 + 1e-9 );
+}
+
+template< typename TInputImage, typename TOutputImage >
+typename BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >::KernelType
+BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >
+::GetKernel() const
+{
+  const SpacingType spacing = this->GetUnitSpacing();
+  const double      squaredRadius = this->GetSquaredRadiusWithTolerance();
+
+  using BallImageType = typename KernelType::ImageType;
+  typename BallImageType::SizeType  size;
+  typename BallImageType::IndexType center;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    const auto r = static_cast< SizeValueType >( std::floor( m_Radius / spacing[d] ) );
+    size[d] = 2 * r + 1;
+    center[d] = static_cast< IndexValueType >( r );
+    }
+
+  typename BallImageType::Pointer ball = BallImageType::New();
+  ball->SetRegions(size);
+  ball->Allocate();
+
+  ImageRegionIteratorWithIndex< BallImageType > it( ball, ball->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    double squaredDistance = 0.0;
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      const double delta = ( it.GetIndex()[d] - center[d] ) * spacing[d];
+      squaredDistance += delta * delta;
+      }
+    it.Set( squaredDistance <= squaredRadius );
+    }
+
+  return KernelType::FromImage( ball );
+}
+
+template< typename TInputImage, typename TOutputImage >
+typename BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >::DistanceImageType::Pointer
+BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >
+::ComputeSquaredDistanceMap(bool toForeground)
+{
+  ProgressAccumulator::Pointer progress = ProgressAccumulator::New();
+  progress->SetMiniPipelineFilter(this);
+
+  // the distance map is computed to the pixels which are not 0
+  using MaskImageType = Image< unsigned char, ImageDimension >;
+  using ThresholdType = BinaryThresholdImageFilter< InputImageType, MaskImageType >;
+  typename ThresholdType::Pointer threshold = ThresholdType::New();
+  threshold->SetInput( this->GetInput() );
+  threshold->SetLowerThreshold( m_ForegroundValue );
+  threshold->SetUpperThreshold( m_ForegroundValue );
+  threshold->SetInsideValue( toForeground ? 1 : 0 );
+  threshold->SetOutsideValue( toForeground ? 0 : 1 );
+  threshold->SetNumberOfThreads( this->GetNumberOfThreads() );
+  progress->RegisterInternalFilter( threshold, 0.1f );
+
+  // the squared distance is kept to stay exact with integer spacing
+  using DistanceType = SignedMaurerDistanceMapImageFilter< MaskImageType, DistanceImageType >;
+  typename DistanceType::Pointer distance = DistanceType::New();
+  distance->SetInput( threshold->GetOutput() );
+  distance->SetBackgroundValue( 0 );
+  distance->SetSquaredDistance( true );
+  distance->SetUseImageSpacing( m_UseImageSpacing );
+  distance->SetInsideIsPositive( false );
+  distance->SetNumberOfThreads( this->GetNumberOfThreads() );
+  progress->RegisterInternalFilter( distance, 0.8f );
+  distance->Update();
+
+  typename DistanceImageType::Pointer output = distance->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  if ( this->GetInput() )
+    {
+    auto * input = const_cast< InputImageType * >( this->GetInput() );
+    input->SetRequestedRegionToLargestPossibleRegion();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  this->GetOutput()->SetRequestedRegionToLargestPossibleRegion();
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+BinaryBallMorphologyImageFilter< TInputImage, TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Radius: " << m_Radius << std::endl;
+  os << indent << "UseImageSpacing: " << m_UseImageSpacing << std::endl;
+  os << indent << "ForegroundValue: "
+     << static_cast< typename NumericTraits< InputPixelType >::PrintType >( m_ForegroundValue ) << std::endl;
+  os << indent << "BackgroundValue: "
+     << static_cast< typename NumericTraits< OutputPixelType >::PrintType >( m_BackgroundValue ) << std::endl;
+  os << indent << "Algorithm: " << m_Algorithm << std::endl;
+  os << indent << "DistanceMapRadiusThreshold: " << m_DistanceMapRadiusThreshold << std::endl;
+}
+} // end namespace itk
+
+#endif
@@ -52,6 +52,11 @@ namespace itk
  * Danielsson, Per-Erik.  Euclidean Distance Mapping.  Computer
  * Graphics and Image Processing 14, 227-248 (1980).
  *
+ * MaurerVoronoiDistanceMapImageFilter produces the same outputs with an
+ * exact and multithreaded algorithm.
+ *
+ * \sa MaurerVoronoiDistanceMapImageFilter
+ *
  * \ingroup ImageFeatureExtraction
  * \ingroup ITKDistanceMap
  */
@@ -0,0 +1,216 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkLabelSurfaceDistanceImageFilter_h
+#define itkLabelSurfaceDistanceImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkNumericTraits.h"
+#include "itkVector.h"
+
+#include <map>
+#include <vector>
+
+namespace itk
+{
+/** \class LabelSurfaceDistanceImageFilter
+ * \brief Computes surface distances between the labels of two images.
+ *
+ * For every nonzero label of the source and target images, this filter
+ * compares the boundary of the label in the source image with its boundary
+ * in the target image. A pixel is on the boundary of its label when one of
+ * its neighbors, in the full 3^N-1 neighborhood, has another value; the
+ * image border is not a boundary, as in ContourDirectedMeanDistanceImageFilter.
+ *
+ * The following measures are computed for each label:
+ *
+ * \li the Hausdorff distance between the two boundaries, i.e. the largest
+ *   distance from a boundary pixel to the other boundary;
+ * \li the percentile Hausdorff distance, the larger of the two directed
+ *   Percentile (95 by default) percentiles of these distances, commonly
+ *   called HD95;
+ * \li the mean distance, the larger of the two directed mean distances, as
+ *   in ContourMeanDistanceImageFilter;
+ * \li the average surface distance, the mean of the distances of all the
+ *   pixels of both boundaries.
+ *
+ * Unlike HausdorffDistanceImageFilter and ContourMeanDistanceImageFilter,
+ * no distance map is computed. The boundaries of all the labels are
+ * extracted in one multithreaded pass over the images, a
+ * Statistics::KdTree is built for each boundary, and the directed
+ * distances are answered by nearest neighbor queries which are run in
+ * parallel. The memory used is proportional to the size of the boundaries
+ * instead of the size of the images.
+ *
+ * When a label is present in only one of the images, all its distances
+ * are infinite. A label without boundary, which fills the whole image, is
+ * ignored.
+ *
+ * The filter passes the source image through unmodified.
+ *
+ * \sa HausdorffDistanceImageFilter, ContourMeanDistanceImageFilter
+ *
+ * \ingroup MultiThreaded
+ * \ingroup ITKDistanceMap
+ */
+template< typename TLabelImage >
+class ITK_TEMPLATE_EXPORT LabelSurfaceDistanceImageFilter:
+  public ImageToImageFilter< TLabelImage, TLabelImage >
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(LabelSurfaceDistanceImageFilter);
+
+  /** Standard Self type alias */
+  using Self = LabelSurfaceDistanceImageFilter;
+  using Superclass = ImageToImageFilter< TLabelImage, TLabelImage >;
+  using Pointer = SmartPointer< Self >;
+  using ConstPointer = SmartPointer< const Self >;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Runtime information support. */
+  itkTypeMacro(LabelSurfaceDistanceImageFilter, ImageToImageFilter);
+
+  /** Image related type alias. */
+  using LabelImageType = TLabelImage;
+  using RegionType = typename TLabelImage::RegionType;
+  using LabelType = typename TLabelImage::PixelType;
+
+  static constexpr unsigned int ImageDimension = TLabelImage::ImageDimension;
+
+  /** Type to use for computations. */
+  using RealType = double;
+
+  /** Position of a boundary pixel, in physical units when UseImageSpacing
+   * is on, in pixels otherwise. */
+  using PointType = Vector< RealType, ImageDimension >;
+  using PointListType = std::vector< PointType >;
+
+  /** \class LabelSurfaceDistances
+   * \brief Measures stored per label
+   * \ingroup ITKDistanceMap
+   */
+  class LabelSurfaceDistances
+  {
+  public:
+    LabelSurfaceDistances():
+      m_HausdorffDistance(0.0),
+      m_PercentileHausdorffDistance(0.0),
+      m_MeanDistance(0.0),
+      m_AverageSurfaceDistance(0.0),
+      m_SourceBoundarySize(0),
+      m_TargetBoundarySize(0)
+    {}
+
+    RealType      m_HausdorffDistance;
+    RealType      m_PercentileHausdorffDistance;
+    RealType      m_MeanDistance;
+    RealType      m_AverageSurfaceDistance;
+    SizeValueType m_SourceBoundarySize;
+    SizeValueType m_TargetBoundarySize;
+  };
+
+  /** Type of the map used to store the measures per label */
+  using MapType = std::map< LabelType, LabelSurfaceDistances >;
+
+  /** Set the source image. */
+  void SetSourceImage( const LabelImageType * image )
+  { this->SetNthInput( 0, const_cast< LabelImageType * >( image ) ); }
+
+  /** Set the target image. */
+  void SetTargetImage( const LabelImageType * image )
+  { this->SetNthInput( 1, const_cast< LabelImageType * >( image ) ); }
+
+  /** Get the source image. */
+  const LabelImageType * GetSourceImage()
+  { return this->GetInput( 0 ); }
+
+  /** Get the target image. */
+  const LabelImageType * GetTargetImage()
+  { return this->GetInput( 1 ); }
+
+  /** Set if image spacing should be used in computing distances. Defaults
+   * to true. */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** Percentile, between 0 and 100, of the percentile Hausdorff distance.
+   * Defaults to 95. */
+  itkSetClampMacro(Percentile, RealType, 0.0, 100.0);
+  itkGetConstMacro(Percentile, RealType);
+
+  /** Get the measures of all the labels. */
+  const MapType & GetLabelSurfaceDistances() const
+  { return m_LabelSurfaceDistances; }
+
+  /** Get the measures of a label. An exception is thrown if the label is not
+   * in the images. */
+  RealType GetHausdorffDistance( LabelType label ) const;
+  RealType GetPercentileHausdorffDistance( LabelType label ) const;
+  RealType GetMeanDistance( LabelType label ) const;
+  RealType GetAverageSurfaceDistance( LabelType label ) const;
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  // Begin concept checking
+  itkConceptMacro( LabelHasNumericTraitsCheck,
+                   ( Concept::HasNumericTraits< LabelType > ) );
+  // End concept checking
+#endif
+
+protected:
+  LabelSurfaceDistanceImageFilter();
+  ~LabelSurfaceDistanceImageFilter() override {}
+
+  void PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Pass the source image through unmodified. */
+  void AllocateOutputs() override;
+
+  void GenerateData() override;
+
+  // Override since the filter needs all the data for the algorithm
+  void GenerateInputRequestedRegion() override;
+
+  // Override since the filter produces all of its output
+  void EnlargeOutputRequestedRegion(DataObject *data) override;
+
+  /** Boundary pixels of every label of image, sorted. */
+  using BoundaryMapType = std::map< LabelType, PointListType >;
+  void ExtractBoundaries(const LabelImageType * image, BoundaryMapType & boundaries);
+
+  /** Distances from the points of each query list to the points of the
+   * matching reference list. */
+  void ComputeDirectedDistances(const std::vector< const PointListType * > & queries,
+                                const std::vector< const PointListType * > & references,
+                                std::vector< std::vector< RealType > > & distances);
+
+  const LabelSurfaceDistances & GetMeasures( LabelType label ) const;
+
+private:
+  bool     m_UseImageSpacing;
+  RealType m_Percentile;
+  MapType  m_LabelSurfaceDistances;
+}; // end of class
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkLabelSurfaceDistanceImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,396 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkLabelSurfaceDistanceImageFilter_hxx
+#define itkLabelSurfaceDistanceImageFilter_hxx
+
+#include "itkLabelSurfaceDistanceImageFilter.h"
+#include "itkConstNeighborhoodIterator.h"
+#include "itkNeighborhoodAlgorithm.h"
+#include "itkZeroFluxNeumannBoundaryCondition.h"
+#include "itkListSample.h"
+#include "itkKdTreeGenerator.h"
+#include "itkMath.h"
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+namespace itk
+{
+template< typename TLabelImage >
+LabelSurfaceDistanceImageFilter< TLabelImage >
+::LabelSurfaceDistanceImageFilter():
+  m_UseImageSpacing(true),
+  m_Percentile(95.0)
+{
+  // this filter requires two input images
+  this->SetNumberOfRequiredInputs(2);
+}
+
+template< typename TLabelImage >
+void
+LabelSurfaceDistanceImageFilter< TLabelImage >
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  // this filter requires:
+  // - the largeset possible region of the first image
+  // - the corresponding region of the second image
+  if ( this->GetSourceImage() )
+    {
+    auto * source = const_cast< LabelImageType * >( this->GetSourceImage() );
+    source->SetRequestedRegionToLargestPossibleRegion();
+
+    if ( this->GetTargetImage() )
+      {
+      auto * target = const_cast< LabelImageType * >( this->GetTargetImage() );
+      target->SetRequestedRegion( source->GetRequestedRegion() );
+      }
+    }
+}
+
+template< typename TLabelImage >
+void
+LabelSurfaceDistanceImageFilter< TLabelImage >
+::EnlargeOutputRequestedRegion(DataObject *data)
+{
+  Superclass::EnlargeOutputRequestedRegion(data);
+  data->SetRequestedRegionToLargestPossibleRegion();
+}
+
+template< typename TLabelImage >
+void
+LabelSurfaceDistanceImageFilter< TLabelImage >
+::AllocateOutputs()
+{
+  // Pass the source through as the output
+  auto * image = const_cast< TLabelImage * >( this->GetSourceImage() );
+
+  this->GraftOutput(image);
+}
+
+template< typename TLabelImage >
+void
+LabelSurfaceDistanceImageFilter< TLabelImage >
+::GenerateData()
+{
+  this->AllocateOutputs();
+  m_LabelSurfaceDistances.clear();
+
+  BoundaryMapType boundaries[2];
+  this->ExtractBoundaries( this->GetSourceImage(), boundaries[0] );
+  this->ExtractBoundaries( this->GetTargetImage(), boundaries[1] );
+  this->UpdateProgress(0.3f);
+
+  // the labels in only one image are reported with infinite distances
+  const RealType infinity = std::numeric_limits< RealType >::infinity();
+  std::vector< LabelType >             labels;
+  std::vector< const PointListType * > queries;
+  std::vector< const PointListType * > references;
+  for ( unsigned int i = 0; i < 2; i++ )
+    {
+    for ( const auto & boundary : boundaries[i] )
+      {
+      const auto other = boundaries[1 - i].find( boundary.first );
+      if ( other == boundaries[1 - i].end() )
+        {
+        LabelSurfaceDistances & measures = m_LabelSurfaceDistances[boundary.first];
+        measures.m_HausdorffDistance = infinity;
+        measures.m_PercentileHausdorffDistance = infinity;
+        measures.m_MeanDistance = infinity;
+        measures.m_AverageSurfaceDistance = infinity;
+        ( i == 0 ? measures.m_SourceBoundarySize : measures.m_TargetBoundarySize ) = boundary.second.size();
+        }
+      else if ( i == 0 )
+        {
+        labels.push_back( boundary.first );
+        queries.push_back( &boundary.second );
+        references.push_back( &other->second );
+        queries.push_back( &other->second );
+        references.push_back( &boundary.second );
+        }
+      }
+    }
+
+  // all the directed distances are computed at once
+  std::vector< std::vector< RealType > > distances;
+  this->ComputeDirectedDistances( queries, references, distances );
+  this->UpdateProgress(0.9f);
+
+  for ( unsigned int l = 0; l < labels.size(); l++ )
+    {
+    LabelSurfaceDistances & measures = m_LabelSurfaceDistances[labels[l]];
+    measures.m_SourceBoundarySize = queries[2 * l]->size();
+    measures.m_TargetBoundarySize = queries[2 * l + 1]->size();
+
+    RealType sum = 0.0;
+    for ( unsigned int direction = 0; direction < 2; direction++ )
+      {
+      std::vector< RealType > & directed = distances[2 * l + direction];
+      const auto                n = static_cast< SizeValueType >( directed.size() );
+
+      RealType directedSum = 0.0;
+      RealType directedMax = 0.0;
+      for ( RealType d : directed )
+        {
+        directedSum += d;
+        directedMax = std::max( directedMax, d );
+        }
+      sum += directedSum;
+
+      // nearest rank percentile
+      auto rank = static_cast< SizeValueType >( std::ceil( m_Percentile / 100.0 * n ) );
+      rank = std::min( std::max( rank, SizeValueType( 1 ) ), n ) - 1;
+      std::nth_element( directed.begin(), directed.begin() + rank, directed.end() );
+
+      measures.m_HausdorffDistance = std::max( measures.m_HausdorffDistance, directedMax );
+      measures.m_PercentileHausdorffDistance = std::max( measures.m_PercentileHausdorffDistance, directed[rank] );
+      measures.m_MeanDistance = std::max( measures.m_MeanDistance, directedSum / n );
+      }
+    measures.m_AverageSurfaceDistance =
+      sum / ( measures.m_SourceBoundarySize + measures.m_TargetBoundarySize );
+    }
+  this->UpdateProgress(1.0f);
+}
+
+template< typename TLabelImage >
+void
+LabelSurfaceDistanceImageFilter< TLabelImage >
+::ExtractBoundaries(const LabelImageType * image, BoundaryMapType & boundaries)
+{
+  PointType spacing;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    spacing[d] = m_UseImageSpacing ? image->GetSpacing()[d] : 1.0;
+    }
+
+  std::mutex mutex;
+
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->template ParallelizeImageRegion< ImageDimension >(
+    image->GetRequestedRegion(),
+    [&](const RegionType & region)
+      {
+      BoundaryMapType localBoundaries;
+
+      using NeighborhoodIteratorType = ConstNeighborhoodIterator< LabelImageType >;
+      typename NeighborhoodIteratorType::RadiusType radius;
+      radius.Fill(1);
+      ZeroFluxNeumannBoundaryCondition< LabelImageType > nbc;
+
+      using FaceCalculatorType = NeighborhoodAlgorithm::ImageBoundaryFacesCalculator< LabelImageType >;
+      FaceCalculatorType faceCalculator;
+      typename FaceCalculatorType::FaceListType faceList = faceCalculator(image, region, radius);
+
+      for ( const auto & face : faceList )
+        {
+        NeighborhoodIteratorType it(radius, image, face);
+        it.OverrideBoundaryCondition(&nbc);
+        const unsigned int neighborhoodSize = it.Size();
+
+        for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+          {
+          const LabelType label = it.GetCenterPixel();
+          if ( Math::ExactlyEquals( label, NumericTraits< LabelType >::ZeroValue() ) )
+            {
+            continue;
+            }
+          for ( unsigned int i = 0; i < neighborhoodSize; ++i )
+            {
+            if ( Math::NotExactlyEquals( it.GetPixel(i), label ) )
+              {
+              const typename LabelImageType::IndexType index = it.GetIndex();
+              PointType                                point;
+              for ( unsigned int d = 0; d < ImageDimension; d++ )
+                {
+                point[d] = index[d] * spacing[d];
+                }
+              localBoundaries[label].push_back(point);
+              break;
+              }
+            }
+          }
+        }
+
+      std::lock_guard< std::mutex > lock(mutex);
+      for ( auto & boundary : localBoundaries )
+        {
+        PointListType & points = boundaries[boundary.first];
+        points.insert( points.end(), boundary.second.begin(), boundary.second.end() );
+        }
+      },
+    nullptr);
+
+  // the order of the points must not depend on the threads, so the sums
+  // are reproducible
+  for ( auto & boundary : boundaries )
+    {
+    std::sort( boundary.second.begin(), boundary.second.end(),
+               [](const PointType & a, const PointType & b)
+                 {
+                 return std::lexicographical_compare( a.Begin(), a.End(), b.Begin(), b.End() );
+                 } );
+    }
+}
+
+template< typename TLabelImage >
+void
+LabelSurfaceDistanceImageFilter< TLabelImage >
+::ComputeDirectedDistances(const std::vector< const PointListType * > & queries,
+                           const std::vector< const PointListType * > & references,
+                           std::vector< std::vector< RealType > > & distances)
+{
+  using SampleType = Statistics::ListSample< PointType >;
+  using TreeGeneratorType = Statistics::KdTreeGenerator< SampleType >;
+  using TreeType = typename TreeGeneratorType::KdTreeType;
+
+  const auto numberOfLists = static_cast< SizeValueType >( queries.size() );
+  distances.resize(numberOfLists);
+  if ( numberOfLists == 0 )
+    {
+    return;
+    }
+
+  // Each reference list appears once in queries and once in references,
+  // so one tree is built per list. The lists are split between the
+  // threads, then the queries.
+  std::vector< typename SampleType::Pointer > samples(numberOfLists);
+  std::vector< typename TreeType::Pointer >   trees(numberOfLists);
+
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  ImageRegion< 1 > listRegion;
+  listRegion.SetSize( 0, numberOfLists );
+  multiThreader->template ParallelizeImageRegion< 1 >(
+    listRegion,
+    [&](const ImageRegion< 1 > & region)
+      {
+      for ( IndexValueType l = region.GetIndex(0); l < region.GetUpperIndex()[0] + 1; l++ )
+        {
+        typename SampleType::Pointer sample = SampleType::New();
+        sample->SetMeasurementVectorSize( ImageDimension );
+        for ( const PointType & point : *references[l] )
+          {
+          sample->PushBack( point );
+          }
+        typename TreeGeneratorType::Pointer generator = TreeGeneratorType::New();
+        generator->SetSample( sample );
+        generator->SetBucketSize( 16 );
+        generator->Update();
+        samples[l] = sample;
+        trees[l] = generator->GetOutput();
+        distances[l].resize( queries[l]->size() );
+        }
+      },
+    nullptr);
+
+  // the queries of all the lists are numbered consecutively
+  std::vector< SizeValueType > firstQuery( numberOfLists + 1, 0 );
+  for ( SizeValueType l = 0; l < numberOfLists; l++ )
+    {
+    firstQuery[l + 1] = firstQuery[l] + queries[l]->size();
+    }
+
+  ImageRegion< 1 > queryRegion;
+  queryRegion.SetSize( 0, firstQuery.back() );
+  multiThreader->template ParallelizeImageRegion< 1 >(
+    queryRegion,
+    [&](const ImageRegion< 1 > & region)
+      {
+      typename TreeType::InstanceIdentifierVectorType neighbors;
+      std::vector< double >                           neighborDistances;
+
+      const auto begin = static_cast< SizeValueType >( region.GetIndex(0) );
+      const SizeValueType end = begin + region.GetSize(0);
+      SizeValueType l = std::upper_bound( firstQuery.begin(), firstQuery.end(), begin ) - firstQuery.begin() - 1;
+      for ( SizeValueType q = begin; q < end; q++ )
+        {
+        while ( q >= firstQuery[l + 1] )
+          {
+          ++l;
+          }
+        const SizeValueType i = q - firstQuery[l];
+        trees[l]->Search( ( *queries[l] )[i], 1, neighbors, neighborDistances );
+        distances[l][i] = neighborDistances[0];
+        }
+      },
+    nullptr);
+}
+
+template< typename TLabelImage >
+const typename LabelSurfaceDistanceImageFilter< TLabelImage >::LabelSurfaceDistances &
+LabelSurfaceDistanceImageFilter< TLabelImage >
+::GetMeasures(LabelType label) const
+{
+  const auto it = m_LabelSurfaceDistances.find(label);
+  if ( it == m_LabelSurfaceDistances.end() )
+    {
+    itkExceptionMacro( "Label " << static_cast< typename NumericTraits< LabelType >::PrintType >( label )
+                                << " not found." );
+    }
+  return it->second;
+}
+
+template< typename TLabelImage >
+typename LabelSurfaceDistanceImageFilter< TLabelImage >::RealType
+LabelSurfaceDistanceImageFilter< TLabelImage >
+::GetHausdorffDistance(LabelType label) const
+{
+  return this->GetMeasures(label).m_HausdorffDistance;
+}
+
+template< typename TLabelImage >
+typename LabelSurfaceDistanceImageFilter< TLabelImage >::RealType
+LabelSurfaceDistanceImageFilter< TLabelImage >
+::GetPercentileHausdorffDistance(LabelType label) const
+{
+  return this->GetMeasures(label).m_PercentileHausdorffDistance;
+}
+
+template< typename TLabelImage >
+typename LabelSurfaceDistanceImageFilter< TLabelImage >::RealType
+LabelSurfaceDistanceImageFilter< TLabelImage >
+::GetMeanDistance(LabelType label) const
+{
+  return this->GetMeasures(label).m_MeanDistance;
+}
+
+template< typename TLabelImage >
+typename LabelSurfaceDistanceImageFilter< TLabelImage >::RealType
+LabelSurfaceDistanceImageFilter< TLabelImage >
+::GetAverageSurfaceDistance(LabelType label) const
+{
+  return this->GetMeasures(label).m_AverageSurfaceDistance;
+}
+
+template< typename TLabelImage >
+void
+LabelSurfaceDistanceImageFilter< TLabelImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "UseImageSpacing: " << m_UseImageSpacing << std::endl;
+  os << indent << "Percentile: " << m_Percentile << std::endl;
+  os << indent << "Number of labels: " << m_LabelSurfaceDistances.size() << std::endl;
+}
+} // end namespace itk
+
+#endif
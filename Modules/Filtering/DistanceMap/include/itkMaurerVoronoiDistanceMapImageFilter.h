@@ -0,0 +1,189 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkMaurerVoronoiDistanceMapImageFilter_h
+#define itkMaurerVoronoiDistanceMapImageFilter_h
+
+#include "itkImageToImageFilter.h"
+
+namespace itk
+{
+/** \class MaurerVoronoiDistanceMapImageFilter
+ *
+ * \tparam TInputImage Input Image Type
+ * \tparam TOutputImage Output Image Type
+ * \tparam TVoronoiImage Voronoi Image Type. Note the default value is TInputImage.
+ *
+ * \brief Exact Euclidean distance map, with the Voronoi partition and the
+ * vectors to the closest object pixels.
+ *
+ * This filter produces the same three outputs as
+ * DanielssonDistanceMapImageFilter, and can be used in its place:
+ *
+ * \li A <b>distance map</b> with the Euclidean distance from each pixel to
+ *   the closest nonzero pixel of the input.
+ * \li A <b>Voronoi partition</b> using the same numeric codes as the input.
+ * \li A <b>vector map</b> containing, for each pixel, the itk::Offset to the
+ *   closest object pixel, in pixels.
+ *
+ * The distance is computed with the separable algorithm of Maurer et al.
+ * used in SignedMaurerDistanceMapImageFilter, in which each pass keeps
+ * track of the closest object pixel instead of the distance only. Unlike
+ * the Danielsson algorithm, the result is exact, and each pass is
+ * multithreaded: the lines along the processed dimension are split along
+ * the outermost of the other dimensions.
+ *
+ * When several object pixels are at the same distance, the one kept may
+ * differ from the one found by DanielssonDistanceMapImageFilter. When the
+ * input does not contain any object pixel, the distance map is set to the
+ * maximum value of the output pixel type, and the Voronoi map and the
+ * vectors are set to zero.
+ *
+ * Reference:
+ * C. R. Maurer, Jr., R. Qi, and V. Raghavan, "A Linear Time Algorithm
+ * for Computing Exact Euclidean Distance Transforms of Binary Images in
+ * Arbitrary Dimensions", IEEE - Transactions on Pattern Analysis and
+ * Machine Intelligence, 25(2): 265-270, 2003.
+ *
+ * \sa DanielssonDistanceMapImageFilter, SignedMaurerDistanceMapImageFilter
+ *
+ * \ingroup ImageFeatureExtraction
+ * \ingroup ITKDistanceMap
+ */
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TVoronoiImage = TInputImage >
+class ITK_TEMPLATE_EXPORT MaurerVoronoiDistanceMapImageFilter:
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(MaurerVoronoiDistanceMapImageFilter);
+
+  /** Standard class type aliases. */
+  using Self = MaurerVoronoiDistanceMapImageFilter;
+  using Superclass = ImageToImageFilter< TInputImage, TOutputImage >;
+  using Pointer = SmartPointer< Self >;
+  using ConstPointer = SmartPointer< const Self >;
+  using DataObjectPointer = DataObject::Pointer;
+
+  /** Method for creation through the object factory */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(MaurerVoronoiDistanceMapImageFilter, ImageToImageFilter);
+
+  /** Type for input image. */
+  using InputImageType = TInputImage;
+  using InputPixelType = typename InputImageType::PixelType;
+  using RegionType = typename InputImageType::RegionType;
+  using IndexType = typename RegionType::IndexType;
+  using OffsetType = typename InputImageType::OffsetType;
+  using SpacingType = typename InputImageType::SpacingType;
+  using SizeType = typename RegionType::SizeType;
+
+  /** Type for the distance map. */
+  using OutputImageType = TOutputImage;
+  using OutputPixelType = typename OutputImageType::PixelType;
+
+  /** Type for the Voronoi map. */
+  using VoronoiImageType = TVoronoiImage;
+  using VoronoiImagePointer = typename VoronoiImageType::Pointer;
+  using VoronoiPixelType = typename VoronoiImageType::PixelType;
+
+  /** The dimension of the input and output images. */
+  static constexpr unsigned int InputImageDimension = InputImageType::ImageDimension;
+
+  /** Type for the vector distance image */
+  using VectorImageType = Image< OffsetType, Self::InputImageDimension >;
+  using VectorImagePointer = typename VectorImageType::Pointer;
+
+  /** Set if the distance should be squared. Defaults to false. */
+  itkSetMacro(SquaredDistance, bool);
+  itkGetConstReferenceMacro(SquaredDistance, bool);
+  itkBooleanMacro(SquaredDistance);
+
+  /** Set if the input is binary. If this variable is set, the Voronoi map
+   * contains 1 for all the pixels instead of the value of the closest object
+   * pixel, as in DanielssonDistanceMapImageFilter. Defaults to false. */
+  itkSetMacro(InputIsBinary, bool);
+  itkGetConstReferenceMacro(InputIsBinary, bool);
+  itkBooleanMacro(InputIsBinary);
+
+  /** Set if image spacing should be used in computing distances. The
+   * vectors are always expressed in pixels. Defaults to true. */
+  itkSetMacro(UseImageSpacing, bool);
+  itkGetConstReferenceMacro(UseImageSpacing, bool);
+  itkBooleanMacro(UseImageSpacing);
+
+  /** Get the Voronoi map. This map shows for each pixel the value of the
+   * closest nonzero pixel of the input. */
+  VoronoiImageType * GetVoronoiMap();
+
+  /** Get the distance map. */
+  OutputImageType * GetDistanceMap();
+
+  /** Get the vectors to the closest object pixels. */
+  VectorImageType * GetVectorDistanceMap();
+
+  /** Standard itk::ProcessObject subclass method. */
+  using DataObjectPointerArraySizeType = ProcessObject::DataObjectPointerArraySizeType;
+  using Superclass::MakeOutput;
+  DataObjectPointer MakeOutput( DataObjectPointerArraySizeType idx ) override;
+
+#ifdef ITK_USE_CONCEPT_CHECKING
+  static constexpr unsigned int OutputImageDimension = TOutputImage::ImageDimension;
+  static constexpr unsigned int VoronoiImageDimension = TVoronoiImage::ImageDimension;
+  // Begin concept checking
+  itkConceptMacro( InputOutputSameDimensionCheck,
+                   ( Concept::SameDimension< InputImageDimension, OutputImageDimension > ) );
+  itkConceptMacro( InputVoronoiSameDimensionCheck,
+                   ( Concept::SameDimension< InputImageDimension, VoronoiImageDimension > ) );
+  itkConceptMacro( DoubleConvertibleToOutputCheck,
+                   ( Concept::Convertible< double, OutputPixelType > ) );
+  // End concept checking
+#endif
+
+protected:
+  MaurerVoronoiDistanceMapImageFilter();
+  ~MaurerVoronoiDistanceMapImageFilter() override {}
+
+  void PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** The whole input is needed, and the whole outputs are produced. */
+  void GenerateInputRequestedRegion() override;
+  void EnlargeOutputRequestedRegion(DataObject *) override;
+
+  void GenerateData() override;
+
+  /** Update the vectors of the lines along the dimension d, starting at the
+   * pixels of lineRegion, with the closest object pixels on these lines. */
+  void ProcessLines(unsigned int d, const RegionType & lineRegion);
+
+private:
+  bool m_SquaredDistance;
+  bool m_InputIsBinary;
+  bool m_UseImageSpacing;
+
+  SpacingType m_Spacing;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkMaurerVoronoiDistanceMapImageFilter.hxx"
+#endif
+
+#endif
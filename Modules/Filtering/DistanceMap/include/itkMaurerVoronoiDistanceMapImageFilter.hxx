@@ -0,0 +1,329 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkMaurerVoronoiDistanceMapImageFilter_hxx
+#define itkMaurerVoronoiDistanceMapImageFilter_hxx
+
+#include "itkMaurerVoronoiDistanceMapImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMath.h"
+
+#include <vector>
+
+namespace itk
+{
+template< typename TInputImage, typename TOutputImage, typename TVoronoiImage >
+MaurerVoronoiDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
+::MaurerVoronoiDistanceMapImageFilter():
+  m_SquaredDistance(false),
+  m_InputIsBinary(false),
+  m_UseImageSpacing(true)
+{
+  this->SetNumberOfRequiredOutputs(3);
+
+  // distance map
+  this->SetNthOutput( 0, this->MakeOutput( 0 ) );
+
+  // voronoi map
+  this->SetNthOutput( 1, this->MakeOutput( 1 ) );
+
+  // distance vectors
+  this->SetNthOutput( 2, this->MakeOutput( 2 ) );
+
+  m_Spacing.Fill(1.0);
+}
+
+template< typename TInputImage, typename TOutputImage, typename TVoronoiImage >
+typename MaurerVoronoiDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >::DataObjectPointer
+MaurerVoronoiDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
+::MakeOutput(DataObjectPointerArraySizeType idx)
+{
+  if ( idx == 1 )
+    {
+    return VoronoiImageType::New().GetPointer();
+    }
+  if ( idx == 2 )
+    {
+    return VectorImageType::New().GetPointer();
+    }
+  return Superclass::MakeOutput( idx );
+}
+
+template< typename TInputImage, typename TOutputImage, typename TVoronoiImage >
+typename MaurerVoronoiDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >::OutputImageType *
+MaurerVoronoiDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
+::GetDistanceMap()
+{
+  return dynamic_cast< OutputImageType * >( this->ProcessObject::GetOutput(0) );
+}
+
+template< typename TInputImage, typename TOutputImage, typename TVoronoiImage >
+typename MaurerVoronoiDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >::VoronoiImageType *
+MaurerVoronoiDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
+::GetVoronoiMap()
+{
+  return dynamic_cast< VoronoiImageType * >( this->ProcessObject::GetOutput(1) );
+}
+
+template< typename TInputImage, typename TOutputImage, typename TVoronoiImage >
+typename MaurerVoronoiDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >::VectorImageType *
+MaurerVoronoiDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
+::GetVectorDistanceMap()
+{
+  return dynamic_cast< VectorImageType * >( this->ProcessObject::GetOutput(2) );
+}
+
+template< typename TInputImage, typename TOutputImage, typename TVoronoiImage >
+void
+MaurerVoronoiDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  if ( this->GetInput() )
+    {
+    auto * input = const_cast< InputImageType * >( this->GetInput() );
+    input->SetRequestedRegionToLargestPossibleRegion();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage, typename TVoronoiImage >
+void
+MaurerVoronoiDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
+::EnlargeOutputRequestedRegion(DataObject *)
+{
+  for ( unsigned int i = 0; i < this->GetNumberOfIndexedOutputs(); i++ )
+    {
+    if ( this->ProcessObject::GetOutput(i) )
+      {
+      this->ProcessObject::GetOutput(i)->SetRequestedRegionToLargestPossibleRegion();
+      }
+    }
+}
+
+template< typename TInputImage, typename TOutputImage, typename TVoronoiImage >
+void
+MaurerVoronoiDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
+::GenerateData()
+{
+  const InputImageType * input = this->GetInput();
+  const RegionType       region = input->GetRequestedRegion();
+
+  OutputImageType * distanceMap = this->GetDistanceMap();
+  distanceMap->SetBufferedRegion( region );
+  distanceMap->Allocate();
+
+  VoronoiImageType * voronoiMap = this->GetVoronoiMap();
+  voronoiMap->SetBufferedRegion( region );
+  voronoiMap->Allocate();
+
+  VectorImageType * vectorMap = this->GetVectorDistanceMap();
+  vectorMap->SetBufferedRegion( region );
+  vectorMap->Allocate();
+
+  m_Spacing.Fill(1.0);
+  if ( m_UseImageSpacing )
+    {
+    m_Spacing = input->GetSpacing();
+    }
+
+  // the vector of the pixels which have not been reached yet by any object
+  // pixel has its first component set to this value
+  const OffsetValueType unreached = NumericTraits< OffsetValueType >::max();
+
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  multiThreader->template ParallelizeImageRegion< InputImageDimension >(
+    region,
+    [&](const RegionType & threadRegion)
+      {
+      ImageRegionConstIterator< InputImageType > inIt( input, threadRegion );
+      ImageRegionIterator< VectorImageType >     vIt( vectorMap, threadRegion );
+      OffsetType                                 zero;
+      zero.Fill(0);
+      OffsetType notReached = zero;
+      notReached[0] = unreached;
+      for ( ; !inIt.IsAtEnd(); ++inIt, ++vIt )
+        {
+        vIt.Set( Math::NotExactlyEquals( inIt.Get(), NumericTraits< InputPixelType >::ZeroValue() )
+                 ? zero : notReached );
+        }
+      },
+    nullptr);
+
+  // one separable pass per dimension, over all the lines along it
+  for ( unsigned int d = 0; d < InputImageDimension; d++ )
+    {
+    RegionType lineRegion = region;
+    lineRegion.SetSize(d, 1);
+    multiThreader->template ParallelizeImageRegion< InputImageDimension >(
+      lineRegion,
+      [this, d](const RegionType & threadRegion)
+        {
+        this->ProcessLines(d, threadRegion);
+        },
+      nullptr);
+    this->UpdateProgress( static_cast< float >( d + 1 ) / ( InputImageDimension + 1 ) );
+    }
+
+  // distances and labels of the closest object pixels
+  multiThreader->template ParallelizeImageRegion< InputImageDimension >(
+    region,
+    [&](const RegionType & threadRegion)
+      {
+      ImageRegionIteratorWithIndex< VectorImageType > vIt( vectorMap, threadRegion );
+      ImageRegionIterator< OutputImageType >          dIt( distanceMap, threadRegion );
+      ImageRegionIterator< VoronoiImageType >         lIt( voronoiMap, threadRegion );
+      for ( ; !vIt.IsAtEnd(); ++vIt, ++dIt, ++lIt )
+        {
+        const OffsetType vector = vIt.Get();
+        if ( vector[0] == unreached )
+          {
+          OffsetType zero;
+          zero.Fill(0);
+          vIt.Set(zero);
+          dIt.Set( NumericTraits< OutputPixelType >::max() );
+          lIt.Set( NumericTraits< VoronoiPixelType >::ZeroValue() );
+          continue;
+          }
+
+        double distance = 0.0;
+        for ( unsigned int i = 0; i < InputImageDimension; i++ )
+          {
+          const double component = vector[i] * m_Spacing[i];
+          distance += component * component;
+          }
+        dIt.Set( static_cast< OutputPixelType >( m_SquaredDistance ? distance : std::sqrt(distance) ) );
+
+        if ( m_InputIsBinary )
+          {
+          lIt.Set( NumericTraits< VoronoiPixelType >::OneValue() );
+          }
+        else
+          {
+          lIt.Set( static_cast< VoronoiPixelType >( input->GetPixel( vIt.GetIndex() + vector ) ) );
+          }
+        }
+      },
+    nullptr);
+  this->UpdateProgress(1.0f);
+}
+
+template< typename TInputImage, typename TOutputImage, typename TVoronoiImage >
+void
+MaurerVoronoiDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
+::ProcessLines(unsigned int d, const RegionType & lineRegion)
+{
+  VectorImageType *     vectorMap = this->GetVectorDistanceMap();
+  const SizeValueType   length = vectorMap->GetBufferedRegion().GetSize()[d];
+  const OffsetValueType stride = vectorMap->GetOffsetTable()[d];
+  const double          spacing = m_Spacing[d];
+  const OffsetValueType unreached = NumericTraits< OffsetValueType >::max();
+
+  // copy of the line, and lower envelope of the parabolas of its object
+  // pixels: squared distance in the other dimensions, position and pixel
+  std::vector< OffsetType >    line(length);
+  std::vector< double >        g(length);
+  std::vector< double >        h(length);
+  std::vector< SizeValueType > site(length);
+
+  ImageRegionIterator< VectorImageType > it( vectorMap, lineRegion );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    OffsetType * buffer = &it.Value();
+
+    long l = -1;
+    for ( SizeValueType i = 0; i < length; i++ )
+      {
+      const OffsetType & vector = buffer[i * stride];
+      line[i] = vector;
+      if ( vector[0] == unreached )
+        {
+        continue;
+        }
+      double di = 0.0;
+      for ( unsigned int k = 0; k < InputImageDimension; k++ )
+        {
+        const double component = vector[k] * m_Spacing[k];
+        di += component * component;
+        }
+      const double iw = i * spacing;
+
+      // remove the parabolas hidden by the new one, as in
+      // SignedMaurerDistanceMapImageFilter
+      while ( l >= 1 )
+        {
+        const double a = h[l] - h[l - 1];
+        const double b = iw - h[l];
+        const double c = iw - h[l - 1];
+        if ( c * g[l] - b * g[l - 1] - a * di - a * b * c <= 0 )
+          {
+          break;
+          }
+        --l;
+        }
+      ++l;
+      g[l] = di;
+      h[l] = iw;
+      site[l] = i;
+      }
+
+    if ( l == -1 )
+      {
+      continue;
+      }
+
+    const long ns = l;
+    l = 0;
+    for ( SizeValueType i = 0; i < length; i++ )
+      {
+      const double iw = i * spacing;
+      double       d1 = g[l] + ( h[l] - iw ) * ( h[l] - iw );
+      while ( l < ns )
+        {
+        const double d2 = g[l + 1] + ( h[l + 1] - iw ) * ( h[l + 1] - iw );
+        if ( d1 <= d2 )
+          {
+          break;
+          }
+        ++l;
+        d1 = d2;
+        }
+      OffsetType vector = line[site[l]];
+      vector[d] = static_cast< OffsetValueType >( site[l] ) - static_cast< OffsetValueType >( i );
+      buffer[i * stride] = vector;
+      }
+    }
+}
+
+template< typename TInputImage, typename TOutputImage, typename TVoronoiImage >
+void
+MaurerVoronoiDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "SquaredDistance: " << m_SquaredDistance << std::endl;
+  os << indent << "InputIsBinary: " << m_InputIsBinary << std::endl;
+  os << indent << "UseImageSpacing: " << m_UseImageSpacing << std::endl;
+}
+} // end namespace itk
+
+#endif
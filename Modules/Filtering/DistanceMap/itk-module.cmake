@@ -7,6 +7,7 @@ itk_module(ITKDistanceMap
     ITKBinaryMathematicalMorphology
     ITKImageLabel
     ITKNarrowBand
+    ITKStatistics
   TEST_DEPENDS
     ITKTestKernel
   DESCRIPTION
@@ -0,0 +1,155 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBinaryBallDilateImageFilter.h"
+#include "itkBinaryBallErodeImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+
+template< typename TFilter >
+int CompareAlgorithms( typename TFilter::InputImageType * image, double radius, bool useSpacing )
+{
+  using ImageType = typename TFilter::InputImageType;
+
+  typename TFilter::Pointer structuringElement = TFilter::New();
+  structuringElement->SetInput( image );
+  structuringElement->SetRadius( radius );
+  structuringElement->SetUseImageSpacing( useSpacing );
+  structuringElement->SetForegroundValue( 1 );
+  structuringElement->SetBackgroundValue( 0 );
+  structuringElement->SetAlgorithm( TFilter::STRUCTURING_ELEMENT );
+  TRY_EXPECT_NO_EXCEPTION( structuringElement->Update() );
+
+  typename TFilter::Pointer distanceMap = TFilter::New();
+  distanceMap->SetInput( image );
+  distanceMap->SetRadius( radius );
+  distanceMap->SetUseImageSpacing( useSpacing );
+  distanceMap->SetForegroundValue( 1 );
+  distanceMap->SetBackgroundValue( 0 );
+  distanceMap->SetAlgorithm( TFilter::DISTANCE_MAP );
+  TRY_EXPECT_NO_EXCEPTION( distanceMap->Update() );
+
+  itk::SizeValueType foreground = 0;
+  itk::ImageRegionConstIteratorWithIndex< ImageType > it( distanceMap->GetOutput(),
+                                                          distanceMap->GetOutput()->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    if ( it.Get() != structuringElement->GetOutput()->GetPixel( it.GetIndex() ) )
+      {
+      std::cerr << distanceMap->GetNameOfClass() << " with radius " << radius
+                << ( useSpacing ? " (physical)" : "" ) << ": wrong value at " << it.GetIndex() << ": "
+                << static_cast< int >( it.Get() ) << " instead of "
+                << static_cast< int >( structuringElement->GetOutput()->GetPixel( it.GetIndex() ) ) << std::endl;
+      return EXIT_FAILURE;
+      }
+    foreground += ( it.Get() == 1 );
+    }
+  std::cout << distanceMap->GetNameOfClass() << " radius " << radius << ( useSpacing ? " (physical)" : "" )
+            << ": " << foreground << " foreground pixels" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+}
+
+int itkBinaryBallMorphologyImageFilterTest( int, char *[] )
+{
+  constexpr unsigned int Dimension = 3;
+  using ImageType = itk::Image< unsigned char, Dimension >;
+
+  // a few random blobs with some pixels of another label
+  ImageType::SizeType size;
+  size[0] = 40;
+  size[1] = 36;
+  size[2] = 20;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate( true );
+  ImageType::SpacingType spacing;
+  spacing[0] = 0.8;
+  spacing[1] = 1.0;
+  spacing[2] = 2.5;
+  image->SetSpacing( spacing );
+
+  using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( unsigned int b = 0; b < 6; ++b )
+    {
+    ImageType::PointType center;
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      center[d] = generator->GetUniformVariate( 0, size[d] * spacing[d] );
+      }
+    const double blobRadius = generator->GetUniformVariate( 4, 10 );
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      ImageType::PointType p;
+      image->TransformIndexToPhysicalPoint( it.GetIndex(), p );
+      if ( p.EuclideanDistanceTo( center ) <= blobRadius )
+        {
+        it.Set( 1 );
+        }
+      }
+    }
+  for ( unsigned int i = 0; i < 50; ++i )
+    {
+    ImageType::IndexType idx;
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      idx[d] = generator->GetIntegerVariate( size[d] - 1 );
+      }
+    image->SetPixel( idx, 2 );
+    }
+
+  using DilateType = itk::BinaryBallDilateImageFilter< ImageType >;
+  using ErodeType = itk::BinaryBallErodeImageFilter< ImageType >;
+
+  DilateType::Pointer dilate = DilateType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( dilate, BinaryBallDilateImageFilter, BinaryBallMorphologyImageFilter );
+
+  // automatic selection of the algorithm
+  dilate->SetInput( image );
+  dilate->SetRadius( 2 );
+  TEST_EXPECT_TRUE( !dilate->GetUseDistanceMap() );
+  dilate->SetRadius( 20 );
+  TEST_EXPECT_TRUE( dilate->GetUseDistanceMap() );
+  dilate->SetRadius( 4 );
+  dilate->UseImageSpacingOn();
+  TEST_EXPECT_TRUE( dilate->GetUseDistanceMap() );
+
+  const double radii[] = { 1.0, 2.0, 3.5 };
+  for ( double radius : radii )
+    {
+    for ( bool useSpacing : { false, true } )
+      {
+      if ( CompareAlgorithms< DilateType >( image, radius, useSpacing ) != EXIT_SUCCESS
+           || CompareAlgorithms< ErodeType >( image, radius, useSpacing ) != EXIT_SUCCESS )
+        {
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,214 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkLabelSurfaceDistanceImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Compare the measures with a brute force computation on two images with
+// overlapping labelled boxes.
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using ImageType = itk::Image< unsigned char, Dimension >;
+using FilterType = itk::LabelSurfaceDistanceImageFilter< ImageType >;
+using PointType = FilterType::PointType;
+
+void DrawBox( ImageType * image, unsigned char label, const ImageType::IndexType & corner, unsigned int size )
+{
+  ImageType::RegionType region;
+  region.SetIndex( corner );
+  ImageType::SizeType boxSize;
+  boxSize.Fill( size );
+  region.SetSize( boxSize );
+  region.Crop( image->GetLargestPossibleRegion() );
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, region );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    it.Set( label );
+    }
+}
+
+std::vector< PointType > Boundary( const ImageType * image, unsigned char label )
+{
+  std::vector< PointType > points;
+  const ImageType::RegionType region = image->GetLargestPossibleRegion();
+  itk::ImageRegionConstIteratorWithIndex< ImageType > it( image, region );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    if ( it.Get() != label )
+      {
+      continue;
+      }
+    bool onBoundary = false;
+    for ( int dz = -1; dz <= 1; ++dz )
+      {
+      for ( int dy = -1; dy <= 1; ++dy )
+        {
+        for ( int dx = -1; dx <= 1; ++dx )
+          {
+          ImageType::IndexType n = it.GetIndex();
+          n[0] += dx;
+          n[1] += dy;
+          n[2] += dz;
+          if ( region.IsInside( n ) && image->GetPixel( n ) != label )
+            {
+            onBoundary = true;
+            }
+          }
+        }
+      }
+    if ( onBoundary )
+      {
+      PointType p;
+      for ( unsigned int d = 0; d < Dimension; ++d )
+        {
+        p[d] = it.GetIndex()[d] * image->GetSpacing()[d];
+        }
+      points.push_back( p );
+      }
+    }
+  return points;
+}
+
+std::vector< double > DirectedDistances( const std::vector< PointType > & from, const std::vector< PointType > & to )
+{
+  std::vector< double > distances;
+  for ( const auto & p : from )
+    {
+    double best = itk::NumericTraits< double >::max();
+    for ( const auto & q : to )
+      {
+      best = std::min( best, ( p - q ).GetNorm() );
+      }
+    distances.push_back( best );
+    }
+  return distances;
+}
+
+bool Check( double value, double expected, const char * name, unsigned int label )
+{
+  if ( std::abs( value - expected ) > 1e-9 * ( 1.0 + expected ) )
+    {
+    std::cerr << "Wrong " << name << " for label " << label << ": " << value << " instead of " << expected
+              << std::endl;
+    return false;
+    }
+  return true;
+}
+
+}
+
+int itkLabelSurfaceDistanceImageFilterTest( int, char *[] )
+{
+  ImageType::SizeType size;
+  size[0] = 30;
+  size[1] = 26;
+  size[2] = 22;
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 0.8;
+  spacing[2] = 1.5;
+
+  ImageType::Pointer source = ImageType::New();
+  source->SetRegions( size );
+  source->SetSpacing( spacing );
+  source->Allocate( true );
+  ImageType::Pointer target = ImageType::New();
+  target->SetRegions( size );
+  target->SetSpacing( spacing );
+  target->Allocate( true );
+
+  ImageType::IndexType corner;
+  corner[0] = 2; corner[1] = 3; corner[2] = 2;
+  DrawBox( source, 1, corner, 10 );
+  corner[0] = 4; corner[1] = 2; corner[2] = 5;
+  DrawBox( target, 1, corner, 9 );
+  corner[0] = 15; corner[1] = 12; corner[2] = 8;
+  DrawBox( source, 2, corner, 8 );
+  corner[0] = 18; corner[1] = 10; corner[2] = 3;
+  DrawBox( target, 2, corner, 12 );
+  // a hole in label 2, and a label only in the source
+  corner[0] = 17; corner[1] = 14; corner[2] = 10;
+  DrawBox( source, 0, corner, 2 );
+  corner[0] = 2; corner[1] = 18; corner[2] = 15;
+  DrawBox( source, 3, corner, 4 );
+
+  FilterType::Pointer filter = FilterType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( filter, LabelSurfaceDistanceImageFilter, ImageToImageFilter );
+  TEST_SET_GET_BOOLEAN( filter, UseImageSpacing, true );
+  TEST_SET_GET_VALUE( 95.0, filter->GetPercentile() );
+
+  filter->SetSourceImage( source );
+  filter->SetTargetImage( target );
+  filter->SetPercentile( 90.0 );
+  TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+
+  TEST_EXPECT_EQUAL( filter->GetLabelSurfaceDistances().size(), 3u );
+  TEST_EXPECT_TRUE( std::isinf( filter->GetHausdorffDistance( 3 ) ) );
+  TRY_EXPECT_EXCEPTION( filter->GetMeanDistance( 4 ) );
+
+  for ( unsigned char label = 1; label <= 2; ++label )
+    {
+    const std::vector< PointType > sourceBoundary = Boundary( source, label );
+    const std::vector< PointType > targetBoundary = Boundary( target, label );
+    std::vector< double >          directed[2] = { DirectedDistances( sourceBoundary, targetBoundary ),
+                                                   DirectedDistances( targetBoundary, sourceBoundary ) };
+
+    double hausdorff = 0.0;
+    double percentile = 0.0;
+    double mean = 0.0;
+    double sum = 0.0;
+    for ( auto & distances : directed )
+      {
+      std::sort( distances.begin(), distances.end() );
+      const auto rank = static_cast< size_t >( std::ceil( 0.9 * distances.size() ) ) - 1;
+      double     directedSum = 0.0;
+      for ( double d : distances )
+        {
+        directedSum += d;
+        }
+      hausdorff = std::max( hausdorff, distances.back() );
+      percentile = std::max( percentile, distances[rank] );
+      mean = std::max( mean, directedSum / distances.size() );
+      sum += directedSum;
+      }
+    const double average = sum / ( sourceBoundary.size() + targetBoundary.size() );
+
+    const FilterType::LabelSurfaceDistances & measures = filter->GetLabelSurfaceDistances().at( label );
+    TEST_EXPECT_EQUAL( measures.m_SourceBoundarySize, sourceBoundary.size() );
+    TEST_EXPECT_EQUAL( measures.m_TargetBoundarySize, targetBoundary.size() );
+    if ( !Check( filter->GetHausdorffDistance( label ), hausdorff, "Hausdorff distance", label )
+         || !Check( filter->GetPercentileHausdorffDistance( label ), percentile, "percentile", label )
+         || !Check( filter->GetMeanDistance( label ), mean, "mean distance", label )
+         || !Check( filter->GetAverageSurfaceDistance( label ), average, "average surface distance", label ) )
+      {
+      return EXIT_FAILURE;
+      }
+    std::cout << "Label " << +label << ": Hausdorff " << hausdorff << ", percentile " << percentile
+              << ", mean " << mean << ", average " << average << std::endl;
+    }
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMaurerVoronoiDistanceMapImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+#include <vector>
+
+// Compare the outputs with a brute force search of the closest object
+// pixels, on images with a few labelled pixels and anisotropic spacing.
+namespace
+{
+
+template< unsigned int VDimension >
+int TestDimension( const itk::Size< VDimension > & size, unsigned int numberOfObjects )
+{
+  using InputImageType = itk::Image< unsigned short, VDimension >;
+  using OutputImageType = itk::Image< float, VDimension >;
+  using FilterType = itk::MaurerVoronoiDistanceMapImageFilter< InputImageType, OutputImageType >;
+
+  typename InputImageType::Pointer image = InputImageType::New();
+  image->SetRegions( size );
+  image->Allocate( true );
+  typename InputImageType::SpacingType spacing;
+  for ( unsigned int d = 0; d < VDimension; ++d )
+    {
+    spacing[d] = 0.7 + 0.4 * d;
+    }
+  image->SetSpacing( spacing );
+
+  using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 5678 );
+
+  std::vector< typename InputImageType::IndexType > objects;
+  for ( unsigned int i = 0; i < numberOfObjects; ++i )
+    {
+    typename InputImageType::IndexType idx;
+    for ( unsigned int d = 0; d < VDimension; ++d )
+      {
+      idx[d] = generator->GetIntegerVariate( size[d] - 1 );
+      }
+    image->SetPixel( idx, static_cast< unsigned short >( i + 1 ) );
+    objects.push_back( idx );
+    }
+
+  for ( bool useSpacing : { false, true } )
+    {
+    typename FilterType::Pointer filter = FilterType::New();
+    filter->SetInput( image );
+    filter->SetUseImageSpacing( useSpacing );
+    filter->SetSquaredDistance( true );
+    TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+
+    itk::ImageRegionConstIteratorWithIndex< OutputImageType > it( filter->GetDistanceMap(),
+                                                                  image->GetLargestPossibleRegion() );
+    for ( ; !it.IsAtEnd(); ++it )
+      {
+      const typename InputImageType::IndexType idx = it.GetIndex();
+      double                                    best = itk::NumericTraits< double >::max();
+      for ( const auto & object : objects )
+        {
+        double distance = 0.0;
+        for ( unsigned int d = 0; d < VDimension; ++d )
+          {
+          const double delta = ( object[d] - idx[d] ) * ( useSpacing ? spacing[d] : 1.0 );
+          distance += delta * delta;
+          }
+        best = std::min( best, distance );
+        }
+      if ( std::abs( it.Get() - best ) > 1e-4 * ( 1.0 + best ) )
+        {
+        std::cerr << "Wrong distance at " << idx << ": " << it.Get() << " instead of " << best << std::endl;
+        return EXIT_FAILURE;
+        }
+
+      // the vector must lead to an object pixel at the same distance, whose
+      // value is in the Voronoi map
+      const typename FilterType::OffsetType vector = filter->GetVectorDistanceMap()->GetPixel( idx );
+      double                                distance = 0.0;
+      for ( unsigned int d = 0; d < VDimension; ++d )
+        {
+        const double delta = vector[d] * ( useSpacing ? spacing[d] : 1.0 );
+        distance += delta * delta;
+        }
+      const unsigned short label = image->GetPixel( idx + vector );
+      if ( label == 0 || std::abs( distance - best ) > 1e-4 * ( 1.0 + best )
+           || filter->GetVoronoiMap()->GetPixel( idx ) != label )
+        {
+        std::cerr << "Wrong vector or Voronoi label at " << idx << ": " << vector << ", "
+                  << filter->GetVoronoiMap()->GetPixel( idx ) << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // the result must not depend on the number of threads
+  typename FilterType::Pointer single = FilterType::New();
+  single->SetInput( image );
+  single->SetNumberOfThreads( 1 );
+  single->Update();
+  typename FilterType::Pointer multi = FilterType::New();
+  multi->SetInput( image );
+  multi->SetNumberOfThreads( 4 );
+  multi->Update();
+  itk::ImageRegionConstIteratorWithIndex< typename FilterType::VectorImageType > vit(
+    single->GetVectorDistanceMap(), image->GetLargestPossibleRegion() );
+  for ( ; !vit.IsAtEnd(); ++vit )
+    {
+    if ( vit.Get() != multi->GetVectorDistanceMap()->GetPixel( vit.GetIndex() ) )
+      {
+      std::cerr << "Different vectors with several threads at " << vit.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+}
+
+int itkMaurerVoronoiDistanceMapImageFilterTest( int, char *[] )
+{
+  using ImageType = itk::Image< unsigned char, 2 >;
+  using FilterType = itk::MaurerVoronoiDistanceMapImageFilter< ImageType, ImageType >;
+  FilterType::Pointer filter = FilterType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( filter, MaurerVoronoiDistanceMapImageFilter, ImageToImageFilter );
+
+  TEST_SET_GET_BOOLEAN( filter, SquaredDistance, true );
+  TEST_SET_GET_BOOLEAN( filter, InputIsBinary, true );
+  TEST_SET_GET_BOOLEAN( filter, UseImageSpacing, true );
+
+  // an image without object
+  ImageType::SizeType size;
+  size.Fill( 5 );
+  ImageType::Pointer empty = ImageType::New();
+  empty->SetRegions( size );
+  empty->Allocate( true );
+  filter->SetInput( empty );
+  filter->InputIsBinaryOff();
+  TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+  ImageType::IndexType idx;
+  idx.Fill( 2 );
+  TEST_EXPECT_EQUAL( filter->GetDistanceMap()->GetPixel( idx ), itk::NumericTraits< unsigned char >::max() );
+  TEST_EXPECT_EQUAL( filter->GetVoronoiMap()->GetPixel( idx ), 0 );
+
+  itk::Size< 2 > size2D;
+  size2D[0] = 61;
+  size2D[1] = 47;
+  itk::Size< 3 > size3D;
+  size3D[0] = 23;
+  size3D[1] = 19;
+  size3D[2] = 17;
+  if ( TestDimension< 2 >( size2D, 40 ) != EXIT_SUCCESS
+       || TestDimension< 3 >( size3D, 30 ) != EXIT_SUCCESS )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
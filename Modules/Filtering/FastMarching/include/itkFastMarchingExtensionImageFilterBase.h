@@ -137,6 +137,20 @@ protected:
 
   void UpdateValue( OutputImageType* oImage, const NodeType& iValue ) override;
 
+  using InternalNodeStructureArray = typename Superclass::InternalNodeStructureArray;
+
+  /** Extend the auxiliary values to a node with a value iValue, from the
+   * nodes used to compute it. Returns true if one of them has changed. */
+  bool UpdateAuxiliaryValues( const NodeType& iNode,
+                              const OutputPixelType& iValue,
+                              const InternalNodeStructureArray& iNodesUsed );
+
+  /** The Fast Iterative Method extends the auxiliary values each time a
+   * node is solved */
+  bool UpdateIteratedNodeData( const NodeType& iNode,
+                               const OutputPixelType& iValue,
+                               const InternalNodeStructureArray& iNodesUsed ) override;
+
   /** Generate the output image meta information */
   void GenerateOutputInformation() override;
 
@@ -147,12 +147,13 @@ FastMarchingExtensionImageFilterBase< TInput, TOutput, TAuxValue, VAuxDimension
     itkExceptionMacro(<< "in Initialize(): AuxTrialValues is the wrong size");
     }
 
-  // allocate memory for the auxiliary outputs
+  // allocate memory for the auxiliary outputs, initialized to zero since
+  // the previous values are compared with the updated ones
   for ( unsigned int k = 0; k < AuxDimension; k++ )
     {
     AuxImageType *ptr = this->GetAuxiliaryImage(k);
     ptr->SetBufferedRegion( ptr->GetRequestedRegion() );
-    ptr->Allocate();
+    ptr->Allocate( true );
     this->m_AuxImages[k] = ptr;
     }
 
@@ -234,8 +235,6 @@ FastMarchingExtensionImageFilterBase< TInput, TOutput, TAuxValue, VAuxDimension
 
   this->GetInternalNodesUsed( oImage, iNode, NodesUsed );
 
-  InternalNodeStructure temp_node;
-
   auto outputPixel = static_cast< OutputPixelType >( this->Solve( oImage, iNode, NodesUsed ) );
 
   if ( outputPixel < this->m_LargeValue )
@@ -251,38 +250,74 @@ FastMarchingExtensionImageFilterBase< TInput, TOutput, TAuxValue, VAuxDimension
     this->m_Heap.push( NodePairType( iNode, outputPixel ) );
 
     // update auxiliary values
-    for ( unsigned int k = 0; k < AuxDimension; k++ )
-      {
-      double       numer = 0.;
-      double       denom = 0.;
-      AuxValueType auxVal;
+    this->UpdateAuxiliaryValues( iNode, outputPixel, NodesUsed );
+    }
+}
 
-      for ( unsigned int j = 0; j < ImageDimension; j++ )
-        {
-        temp_node = NodesUsed[j];
+template< typename TInput, typename TOutput,
+         typename TAuxValue,
+         unsigned int VAuxDimension >
+bool
+FastMarchingExtensionImageFilterBase< TInput, TOutput, TAuxValue, VAuxDimension >
+::UpdateAuxiliaryValues( const NodeType& iNode,
+                         const OutputPixelType& iValue,
+                         const InternalNodeStructureArray& iNodesUsed )
+{
+  bool changed = false;
 
-        if ( outputPixel < temp_node.m_Value )
-          {
-          break;
-          }
+  for ( unsigned int k = 0; k < AuxDimension; k++ )
+    {
+    double       numer = 0.;
+    double       denom = 0.;
+    AuxValueType auxVal;
 
-        auxVal = this->m_AuxImages[k]->GetPixel( temp_node.m_Node );
-        numer += auxVal * ( outputPixel - temp_node.m_Value );
-        denom += outputPixel - temp_node.m_Value;
-        }
+    for ( unsigned int j = 0; j < ImageDimension; j++ )
+      {
+      const InternalNodeStructure & temp_node = iNodesUsed[j];
 
-      if ( denom > itk::Math::eps )
-        {
-        auxVal = static_cast< AuxValueType >( numer / denom );
-        }
-      else
+      if ( iValue < temp_node.m_Value )
         {
-        auxVal = NumericTraits< AuxValueType >::ZeroValue();
+        break;
         }
 
-      this->m_AuxImages[k]->SetPixel(iNode, auxVal);
+      auxVal = this->m_AuxImages[k]->GetPixel( temp_node.m_Node );
+      numer += auxVal * ( iValue - temp_node.m_Value );
+      denom += iValue - temp_node.m_Value;
       }
+
+    if ( denom > itk::Math::eps )
+      {
+      auxVal = static_cast< AuxValueType >( numer / denom );
+      }
+    else
+      {
+      auxVal = NumericTraits< AuxValueType >::ZeroValue();
+      }
+
+    // the auxiliary images start at zero, so the first value of a node is
+    // a change unless it is zero
+    const AuxValueType previous = this->m_AuxImages[k]->GetPixel( iNode );
+    if ( ( previous < auxVal ) || ( auxVal < previous ) )
+      {
+      changed = true;
+      }
+
+    this->m_AuxImages[k]->SetPixel(iNode, auxVal);
     }
+
+  return changed;
+}
+
+template< typename TInput, typename TOutput,
+         typename TAuxValue,
+         unsigned int VAuxDimension >
+bool
+FastMarchingExtensionImageFilterBase< TInput, TOutput, TAuxValue, VAuxDimension >
+::UpdateIteratedNodeData( const NodeType& iNode,
+                          const OutputPixelType& iValue,
+                          const InternalNodeStructureArray& iNodesUsed )
+{
+  return this->UpdateAuxiliaryValues( iNode, iValue, iNodesUsed );
 }
 } // namespace itk
 
@@ -24,6 +24,7 @@
 #include "itkNeighborhoodIterator.h"
 #include "itkArray.h"
 #include <bitset>
+#include <vector>
 
 namespace itk
 {
@@ -61,6 +62,24 @@ namespace itk
  * "Level Set Methods and Fast Marching Methods", J.A. Sethian,
  * Cambridge Press, Second edition, 1999.
  *
+ * When UseFastIterativeMethod is on, the arrival times are computed with
+ * the Fast Iterative Method instead of the heap. The image is split in
+ * blocks, and the active blocks are updated concurrently until their values
+ * do not change anymore; a block is activated again when the values on the
+ * faces of one of its neighbors change. The blocks processed at the same
+ * time are never adjacent, so the result does not depend on the number of
+ * threads. The converged values are then accepted in increasing order until
+ * the stopping criterion is satisfied, and the trial values of the front
+ * are computed from the accepted nodes only, so the output and the label
+ * image hold the same alive and trial nodes as with the heap. With a
+ * FastMarchingThresholdStoppingCriterion, the fronts are not propagated
+ * beyond the threshold. Topology checks are only supported by the heap,
+ * which is used when TopologyCheck is not Nothing.
+ *
+ * Reference:
+ * W.-K. Jeong and R. T. Whitaker, "A Fast Iterative Method for Eikonal
+ * Equations", SIAM Journal on Scientific Computing, 30(5):2512-2534, 2008.
+ *
  * For an alternative implementation, see itk::FastMarchingImageFilter.
  *
  * \tparam TTraits traits
@@ -155,6 +174,12 @@ public:
   itkGetConstReferenceMacro(OverrideOutputInformation, bool);
   itkBooleanMacro(OverrideOutputInformation);
 
+  /** Set/Get whether the Fast Iterative Method is used instead of the heap.
+   * Default is false. */
+  itkSetMacro(UseFastIterativeMethod, bool);
+  itkGetConstReferenceMacro(UseFastIterativeMethod, bool);
+  itkBooleanMacro(UseFastIterativeMethod);
+
 protected:
 
   FastMarchingImageFilterBase();
@@ -172,6 +197,7 @@ protected:
   OutputSpacingType   m_OutputSpacing;
   OutputDirectionType m_OutputDirection;
   bool                m_OverrideOutputInformation;
+  bool                m_UseFastIterativeMethod;
 
   /** Generate the output image meta information. */
   void GenerateOutputInformation() override;
@@ -212,6 +238,52 @@ protected:
                       const NodeType& iNode ) override;
   void InitializeOutput( OutputImageType* oImage ) override;
 
+  /** Use the Fast Iterative Method when UseFastIterativeMethod is on */
+  void GenerateData() override;
+
+  /** Compute the arrival times with the Fast Iterative Method, accept the
+   * nodes and update the front */
+  void GenerateDataWithFastIterativeMethod();
+
+  /** Update the active blocks until all of them have converged. The nodes
+   * with a value greater than or equal to iLimit are not propagated. */
+  void IterateBlocks( OutputImageType* oImage,
+                      const std::vector< NodeType >& iSeeds,
+                      const OutputPixelType& iLimit );
+
+  /** Update the nodes of a block until they do not change anymore. Returns
+   * the faces of the block where a node has changed, two bits per dimension. */
+  unsigned int IterateBlock( OutputImageType* oImage,
+                             const OutputRegionType& iBlock,
+                             const OutputPixelType& iLimit );
+
+  /** Solve the quadratic equation at a node with the neighbors which have
+   * reached a value lower than iLimit, or with the alive neighbors only when
+   * iAliveOnly is true. Returns false if the node cannot be reached from
+   * these neighbors. */
+  bool SolveIteratedNode( OutputImageType* oImage,
+                          const NodeType& iNode,
+                          const OutputPixelType& iLimit,
+                          bool iAliveOnly,
+                          OutputPixelType& oValue,
+                          InternalNodeStructureArray& oNodesUsed ) const;
+
+  /** Update the data attached to a node by a subclass when the Fast
+   * Iterative Method solves it with the neighbors iNodesUsed. Returns true if
+   * this data has changed. Called concurrently on nodes of non adjacent
+   * blocks. */
+  virtual bool UpdateIteratedNodeData( const NodeType& itkNotUsed(iNode),
+                                       const OutputPixelType& itkNotUsed(iValue),
+                                       const InternalNodeStructureArray& itkNotUsed(iNodesUsed) )
+  { return false; }
+
+  /** Update the data attached to a node by a subclass when the Fast
+   * Iterative Method accepts it, once all the nodes are labeled. Called
+   * concurrently. */
+  virtual void UpdateAcceptedNodeData( OutputImageType* itkNotUsed(oImage),
+                                       const NodeType& itkNotUsed(iNode) )
+  {}
+
   /** Find the nodes were the front will propagate given a node */
   void GetInternalNodesUsed( OutputImageType* oImage,
                              const NodeType& iNode,
@@ -22,8 +22,16 @@
 #include "itkFastMarchingImageFilterBase.h"
 
 #include "itkImageRegionIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
 #include "itkConnectedComponentImageFilter.h"
 #include "itkRelabelComponentImageFilter.h"
+#include "itkFastMarchingThresholdStoppingCriterion.h"
+#include "itkMultiThreaderBase.h"
+#include "itkMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
 
 namespace itk
 {
@@ -50,6 +58,7 @@ template< typename TInput, typename TOutput >
 FastMarchingImageFilterBase< TInput, TOutput >::
 FastMarchingImageFilterBase() :
   m_OverrideOutputInformation( false ),
+  m_UseFastIterativeMethod( false ),
   m_LabelImage( LabelImageType::New() )
 {
   m_StartIndex.Fill(0);
@@ -631,6 +640,551 @@ InitializeOutput( OutputImageType* oImage )
   m_InputCache = this->GetInput();
 }
 
+template< typename TInput, typename TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+GenerateData()
+{
+  if( m_UseFastIterativeMethod && ( this->m_TopologyCheck == Superclass::Nothing ) )
+    {
+    this->GenerateDataWithFastIterativeMethod();
+    }
+  else
+    {
+    Superclass::GenerateData();
+    }
+}
+
+template< typename TInput, typename TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+GenerateDataWithFastIterativeMethod()
+{
+  OutputImageType* output = this->GetOutput();
+
+  this->Initialize( output );
+
+  // The trial points pushed in the heap are the seeds of the iterations
+  std::vector< NodeType > seeds;
+  seeds.reserve( this->m_Heap.size() );
+  while( !this->m_Heap.empty() )
+    {
+    seeds.push_back( this->m_Heap.top().GetNode() );
+    this->m_Heap.pop();
+    }
+
+  this->m_StoppingCriterion->Reinitialize();
+
+  // No node above a threshold is accepted, so the fronts do not need to be
+  // propagated further
+  using ThresholdCriterionType = FastMarchingThresholdStoppingCriterion< TInput, TOutput >;
+  auto * thresholdCriterion =
+    dynamic_cast< ThresholdCriterionType * >( this->m_StoppingCriterion.GetPointer() );
+
+  OutputPixelType limit = this->m_LargeValue;
+  if( thresholdCriterion )
+    {
+    limit = thresholdCriterion->GetThreshold();
+    }
+
+  this->IterateBlocks( output, seeds, limit );
+  this->UpdateProgress( 0.5f );
+
+  OutputPixelType current_value = NumericTraits< OutputPixelType >::ZeroValue();
+
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  if( thresholdCriterion && !this->m_CollectPoints )
+    {
+    // All the nodes below the threshold are accepted, the front stops at the
+    // lowest node above it
+    std::mutex      mutex;
+    bool            stopped = false;
+    bool            accepted = false;
+    OutputPixelType stopValue = this->m_LargeValue;
+    OutputPixelType lastValue = current_value;
+
+    multiThreader->template ParallelizeImageRegion< ImageDimension >(
+      m_BufferedRegion,
+      [&](const OutputRegionType & region)
+        {
+        bool            threadStopped = false;
+        bool            threadAccepted = false;
+        OutputPixelType threadStopValue = this->m_LargeValue;
+        OutputPixelType threadLastValue = NumericTraits< OutputPixelType >::ZeroValue();
+
+        ImageRegionIterator< LabelImageType >  labelIt( m_LabelImage, region );
+        ImageRegionIterator< OutputImageType > outputIt( output, region );
+        for( ; !labelIt.IsAtEnd(); ++labelIt, ++outputIt )
+          {
+          const unsigned char label = labelIt.Get();
+          if( ( label != Traits::Trial ) && ( label != Traits::InitialTrial ) )
+            {
+            continue;
+            }
+          const OutputPixelType value = outputIt.Get();
+          if( value < limit )
+            {
+            labelIt.Set( Traits::Alive );
+            if( !threadAccepted || threadLastValue < value )
+              {
+              threadLastValue = value;
+              }
+            threadAccepted = true;
+            }
+          else if( !threadStopped || value < threadStopValue )
+            {
+            threadStopValue = value;
+            threadStopped = true;
+            }
+          }
+
+        std::lock_guard< std::mutex > lock( mutex );
+        if( threadStopped && ( !stopped || threadStopValue < stopValue ) )
+          {
+          stopValue = threadStopValue;
+          stopped = true;
+          }
+        if( threadAccepted && ( !accepted || lastValue < threadLastValue ) )
+          {
+          lastValue = threadLastValue;
+          accepted = true;
+          }
+        },
+      nullptr );
+
+    current_value = stopped ? stopValue : lastValue;
+    }
+  else
+    {
+    // Replay the acceptance of the heap on the converged values
+    std::vector< NodePairType > candidates;
+
+    ImageRegionConstIteratorWithIndex< LabelImageType > labelIt( m_LabelImage, m_BufferedRegion );
+    for( ; !labelIt.IsAtEnd(); ++labelIt )
+      {
+      const unsigned char label = labelIt.Get();
+      if( ( label == Traits::Trial ) || ( label == Traits::InitialTrial ) )
+        {
+        candidates.push_back( NodePairType( labelIt.GetIndex(),
+                                            output->GetPixel( labelIt.GetIndex() ) ) );
+        }
+      }
+    std::sort( candidates.begin(), candidates.end() );
+
+    for( typename std::vector< NodePairType >::const_iterator it = candidates.begin();
+         it != candidates.end(); ++it )
+      {
+      current_value = it->GetValue();
+
+      this->m_StoppingCriterion->SetCurrentNodePair( *it );
+      if( this->m_StoppingCriterion->IsSatisfied() )
+        {
+        break;
+        }
+
+      if( this->m_CollectPoints )
+        {
+        this->m_ProcessedPoints->push_back( *it );
+        }
+      this->SetLabelValueForGivenNode( it->GetNode(), Traits::Alive );
+      }
+    }
+
+  this->m_TargetReachedValue = current_value;
+
+  // The initial alive points are not accepted by the iterations
+  std::vector< OffsetValueType > initialAlive;
+  if( this->m_AlivePoints )
+    {
+    NodePairContainerConstIterator pointsIter = this->m_AlivePoints->Begin();
+    NodePairContainerConstIterator pointsEnd = this->m_AlivePoints->End();
+    for( ; pointsIter != pointsEnd; ++pointsIter )
+      {
+      const NodeType node = pointsIter->Value().GetNode();
+      if( m_BufferedRegion.IsInside( node ) )
+        {
+        initialAlive.push_back( output->ComputeOffset( node ) );
+        }
+      }
+    std::sort( initialAlive.begin(), initialAlive.end() );
+    }
+
+  // The values of the nodes which have not been accepted were computed with
+  // other nodes which have not been accepted: compute the front again from
+  // the accepted nodes only. The alive nodes are not modified, so the nodes
+  // can be processed concurrently.
+  multiThreader->template ParallelizeImageRegion< ImageDimension >(
+    m_BufferedRegion,
+    [&](const OutputRegionType & region)
+      {
+      InternalNodeStructureArray nodesUsed;
+
+      ImageRegionIteratorWithIndex< LabelImageType > labelIt( m_LabelImage, region );
+      for( ; !labelIt.IsAtEnd(); ++labelIt )
+        {
+        const unsigned char label = labelIt.Get();
+        const NodeType      node = labelIt.GetIndex();
+        if( label == Traits::Trial )
+          {
+          OutputPixelType value;
+          if( this->SolveIteratedNode( output, node, limit, true, value, nodesUsed ) )
+            {
+            output->SetPixel( node, value );
+            this->UpdateIteratedNodeData( node, value, nodesUsed );
+            }
+          else
+            {
+            output->SetPixel( node, this->m_LargeValue );
+            labelIt.Set( Traits::Far );
+            }
+          }
+        else if( ( label == Traits::Alive ) &&
+                 !std::binary_search( initialAlive.begin(), initialAlive.end(),
+                                      output->ComputeOffset( node ) ) )
+          {
+          this->UpdateAcceptedNodeData( output, node );
+          }
+        }
+      },
+    nullptr );
+
+  this->UpdateProgress( 1.0f );
+}
+
+template< typename TInput, typename TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+IterateBlocks( OutputImageType* oImage,
+               const std::vector< NodeType >& iSeeds,
+               const OutputPixelType& iLimit )
+{
+  const OutputSizeType regionSize = m_BufferedRegion.GetSize();
+
+  // Blocks of about a thousand nodes
+  const auto blockSide = std::max< SizeValueType >( 2,
+    Math::Round< SizeValueType >( std::pow( 1024.0, 1.0 / ImageDimension ) ) );
+
+  OutputSizeType gridSize;
+  SizeValueType  numberOfBlocks = 1;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    gridSize[d] = ( regionSize[d] + blockSide - 1 ) / blockSide;
+    numberOfBlocks *= gridSize[d];
+    }
+
+  auto blockIndex = [&](const NodeType & node)
+    {
+    SizeValueType b = 0;
+    for( int d = ImageDimension - 1; d >= 0; d-- )
+      {
+      b = b * gridSize[d] + ( node[d] - m_StartIndex[d] ) / blockSide;
+      }
+    return b;
+    };
+
+  auto blockRegion = [&](SizeValueType b)
+    {
+    OutputRegionType block;
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      const SizeValueType g = b % gridSize[d];
+      b /= gridSize[d];
+      block.SetIndex( d, m_StartIndex[d] + static_cast< OffsetValueType >( g * blockSide ) );
+      block.SetSize( d, std::min( blockSide, regionSize[d] - g * blockSide ) );
+      }
+    return block;
+    };
+
+  // The blocks of the seeds, and their neighbors when the seeds are on a
+  // face, are active
+  std::vector< unsigned char > active( numberOfBlocks, 0 );
+  for( typename std::vector< NodeType >::const_iterator it = iSeeds.begin(); it != iSeeds.end(); ++it )
+    {
+    active[blockIndex( *it )] = 1;
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      for( int s = -1; s < 2; s += 2 )
+        {
+        NodeType neighbor = *it;
+        neighbor[d] += s;
+        if( m_BufferedRegion.IsInside( neighbor ) )
+          {
+          active[blockIndex( neighbor )] = 1;
+          }
+        }
+      }
+    }
+
+  // The blocks of a color are never adjacent, and can be updated concurrently
+  std::vector< unsigned int > faces( numberOfBlocks, 0 );
+  std::vector< unsigned int > colors( numberOfBlocks, 0 );
+  for( SizeValueType b = 0; b < numberOfBlocks; b++ )
+    {
+    SizeValueType g = b;
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      colors[b] |= ( ( g % gridSize[d] ) & 1 ) << d;
+      g /= gridSize[d];
+      }
+    }
+
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  std::vector< SizeValueType > blocks;
+  bool                         anyActive = !iSeeds.empty();
+  while( anyActive )
+    {
+    for( unsigned int color = 0; color < ( 1u << ImageDimension ); color++ )
+      {
+      blocks.clear();
+      for( SizeValueType b = 0; b < numberOfBlocks; b++ )
+        {
+        if( active[b] && ( colors[b] == color ) )
+          {
+          blocks.push_back( b );
+          }
+        }
+      if( blocks.empty() )
+        {
+        continue;
+        }
+
+      ImageRegion< 1 > range;
+      range.SetIndex( 0, 0 );
+      range.SetSize( 0, blocks.size() );
+      multiThreader->template ParallelizeImageRegion< 1 >(
+        range,
+        [&](const ImageRegion< 1 > & threadRange)
+          {
+          const IndexValueType first = threadRange.GetIndex( 0 );
+          const IndexValueType last = first + static_cast< IndexValueType >( threadRange.GetSize( 0 ) );
+          for( IndexValueType i = first; i < last; i++ )
+            {
+            faces[blocks[i]] = this->IterateBlock( oImage, blockRegion( blocks[i] ), iLimit );
+            }
+          },
+        nullptr );
+
+      // Activate the neighbors of the faces which have changed
+      for( typename std::vector< SizeValueType >::const_iterator it = blocks.begin(); it != blocks.end(); ++it )
+        {
+        active[*it] = 0;
+        SizeValueType g = *it;
+        SizeValueType stride = 1;
+        for( unsigned int d = 0; d < ImageDimension; d++ )
+          {
+          const SizeValueType gd = g % gridSize[d];
+          g /= gridSize[d];
+          if( ( faces[*it] & ( 1u << ( 2 * d ) ) ) && ( gd > 0 ) )
+            {
+            active[*it - stride] = 1;
+            }
+          if( ( faces[*it] & ( 1u << ( 2 * d + 1 ) ) ) && ( gd + 1 < gridSize[d] ) )
+            {
+            active[*it + stride] = 1;
+            }
+          stride *= gridSize[d];
+          }
+        }
+      }
+
+    anyActive = std::find( active.begin(), active.end(), 1 ) != active.end();
+    }
+}
+
+template< typename TInput, typename TOutput >
+unsigned int
+FastMarchingImageFilterBase< TInput, TOutput >::
+IterateBlock( OutputImageType* oImage,
+              const OutputRegionType& iBlock,
+              const OutputPixelType& iLimit )
+{
+  const NodeType       blockStart = iBlock.GetIndex();
+  const OutputSizeType blockSize = iBlock.GetSize();
+  const SizeValueType  numberOfNodes = iBlock.GetNumberOfPixels();
+
+  SizeValueType blockStride[ImageDimension];
+  blockStride[0] = 1;
+  for( unsigned int d = 1; d < ImageDimension; d++ )
+    {
+    blockStride[d] = blockStride[d - 1] * blockSize[d - 1];
+    }
+
+  // Active list of the block: the nodes are updated in turn, and the
+  // neighbors of a node which has changed are added to the list
+  std::vector< SizeValueType > active( numberOfNodes );
+  std::vector< unsigned char > isActive( numberOfNodes, 1 );
+  for( SizeValueType p = 0; p < numberOfNodes; p++ )
+    {
+    active[p] = p;
+    }
+
+  const unsigned char* labels = m_LabelImage->GetBufferPointer();
+  const typename OutputImageType::OffsetValueType* offsetTable = oImage->GetOffsetTable();
+
+  InternalNodeStructureArray nodesUsed;
+
+  unsigned int faces = 0;
+  for( SizeValueType first = 0; !active.empty(); )
+    {
+    const SizeValueType p = active[first];
+    if( ++first == active.size() )
+      {
+      active.clear();
+      first = 0;
+      }
+    else if( first == numberOfNodes )
+      {
+      active.erase( active.begin(), active.begin() + first );
+      first = 0;
+      }
+    isActive[p] = 0;
+
+    NodeType        node;
+    OffsetValueType offset = 0;
+    SizeValueType   q = p;
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      node[d] = blockStart[d] + static_cast< IndexValueType >( q % blockSize[d] );
+      q /= blockSize[d];
+      offset += ( node[d] - m_StartIndex[d] ) * offsetTable[d];
+      }
+
+    const unsigned char label = labels[offset];
+    if( ( label != Traits::Far ) && ( label != Traits::Trial ) )
+      {
+      continue;
+      }
+
+    OutputPixelType value;
+    if( !this->SolveIteratedNode( oImage, node, iLimit, false, value, nodesUsed ) )
+      {
+      continue;
+      }
+
+    bool nodeChanged = false;
+    OutputPixelType & previous = oImage->GetBufferPointer()[offset];
+    if( value < previous )
+      {
+      previous = value;
+      m_LabelImage->GetBufferPointer()[offset] = Traits::Trial;
+      nodeChanged = true;
+      }
+    else
+      {
+      value = previous;
+      }
+    if( this->UpdateIteratedNodeData( node, value, nodesUsed ) )
+      {
+      nodeChanged = true;
+      }
+
+    if( nodeChanged )
+      {
+      for( unsigned int d = 0; d < ImageDimension; d++ )
+        {
+        const IndexValueType coordinate = node[d] - blockStart[d];
+        if( coordinate == 0 )
+          {
+          faces |= 1u << ( 2 * d );
+          }
+        else if( !isActive[p - blockStride[d]] )
+          {
+          isActive[p - blockStride[d]] = 1;
+          active.push_back( p - blockStride[d] );
+          }
+        if( coordinate == static_cast< IndexValueType >( blockSize[d] ) - 1 )
+          {
+          faces |= 1u << ( 2 * d + 1 );
+          }
+        else if( !isActive[p + blockStride[d]] )
+          {
+          isActive[p + blockStride[d]] = 1;
+          active.push_back( p + blockStride[d] );
+          }
+        }
+      }
+    }
+  return faces;
+}
+
+template< typename TInput, typename TOutput >
+bool
+FastMarchingImageFilterBase< TInput, TOutput >::
+SolveIteratedNode( OutputImageType* oImage,
+                   const NodeType& iNode,
+                   const OutputPixelType& iLimit,
+                   bool iAliveOnly,
+                   OutputPixelType& oValue,
+                   InternalNodeStructureArray& oNodesUsed ) const
+{
+  const unsigned char*   labels = m_LabelImage->GetBufferPointer();
+  const OutputPixelType* values = oImage->GetBufferPointer();
+  const typename OutputImageType::OffsetValueType* offsetTable = oImage->GetOffsetTable();
+
+  OffsetValueType offset = 0;
+  for( unsigned int j = 0; j < ImageDimension; j++ )
+    {
+    offset += ( iNode[j] - m_StartIndex[j] ) * offsetTable[j];
+    }
+
+  // As with the heap, a node is reached when a neighbor which is not an
+  // initial alive point has a value
+  bool reached = false;
+
+  for( unsigned int j = 0; j < ImageDimension; j++ )
+    {
+    InternalNodeStructure temp_node;
+    temp_node.m_Node = iNode;
+    temp_node.m_Value = this->m_LargeValue;
+    temp_node.m_Axis = j;
+
+    for( int s = -1; s < 2; s += 2 )
+      {
+      const IndexValueType coordinate = iNode[j] + s;
+      if( ( coordinate < m_StartIndex[j] ) || ( coordinate > m_LastIndex[j] ) )
+        {
+        continue;
+        }
+
+      const OffsetValueType neighbor = offset + s * offsetTable[j];
+      const unsigned char   label = labels[neighbor];
+      const OutputPixelType value = values[neighbor];
+      bool usable;
+      if( iAliveOnly )
+        {
+        usable = ( label == Traits::Alive );
+        reached = reached || usable;
+        }
+      else
+        {
+        usable = ( ( label == Traits::Alive ) || ( label == Traits::Trial ) ||
+                   ( label == Traits::InitialTrial ) ) && ( value < iLimit );
+        reached = reached || ( usable && ( label != Traits::Alive ) );
+        }
+
+      if( usable && ( value < temp_node.m_Value ) )
+        {
+        temp_node.m_Value = value;
+        temp_node.m_Node[j] = coordinate;
+        }
+      }
+
+    oNodesUsed[j] = temp_node;
+    }
+
+  if( !reached )
+    {
+    return false;
+    }
+
+  oValue = static_cast< OutputPixelType >( this->Solve( oImage, iNode, oNodesUsed ) );
+  return oValue < this->m_LargeValue;
+}
+
 template< typename TInput, typename TOutput >
 bool
 FastMarchingImageFilterBase< TInput, TOutput >::
@@ -1099,6 +1653,8 @@ PrintSelf( std::ostream & os, Indent indent ) const
 
   os << indent << "OverrideOutputInformation: " << m_OverrideOutputInformation
     << std::endl;
+  os << indent << "UseFastIterativeMethod: " << m_UseFastIterativeMethod
+    << std::endl;
 
   itkPrintSelfObjectMacro( LabelImage );
 
@@ -105,6 +105,11 @@ protected:
 
   virtual void ComputeGradient(OutputImageType* oImage,
                                const NodeType& iNode );
+
+  /** Compute the gradient of the nodes accepted by the Fast Iterative
+   * Method */
+  void UpdateAcceptedNodeData( OutputImageType* oImage,
+                               const NodeType& iNode ) override;
 };
 
 /* this class was made in the case where isotropic and anisotropic fast
@@ -104,6 +104,19 @@ UpdateNeighbors(
   this->ComputeGradient( oImage, iNode );
 }
 
+template< typename TInput, typename TOutput >
+void
+FastMarchingUpwindGradientImageFilterBase< TInput, TOutput >::
+UpdateAcceptedNodeData(
+  OutputImageType* oImage,
+  const NodeType& iNode )
+{
+  // All the nodes are labeled, but the gradient only uses the alive
+  // neighbors with a lower value, which had already been accepted before
+  // this node by the heap
+  this->ComputeGradient( oImage, iNode );
+}
+
 /**
  *
  */
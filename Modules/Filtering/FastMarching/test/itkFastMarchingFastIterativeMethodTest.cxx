@@ -0,0 +1,259 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkFastMarchingExtensionImageFilterBase.h"
+#include "itkFastMarchingUpwindGradientImageFilterBase.h"
+#include "itkFastMarchingThresholdStoppingCriterion.h"
+#include "itkFastMarchingReachedTargetNodesStoppingCriterion.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+// Compare the outputs and labels of two marchers, and the values of two
+// other images of the same size
+template< typename TMarcher, typename TImage >
+bool CompareMarchers( TMarcher * heap, TMarcher * iterative,
+                      const TImage * heapImage, const TImage * iterativeImage,
+                      const char * name )
+{
+  using OutputImageType = typename TMarcher::OutputImageType;
+  using LabelImageType = typename TMarcher::LabelImageType;
+
+  itk::ImageRegionConstIterator< OutputImageType > hIt( heap->GetOutput(), heap->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< OutputImageType > iIt( iterative->GetOutput(), iterative->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< LabelImageType >  hlIt( heap->GetLabelImage(), heap->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< LabelImageType >  ilIt( iterative->GetLabelImage(), heap->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< TImage >          hxIt( heapImage, heap->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< TImage >          ixIt( iterativeImage, heap->GetOutput()->GetBufferedRegion() );
+
+  unsigned int labelDifferences = 0;
+  double       maximumDifference = 0.0;
+  double       maximumImageDifference = 0.0;
+  for( ; !hIt.IsAtEnd(); ++hIt, ++iIt, ++hlIt, ++ilIt, ++hxIt, ++ixIt )
+    {
+    if( hlIt.Get() != ilIt.Get() )
+      {
+      ++labelDifferences;
+      continue;
+      }
+    maximumDifference = std::max( maximumDifference,
+      std::abs( static_cast< double >( hIt.Get() ) - static_cast< double >( iIt.Get() ) ) );
+    if( hlIt.Get() != 0 )
+      {
+      typename TImage::PixelType difference = hxIt.Get() - ixIt.Get();
+      maximumImageDifference = std::max( maximumImageDifference,
+        static_cast< double >( difference.GetNorm() ) );
+      }
+    }
+
+  std::cout << name << ": " << labelDifferences << " label differences, maximum difference "
+            << maximumDifference << ", maximum gradient or auxiliary difference "
+            << maximumImageDifference << ", target reached value "
+            << heap->GetTargetReachedValue() << " " << iterative->GetTargetReachedValue() << std::endl;
+
+  return ( labelDifferences == 0 ) && ( maximumDifference < 1e-3 ) && ( maximumImageDifference < 1e-3 )
+    && ( std::abs( heap->GetTargetReachedValue() - iterative->GetTargetReachedValue() ) < 1e-3 );
+}
+}
+
+template< unsigned int VDimension >
+int FastMarchingFastIterativeMethod( const typename itk::Image< float, VDimension >::SizeType & size )
+{
+  using ImageType = itk::Image< float, VDimension >;
+  using IndexType = typename ImageType::IndexType;
+
+  // smooth speed with a varying magnitude
+  typename ImageType::Pointer speed = ImageType::New();
+  speed->SetRegions( size );
+  speed->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > sIt( speed, speed->GetBufferedRegion() );
+  for( ; !sIt.IsAtEnd(); ++sIt )
+    {
+    double value = 1.0;
+    for( unsigned int d = 0; d < VDimension; d++ )
+      {
+      value *= std::cos( sIt.GetIndex()[d] / ( 5.0 + d ) );
+      }
+    sIt.Set( static_cast< float >( 1.0 + 0.5 * value ) );
+    }
+
+  using MarcherType = itk::FastMarchingUpwindGradientImageFilterBase< ImageType, ImageType >;
+  using NodePairType = typename MarcherType::NodePairType;
+  using NodePairContainerType = typename MarcherType::NodePairContainerType;
+
+  typename NodePairContainerType::Pointer trialPoints = NodePairContainerType::New();
+  typename NodePairContainerType::Pointer alivePoints = NodePairContainerType::New();
+  IndexType seed;
+  for( unsigned int d = 0; d < VDimension; d++ )
+    {
+    seed[d] = size[d] / 3;
+    }
+  alivePoints->push_back( NodePairType( seed, 0.0 ) );
+  for( unsigned int d = 0; d < VDimension; d++ )
+    {
+    for( int s = -1; s < 2; s += 2 )
+      {
+      IndexType trial = seed;
+      trial[d] += s;
+      trialPoints->push_back( NodePairType( trial, 1.0 ) );
+      }
+    }
+  IndexType other;
+  for( unsigned int d = 0; d < VDimension; d++ )
+    {
+    other[d] = 3 * size[d] / 4;
+    }
+  trialPoints->push_back( NodePairType( other, 2.5 ) );
+
+  IndexType target;
+  for( unsigned int d = 0; d < VDimension; d++ )
+    {
+    target[d] = size[d] - 2;
+    }
+  std::vector< IndexType > targets;
+  targets.push_back( target );
+
+  typename MarcherType::Pointer marcher = MarcherType::New();
+  TEST_SET_GET_BOOLEAN( marcher, UseFastIterativeMethod, true );
+
+  bool passed = true;
+  for( unsigned int test = 0; test < 3; test++ )
+    {
+    typename MarcherType::Pointer heap = MarcherType::New();
+    typename MarcherType::Pointer iterative = MarcherType::New();
+    iterative->UseFastIterativeMethodOn();
+    iterative->SetNumberOfThreads( 4 );
+
+    for( MarcherType * m : { heap.GetPointer(), iterative.GetPointer() } )
+      {
+      m->SetInput( speed );
+      m->SetTrialPoints( trialPoints );
+      m->SetAlivePoints( alivePoints );
+      m->SetCollectPoints( test == 1 );
+      if( test < 2 )
+        {
+        using CriterionType = itk::FastMarchingThresholdStoppingCriterion< ImageType, ImageType >;
+        typename CriterionType::Pointer criterion = CriterionType::New();
+        criterion->SetThreshold( 0.6 * size[0] );
+        m->SetStoppingCriterion( criterion );
+        }
+      else
+        {
+        using CriterionType = itk::FastMarchingReachedTargetNodesStoppingCriterion< ImageType, ImageType >;
+        typename CriterionType::Pointer criterion = CriterionType::New();
+        criterion->SetTargetCondition( CriterionType::OneTarget );
+        criterion->SetTargetNodes( targets );
+        criterion->SetTargetOffset( 2.0 );
+        m->SetStoppingCriterion( criterion );
+        }
+      TRY_EXPECT_NO_EXCEPTION( m->Update() );
+      }
+
+    const char * names[] = { "threshold", "threshold with collected points", "reached target" };
+    if( !CompareMarchers( heap.GetPointer(), iterative.GetPointer(),
+                          heap->GetGradientImage(), iterative->GetGradientImage(), names[test] ) )
+      {
+      std::cerr << "The Fast Iterative Method differs from the heap" << std::endl;
+      passed = false;
+      }
+    if( test == 1 )
+      {
+      TEST_EXPECT_EQUAL( heap->GetProcessedPoints()->Size(), iterative->GetProcessedPoints()->Size() );
+      }
+    }
+
+  // extension of an auxiliary value
+  using ExtensionType = itk::FastMarchingExtensionImageFilterBase< ImageType, ImageType, float, 1 >;
+  using AuxImageType = itk::Image< itk::Vector< float, 1 >, VDimension >;
+  using AuxValueContainerType = typename ExtensionType::AuxValueContainerType;
+  typename AuxValueContainerType::Pointer auxAliveValues = AuxValueContainerType::New();
+  typename AuxValueContainerType::Pointer auxTrialValues = AuxValueContainerType::New();
+  typename ExtensionType::AuxValueVectorType auxValue;
+  auxValue[0] = 10.0;
+  auxAliveValues->push_back( auxValue );
+  for( unsigned int i = 0; i < trialPoints->Size(); i++ )
+    {
+    auxValue[0] = 10.0 * ( i + 1 );
+    auxTrialValues->push_back( auxValue );
+    }
+
+  typename ExtensionType::Pointer heap = ExtensionType::New();
+  typename ExtensionType::Pointer iterative = ExtensionType::New();
+  iterative->UseFastIterativeMethodOn();
+  iterative->SetNumberOfThreads( 3 );
+  typename AuxImageType::Pointer auxImages[2];
+  unsigned int i = 0;
+  for( ExtensionType * m : { heap.GetPointer(), iterative.GetPointer() } )
+    {
+    using CriterionType = itk::FastMarchingThresholdStoppingCriterion< ImageType, ImageType >;
+    typename CriterionType::Pointer criterion = CriterionType::New();
+    criterion->SetThreshold( 0.4 * size[0] );
+    m->SetStoppingCriterion( criterion );
+    m->SetInput( speed );
+    m->SetTrialPoints( trialPoints );
+    m->SetAlivePoints( alivePoints );
+    m->SetAuxiliaryAliveValues( auxAliveValues );
+    m->SetAuxiliaryTrialValues( auxTrialValues );
+    TRY_EXPECT_NO_EXCEPTION( m->Update() );
+
+    // only the alive and trial nodes have an auxiliary value
+    auxImages[i] = AuxImageType::New();
+    auxImages[i]->SetRegions( size );
+    auxImages[i]->Allocate();
+    itk::ImageRegionIterator< AuxImageType > aIt( auxImages[i], auxImages[i]->GetBufferedRegion() );
+    itk::ImageRegionConstIterator< typename ExtensionType::AuxImageType >
+      xIt( m->GetAuxiliaryImage( 0 ), auxImages[i]->GetBufferedRegion() );
+    itk::ImageRegionConstIterator< typename ExtensionType::LabelImageType >
+      lIt( m->GetLabelImage(), auxImages[i]->GetBufferedRegion() );
+    for( ; !aIt.IsAtEnd(); ++aIt, ++xIt, ++lIt )
+      {
+      const bool hasValue = ( lIt.Get() == ExtensionType::Traits::Trial ) ||
+        ( lIt.Get() == ExtensionType::Traits::InitialTrial ) ||
+        ( ( lIt.Get() == ExtensionType::Traits::Alive ) && ( aIt.GetIndex() != seed ) );
+      auxValue[0] = hasValue ? xIt.Get() : 0.0f;
+      aIt.Set( auxValue );
+      }
+    ++i;
+    }
+  if( !CompareMarchers( heap.GetPointer(), iterative.GetPointer(),
+                        auxImages[0].GetPointer(), auxImages[1].GetPointer(), "extension" ) )
+    {
+    std::cerr << "The Fast Iterative Method differs from the heap" << std::endl;
+    passed = false;
+    }
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int itkFastMarchingFastIterativeMethodTest( int, char * [] )
+{
+  itk::Size< 2 > size2D = {{ 83, 71 }};
+  if( FastMarchingFastIterativeMethod< 2 >( size2D ) == EXIT_FAILURE )
+    {
+    std::cerr << "2D Fails" << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::Size< 3 > size3D = {{ 29, 25, 23 }};
+  if( FastMarchingFastIterativeMethod< 3 >( size3D ) == EXIT_FAILURE )
+    {
+    std::cerr << "3D Fails" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
@@ -23,7 +23,6 @@
 #include "itkSimpleDataObjectDecorator.h"
 #include "itksys/hash_map.hxx"
 #include "itkHistogram.h"
-#include "itkFastMutexLock.h"
 #include <vector>
 
 namespace itk
@@ -49,6 +48,19 @@ namespace itk
  * threaded. It computes statistics in each thread then combines them in
  * its AfterThreadedGenerate method.
  *
+ * Each thread accumulates the pixels by runs of the same label along the
+ * first dimension. The accumulators of the labels in [0, 65535] are found
+ * in a dense table, which avoids hashing for the usual unsigned char and
+ * unsigned short label images, and the histograms are stored in one flat
+ * array per thread. The labels are then combined in parallel, each label by
+ * a single thread, without locking. When the bounding boxes are not needed,
+ * ComputeBoundingBoxOff() skips their computation.
+ *
+ * When NumberOfStreamDivisions is larger than 1, the inputs are requested
+ * and processed by pieces, and the statistics are accumulated across the
+ * pieces, so that the whole inputs never need to be in memory. The output
+ * then only holds the last piece of the intensity input.
+ *
  * \ingroup MathematicalStatisticsImageFilters
  * \ingroup ITKImageStatistics
  *
@@ -244,6 +256,18 @@ public:
   itkGetConstMacro(UseHistograms, bool);
   itkBooleanMacro(UseHistograms);
 
+  /** Set/Get whether the bounding boxes, and the regions, of the labels are
+   * computed. When off, GetBoundingBox() and GetRegion() are undefined.
+   * Defaults to true. */
+  itkSetMacro(ComputeBoundingBox, bool);
+  itkGetConstMacro(ComputeBoundingBox, bool);
+  itkBooleanMacro(ComputeBoundingBox);
+
+  /** Set/Get the number of pieces in which the inputs are requested and
+   * processed. Defaults to 1, the whole inputs at once. */
+  itkSetClampMacro(NumberOfStreamDivisions, unsigned int, 1, NumericTraits< unsigned int >::max());
+  itkGetConstMacro(NumberOfStreamDivisions, unsigned int);
+
 
   virtual const ValidLabelValuesContainerType &GetValidLabelValues() const
   {
@@ -337,6 +361,14 @@ protected:
     AllocateOutputs method. */
   void AllocateOutputs() override;
 
+  /** Process the inputs by pieces when NumberOfStreamDivisions is larger
+   * than 1. */
+  void GenerateData() override;
+
+  /** Request the first piece of the inputs when NumberOfStreamDivisions is
+   * larger than 1. */
+  void GenerateInputRequestedRegion() override;
+
   /** Initialize some accumulators before the threads run. */
   void BeforeThreadedGenerateData() override;
 
@@ -357,17 +389,54 @@ protected:
   void EnlargeOutputRequestedRegion(DataObject *data) override;
 
 private:
-  std::vector< MapType >        m_LabelStatisticsPerThread;
-  MapType                       m_LabelStatistics;
-  ValidLabelValuesContainerType m_ValidLabelValues;
+  using AbsoluteFrequencyType = typename HistogramType::AbsoluteFrequencyType;
+
+  /** Statistics of a label accumulated by a thread */
+  struct LabelAccumulator
+  {
+    IdentifierType m_Count;
+    RealType       m_Sum;
+    RealType       m_SumOfSquares;
+    RealType       m_Minimum;
+    RealType       m_Maximum;
+    IndexValueType m_BoundingBox[2 * ImageDimension];
+  };
+
+  /** Accumulators of a thread. The labels in [0, DenseLabelRange) are found
+   * in a dense table of accumulator indices plus one, the other labels in a
+   * hash map. The histogram of the accumulator i is in the NumBins
+   * frequencies starting at i * NumBins. */
+  struct ThreadAccumulator
+  {
+    std::vector< LabelAccumulator >                   m_Accumulators;
+    std::vector< SizeValueType >                      m_DenseIndices;
+    itksys::hash_map< LabelPixelType, SizeValueType > m_SparseIndices;
+    std::vector< AbsoluteFrequencyType >              m_Frequencies;
+  };
+
+  static constexpr SizeValueType DenseLabelRange = 65536;
+
+  /** Index of the accumulator of a label in a thread, created if needed. */
+  SizeValueType GetAccumulatorIndex(ThreadAccumulator & accumulator, const LabelPixelType & label);
+
+  /** Index plus one of the accumulator of a label in a thread, or 0 if the
+   * thread has not seen the label. */
+  SizeValueType FindAccumulatorIndex(const ThreadAccumulator & accumulator, const LabelPixelType & label) const;
+
+  std::vector< ThreadAccumulator > m_ThreadAccumulators;
+  MapType                          m_LabelStatistics;
+  ValidLabelValuesContainerType    m_ValidLabelValues;
 
   bool m_UseHistograms;
+  bool m_ComputeBoundingBox;
+
+  unsigned int m_NumberOfStreamDivisions;
 
   typename HistogramType::SizeType m_NumBins;
 
-  RealType            m_LowerBound;
-  RealType            m_UpperBound;
-  SimpleFastMutexLock m_Mutex;
+  RealType         m_LowerBound;
+  RealType         m_UpperBound;
+  HistogramPointer m_HistogramPrototype;
 }; // end of class
 } // end namespace itk
 
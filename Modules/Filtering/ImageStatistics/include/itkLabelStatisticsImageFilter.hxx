@@ -19,8 +19,8 @@
 #define itkLabelStatisticsImageFilter_hxx
 #include "itkLabelStatisticsImageFilter.h"
 
-#include "itkImageLinearConstIteratorWithIndex.h"
 #include "itkImageScanlineConstIterator.h"
+#include "itkImageRegionSplitterSlowDimension.h"
 #include "itkProgressReporter.h"
 
 namespace itk
@@ -31,6 +31,8 @@ LabelStatisticsImageFilter< TInputImage, TLabelImage >
 {
   this->SetNumberOfRequiredInputs(2);
   m_UseHistograms = false;
+  m_ComputeBoundingBox = true;
+  m_NumberOfStreamDivisions = 1;
   m_NumBins.SetSize(1);
   m_NumBins[0] = 20;
   m_LowerBound = static_cast< RealType >( NumericTraits< PixelType >::NonpositiveMin() );
@@ -73,6 +75,72 @@ LabelStatisticsImageFilter< TInputImage, TLabelImage >
   m_UseHistograms = true;
 }
 
+template< typename TInputImage, typename TLabelImage >
+void
+LabelStatisticsImageFilter< TInputImage, TLabelImage >
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  if ( m_NumberOfStreamDivisions > 1 )
+    {
+    // the other pieces are requested in GenerateData()
+    InputImagePointer input = const_cast< TInputImage * >( this->GetInput() );
+    auto * labelInput = const_cast< LabelImageType * >( this->GetLabelInput() );
+    if ( input && labelInput )
+      {
+      RegionType region = input->GetLargestPossibleRegion();
+      ImageRegionSplitterSlowDimension::Pointer splitter = ImageRegionSplitterSlowDimension::New();
+      const unsigned int numberOfPieces = splitter->GetNumberOfSplits( region, m_NumberOfStreamDivisions );
+      splitter->GetSplit( 0, numberOfPieces, region );
+      input->SetRequestedRegion( region );
+      labelInput->SetRequestedRegion( region );
+      }
+    }
+}
+
+template< typename TInputImage, typename TLabelImage >
+void
+LabelStatisticsImageFilter< TInputImage, TLabelImage >
+::GenerateData()
+{
+  if ( m_NumberOfStreamDivisions < 2 )
+    {
+    Superclass::GenerateData();
+    return;
+    }
+
+  InputImagePointer input = const_cast< TInputImage * >( this->GetInput() );
+  auto * labelInput = const_cast< LabelImageType * >( this->GetLabelInput() );
+
+  const RegionType largestRegion = input->GetLargestPossibleRegion();
+  ImageRegionSplitterSlowDimension::Pointer splitter = ImageRegionSplitterSlowDimension::New();
+  const unsigned int numberOfPieces = splitter->GetNumberOfSplits( largestRegion, m_NumberOfStreamDivisions );
+
+  this->BeforeThreadedGenerateData();
+
+  // the statistics are accumulated in the same thread accumulators for all
+  // the pieces
+  for ( unsigned int piece = 0; piece < numberOfPieces && !this->GetAbortGenerateData(); ++piece )
+    {
+    RegionType streamRegion = largestRegion;
+    splitter->GetSplit( piece, numberOfPieces, streamRegion );
+
+    input->SetRequestedRegion( streamRegion );
+    input->PropagateRequestedRegion();
+    input->UpdateOutputData();
+    labelInput->SetRequestedRegion( streamRegion );
+    labelInput->PropagateRequestedRegion();
+    labelInput->UpdateOutputData();
+
+    this->AllocateOutputs();
+    this->GetOutput()->SetRequestedRegion( streamRegion );
+    this->ClassicMultiThread( this->ThreaderCallback );
+    }
+
+  this->AfterThreadedGenerateData();
+}
+
 template< typename TInputImage, typename TLabelImage >
 void
 LabelStatisticsImageFilter< TInputImage, TLabelImage >
@@ -80,136 +148,231 @@ LabelStatisticsImageFilter< TInputImage, TLabelImage >
 {
   ThreadIdType numberOfThreads = this->GetNumberOfThreads();
 
-  // Resize the thread temporaries
-  m_LabelStatisticsPerThread.resize(numberOfThreads);
+  // Initialize the thread temporaries
+  m_ThreadAccumulators.clear();
+  m_ThreadAccumulators.resize(numberOfThreads);
 
-  // Initialize the temporaries
-  for ( ThreadIdType i = 0; i < numberOfThreads; ++i )
+  // All the histograms have the same bins
+  m_HistogramPrototype = nullptr;
+  if ( m_UseHistograms )
     {
-    m_LabelStatisticsPerThread[i].clear();
+    m_HistogramPrototype = LabelStatistics(m_NumBins[0], m_LowerBound, m_UpperBound).m_Histogram;
     }
 
   // Initialize the final map
   m_LabelStatistics.clear();
 }
 
+template< typename TInputImage, typename TLabelImage >
+SizeValueType
+LabelStatisticsImageFilter< TInputImage, TLabelImage >
+::GetAccumulatorIndex(ThreadAccumulator & accumulator, const LabelPixelType & label)
+{
+  SizeValueType * index = nullptr;
+  if ( std::numeric_limits< LabelPixelType >::is_integer && NumericTraits< LabelPixelType >::IsNonnegative(label)
+       && static_cast< SizeValueType >( label ) < DenseLabelRange )
+    {
+    const auto denseLabel = static_cast< SizeValueType >( label );
+    if ( denseLabel >= accumulator.m_DenseIndices.size() )
+      {
+      accumulator.m_DenseIndices.resize(denseLabel + 1, 0);
+      }
+    index = &accumulator.m_DenseIndices[denseLabel];
+    }
+  else
+    {
+    // inserted as absent if not found
+    index = &accumulator.m_SparseIndices[label];
+    }
+
+  if ( *index == 0 )
+    {
+    // create a new accumulator
+    LabelAccumulator labelStats;
+    labelStats.m_Count = NumericTraits< IdentifierType >::ZeroValue();
+    labelStats.m_Sum = NumericTraits< RealType >::ZeroValue();
+    labelStats.m_SumOfSquares = NumericTraits< RealType >::ZeroValue();
+    labelStats.m_Minimum = NumericTraits< RealType >::max();
+    labelStats.m_Maximum = NumericTraits< RealType >::NonpositiveMin();
+    for ( unsigned int i = 0; i < ImageDimension * 2; i += 2 )
+      {
+      labelStats.m_BoundingBox[i] = NumericTraits< IndexValueType >::max();
+      labelStats.m_BoundingBox[i + 1] = NumericTraits< IndexValueType >::NonpositiveMin();
+      }
+    accumulator.m_Accumulators.push_back(labelStats);
+    if ( m_UseHistograms )
+      {
+      accumulator.m_Frequencies.resize(accumulator.m_Frequencies.size() + m_NumBins[0], 0);
+      }
+    *index = accumulator.m_Accumulators.size();
+    }
+  return *index - 1;
+}
+
+template< typename TInputImage, typename TLabelImage >
+SizeValueType
+LabelStatisticsImageFilter< TInputImage, TLabelImage >
+::FindAccumulatorIndex(const ThreadAccumulator & accumulator, const LabelPixelType & label) const
+{
+  if ( std::numeric_limits< LabelPixelType >::is_integer && NumericTraits< LabelPixelType >::IsNonnegative(label)
+       && static_cast< SizeValueType >( label ) < DenseLabelRange )
+    {
+    const auto denseLabel = static_cast< SizeValueType >( label );
+    return denseLabel < accumulator.m_DenseIndices.size() ? accumulator.m_DenseIndices[denseLabel] : 0;
+    }
+  auto it = accumulator.m_SparseIndices.find(label);
+  return it != accumulator.m_SparseIndices.end() ? it->second : 0;
+}
+
 template< typename TInputImage, typename TLabelImage >
 void
 LabelStatisticsImageFilter< TInputImage, TLabelImage >
 ::AfterThreadedGenerateData()
 {
-  MapIterator      mapIt;
-  MapConstIterator threadIt;
-  ThreadIdType     i;
-  ThreadIdType     numberOfThreads = this->GetNumberOfThreads();
-
-  // Run through the map for each thread and accumulate the count,
-  // sum, and sumofsquares
-  for ( i = 0; i < numberOfThreads; i++ )
-    {
-    // iterate over the map for this thread
-    for ( threadIt = m_LabelStatisticsPerThread[i].begin();
-          threadIt != m_LabelStatisticsPerThread[i].end();
-          ++threadIt )
+  const auto numberOfThreads = static_cast< ThreadIdType >( m_ThreadAccumulators.size() );
+
+  // Create the entries of all the labels
+  using MapValueType = typename MapType::value_type;
+  for ( ThreadIdType i = 0; i < numberOfThreads; i++ )
+    {
+    const ThreadAccumulator & accumulator = m_ThreadAccumulators[i];
+    for ( SizeValueType label = 0; label < accumulator.m_DenseIndices.size(); ++label )
       {
-      // does this label exist in the cumulative structure yet?
-      mapIt = m_LabelStatistics.find( ( *threadIt ).first );
-      if ( mapIt == m_LabelStatistics.end() )
+      if ( accumulator.m_DenseIndices[label] != 0
+           && m_LabelStatistics.find( static_cast< LabelPixelType >( label ) ) == m_LabelStatistics.end() )
         {
-        // create a new entry
-        using MapValueType = typename MapType::value_type;
         if ( m_UseHistograms )
           {
-          mapIt = m_LabelStatistics.insert( MapValueType( ( *threadIt ).first,
-                                                          LabelStatistics(m_NumBins[0], m_LowerBound,
-                                                                          m_UpperBound) ) ).first;
+          m_LabelStatistics.insert( MapValueType( static_cast< LabelPixelType >( label ),
+                                                  LabelStatistics(m_NumBins[0], m_LowerBound, m_UpperBound) ) );
           }
         else
           {
-          mapIt = m_LabelStatistics.insert( MapValueType( ( *threadIt ).first,
-                                                          LabelStatistics() ) ).first;
+          m_LabelStatistics.insert( MapValueType( static_cast< LabelPixelType >( label ), LabelStatistics() ) );
           }
         }
-
-
-      typename MapType::mapped_type &labelStats = ( *mapIt ).second;
-
-      // accumulate the information from this thread
-      labelStats.m_Count += ( *threadIt ).second.m_Count;
-      labelStats.m_Sum += ( *threadIt ).second.m_Sum;
-      labelStats.m_SumOfSquares += ( *threadIt ).second.m_SumOfSquares;
-
-      if ( labelStats.m_Minimum > ( *threadIt ).second.m_Minimum )
-        {
-        labelStats.m_Minimum = ( *threadIt ).second.m_Minimum;
-        }
-      if ( labelStats.m_Maximum < ( *threadIt ).second.m_Maximum )
-        {
-        labelStats.m_Maximum = ( *threadIt ).second.m_Maximum;
-        }
-
-      //bounding box is min,max pairs
-      for ( unsigned int ii = 0; ii < ( ImageDimension * 2 ); ii += 2 )
+      }
+    for ( const auto & sparse : accumulator.m_SparseIndices )
+      {
+      if ( m_LabelStatistics.find(sparse.first) == m_LabelStatistics.end() )
         {
-        if ( labelStats.m_BoundingBox[ii] > ( *threadIt ).second.m_BoundingBox[ii] )
+        if ( m_UseHistograms )
           {
-          labelStats.m_BoundingBox[ii] = ( *threadIt ).second.m_BoundingBox[ii];
+          m_LabelStatistics.insert( MapValueType( sparse.first,
+                                                  LabelStatistics(m_NumBins[0], m_LowerBound, m_UpperBound) ) );
           }
-        if ( labelStats.m_BoundingBox[ii + 1] < ( *threadIt ).second.m_BoundingBox[ii + 1] )
+        else
           {
-          labelStats.m_BoundingBox[ii + 1] = ( *threadIt ).second.m_BoundingBox[ii + 1];
+          m_LabelStatistics.insert( MapValueType( sparse.first, LabelStatistics() ) );
           }
         }
+      }
+    }
 
-      // if enabled, update the histogram for this label
-      if ( m_UseHistograms )
+  std::vector< MapValueType * > entries;
+  entries.reserve( m_LabelStatistics.size() );
+  for ( MapIterator mapIt = m_LabelStatistics.begin(); mapIt != m_LabelStatistics.end(); ++mapIt )
+    {
+    entries.push_back( &( *mapIt ) );
+    }
+
+  // Accumulate the count, sum, and sumofsquares of each label from all the
+  // threads, and compute the remainder of the statistics. Each label is
+  // processed by a single thread.
+  ImageRegion< 1 > entryRegion;
+  entryRegion.SetIndex( 0, 0 );
+  entryRegion.SetSize( 0, entries.size() );
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+  multiThreader->template ParallelizeImageRegion< 1 >(
+    entryRegion,
+    [&]( const ImageRegion< 1 > & subRegion )
+      {
+      for ( SizeValueType e = subRegion.GetIndex(0); e < subRegion.GetIndex(0) + subRegion.GetSize(0); ++e )
         {
-        typename HistogramType::IndexType index;
-        index.SetSize(1);
-        for ( unsigned int bin = 0; bin < m_NumBins[0]; bin++ )
+        const LabelPixelType & label = entries[e]->first;
+        LabelStatistics &      labelStats = entries[e]->second;
+
+        for ( ThreadIdType i = 0; i < numberOfThreads; i++ )
           {
-          index[0] = bin;
-          labelStats.m_Histogram->IncreaseFrequency( bin, ( *threadIt ).second.m_Histogram->GetFrequency(bin) );
+          const ThreadAccumulator & accumulator = m_ThreadAccumulators[i];
+          const SizeValueType       index = this->FindAccumulatorIndex(accumulator, label);
+          if ( index == 0 )
+            {
+            continue;
+            }
+          const LabelAccumulator & threadStats = accumulator.m_Accumulators[index - 1];
+
+          // accumulate the information from this thread
+          labelStats.m_Count += threadStats.m_Count;
+          labelStats.m_Sum += threadStats.m_Sum;
+          labelStats.m_SumOfSquares += threadStats.m_SumOfSquares;
+
+          if ( labelStats.m_Minimum > threadStats.m_Minimum )
+            {
+            labelStats.m_Minimum = threadStats.m_Minimum;
+            }
+          if ( labelStats.m_Maximum < threadStats.m_Maximum )
+            {
+            labelStats.m_Maximum = threadStats.m_Maximum;
+            }
+
+          //bounding box is min,max pairs
+          for ( unsigned int ii = 0; ii < ( ImageDimension * 2 ); ii += 2 )
+            {
+            if ( labelStats.m_BoundingBox[ii] > threadStats.m_BoundingBox[ii] )
+              {
+              labelStats.m_BoundingBox[ii] = threadStats.m_BoundingBox[ii];
+              }
+            if ( labelStats.m_BoundingBox[ii + 1] < threadStats.m_BoundingBox[ii + 1] )
+              {
+              labelStats.m_BoundingBox[ii + 1] = threadStats.m_BoundingBox[ii + 1];
+              }
+            }
+
+          // if enabled, update the histogram for this label
+          if ( m_UseHistograms )
+            {
+            const AbsoluteFrequencyType * frequencies = &accumulator.m_Frequencies[( index - 1 ) * m_NumBins[0]];
+            for ( unsigned int bin = 0; bin < m_NumBins[0]; bin++ )
+              {
+              labelStats.m_Histogram->IncreaseFrequency( bin, frequencies[bin] );
+              }
+            }
           }
-        }
-      } // end of thread map iterator loop
-    }   // end of thread loop
 
-  // compute the remainder of the statistics
-  for ( mapIt = m_LabelStatistics.begin();
-        mapIt != m_LabelStatistics.end();
-        ++mapIt )
-    {
-    typename MapType::mapped_type &labelStats = ( *mapIt ).second;
+        // mean
+        labelStats.m_Mean = labelStats.m_Sum / static_cast< RealType >( labelStats.m_Count );
 
-    // mean
-    labelStats.m_Mean = labelStats.m_Sum
-                               / static_cast< RealType >( labelStats.m_Count );
+        // variance
+        if ( labelStats.m_Count > 1 )
+          {
+          // unbiased estimate of variance
+          const RealType sumSquared  = labelStats.m_Sum * labelStats.m_Sum;
+          const auto     count = static_cast< RealType >( labelStats.m_Count );
 
-    // variance
-    if ( labelStats.m_Count > 1 )
-      {
-      // unbiased estimate of variance
-      LabelStatistics & ls = mapIt->second;
-      const RealType    sumSquared  = ls.m_Sum * ls.m_Sum;
-      const auto count = static_cast< RealType >( ls.m_Count );
+          labelStats.m_Variance = ( labelStats.m_SumOfSquares - sumSquared / count ) / ( count - 1.0 );
+          }
+        else
+          {
+          labelStats.m_Variance = NumericTraits< RealType >::ZeroValue();
+          }
 
-      ls.m_Variance = ( ls.m_SumOfSquares - sumSquared / count ) / ( count - 1.0 );
-      }
-    else
-      {
-      labelStats.m_Variance = NumericTraits< RealType >::ZeroValue();
-      }
+        // sigma
+        labelStats.m_Sigma = std::sqrt( labelStats.m_Variance );
+        }
+      },
+    nullptr );
 
-    // sigma
-    labelStats.m_Sigma = std::sqrt( labelStats.m_Variance );
-    }
+  // Release the thread temporaries
+  m_ThreadAccumulators.clear();
+  m_HistogramPrototype = nullptr;
 
     {
     //Now update the cached vector of valid labels.
     m_ValidLabelValues.resize(0);
     m_ValidLabelValues.reserve(m_LabelStatistics.size());
-    for ( mapIt = m_LabelStatistics.begin();
+    for ( MapIterator mapIt = m_LabelStatistics.begin();
       mapIt != m_LabelStatistics.end();
       ++mapIt )
       {
@@ -224,7 +387,6 @@ LabelStatisticsImageFilter< TInputImage, TLabelImage >
 ::ThreadedGenerateData(const RegionType & outputRegionForThread,
                        ThreadIdType threadId)
 {
-
   typename HistogramType::IndexType histogramIndex(1);
   typename HistogramType::MeasurementVectorType histogramMeasurement(1);
 
@@ -234,13 +396,31 @@ LabelStatisticsImageFilter< TInputImage, TLabelImage >
     return;
     }
 
-  ImageLinearConstIteratorWithIndex< TInputImage > it (this->GetInput(),
-                                                       outputRegionForThread);
+  ImageScanlineConstIterator< TInputImage > it (this->GetInput(),
+                                                outputRegionForThread);
 
   ImageScanlineConstIterator< TLabelImage > labelIt (this->GetLabelInput(),
                                                      outputRegionForThread);
 
-  MapIterator mapIt;
+  ThreadAccumulator & accumulator = m_ThreadAccumulators[threadId];
+  const SizeValueType numberOfBins = m_UseHistograms ? m_NumBins[0] : 0;
+
+  // the bounding box is updated once per run of pixels of the same label
+  auto updateBoundingBox = [this]( LabelAccumulator & labelStats, const IndexType & lineIndex,
+                                   IndexValueType start, IndexValueType last )
+    {
+    if ( !m_ComputeBoundingBox )
+      {
+      return;
+      }
+    labelStats.m_BoundingBox[0] = std::min( labelStats.m_BoundingBox[0], start );
+    labelStats.m_BoundingBox[1] = std::max( labelStats.m_BoundingBox[1], last );
+    for ( unsigned int i = 2; i < ( 2 * ImageDimension ); i += 2 )
+      {
+      labelStats.m_BoundingBox[i] = std::min( labelStats.m_BoundingBox[i], lineIndex[i / 2] );
+      labelStats.m_BoundingBox[i + 1] = std::max( labelStats.m_BoundingBox[i + 1], lineIndex[i / 2] );
+      }
+    };
 
   // support progress methods/callbacks
   const size_t numberOfLinesToProcess = outputRegionForThread.GetNumberOfPixels() / size0;
@@ -249,78 +429,61 @@ LabelStatisticsImageFilter< TInputImage, TLabelImage >
   // do the work
   while ( !it.IsAtEnd() )
     {
+    const IndexType lineIndex = it.GetIndex();
+    IndexValueType  x = lineIndex[0];
+    IndexValueType  runStart = x;
+    LabelPixelType  runLabel = labelIt.Get();
+    SizeValueType   current = this->GetAccumulatorIndex(accumulator, runLabel);
+    LabelAccumulator * labelStats = &accumulator.m_Accumulators[current];
+
     while ( !it.IsAtEndOfLine() )
       {
-      const RealType & value = static_cast< RealType >( it.Get() );
-
       const LabelPixelType & label = labelIt.Get();
-
-      // is the label already in this thread?
-      mapIt = m_LabelStatisticsPerThread[threadId].find(label);
-      if ( mapIt == m_LabelStatisticsPerThread[threadId].end() )
+      if ( label != runLabel )
         {
-        // create a new statistics object
-        using MapValueType = typename MapType::value_type;
-        if ( m_UseHistograms )
-          {
-          mapIt = m_LabelStatisticsPerThread[threadId].insert( MapValueType( label,
-                                                                             LabelStatistics(m_NumBins[0], m_LowerBound,
-                                                                                             m_UpperBound) ) ).first;
-          }
-        else
-          {
-          mapIt = m_LabelStatisticsPerThread[threadId].insert( MapValueType( label,
-                                                                             LabelStatistics() ) ).first;
-          }
+        updateBoundingBox( *labelStats, lineIndex, runStart, x - 1 );
+        runLabel = label;
+        runStart = x;
+        current = this->GetAccumulatorIndex(accumulator, label);
+        labelStats = &accumulator.m_Accumulators[current];
         }
 
-      typename MapType::mapped_type &labelStats = ( *mapIt ).second;
+      const auto value = static_cast< RealType >( it.Get() );
 
       // update the values for this label and this thread
-      if ( value < labelStats.m_Minimum )
+      if ( value < labelStats->m_Minimum )
         {
-        labelStats.m_Minimum = value;
+        labelStats->m_Minimum = value;
         }
-      if ( value > labelStats.m_Maximum )
+      if ( value > labelStats->m_Maximum )
         {
-        labelStats.m_Maximum = value;
+        labelStats->m_Maximum = value;
         }
 
-      // bounding box is min,max pairs
-      for ( unsigned int i = 0; i < ( 2 * TInputImage::ImageDimension ); i += 2 )
-        {
-        const IndexType & index = it.GetIndex();
-        if ( labelStats.m_BoundingBox[i] > index[i / 2] )
-          {
-          labelStats.m_BoundingBox[i] = index[i / 2];
-          }
-        if ( labelStats.m_BoundingBox[i + 1] < index[i / 2] )
-          {
-          labelStats.m_BoundingBox[i + 1] = index[i / 2];
-          }
-        }
-
-      labelStats.m_Sum += value;
-      labelStats.m_SumOfSquares += ( value * value );
-      labelStats.m_Count++;
+      labelStats->m_Sum += value;
+      labelStats->m_SumOfSquares += ( value * value );
+      labelStats->m_Count++;
 
       // if enabled, update the histogram for this label
-      if ( m_UseHistograms )
+      if ( numberOfBins > 0 )
         {
         histogramMeasurement[0] = value;
-        labelStats.m_Histogram->GetIndex(histogramMeasurement, histogramIndex);
-        labelStats.m_Histogram->IncreaseFrequencyOfIndex(histogramIndex, 1);
+        if ( m_HistogramPrototype->GetIndex(histogramMeasurement, histogramIndex) )
+          {
+          ++accumulator.m_Frequencies[current * numberOfBins + histogramIndex[0]];
+          }
         }
 
-
       ++labelIt;
       ++it;
+      ++x;
       }
+    updateBoundingBox( *labelStats, lineIndex, runStart, x - 1 );
+
     labelIt.NextLine();
     it.NextLine();
     progress.CompletedPixel();
     }
-
 }
 
 template< typename TInputImage, typename TLabelImage >
@@ -581,6 +744,10 @@ LabelStatisticsImageFilter< TImage, TLabelImage >
      << std::endl;
   os << indent << "Use Histograms: " << m_UseHistograms
      << std::endl;
+  os << indent << "Compute Bounding Box: " << m_ComputeBoundingBox
+     << std::endl;
+  os << indent << "Number Of Stream Divisions: " << m_NumberOfStreamDivisions
+     << std::endl;
   os << indent << "Histogram Lower Bound: " << m_LowerBound
      << std::endl;
   os << indent << "Histogram Upper Bound: " << m_UpperBound
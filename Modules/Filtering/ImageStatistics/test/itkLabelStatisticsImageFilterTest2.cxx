@@ -0,0 +1,165 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkLabelStatisticsImageFilter.h"
+#include "itkCastImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+#include <map>
+
+// Compare the filter with statistics computed pixel by pixel, for labels
+// in the dense table and out of it, with threads and streaming.
+int itkLabelStatisticsImageFilterTest2(int, char* [] )
+{
+  using ImageType = itk::Image< unsigned char, 3 >;
+  using LabelImageType = itk::Image< int, 3 >;
+  using FilterType = itk::LabelStatisticsImageFilter< ImageType, LabelImageType >;
+  using RealType = FilterType::RealType;
+
+  ImageType::SizeType size = {{ 37, 29, 23 }};
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  LabelImageType::Pointer labelImage = LabelImageType::New();
+  labelImage->SetRegions( size );
+  labelImage->Allocate();
+
+  // runs of labels, some of them negative or larger than 65535
+  using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 42 );
+  const int labels[] = { 0, 1, 2, 255, 256, 3000, 65535, 65536, 100000, -1, -70000 };
+  int label = 0;
+
+  struct Reference
+  {
+    itk::SizeValueType m_Count = 0;
+    double m_Sum = 0.0;
+    double m_SumOfSquares = 0.0;
+    double m_Minimum = 1e9;
+    double m_Maximum = -1e9;
+    itk::IndexValueType m_BoundingBox[6] = { 1000, -1000, 1000, -1000, 1000, -1000 };
+  };
+  std::map< int, Reference > references;
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetBufferedRegion() );
+  itk::ImageRegionIteratorWithIndex< LabelImageType > lIt( labelImage, labelImage->GetBufferedRegion() );
+  for( ; !it.IsAtEnd(); ++it, ++lIt )
+    {
+    if( generator->GetVariate() < 0.2 )
+      {
+      label = labels[generator->GetIntegerVariate( 10 )];
+      }
+    const auto value = static_cast< unsigned char >( generator->GetIntegerVariate( 255 ) );
+    it.Set( value );
+    lIt.Set( label );
+
+    Reference & reference = references[label];
+    ++reference.m_Count;
+    reference.m_Sum += value;
+    reference.m_SumOfSquares += value * value;
+    reference.m_Minimum = std::min( reference.m_Minimum, static_cast< double >( value ) );
+    reference.m_Maximum = std::max( reference.m_Maximum, static_cast< double >( value ) );
+    for( unsigned int d = 0; d < 3; d++ )
+      {
+      reference.m_BoundingBox[2 * d] = std::min( reference.m_BoundingBox[2 * d], it.GetIndex()[d] );
+      reference.m_BoundingBox[2 * d + 1] = std::max( reference.m_BoundingBox[2 * d + 1], it.GetIndex()[d] );
+      }
+    }
+
+  // cast filters, to check that the inputs are streamed
+  using CastType = itk::CastImageFilter< ImageType, ImageType >;
+  using LabelCastType = itk::CastImageFilter< LabelImageType, LabelImageType >;
+  CastType::Pointer cast = CastType::New();
+  cast->SetInput( image );
+  cast->InPlaceOff();
+  LabelCastType::Pointer labelCast = LabelCastType::New();
+  labelCast->SetInput( labelImage );
+  labelCast->InPlaceOff();
+
+  FilterType::Pointer filter = FilterType::New();
+  TEST_SET_GET_BOOLEAN( filter, ComputeBoundingBox, true );
+  filter->SetNumberOfStreamDivisions( 0 );
+  TEST_SET_GET_VALUE( 1u, filter->GetNumberOfStreamDivisions() );
+  filter->SetInput( cast->GetOutput() );
+  filter->SetLabelInput( labelCast->GetOutput() );
+  filter->SetHistogramParameters( 16, 0.0, 256.0 );
+
+  bool passed = true;
+  for( unsigned int test = 0; test < 4; test++ )
+    {
+    const unsigned int divisions = ( test < 2 ) ? 5 : 1;
+    filter->SetNumberOfStreamDivisions( divisions );
+    filter->SetNumberOfThreads( ( test % 2 ) ? 3 : 1 );
+    filter->SetComputeBoundingBox( test != 1 );
+    TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+
+    std::cout << "Stream divisions " << divisions << ", threads " << filter->GetNumberOfThreads()
+              << ", labels " << filter->GetNumberOfLabels() << std::endl;
+    TEST_EXPECT_EQUAL( filter->GetNumberOfLabels(), references.size() );
+    if( divisions > 1 )
+      {
+      // only the last piece remains
+      TEST_EXPECT_TRUE( cast->GetOutput()->GetBufferedRegion().GetNumberOfPixels()
+                        < image->GetBufferedRegion().GetNumberOfPixels() );
+      }
+
+    for( const auto & entry : references )
+      {
+      const Reference & reference = entry.second;
+      const double mean = reference.m_Sum / reference.m_Count;
+      const double variance = reference.m_Count > 1 ?
+        ( reference.m_SumOfSquares - reference.m_Sum * reference.m_Sum / reference.m_Count ) / ( reference.m_Count - 1 ) : 0.0;
+      bool same = filter->HasLabel( entry.first )
+        && ( filter->GetCount( entry.first ) == reference.m_Count )
+        && itk::Math::FloatAlmostEqual( filter->GetSum( entry.first ), reference.m_Sum )
+        && itk::Math::FloatAlmostEqual( filter->GetMean( entry.first ), mean, 4, 1e-9 )
+        && itk::Math::FloatAlmostEqual( filter->GetVariance( entry.first ), variance, 4, 1e-6 )
+        && itk::Math::ExactlyEquals( filter->GetMinimum( entry.first ), reference.m_Minimum )
+        && itk::Math::ExactlyEquals( filter->GetMaximum( entry.first ), reference.m_Maximum );
+      if( filter->GetComputeBoundingBox() )
+        {
+        const FilterType::BoundingBoxType box = filter->GetBoundingBox( entry.first );
+        for( unsigned int i = 0; i < 6; i++ )
+          {
+          same = same && ( box[i] == reference.m_BoundingBox[i] );
+          }
+        }
+      double frequencies = 0.0;
+      for( unsigned int bin = 0; bin < 16; bin++ )
+        {
+        frequencies += filter->GetHistogram( entry.first )->GetFrequency( bin );
+        }
+      same = same && ( frequencies == reference.m_Count );
+      if( !same )
+        {
+        std::cerr << "Wrong statistics for label " << entry.first << ": count "
+                  << filter->GetCount( entry.first ) << " " << reference.m_Count
+                  << ", mean " << filter->GetMean( entry.first ) << " " << mean
+                  << ", histogram " << frequencies << std::endl;
+        passed = false;
+        }
+      }
+    const RealType median = filter->GetMedian( 3000 );
+    std::cout << "Median of label 3000: " << median << std::endl;
+    }
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -59,8 +59,10 @@ GrayscaleDilateImageFilter< TInputImage, TOutputImage, TKernel >
 
   if ( flatKernel != nullptr && flatKernel->GetDecomposable() )
     {
-    m_AnchorFilter->SetKernel(*flatKernel);
-    m_Algorithm = ANCHOR;
+    // the van Herk/Gil-Werman filter processes several lines at once, and
+    // its cost does not depend on the image content
+    m_VHGWFilter->SetKernel(*flatKernel);
+    m_Algorithm = VHGW;
     }
   else if ( m_HistogramFilter->GetUseVectorBasedAlgorithm() )
     {
@@ -43,6 +43,13 @@ namespace itk
  * values (zero or one). Only elements of the structuring element
  * having values > 0 are candidates for affecting the center pixel.
  *
+ * Decomposable flat kernels use the anchor algorithm by default. Unlike
+ * GrayscaleErodeImageFilter and GrayscaleDilateImageFilter, which use
+ * the van Herk/Gil-Werman algorithm, the closing keeps the anchor
+ * algorithm: with polygons, the anchor closing differs from the chain of the
+ * erosion and the dilation, and the default output is kept unchanged.
+ * Use SetAlgorithm( VHGW ) to select the van Herk/Gil-Werman algorithm.
+ *
  * \sa MorphologyImageFilter, GrayscaleFunctionErodeImageFilter, BinaryErodeImageFilter
  * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
  * \ingroup ITKMathematicalMorphology
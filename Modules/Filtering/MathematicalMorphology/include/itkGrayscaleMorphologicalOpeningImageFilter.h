@@ -42,6 +42,13 @@ namespace itk
  * values (zero or one). Only elements of the structuring element
  * having values > 0 are candidates for affecting the center pixel.
  *
+ * Decomposable flat kernels use the anchor algorithm by default. Unlike
+ * GrayscaleErodeImageFilter and GrayscaleDilateImageFilter, which use
+ * the van Herk/Gil-Werman algorithm, the opening keeps the anchor
+ * algorithm: with polygons, the anchor opening differs from the chain of the
+ * erosion and the dilation, and the default output is kept unchanged.
+ * Use SetAlgorithm( VHGW ) to select the van Herk/Gil-Werman algorithm.
+ *
  * \sa MorphologyImageFilter, GrayscaleFunctionDilateImageFilter, BinaryDilateImageFilter
  * \ingroup ImageEnhancement  MathematicalMorphologyImageFilters
  * \ingroup ITKMathematicalMorphology
@@ -22,6 +22,7 @@
 #include <vector>
 #include "itkIntTypes.h"
 #include "itkNumericTraits.h"
+#include "itkSortedArrayHistogram.h"
 
 namespace itk
 {
@@ -213,6 +214,33 @@ class MorphologyHistogram<bool, TCompare>:
 {
 };
 
+// pixel types with a large range use a sorted array instead of the
+// std::map, which allocates on every new value
+
+template< typename TCompare >
+class MorphologyHistogram<float, TCompare>:
+  public SortedArrayMorphologyHistogram<float, TCompare>
+{
+};
+
+template< typename TCompare >
+class MorphologyHistogram<double, TCompare>:
+  public SortedArrayMorphologyHistogram<double, TCompare>
+{
+};
+
+template< typename TCompare >
+class MorphologyHistogram<int, TCompare>:
+  public SortedArrayMorphologyHistogram<int, TCompare>
+{
+};
+
+template< typename TCompare >
+class MorphologyHistogram<unsigned int, TCompare>:
+  public SortedArrayMorphologyHistogram<unsigned int, TCompare>
+{
+};
+
 /// \endcond
 
 } // end namespace Function
@@ -21,6 +21,7 @@
 
 #include "itkIntTypes.h"
 #include "itkNumericTraits.h"
+#include "itkSortedArrayHistogram.h"
 
 #include <map>
 #include <vector>
@@ -395,6 +396,33 @@ class RankHistogram<bool>:
 {
 };
 
+// pixel types with a large range use a sorted array instead of the
+// std::map, which allocates on every new value
+
+template<>
+class RankHistogram<float>:
+  public SortedArrayRankHistogram<float>
+{
+};
+
+template<>
+class RankHistogram<double>:
+  public SortedArrayRankHistogram<double>
+{
+};
+
+template<>
+class RankHistogram<int>:
+  public SortedArrayRankHistogram<int>
+{
+};
+
+template<>
+class RankHistogram<unsigned int>:
+  public SortedArrayRankHistogram<unsigned int>
+{
+};
+
 /// \endcond
 
 } // end namespace Function
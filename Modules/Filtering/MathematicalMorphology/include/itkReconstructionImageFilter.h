@@ -23,6 +23,7 @@
 #include "itkImageRegionIterator.h"
 #include "itkProgressReporter.h"
 #include <queue>
+#include <vector>
 
 //#define BASIC
 #define COPY
@@ -43,6 +44,14 @@ namespace itk
  * applications and efficient algorithms" -- IEEE Transactions on
  * Image processing, Vol 2, No 2, pp 176-201, April 1993
  *
+ * The image is divided in slabs along its last dimension, one for each
+ * thread, and the raster, antiraster and FIFO steps are run in parallel
+ * on the slabs, without reading or writing the pixels of the other slabs.
+ * The values are then propagated across the boundaries of the slabs, and
+ * the pixels which change seed new FIFO steps in their slab, until no
+ * value changes. The reconstruction is unique, so the output does not
+ * depend on the number of threads.
+ *
  * \author Richard Beare. Department of Medicine, Monash University,
  * Melbourne, Australia.
  *
@@ -127,9 +136,10 @@ public:
   itkBooleanMacro(FullyConnected);
 
   /**
-   * Perform a padding of the image internally to increase the performance
-   * of the filter. UseInternalCopy can be set to false to reduce the memory
-   * usage.
+   * Deprecated, and ignored. The reconstruction used to pad an internal
+   * copy of the image, which this option disabled to reduce the memory
+   * usage. It now works in place on the output, without a copy, whatever
+   * the value of UseInternalCopy. It is kept for backward compatibility.
    */
   itkSetMacro(UseInternalCopy, bool);
   itkGetConstReferenceMacro(UseInternalCopy, bool);
@@ -159,18 +169,43 @@ private:
   bool m_FullyConnected;
   bool m_UseInternalCopy;
 
-  using FaceCalculatorType = typename itk::NeighborhoodAlgorithm::ImageBoundaryFacesCalculator< OutputImageType >;
-
-  using FaceListType = typename FaceCalculatorType::FaceListType;
-  using FaceListTypeIt = typename FaceCalculatorType::FaceListType::iterator;
-
   using InputIteratorType = ImageRegionConstIterator< InputImageType >;
   using OutputIteratorType = ImageRegionIterator< OutputImageType >;
-
-  using OutIndexType = typename OutputImageType::IndexType;
-  using InIndexType = typename InputImageType::IndexType;
-  using CNInputIterator = ConstShapedNeighborhoodIterator< InputImageType >;
-  using NOutputIterator = ShapedNeighborhoodIterator< OutputImageType >;
+  using OffsetType = typename OutputImageType::OffsetType;
+  using SizeType = typename OutputImageType::SizeType;
+
+  /** A slab of the image, along its last dimension, and the FIFO of the
+   * pixels from which the values are propagated in it. */
+  struct SlabType
+  {
+    IndexValueType                 m_Begin;
+    IndexValueType                 m_End;
+    std::queue< OffsetValueType >  m_Fifo;
+  };
+
+  /** Whether a neighbor of a pixel is in the image and in a slab. The
+   * index is relative to the start of the buffer. */
+  bool IsInside(const OutputImageIndexType & index, const OffsetType & offset, const SlabType & slab) const;
+
+  /** The raster or antiraster step on a slab. The antiraster step fills
+   * the FIFO. */
+  void ScanSlab(SlabType & slab, bool forward) const;
+
+  /** The FIFO step on a slab. */
+  void PropagateSlab(SlabType & slab) const;
+
+  /** Propagate the values across the boundary of two consecutive slabs,
+   * and add the pixels which change to the FIFO of their slab. Returns
+   * whether a value changed. */
+  bool PropagateBoundary(SlabType & previous, SlabType & next) const;
+
+  // the neighbors of a pixel, the layout of the buffers, and the buffers
+  std::vector< OffsetType >      m_Neighbors;
+  std::vector< OffsetValueType > m_NeighborOffsets;
+  SizeType                       m_Size;
+  OffsetValueType                m_SliceSize;
+  OutputImagePixelType *         m_OutputBuffer;
+  const MaskImagePixelType *     m_MaskBuffer;
 }; // end of class
 } // end namespace itk
 
@@ -23,8 +23,8 @@
 #include "itkConstantBoundaryCondition.h"
 #include "itkConnectedComponentAlgorithm.h"
 
-#include "itkConstantPadImageFilter.h"
-#include "itkCropImageFilter.h"
+#include <atomic>
+#include <functional>
 
 namespace itk
 {
@@ -99,7 +99,6 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >::GetMaskImage()
   return this->GetInput(1);
 }
 
-// a version that takes a padded copy of mask and marker
 template< typename TInputImage, typename TOutputImage, typename TCompare >
 void
 ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
@@ -107,11 +106,6 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
 {
   // Allocate the output
   this->AllocateOutputs();
-  // there are 2 passes that use all pixels and a 3rd that uses some
-  // subset of the pixels. We'll just pretend that the third pass
-  // takes the same as each of the others. Is it OK to update more
-  // often than pixels?
-  ProgressReporter progress(this, 0, this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() * 3);
 
   TCompare compare;
 
@@ -125,267 +119,358 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
     itkExceptionMacro(<< "Marker and mask must have the same size.");
     }
 
-  // create padded versions of the marker image and the mask image
-  using PadType = typename itk::ConstantPadImageFilter< InputImageType, InputImageType >;
-
-  MarkerImageConstPointer markerImageP;
-  MaskImageConstPointer   maskImageP;
-
-  ISizeType padSize;
-
-  if ( m_UseInternalCopy )
+  const OutputImageRegionType region = output->GetRequestedRegion();
+  if ( region.GetNumberOfPixels() == 0 )
     {
-    typename PadType::Pointer MaskPad = PadType::New();
-    typename PadType::Pointer MarkerPad = PadType::New();
-    padSize.Fill(1);
-
-    MaskPad->SetConstant(m_MarkerValue);
-    MarkerPad->SetConstant(m_MarkerValue);
-    MaskPad->SetPadLowerBound(padSize);
-    MaskPad->SetPadUpperBound(padSize);
-    MarkerPad->SetPadLowerBound(padSize);
-    MarkerPad->SetPadUpperBound(padSize);
-
-    MaskPad->SetInput(maskImage);
-    MarkerPad->SetInput(markerImage);
-    MaskPad->Update();
-    MarkerPad->Update();
-
-    markerImageP = MarkerPad->GetOutput();
-    maskImageP = MaskPad->GetOutput();
+    return;
     }
-  else
+  // the progress is reported after the copy, and after each pass of the
+  // hybrid algorithm on the slabs
+  ProgressReporter progress(this, 0, 4, 4);
+
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  // copy the marker to the output, and check that it follows the
+  // preconditions
+  std::atomic< bool > isValid( true );
+  multiThreader->template ParallelizeImageRegion< OutputImageDimension >(
+    region,
+    [&](const OutputImageRegionType & regionForThread)
+      {
+      InputIteratorType  markerIt( markerImage, regionForThread );
+      InputIteratorType  maskIt( maskImage, regionForThread );
+      OutputIteratorType outIt( output, regionForThread );
+      bool               valid = true;
+      for ( ; !outIt.IsAtEnd(); ++markerIt, ++maskIt, ++outIt )
+        {
+        const auto V = static_cast< OutputImagePixelType >( markerIt.Get() );
+        valid = valid && !compare( V, static_cast< OutputImagePixelType >( maskIt.Get() ) );
+        outIt.Set( V );
+        }
+      if ( !valid )
+        {
+        isValid = false;
+        }
+      },
+    nullptr);
+  if ( !isValid )
     {
-    maskImageP = this->GetMaskImage();
-    InputIteratorType inIt( markerImage,
-                            output->GetRequestedRegion() );
-    OutputIteratorType outIt( output,
-                              output->GetRequestedRegion() );
-    // copy marker to output - isn't there a better way?
-    while ( !outIt.IsAtEnd() )
+    if ( compare(0, 1) )
       {
-      MarkerImagePixelType currentValue = inIt.Get();
-      outIt.Set( static_cast< OutputImagePixelType >( currentValue ) );
-      ++inIt;
-      ++outIt;
+      itkExceptionMacro(<< "Marker pixels must be <= mask pixels.");
+      }
+    else
+      {
+      itkExceptionMacro(<< "Marker pixels must be >= mask pixels.");
       }
-    markerImageP = output;
-    }
-
-  // declare our queue type
-  using FifoType = typename std::queue< OutputImageIndexType >;
-  FifoType IndexFifo;
-
-  NOutputIterator   outNIt;
-  InputIteratorType mskIt;
-  CNInputIterator   mskNIt;
-  ISizeType         kernelRadius;
-  kernelRadius.Fill(1);
-  if ( m_UseInternalCopy )
-    {
-    FaceCalculatorType faceCalculator;
-
-    FaceListType   faceList;
-    FaceListTypeIt fit;
-
-    faceList = faceCalculator(maskImageP, maskImageP->GetLargestPossibleRegion(),
-                              kernelRadius);
-    // we will only be processing the body region
-    fit = faceList.begin();
-    // must be a better way of doing this
-    NOutputIterator tt(kernelRadius,
-                       markerImageP,
-                       *fit);
-    outNIt = tt;
-
-    InputIteratorType ttt(maskImageP,
-                          *fit);
-    mskIt = ttt;
-    CNInputIterator tttt(kernelRadius,
-                         maskImageP,
-                         *fit);
-    mskNIt = tttt;
-    }
-  else
-    {
-    NOutputIterator tt( kernelRadius,
-                        markerImageP,
-                        output->GetRequestedRegion() );
-    outNIt = tt;
-
-    InputIteratorType ttt( maskImageP,
-                           output->GetRequestedRegion() );
-    mskIt = ttt;
-    CNInputIterator tttt( kernelRadius,
-                          maskImageP,
-                          output->GetRequestedRegion() );
-    mskNIt = tttt;
     }
-
-  setConnectivityPrevious(&outNIt, m_FullyConnected);
-
-  ConstantBoundaryCondition< OutputImageType > oBC;
-  oBC.SetConstant(m_MarkerValue);
-  outNIt.OverrideBoundaryCondition(&oBC);
-
-  mskIt.GoToBegin();
-  // scan in forward raster order
-  for ( outNIt.GoToBegin(), mskIt.GoToBegin(); !outNIt.IsAtEnd(); ++outNIt, ++mskIt )
+  progress.CompletedPixel();
+
+  // the neighbors, and the layout of the buffers
+  m_Neighbors.clear();
+  m_NeighborOffsets.clear();
+  OffsetType offset;
+  offset.Fill( -1 );
+  bool done = false;
+  while ( !done )
     {
-    InputImagePixelType V = outNIt.GetCenterPixel();
-    auto iV = static_cast< OutputImagePixelType >( mskIt.Get() );
-
-    // be sure that the pixels in the images follow the preconditions
-    if ( compare(V, iV) )
+    unsigned int nonZero = 0;
+    for ( unsigned int d = 0; d < OutputImageDimension; ++d )
+      {
+      nonZero += ( offset[d] != 0 );
+      }
+    if ( nonZero == 1 || ( nonZero > 1 && m_FullyConnected ) )
+      {
+      m_Neighbors.push_back( offset );
+      }
+    done = true;
+    for ( unsigned int d = 0; d < OutputImageDimension && done; ++d )
       {
-      if ( compare(0, 1) )
+      if ( offset[d] < 1 )
         {
-        itkExceptionMacro(<< "Marker pixels must be <= mask pixels.");
+        ++offset[d];
+        done = false;
         }
       else
         {
-        itkExceptionMacro(<< "Marker pixels must be >= mask pixels.");
+        offset[d] = -1;
         }
       }
-
-    // visit the previous neighbours
-    typename NOutputIterator::ConstIterator sIt;
-    for ( sIt = outNIt.Begin(); !sIt.IsAtEnd(); ++sIt )
+    }
+  const typename OutputImageType::OffsetValueType * offsetTable = output->GetOffsetTable();
+  for ( const OffsetType & neighbor : m_Neighbors )
+    {
+    OffsetValueType neighborOffset = 0;
+    for ( unsigned int d = 0; d < OutputImageDimension; ++d )
       {
-      InputImagePixelType VN = sIt.Get();
-      if ( compare(VN, V) )
-        {
-        outNIt.SetCenterPixel(VN);
-        V = VN;
-        }
+      neighborOffset += neighbor[d] * offsetTable[d];
       }
+    m_NeighborOffsets.push_back( neighborOffset );
+    }
+  m_Size = region.GetSize();
+  m_SliceSize = offsetTable[OutputImageDimension - 1];
+  m_OutputBuffer = output->GetBufferPointer();
+  m_MaskBuffer = maskImage->GetBufferPointer()
+    + maskImage->ComputeOffset( maskImage->GetRequestedRegion().GetIndex() );
+
+  // the slabs
+  const SizeValueType numberOfSlices = m_Size[OutputImageDimension - 1];
+  const SizeValueType numberOfSlabs = ( OutputImageDimension == 1 ) ? 1 :
+    std::min( static_cast< SizeValueType >( this->GetNumberOfThreads() ), numberOfSlices );
+  std::vector< SlabType > slabs( numberOfSlabs );
+  for ( SizeValueType i = 0; i < numberOfSlabs; ++i )
+    {
+    slabs[i].m_Begin = static_cast< IndexValueType >( i * numberOfSlices / numberOfSlabs );
+    slabs[i].m_End = static_cast< IndexValueType >( ( i + 1 ) * numberOfSlices / numberOfSlabs );
+    }
 
-    // this step clamps to the mask
-    if ( compare(V, iV) )
+  // the hybrid algorithm on each slab, one pass at a time, then the
+  // propagation across the slabs and the FIFO steps it requires, until
+  // nothing changes
+  ImageRegion< 1 > slabRegion;
+  slabRegion.SetIndex( 0, 0 );
+  slabRegion.SetSize( 0, numberOfSlabs );
+  const auto forEachSlab = [&](const std::function< void( SlabType & ) > & pass)
+    {
+    multiThreader->template ParallelizeImageRegion< 1 >(
+      slabRegion,
+      [&](const ImageRegion< 1 > & slabsForThread)
+        {
+        const SizeValueType begin = slabsForThread.GetIndex( 0 );
+        for ( SizeValueType i = begin; i < begin + slabsForThread.GetSize( 0 ); ++i )
+          {
+          pass( slabs[i] );
+          }
+        },
+      nullptr);
+    };
+  forEachSlab( [this](SlabType & slab) { this->ScanSlab( slab, true ); } );
+  progress.CompletedPixel();
+  forEachSlab( [this](SlabType & slab) { this->ScanSlab( slab, false ); } );
+  progress.CompletedPixel();
+  bool first = true;
+  bool changed = true;
+  while ( changed )
+    {
+    forEachSlab( [this](SlabType & slab) { this->PropagateSlab( slab ); } );
+    if ( first )
       {
-      outNIt.SetCenterPixel(iV);
+      progress.CompletedPixel();
+      first = false;
       }
 
-    progress.CompletedPixel();
+    changed = false;
+    for ( SizeValueType i = 1; i < numberOfSlabs; ++i )
+      {
+      changed = this->PropagateBoundary( slabs[i - 1], slabs[i] ) || changed;
+      }
     }
+}
 
-  // now for the reverse raster order pass
-  // reset the neighborhood
-  setConnectivityLater(&outNIt, m_FullyConnected);
-  outNIt.OverrideBoundaryCondition(&oBC);
-  outNIt.GoToEnd();
-  //mskIt.GoToEnd();
-
-  ConstantBoundaryCondition< InputImageType > iBC;
-  iBC.SetConstant(m_MarkerValue);
-
-  setConnectivityLater(&mskNIt, m_FullyConnected);
-  mskNIt.OverrideBoundaryCondition(&iBC);
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+bool
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::IsInside(const OutputImageIndexType & index, const OffsetType & offset, const SlabType & slab) const
+{
+  for ( unsigned int d = 0; d + 1 < OutputImageDimension; ++d )
+    {
+    const IndexValueType i = index[d] + offset[d];
+    if ( i < 0 || i >= static_cast< IndexValueType >( m_Size[d] ) )
+      {
+      return false;
+      }
+    }
+  const IndexValueType i = index[OutputImageDimension - 1] + offset[OutputImageDimension - 1];
+  return i >= slab.m_Begin && i < slab.m_End;
+}
 
-  typename NOutputIterator::IndexListType oIndexList, mIndexList;
-  typename NOutputIterator::IndexListType::const_iterator oLIt, mLIt;
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+void
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::ScanSlab(SlabType & slab, bool forward) const
+{
+  TCompare compare;
 
-  oIndexList = outNIt.GetActiveIndexList();
-  mIndexList = mskNIt.GetActiveIndexList();
+  // the neighbors before the pixel in the scan order
+  std::vector< SizeValueType > previous;
+  for ( SizeValueType k = 0; k < m_Neighbors.size(); ++k )
+    {
+    if ( ( m_NeighborOffsets[k] < 0 ) == forward )
+      {
+      previous.push_back( k );
+      }
+    }
 
-  mskNIt.GoToEnd();
-  while ( !outNIt.IsAtBegin() )
+  const auto            lineSize = static_cast< IndexValueType >( m_Size[0] );
+  const OffsetValueType begin = slab.m_Begin * m_SliceSize;
+  const OffsetValueType end = slab.m_End * m_SliceSize;
+  const OffsetValueType numberOfLines = ( end - begin ) / lineSize;
+  std::vector< bool >   isLineInside( m_Neighbors.size() );
+  for ( OffsetValueType l = 0; l < numberOfLines; ++l )
     {
-    --outNIt;
-    --mskNIt;
-    InputImagePixelType V = outNIt.GetCenterPixel();
-    typename NOutputIterator::ConstIterator sIt;
-    for ( sIt = outNIt.Begin(); !sIt.IsAtEnd(); ++sIt )
+    const OffsetValueType line = forward ? l : numberOfLines - 1 - l;
+    const OffsetValueType lineStart = begin + line * lineSize;
+
+    // whether the lines of the neighbors are in the slab
+    OutputImageIndexType index;
+    index[0] = 0;
+    OffsetValueType remainder = lineStart / lineSize;
+    for ( unsigned int d = 1; d < OutputImageDimension; ++d )
       {
-      InputImagePixelType VN = sIt.Get();
-      if ( compare(VN, V) )
-        {
-        outNIt.SetCenterPixel(VN);
-        V = VN;
-        }
+      index[d] = remainder % static_cast< OffsetValueType >( m_Size[d] );
+      remainder /= static_cast< OffsetValueType >( m_Size[d] );
       }
-    InputImagePixelType iV = mskNIt.GetCenterPixel();
-    if ( compare(V, iV) )
+    for ( SizeValueType k = 0; k < m_Neighbors.size(); ++k )
       {
-      outNIt.SetCenterPixel(iV);
-      V = iV;
+      OffsetType lineOffset = m_Neighbors[k];
+      lineOffset[0] = 0;
+      isLineInside[k] = this->IsInside( index, lineOffset, slab );
       }
 
-    // now put indexes in the fifo
-    //typename CNInputIterator::ConstIterator mIt;
-    for ( oLIt = oIndexList.begin(), mLIt = mIndexList.begin(); oLIt != oIndexList.end(); ++oLIt, ++mLIt )
+    for ( IndexValueType i = 0; i < lineSize; ++i )
       {
-      InputImagePixelType VN = outNIt.GetPixel(*oLIt);
-      InputImagePixelType iN = mskNIt.GetPixel(*mLIt);
-      if ( compare(V, VN) && compare(iN, VN) )
+      const IndexValueType  x = forward ? i : lineSize - 1 - i;
+      const OffsetValueType p = lineStart + x;
+      OutputImagePixelType  V = m_OutputBuffer[p];
+      for ( const SizeValueType k : previous )
         {
-        IndexFifo.push( outNIt.GetIndex() );
-        break;
+        const IndexValueType xn = x + m_Neighbors[k][0];
+        if ( isLineInside[k] && xn >= 0 && xn < lineSize && compare( m_OutputBuffer[p + m_NeighborOffsets[k]], V ) )
+          {
+          V = m_OutputBuffer[p + m_NeighborOffsets[k]];
+          }
+        }
+
+      // this step clamps to the mask
+      const auto iV = static_cast< OutputImagePixelType >( m_MaskBuffer[p] );
+      if ( compare( V, iV ) )
+        {
+        V = iV;
+        }
+      m_OutputBuffer[p] = V;
+
+      // the pixels from which the values may still be propagated
+      if ( !forward )
+        {
+        for ( const SizeValueType k : previous )
+          {
+          const IndexValueType xn = x + m_Neighbors[k][0];
+          if ( !isLineInside[k] || xn < 0 || xn >= lineSize )
+            {
+            continue;
+            }
+          const OutputImagePixelType VN = m_OutputBuffer[p + m_NeighborOffsets[k]];
+          const auto                 iN = static_cast< OutputImagePixelType >( m_MaskBuffer[p + m_NeighborOffsets[k]] );
+          if ( compare( V, VN ) && compare( iN, VN ) )
+            {
+            slab.m_Fifo.push( p );
+            break;
+            }
+          }
         }
       }
-    progress.CompletedPixel();
     }
+}
+
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+void
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::PropagateSlab(SlabType & slab) const
+{
+  TCompare compare;
 
-  // Now we want to check the full neighborhood
-  setConnectivity(&outNIt, m_FullyConnected);
-  setConnectivity(&mskNIt, m_FullyConnected);
-  mskNIt.OverrideBoundaryCondition(&iBC);
-  outNIt.OverrideBoundaryCondition(&oBC);
-  oIndexList = outNIt.GetActiveIndexList();
-  mIndexList = mskNIt.GetActiveIndexList();
-  // now process the fifo - this fill the parts that weren't dealt
-  // with by the raster and anti-raster passes
-  //typename NOutputIterator::Iterator sIt;
-  typename CNInputIterator::ConstIterator mIt;
-
-  while ( !IndexFifo.empty() )
+  while ( !slab.m_Fifo.empty() )
     {
-    InputImageIndexType I = IndexFifo.front();
-    IndexFifo.pop();
-    // reposition the iterators
-    outNIt += I - outNIt.GetIndex();
-    mskNIt += I - mskNIt.GetIndex();
-    InputImagePixelType V = outNIt.GetCenterPixel();
-    for ( oLIt = oIndexList.begin(), mLIt = mIndexList.begin();
-          oLIt != oIndexList.end();
-          ++oLIt, ++mLIt )
+    const OffsetValueType p = slab.m_Fifo.front();
+    slab.m_Fifo.pop();
+
+    OutputImageIndexType index;
+    OffsetValueType      remainder = p;
+    for ( unsigned int d = 0; d < OutputImageDimension; ++d )
       {
-      InputImagePixelType VN = outNIt.GetPixel(*oLIt);
-      InputImagePixelType iN = mskNIt.GetPixel(*mLIt);
+      index[d] = remainder % static_cast< OffsetValueType >( m_Size[d] );
+      remainder /= static_cast< OffsetValueType >( m_Size[d] );
+      }
+
+    const OutputImagePixelType V = m_OutputBuffer[p];
+    for ( SizeValueType k = 0; k < m_Neighbors.size(); ++k )
+      {
+      if ( !this->IsInside( index, m_Neighbors[k], slab ) )
+        {
+        continue;
+        }
+      const OffsetValueType      q = p + m_NeighborOffsets[k];
+      const OutputImagePixelType VN = m_OutputBuffer[q];
+      const auto                 iN = static_cast< OutputImagePixelType >( m_MaskBuffer[q] );
       // candidate for dilation via flooding
       if ( compare(V, VN) && Math::NotAlmostEquals( iN, VN ) )
         {
         if ( compare(iN, V) )
           {
           // not clamped by the mask, propagate the center value
-          outNIt.SetPixel(*oLIt, V);
+          m_OutputBuffer[q] = V;
           }
         else
           {
           // apply the clamping
-          outNIt.SetPixel(*oLIt, iN);
+          m_OutputBuffer[q] = iN;
           }
-        IndexFifo.push( outNIt.GetIndex(*oLIt) );
+        slab.m_Fifo.push( q );
         }
       }
-    progress.CompletedPixel();
     }
+}
 
-  if ( m_UseInternalCopy )
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+bool
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::PropagateBoundary(SlabType & previous, SlabType & next) const
+{
+  TCompare compare;
+  bool     changed = false;
+
+  // propagate the value of a pixel to a neighbor of the other slab
+  auto propagate = [&](OffsetValueType from, OffsetValueType to, SlabType & slab)
+    {
+    const OutputImagePixelType V = m_OutputBuffer[from];
+    const OutputImagePixelType VN = m_OutputBuffer[to];
+    const auto                 iN = static_cast< OutputImagePixelType >( m_MaskBuffer[to] );
+    if ( compare(V, VN) && Math::NotAlmostEquals( iN, VN ) )
+      {
+      m_OutputBuffer[to] = compare(iN, V) ? V : iN;
+      slab.m_Fifo.push( to );
+      changed = true;
+      }
+    };
+
+  // the pixels of the first slice of the next slab, and their neighbors in
+  // the last slice of the previous one
+  SlabType both;
+  both.m_Begin = previous.m_Begin;
+  both.m_End = next.m_End;
+  const OffsetValueType begin = next.m_Begin * m_SliceSize;
+  for ( OffsetValueType p = begin; p < begin + m_SliceSize; ++p )
     {
-    using CropType = typename itk::CropImageFilter< InputImageType, OutputImageType >;
-    typename CropType::Pointer crop = CropType::New();
-
-    crop->SetInput(markerImageP);
-    crop->SetUpperBoundaryCropSize(padSize);
-    crop->SetLowerBoundaryCropSize(padSize);
-    crop->GraftOutput( this->GetOutput() );
-    /** execute the minipipeline */
-    crop->Update();
-
-    /** graft the minipipeline output back into this filter's output */
-    this->GraftOutput( crop->GetOutput() );
+    OutputImageIndexType index;
+    OffsetValueType      remainder = p;
+    for ( unsigned int d = 0; d < OutputImageDimension; ++d )
+      {
+      index[d] = remainder % static_cast< OffsetValueType >( m_Size[d] );
+      remainder /= static_cast< OffsetValueType >( m_Size[d] );
+      }
+    for ( SizeValueType k = 0; k < m_Neighbors.size(); ++k )
+      {
+      if ( m_Neighbors[k][OutputImageDimension - 1] != -1 || !this->IsInside( index, m_Neighbors[k], both ) )
+        {
+        continue;
+        }
+      const OffsetValueType q = p + m_NeighborOffsets[k];
+      propagate( q, p, next );
+      propagate( p, q, previous );
+      }
     }
+  return changed;
 }
 
 template< typename TInputImage, typename TOutputImage, typename TCompare >
@@ -0,0 +1,289 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkSortedArrayHistogram_h
+#define itkSortedArrayHistogram_h
+
+#include "itkIntTypes.h"
+#include "itkNumericTraits.h"
+#include "itkMacro.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace itk
+{
+namespace Function
+{
+
+/** \class BlockedSortedArray
+ * \brief An order statistics multiset stored as a list of sorted blocks.
+ *
+ * Values are kept, with their duplicates, in a short list of sorted
+ * contiguous blocks whose size is bounded by BlockCapacity.
+ * Insertion and removal cost a binary search over the blocks and a
+ * memmove inside a single block; the k-th value is found by walking
+ * the block sizes. Unlike std::map, the storage is reused as the moving
+ * histogram slides, so no allocation happens in the steady state.
+ *
+ * This is the storage used by the moving histograms for pixel types
+ * whose range is too large for a dense vector (float, double, 32 bit
+ * integers).
+ *
+ * \ingroup ITKMathematicalMorphology
+ */
+template< typename TValue, typename TCompare = std::less< TValue > >
+class BlockedSortedArray
+{
+public:
+  using ValueType = TValue;
+  using BlockType = std::vector< TValue >;
+  using BlockListType = std::vector< BlockType >;
+
+  /** A block is split in two halves when it reaches this size. */
+  static constexpr SizeValueType BlockCapacity = 128;
+
+  BlockedSortedArray():
+    m_Size(0)
+  {}
+
+  void Insert(const TValue & v)
+  {
+    if ( m_Blocks.empty() )
+      {
+      m_Blocks.emplace_back();
+      m_Blocks.back().reserve(BlockCapacity);
+      }
+    auto blockIt = this->FindBlock(v);
+    if ( blockIt == m_Blocks.end() )
+      {
+      --blockIt;
+      }
+    BlockType & block = *blockIt;
+    block.insert(std::upper_bound(block.begin(), block.end(), v, m_Compare), v);
+    ++m_Size;
+
+    if ( block.size() >= BlockCapacity )
+      {
+      const auto half = static_cast< typename BlockType::difference_type >( block.size() / 2 );
+      BlockType upper;
+      upper.reserve(BlockCapacity);
+      upper.assign(block.begin() + half, block.end());
+      block.erase(block.begin() + half, block.end());
+      m_Blocks.insert(blockIt + 1, std::move(upper));
+      }
+  }
+
+  /** Remove one occurrence of v. v must have been inserted before. */
+  void Erase(const TValue & v)
+  {
+    auto blockIt = this->FindBlock(v);
+    itkAssertInDebugAndIgnoreInReleaseMacro( blockIt != m_Blocks.end() );
+    BlockType & block = *blockIt;
+    auto it = std::lower_bound(block.begin(), block.end(), v, m_Compare);
+    itkAssertInDebugAndIgnoreInReleaseMacro( it != block.end() && !m_Compare(v, *it) );
+    block.erase(it);
+    --m_Size;
+
+    if ( block.empty() )
+      {
+      m_Blocks.erase(blockIt);
+      }
+  }
+
+  /** The k-th value (0 based) in TCompare order. */
+  const TValue & GetNthValue(SizeValueType k) const
+  {
+    itkAssertInDebugAndIgnoreInReleaseMacro( k < m_Size );
+    auto blockIt = m_Blocks.begin();
+    while ( k >= blockIt->size() )
+      {
+      k -= blockIt->size();
+      ++blockIt;
+      }
+    return ( *blockIt )[k];
+  }
+
+  /** The first value in TCompare order. */
+  const TValue & GetFront() const
+  {
+    itkAssertInDebugAndIgnoreInReleaseMacro( m_Size > 0 );
+    return m_Blocks.front().front();
+  }
+
+  SizeValueType GetSize() const
+  {
+    return m_Size;
+  }
+
+  bool IsEmpty() const
+  {
+    return m_Size == 0;
+  }
+
+  void Clear()
+  {
+    m_Blocks.clear();
+    m_Size = 0;
+  }
+
+private:
+  /** First block whose last value is not before v. */
+  typename BlockListType::iterator FindBlock(const TValue & v)
+  {
+    return std::lower_bound( m_Blocks.begin(), m_Blocks.end(), v,
+                             [this](const BlockType & block, const TValue & value)
+                               {
+                               return m_Compare(block.back(), value);
+                               } );
+  }
+
+  BlockListType m_Blocks;
+  SizeValueType m_Size;
+  TCompare      m_Compare;
+};
+
+/** \class SortedArrayMorphologyHistogram
+ * \brief Min/max moving histogram based on BlockedSortedArray.
+ *
+ * Provides the same interface as MorphologyHistogram and is used in
+ * place of the std::map based implementation for pixel types with a
+ * large range.
+ *
+ * \ingroup ITKMathematicalMorphology
+ */
+template< typename TInputPixel, typename TCompare >
+class SortedArrayMorphologyHistogram
+{
+public:
+  SortedArrayMorphologyHistogram():
+    m_Boundary( NumericTraits< TInputPixel >::ZeroValue() )
+  {}
+
+  inline void AddBoundary()
+  {
+    m_Values.Insert(m_Boundary);
+  }
+
+  inline void RemoveBoundary()
+  {
+    m_Values.Erase(m_Boundary);
+  }
+
+  inline void AddPixel(const TInputPixel & p)
+  {
+    m_Values.Insert(p);
+  }
+
+  inline void RemovePixel(const TInputPixel & p)
+  {
+    m_Values.Erase(p);
+  }
+
+  inline TInputPixel GetValue()
+  {
+    itkAssertInDebugAndIgnoreInReleaseMacro( !m_Values.IsEmpty() );
+    return m_Values.GetFront();
+  }
+
+  inline TInputPixel GetValue(const TInputPixel &)
+  {
+    return GetValue();
+  }
+
+  void SetBoundary(const TInputPixel & val)
+  {
+    m_Boundary = val;
+  }
+
+  static bool UseVectorBasedAlgorithm()
+  {
+    return false;
+  }
+
+  BlockedSortedArray< TInputPixel, TCompare > m_Values;
+  TInputPixel                                  m_Boundary;
+};
+
+/** \class SortedArrayRankHistogram
+ * \brief Rank moving histogram based on BlockedSortedArray.
+ *
+ * Provides the same interface as RankHistogram. Ties are resolved
+ * exactly, as every value is stored with its duplicates.
+ *
+ * \ingroup ITKMathematicalMorphology
+ */
+template< typename TInputPixel >
+class SortedArrayRankHistogram
+{
+public:
+  SortedArrayRankHistogram():
+    m_Rank(0.5)
+  {}
+
+  void AddPixel(const TInputPixel & p)
+  {
+    m_Values.Insert(p);
+  }
+
+  void RemovePixel(const TInputPixel & p)
+  {
+    m_Values.Erase(p);
+  }
+
+  bool IsValid()
+  {
+    return !m_Values.IsEmpty();
+  }
+
+  TInputPixel GetValue(const TInputPixel &)
+  {
+    if ( m_Values.IsEmpty() )
+      {
+      return NumericTraits< TInputPixel >::max();
+      }
+    const SizeValueType entries = m_Values.GetSize();
+    const auto          target = (SizeValueType)( m_Rank * ( entries - 1 ) );
+    return m_Values.GetNthValue(target);
+  }
+
+  void SetRank(float rank)
+  {
+    m_Rank = rank;
+  }
+
+  void AddBoundary(){}
+
+  void RemoveBoundary(){}
+
+  static bool UseVectorBasedAlgorithm()
+  {
+    return false;
+  }
+
+protected:
+  float m_Rank;
+
+private:
+  BlockedSortedArray< TInputPixel, std::less< TInputPixel > > m_Values;
+};
+
+} // end namespace Function
+} // end namespace itk
+
+#endif
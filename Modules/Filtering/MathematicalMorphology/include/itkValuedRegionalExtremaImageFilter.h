@@ -22,6 +22,7 @@
 #include "itkShapedNeighborhoodIterator.h"
 #include "itkConstantBoundaryCondition.h"
 #include <stack>
+#include <vector>
 
 namespace itk
 {
@@ -57,6 +58,14 @@ namespace itk
  *
  * The implementation uses the functor model from itkMaximumImageFilter.
  *
+ * The image is divided in slabs along its last dimension, one for each
+ * thread, and the slabs are scanned in parallel. A flooding stops at the
+ * boundary of its slab, and the pixels of the flat region in the other
+ * slabs seed new floodings in their slab, until no flat region crosses
+ * a boundary. A flat region is flooded as soon as one of its pixels has a
+ * better neighbor, so the output does not depend on the number of
+ * threads.
+ *
  *
  * This code was contributed in the Insight Journal paper:
  * "Finding regional extrema - methods and performance"
@@ -167,6 +176,36 @@ private:
   using ConstInputIterator = ConstShapedNeighborhoodIterator< InputImageType >;
   using NOutputIterator = ShapedNeighborhoodIterator< OutputImageType >;
   using IndexStack = std::stack< OutIndexType >;
+
+  using OffsetType = typename OutputImageType::OffsetType;
+
+  /** A slab of the image, along its last dimension, the pixels from which
+   * it must be flooded, and the pixels of the other slabs reached by its
+   * floodings. */
+  struct SlabType
+  {
+    IndexValueType                 m_Begin;
+    IndexValueType                 m_End;
+    std::vector< OffsetValueType > m_Seeds;
+    std::vector< OffsetValueType > m_Outgoing;
+  };
+
+  /** The index of a pixel, relative to the start of the buffer. */
+  OutIndexType ComputeIndex(OffsetValueType offset) const;
+
+  /** Scan a slab, and flood the flat regions which are not extrema. */
+  void ScanSlab(SlabType & slab);
+
+  /** Flood the flat region of a pixel in a slab. */
+  void FloodSlab(SlabType & slab, OffsetValueType seed);
+
+  // the neighbors of a pixel, the layout of the buffers, and the buffers
+  std::vector< OffsetType >      m_Neighbors;
+  std::vector< OffsetValueType > m_NeighborOffsets;
+  typename OutputImageType::SizeType m_Size;
+  OffsetValueType                m_SliceSize;
+  const InputImagePixelType *    m_InputBuffer;
+  OutputImagePixelType *         m_OutputBuffer;
 }; // end of class
 } // end namespace itk
 
@@ -24,6 +24,8 @@
 #include "itkProgressReporter.h"
 #include "itkConnectedComponentAlgorithm.h"
 
+#include <atomic>
+
 
 namespace itk
 {
@@ -86,147 +88,298 @@ ValuedRegionalExtremaImageFilter< TInputImage, TOutputImage, TFunction1,
 
   const InputImageType * input = this->GetInput();
   OutputImageType * output = this->GetOutput();
+  const OutputImageRegionType region = output->GetRequestedRegion();
+  if ( region.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
 
-  // 2 phases
-  ProgressReporter progress(this, 0,
-                            this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() * 2);
+  ProgressReporter progress(this, 0, 1);
 
-  // copy input to output - isn't there a better way?
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  // copy input to output, and check whether the image is flat
   using InputIterator = ImageRegionConstIterator< TInputImage >;
   using OutputIterator = ImageRegionIterator< TOutputImage >;
 
-  InputIterator inIt( input,
-                      output->GetRequestedRegion() );
-  OutputIterator outIt( output,
-                        output->GetRequestedRegion() );
-  inIt.GoToBegin();
-  outIt.GoToBegin();
-
-  InputImagePixelType firstValue = inIt.Get();
-  this->m_Flat = true;
-
-  while( !outIt.IsAtEnd() )
-    {
-    InputImagePixelType currentValue = inIt.Get();
-    outIt.Set( static_cast< OutputImagePixelType >( currentValue ) );
-    if ( currentValue != firstValue )
+  const InputImagePixelType firstValue = input->GetPixel( region.GetIndex() );
+  std::atomic< bool > flat( true );
+  multiThreader->template ParallelizeImageRegion< OutputImageDimension >(
+    region,
+    [&](const OutputImageRegionType & regionForThread)
       {
-      this->m_Flat = false;
-      }
-    ++inIt;
-    ++outIt;
-    progress.CompletedPixel();
-    }
+      InputIterator  inIt( input, regionForThread );
+      OutputIterator outIt( output, regionForThread );
+      bool           flatForThread = true;
+      for ( ; !outIt.IsAtEnd(); ++inIt, ++outIt )
+        {
+        const InputImagePixelType currentValue = inIt.Get();
+        outIt.Set( static_cast< OutputImagePixelType >( currentValue ) );
+        flatForThread = flatForThread && ( currentValue == firstValue );
+        }
+      if ( !flatForThread )
+        {
+        flat = false;
+        }
+      },
+    nullptr);
+  this->m_Flat = flat;
 
   // if the image is flat, there is no need to do the work:
   // the image will be unchanged
   if( !this->m_Flat )
     {
-    // Now for the real work!
-    // More iterators - use shaped ones so that we can set connectivity
-    // Note : all comments refer to finding regional minima, because
-    // it is briefer and clearer than trying to describe both regional
-    // maxima and minima processes at the same time
-    ISizeType kernelRadius;
-    kernelRadius.Fill( 1 );
-    NOutputIterator outNIt( kernelRadius,
-                            output,
-                            output->GetRequestedRegion() );
-    setConnectivity(&outNIt, m_FullyConnected);
-
-    ConstInputIterator inNIt( kernelRadius,
-                              input,
-                              output->GetRequestedRegion() );
-    setConnectivity(&inNIt, m_FullyConnected);
-
-    ConstantBoundaryCondition< OutputImageType > iBC;
-    iBC.SetConstant(m_MarkerValue);
-    inNIt.OverrideBoundaryCondition(&iBC);
-
-    ConstantBoundaryCondition< OutputImageType > oBC;
-    oBC.SetConstant(m_MarkerValue);
-    outNIt.OverrideBoundaryCondition(&oBC);
-
-    TFunction1 compareIn;
-    TFunction2 compareOut;
-
-    outIt.GoToBegin();
-    // set up the stack and neighbor list
-    IndexStack IS;
-    typename NOutputIterator::IndexListType IndexList;
-    IndexList = outNIt.GetActiveIndexList();
-
-    while( !outIt.IsAtEnd() )
+    // the neighbors, and the layout of the buffers
+    m_Neighbors.clear();
+    m_NeighborOffsets.clear();
+    OffsetType offset;
+    offset.Fill( -1 );
+    bool done = false;
+    while ( !done )
       {
-      OutputImagePixelType V = outIt.Get();
-      // if the output pixel value = the marker value then we have
-      // already visited this pixel and don't need to do so again
-      if ( compareOut(V, m_MarkerValue) )
+      unsigned int nonZero = 0;
+      for ( unsigned int d = 0; d < OutputImageDimension; ++d )
         {
-        // reposition the input iterator
-        inNIt += outIt.GetIndex() - inNIt.GetIndex();
-
-        auto Cent = static_cast< InputImagePixelType >( V );
+        nonZero += ( offset[d] != 0 );
+        }
+      if ( nonZero == 1 || ( nonZero > 1 && m_FullyConnected ) )
+        {
+        m_Neighbors.push_back( offset );
+        }
+      done = true;
+      for ( unsigned int d = 0; d < OutputImageDimension && done; ++d )
+        {
+        if ( offset[d] < 1 )
+          {
+          ++offset[d];
+          done = false;
+          }
+        else
+          {
+          offset[d] = -1;
+          }
+        }
+      }
+    const typename OutputImageType::OffsetValueType * offsetTable = output->GetOffsetTable();
+    for ( const OffsetType & neighbor : m_Neighbors )
+      {
+      OffsetValueType neighborOffset = 0;
+      for ( unsigned int d = 0; d < OutputImageDimension; ++d )
+        {
+        neighborOffset += neighbor[d] * offsetTable[d];
+        }
+      m_NeighborOffsets.push_back( neighborOffset );
+      }
+    m_Size = region.GetSize();
+    m_SliceSize = offsetTable[OutputImageDimension - 1];
+    m_InputBuffer = input->GetBufferPointer() + input->ComputeOffset( region.GetIndex() );
+    m_OutputBuffer = output->GetBufferPointer();
+
+    // the slabs
+    const SizeValueType numberOfSlices = m_Size[OutputImageDimension - 1];
+    const SizeValueType numberOfSlabs = ( OutputImageDimension == 1 ) ? 1 :
+      std::min( static_cast< SizeValueType >( this->GetNumberOfThreads() ), numberOfSlices );
+    std::vector< SlabType > slabs( numberOfSlabs );
+    for ( SizeValueType i = 0; i < numberOfSlabs; ++i )
+      {
+      slabs[i].m_Begin = static_cast< IndexValueType >( i * numberOfSlices / numberOfSlabs );
+      slabs[i].m_End = static_cast< IndexValueType >( ( i + 1 ) * numberOfSlices / numberOfSlabs );
+      }
 
-        // check each neighbor of the input pixel
-        typename ConstInputIterator::ConstIterator sIt;
-        for ( sIt = inNIt.Begin(); !sIt.IsAtEnd(); ++sIt )
+    // scan the slabs, then flood the flat regions which cross their
+    // boundaries, until they are all flooded
+    ImageRegion< 1 > slabRegion;
+    slabRegion.SetIndex( 0, 0 );
+    slabRegion.SetSize( 0, numberOfSlabs );
+    bool first = true;
+    bool crossing = true;
+    while ( crossing )
+      {
+      multiThreader->template ParallelizeImageRegion< 1 >(
+        slabRegion,
+        [&](const ImageRegion< 1 > & slabsForThread)
           {
-          InputImagePixelType Adjacent = sIt.Get();
-          if ( compareIn(Adjacent, Cent) )
+          const SizeValueType begin = slabsForThread.GetIndex( 0 );
+          for ( SizeValueType i = begin; i < begin + slabsForThread.GetSize( 0 ); ++i )
             {
-            // The centre pixel cannot be part of a regional minima
-            // because one of its neighbors is smaller.
-            // Set all pixels in the output image that are connected to
-            // the centre pixel and have the same value to
-            // m_MarkerValue
-            // This is the flood filling step. It is a simple, stack
-            // based, procedure. The original value (V) of the pixel is
-            // recorded and the pixel index in the output image
-            // is set to the marker value. The stack is initialized
-            // with the pixel index. The flooding procedure pops the
-            // stack, sets that index to the marker value and places the
-            // indexes of all neighbors with value V on the stack. The
-            // process terminates when the stack is empty.
-
-            outNIt += outIt.GetIndex() - outNIt.GetIndex();
-
-            OutputImagePixelType NVal;
-            OutIndexType         idx;
-            // Initialize the stack
-            IS.push( outNIt.GetIndex() );
-            outNIt.SetCenterPixel(m_MarkerValue);
-
-            typename NOutputIterator::IndexListType::const_iterator LIt;
-
-            while( !IS.empty() )
+            if ( first )
+              {
+              this->ScanSlab( slabs[i] );
+              }
+            std::vector< OffsetValueType > seeds;
+            seeds.swap( slabs[i].m_Seeds );
+            for ( const OffsetValueType seed : seeds )
               {
-              // Pop the stack
-              idx = IS.top();
-              IS.pop();
-              // position the iterator
-              outNIt += idx - outNIt.GetIndex();
-              // check neighbors
-              for ( LIt = IndexList.begin(); LIt != IndexList.end(); ++LIt )
+              // the flat region may already be flooded
+              if ( m_OutputBuffer[seed] == static_cast< OutputImagePixelType >( m_InputBuffer[seed] ) )
                 {
-                NVal = outNIt.GetPixel(*LIt);
-                if ( NVal == V )
-                  {
-                  // still in a flat zone
-                  IS.push( outNIt.GetIndex(*LIt) );
-
-                  // set the output as the marker value
-                  outNIt.SetPixel(*LIt, m_MarkerValue);
-                  }
+                this->FloodSlab( slabs[i], seed );
                 }
               }
-            // end flooding
-            break;
             }
+          },
+        nullptr);
+      first = false;
+
+      // the pixels reached in the other slabs
+      crossing = false;
+      for ( SlabType & slab : slabs )
+        {
+        for ( const OffsetValueType pixel : slab.m_Outgoing )
+          {
+          const auto slice = static_cast< IndexValueType >( pixel / m_SliceSize );
+          SizeValueType owner = 0;
+          while ( slabs[owner].m_End <= slice )
+            {
+            ++owner;
+            }
+          slabs[owner].m_Seeds.push_back( pixel );
+          crossing = true;
           }
+        slab.m_Outgoing.clear();
+        }
+      }
+    }
+  progress.CompletedPixel();
+}
+
+
+template< typename TInputImage, typename TOutputImage, typename TFunction1,
+          typename TFunction2 >
+typename ValuedRegionalExtremaImageFilter< TInputImage, TOutputImage, TFunction1, TFunction2 >::OutIndexType
+ValuedRegionalExtremaImageFilter< TInputImage, TOutputImage, TFunction1,
+                                  TFunction2 >
+::ComputeIndex(OffsetValueType offset) const
+{
+  OutIndexType index;
+  for ( unsigned int d = 0; d < OutputImageDimension; ++d )
+    {
+    index[d] = offset % static_cast< OffsetValueType >( m_Size[d] );
+    offset /= static_cast< OffsetValueType >( m_Size[d] );
+    }
+  return index;
+}
+
+
+template< typename TInputImage, typename TOutputImage, typename TFunction1,
+          typename TFunction2 >
+void
+ValuedRegionalExtremaImageFilter< TInputImage, TOutputImage, TFunction1,
+                                  TFunction2 >
+::ScanSlab(SlabType & slab)
+{
+  // Note : all comments refer to finding regional minima, because
+  // it is briefer and clearer than trying to describe both regional
+  // maxima and minima processes at the same time
+  TFunction1 compareIn;
+  TFunction2 compareOut;
+
+  const auto            lineSize = static_cast< IndexValueType >( m_Size[0] );
+  const OffsetValueType begin = slab.m_Begin * m_SliceSize;
+  const OffsetValueType end = slab.m_End * m_SliceSize;
+  std::vector< bool >   isLineInside( m_Neighbors.size() );
+  for ( OffsetValueType lineStart = begin; lineStart < end; lineStart += lineSize )
+    {
+    // whether the lines of the neighbors are in the image
+    const OutIndexType lineIndex = this->ComputeIndex( lineStart );
+    for ( SizeValueType k = 0; k < m_Neighbors.size(); ++k )
+      {
+      bool isInside = true;
+      for ( unsigned int d = 1; d < OutputImageDimension; ++d )
+        {
+        const IndexValueType i = lineIndex[d] + m_Neighbors[k][d];
+        isInside = isInside && i >= 0 && i < static_cast< IndexValueType >( m_Size[d] );
+        }
+      isLineInside[k] = isInside;
+      }
+
+    for ( IndexValueType x = 0; x < lineSize; ++x )
+      {
+      const OffsetValueType      p = lineStart + x;
+      const OutputImagePixelType V = m_OutputBuffer[p];
+      // if the output pixel value = the marker value then we have
+      // already visited this pixel and don't need to do so again
+      if ( !compareOut(V, m_MarkerValue) )
+        {
+        continue;
+        }
+      auto Cent = static_cast< InputImagePixelType >( V );
+
+      // check each neighbor of the input pixel. The pixels outside of the
+      // image have the marker value.
+      for ( SizeValueType k = 0; k < m_Neighbors.size(); ++k )
+        {
+        const IndexValueType xn = x + m_Neighbors[k][0];
+        const bool           isInside = isLineInside[k] && xn >= 0 && xn < lineSize;
+        const InputImagePixelType Adjacent = isInside ? m_InputBuffer[p + m_NeighborOffsets[k]] : m_MarkerValue;
+        if ( compareIn(Adjacent, Cent) )
+          {
+          // The centre pixel cannot be part of a regional minima
+          // because one of its neighbors is smaller.
+          // Set all pixels in the output image that are connected to
+          // the centre pixel and have the same value to
+          // m_MarkerValue
+          this->FloodSlab( slab, p );
+          break;
+          }
+        }
+      }
+    }
+}
+
+
+template< typename TInputImage, typename TOutputImage, typename TFunction1,
+          typename TFunction2 >
+void
+ValuedRegionalExtremaImageFilter< TInputImage, TOutputImage, TFunction1,
+                                  TFunction2 >
+::FloodSlab(SlabType & slab, OffsetValueType seed)
+{
+  // This is the flood filling step. It is a simple, stack based,
+  // procedure. The original value (V) of the pixel is recorded and the
+  // pixel in the output image is set to the marker value. The stack is
+  // initialized with the pixel. The flooding procedure pops the stack
+  // and places the neighbors with value V on the stack, after setting
+  // them to the marker value. The neighbors in the other slabs are only
+  // recorded, and flooded by the thread of their slab.
+  const OutputImagePixelType V = m_OutputBuffer[seed];
+  std::stack< OffsetValueType > stack;
+  stack.push( seed );
+  m_OutputBuffer[seed] = m_MarkerValue;
+
+  while ( !stack.empty() )
+    {
+    const OffsetValueType p = stack.top();
+    stack.pop();
+    const OutIndexType index = this->ComputeIndex( p );
+    for ( SizeValueType k = 0; k < m_Neighbors.size(); ++k )
+      {
+      bool isInside = true;
+      for ( unsigned int d = 0; d < OutputImageDimension; ++d )
+        {
+        const IndexValueType i = index[d] + m_Neighbors[k][d];
+        isInside = isInside && i >= 0 && i < static_cast< IndexValueType >( m_Size[d] );
+        }
+      if ( !isInside )
+        {
+        continue;
+        }
+      const OffsetValueType q = p + m_NeighborOffsets[k];
+      const IndexValueType  slice = index[OutputImageDimension - 1] + m_Neighbors[k][OutputImageDimension - 1];
+      if ( slice >= slab.m_Begin && slice < slab.m_End )
+        {
+        if ( m_OutputBuffer[q] == V )
+          {
+          // still in a flat zone
+          stack.push( q );
+          m_OutputBuffer[q] = m_MarkerValue;
+          }
+        }
+      else if ( static_cast< OutputImagePixelType >( m_InputBuffer[q] ) == V )
+        {
+        slab.m_Outgoing.push_back( q );
         }
-      ++outIt;
-      progress.CompletedPixel();
       }
     }
 }
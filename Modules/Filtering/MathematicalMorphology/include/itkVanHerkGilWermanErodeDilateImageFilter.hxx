@@ -47,11 +47,10 @@ VanHerkGilWermanErodeDilateImageFilter< TImage, TKernel, TFunction1 >
 
   // TFunction1 will be < for erosions
 
-  // the initial version will adopt the methodology of loading a line
-  // at a time into a buffer vector, carrying out the opening or
-  // closing, and then copy the result to the output. Hopefully this
-  // will improve cache performance when working along non raster
-  // directions.
+  // the lines are loaded into a buffer, a group of lines at a time,
+  // the erosion or dilation is carried out on the whole group, and the
+  // result is copied to the output. Hopefully this will improve cache
+  // performance when working along non raster directions.
 
   InputImageConstPointer input = this->GetInput();
 
@@ -78,9 +77,6 @@ VanHerkGilWermanErodeDilateImageFilter< TImage, TKernel, TFunction1 >
   // compat
   bufflength += 2;
 
-  std::vector<InputImagePixelType> buffer(bufflength);
-  std::vector<InputImagePixelType> forward(bufflength);
-  std::vector<InputImagePixelType> reverse(bufflength);
   // iterate over all the structuring elements
   typename KernelType::DecompType decomposition = this->GetKernel().GetLines();
   BresType BresLine;
@@ -100,10 +96,9 @@ VanHerkGilWermanErodeDilateImageFilter< TImage, TKernel, TFunction1 >
 
     InputImageRegionType BigFace = MakeEnlargedFace< InputImageType, KernelLType >(input, IReg, ThisLine);
 
-    DoFace< TImage, BresType, TFunction1, KernelLType >(input, output, m_Boundary, ThisLine,
-                                                        TheseOffsets, SELength,
-                                                        buffer, forward,
-                                                        reverse, IReg, BigFace);
+    // the lines of the face are processed several at a time
+    DoFaceBatched< TImage, BresType, TFunction1, KernelLType >(input.GetPointer(), output.GetPointer(), m_Boundary,
+                                                               ThisLine, TheseOffsets, SELength, IReg, BigFace);
 
     // after the first pass the input will be taken from the output
     input = internalbuffer;
@@ -53,6 +53,23 @@ void DoFace(typename TImage::ConstPointer input,
             std::vector<typename TImage::PixelType> & rExtBuffer,
             const typename TImage::RegionType AllImage,
             const typename TImage::RegionType face);
+
+/** Same result as DoFace, but the lines of the face are processed by
+ * groups of VanHerkGilWermanLanes. The lines of a group are gathered in a
+ * lane-interleaved buffer, so the inner loops of the forward and reverse
+ * passes run over the lanes with unit stride and can be vectorized by the
+ * compiler whatever the direction of the line in the image. */
+static constexpr unsigned int VanHerkGilWermanLanes = 16;
+
+template< typename TImage, typename TBres, typename TFunction, typename TLine >
+void DoFaceBatched(const TImage * input,
+                   TImage * output,
+                   typename TImage::PixelType border,
+                   TLine line,
+                   const typename TBres::OffsetArray & LineOffsets,
+                   const unsigned int KernLen,
+                   const typename TImage::RegionType & AllImage,
+                   const typename TImage::RegionType & face);
 } // namespace itk
 
 #ifndef ITK_MANUAL_INSTANTIATION
@@ -23,6 +23,9 @@
 #include "itkImageRegionConstIterator.h"
 #include "itkNeighborhoodAlgorithm.h"
 
+#include <algorithm>
+#include <memory>
+
 namespace itk
 {
 /**
@@ -209,6 +212,173 @@ void DoFace(typename TImage::ConstPointer input,
     }
 }
 
+template< typename TImage, typename TBres, typename TFunction, typename TLine >
+void DoFaceBatched(const TImage * input,
+                   TImage * output,
+                   typename TImage::PixelType border,
+                   TLine line,
+                   const typename TBres::OffsetArray & LineOffsets,
+                   const unsigned int KernLen,
+                   const typename TImage::RegionType & AllImage,
+                   const typename TImage::RegionType & face)
+{
+  using PixelType = typename TImage::PixelType;
+  using IndexType = typename TImage::IndexType;
+  constexpr unsigned int Lanes = VanHerkGilWermanLanes;
+
+  // see DoFace
+  typename TImage::Pointer dumbImg = TImage::New();
+  dumbImg->SetRegions(face);
+
+  TLine NormLine = line;
+  NormLine.Normalize();
+  float     tol = 1.0 / LineOffsets.size();
+  TFunction m_TF;
+
+  const unsigned int half = KernLen / 2;
+
+  // the lines are moved through the buffers with plain pointer arithmetic
+  auto linearOffsets = [&LineOffsets](const TImage * image)
+    {
+    const OffsetValueType *        table = image->GetOffsetTable();
+    std::vector< OffsetValueType > linear( LineOffsets.size() );
+    for ( unsigned int i = 0; i < LineOffsets.size(); i++ )
+      {
+      OffsetValueType o = 0;
+      for ( unsigned int d = 0; d < TImage::ImageDimension; d++ )
+        {
+        o += LineOffsets[i][d] * table[d];
+        }
+      linear[i] = o;
+      }
+    return linear;
+    };
+  const std::vector< OffsetValueType > inOffsets = linearOffsets(input);
+  const std::vector< OffsetValueType > outOffsets = linearOffsets(output);
+  const PixelType *                    inBuffer = input->GetBufferPointer();
+  PixelType *                          outBuffer = output->GetBufferPointer();
+
+  // Each line is stored with the border value on both sides and is padded
+  // with KernLen/2 more border values, so the windows never have to be
+  // cropped, and up to a multiple of KernLen, so all the blocks of the
+  // forward and reverse passes are complete. Repeating the border does not
+  // change the extremum of a window which already contains it.
+  const unsigned int maxLength = 2 * half + static_cast< unsigned int >( LineOffsets.size() ) + 2;
+  const unsigned int maxPadded = ( ( maxLength + KernLen - 1 ) / KernLen ) * KernLen;
+  // plain arrays rather than vectors, so bool images can be processed too
+  std::unique_ptr< PixelType[] > pixbuffer( new PixelType[maxPadded * Lanes] );
+  std::unique_ptr< PixelType[] > fExtBuffer( new PixelType[maxPadded * Lanes] );
+  std::unique_ptr< PixelType[] > rExtBuffer( new PixelType[maxPadded * Lanes] );
+
+  OffsetValueType inStart[Lanes];
+  OffsetValueType outStart[Lanes];
+  unsigned int    starts[Lanes];
+  unsigned int    lengths[Lanes];
+  unsigned int    lanes = 0;
+  unsigned int    longest = 0;
+
+  const SizeValueType facePixels = face.GetNumberOfPixels();
+  for ( SizeValueType it = 0; it <= facePixels; it++ )
+    {
+    if ( it < facePixels )
+      {
+      const IndexType Ind = dumbImg->ComputeIndex(it);
+      unsigned        start, end;
+      if ( ComputeStartEnd< TImage, TBres, TLine >(Ind, NormLine, tol, LineOffsets, AllImage, start, end) )
+        {
+        inStart[lanes] = input->ComputeOffset(Ind + LineOffsets[start]) - inOffsets[start];
+        outStart[lanes] = output->ComputeOffset(Ind + LineOffsets[start]) - outOffsets[start];
+        starts[lanes] = start;
+        lengths[lanes] = end - start + 1;
+        longest = std::max(longest, lengths[lanes]);
+        ++lanes;
+        }
+      if ( lanes < Lanes )
+        {
+        continue;
+        }
+      }
+    if ( lanes == 0 )
+      {
+      continue;
+      }
+
+    // gather the lines in the interleaved buffer
+    const unsigned int padded = ( ( 2 * half + longest + 2 + KernLen - 1 ) / KernLen ) * KernLen;
+    std::fill(pixbuffer.get(), pixbuffer.get() + padded * Lanes, border);
+    for ( unsigned int l = 0; l < lanes; l++ )
+      {
+      PixelType *             dest = &pixbuffer[( half + 1 ) * Lanes + l];
+      const OffsetValueType * offsets = &inOffsets[starts[l]];
+      const PixelType *       source = inBuffer + inStart[l];
+      for ( unsigned int i = 0; i < lengths[l]; i++ )
+        {
+        dest[i * Lanes] = source[offsets[i]];
+        }
+      }
+
+    // forward and reverse extremes of the blocks, all the lanes at once
+    for ( unsigned int b = 0; b < padded; b += KernLen )
+      {
+      PixelType *       f = &fExtBuffer[b * Lanes];
+      const PixelType * p = &pixbuffer[b * Lanes];
+      std::copy(p, p + Lanes, f);
+      for ( unsigned int k = 1; k < KernLen; k++ )
+        {
+        const PixelType * previous = f;
+        f += Lanes;
+        p += Lanes;
+        for ( unsigned int l = 0; l < Lanes; l++ )
+          {
+          f[l] = m_TF(p[l], previous[l]);
+          }
+        }
+
+      PixelType * r = &rExtBuffer[( b + KernLen - 1 ) * Lanes];
+      p = &pixbuffer[( b + KernLen - 1 ) * Lanes];
+      std::copy(p, p + Lanes, r);
+      for ( unsigned int k = 1; k < KernLen; k++ )
+        {
+        const PixelType * next = r;
+        r -= Lanes;
+        p -= Lanes;
+        for ( unsigned int l = 0; l < Lanes; l++ )
+          {
+          r[l] = m_TF(p[l], next[l]);
+          }
+        }
+      }
+
+    // The window of the pixel at position j in the padded line is
+    // [j - half, j + half]: it is covered by the reverse extreme at its
+    // beginning and the forward extreme at its end.
+    for ( unsigned int j = 0; j < longest; j++ )
+      {
+      PixelType *       result = &pixbuffer[( j + 1 ) * Lanes];
+      const PixelType * r = &rExtBuffer[( j + 1 ) * Lanes];
+      const PixelType * f = &fExtBuffer[( j + 1 + 2 * half ) * Lanes];
+      for ( unsigned int l = 0; l < Lanes; l++ )
+        {
+        result[l] = m_TF(r[l], f[l]);
+        }
+      }
+
+    // scatter the results
+    for ( unsigned int l = 0; l < lanes; l++ )
+      {
+      const PixelType *       source = &pixbuffer[Lanes + l];
+      const OffsetValueType * offsets = &outOffsets[starts[l]];
+      PixelType *             dest = outBuffer + outStart[l];
+      for ( unsigned int i = 0; i < lengths[l]; i++ )
+        {
+        dest[offsets[i]] = source[i * Lanes];
+        }
+      }
+    lanes = 0;
+    longest = 0;
+    }
+}
+
 } // namespace itk
 
 #endif
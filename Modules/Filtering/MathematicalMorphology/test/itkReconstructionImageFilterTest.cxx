@@ -0,0 +1,351 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkReconstructionByDilationImageFilter.h"
+#include "itkReconstructionByErosionImageFilter.h"
+#include "itkImageAlgorithm.h"
+#include "itkCommand.h"
+#include "itkGrayscaleFillholeImageFilter.h"
+#include "itkHMaximaImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+template< typename TImage >
+bool SameImages( const TImage * image1, const TImage * image2, const std::string & name )
+{
+  itk::ImageRegionConstIterator< TImage > it1( image1, image1->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > it2( image2, image1->GetLargestPossibleRegion() );
+  unsigned int differences = 0;
+  for( ; !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    differences += ( it1.Get() != it2.Get() );
+    }
+  std::cout << name << ": " << differences << " differences" << std::endl;
+  return differences == 0;
+}
+
+// propagate the values of the marker to the neighbors under the mask,
+// pixel by pixel, until stability
+template< typename TImage, typename TCompare >
+typename TImage::Pointer Reference( const TImage * marker, const TImage * mask, bool fullyConnected )
+{
+  using OffsetType = typename TImage::OffsetType;
+  constexpr unsigned int Dimension = TImage::ImageDimension;
+  std::vector< OffsetType > neighbors;
+  OffsetType offset;
+  offset.Fill( -1 );
+  for( bool done = false; !done; )
+    {
+    unsigned int nonZero = 0;
+    for( unsigned int d = 0; d < Dimension; d++ )
+      {
+      nonZero += ( offset[d] != 0 );
+      }
+    if( nonZero == 1 || ( nonZero > 1 && fullyConnected ) )
+      {
+      neighbors.push_back( offset );
+      }
+    done = true;
+    for( unsigned int d = 0; d < Dimension && done; d++ )
+      {
+      done = ( offset[d] == 1 );
+      offset[d] = done ? -1 : offset[d] + 1;
+      }
+    }
+
+  typename TImage::Pointer output = TImage::New();
+  output->SetRegions( marker->GetLargestPossibleRegion() );
+  output->Allocate();
+  itk::ImageAlgorithm::Copy( marker, output.GetPointer(), marker->GetLargestPossibleRegion(),
+                             marker->GetLargestPossibleRegion() );
+  const typename TImage::RegionType region = output->GetLargestPossibleRegion();
+  TCompare compare;
+  for( bool changed = true; changed; )
+    {
+    changed = false;
+    itk::ImageRegionIteratorWithIndex< TImage > it( output, region );
+    for( ; !it.IsAtEnd(); ++it )
+      {
+      for( const OffsetType & neighbor : neighbors )
+        {
+        const typename TImage::IndexType index = it.GetIndex() + neighbor;
+        if( !region.IsInside( index ) )
+          {
+          continue;
+          }
+        typename TImage::PixelType value = output->GetPixel( index );
+        if( compare( value, mask->GetPixel( it.GetIndex() ) ) )
+          {
+          value = mask->GetPixel( it.GetIndex() );
+          }
+        if( compare( value, it.Get() ) )
+          {
+          it.Set( value );
+          changed = true;
+          }
+        }
+      }
+    }
+  return output;
+}
+
+// count the progress events between the start and the end of a filter
+class ProgressCounter
+{
+public:
+  void Observe()
+  {
+    const float progress = m_Filter->GetProgress();
+    m_Steps += ( progress > 0.0f && progress < 1.0f );
+  }
+
+  const itk::ProcessObject * m_Filter;
+  unsigned int               m_Steps;
+};
+
+template< typename TFilter, typename TImage >
+bool SameForAllThreads( TFilter * filter, const TImage * expected, const std::string & name )
+{
+  bool passed = true;
+  for( unsigned int threads = 1; threads < 8; threads += 3 )
+    {
+    filter->SetNumberOfThreads( threads );
+    filter->Modified();
+    TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+    passed &= SameImages( expected, filter->GetOutput(), name + ", " + std::to_string( threads ) + " threads" );
+    }
+  return passed;
+}
+}
+
+// Compare the reconstructions with a propagation pixel by pixel, and
+// the filters using them, for several numbers of threads.
+template< unsigned int VDimension >
+int Reconstruction( const typename itk::Image< unsigned char, VDimension >::SizeType & size )
+{
+  using ImageType = itk::Image< unsigned char, VDimension >;
+  using IndexType = typename ImageType::IndexType;
+
+  // bumps and noise as the mask, a lower marker with a few peaks, and a
+  // higher marker with a few pits
+  typename ImageType::Pointer mask = ImageType::New();
+  mask->SetRegions( size );
+  mask->Allocate();
+  typename ImageType::Pointer lowMarker = ImageType::New();
+  lowMarker->SetRegions( size );
+  lowMarker->Allocate();
+  typename ImageType::Pointer highMarker = ImageType::New();
+  highMarker->SetRegions( size );
+  highMarker->Allocate();
+
+  using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+  std::vector< IndexType > centers( 40 );
+  for( IndexType & center : centers )
+    {
+    for( unsigned int d = 0; d < VDimension; d++ )
+      {
+      center[d] = generator->GetIntegerVariate( size[d] - 1 );
+      }
+    }
+  itk::ImageRegionIteratorWithIndex< ImageType > mIt( mask, mask->GetBufferedRegion() );
+  itk::ImageRegionIterator< ImageType > lIt( lowMarker, mask->GetBufferedRegion() );
+  itk::ImageRegionIterator< ImageType > hIt( highMarker, mask->GetBufferedRegion() );
+  for( ; !mIt.IsAtEnd(); ++mIt, ++lIt, ++hIt )
+    {
+    double sum = 20.0 * generator->GetVariate();
+    for( const IndexType & center : centers )
+      {
+      double distance = 0.0;
+      for( unsigned int d = 0; d < VDimension; d++ )
+        {
+        distance += ( mIt.GetIndex()[d] - center[d] ) * ( mIt.GetIndex()[d] - center[d] );
+        }
+      sum += 100.0 * std::exp( -distance / 50.0 );
+      }
+    const auto value = static_cast< unsigned char >( std::min( 255.0, sum ) );
+    mIt.Set( value );
+    lIt.Set( generator->GetVariate() < 0.002 ? value : value / 3 );
+    hIt.Set( generator->GetVariate() < 0.002 ? value : 255 - ( 255 - value ) / 3 );
+    }
+
+  // a serpentine along the first dimension, which crosses the slabs many
+  // times, with a seed at one end
+  typename ImageType::Pointer path = ImageType::New();
+  path->SetRegions( size );
+  path->Allocate( true );
+  typename ImageType::Pointer seed = ImageType::New();
+  seed->SetRegions( size );
+  seed->Allocate( true );
+  itk::ImageRegionIteratorWithIndex< ImageType > pIt( path, path->GetBufferedRegion() );
+  for( ; !pIt.IsAtEnd(); ++pIt )
+    {
+    const IndexType index = pIt.GetIndex();
+    bool onPath = true;
+    for( unsigned int d = 2; d < VDimension; d++ )
+      {
+      onPath = onPath && ( index[d] == 0 );
+      }
+    const itk::IndexValueType last = size[1] - 1;
+    const bool turn = ( index[0] % 4 == 1 && index[1] == last ) || ( index[0] % 4 == 3 && index[1] == 0 );
+    if( onPath && ( index[0] % 2 == 0 || turn ) )
+      {
+      pIt.Set( 200 );
+      }
+    }
+  IndexType start;
+  start.Fill( 0 );
+  seed->SetPixel( start, 200 );
+
+  using DilationType = itk::ReconstructionByDilationImageFilter< ImageType, ImageType >;
+  typename DilationType::Pointer dilation = DilationType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( dilation, ReconstructionByDilationImageFilter, ReconstructionImageFilter );
+  TEST_SET_GET_BOOLEAN( dilation, FullyConnected, false );
+  TEST_SET_GET_BOOLEAN( dilation, UseInternalCopy, true );
+  using ErosionType = itk::ReconstructionByErosionImageFilter< ImageType, ImageType >;
+  typename ErosionType::Pointer erosion = ErosionType::New();
+
+  bool passed = true;
+  for( unsigned int fullyConnected = 0; fullyConnected < 2; fullyConnected++ )
+    {
+    const std::string connectivity = fullyConnected ? "fully connected" : "face connected";
+
+    dilation->SetFullyConnected( fullyConnected );
+    dilation->SetMaskImage( mask );
+    dilation->SetMarkerImage( lowMarker );
+    typename ImageType::Pointer expected =
+      Reference< ImageType, std::greater< unsigned char > >( lowMarker, mask, fullyConnected );
+    passed &= SameForAllThreads( dilation.GetPointer(), expected.GetPointer(), "dilation, " + connectivity );
+
+    erosion->SetFullyConnected( fullyConnected );
+    erosion->SetMaskImage( mask );
+    erosion->SetMarkerImage( highMarker );
+    expected = Reference< ImageType, std::less< unsigned char > >( highMarker, mask, fullyConnected );
+    passed &= SameForAllThreads( erosion.GetPointer(), expected.GetPointer(), "erosion, " + connectivity );
+
+    dilation->SetMaskImage( path );
+    dilation->SetMarkerImage( seed );
+    passed &= SameForAllThreads( dilation.GetPointer(), path.GetPointer(), "serpentine, " + connectivity );
+
+    // the filters built on the reconstruction
+    using FillholeType = itk::GrayscaleFillholeImageFilter< ImageType, ImageType >;
+    typename FillholeType::Pointer fillhole = FillholeType::New();
+    fillhole->SetInput( mask );
+    fillhole->SetFullyConnected( fullyConnected );
+    fillhole->SetNumberOfThreads( 1 );
+    TRY_EXPECT_NO_EXCEPTION( fillhole->Update() );
+    expected = fillhole->GetOutput();
+    expected->DisconnectPipeline();
+    passed &= SameForAllThreads( fillhole.GetPointer(), expected.GetPointer(), "fillhole, " + connectivity );
+
+    using HMaximaType = itk::HMaximaImageFilter< ImageType, ImageType >;
+    typename HMaximaType::Pointer hMaxima = HMaximaType::New();
+    hMaxima->SetInput( mask );
+    hMaxima->SetHeight( 20 );
+    hMaxima->SetFullyConnected( fullyConnected );
+    hMaxima->SetNumberOfThreads( 1 );
+    TRY_EXPECT_NO_EXCEPTION( hMaxima->Update() );
+    expected = hMaxima->GetOutput();
+    expected->DisconnectPipeline();
+    passed &= SameForAllThreads( hMaxima.GetPointer(), expected.GetPointer(), "h-maxima, " + connectivity );
+    }
+
+  // the progress is reported during the reconstruction, whatever the
+  // number of threads
+  ProgressCounter counter = { dilation.GetPointer(), 0 };
+  using CommandType = itk::SimpleMemberCommand< ProgressCounter >;
+  typename CommandType::Pointer command = CommandType::New();
+  command->SetCallbackFunction( &counter, &ProgressCounter::Observe );
+  dilation->AddObserver( itk::ProgressEvent(), command );
+  dilation->SetMaskImage( mask );
+  dilation->SetMarkerImage( lowMarker );
+  for( unsigned int threads = 1; threads < 8; threads += 3 )
+    {
+    counter.m_Steps = 0;
+    dilation->SetNumberOfThreads( threads );
+    TRY_EXPECT_NO_EXCEPTION( dilation->Update() );
+    std::cout << "progress, " << threads << " threads: " << counter.m_Steps << " steps" << std::endl;
+    passed &= ( counter.m_Steps == 3 );
+    }
+  dilation->RemoveAllObservers();
+
+  // a marker above the mask is an error
+  dilation->SetMaskImage( lowMarker );
+  dilation->SetMarkerImage( mask );
+  TRY_EXPECT_EXCEPTION( dilation->Update() );
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// A 1D image is a single line, which is not split into slabs.
+int Reconstruction1D()
+{
+  using ImageType = itk::Image< unsigned char, 1 >;
+  ImageType::SizeType size = {{ 64 }};
+  ImageType::Pointer mask = ImageType::New();
+  mask->SetRegions( size );
+  mask->Allocate();
+  ImageType::Pointer marker = ImageType::New();
+  marker->SetRegions( size );
+  marker->Allocate( true );
+
+  using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+  itk::ImageRegionIterator< ImageType > it( mask, mask->GetBufferedRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    it.Set( static_cast< unsigned char >( 100 + generator->GetIntegerVariate( 100 ) ) );
+    }
+  ImageType::IndexType seed = {{ 5 }};
+  marker->SetPixel( seed, mask->GetPixel( seed ) );
+
+  using DilationType = itk::ReconstructionByDilationImageFilter< ImageType, ImageType >;
+  DilationType::Pointer dilation = DilationType::New();
+  dilation->SetMaskImage( mask );
+  dilation->SetMarkerImage( marker );
+  ImageType::Pointer expected = Reference< ImageType, std::greater< unsigned char > >( marker, mask, false );
+  return SameForAllThreads( dilation.GetPointer(), expected.GetPointer(), "1D dilation" ) ? EXIT_SUCCESS
+                                                                                          : EXIT_FAILURE;
+}
+
+int itkReconstructionImageFilterTest( int, char * [] )
+{
+  if( Reconstruction1D() == EXIT_FAILURE )
+    {
+    std::cerr << "1D Fails" << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::Size< 2 > size2D = {{ 157, 133 }};
+  if( Reconstruction< 2 >( size2D ) == EXIT_FAILURE )
+    {
+    std::cerr << "2D Fails" << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::Size< 3 > size3D = {{ 41, 37, 29 }};
+  if( Reconstruction< 3 >( size3D ) == EXIT_FAILURE )
+    {
+    std::cerr << "3D Fails" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,188 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkRankImageFilter.h"
+#include "itkMovingHistogramDilateImageFilter.h"
+#include "itkMovingHistogramErodeImageFilter.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+#include <iterator>
+#include <set>
+
+namespace
+{
+
+// Compare the sorted array against a std::multiset under random insertions
+// and removals, with many ties.
+int CheckBlockedSortedArray()
+{
+  using ArrayType = itk::Function::BlockedSortedArray< float >;
+  using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 12345 );
+
+  ArrayType              array;
+  std::multiset< float > reference;
+  std::vector< float >   inserted;
+
+  for ( unsigned int i = 0; i < 20000; ++i )
+    {
+    if ( inserted.empty() || generator->GetVariate() < 0.55 )
+      {
+      const float v = static_cast< float >( generator->GetIntegerVariate( 500 ) ) / 7.0f;
+      array.Insert( v );
+      reference.insert( v );
+      inserted.push_back( v );
+      }
+    else
+      {
+      const unsigned int pos = generator->GetIntegerVariate( static_cast< unsigned int >( inserted.size() - 1 ) );
+      const float v = inserted[pos];
+      inserted[pos] = inserted.back();
+      inserted.pop_back();
+      array.Erase( v );
+      reference.erase( reference.find( v ) );
+      }
+
+    if ( array.GetSize() != reference.size() )
+      {
+      std::cerr << "Size mismatch at step " << i << std::endl;
+      return EXIT_FAILURE;
+      }
+    if ( reference.empty() )
+      {
+      continue;
+      }
+    if ( array.GetFront() != *reference.begin() )
+      {
+      std::cerr << "Front mismatch at step " << i << std::endl;
+      return EXIT_FAILURE;
+      }
+    const itk::SizeValueType k = generator->GetIntegerVariate( static_cast< unsigned int >( reference.size() - 1 ) );
+    auto                     refIt = reference.begin();
+    std::advance( refIt, k );
+    if ( array.GetNthValue( k ) != *refIt )
+      {
+      std::cerr << "Value of rank " << k << " mismatch at step " << i << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+}
+
+int itkSortedArrayHistogramTest( int, char *[] )
+{
+  if ( CheckBlockedSortedArray() != EXIT_SUCCESS )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The float filters must give the same result as the vector based
+  // histograms used for signed char images.
+  constexpr unsigned int Dimension = 3;
+  using FloatImageType = itk::Image< float, Dimension >;
+  using CharImageType = itk::Image< signed char, Dimension >;
+  using SEType = itk::FlatStructuringElement< Dimension >;
+
+  FloatImageType::SizeType size;
+  size.Fill( 24 );
+  FloatImageType::Pointer floatImage = FloatImageType::New();
+  floatImage->SetRegions( size );
+  floatImage->Allocate();
+  CharImageType::Pointer charImage = CharImageType::New();
+  charImage->SetRegions( size );
+  charImage->Allocate();
+
+  using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 54321 );
+
+  itk::ImageRegionIteratorWithIndex< FloatImageType > fit( floatImage, floatImage->GetLargestPossibleRegion() );
+  for ( ; !fit.IsAtEnd(); ++fit )
+    {
+    const auto v = static_cast< signed char >( static_cast< int >( generator->GetIntegerVariate( 200 ) ) - 100 );
+    fit.Set( v );
+    charImage->SetPixel( fit.GetIndex(), v );
+    }
+
+  SEType::RadiusType radius;
+  radius.Fill( 2 );
+  SEType kernel = SEType::Ball( radius );
+
+  using FloatRankType = itk::RankImageFilter< FloatImageType, FloatImageType, SEType >;
+  using CharRankType = itk::RankImageFilter< CharImageType, CharImageType, SEType >;
+  FloatRankType::Pointer floatRank = FloatRankType::New();
+  floatRank->SetInput( floatImage );
+  floatRank->SetKernel( kernel );
+  floatRank->SetRank( 0.3 );
+  CharRankType::Pointer charRank = CharRankType::New();
+  charRank->SetInput( charImage );
+  charRank->SetKernel( kernel );
+  charRank->SetRank( 0.3 );
+
+  using FloatDilateType = itk::MovingHistogramDilateImageFilter< FloatImageType, FloatImageType, SEType >;
+  using CharDilateType = itk::MovingHistogramDilateImageFilter< CharImageType, CharImageType, SEType >;
+  FloatDilateType::Pointer floatDilate = FloatDilateType::New();
+  floatDilate->SetInput( floatImage );
+  floatDilate->SetKernel( kernel );
+  CharDilateType::Pointer charDilate = CharDilateType::New();
+  charDilate->SetInput( charImage );
+  charDilate->SetKernel( kernel );
+
+  using FloatErodeType = itk::MovingHistogramErodeImageFilter< FloatImageType, FloatImageType, SEType >;
+  using CharErodeType = itk::MovingHistogramErodeImageFilter< CharImageType, CharImageType, SEType >;
+  FloatErodeType::Pointer floatErode = FloatErodeType::New();
+  floatErode->SetInput( floatImage );
+  floatErode->SetKernel( kernel );
+  CharErodeType::Pointer charErode = CharErodeType::New();
+  charErode->SetInput( charImage );
+  charErode->SetKernel( kernel );
+
+  TRY_EXPECT_NO_EXCEPTION( floatRank->Update() );
+  TRY_EXPECT_NO_EXCEPTION( charRank->Update() );
+  TRY_EXPECT_NO_EXCEPTION( floatDilate->Update() );
+  TRY_EXPECT_NO_EXCEPTION( charDilate->Update() );
+  TRY_EXPECT_NO_EXCEPTION( floatErode->Update() );
+  TRY_EXPECT_NO_EXCEPTION( charErode->Update() );
+
+  const FloatImageType * outputs[] = { floatRank->GetOutput(), floatDilate->GetOutput(), floatErode->GetOutput() };
+  const CharImageType * references[] = { charRank->GetOutput(), charDilate->GetOutput(), charErode->GetOutput() };
+  const char *           names[] = { "rank", "dilate", "erode" };
+  for ( unsigned int f = 0; f < 3; ++f )
+    {
+    itk::ImageRegionConstIteratorWithIndex< FloatImageType > it( outputs[f], outputs[f]->GetLargestPossibleRegion() );
+    for ( ; !it.IsAtEnd(); ++it )
+      {
+      if ( it.Get() != references[f]->GetPixel( it.GetIndex() ) )
+        {
+        std::cerr << "Wrong " << names[f] << " value at " << it.GetIndex() << ": " << it.Get()
+                  << " instead of " << +references[f]->GetPixel( it.GetIndex() ) << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,232 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkValuedRegionalMaximaImageFilter.h"
+#include "itkValuedRegionalMinimaImageFilter.h"
+#include "itkRegionalMaximaImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+#include <queue>
+
+namespace
+{
+// Mark the flat regions which have a better neighbor, region by region.
+// The pixels outside of the image have the marker value.
+template< typename TImage, typename TCompare >
+typename TImage::Pointer Reference( const TImage * input, bool fullyConnected,
+                                    typename TImage::PixelType marker )
+{
+  using IndexType = typename TImage::IndexType;
+  using OffsetType = typename TImage::OffsetType;
+  constexpr unsigned int Dimension = TImage::ImageDimension;
+  std::vector< OffsetType > neighbors;
+  OffsetType offset;
+  offset.Fill( -1 );
+  for( bool done = false; !done; )
+    {
+    unsigned int nonZero = 0;
+    for( unsigned int d = 0; d < Dimension; d++ )
+      {
+      nonZero += ( offset[d] != 0 );
+      }
+    if( nonZero == 1 || ( nonZero > 1 && fullyConnected ) )
+      {
+      neighbors.push_back( offset );
+      }
+    done = true;
+    for( unsigned int d = 0; d < Dimension && done; d++ )
+      {
+      done = ( offset[d] == 1 );
+      offset[d] = done ? -1 : offset[d] + 1;
+      }
+    }
+
+  const typename TImage::RegionType region = input->GetLargestPossibleRegion();
+  typename TImage::Pointer output = TImage::New();
+  output->SetRegions( region );
+  output->Allocate();
+  std::vector< bool > isVisited( region.GetNumberOfPixels(), false );
+  TCompare compare;
+
+  itk::ImageRegionIteratorWithIndex< TImage > it( output, region );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    if( isVisited[input->ComputeOffset( it.GetIndex() )] )
+      {
+      continue;
+      }
+    // the flat region of the pixel
+    const typename TImage::PixelType value = input->GetPixel( it.GetIndex() );
+    std::vector< IndexType > flatRegion;
+    std::queue< IndexType > queue;
+    queue.push( it.GetIndex() );
+    isVisited[input->ComputeOffset( it.GetIndex() )] = true;
+    bool isExtremum = true;
+    while( !queue.empty() )
+      {
+      const IndexType index = queue.front();
+      queue.pop();
+      flatRegion.push_back( index );
+      for( const OffsetType & neighbor : neighbors )
+        {
+        const IndexType neighborIndex = index + neighbor;
+        const typename TImage::PixelType neighborValue =
+          region.IsInside( neighborIndex ) ? input->GetPixel( neighborIndex ) : marker;
+        isExtremum = isExtremum && !compare( neighborValue, value );
+        if( region.IsInside( neighborIndex ) && neighborValue == value
+            && !isVisited[input->ComputeOffset( neighborIndex )] )
+          {
+          isVisited[input->ComputeOffset( neighborIndex )] = true;
+          queue.push( neighborIndex );
+          }
+        }
+      }
+    // the regions which are not better than the marker are never visited
+    isExtremum = isExtremum || !compare( value, marker );
+    for( const IndexType & index : flatRegion )
+      {
+      output->SetPixel( index, isExtremum ? value : marker );
+      }
+    }
+  return output;
+}
+
+template< typename TImage >
+bool SameImages( const TImage * image1, const TImage * image2, const std::string & name )
+{
+  itk::ImageRegionConstIterator< TImage > it1( image1, image1->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > it2( image2, image1->GetLargestPossibleRegion() );
+  unsigned int differences = 0;
+  for( ; !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    differences += ( it1.Get() != it2.Get() );
+    }
+  std::cout << name << ": " << differences << " differences" << std::endl;
+  return differences == 0;
+}
+
+template< typename TFilter, typename TImage >
+bool SameForAllThreads( TFilter * filter, const TImage * expected, const std::string & name )
+{
+  bool passed = true;
+  for( unsigned int threads = 1; threads < 8; threads += 3 )
+    {
+    filter->SetNumberOfThreads( threads );
+    filter->Modified();
+    TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+    passed &= SameImages( expected, filter->GetOutput(), name + ", " + std::to_string( threads ) + " threads" );
+    }
+  return passed;
+}
+}
+
+// Compare the regional extrema with a flooding region by region, for
+// several numbers of threads.
+template< unsigned int VDimension >
+int ValuedRegionalExtrema( const typename itk::Image< unsigned char, VDimension >::SizeType & size )
+{
+  using ImageType = itk::Image< unsigned char, VDimension >;
+
+  // blocks of a few values, which make large flat regions crossing the
+  // slabs, and noise
+  typename ImageType::Pointer input = ImageType::New();
+  input->SetRegions( size );
+  input->Allocate();
+  using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+  std::vector< unsigned char > blocks( 4096 );
+  for( unsigned char & block : blocks )
+    {
+    block = static_cast< unsigned char >( 10 * generator->GetIntegerVariate( 5 ) );
+    }
+  itk::ImageRegionIteratorWithIndex< ImageType > it( input, input->GetBufferedRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    unsigned int block = 0;
+    for( unsigned int d = 0; d < VDimension; d++ )
+      {
+      block = block * 16 + it.GetIndex()[d] / 5 % 16;
+      }
+    it.Set( generator->GetVariate() < 0.05 ? static_cast< unsigned char >( generator->GetIntegerVariate( 50 ) )
+                                           : blocks[block % blocks.size()] );
+    }
+
+  using MaximaType = itk::ValuedRegionalMaximaImageFilter< ImageType, ImageType >;
+  typename MaximaType::Pointer maxima = MaximaType::New();
+  maxima->SetInput( input );
+  EXERCISE_BASIC_OBJECT_METHODS( maxima, ValuedRegionalMaximaImageFilter, ValuedRegionalExtremaImageFilter );
+  TEST_SET_GET_BOOLEAN( maxima, FullyConnected, false );
+  using MinimaType = itk::ValuedRegionalMinimaImageFilter< ImageType, ImageType >;
+  typename MinimaType::Pointer minima = MinimaType::New();
+  minima->SetInput( input );
+
+  bool passed = true;
+  for( unsigned int fullyConnected = 0; fullyConnected < 2; fullyConnected++ )
+    {
+    const std::string connectivity = fullyConnected ? "fully connected" : "face connected";
+
+    maxima->SetFullyConnected( fullyConnected );
+    typename ImageType::Pointer expected =
+      Reference< ImageType, std::greater< unsigned char > >( input, fullyConnected, maxima->GetMarkerValue() );
+    passed &= SameForAllThreads( maxima.GetPointer(), expected.GetPointer(), "maxima, " + connectivity );
+    TEST_EXPECT_TRUE( !maxima->GetFlat() );
+
+    minima->SetFullyConnected( fullyConnected );
+    expected = Reference< ImageType, std::less< unsigned char > >( input, fullyConnected, minima->GetMarkerValue() );
+    passed &= SameForAllThreads( minima.GetPointer(), expected.GetPointer(), "minima, " + connectivity );
+
+    // a marker value in the range of the image
+    maxima->SetMarkerValue( 20 );
+    expected = Reference< ImageType, std::greater< unsigned char > >( input, fullyConnected, 20 );
+    passed &= SameForAllThreads( maxima.GetPointer(), expected.GetPointer(), "maxima with marker 20, " + connectivity );
+    maxima->SetMarkerValue( itk::NumericTraits< unsigned char >::NonpositiveMin() );
+
+    // the filters built on it
+    using RegionalMaximaType = itk::RegionalMaximaImageFilter< ImageType, ImageType >;
+    typename RegionalMaximaType::Pointer regionalMaxima = RegionalMaximaType::New();
+    regionalMaxima->SetInput( input );
+    regionalMaxima->SetFullyConnected( fullyConnected );
+    regionalMaxima->SetNumberOfThreads( 1 );
+    TRY_EXPECT_NO_EXCEPTION( regionalMaxima->Update() );
+    expected = regionalMaxima->GetOutput();
+    expected->DisconnectPipeline();
+    passed &= SameForAllThreads( regionalMaxima.GetPointer(), expected.GetPointer(), "regional maxima, " + connectivity );
+    }
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int itkValuedRegionalExtremaImageFilterTest( int, char * [] )
+{
+  itk::Size< 2 > size2D = {{ 157, 133 }};
+  if( ValuedRegionalExtrema< 2 >( size2D ) == EXIT_FAILURE )
+    {
+    std::cerr << "2D Fails" << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::Size< 3 > size3D = {{ 41, 37, 29 }};
+  if( ValuedRegionalExtrema< 3 >( size3D ) == EXIT_FAILURE )
+    {
+    std::cerr << "3D Fails" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,189 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkGrayscaleDilateImageFilter.h"
+#include "itkGrayscaleErodeImageFilter.h"
+#include "itkGrayscaleMorphologicalClosingImageFilter.h"
+#include "itkGrayscaleMorphologicalOpeningImageFilter.h"
+#include "itkFlatStructuringElement.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+// The van Herk/Gil-Werman filters process the lines of a face by groups.
+// Check them for line lengths and image sizes which do not match the size
+// of the groups, along the axes and along oblique directions. Boxes are
+// compared with the basic algorithm; the decomposition of the polygons
+// is not exact at the image border, so they are compared with the anchor
+// algorithm, which uses the same decomposition. The van Herk/Gil-Werman
+// openings and closings are compared with the erosions and dilations they
+// are made of.
+namespace
+{
+
+template< typename TImage >
+int CompareImages( const TImage * image, const TImage * reference, const char * className, const char * name )
+{
+  itk::ImageRegionConstIteratorWithIndex< TImage > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    if ( it.Get() != reference->GetPixel( it.GetIndex() ) )
+      {
+      std::cerr << className << " with " << name << ": wrong value at " << it.GetIndex() << ": "
+                << +it.Get() << " instead of " << +reference->GetPixel( it.GetIndex() ) << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+template< typename TFilter >
+int CompareWithReference( typename TFilter::InputImageType * image,
+                          const typename TFilter::KernelType & kernel,
+                          int referenceAlgorithm,
+                          const char * name )
+{
+  typename TFilter::Pointer reference = TFilter::New();
+  reference->SetInput( image );
+  reference->SetKernel( kernel );
+  reference->SetAlgorithm( referenceAlgorithm );
+  TRY_EXPECT_NO_EXCEPTION( reference->Update() );
+
+  typename TFilter::Pointer vhgw = TFilter::New();
+  vhgw->SetInput( image );
+  vhgw->SetKernel( kernel );
+  vhgw->SetAlgorithm( TFilter::VHGW );
+  TRY_EXPECT_NO_EXCEPTION( vhgw->Update() );
+
+  return CompareImages( vhgw->GetOutput(), reference->GetOutput(), vhgw->GetNameOfClass(), name );
+}
+
+// The van Herk/Gil-Werman opening or closing, without the safe border, is
+// the chain of the two filters with their default algorithms.
+template< typename TFilter, typename TFirst, typename TSecond >
+int CompareWithChain( typename TFilter::InputImageType * image,
+                      const typename TFilter::KernelType & kernel,
+                      const char * name )
+{
+  typename TFirst::Pointer first = TFirst::New();
+  first->SetInput( image );
+  first->SetKernel( kernel );
+  typename TSecond::Pointer second = TSecond::New();
+  second->SetInput( first->GetOutput() );
+  second->SetKernel( kernel );
+  TRY_EXPECT_NO_EXCEPTION( second->Update() );
+
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput( image );
+  filter->SetKernel( kernel );
+  filter->SetAlgorithm( TFilter::VHGW );
+  filter->SetSafeBorder( false );
+  TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+
+  return CompareImages( filter->GetOutput(), second->GetOutput(), filter->GetNameOfClass(), name );
+}
+
+template< typename TPixel, unsigned int VDimension >
+int TestImageType( const typename itk::Image< TPixel, VDimension >::SizeType & size )
+{
+  using ImageType = itk::Image< TPixel, VDimension >;
+  using KernelType = itk::FlatStructuringElement< VDimension >;
+  using DilateType = itk::GrayscaleDilateImageFilter< ImageType, ImageType, KernelType >;
+  using ErodeType = itk::GrayscaleErodeImageFilter< ImageType, ImageType, KernelType >;
+  using OpeningType = itk::GrayscaleMorphologicalOpeningImageFilter< ImageType, ImageType, KernelType >;
+  using ClosingType = itk::GrayscaleMorphologicalClosingImageFilter< ImageType, ImageType, KernelType >;
+
+  typename ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 2018 );
+  itk::ImageRegionIterator< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    it.Set( static_cast< TPixel >( generator->GetIntegerVariate( 250 ) ) );
+    }
+
+  typename KernelType::RadiusType radius;
+  for ( unsigned int d = 0; d < VDimension; ++d )
+    {
+    radius[d] = d + 1;
+    }
+  const KernelType box = KernelType::Box( radius );
+  radius.Fill( 3 );
+  const KernelType polygon = KernelType::Polygon( radius, VDimension == 2 ? 3 : 7 );
+  radius.Fill( VDimension == 2 ? 9 : 5 );
+  const KernelType longPolygon = KernelType::Polygon( radius, VDimension == 2 ? 2 : 6 );
+
+  // the decomposable kernels use the van Herk/Gil-Werman algorithm by
+  // default, except in the openings and closings
+  typename DilateType::Pointer dilate = DilateType::New();
+  dilate->SetKernel( polygon );
+  TEST_EXPECT_EQUAL( dilate->GetAlgorithm(), static_cast< int >( DilateType::VHGW ) );
+  typename ErodeType::Pointer erode = ErodeType::New();
+  erode->SetKernel( box );
+  TEST_EXPECT_EQUAL( erode->GetAlgorithm(), static_cast< int >( ErodeType::VHGW ) );
+  typename OpeningType::Pointer opening = OpeningType::New();
+  opening->SetKernel( polygon );
+  TEST_EXPECT_EQUAL( opening->GetAlgorithm(), static_cast< int >( OpeningType::ANCHOR ) );
+  typename ClosingType::Pointer closing = ClosingType::New();
+  closing->SetKernel( box );
+  TEST_EXPECT_EQUAL( closing->GetAlgorithm(), static_cast< int >( ClosingType::ANCHOR ) );
+
+  const KernelType * kernels[] = { &box, &polygon, &longPolygon };
+  const int          references[] = { DilateType::BASIC, DilateType::ANCHOR, DilateType::ANCHOR };
+  const char *       names[] = { "box", "polygon", "long polygon" };
+  for ( unsigned int k = 0; k < 3; ++k )
+    {
+    if ( CompareWithReference< DilateType >( image, *kernels[k], references[k], names[k] ) != EXIT_SUCCESS
+         || CompareWithReference< ErodeType >( image, *kernels[k], references[k], names[k] ) != EXIT_SUCCESS
+         || CompareWithChain< OpeningType, ErodeType, DilateType >( image, *kernels[k], names[k] ) != EXIT_SUCCESS
+         || CompareWithChain< ClosingType, DilateType, ErodeType >( image, *kernels[k], names[k] ) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+}
+
+int itkVanHerkGilWermanBatchedLinesTest( int, char *[] )
+{
+  itk::Size< 2 > size2D;
+  size2D[0] = 53;
+  size2D[1] = 37;
+  itk::Size< 3 > size3D;
+  size3D[0] = 21;
+  size3D[1] = 18;
+  size3D[2] = 13;
+
+  if ( TestImageType< unsigned char, 2 >( size2D ) != EXIT_SUCCESS
+       || TestImageType< float, 2 >( size2D ) != EXIT_SUCCESS
+       || TestImageType< unsigned char, 3 >( size3D ) != EXIT_SUCCESS
+       || TestImageType< float, 3 >( size3D ) != EXIT_SUCCESS )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,176 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkAdaptiveStochasticGradientDescentOptimizerv4_h
+#define itkAdaptiveStochasticGradientDescentOptimizerv4_h
+
+#include "itkGradientDescentOptimizerv4.h"
+
+namespace itk
+{
+/** \class AdaptiveStochasticGradientDescentOptimizerv4Template
+ *  \brief Gradient descent optimizer with an adaptive decaying step size,
+ *  for metrics evaluated on a new random set of samples at each iteration.
+ *
+ * The learning rate is decayed with a "time" which advances when the
+ * optimization oscillates, following the adaptive stochastic gradient
+ * descent (ASGD) of Klein et al. At iteration k, the position is updated
+ * according to
+ *
+ * \f[
+ *        p_{k+1} = p_k + \mbox{learningRate} \, \left( \frac{A}{t_k + A} \right)^{\alpha}
+ *                  \, \frac{\partial f(p_k) }{\partial p_k}
+ * \f]
+ *
+ * and the time is updated from the gradients of the current and of the
+ * previous iterations with
+ *
+ * \f[
+ *        t_{k+1} = \max \left( 0, t_k + \mbox{sigmoid}( -\cos( g_k, g_{k-1} ) ) \right)
+ * \f]
+ *
+ * The time advances by up to SigmoidMaximum when consecutive gradients
+ * point in opposite directions, so that the step size decreases when the
+ * optimization oscillates around the optimum, and it goes back by up to
+ * -SigmoidMinimum when they point in the same direction, so that the step
+ * size increases again while far from it. The sigmoid is
+ *
+ * \f[
+ *        \mbox{sigmoid}(x) = f_{min} + \frac{ f_{max} - f_{min} }{ 1 - \frac{f_{max}}{f_{min}} e^{-x / \omega} }
+ * \f]
+ *
+ * with \f$f_{min}\f$ the SigmoidMinimum, \f$f_{max}\f$ the SigmoidMaximum
+ * and \f$\omega\f$ the SigmoidScale. Unlike in the original method, the
+ * inner product of the gradients is normalized by their norms, so that
+ * the sigmoid scale does not depend on the magnitude of the metric
+ * derivative.
+ *
+ * The learning rate is the one of the superclass: it is set by the user or
+ * estimated with the scales estimator, and the time is restarted at each
+ * StartOptimization(). Since the metric values are noisy with a random set
+ * of samples, the optimization runs for the number of iterations, without
+ * convergence monitoring.
+ *
+ * \sa ImageRegistrationMethodv4::STOCHASTIC
+ *
+ * \ingroup ITKOptimizersv4
+ */
+template<typename TInternalComputationValueType>
+class ITK_TEMPLATE_EXPORT AdaptiveStochasticGradientDescentOptimizerv4Template
+: public GradientDescentOptimizerv4Template<TInternalComputationValueType>
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(AdaptiveStochasticGradientDescentOptimizerv4Template);
+
+  /** Standard class type aliases. */
+  using Self = AdaptiveStochasticGradientDescentOptimizerv4Template;
+  using Superclass = GradientDescentOptimizerv4Template<TInternalComputationValueType>;
+  using Pointer = SmartPointer< Self >;
+  using ConstPointer = SmartPointer< const Self >;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(AdaptiveStochasticGradientDescentOptimizerv4Template, Superclass);
+
+  /** New macro for creation of through a Smart Pointer   */
+  itkNewMacro(Self);
+
+  /** It should be possible to derive the internal computation type from the class object. */
+  using InternalComputationValueType = TInternalComputationValueType;
+
+  /** Derivative type */
+  using DerivativeType = typename Superclass::DerivativeType;
+
+  /** Metric type over which this class is templated */
+  using MeasureType = typename Superclass::MeasureType;
+  using IndexRangeType = typename Superclass::IndexRangeType;
+  using ParametersType = typename Superclass::ParametersType;
+
+  /** Set/Get the offset A of the time in the step size decay. Larger values
+   * decay the step size more slowly. Default is 20. */
+  itkSetMacro(LearningRateOffset, TInternalComputationValueType);
+  itkGetConstReferenceMacro(LearningRateOffset, TInternalComputationValueType);
+
+  /** Set/Get the exponent alpha of the step size decay. Default is 1. */
+  itkSetMacro(LearningRateDecay, TInternalComputationValueType);
+  itkGetConstReferenceMacro(LearningRateDecay, TInternalComputationValueType);
+
+  /** Set/Get the largest advance of the time in one iteration, when the
+   * gradients point in opposite directions. Must be positive. Default is 1. */
+  itkSetMacro(SigmoidMaximum, TInternalComputationValueType);
+  itkGetConstReferenceMacro(SigmoidMaximum, TInternalComputationValueType);
+
+  /** Set/Get the largest change of the time in one iteration when the
+   * gradients point in the same direction. Must be negative. Default is -0.8. */
+  itkSetMacro(SigmoidMinimum, TInternalComputationValueType);
+  itkGetConstReferenceMacro(SigmoidMinimum, TInternalComputationValueType);
+
+  /** Set/Get the scale of the sigmoid, relative to the cosine of the
+   * angle between the gradients. Must be positive. Default is 0.1. */
+  itkSetMacro(SigmoidScale, TInternalComputationValueType);
+  itkGetConstReferenceMacro(SigmoidScale, TInternalComputationValueType);
+
+  /** Get the current time of the step size decay. */
+  itkGetConstReferenceMacro(CurrentTime, TInternalComputationValueType);
+
+  /** Get the learning rate used at the current iteration, i.e. the learning
+   * rate decayed with the current time. */
+  itkGetConstReferenceMacro(CurrentLearningRate, TInternalComputationValueType);
+
+  /** Start and run the optimization. */
+  void StartOptimization( bool doOnlyInitialization = false ) override;
+
+  /** Estimate the learning rate as the superclass does, decay it with the
+   * current time, and advance the time. */
+  void EstimateLearningRate() override;
+
+protected:
+  /** Modify the gradient by the decayed learning rate over a given index range. */
+  void ModifyGradientByLearningRateOverSubRange( const IndexRangeType& subrange ) override;
+
+  /** Default constructor */
+  AdaptiveStochasticGradientDescentOptimizerv4Template();
+
+  /** Destructor */
+  ~AdaptiveStochasticGradientDescentOptimizerv4Template() override;
+
+  /** Clone the optimizer settings. */
+  typename LightObject::Pointer InternalClone() const override;
+
+  void PrintSelf( std::ostream & os, Indent indent ) const override;
+
+  /** The change of the time for the cosine of the angle between the
+   * gradients. */
+  TInternalComputationValueType Sigmoid( TInternalComputationValueType cosine ) const;
+
+  TInternalComputationValueType m_LearningRateOffset;
+  TInternalComputationValueType m_LearningRateDecay;
+  TInternalComputationValueType m_SigmoidMaximum;
+  TInternalComputationValueType m_SigmoidMinimum;
+  TInternalComputationValueType m_SigmoidScale;
+  TInternalComputationValueType m_CurrentTime;
+  TInternalComputationValueType m_CurrentLearningRate;
+};
+
+using AdaptiveStochasticGradientDescentOptimizerv4 = AdaptiveStochasticGradientDescentOptimizerv4Template<double>;
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkAdaptiveStochasticGradientDescentOptimizerv4.hxx"
+#endif
+
+#endif
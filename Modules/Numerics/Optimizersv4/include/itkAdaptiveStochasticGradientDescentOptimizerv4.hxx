@@ -0,0 +1,168 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkAdaptiveStochasticGradientDescentOptimizerv4_hxx
+#define itkAdaptiveStochasticGradientDescentOptimizerv4_hxx
+
+#include "itkAdaptiveStochasticGradientDescentOptimizerv4.h"
+
+namespace itk
+{
+
+template<typename TInternalComputationValueType>
+AdaptiveStochasticGradientDescentOptimizerv4Template<TInternalComputationValueType>
+::AdaptiveStochasticGradientDescentOptimizerv4Template() :
+  m_LearningRateOffset( 20.0 ),
+  m_LearningRateDecay( NumericTraits<TInternalComputationValueType>::OneValue() ),
+  m_SigmoidMaximum( NumericTraits<TInternalComputationValueType>::OneValue() ),
+  m_SigmoidMinimum( -0.8 ),
+  m_SigmoidScale( 0.1 ),
+  m_CurrentTime( NumericTraits<TInternalComputationValueType>::ZeroValue() ),
+  m_CurrentLearningRate( NumericTraits<TInternalComputationValueType>::OneValue() )
+{
+  // the metric values are noisy
+  this->m_UseConvergenceMonitoring = false;
+}
+
+template<typename TInternalComputationValueType>
+AdaptiveStochasticGradientDescentOptimizerv4Template<TInternalComputationValueType>
+::~AdaptiveStochasticGradientDescentOptimizerv4Template()
+{}
+
+template<typename TInternalComputationValueType>
+void
+AdaptiveStochasticGradientDescentOptimizerv4Template<TInternalComputationValueType>
+::StartOptimization( bool doOnlyInitialization )
+{
+  if( this->m_LearningRateOffset <= NumericTraits<TInternalComputationValueType>::ZeroValue() )
+    {
+    itkExceptionMacro( "LearningRateOffset must be positive." );
+    }
+  if( this->m_SigmoidMaximum <= NumericTraits<TInternalComputationValueType>::ZeroValue()
+      || this->m_SigmoidMinimum >= NumericTraits<TInternalComputationValueType>::ZeroValue() )
+    {
+    itkExceptionMacro( "SigmoidMaximum must be positive and SigmoidMinimum negative." );
+    }
+  if( this->m_SigmoidScale <= NumericTraits<TInternalComputationValueType>::ZeroValue() )
+    {
+    itkExceptionMacro( "SigmoidScale must be positive." );
+    }
+
+  this->m_CurrentTime = NumericTraits<TInternalComputationValueType>::ZeroValue();
+  this->m_CurrentLearningRate = this->m_LearningRate;
+
+  Superclass::StartOptimization( doOnlyInitialization );
+}
+
+template<typename TInternalComputationValueType>
+void
+AdaptiveStochasticGradientDescentOptimizerv4Template<TInternalComputationValueType>
+::EstimateLearningRate()
+{
+  Superclass::EstimateLearningRate();
+
+  this->m_CurrentLearningRate = this->m_LearningRate
+    * std::pow( this->m_LearningRateOffset / ( this->m_CurrentTime + this->m_LearningRateOffset ),
+                this->m_LearningRateDecay );
+
+  // At the first iteration, the previous gradient is the one of the
+  // previous optimization, if any. Otherwise, it holds the previous
+  // update, which is the previous scaled gradient times a positive
+  // learning rate.
+  if( this->m_CurrentIteration == 0 || this->m_PreviousGradient.Size() != this->m_Gradient.Size() )
+    {
+    return;
+    }
+  TInternalComputationValueType innerProduct = NumericTraits<TInternalComputationValueType>::ZeroValue();
+  TInternalComputationValueType squaredNorm = NumericTraits<TInternalComputationValueType>::ZeroValue();
+  TInternalComputationValueType previousSquaredNorm = NumericTraits<TInternalComputationValueType>::ZeroValue();
+  for( SizeValueType i = 0; i < this->m_Gradient.Size(); ++i )
+    {
+    innerProduct += this->m_Gradient[i] * this->m_PreviousGradient[i];
+    squaredNorm += this->m_Gradient[i] * this->m_Gradient[i];
+    previousSquaredNorm += this->m_PreviousGradient[i] * this->m_PreviousGradient[i];
+    }
+  if( squaredNorm > NumericTraits<TInternalComputationValueType>::ZeroValue()
+      && previousSquaredNorm > NumericTraits<TInternalComputationValueType>::ZeroValue() )
+    {
+    const TInternalComputationValueType cosine = innerProduct / std::sqrt( squaredNorm * previousSquaredNorm );
+    this->m_CurrentTime = std::max( NumericTraits<TInternalComputationValueType>::ZeroValue(),
+                                    this->m_CurrentTime + this->Sigmoid( cosine ) );
+    }
+}
+
+template<typename TInternalComputationValueType>
+TInternalComputationValueType
+AdaptiveStochasticGradientDescentOptimizerv4Template<TInternalComputationValueType>
+::Sigmoid( TInternalComputationValueType cosine ) const
+{
+  // 0 for orthogonal gradients, up to the maximum for opposite ones
+  return this->m_SigmoidMinimum + ( this->m_SigmoidMaximum - this->m_SigmoidMinimum )
+    / ( NumericTraits<TInternalComputationValueType>::OneValue()
+        - ( this->m_SigmoidMaximum / this->m_SigmoidMinimum ) * std::exp( cosine / this->m_SigmoidScale ) );
+}
+
+template<typename TInternalComputationValueType>
+void
+AdaptiveStochasticGradientDescentOptimizerv4Template<TInternalComputationValueType>
+::ModifyGradientByLearningRateOverSubRange( const IndexRangeType& subrange )
+{
+  // Loop over the range. It is inclusive.
+  for ( IndexValueType j = subrange[0]; j <= subrange[1]; j++ )
+    {
+    this->m_Gradient[j] = this->m_Gradient[j] * this->m_CurrentLearningRate;
+    }
+}
+
+template<typename TInternalComputationValueType>
+typename LightObject::Pointer
+AdaptiveStochasticGradientDescentOptimizerv4Template<TInternalComputationValueType>
+::InternalClone() const
+{
+  typename LightObject::Pointer loPtr = Superclass::InternalClone();
+
+  typename Self::Pointer rval = dynamic_cast<Self *>( loPtr.GetPointer() );
+  if( rval.IsNull() )
+    {
+    itkExceptionMacro(<< "downcast to type " << this->GetNameOfClass() << " failed.");
+    }
+  rval->m_LearningRateOffset = this->m_LearningRateOffset;
+  rval->m_LearningRateDecay = this->m_LearningRateDecay;
+  rval->m_SigmoidMaximum = this->m_SigmoidMaximum;
+  rval->m_SigmoidMinimum = this->m_SigmoidMinimum;
+  rval->m_SigmoidScale = this->m_SigmoidScale;
+  return loPtr;
+}
+
+template<typename TInternalComputationValueType>
+void
+AdaptiveStochasticGradientDescentOptimizerv4Template<TInternalComputationValueType>
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "LearningRateOffset: " << this->m_LearningRateOffset << std::endl;
+  os << indent << "LearningRateDecay: " << this->m_LearningRateDecay << std::endl;
+  os << indent << "SigmoidMaximum: " << this->m_SigmoidMaximum << std::endl;
+  os << indent << "SigmoidMinimum: " << this->m_SigmoidMinimum << std::endl;
+  os << indent << "SigmoidScale: " << this->m_SigmoidScale << std::endl;
+  os << indent << "CurrentTime: " << this->m_CurrentTime << std::endl;
+  os << indent << "CurrentLearningRate: " << this->m_CurrentLearningRate << std::endl;
+}
+}//namespace itk
+
+#endif
@@ -172,6 +172,10 @@ protected:
   GradientDescentOptimizerBasev4Template();
   ~GradientDescentOptimizerBasev4Template() override;
 
+  /** Clone the optimizer settings, including the learning rate estimation
+   * and convergence monitoring settings. */
+  typename LightObject::Pointer InternalClone() const override;
+
   /** Flag to control use of the ScalesEstimator (if set) for
    * automatic learning step estimation at *each* iteration.
    */
@@ -96,6 +96,26 @@ GradientDescentOptimizerBasev4Template<TInternalComputationValueType>
     << std::endl;
 }
 
+//-------------------------------------------------------------------
+template<typename TInternalComputationValueType>
+typename LightObject::Pointer
+GradientDescentOptimizerBasev4Template<TInternalComputationValueType>
+::InternalClone() const
+{
+  typename LightObject::Pointer loPtr = Superclass::InternalClone();
+
+  typename Self::Pointer rval = dynamic_cast<Self *>( loPtr.GetPointer() );
+  if( rval.IsNull() )
+    {
+    itkExceptionMacro(<< "downcast to type " << this->GetNameOfClass() << " failed.");
+    }
+  rval->m_DoEstimateLearningRateAtEachIteration = this->m_DoEstimateLearningRateAtEachIteration;
+  rval->m_DoEstimateLearningRateOnce = this->m_DoEstimateLearningRateOnce;
+  rval->m_MaximumStepSizeInPhysicalUnits = this->m_MaximumStepSizeInPhysicalUnits;
+  rval->m_UseConvergenceMonitoring = this->m_UseConvergenceMonitoring;
+  rval->m_ConvergenceWindowSize = this->m_ConvergenceWindowSize;
+  return loPtr;
+}
 
 //-------------------------------------------------------------------
 template<typename TInternalComputationValueType>
@@ -214,6 +214,11 @@ protected:
   /** Destructor */
   ~GradientDescentOptimizerv4Template() override;
 
+  /** Clone the optimizer settings. The current learning rate is copied, so
+   * that a learning rate estimated by this optimizer is used by the clone,
+   * which has no scales estimator. */
+  typename LightObject::Pointer InternalClone() const override;
+
   void PrintSelf( std::ostream & os, Indent indent ) const override;
 
 
@@ -20,6 +20,8 @@
 
 #include "itkObjectToObjectOptimizerBase.h"
 #include "itkGradientDescentOptimizerv4.h"
+#include "itkMultiThreaderBase.h"
+#include <atomic>
 
 namespace itk
 {
@@ -34,6 +36,24 @@ namespace itk
    *   focus modifying the parameter sample space.  This is why we place the burden on the user to provide
    *   the parameter samples over which to optimize.
    *
+   *   The starts can be optimized concurrently, by setting NumberOfConcurrentStarts
+   *   to more than one. Each concurrent start is then optimized with a clone of the
+   *   metric and of the local optimizer, the starts being picked as tasks by the
+   *   threads of the multi-threader. Image metrics share their read-only images,
+   *   interpolators and gradient images with their clones, see ImageToImageMetricv4.
+   *   The metric must be initialized and its class must support Clone(). Since the
+   *   scales estimator of the local optimizer refers to the metric, it is only used
+   *   by the first start, which is optimized first: the other starts use the scales
+   *   and the learning rate estimated for it. The observers of the local optimizer
+   *   are not invoked for the concurrent starts, and the iteration events of this
+   *   optimizer are invoked in order once all the starts have been optimized.
+   *
+   *   The starts can also be pruned, by setting NumberOfStartsToOptimize: the
+   *   metric, or a cheaper PruningMetric evaluated e.g. on a coarse level of the
+   *   images, is evaluated at every start, and only the starts with the best
+   *   values are optimized. The pruned starts are left out of the metric values
+   *   list, like the starts whose optimization failed.
+   *
    * \ingroup ITKOptimizersv4
    */
 template<typename TInternalComputationValueType>
@@ -133,6 +153,27 @@ public:
 
   inline ParameterListSizeType GetBestParametersIndex( ) { return this->m_BestParametersIndex; }
 
+  /** Set/Get the number of starts optimized concurrently, each with its own
+   * clone of the metric and of the local optimizer. Defaults to 1, i.e. the
+   * starts are optimized one after another with the metric. At most
+   * MultiThreaderBase::GetGlobalDefaultNumberOfThreads() starts are
+   * optimized at once. */
+  itkSetClampMacro( NumberOfConcurrentStarts, ThreadIdType, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfConcurrentStarts, ThreadIdType );
+
+  /** Set/Get the number of starts to optimize. When it is non-zero and less
+   * than the number of starts, the starts are pruned: only the ones with the
+   * best values of the pruning metric are optimized. Defaults to 0, i.e. all
+   * the starts are optimized. */
+  itkSetMacro( NumberOfStartsToOptimize, ParameterListSizeType );
+  itkGetConstMacro( NumberOfStartsToOptimize, ParameterListSizeType );
+
+  /** Set/Get the initialized metric used to prune the starts, e.g. the metric
+   * evaluated on a coarse level of the images. Its parameters must match the
+   * ones of the metric. When it is not set, the metric itself is used. */
+  itkSetObjectMacro( PruningMetric, MetricType );
+  itkGetModifiableObjectMacro( PruningMetric, MetricType );
+
 protected:
   /** Default constructor */
   MultiStartOptimizerv4Template();
@@ -140,6 +181,43 @@ protected:
 
   void PrintSelf(std::ostream & os, Indent indent) const override;
 
+  /** Result of the optimization of a start. */
+  struct StartResultType
+    {
+    ParametersType Parameters;
+    MeasureType    Value;
+    bool           Succeeded;
+    };
+  using StartIndexListType = std::vector< ParameterListSizeType >;
+  using StartResultListType = std::vector< StartResultType >;
+
+  /** Optimize the given starts with the metric and the local optimizer, which
+   * can be nullptr to only evaluate the metric, concurrently when
+   * NumberOfConcurrentStarts is more than one. */
+  void OptimizeStarts( MetricType * metric, OptimizerType * localOptimizer, const StartIndexListType & starts,
+                       StartResultListType & results );
+
+  /** Select the starts to optimize among the remaining ones, pruning the
+   * others when NumberOfStartsToOptimize is set. */
+  void SelectStarts( std::vector< bool > & selectedStarts );
+
+  /** Optimize a start from the given parameters, and return the optimized
+   * parameters and metric value. */
+  static void OptimizeStart( MetricType * metric, OptimizerType * localOptimizer, ParametersType & parameters,
+                             MeasureType & value );
+
+  /** Data of the threads optimizing the starts concurrently. */
+  struct ConcurrentStartsStruct
+    {
+    std::vector< MetricTypePointer >    Metrics;
+    std::vector< OptimizerPointer >     LocalOptimizers;
+    StartResultListType *               Results;
+    std::atomic< SizeValueType >        NextStart;
+    };
+
+  /** Optimize the starts picked by a thread. */
+  static ITK_THREAD_RETURN_TYPE ConcurrentStartsThreaderCallback( void * arg );
+
   /* Common variables for optimization control and reporting */
   bool                          m_Stop;
   StopConditionType             m_StopCondition;
@@ -150,6 +228,9 @@ protected:
   MeasureType                   m_MaximumMetricValue;
   ParameterListSizeType         m_BestParametersIndex;
   OptimizerPointer              m_LocalOptimizer;
+  ThreadIdType                  m_NumberOfConcurrentStarts;
+  ParameterListSizeType         m_NumberOfStartsToOptimize;
+  MetricTypePointer             m_PruningMetric;
 };
 
 /** This helps to meet backward compatibility */
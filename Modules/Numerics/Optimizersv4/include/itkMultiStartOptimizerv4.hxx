@@ -19,6 +19,8 @@
 #define itkMultiStartOptimizerv4_hxx
 
 #include "itkMultiStartOptimizerv4.h"
+#include <algorithm>
+#include <numeric>
 
 namespace itk
 {
@@ -27,7 +29,9 @@ namespace itk
 template<typename TInternalComputationValueType>
 MultiStartOptimizerv4Template<TInternalComputationValueType>
 ::MultiStartOptimizerv4Template():
-  m_Stop(false)
+  m_Stop(false),
+  m_NumberOfConcurrentStarts(1),
+  m_NumberOfStartsToOptimize(0)
 {
   this->m_NumberOfIterations = static_cast<SizeValueType>(0);
   this->m_StopCondition      = MAXIMUM_NUMBER_OF_ITERATIONS;
@@ -54,6 +58,9 @@ MultiStartOptimizerv4Template<TInternalComputationValueType>
   Superclass::PrintSelf(os, indent);
   os << indent << "Stop condition:"<< this->m_StopCondition << std::endl;
   os << indent << "Stop condition description: " << this->m_StopConditionDescription.str()  << std::endl;
+  os << indent << "Number of concurrent starts: " << this->m_NumberOfConcurrentStarts << std::endl;
+  os << indent << "Number of starts to optimize: " << this->m_NumberOfStartsToOptimize << std::endl;
+  itkPrintSelfObjectMacro( PruningMetric );
 }
 
 //-------------------------------------------------------------------
@@ -177,35 +184,75 @@ MultiStartOptimizerv4Template<TInternalComputationValueType>
   this->m_StopConditionDescription << this->GetNameOfClass() << ": ";
   this->InvokeEvent( StartEvent() );
 
-  this->m_Stop = false;
-  while( ! this->m_Stop )
+  std::vector< bool > selectedStarts;
+  this->SelectStarts( selectedStarts );
+
+  /* When the starts are optimized concurrently, they are all optimized
+   * first, and their results are then processed in order. */
+  const bool concurrent = this->m_NumberOfConcurrentStarts > 1;
+  StartResultListType results;
+  if( concurrent )
     {
-    /* Compute metric value */
-    try
+    StartIndexListType starts;
+    for( ParameterListSizeType i = this->m_CurrentIteration; i < this->m_NumberOfIterations; ++i )
       {
-      this->m_Metric->SetParameters( this->m_ParametersList[ this->m_CurrentIteration ] );
-      if (  this->m_LocalOptimizer )
+      if( selectedStarts[i] )
         {
-        this->m_LocalOptimizer->SetMetric( this->m_Metric );
-        this->m_LocalOptimizer->StartOptimization();
-        this->m_ParametersList[this->m_CurrentIteration] = this->m_Metric->GetParameters();
+        starts.push_back( i );
         }
-      this->m_CurrentMetricValue = this->m_Metric->GetValue();
-      this->m_MetricValuesList.push_back(this->m_CurrentMetricValue);
-      }
-    catch ( ExceptionObject & )
-      {
-      /** We simply ignore this exception because it may just be a bad starting point.
-       *  We hope that other start points are better.
-       */
-      itkWarningMacro("An exception occurred in sub-optimization number " << this->m_CurrentIteration << ".  If too many of these occur, you may need to set a different set of initial parameters.");
       }
+    this->OptimizeStarts( this->m_Metric, this->m_LocalOptimizer, starts, results );
+    }
+  typename StartResultListType::const_iterator result = results.begin();
 
-    if ( this->m_CurrentMetricValue <  this->m_MinimumMetricValue )
+  this->m_Stop = false;
+  while( ! this->m_Stop )
+    {
+    if( selectedStarts[ this->m_CurrentIteration ] )
       {
-      this->m_MinimumMetricValue=this->m_CurrentMetricValue;
-      this->m_BestParametersIndex = this->m_CurrentIteration;
+      bool succeeded = false;
+      if( concurrent )
+        {
+        succeeded = result->Succeeded;
+        if( succeeded )
+          {
+          this->m_ParametersList[this->m_CurrentIteration] = result->Parameters;
+          this->m_CurrentMetricValue = result->Value;
+          }
+        ++result;
+        }
+      else
+        {
+        /* Compute metric value */
+        try
+          {
+          OptimizeStart( this->m_Metric, this->m_LocalOptimizer, this->m_ParametersList[ this->m_CurrentIteration ],
+                         this->m_CurrentMetricValue );
+          succeeded = true;
+          }
+        catch ( ExceptionObject & )
+          {
+          }
+        }
+
+      if( succeeded )
+        {
+        this->m_MetricValuesList.push_back(this->m_CurrentMetricValue);
+        if ( this->m_CurrentMetricValue <  this->m_MinimumMetricValue )
+          {
+          this->m_MinimumMetricValue=this->m_CurrentMetricValue;
+          this->m_BestParametersIndex = this->m_CurrentIteration;
+          }
+        }
+      else
+        {
+        /** We simply ignore this exception because it may just be a bad starting point.
+         *  We hope that other start points are better.
+         */
+        itkWarningMacro("An exception occurred in sub-optimization number " << this->m_CurrentIteration << ".  If too many of these occur, you may need to set a different set of initial parameters.");
+        }
       }
+
     /* Check if optimization has been stopped externally.
      * (Presumably this could happen from a multi-threaded client app?) */
     if ( this->m_Stop )
@@ -230,6 +277,170 @@ MultiStartOptimizerv4Template<TInternalComputationValueType>
     } //while (!m_Stop)
 }
 
+//-------------------------------------------------------------------
+template<typename TInternalComputationValueType>
+void
+MultiStartOptimizerv4Template<TInternalComputationValueType>
+::SelectStarts( std::vector< bool > & selectedStarts )
+{
+  selectedStarts.assign( this->m_NumberOfIterations, true );
+
+  const ParameterListSizeType numberOfRemainingStarts = this->m_NumberOfIterations - this->m_CurrentIteration;
+  if( this->m_NumberOfStartsToOptimize == 0 || this->m_NumberOfStartsToOptimize >= numberOfRemainingStarts )
+    {
+    return;
+    }
+
+  /* Evaluate the pruning metric at the remaining starts. */
+  StartIndexListType starts( numberOfRemainingStarts );
+  std::iota( starts.begin(), starts.end(), static_cast<ParameterListSizeType>( this->m_CurrentIteration ) );
+  MetricType * pruningMetric = this->m_PruningMetric.IsNotNull() ? this->m_PruningMetric.GetPointer()
+                                                                 : this->m_Metric.GetPointer();
+  StartResultListType results;
+  this->OptimizeStarts( pruningMetric, nullptr, starts, results );
+
+  /* Keep the starts with the best values. The starts whose evaluation
+   * failed come last. */
+  StartIndexListType order( starts.size() );
+  std::iota( order.begin(), order.end(), static_cast<ParameterListSizeType>( 0 ) );
+  std::stable_sort( order.begin(), order.end(),
+    [&results]( ParameterListSizeType a, ParameterListSizeType b )
+    {
+    if( results[a].Succeeded != results[b].Succeeded )
+      {
+      return results[a].Succeeded;
+      }
+    return results[a].Succeeded && results[a].Value < results[b].Value;
+    } );
+  for( ParameterListSizeType k = this->m_NumberOfStartsToOptimize; k < order.size(); ++k )
+    {
+    selectedStarts[ starts[ order[k] ] ] = false;
+    }
+}
+
+//-------------------------------------------------------------------
+template<typename TInternalComputationValueType>
+void
+MultiStartOptimizerv4Template<TInternalComputationValueType>
+::OptimizeStarts( MetricType * metric, OptimizerType * localOptimizer, const StartIndexListType & starts,
+                  StartResultListType & results )
+{
+  results.resize( starts.size() );
+  for( ParameterListSizeType k = 0; k < starts.size(); ++k )
+    {
+    results[k].Parameters = this->m_ParametersList[ starts[k] ];
+    results[k].Value = NumericTraits<MeasureType>::max();
+    results[k].Succeeded = false;
+    }
+
+  /* The scales estimator of the local optimizer refers to the metric, so
+   * the first start is optimized with them, and the clones of the local
+   * optimizer use the scales and learning rate estimated for it. */
+  ParameterListSizeType numberOfSerialStarts = starts.size();
+  if( this->m_NumberOfConcurrentStarts > 1 )
+    {
+    numberOfSerialStarts = ( localOptimizer != nullptr && localOptimizer->GetScalesEstimator() != nullptr ) ? 1 : 0;
+    }
+  for( ParameterListSizeType k = 0; k < std::min( numberOfSerialStarts, starts.size() ); ++k )
+    {
+    try
+      {
+      OptimizeStart( metric, localOptimizer, results[k].Parameters, results[k].Value );
+      results[k].Succeeded = true;
+      }
+    catch ( ExceptionObject & )
+      {
+      }
+    }
+  if( numberOfSerialStarts >= starts.size() )
+    {
+    return;
+    }
+
+  /* Optimize the other starts concurrently, with a clone of the metric and
+   * of the local optimizer per thread. The metrics run their own threads
+   * within these ones: with the pool threader, at least one thread of the
+   * pool is left for them, or they would wait forever. */
+  const ThreadIdType numberOfConcurrentStarts = std::min( this->m_NumberOfConcurrentStarts,
+                                                          MultiThreaderBase::GetGlobalDefaultNumberOfThreads() );
+  MultiThreaderBase::Pointer multiThreader = MultiThreaderBase::New();
+  multiThreader->SetNumberOfThreads( static_cast<ThreadIdType>(
+    std::min< ParameterListSizeType >( numberOfConcurrentStarts, starts.size() - numberOfSerialStarts ) ) );
+
+  ConcurrentStartsStruct str;
+  str.Results = &results;
+  str.NextStart = numberOfSerialStarts;
+  for( ThreadIdType threadId = 0; threadId < multiThreader->GetNumberOfThreads(); ++threadId )
+    {
+    MetricTypePointer metricClone = dynamic_cast<MetricType *>( metric->Clone().GetPointer() );
+    if( metricClone.IsNull() )
+      {
+      itkExceptionMacro( "The metric " << metric->GetNameOfClass() << " could not be cloned." );
+      }
+    metricClone->Initialize();
+    str.Metrics.push_back( metricClone );
+
+    OptimizerPointer localOptimizerClone;
+    if( localOptimizer != nullptr )
+      {
+      localOptimizerClone = dynamic_cast<OptimizerType *>( localOptimizer->Clone().GetPointer() );
+      if( localOptimizerClone.IsNull() )
+        {
+        itkExceptionMacro( "The local optimizer " << localOptimizer->GetNameOfClass() << " could not be cloned." );
+        }
+      }
+    str.LocalOptimizers.push_back( localOptimizerClone );
+    }
+
+  multiThreader->SetSingleMethod( this->ConcurrentStartsThreaderCallback, &str );
+  multiThreader->SingleMethodExecute();
+}
+
+//-------------------------------------------------------------------
+template<typename TInternalComputationValueType>
+ITK_THREAD_RETURN_TYPE
+MultiStartOptimizerv4Template<TInternalComputationValueType>
+::ConcurrentStartsThreaderCallback( void * arg )
+{
+  auto * threadInfo = static_cast<MultiThreaderBase::ThreadInfoStruct *>( arg );
+  auto * str = static_cast<ConcurrentStartsStruct *>( threadInfo->UserData );
+  const ThreadIdType threadId = threadInfo->ThreadID;
+  StartResultListType & results = *str->Results;
+
+  /* Pick the starts one at a time, so that the threads stay busy even when
+   * the local optimizations take different numbers of iterations. */
+  for( SizeValueType k = str->NextStart++; k < results.size(); k = str->NextStart++ )
+    {
+    try
+      {
+      OptimizeStart( str->Metrics[threadId], str->LocalOptimizers[threadId], results[k].Parameters, results[k].Value );
+      results[k].Succeeded = true;
+      }
+    catch ( ExceptionObject & )
+      {
+      /* A bad start, reported when the results are processed. */
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+//-------------------------------------------------------------------
+template<typename TInternalComputationValueType>
+void
+MultiStartOptimizerv4Template<TInternalComputationValueType>
+::OptimizeStart( MetricType * metric, OptimizerType * localOptimizer, ParametersType & parameters,
+                 MeasureType & value )
+{
+  metric->SetParameters( parameters );
+  if( localOptimizer != nullptr )
+    {
+    localOptimizer->SetMetric( metric );
+    localOptimizer->StartOptimization();
+    parameters = metric->GetParameters();
+    }
+  value = metric->GetValue();
+}
+
 } //namespace itk
 
 #endif
@@ -236,6 +236,27 @@ public:
    *  points will correspond to points within the point sets. */
   virtual bool SupportsArbitraryVirtualDomainSamples( void ) const = 0;
 
+  /** Moving-space points of the pixels of the virtual domain buffered
+   *  region, stored at the buffer offsets of the pixels. */
+  using MappedMovingPointsContainerType = std::vector<MovingOutputPointType>;
+
+  /** Returns a flag. True if the metric can evaluate the moving image at
+   *  virtual domain points mapped by another object, passed with
+   *  SetSharedMappedMovingPoints(). False by default. */
+  virtual bool SupportsSharedMappedMovingPoints() const
+    {
+    return false;
+    }
+
+  /** Evaluate the moving object at these points, mapped with the current
+   *  moving transform, instead of mapping the virtual domain points. The
+   *  points are not copied, and must be reset to nullptr before the moving
+   *  transform or the virtual domain change. Ignored if
+   *  SupportsSharedMappedMovingPoints() is false. Used by
+   *  ObjectToObjectMultiMetricv4 to map the virtual domain once for all its
+   *  image metrics. */
+  virtual void SetSharedMappedMovingPoints( const MappedMovingPointsContainerType * itkNotUsed( points ) ) {}
+
   /** Return a timestamp relating to the virtual domain.
    * This returns the greater of the metric timestamp and the
    * virtual domain image timestamp. This allows us to
@@ -304,6 +325,13 @@ protected:
 
   void PrintSelf(std::ostream & os, Indent indent) const override;
 
+  /** Clone the metric. The fixed and moving transforms are cloned, so that
+   * the parameters of the clone can be changed independently of this metric,
+   * while the virtual domain and the gradient source are shared. Derived
+   * classes copy their own settings; the clone must be initialized before
+   * it is used. */
+  typename LightObject::Pointer InternalClone() const override;
+
   /** Verify that virtual domain and displacement field are the same size
    * and in the same physical space. */
   virtual void VerifyDisplacementFieldSizeAndPhysicalSpace();
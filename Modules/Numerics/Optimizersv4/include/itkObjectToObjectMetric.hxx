@@ -532,6 +532,35 @@ ObjectToObjectMetric<TFixedDimension, TMovingDimension, TVirtualImage, TParamete
   return true;
 }
 
+template<unsigned int TFixedDimension, unsigned int TMovingDimension, typename TVirtualImage,
+ typename TParametersValueType>
+typename LightObject::Pointer
+ObjectToObjectMetric<TFixedDimension, TMovingDimension, TVirtualImage, TParametersValueType>
+::InternalClone() const
+{
+  typename LightObject::Pointer loPtr = Superclass::InternalClone();
+
+  typename Self::Pointer rval = dynamic_cast<Self *>( loPtr.GetPointer() );
+  if( rval.IsNull() )
+    {
+    itkExceptionMacro(<< "downcast to type " << this->GetNameOfClass() << " failed.");
+    }
+  rval->m_FixedObject = this->m_FixedObject;
+  rval->m_MovingObject = this->m_MovingObject;
+  rval->m_GradientSource = this->m_GradientSource;
+  if( this->m_FixedTransform.IsNotNull() )
+    {
+    rval->m_FixedTransform = this->m_FixedTransform->Clone();
+    }
+  if( this->m_MovingTransform.IsNotNull() )
+    {
+    rval->m_MovingTransform = this->m_MovingTransform->Clone();
+    }
+  rval->m_VirtualImage = this->m_VirtualImage;
+  rval->m_UserHasSetVirtualDomain = this->m_UserHasSetVirtualDomain;
+  return loPtr;
+}
+
 template<unsigned int TFixedDimension, unsigned int TMovingDimension, typename TVirtualImage,
  typename TParametersValueType>
 void
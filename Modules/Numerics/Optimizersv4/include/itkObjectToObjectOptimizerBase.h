@@ -172,6 +172,7 @@ public:
    * \sa SetDoEstimateScales()
    */
   itkSetObjectMacro(ScalesEstimator, ScalesEstimatorType);
+  itkGetModifiableObjectMacro(ScalesEstimator, ScalesEstimatorType);
 
   /** Option to use ScalesEstimator for scales estimation.
    * The estimation is performed once at begin of
@@ -222,6 +223,12 @@ protected:
   ObjectToObjectOptimizerBaseTemplate();
   ~ObjectToObjectOptimizerBaseTemplate() override;
 
+  /** Clone the optimizer settings: the number of threads and iterations,
+   * the scales, the weights and the scales estimation flag. The metric and
+   * the scales estimator are not copied, so that the clone can be used with
+   * another metric concurrently with this optimizer. */
+  typename LightObject::Pointer InternalClone() const override;
+
   MetricTypePointer             m_Metric;
   ThreadIdType                  m_NumberOfThreads;
   SizeValueType                 m_CurrentIteration;
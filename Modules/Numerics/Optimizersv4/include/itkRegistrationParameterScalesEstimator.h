@@ -190,6 +190,22 @@ protected:
   /** Compute the transform Jacobian at a physical point. */
   void ComputeSquaredJacobianNorms( const VirtualPointType  & p, ParametersType & squareNorms);
 
+  /** Add the squared norms of the transform Jacobian at a physical point to
+   * \c squareNorms. With a sparse Jacobian, only the entries of its
+   * parameters are visited. */
+  void AddSquaredJacobianNorms( const VirtualPointType  & p, ParametersType & squareNorms);
+
+  /** Get the number of weights of each row of the sparse Jacobian of the
+   * transform, zero when the transform does not provide one. See
+   * Transform::ComputeSparseJacobianWithRespectToParameters. */
+  SizeValueType GetNumberOfSparseJacobianParameters();
+
+  /** Compute the sparse Jacobian of the transform at a physical point into
+   * \c m_SparseJacobianWeights and \c m_SparseJacobianParameterIndices, and
+   * return the number of weights of each row. The buffers are reused
+   * between the points. */
+  SizeValueType ComputeSparseJacobian( const VirtualPointType & p );
+
   /** Check if the transform being optimized has local support. */
   bool TransformHasLocalSupportForScalesEstimation();
 
@@ -259,6 +275,11 @@ protected:
 
   typename VirtualPointSetType::ConstPointer  m_VirtualDomainPointSet;
 
+  /** Buffers of the transform Jacobian, reused between the points. */
+  JacobianType                                m_Jacobian;
+  std::vector< typename TMetric::ParametersValueType >                  m_SparseJacobianWeights;
+  std::vector< typename MovingTransformType::NumberOfParametersType >   m_SparseJacobianParameterIndices;
+
   // the threadhold to decide if the number of random samples uses logarithm
   static constexpr SizeValueType    SizeOfSmallDomain = 1000;
 
@@ -289,39 +289,97 @@ template< typename TMetric >
 void
 RegistrationParameterScalesEstimator< TMetric >
 ::ComputeSquaredJacobianNorms( const VirtualPointType  & point, ParametersType & squareNorms )
+{
+  squareNorms.Fill( NumericTraits< typename ParametersType::ValueType >::ZeroValue() );
+  this->AddSquaredJacobianNorms( point, squareNorms );
+}
+
+/** Add the squared norms of the transform Jacobians w.r.t parameters at a point */
+template< typename TMetric >
+void
+RegistrationParameterScalesEstimator< TMetric >
+::AddSquaredJacobianNorms( const VirtualPointType  & point, ParametersType & squareNorms )
 {
   const SizeValueType numPara = this->GetNumberOfLocalParameters();
   const SizeValueType dim = this->GetDimension();
-  JacobianType jacobian(dim,numPara);
 
-  if (this->GetTransformForward())
+  const SizeValueType rowSize = this->GetNumberOfSparseJacobianParameters();
+  if (rowSize > 0)
     {
-    this->m_Metric->GetMovingTransform()->ComputeJacobianWithRespectToParameters(point, jacobian);
-
-    for (SizeValueType p=0; p<numPara; p++)
+    // Only visit the parameters of the sparse Jacobian. A parameter
+    // appears at most once in each row.
+    const SizeValueType numberOfWeights = this->ComputeSparseJacobian(point);
+    for (SizeValueType d=0; d<dim; d++)
       {
-      squareNorms[p] = NumericTraits< typename ParametersType::ValueType >::ZeroValue();
-      for (SizeValueType d=0; d<dim; d++)
+      for (SizeValueType k=0; k<numberOfWeights; k++)
         {
-        squareNorms[p] += jacobian[d][p] * jacobian[d][p];
+        const typename TMetric::ParametersValueType weight = this->m_SparseJacobianWeights[d * rowSize + k];
+        squareNorms[this->m_SparseJacobianParameterIndices[d * rowSize + k]] += weight * weight;
         }
       }
+    return;
+    }
+
+  if (this->GetTransformForward())
+    {
+    this->m_Metric->GetMovingTransform()->ComputeJacobianWithRespectToParameters(point, this->m_Jacobian);
     }
   else
     {
-    this->m_Metric->GetFixedTransform()->ComputeJacobianWithRespectToParameters(point, jacobian);
+    this->m_Metric->GetFixedTransform()->ComputeJacobianWithRespectToParameters(point, this->m_Jacobian);
+    }
 
-    for (SizeValueType p=0; p<numPara; p++)
+  for (SizeValueType p=0; p<numPara; p++)
+    {
+    for (SizeValueType d=0; d<dim; d++)
       {
-      squareNorms[p] = NumericTraits< typename ParametersType::ValueType >::ZeroValue();
-      for (SizeValueType d=0; d<dim; d++)
-        {
-        squareNorms[p] += jacobian[d][p] * jacobian[d][p];
-        }
+      squareNorms[p] += this->m_Jacobian[d][p] * this->m_Jacobian[d][p];
       }
     }
 }
 
+/** Get the number of weights of each row of the sparse transform Jacobian */
+template< typename TMetric >
+SizeValueType
+RegistrationParameterScalesEstimator< TMetric >
+::GetNumberOfSparseJacobianParameters()
+{
+  if (this->IsDisplacementFieldTransform())
+    {
+    return 0;
+    }
+  if (this->GetTransformForward())
+    {
+    return this->m_Metric->GetMovingTransform()->GetNumberOfSparseJacobianParameters();
+    }
+  else
+    {
+    return this->m_Metric->GetFixedTransform()->GetNumberOfSparseJacobianParameters();
+    }
+}
+
+/** Compute the sparse transform Jacobian at a point */
+template< typename TMetric >
+SizeValueType
+RegistrationParameterScalesEstimator< TMetric >
+::ComputeSparseJacobian( const VirtualPointType & point )
+{
+  const SizeValueType size = this->GetDimension() * this->GetNumberOfSparseJacobianParameters();
+  this->m_SparseJacobianWeights.resize(size);
+  this->m_SparseJacobianParameterIndices.resize(size);
+
+  if (this->GetTransformForward())
+    {
+    return this->m_Metric->GetMovingTransform()->ComputeSparseJacobianWithRespectToParameters(point,
+      this->m_SparseJacobianWeights.data(), this->m_SparseJacobianParameterIndices.data());
+    }
+  else
+    {
+    return this->m_Metric->GetFixedTransform()->ComputeSparseJacobianWithRespectToParameters(point,
+      this->m_SparseJacobianWeights.data(), this->m_SparseJacobianParameterIndices.data());
+    }
+}
+
 /** Sample the virtual domain with phyical points
  *  and store the results into this->m_SamplePoints.
  */
@@ -57,12 +57,7 @@ RegistrationParameterScalesFromJacobian< TMetric >
   // checking each sample point
   for (SizeValueType c=0; c<numSamples; c++)
     {
-    const VirtualPointType point = this->m_SamplePoints[c];
-
-    ParametersType squaredNorms(numPara);
-    this->ComputeSquaredJacobianNorms( point, squaredNorms );
-
-    norms = norms + squaredNorms;
+    this->AddSquaredJacobianNorms( this->m_SamplePoints[c], norms );
     } //for numSamples
 
   if (numSamples > 0)
@@ -159,6 +154,27 @@ RegistrationParameterScalesFromJacobian< TMetric >
 
   itk::Array<FloatType> dTdt(dim);
 
+  // With a sparse Jacobian, only visit its parameters.
+  const SizeValueType rowSize = this->GetNumberOfSparseJacobianParameters();
+  if (rowSize > 0)
+    {
+    for (SizeValueType c=0; c<numSamples; c++)
+      {
+      const SizeValueType numberOfWeights = this->ComputeSparseJacobian(this->m_SamplePoints[c]);
+      for (SizeValueType d=0; d<dim; d++)
+        {
+        dTdt[d] = NumericTraits<FloatType>::ZeroValue();
+        for (SizeValueType k=0; k<numberOfWeights; k++)
+          {
+          dTdt[d] += this->m_SparseJacobianWeights[d * rowSize + k]
+            * step[this->m_SparseJacobianParameterIndices[d * rowSize + k]];
+          }
+        }
+      sampleScales[c] = dTdt.two_norm();
+      }
+    return;
+    }
+
   JacobianType jacobianCache(dim,dim);
   JacobianType jacobian(dim,
                         (this->GetTransformForward() ?
@@ -128,6 +128,10 @@ protected:
   /** Destructor. */
   ~RegularStepGradientDescentOptimizerv4() override;
 
+  /** Clone the optimizer settings, including the relaxation factor,
+   * the minimum step length and the gradient magnitude tolerance. */
+  typename LightObject::Pointer InternalClone() const override;
+
   void PrintSelf( std::ostream & os, Indent indent ) const override;
 
 
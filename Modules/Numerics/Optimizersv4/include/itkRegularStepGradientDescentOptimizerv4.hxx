@@ -288,6 +288,25 @@ RegularStepGradientDescentOptimizerv4<TInternalComputationValueType>
 
     }
 }
+
+template<typename TInternalComputationValueType>
+typename LightObject::Pointer
+RegularStepGradientDescentOptimizerv4<TInternalComputationValueType>
+::InternalClone() const
+{
+  typename LightObject::Pointer loPtr = Superclass::InternalClone();
+
+  typename Self::Pointer rval = dynamic_cast<Self *>( loPtr.GetPointer() );
+  if( rval.IsNull() )
+    {
+    itkExceptionMacro(<< "downcast to type " << this->GetNameOfClass() << " failed.");
+    }
+  rval->m_RelaxationFactor = this->m_RelaxationFactor;
+  rval->m_MinimumStepLength = this->m_MinimumStepLength;
+  rval->m_GradientMagnitudeTolerance = this->m_GradientMagnitudeTolerance;
+  return loPtr;
+}
+
 template<typename TInternalComputationValueType>
 void
 RegularStepGradientDescentOptimizerv4<TInternalComputationValueType>
@@ -0,0 +1,209 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkAdaptiveStochasticGradientDescentOptimizerv4.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+/**
+ *  \class AdaptiveStochasticGradientDescentOptimizerv4TestMetric for test
+ *
+ *  The objective function is the quadratic form:
+ *
+ *  1/2 x^T A x - b^T x
+ *
+ *  Where A is a matrix and b is a vector
+ *  The system in this example is:
+ *
+ *     | 3  2 ||x|   | 2|   |0|
+ *     | 2  6 ||y| + |-8| = |0|
+ *
+ *
+ *   the solution is the vector | 2 -2 |
+ *
+ *  Uniform noise is added to the derivative, as for a metric evaluated on
+ *  a new random set of samples at each iteration.
+ */
+class AdaptiveStochasticGradientDescentOptimizerv4TestMetric
+  : public itk::ObjectToObjectMetricBase
+{
+public:
+
+  using Self = AdaptiveStochasticGradientDescentOptimizerv4TestMetric;
+  using Superclass = itk::ObjectToObjectMetricBase;
+  using Pointer = itk::SmartPointer<Self>;
+  using ConstPointer = itk::SmartPointer<const Self>;
+  itkNewMacro( Self );
+  itkTypeMacro( AdaptiveStochasticGradientDescentOptimizerv4TestMetric, ObjectToObjectMetricBase );
+
+  enum { SpaceDimension=2 };
+
+  using ParametersType = Superclass::ParametersType;
+  using ParametersValueType = Superclass::ParametersValueType;
+  using DerivativeType = Superclass::DerivativeType;
+  using MeasureType = Superclass::MeasureType;
+  using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+
+  AdaptiveStochasticGradientDescentOptimizerv4TestMetric()
+  {
+    m_Parameters.SetSize( SpaceDimension );
+    m_Parameters.Fill( 0 );
+    m_Generator = GeneratorType::New();
+    m_Generator->Initialize( 2018 );
+  }
+
+  void Initialize(void) throw ( itk::ExceptionObject ) override {}
+
+  void GetDerivative( DerivativeType & derivative ) const override
+  {
+    MeasureType value;
+    GetValueAndDerivative( value, derivative );
+  }
+
+  void GetValueAndDerivative( MeasureType & value,
+                              DerivativeType & derivative ) const override
+  {
+    if( derivative.Size() != 2 )
+      derivative.SetSize(2);
+
+    double x = m_Parameters[0];
+    double y = m_Parameters[1];
+
+    value = 0.5*(3*x*x+4*x*y+6*y*y) - 2*x + 8*y;
+
+    derivative[0] = -( 3 * x + 2 * y -2 ) + 8.0 * ( m_Generator->GetVariate() - 0.5 );
+    derivative[1] = -( 2 * x + 6 * y +8 ) + 8.0 * ( m_Generator->GetVariate() - 0.5 );
+  }
+
+  MeasureType  GetValue() const override
+  {
+    return 0.0;
+  }
+
+  void UpdateTransformParameters( const DerivativeType & update, ParametersValueType ) override
+  {
+    m_Parameters += update;
+  }
+
+  unsigned int GetNumberOfParameters(void) const override
+  {
+    return SpaceDimension;
+  }
+
+  bool HasLocalSupport() const override
+    {
+    return false;
+    }
+
+  unsigned int GetNumberOfLocalParameters() const override
+  {
+    return SpaceDimension;
+  }
+
+  void SetParameters( ParametersType & parameters ) override
+  {
+    m_Parameters = parameters;
+  }
+
+  const ParametersType & GetParameters() const override
+  {
+    return m_Parameters;
+  }
+
+private:
+
+  ParametersType         m_Parameters;
+  GeneratorType::Pointer m_Generator;
+};
+
+namespace
+{
+using OptimizerType = itk::AdaptiveStochasticGradientDescentOptimizerv4;
+
+// Optimize from the origin, and return the distance to the solution.
+double Optimize( OptimizerType * optimizer )
+{
+  AdaptiveStochasticGradientDescentOptimizerv4TestMetric::Pointer metric =
+    AdaptiveStochasticGradientDescentOptimizerv4TestMetric::New();
+  optimizer->SetMetric( metric );
+  optimizer->SetLearningRate( 0.25 );
+  optimizer->SetNumberOfIterations( 400 );
+  optimizer->StartOptimization();
+
+  const OptimizerType::ParametersType & position = optimizer->GetCurrentPosition();
+  const double distance = std::sqrt( ( position[0] - 2.0 ) * ( position[0] - 2.0 )
+                                     + ( position[1] + 2.0 ) * ( position[1] + 2.0 ) );
+  std::cout << "Offset " << optimizer->GetLearningRateOffset() << ": position " << position
+            << ", distance to the solution " << distance << ", time " << optimizer->GetCurrentTime()
+            << ", learning rate " << optimizer->GetCurrentLearningRate() << std::endl;
+  return distance;
+}
+}
+
+int itkAdaptiveStochasticGradientDescentOptimizerv4Test( int, char * [] )
+{
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+
+  EXERCISE_BASIC_OBJECT_METHODS( optimizer, AdaptiveStochasticGradientDescentOptimizerv4Template,
+                                 GradientDescentOptimizerv4Template );
+
+  TEST_SET_GET_VALUE( 20.0, optimizer->GetLearningRateOffset() );
+  TEST_SET_GET_VALUE( 1.0, optimizer->GetLearningRateDecay() );
+  TEST_SET_GET_VALUE( 1.0, optimizer->GetSigmoidMaximum() );
+  TEST_SET_GET_VALUE( -0.8, optimizer->GetSigmoidMinimum() );
+  TEST_SET_GET_VALUE( 0.1, optimizer->GetSigmoidScale() );
+
+  bool passed = true;
+
+  // The step size decays with the noisy derivative, and the position
+  // converges closer to the solution than with a constant step size.
+  const double adaptiveDistance = Optimize( optimizer );
+  if( optimizer->GetCurrentTime() <= 50.0 || optimizer->GetCurrentLearningRate() >= 0.1 )
+    {
+    std::cerr << "The step size did not decay" << std::endl;
+    passed = false;
+    }
+
+  OptimizerType::Pointer constantOptimizer = OptimizerType::New();
+  constantOptimizer->SetLearningRateOffset( 1e12 );
+  const double constantDistance = Optimize( constantOptimizer );
+  if( adaptiveDistance >= 0.25 || adaptiveDistance >= constantDistance )
+    {
+    std::cerr << "The adaptive step size did not get closer to the solution" << std::endl;
+    passed = false;
+    }
+
+  // The time is restarted, and a clone copies the settings.
+  optimizer->SetLearningRateOffset( 50.0 );
+  optimizer->SetSigmoidScale( 0.2 );
+  OptimizerType::Pointer clone = optimizer->Clone();
+  passed = passed && clone->GetLearningRateOffset() == 50.0 && clone->GetSigmoidScale() == 0.2
+           && clone->GetLearningRate() == 0.25;
+  optimizer->SetNumberOfIterations( 0 );
+  TRY_EXPECT_NO_EXCEPTION( optimizer->StartOptimization() );
+  TEST_EXPECT_EQUAL( optimizer->GetCurrentTime(), 0.0 );
+
+  // Invalid sigmoids
+  optimizer->SetSigmoidMinimum( 0.5 );
+  TRY_EXPECT_EXCEPTION( optimizer->StartOptimization() );
+  optimizer->SetSigmoidMinimum( -0.8 );
+  optimizer->SetSigmoidScale( 0.0 );
+  TRY_EXPECT_EXCEPTION( optimizer->StartOptimization() );
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
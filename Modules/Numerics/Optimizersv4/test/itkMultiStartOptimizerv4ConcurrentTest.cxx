@@ -0,0 +1,251 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMultiStartOptimizerv4.h"
+#include "itkEuler2DTransform.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMattesMutualInformationImageToImageMetricv4.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkRegistrationParameterScalesFromPhysicalShift.h"
+#include "itkTestingMacros.h"
+
+/* Optimize rotation starts of a rigid transform one after another and
+ * concurrently, with and without pruning, and compare the results. */
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+using ImageType = itk::Image< float, Dimension >;
+using TransformType = itk::Euler2DTransform< double >;
+using MetricType = itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType >;
+using OptimizerType = itk::MultiStartOptimizerv4;
+using LocalOptimizerType = itk::GradientDescentOptimizerv4;
+
+// An off-center pair of elongated blobs, rotated by angle around the center
+// of the image, sampled with the given spacing.
+ImageType::Pointer CreateImage( double angle, double spacing )
+{
+  const itk::SizeValueType size = static_cast< itk::SizeValueType >( 48 / spacing );
+  ImageType::Pointer image = ImageType::New();
+  ImageType::SizeType imageSize;
+  imageSize.Fill( size );
+  image->SetRegions( imageSize );
+  image->Allocate();
+  ImageType::SpacingType imageSpacing;
+  imageSpacing.Fill( spacing );
+  image->SetSpacing( imageSpacing );
+  for( itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetBufferedRegion() ); !it.IsAtEnd(); ++it )
+    {
+    ImageType::PointType point;
+    image->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    const double x = point[0] - 24.0;
+    const double y = point[1] - 24.0;
+    const double u = std::cos( angle ) * x + std::sin( angle ) * y;
+    const double v = -std::sin( angle ) * x + std::cos( angle ) * y;
+    const double d1 = ( u - 6.0 ) * ( u - 6.0 ) / 60.0 + v * v / 12.0;
+    const double d2 = ( u + 8.0 ) * ( u + 8.0 ) / 10.0 + ( v - 5.0 ) * ( v - 5.0 ) / 10.0;
+    it.Set( static_cast< float >( 100.0 * std::exp( -d1 ) + 60.0 * std::exp( -d2 ) ) );
+    }
+  return image;
+}
+
+MetricType::Pointer CreateMetric( const ImageType * fixed, const ImageType * moving )
+{
+  TransformType::Pointer transform = TransformType::New();
+  TransformType::InputPointType center;
+  center.Fill( 24.0 );
+  transform->SetCenter( center );
+
+  MetricType::Pointer metric = MetricType::New();
+  metric->SetFixedImage( fixed );
+  metric->SetMovingImage( moving );
+  metric->SetMovingTransform( transform );
+  // a single thread per metric, for reproducible values
+  metric->SetMaximumNumberOfThreads( 1 );
+  metric->Initialize();
+  return metric;
+}
+
+OptimizerType::ParametersListType CreateStarts()
+{
+  OptimizerType::ParametersListType starts;
+  for( unsigned int i = 0; i < 16; ++i )
+    {
+    OptimizerType::ParametersType parameters( 3 );
+    parameters[0] = -itk::Math::pi + i * itk::Math::pi / 8.0;
+    parameters[1] = 0.0;
+    parameters[2] = 0.0;
+    starts.push_back( parameters );
+    }
+  return starts;
+}
+
+OptimizerType::Pointer Optimize( const ImageType * fixed, const ImageType * moving, const ImageType * coarseFixed,
+                                 const ImageType * coarseMoving, itk::ThreadIdType numberOfConcurrentStarts,
+                                 OptimizerType::ParameterListSizeType numberOfStartsToOptimize, bool estimateScales )
+{
+  MetricType::Pointer metric = CreateMetric( fixed, moving );
+
+  LocalOptimizerType::Pointer localOptimizer = LocalOptimizerType::New();
+  localOptimizer->SetNumberOfIterations( 60 );
+  localOptimizer->SetNumberOfThreads( 1 );
+  if( estimateScales )
+    {
+    using ScalesEstimatorType = itk::RegistrationParameterScalesFromPhysicalShift< MetricType >;
+    ScalesEstimatorType::Pointer scalesEstimator = ScalesEstimatorType::New();
+    scalesEstimator->SetMetric( metric );
+    localOptimizer->SetScalesEstimator( scalesEstimator );
+    }
+  else
+    {
+    LocalOptimizerType::ScalesType scales( 3 );
+    scales[0] = 500.0;
+    scales[1] = 1.0;
+    scales[2] = 1.0;
+    localOptimizer->SetScales( scales );
+    localOptimizer->SetLearningRate( 0.002 );
+    }
+
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  OptimizerType::ParametersListType starts = CreateStarts();
+  optimizer->SetParametersList( starts );
+  optimizer->SetMetric( metric );
+  optimizer->SetLocalOptimizer( localOptimizer );
+  optimizer->SetNumberOfConcurrentStarts( numberOfConcurrentStarts );
+  optimizer->SetNumberOfStartsToOptimize( numberOfStartsToOptimize );
+  if( coarseFixed != nullptr )
+    {
+    MetricType::Pointer pruningMetric = CreateMetric( coarseFixed, coarseMoving );
+    optimizer->SetPruningMetric( pruningMetric );
+    }
+  optimizer->StartOptimization();
+
+  std::cout << numberOfConcurrentStarts << " concurrent starts, " << numberOfStartsToOptimize
+            << " starts to optimize" << ( coarseFixed != nullptr ? " (coarse pruning)" : "" )
+            << ( estimateScales ? " (estimated scales)" : "" ) << ": best " << optimizer->GetBestParameters()
+            << " at start " << optimizer->GetBestParametersIndex() << ", values";
+  for( double value : optimizer->GetMetricValuesList() )
+    {
+    std::cout << " " << value;
+    }
+  std::cout << std::endl;
+  return optimizer;
+}
+
+bool SameResults( OptimizerType * serial, OptimizerType * concurrent )
+{
+  bool passed = serial->GetMetricValuesList() == concurrent->GetMetricValuesList()
+                && serial->GetParametersList() == concurrent->GetParametersList()
+                && serial->GetBestParametersIndex() == concurrent->GetBestParametersIndex()
+                && serial->GetMetric()->GetParameters() == concurrent->GetMetric()->GetParameters();
+  if( !passed )
+    {
+    std::cerr << "The concurrent optimization differs from the serial one" << std::endl;
+    }
+  return passed;
+}
+
+// The best rotation should be closer to the true one than to the other starts.
+bool FoundRotation( OptimizerType * optimizer, double angle )
+{
+  const OptimizerType::ParametersType best = optimizer->GetBestParameters();
+  const bool passed = std::abs( best[0] - angle ) < itk::Math::pi / 16.0;
+  if( !passed )
+    {
+    std::cerr << "The rotation " << angle << " was not found: " << best << std::endl;
+    }
+  return passed;
+}
+}
+
+int itkMultiStartOptimizerv4ConcurrentTest( int, char * [] )
+{
+  const double angle = 2.2;
+  const ImageType::Pointer fixed = CreateImage( 0.0, 1.0 );
+  const ImageType::Pointer moving = CreateImage( angle, 1.0 );
+  const ImageType::Pointer coarseFixed = CreateImage( 0.0, 2.0 );
+  const ImageType::Pointer coarseMoving = CreateImage( angle, 2.0 );
+
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  TEST_SET_GET_VALUE( 1, optimizer->GetNumberOfConcurrentStarts() );
+  TEST_SET_GET_VALUE( 0, optimizer->GetNumberOfStartsToOptimize() );
+
+  bool passed = true;
+
+  // A clone of the metric shares the images and evaluates the same value.
+  MetricType::Pointer metric = CreateMetric( fixed, moving );
+  OptimizerType::ParametersType parameters = CreateStarts()[3];
+  metric->SetParameters( parameters );
+  MetricType::Pointer metricClone = metric->Clone();
+  TRY_EXPECT_NO_EXCEPTION( metricClone->Initialize() );
+  passed = passed && metricClone->GetFixedImage() == metric->GetFixedImage()
+           && metricClone->GetMovingInterpolator() == metric->GetMovingInterpolator()
+           && metricClone->GetMovingTransform() != metric->GetMovingTransform()
+           && metricClone->GetParameters() == metric->GetParameters()
+           && metricClone->GetMaximumNumberOfThreads() == 1 && metricClone->GetValue() == metric->GetValue();
+
+  // A clone of a metric with additional settings copies them.
+  using MattesMetricType = itk::MattesMutualInformationImageToImageMetricv4< ImageType, ImageType >;
+  MattesMetricType::Pointer mattesMetric = MattesMetricType::New();
+  mattesMetric->SetNumberOfHistogramBins( 17 );
+  mattesMetric->SetUseSparseJointPDFDerivatives( true );
+  MattesMetricType::Pointer mattesMetricClone = mattesMetric->Clone();
+  passed = passed && mattesMetricClone->GetNumberOfHistogramBins() == 17
+           && mattesMetricClone->GetUseSparseJointPDFDerivatives();
+  if( !passed )
+    {
+    std::cerr << "The metric clones differ from the metrics" << std::endl;
+    }
+
+  // All the starts, one after another and concurrently.
+  OptimizerType::Pointer serial = Optimize( fixed, moving, nullptr, nullptr, 1, 0, false );
+  passed = FoundRotation( serial, angle ) && passed;
+  for( itk::ThreadIdType concurrency = 2; concurrency < 8; concurrency += 5 )
+    {
+    OptimizerType::Pointer concurrent = Optimize( fixed, moving, nullptr, nullptr, concurrency, 0, false );
+    passed = SameResults( serial, concurrent ) && passed;
+    }
+
+  // The starts pruned with the metric, and with the metric on coarse images.
+  for( unsigned int coarse = 0; coarse < 2; ++coarse )
+    {
+    const ImageType * pruningFixed = coarse ? coarseFixed.GetPointer() : nullptr;
+    const ImageType * pruningMoving = coarse ? coarseMoving.GetPointer() : nullptr;
+    OptimizerType::Pointer prunedSerial = Optimize( fixed, moving, pruningFixed, pruningMoving, 1, 3, false );
+    OptimizerType::Pointer prunedConcurrent = Optimize( fixed, moving, pruningFixed, pruningMoving, 4, 3, false );
+    passed = SameResults( prunedSerial, prunedConcurrent ) && passed;
+    passed = FoundRotation( prunedConcurrent, angle ) && passed;
+    if( prunedConcurrent->GetMetricValuesList().size() != 3 )
+      {
+      std::cerr << "Expected 3 optimized starts" << std::endl;
+      passed = false;
+      }
+    }
+
+  // The scales and learning rate estimated for the first start are used by
+  // the concurrent starts.
+  OptimizerType::Pointer estimated = Optimize( fixed, moving, nullptr, nullptr, 4, 0, true );
+  passed = FoundRotation( estimated, angle ) && passed;
+  if( estimated->GetMetricValuesList().size() != CreateStarts().size() )
+    {
+    std::cerr << "Expected all the starts to be optimized" << std::endl;
+    passed = false;
+    }
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
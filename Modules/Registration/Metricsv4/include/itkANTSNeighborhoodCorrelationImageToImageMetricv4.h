@@ -55,6 +55,10 @@ namespace itk {
  * neighborhood window. This is described in the above paper and specifically
  * optimized for dense registration.
  *
+ * With UseSeparableBoxSums on, the dense evaluation instead maps each voxel
+ * once, and computes the sums over the neighborhoods by separable box
+ * filtering. See SetUseSeparableBoxSums.
+ *
  *  Example of usage:
  *
  *  using MetricType = itk::ANTSNeighborhoodCorrelationImageToImageMetricv4
@@ -164,6 +168,23 @@ public:
   itkGetMacro(Radius, RadiusType);
   itkGetConstMacro(Radius, RadiusType);
 
+  /** Compute the sums over the neighborhoods of the dense evaluation by
+   * separable box filtering. The scanning window maps and interpolates each
+   * voxel once for each neighborhood containing it along the scan direction,
+   * that is (2*radius+1)^(Dimension-1) times. With this option, each thread
+   * maps the voxels of its region padded by the radius once, plane by plane
+   * along the last dimension, and computes the sums of the fixed and moving
+   * values, of their squares and of their product, and the number of valid
+   * voxels, in a ring of 2*radius+1 planes: the sums along the other
+   * dimensions are computed in each plane, and the planes of the ring are
+   * then added. These are loops over contiguous arrays, which the compiler
+   * can vectorize. The value and the derivative are equal to the ones of
+   * the scanning window up to the order of the summation. This does not
+   * change the evaluation on a sampled point set. Off by default. */
+  itkSetMacro(UseSeparableBoxSums, bool);
+  itkGetConstMacro(UseSeparableBoxSums, bool);
+  itkBooleanMacro(UseSeparableBoxSums);
+
   void Initialize(void) override;
 
 protected:
@@ -178,11 +199,16 @@ protected:
   using ANTSNeighborhoodCorrelationImageToImageMetricv4SparseGetValueAndDerivativeThreaderType =
       ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< ThreadedIndexedContainerPartitioner, Superclass, Self >;
 
+  /** Clone the metric, copying the radius and the box sums flag. */
+  typename LightObject::Pointer InternalClone() const override;
+
   void PrintSelf(std::ostream & os, Indent indent) const override;
 
 private:
   // Radius of the neighborhood window centered at each pixel
   RadiusType m_Radius;
+
+  bool m_UseSeparableBoxSums;
 };
 
 } // end namespace itk
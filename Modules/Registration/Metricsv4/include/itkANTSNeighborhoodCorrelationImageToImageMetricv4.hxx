@@ -26,7 +26,8 @@ namespace itk
 
 template<typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
 ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
-::ANTSNeighborhoodCorrelationImageToImageMetricv4()
+::ANTSNeighborhoodCorrelationImageToImageMetricv4() :
+  m_UseSeparableBoxSums(false)
 {
   // initialize radius. note that a radius of 1 can be unstable
   using RadiusValueType = typename RadiusType::SizeValueType;
@@ -51,6 +52,23 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirt
   Superclass::Initialize();
 }
 
+template<typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+typename LightObject::Pointer
+ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::InternalClone() const
+{
+  typename LightObject::Pointer loPtr = Superclass::InternalClone();
+
+  typename Self::Pointer rval = dynamic_cast<Self *>( loPtr.GetPointer() );
+  if( rval.IsNull() )
+    {
+    itkExceptionMacro(<< "downcast to type " << this->GetNameOfClass() << " failed.");
+    }
+  rval->m_Radius = this->m_Radius;
+  rval->m_UseSeparableBoxSums = this->m_UseSeparableBoxSums;
+  return loPtr;
+}
+
 template<typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
 void
 ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
@@ -58,6 +76,7 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4<TFixedImage, TMovingImage, TVirt
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "Correlation window radius: " << m_Radius << std::endl;
+  os << indent << "UseSeparableBoxSums: " << m_UseSeparableBoxSums << std::endl;
 }
 
 } // end namespace itk
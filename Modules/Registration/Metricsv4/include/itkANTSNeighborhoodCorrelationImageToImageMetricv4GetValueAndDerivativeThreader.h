@@ -188,6 +188,14 @@ protected:
     return ProcessVirtualPoint_impl(IdentityHelper<TDomainPartitioner>(), virtualIndex, virtualPoint, threadId );
   }
 
+  /** Process a sample of the sample cache with \c ProcessVirtualPoint,
+   * which evaluates the fixed image itself. */
+  bool ProcessCachedSample( const SizeValueType sample, const ThreadIdType threadId ) override
+  {
+    return this->ProcessVirtualPoint( this->m_ANTSAssociate->m_SampleCacheVirtualIndices[sample],
+                                      this->m_ANTSAssociate->m_SampleCacheVirtualPoints[sample], threadId );
+  }
+
   /* specific overloading for sparse CC metric */
   bool ProcessVirtualPoint_impl(
                              IdentityHelper<ThreadedIndexedContainerPartitioner> itkNotUsed(self),
@@ -282,6 +290,11 @@ protected:
     const ScanParametersType &scanParameters, DerivativeType &deriv,
     MeasureType &local_cc, const ThreadIdType threadId) const;
 
+  /** Dense evaluation over the region with the sums over the neighborhoods
+   * computed by separable box filtering, plane by plane along the last
+   * dimension. */
+  void ThreadedExecutionWithBoxSums( const ImageRegionType & region, const ThreadIdType threadId );
+
 private:
   /** Internal pointer to the metric object in use by this threader.
    *  This will avoid costly dynamic casting in tight loops. */
@@ -38,6 +38,12 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TD
     itkExceptionMacro("Dynamic casting of associate pointer failed.");
     }
 
+  if( this->m_ANTSAssociate->GetUseSeparableBoxSums() )
+    {
+    this->ThreadedExecutionWithBoxSums( virtualImageSubRegion, threadId );
+    return;
+    }
+
   VirtualPointType     virtualPoint;
   MeasureType          metricValueResult = NumericTraits< MeasureType >::ZeroValue();
   MeasureType          metricValueSum = NumericTraits< MeasureType >::ZeroValue();
@@ -177,7 +183,7 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TD
          pointIsValid = this->m_ANTSAssociate->TransformAndEvaluateFixedPoint( virtualPoint, mappedFixedPoint, fixedImageValue );
          if ( pointIsValid )
            {
-           pointIsValid = this->m_ANTSAssociate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, movingImageValue );
+           pointIsValid = this->m_ANTSAssociate->TransformAndEvaluateMovingPoint( index, virtualPoint, mappedMovingPoint, movingImageValue );
            }
          }
        catch (ExceptionObject & exc)
@@ -256,7 +262,7 @@ template < typename TDomainPartitioner, typename TImageToImageMetric, typename T
      pointIsValid = this->m_ANTSAssociate->TransformAndEvaluateFixedPoint( virtualPoint, mappedFixedPoint, fixedImageValue );
      if (pointIsValid)
        {
-       pointIsValid = this->m_ANTSAssociate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, movingImageValue );
+       pointIsValid = this->m_ANTSAssociate->TransformAndEvaluateMovingPoint( index, virtualPoint, mappedMovingPoint, movingImageValue );
        }
      }
    catch (ExceptionObject & exc)
@@ -422,7 +428,7 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TD
    pointIsValid = this->m_ANTSAssociate->TransformAndEvaluateFixedPoint( virtualPoint, mappedFixedPoint, fixedImageValue );
    if ( pointIsValid )
      {
-     pointIsValid = this->m_ANTSAssociate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, movingImageValue );
+     pointIsValid = this->m_ANTSAssociate->TransformAndEvaluateMovingPoint( oindex, virtualPoint, mappedMovingPoint, movingImageValue );
      if( pointIsValid && this->m_ANTSAssociate->GetComputeDerivative() )
        {
        if( this->m_ANTSAssociate->GetGradientSourceIncludesFixed() )
@@ -493,7 +499,16 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TD
 
     if ( ! (sFixedFixed > NumericTraits<LocalRealType>::epsilon() && sMovingMoving > NumericTraits<LocalRealType>::epsilon() ) )
       {
-      deriv.Fill( NumericTraits<DerivativeValueType>::ZeroValue() );
+      if( this->GetUseSparseMovingTransformJacobian() )
+        {
+        /* Nothing to store */
+        this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformSparseJacobianNumberOfWeights = 0;
+        this->m_GetValueAndDerivativePerThreadVariables[threadId].LocalDerivativesAreSparse = true;
+        }
+      else
+        {
+        deriv.Fill( NumericTraits<DerivativeValueType>::ZeroValue() );
+        }
       return;
       }
 
@@ -502,6 +517,13 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TD
       derivWRTImage[qq] = 2.0 * sFixedMoving / (sFixedFixed_sMovingMoving) * (fixedI - sFixedMoving / sMovingMoving * movingI) * movingImageGradient[qq];
       }
 
+    if( this->GetUseSparseMovingTransformJacobian() )
+      {
+      /* Only visit the parameters of the sparse Jacobian. */
+      this->ComputeSparseLocalDerivative( scanMem.virtualPoint, derivWRTImage, deriv, threadId );
+      return;
+      }
+
     /* Use a pre-allocated jacobian object for efficiency */
     using JacobianReferenceType = JacobianType &;
     JacobianReferenceType jacobian = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobian;
@@ -526,6 +548,240 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TD
     }
 }
 
+template < typename TDomainPartitioner, typename TImageToImageMetric, typename TNeighborhoodCorrelationMetric >
+void
+ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner, TImageToImageMetric, TNeighborhoodCorrelationMetric >
+::ThreadedExecutionWithBoxSums( const ImageRegionType & region, const ThreadIdType threadId )
+{
+  using LocalRealType = InternalComputationValueType;
+  constexpr unsigned int LastDimension = TImageToImageMetric::VirtualImageDimension - 1;
+  // The sums of the fixed value, of the moving value, of their squares, of
+  // their product, and the number of valid voxels.
+  constexpr unsigned int NumberOfSums = 6;
+
+  const RadiusType radius = this->m_ANTSAssociate->GetRadius();
+  const bool computeDerivative = this->m_ANTSAssociate->GetComputeDerivative();
+  DerivativeType & localDerivativeResult = this->m_GetValueAndDerivativePerThreadVariables[threadId].LocalDerivatives;
+
+  // The voxels of the neighborhoods of the region, processed plane by plane
+  // along the last dimension.
+  ImageRegionType paddedRegion = region;
+  paddedRegion.PadByRadius( radius );
+  paddedRegion.Crop( this->m_ANTSAssociate->GetVirtualImage()->GetBufferedRegion() );
+  ImageRegionType planeRegion = paddedRegion;
+  planeRegion.SetSize( LastDimension, 1 );
+  const SizeValueType planeSize = planeRegion.GetNumberOfPixels();
+  const IndexValueType firstPlane = paddedRegion.GetIndex( LastDimension );
+  const IndexValueType lastPlane = paddedRegion.GetUpperIndex()[LastDimension];
+
+  // The planes within the radius of the current plane
+  struct PlaneType
+    {
+    LocalRealType * Sums[NumberOfSums];
+    std::vector< LocalRealType > Buffer;
+    std::vector< LocalRealType > FixedValues;
+    std::vector< LocalRealType > MovingValues;
+    std::vector< unsigned char > IsValid;
+    std::vector< MovingImagePointType > MappedMovingPoints;
+    };
+  const auto ringSize = std::min< IndexValueType >( 2 * static_cast< IndexValueType >( radius[LastDimension] ) + 1,
+                                                    lastPlane - firstPlane + 1 );
+  std::vector< PlaneType > ring( ringSize );
+  for( PlaneType & plane : ring )
+    {
+    plane.Buffer.resize( NumberOfSums * planeSize );
+    for( unsigned int q = 0; q < NumberOfSums; ++q )
+      {
+      plane.Sums[q] = plane.Buffer.data() + q * planeSize;
+      }
+    plane.FixedValues.resize( planeSize );
+    plane.MovingValues.resize( planeSize );
+    plane.IsValid.resize( planeSize );
+    plane.MappedMovingPoints.resize( computeDerivative ? planeSize : 0 );
+    }
+  std::vector< LocalRealType > buffer( planeSize );
+  std::vector< LocalRealType > totalBuffer( NumberOfSums * planeSize );
+
+  // Map the voxels of a plane, and sum their values over the neighborhoods
+  // within the plane, one dimension at a time.
+  const auto computePlane = [&](IndexValueType planeIndex)
+    {
+    PlaneType & plane = ring[( planeIndex - firstPlane ) % ringSize];
+    VirtualIndexType index = planeRegion.GetIndex();
+    index[LastDimension] = planeIndex;
+    for( SizeValueType i = 0; i < planeSize; ++i )
+      {
+      VirtualPointType     virtualPoint;
+      FixedImagePointType  mappedFixedPoint;
+      FixedImagePixelType  fixedImageValue = NumericTraits< FixedImagePixelType >::ZeroValue();
+      MovingImagePointType mappedMovingPoint;
+      MovingImagePixelType movingImageValue = NumericTraits< MovingImagePixelType >::ZeroValue();
+      this->m_ANTSAssociate->TransformVirtualIndexToPhysicalPoint( index, virtualPoint );
+      bool pointIsValid = this->m_ANTSAssociate->TransformAndEvaluateFixedPoint( virtualPoint, mappedFixedPoint, fixedImageValue );
+      if( pointIsValid )
+        {
+        pointIsValid = this->m_ANTSAssociate->TransformAndEvaluateMovingPoint( index, virtualPoint, mappedMovingPoint, movingImageValue );
+        }
+      if( !pointIsValid )
+        {
+        fixedImageValue = NumericTraits< FixedImagePixelType >::ZeroValue();
+        movingImageValue = NumericTraits< MovingImagePixelType >::ZeroValue();
+        }
+      plane.FixedValues[i] = fixedImageValue;
+      plane.MovingValues[i] = movingImageValue;
+      plane.IsValid[i] = pointIsValid;
+      if( computeDerivative )
+        {
+        plane.MappedMovingPoints[i] = mappedMovingPoint;
+        }
+      plane.Sums[0][i] = fixedImageValue;
+      plane.Sums[1][i] = movingImageValue;
+      plane.Sums[2][i] = fixedImageValue * fixedImageValue;
+      plane.Sums[3][i] = movingImageValue * movingImageValue;
+      plane.Sums[4][i] = fixedImageValue * movingImageValue;
+      plane.Sums[5][i] = pointIsValid ? NumericTraits< LocalRealType >::OneValue() : NumericTraits< LocalRealType >::ZeroValue();
+
+      for( unsigned int d = 0; d < LastDimension; ++d )
+        {
+        if( ++index[d] <= planeRegion.GetUpperIndex()[d] )
+          {
+          break;
+          }
+        index[d] = planeRegion.GetIndex( d );
+        }
+      }
+
+    // The sums along a dimension add rows of stride contiguous values.
+    SizeValueType stride = 1;
+    for( unsigned int d = 0; d < LastDimension; ++d )
+      {
+      const auto length = static_cast< IndexValueType >( planeRegion.GetSize( d ) );
+      const auto r = static_cast< IndexValueType >( radius[d] );
+      for( unsigned int q = 0; r > 0 && q < NumberOfSums; ++q )
+        {
+        std::copy( plane.Sums[q], plane.Sums[q] + planeSize, buffer.begin() );
+        for( SizeValueType outer = 0; outer < planeSize; outer += stride * length )
+          {
+          for( IndexValueType x = 0; x < length; ++x )
+            {
+            LocalRealType * const out = plane.Sums[q] + outer + x * stride;
+            std::fill( out, out + stride, NumericTraits< LocalRealType >::ZeroValue() );
+            for( IndexValueType k = std::max< IndexValueType >( 0, x - r ); k <= std::min( length - 1, x + r ); ++k )
+              {
+              const LocalRealType * const in = buffer.data() + outer + k * stride;
+              for( SizeValueType j = 0; j < stride; ++j )
+                {
+                out[j] += in[j];
+                }
+              }
+            }
+          }
+        }
+      stride *= length;
+      }
+    };
+
+  const auto planeRadius = static_cast< IndexValueType >( radius[LastDimension] );
+  const IndexValueType firstRegionPlane = region.GetIndex( LastDimension );
+  const IndexValueType lastRegionPlane = region.GetUpperIndex()[LastDimension];
+  IndexValueType nextPlane = firstPlane;
+
+  ScanIteratorType   scanIt;
+  ScanParametersType scanParameters;
+  ScanMemType        scanMem;
+  MeasureType        metricValueResult = NumericTraits< MeasureType >::ZeroValue();
+  MeasureType        metricValueSum = NumericTraits< MeasureType >::ZeroValue();
+  const LocalRealType localZero = NumericTraits< LocalRealType >::ZeroValue();
+
+  for( IndexValueType z = firstRegionPlane; z <= lastRegionPlane; ++z )
+    {
+    const IndexValueType lastNeighborPlane = std::min( z + planeRadius, lastPlane );
+    for( ; nextPlane <= lastNeighborPlane; ++nextPlane )
+      {
+      computePlane( nextPlane );
+      }
+
+    // The sums over the neighborhoods
+    std::fill( totalBuffer.begin(), totalBuffer.end(), localZero );
+    for( IndexValueType p = std::max( z - planeRadius, firstPlane ); p <= lastNeighborPlane; ++p )
+      {
+      const LocalRealType * const in = ring[( p - firstPlane ) % ringSize].Buffer.data();
+      LocalRealType * const out = totalBuffer.data();
+      for( SizeValueType j = 0; j < NumberOfSums * planeSize; ++j )
+        {
+        out[j] += in[j];
+        }
+      }
+    const LocalRealType * const sumFixedPlane = totalBuffer.data();
+    const LocalRealType * const sumMovingPlane = sumFixedPlane + planeSize;
+    const LocalRealType * const sumFixed2Plane = sumMovingPlane + planeSize;
+    const LocalRealType * const sumMoving2Plane = sumFixed2Plane + planeSize;
+    const LocalRealType * const sumFixedMovingPlane = sumMoving2Plane + planeSize;
+    const LocalRealType * const countPlane = sumFixedMovingPlane + planeSize;
+    const PlaneType & plane = ring[( z - firstPlane ) % ringSize];
+
+    // The voxels of the region in the plane, in the order of the scanning
+    VirtualIndexType index = region.GetIndex();
+    index[LastDimension] = z;
+    const SizeValueType numberOfVoxels = region.GetNumberOfPixels() / region.GetSize( LastDimension );
+    for( SizeValueType n = 0; n < numberOfVoxels; ++n )
+      {
+      SizeValueType i = 0;
+      SizeValueType stride = 1;
+      for( unsigned int d = 0; d < LastDimension; ++d )
+        {
+        i += static_cast< SizeValueType >( index[d] - planeRegion.GetIndex( d ) ) * stride;
+        stride *= planeRegion.GetSize( d );
+        }
+
+      if( plane.IsValid[i] )
+        {
+        const LocalRealType count = countPlane[i];
+        const LocalRealType sumFixed = sumFixedPlane[i];
+        const LocalRealType sumMoving = sumMovingPlane[i];
+        const LocalRealType fixedMean  = sumFixed  / count;
+        const LocalRealType movingMean = sumMoving / count;
+
+        scanMem.sFixedFixed   = sumFixed2Plane[i] - fixedMean * sumFixed - fixedMean * sumFixed + count * fixedMean * fixedMean;
+        scanMem.sMovingMoving = sumMoving2Plane[i] - movingMean * sumMoving - movingMean * sumMoving + count * movingMean * movingMean;
+        scanMem.sFixedMoving  = sumFixedMovingPlane[i] - movingMean * sumFixed - fixedMean * sumMoving + count * movingMean * fixedMean;
+        scanMem.fixedA        = plane.FixedValues[i] - fixedMean;
+        scanMem.movingA       = plane.MovingValues[i] - movingMean;
+        scanMem.movingImageGradient.Fill( NumericTraits< typename MovingImageGradientType::ValueType >::ZeroValue() );
+        if( computeDerivative )
+          {
+          if( this->m_ANTSAssociate->GetGradientSourceIncludesMoving() )
+            {
+            this->m_ANTSAssociate->ComputeMovingImageGradientAtPoint( plane.MappedMovingPoints[i], scanMem.movingImageGradient );
+            }
+          this->m_ANTSAssociate->TransformVirtualIndexToPhysicalPoint( index, scanMem.virtualPoint );
+          }
+
+        this->ComputeMovingTransformDerivative( scanIt, scanMem, scanParameters, localDerivativeResult, metricValueResult, threadId );
+
+        this->m_GetValueAndDerivativePerThreadVariables[threadId].NumberOfValidPoints++;
+        metricValueSum -= metricValueResult;
+        if( computeDerivative )
+          {
+          this->StorePointDerivativeResult( index, threadId );
+          }
+        }
+
+      for( unsigned int d = 0; d < LastDimension; ++d )
+        {
+        if( ++index[d] <= region.GetUpperIndex()[d] )
+          {
+          break;
+          }
+        index[d] = region.GetIndex( d );
+        }
+      }
+    }
+
+  /* Store metric value result for this thread. */
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].Measure = metricValueSum;
+}
+
 /*
  * Specific implementation for sparse threader. It reuse most of the routine from the dense threader by
  * reinitializing the scanning at every point.
@@ -99,6 +99,14 @@ protected:
                                     const VirtualPointType & virtualPoint,
                                     const ThreadIdType threadId ) override;
 
+  /** Process a sample of the sample cache with \c ProcessVirtualPoint,
+   * which evaluates the fixed image itself. */
+  bool ProcessCachedSample( const SizeValueType sample, const ThreadIdType threadId ) override
+  {
+    return this->ProcessVirtualPoint( this->m_CorrelationAssociate->m_SampleCacheVirtualIndices[sample],
+                                      this->m_CorrelationAssociate->m_SampleCacheVirtualPoints[sample], threadId );
+  }
+
   /** This function computes the local voxel-wise contribution of
    *  the metric to the global integral of the metric/derivative.
    */
@@ -204,7 +204,7 @@ CorrelationImageToImageMetricv4GetValueAndDerivativeThreader<TDomainPartitioner,
 
   try
     {
-    pointIsValid = this->m_CorrelationAssociate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, mappedMovingPixelValue );
+    pointIsValid = this->m_CorrelationAssociate->TransformAndEvaluateMovingPoint( virtualIndex, virtualPoint, mappedMovingPoint, mappedMovingPixelValue );
     if( pointIsValid &&
         this->m_CorrelationAssociate->GetComputeDerivative() &&
         this->m_CorrelationAssociate->GetGradientSourceIncludesMoving() )
@@ -287,7 +287,26 @@ CorrelationImageToImageMetricv4GetValueAndDerivativeThreader<TDomainPartitioner,
   cumsum.m2 += m1 * m1;
   cumsum.fm += f1 * m1;
 
-  if( this->m_CorrelationAssociate->GetComputeDerivative() )
+  if( this->m_CorrelationAssociate->GetComputeDerivative() && this->GetUseSparseMovingTransformJacobian() )
+    {
+    /* Only visit the parameters of the sparse Jacobian. */
+    const NumberOfParametersType rowSize = this->m_CachedNumberOfSparseJacobianParameters;
+    const NumberOfParametersType numberOfWeights = this->ComputeMovingTransformSparseJacobian( virtualPoint, threadId );
+    const auto & weights = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformSparseJacobianWeights;
+    const auto & parameterIndices = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformSparseJacobianParameterIndices;
+    for (SizeValueType dim = 0; dim < ImageToImageMetricv4Type::MovingImageDimension; dim++)
+      {
+      const InternalComputationValueType f1Gradient = f1 * movingImageGradient[dim];
+      const InternalComputationValueType m1Gradient = m1 * movingImageGradient[dim];
+      for (NumberOfParametersType k = 0; k < numberOfWeights; k++)
+        {
+        const NumberOfParametersType par = parameterIndices[dim * rowSize + k];
+        cumsum.fdm[par] += f1Gradient * weights[dim * rowSize + k];
+        cumsum.mdm[par] += m1Gradient * weights[dim * rowSize + k];
+        }
+      }
+    }
+  else if( this->m_CorrelationAssociate->GetComputeDerivative() )
     {
     /* Use a pre-allocated jacobian object for efficiency */
     using JacobianReferenceType = typename TImageToImageMetric::JacobianType &;
@@ -103,7 +103,7 @@ template<typename TDomainPartitioner, typename TImageToImageMetric, typename TCo
 bool
 CorrelationImageToImageMetricv4HelperThreader<TDomainPartitioner,
 TImageToImageMetric, TCorrelationMetric>
-::ProcessVirtualPoint( const VirtualIndexType & itkNotUsed(virtualIndex), const VirtualPointType & virtualPoint, const ThreadIdType threadId )
+::ProcessVirtualPoint( const VirtualIndexType & virtualIndex, const VirtualPointType & virtualPoint, const ThreadIdType threadId )
 {
   FixedImagePointType         mappedFixedPoint;
   FixedImagePixelType         mappedFixedPixelValue;
@@ -134,7 +134,7 @@ TImageToImageMetric, TCorrelationMetric>
 
   try
     {
-    pointIsValid = this->m_CorrelationAssociate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, mappedMovingPixelValue );
+    pointIsValid = this->m_CorrelationAssociate->TransformAndEvaluateMovingPoint( virtualIndex, virtualPoint, mappedMovingPoint, mappedMovingPixelValue );
     }
   catch( ExceptionObject & exc )
     {
@@ -127,6 +127,9 @@ protected:
   using DemonsSparseGetValueAndDerivativeThreaderType =
       DemonsImageToImageMetricv4GetValueAndDerivativeThreader< ThreadedIndexedContainerPartitioner, Superclass, Self >;
 
+  /** Clone the metric, copying the intensity difference threshold. */
+  typename LightObject::Pointer InternalClone() const override;
+
   void PrintSelf(std::ostream& os, Indent indent) const override;
 
 private:
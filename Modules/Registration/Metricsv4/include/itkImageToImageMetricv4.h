@@ -99,13 +99,22 @@ namespace itk
  * Point sets are set via SetFixedSampledPointSet, and the point set is enabled
  * for use by calling SetUseFixedSampledPointSet.
  * \note If the point set is sparse, the option SetUse[Fixed|Moving]ImageGradientFilter
- * typically should be disabled to avoid excessive computation. However,
- * the gradient values of the fixed image are not cached
- * when using a point set (there are plans for this in the future), so
- * depending on the number of iterations (when used during optimization)
- * and the level of sparsity, it may be more efficient to
+ * typically should be disabled to avoid excessive computation. By default,
+ * the values and gradients of the fixed image are evaluated at each sample
+ * at every iteration, so depending on the number of iterations (when used
+ * during optimization) and the level of sparsity, it may be more efficient to
  * use a gradient image filter for it because it will only be
- * calculated once.
+ * calculated once. Alternatively, see SetUseSampleCache.
+ *
+ * Sample Cache
+ *
+ * With a point set and \c UseSampleCache on, the virtual index and point,
+ * the mapped fixed point, the fixed image value and gradient, and whether
+ * the fixed point is valid (inside the fixed image and its mask) are
+ * computed once for each sample in \c Initialize, and stored in one array
+ * per quantity. Each evaluation then only maps the samples with the moving
+ * transform and evaluates the moving image. The cache is computed again when
+ * the point set is updated or the fixed transform is modified.
  *
  * Vector Images
  *
@@ -162,6 +171,14 @@ namespace itk
  *  See \c ImageToImageMetricv4Test for a clear example of what a
  *  derived class must implement and do.
  *
+ *  Clone() returns a metric with the same settings, which shares the
+ *  read-only images, masks, sampled point set, interpolators and image
+ *  gradient filters and calculators with this metric, but has its own
+ *  copies of the transforms. Once initialized, the clone can be evaluated
+ *  concurrently with this metric for other transform parameters, e.g. to
+ *  evaluate several starting points at once. Derived classes with
+ *  additional settings must override InternalClone() to copy them.
+ *
  * \ingroup ITKMetricsv4
  */
 template<typename TFixedImage,typename TMovingImage,typename TVirtualImage = TFixedImage,
@@ -423,6 +440,19 @@ public:
   /** Get the virtual domain sampling point set */
   itkGetModifiableObjectMacro(VirtualSampledPointSet, VirtualPointSetType);
 
+  /** Set a new fixed image domain sampling point set and map it to the
+   * virtual domain, without initializing the metric again. The metric must
+   * have been initialized with UseFixedSampledPointSet on. This is used to
+   * evaluate the metric on a new set of samples at each iteration. */
+  virtual void UpdateFixedSampledPointSet( const FixedSampledPointSetType * pointSet );
+
+  /** Set/Get flag to cache the fixed image data of the sampled points,
+   * when UseFixedSampledPointSet is on. Off by default. See the main
+   * documentation. */
+  itkSetMacro(UseSampleCache, bool);
+  itkGetConstReferenceMacro(UseSampleCache, bool);
+  itkBooleanMacro(UseSampleCache);
+
   /** Set/Get the gradient filter */
   itkSetObjectMacro( FixedImageGradientFilter, FixedImageGradientFilterType );
   itkGetModifiableObjectMacro(FixedImageGradientFilter, FixedImageGradientFilterType );
@@ -539,6 +569,20 @@ public:
     return true;
   }
 
+  using MappedMovingPointsContainerType = typename Superclass::MappedMovingPointsContainerType;
+
+  /** Shared mapped moving points are supported when evaluating the dense
+   * virtual domain, i.e. when UseFixedSampledPointSet is false. */
+  bool SupportsSharedMappedMovingPoints() const override
+  {
+    return !this->m_UseFixedSampledPointSet;
+  }
+
+  void SetSharedMappedMovingPoints( const MappedMovingPointsContainerType * points ) override
+  {
+    this->m_SharedMappedMovingPoints = points;
+  }
+
   using MetricCategoryType = typename Superclass::MetricCategoryType;
 
   /** Get metric category */
@@ -592,6 +636,16 @@ protected:
                          MovingImagePointType & mappedMovingPoint,
                          MovingImagePixelType & mappedMovingPixelValue ) const;
 
+  /** Transform and evaluate the point of a virtual domain pixel, given by
+   * both its index and its point. The shared mapped moving points are used
+   * instead of the moving transform when they are set.
+   * \sa SetSharedMappedMovingPoints */
+  bool TransformAndEvaluateMovingPoint(
+                         const VirtualIndexType & virtualIndex,
+                         const VirtualPointType & virtualPoint,
+                         MovingImagePointType & mappedMovingPoint,
+                         MovingImagePixelType & mappedMovingPixelValue ) const;
+
   /** Compute image derivatives for a Fixed point. */
   virtual void ComputeFixedImageGradientAtPoint( const FixedImagePointType & mappedPoint, FixedImageGradientType & gradient ) const;
 
@@ -624,6 +678,17 @@ protected:
   /** Get accessor for flag to calculate derivative. */
   itkGetConstMacro( ComputeDerivative, bool );
 
+  /** Compute the sample cache again if it is out of date, i.e. if the
+   * points, the fixed transform or the gradient source changed since it
+   * was computed. The samples are processed in parallel. */
+  void UpdateSampleCache() const;
+
+  /** Return true if the threaders evaluate the samples from the cache. */
+  bool GetSampleCacheIsUsed() const
+    {
+    return this->m_UseSampleCache && this->m_UseFixedSampledPointSet && this->m_SampleCacheIsCurrent;
+    }
+
   FixedImageConstPointer  m_FixedImage;
   MovingImageConstPointer m_MovingImage;
 
@@ -683,12 +748,40 @@ protected:
   /** Flag to use FixedSampledPointSet, i.e. Sparse sampling. */
   bool                                    m_UseFixedSampledPointSet;
 
+  /** Sample cache, with one entry per point of m_VirtualSampledPointSet.
+   * The fixed values and gradients are only meaningful for valid points,
+   * and the gradients are only computed when the gradient source includes
+   * the fixed image. */
+  bool                                                  m_UseSampleCache;
+  mutable std::vector< VirtualIndexType >               m_SampleCacheVirtualIndices;
+  mutable std::vector< VirtualPointType >               m_SampleCacheVirtualPoints;
+  mutable std::vector< FixedImagePointType >            m_SampleCacheFixedPoints;
+  mutable std::vector< FixedImagePixelType >            m_SampleCacheFixedPixelValues;
+  mutable std::vector< FixedImageGradientType >         m_SampleCacheFixedImageGradients;
+  mutable std::vector< unsigned char >                  m_SampleCachePointIsValid;
+  mutable bool                                          m_SampleCacheIsCurrent;
+  mutable const FixedTransformType *                    m_SampleCacheFixedTransform;
+  mutable ModifiedTimeType                              m_SampleCacheFixedTransformMTime;
+
+  /** Moving points of the virtual domain pixels mapped by another object,
+   * or nullptr. Not owned. */
+  const MappedMovingPointsContainerType * m_SharedMappedMovingPoints;
+
   ImageToImageMetricv4();
   ~ImageToImageMetricv4() override;
 
   void PrintSelf(std::ostream& os, Indent indent) const override;
 
+  /** Clone the metric, sharing the images and their interpolators and
+   * gradient images. See the main documentation. */
+  typename LightObject::Pointer InternalClone() const override;
+
 private:
+  /** Check a mapped moving point against the mask and the moving image
+   * buffer, and evaluate the moving image there. */
+  bool EvaluateMovingPoint( const MovingImagePointType & mappedMovingPoint,
+                            MovingImagePixelType & mappedMovingPixelValue ) const;
+
   /** Map the fixed point set samples to the virtual domain */
   void MapFixedSampledPointSetToVirtual();
 
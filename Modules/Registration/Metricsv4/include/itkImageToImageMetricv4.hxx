@@ -64,6 +64,12 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
   this->m_UseFixedImageGradientFilter  = true;
   this->m_UseMovingImageGradientFilter = true;
   this->m_UseFixedSampledPointSet      = false;
+  this->m_SharedMappedMovingPoints     = nullptr;
+
+  this->m_UseSampleCache = false;
+  this->m_SampleCacheIsCurrent = false;
+  this->m_SampleCacheFixedTransform = nullptr;
+  this->m_SampleCacheFixedTransformMTime = 0;
 
   this->m_FloatingPointCorrectionResolution = 1e6;
   this->m_UseFloatingPointCorrection = false;
@@ -191,6 +197,14 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
     itkDebugMacro("Initialize: ComputeMovingImageGradientFilterImage");
     this->ComputeMovingImageGradientFilterImage();
     }
+
+  /* Compute the fixed image data of the samples once, now that the
+   * interpolators and the fixed gradient image are ready. */
+  this->m_SampleCacheIsCurrent = false;
+  if( this->m_UseSampleCache && this->m_UseFixedSampledPointSet )
+    {
+    this->UpdateSampleCache();
+    }
 }
 
 template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
@@ -278,6 +292,11 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
     /* Clear derivative final result. */
     this->m_DerivativeResult->Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
     }
+
+  if( this->m_UseSampleCache && this->m_UseFixedSampledPointSet )
+    {
+    this->UpdateSampleCache();
+    }
 }
 
 template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
@@ -326,9 +345,6 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
                          MovingImagePointType & mappedMovingPoint,
                          MovingImagePixelType & mappedMovingPixelValue ) const
 {
-  bool pointIsValid = true;
-  mappedMovingPixelValue = NumericTraits<MovingImagePixelType>::ZeroValue();
-
   // map the point into moving space
 
   // Before transforming points, we should convert their types from the ImagePointType (aka Point<double, dim>)
@@ -337,11 +353,44 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
   typename MovingTransformType::OutputPointType localMappedMovingPoint;
 
   localVirtualPoint.CastFrom(virtualPoint);
-  localMappedMovingPoint.CastFrom(mappedMovingPoint);
 
   localMappedMovingPoint = this->m_MovingTransform->TransformPoint( localVirtualPoint );
   mappedMovingPoint.CastFrom(localMappedMovingPoint);
 
+  return this->EvaluateMovingPoint( mappedMovingPoint, mappedMovingPixelValue );
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+bool
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::TransformAndEvaluateMovingPoint(
+                         const VirtualIndexType & virtualIndex,
+                         const VirtualPointType & virtualPoint,
+                         MovingImagePointType & mappedMovingPoint,
+                         MovingImagePixelType & mappedMovingPixelValue ) const
+{
+  if( this->m_SharedMappedMovingPoints == nullptr || this->m_UseFixedSampledPointSet )
+    {
+    return this->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, mappedMovingPixelValue );
+    }
+
+  // the point was mapped with the moving transform by the owner of the
+  // shared points, at the buffer offset of its index
+  const OffsetValueType offset = this->m_VirtualImage->ComputeOffset( virtualIndex );
+  mappedMovingPoint.CastFrom( ( *this->m_SharedMappedMovingPoints )[offset] );
+
+  return this->EvaluateMovingPoint( mappedMovingPoint, mappedMovingPixelValue );
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+bool
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::EvaluateMovingPoint( const MovingImagePointType & mappedMovingPoint,
+                       MovingImagePixelType & mappedMovingPixelValue ) const
+{
+  bool pointIsValid = true;
+  mappedMovingPixelValue = NumericTraits<MovingImagePixelType>::ZeroValue();
+
   // check against the mask if one is assigned
   if ( this->m_MovingImageMask )
     {
@@ -514,11 +563,90 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
     }
 }
 
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::UpdateFixedSampledPointSet( const FixedSampledPointSetType * pointSet )
+{
+  if( ! this->m_UseFixedSampledPointSet || this->m_VirtualSampledPointSet.IsNull() )
+    {
+    itkExceptionMacro("The metric must be initialized with UseFixedSampledPointSet "
+                      "to update the fixed sampled point set.");
+    }
+  this->m_FixedSampledPointSet = pointSet;
+  this->MapFixedSampledPointSetToVirtual();
+  if( this->m_UseSampleCache )
+    {
+    this->UpdateSampleCache();
+    }
+  this->Modified();
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::UpdateSampleCache() const
+{
+  const bool cacheGradients = this->GetGradientSourceIncludesFixed();
+  if( this->m_SampleCacheIsCurrent
+      && this->m_SampleCacheFixedTransform == this->m_FixedTransform.GetPointer()
+      && this->m_SampleCacheFixedTransformMTime == this->m_FixedTransform->GetMTime()
+      && ( !cacheGradients || !this->m_SampleCacheFixedImageGradients.empty() ) )
+    {
+    return;
+    }
+
+  const SizeValueType numberOfSamples = this->m_VirtualSampledPointSet->GetNumberOfPoints();
+  this->m_SampleCacheVirtualIndices.resize( numberOfSamples );
+  this->m_SampleCacheVirtualPoints.resize( numberOfSamples );
+  this->m_SampleCacheFixedPoints.resize( numberOfSamples );
+  this->m_SampleCacheFixedPixelValues.resize( numberOfSamples );
+  this->m_SampleCachePointIsValid.resize( numberOfSamples );
+  if( cacheGradients )
+    {
+    this->m_SampleCacheFixedImageGradients.resize( numberOfSamples );
+    }
+  else
+    {
+    this->m_SampleCacheFixedImageGradients.clear();
+    }
+
+  const typename VirtualPointSetType::PointsContainer * virtualPoints = this->m_VirtualSampledPointSet->GetPoints();
+
+  ImageRegion< 1 > samples;
+  samples.SetIndex( 0, 0 );
+  samples.SetSize( 0, numberOfSamples );
+  this->m_SparseGetValueAndDerivativeThreader->GetMultiThreader()->template ParallelizeImageRegion< 1 >( samples,
+    [this, virtualPoints, cacheGradients](const ImageRegion< 1 > & region)
+    {
+    const auto first = static_cast< SizeValueType >( region.GetIndex( 0 ) );
+    for( SizeValueType i = first; i < first + region.GetSize( 0 ); ++i )
+      {
+      const VirtualPointType & virtualPoint = virtualPoints->ElementAt( i );
+      this->m_SampleCacheVirtualPoints[i] = virtualPoint;
+      this->TransformPhysicalPointToVirtualIndex( virtualPoint, this->m_SampleCacheVirtualIndices[i] );
+      const bool pointIsValid = this->TransformAndEvaluateFixedPoint( virtualPoint,
+        this->m_SampleCacheFixedPoints[i], this->m_SampleCacheFixedPixelValues[i] );
+      this->m_SampleCachePointIsValid[i] = pointIsValid;
+      if( pointIsValid && cacheGradients )
+        {
+        this->ComputeFixedImageGradientAtPoint( this->m_SampleCacheFixedPoints[i], this->m_SampleCacheFixedImageGradients[i] );
+        }
+      }
+    },
+    nullptr );
+
+  this->m_SampleCacheFixedTransform = this->m_FixedTransform.GetPointer();
+  this->m_SampleCacheFixedTransformMTime = this->m_FixedTransform->GetMTime();
+  this->m_SampleCacheIsCurrent = true;
+}
+
 template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
 void
 ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
 ::MapFixedSampledPointSetToVirtual()
 {
+  this->m_SampleCacheIsCurrent = false;
   this->m_VirtualSampledPointSet = VirtualPointSetType::New();
   this->m_VirtualSampledPointSet->Initialize();
 
@@ -584,6 +712,55 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
     }
 }
 
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+typename LightObject::Pointer
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::InternalClone() const
+{
+  typename LightObject::Pointer loPtr = Superclass::InternalClone();
+
+  typename Self::Pointer rval = dynamic_cast<Self *>( loPtr.GetPointer() );
+  if( rval.IsNull() )
+    {
+    itkExceptionMacro(<< "downcast to type " << this->GetNameOfClass() << " failed.");
+    }
+
+  /* The images, masks and point sets are read-only, and the interpolators,
+   * gradient filters and gradient calculators are only modified during
+   * Initialize, so they are shared. Since the gradient filters are shared,
+   * initializing the clone does not recompute the gradient images. */
+  rval->m_FixedImage = this->m_FixedImage;
+  rval->m_MovingImage = this->m_MovingImage;
+  rval->m_FixedInterpolator = this->m_FixedInterpolator;
+  rval->m_MovingInterpolator = this->m_MovingInterpolator;
+  rval->m_FixedImageGradientInterpolator = this->m_FixedImageGradientInterpolator;
+  rval->m_MovingImageGradientInterpolator = this->m_MovingImageGradientInterpolator;
+  rval->m_UseFixedImageGradientFilter = this->m_UseFixedImageGradientFilter;
+  rval->m_UseMovingImageGradientFilter = this->m_UseMovingImageGradientFilter;
+  rval->m_FixedImageGradientFilter = this->m_FixedImageGradientFilter;
+  rval->m_MovingImageGradientFilter = this->m_MovingImageGradientFilter;
+  rval->m_DefaultFixedImageGradientFilter = this->m_DefaultFixedImageGradientFilter;
+  rval->m_DefaultMovingImageGradientFilter = this->m_DefaultMovingImageGradientFilter;
+  rval->m_DefaultFixedImageGradientCalculator = this->m_DefaultFixedImageGradientCalculator;
+  rval->m_DefaultMovingImageGradientCalculator = this->m_DefaultMovingImageGradientCalculator;
+  rval->m_FixedImageGradientImage = this->m_FixedImageGradientImage;
+  rval->m_MovingImageGradientImage = this->m_MovingImageGradientImage;
+  rval->m_FixedImageGradientCalculator = this->m_FixedImageGradientCalculator;
+  rval->m_MovingImageGradientCalculator = this->m_MovingImageGradientCalculator;
+  rval->m_FixedImageMask = this->m_FixedImageMask;
+  rval->m_MovingImageMask = this->m_MovingImageMask;
+  rval->m_FixedSampledPointSet = this->m_FixedSampledPointSet;
+  rval->m_UseFixedSampledPointSet = this->m_UseFixedSampledPointSet;
+  rval->m_UseSampleCache = this->m_UseSampleCache;
+  rval->m_UseFloatingPointCorrection = this->m_UseFloatingPointCorrection;
+  rval->m_FloatingPointCorrectionResolution = this->m_FloatingPointCorrectionResolution;
+  rval->m_DenseGetValueAndDerivativeThreader->SetMaximumNumberOfThreads(
+    this->m_DenseGetValueAndDerivativeThreader->GetMaximumNumberOfThreads() );
+  rval->m_SparseGetValueAndDerivativeThreader->SetMaximumNumberOfThreads(
+    this->m_SparseGetValueAndDerivativeThreader->GetMaximumNumberOfThreads() );
+  return loPtr;
+}
+
 template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
 void
 ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
@@ -595,7 +772,8 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
      << indent << "GetUseFixedImageGradientFilter: " << this->GetUseFixedImageGradientFilter() << std::endl
      << indent << "GetUseMovingImageGradientFilter: " << this->GetUseMovingImageGradientFilter() << std::endl
      << indent << "UseFloatingPointCorrection: " << this->GetUseFloatingPointCorrection() << std::endl
-     << indent << "FloatingPointCorrectionResolution: " << this->GetFloatingPointCorrectionResolution() << std::endl;
+     << indent << "FloatingPointCorrectionResolution: " << this->GetFloatingPointCorrectionResolution() << std::endl
+     << indent << "UseSampleCache: " << this->GetUseSampleCache() << std::endl;
 
   itkPrintSelfObjectMacro( FixedImage );
   itkPrintSelfObjectMacro( MovingImage );
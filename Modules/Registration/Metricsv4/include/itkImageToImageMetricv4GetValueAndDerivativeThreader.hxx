@@ -53,6 +53,16 @@ ImageToImageMetricv4GetValueAndDerivativeThreader< ThreadedIndexedContainerParti
   using ElementIdentifierType = typename TImageToImageMetricv4::VirtualPointSetType::MeshTraits::PointIdentifier;
   const ElementIdentifierType begin = indexSubRange[0];
   const ElementIdentifierType end   = indexSubRange[1];
+  if( this->m_Associate->GetSampleCacheIsUsed() )
+    {
+    for( ElementIdentifierType i = begin; i <= end; ++i )
+      {
+      this->ProcessCachedSample( i, threadId );
+      }
+    //Finalize per thread actions
+    this->m_Associate->FinalizeThread( threadId );
+    return;
+    }
   VirtualIndexType virtualIndex;
   typename VirtualImageType::ConstPointer virtualImage = this->m_Associate->GetVirtualImage();
   for( ElementIdentifierType i = begin; i <= end; ++i )
@@ -76,6 +76,8 @@ public:
   using FixedOutputPointType = typename FixedTransformType::OutputPointType;
   using MovingTransformType = typename ImageToImageMetricv4Type::MovingTransformType;
   using MovingOutputPointType = typename MovingTransformType::OutputPointType;
+  using MovingTransformParametersValueType = typename MovingTransformType::ParametersValueType;
+  using MovingTransformNumberOfParametersType = typename MovingTransformType::NumberOfParametersType;
 
   using MeasureType = typename ImageToImageMetricv4Type::MeasureType;
   using DerivativeType = typename ImageToImageMetricv4Type::DerivativeType;
@@ -116,6 +118,25 @@ protected:
                                     const VirtualPointType & virtualPoint,
                                     const ThreadIdType threadId );
 
+  /** Method called by the sparse threader to process a sample when the
+   * metric uses its sample cache. The virtual point and the fixed point,
+   * pixel value and gradient are read from the cache, and the rest is done
+   * as in \c ProcessVirtualPoint. Threaders which override
+   * \c ProcessVirtualPoint must override this method too. */
+  virtual bool ProcessCachedSample( const SizeValueType sample,
+                                    const ThreadIdType threadId );
+
+  /** Transform the virtual point into the moving space and evaluate it,
+   * then call \c ProcessPoint with the given fixed point, pixel value and
+   * gradient, and store the results. This is the part of
+   * \c ProcessVirtualPoint which follows the fixed image evaluation. */
+  bool ProcessMappedFixedPoint( const VirtualIndexType & virtualIndex,
+                                const VirtualPointType & virtualPoint,
+                                const FixedImagePointType & mappedFixedPoint,
+                                const FixedImagePixelType & mappedFixedPixelValue,
+                                const FixedImageGradientType & mappedFixedImageGradient,
+                                const ThreadIdType threadId );
+
   /** Method to calculate the metric value and derivative
    * given a point, value and image derivative for both fixed and moving
    * spaces. The provided values have been calculated from \c virtualPoint,
@@ -159,11 +180,44 @@ protected:
 
 
   /** Store derivative result from a single point calculation.
+   * When the local derivative was computed by \c ComputeSparseLocalDerivative,
+   * only the entries of the parameters of the sparse Jacobian are stored.
    * \warning If this method is overridden or otherwise not used
    * in a derived class, be sure to *accumulate* results. */
   virtual void StorePointDerivativeResult( const VirtualIndexType & virtualIndex,
                                            const ThreadIdType threadId );
 
+  /** Whether the Jacobian of the moving transform is computed in sparse
+   * form, i.e. the moving transform is global and provides a sparse
+   * Jacobian, see Transform::ComputeSparseJacobianWithRespectToParameters.
+   * This is only set once threading has been started. */
+  bool GetUseSparseMovingTransformJacobian() const
+    {
+    return this->m_CachedNumberOfSparseJacobianParameters > 0;
+    }
+
+  /** Compute the sparse Jacobian of the moving transform at a virtual point
+   * into the per thread \c MovingTransformSparseJacobianWeights and
+   * \c MovingTransformSparseJacobianParameterIndices, whose rows have
+   * \c m_CachedNumberOfSparseJacobianParameters entries, and return the
+   * number of weights of each row. No memory is allocated.
+   * Requires \c GetUseSparseMovingTransformJacobian(). */
+  NumberOfParametersType ComputeMovingTransformSparseJacobian( const VirtualPointType & virtualPoint,
+                                                               const ThreadIdType threadId ) const;
+
+  /** Set the local derivative at a virtual point to the product of the
+   * transposed Jacobian of the moving transform with \c derivativeWRTImage,
+   * the derivative of the point metric with respect to the mapped moving
+   * point, by the sparse Jacobian. Only the entries of the parameters of the
+   * sparse Jacobian are set, and only they are stored by
+   * \c StorePointDerivativeResult.
+   * Requires \c GetUseSparseMovingTransformJacobian(). */
+  template< typename TDerivativeWRTImage >
+  void ComputeSparseLocalDerivative( const VirtualPointType & virtualPoint,
+                                     const TDerivativeWRTImage & derivativeWRTImage,
+                                     DerivativeType & localDerivativeReturn,
+                                     const ThreadIdType threadId ) const;
+
   struct GetValueAndDerivativePerThreadStruct
     {
     /** Intermediary threaded metric value storage. */
@@ -180,6 +234,14 @@ protected:
      * classes for efficiency. */
     JacobianType                 MovingTransformJacobian;
     JacobianType                 MovingTransformJacobianPositional;
+    /** Pre-allocated sparse transform jacobian buffers, used when the moving
+     * transform provides a sparse Jacobian. */
+    std::vector< MovingTransformParametersValueType >    MovingTransformSparseJacobianWeights;
+    std::vector< MovingTransformNumberOfParametersType > MovingTransformSparseJacobianParameterIndices;
+    /** The number of weights of each row of the sparse Jacobian of the local
+     * derivative, when \c LocalDerivativesAreSparse. */
+    NumberOfParametersType       MovingTransformSparseJacobianNumberOfWeights;
+    bool                         LocalDerivativesAreSparse;
     };
   itkPadStruct( ITK_CACHE_LINE_ALIGNMENT, GetValueAndDerivativePerThreadStruct,
                                             PaddedGetValueAndDerivativePerThreadStruct);
@@ -191,6 +253,7 @@ protected:
    *  These will only be set once threading has been started. */
   mutable NumberOfParametersType                      m_CachedNumberOfParameters;
   mutable NumberOfParametersType                      m_CachedNumberOfLocalParameters;
+  mutable NumberOfParametersType                      m_CachedNumberOfSparseJacobianParameters;
 };
 
 } // end namespace itk
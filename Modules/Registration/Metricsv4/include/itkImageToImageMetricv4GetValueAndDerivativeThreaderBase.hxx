@@ -29,7 +29,8 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
 ::ImageToImageMetricv4GetValueAndDerivativeThreaderBase():
   m_GetValueAndDerivativePerThreadVariables( nullptr ),
   m_CachedNumberOfParameters( 0 ),
-  m_CachedNumberOfLocalParameters( 0 )
+  m_CachedNumberOfLocalParameters( 0 ),
+  m_CachedNumberOfSparseJacobianParameters( 0 )
 {
 }
 
@@ -51,6 +52,13 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
   // Cache some values
   this->m_CachedNumberOfParameters      = this->m_Associate->GetNumberOfParameters();
   this->m_CachedNumberOfLocalParameters = this->m_Associate->GetNumberOfLocalParameters();
+  this->m_CachedNumberOfSparseJacobianParameters = 0;
+  if( this->m_Associate->GetComputeDerivative()
+      && this->m_Associate->m_MovingTransform->GetTransformCategory() != MovingTransformType::DisplacementField )
+    {
+    this->m_CachedNumberOfSparseJacobianParameters =
+      this->m_Associate->m_MovingTransform->GetNumberOfSparseJacobianParameters();
+    }
 
   /* Per-thread results */
   const ThreadIdType numThreadsUsed = this->GetNumberOfThreadsUsed();
@@ -68,6 +76,10 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
         this->m_Associate->VirtualImageDimension, this->m_CachedNumberOfLocalParameters );
       this->m_GetValueAndDerivativePerThreadVariables[i].MovingTransformJacobianPositional.SetSize(
         this->m_Associate->VirtualImageDimension, this->m_Associate->VirtualImageDimension );
+      this->m_GetValueAndDerivativePerThreadVariables[i].MovingTransformSparseJacobianWeights.resize(
+        MovingTransformType::OutputSpaceDimension * this->m_CachedNumberOfSparseJacobianParameters );
+      this->m_GetValueAndDerivativePerThreadVariables[i].MovingTransformSparseJacobianParameterIndices.resize(
+        MovingTransformType::OutputSpaceDimension * this->m_CachedNumberOfSparseJacobianParameters );
       if ( this->m_Associate->m_MovingTransform->GetTransformCategory() == MovingTransformType::DisplacementField )
         {
         /* For transforms with local support, e.g. displacement field,
@@ -99,6 +111,8 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
     {
     this->m_GetValueAndDerivativePerThreadVariables[thread].NumberOfValidPoints = NumericTraits< SizeValueType >::ZeroValue();
     this->m_GetValueAndDerivativePerThreadVariables[thread].Measure = NumericTraits< InternalComputationValueType >::ZeroValue();
+    this->m_GetValueAndDerivativePerThreadVariables[thread].MovingTransformSparseJacobianNumberOfWeights = 0;
+    this->m_GetValueAndDerivativePerThreadVariables[thread].LocalDerivativesAreSparse = false;
     if( this->m_Associate->GetComputeDerivative() )
       {
       if ( this->m_Associate->m_MovingTransform->GetTransformCategory() != MovingTransformType::DisplacementField )
@@ -183,11 +197,7 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
   FixedImagePointType         mappedFixedPoint;
   FixedImagePixelType         mappedFixedPixelValue;
   FixedImageGradientType      mappedFixedImageGradient;
-  MovingImagePointType        mappedMovingPoint;
-  MovingImagePixelType        mappedMovingPixelValue;
-  MovingImageGradientType     mappedMovingImageGradient;
   bool                        pointIsValid = false;
-  MeasureType                 metricValueResult;
 
   /* Transform the point into fixed and moving spaces, and evaluate.
    * Do this in a try block to catch exceptions and print more useful info
@@ -215,9 +225,53 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
     return pointIsValid;
     }
 
+  return this->ProcessMappedFixedPoint( virtualIndex, virtualPoint, mappedFixedPoint, mappedFixedPixelValue,
+                                        mappedFixedImageGradient, threadId );
+}
+
+template< typename TDomainPartitioner, typename TImageToImageMetricv4 >
+bool
+ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >
+::ProcessCachedSample( const SizeValueType sample, const ThreadIdType threadId )
+{
+  if( !this->m_Associate->m_SampleCachePointIsValid[sample] )
+    {
+    return false;
+    }
+
+  /* The gradients are only cached when the gradient source includes the
+   * fixed image. Otherwise, the gradient is meaningless. */
+  const FixedImageGradientType unusedFixedImageGradient{};
+  const FixedImageGradientType & mappedFixedImageGradient =
+    this->m_Associate->m_SampleCacheFixedImageGradients.empty()
+    ? unusedFixedImageGradient : this->m_Associate->m_SampleCacheFixedImageGradients[sample];
+
+  return this->ProcessMappedFixedPoint( this->m_Associate->m_SampleCacheVirtualIndices[sample],
+                                        this->m_Associate->m_SampleCacheVirtualPoints[sample],
+                                        this->m_Associate->m_SampleCacheFixedPoints[sample],
+                                        this->m_Associate->m_SampleCacheFixedPixelValues[sample],
+                                        mappedFixedImageGradient, threadId );
+}
+
+template< typename TDomainPartitioner, typename TImageToImageMetricv4 >
+bool
+ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >
+::ProcessMappedFixedPoint( const VirtualIndexType & virtualIndex,
+                           const VirtualPointType & virtualPoint,
+                           const FixedImagePointType & mappedFixedPoint,
+                           const FixedImagePixelType & mappedFixedPixelValue,
+                           const FixedImageGradientType & mappedFixedImageGradient,
+                           const ThreadIdType threadId )
+{
+  MovingImagePointType        mappedMovingPoint;
+  MovingImagePixelType        mappedMovingPixelValue;
+  MovingImageGradientType     mappedMovingImageGradient;
+  bool                        pointIsValid = false;
+  MeasureType                 metricValueResult;
+
   try
     {
-    pointIsValid = this->m_Associate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, mappedMovingPixelValue );
+    pointIsValid = this->m_Associate->TransformAndEvaluateMovingPoint( virtualIndex, virtualPoint, mappedMovingPoint, mappedMovingPixelValue );
     if( pointIsValid &&
         this->m_Associate->GetComputeDerivative() &&
         this->m_Associate->GetGradientSourceIncludesMoving() )
@@ -278,7 +332,34 @@ void
 ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >
 ::StorePointDerivativeResult( const VirtualIndexType & virtualIndex, const ThreadIdType threadId )
 {
-  if ( this->m_Associate->m_MovingTransform->GetTransformCategory() != MovingTransformType::DisplacementField )
+  GetValueAndDerivativePerThreadStruct & threadVariables = this->m_GetValueAndDerivativePerThreadVariables[threadId];
+  if ( threadVariables.LocalDerivativesAreSparse )
+    {
+    /* Global support with a sparse Jacobian: only visit its parameters.
+     * A parameter may appear in several rows, so each entry is cleared once
+     * it is stored. */
+    threadVariables.LocalDerivativesAreSparse = false;
+    const NumberOfParametersType rowSize = this->m_CachedNumberOfSparseJacobianParameters;
+    const NumberOfParametersType numberOfWeights = threadVariables.MovingTransformSparseJacobianNumberOfWeights;
+    const bool useFloatingPointCorrection = this->m_Associate->GetUseFloatingPointCorrection();
+    const DerivativeValueType correctionResolution = this->m_Associate->GetFloatingPointCorrectionResolution();
+    for ( unsigned int d = 0; d < MovingTransformType::OutputSpaceDimension; ++d )
+      {
+      const MovingTransformNumberOfParametersType * parameterIndices = &threadVariables.MovingTransformSparseJacobianParameterIndices[d * rowSize];
+      for ( NumberOfParametersType k = 0; k < numberOfWeights; ++k )
+        {
+        DerivativeValueType & localDerivative = threadVariables.LocalDerivatives[parameterIndices[k]];
+        if ( useFloatingPointCorrection )
+          {
+          auto test = static_cast< intmax_t >( localDerivative * correctionResolution );
+          localDerivative = static_cast<DerivativeValueType>( test / correctionResolution );
+          }
+        threadVariables.CompensatedDerivatives[parameterIndices[k]] += localDerivative;
+        localDerivative = NumericTraits< DerivativeValueType >::ZeroValue();
+        }
+      }
+    }
+  else if ( this->m_Associate->m_MovingTransform->GetTransformCategory() != MovingTransformType::DisplacementField )
     {
     /* Global support */
     if ( this->m_Associate->GetUseFloatingPointCorrection() )
@@ -323,6 +404,55 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
     }
 }
 
+template< typename TDomainPartitioner, typename TImageToImageMetricv4 >
+typename ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >::NumberOfParametersType
+ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >
+::ComputeMovingTransformSparseJacobian( const VirtualPointType & virtualPoint, const ThreadIdType threadId ) const
+{
+  GetValueAndDerivativePerThreadStruct & threadVariables = this->m_GetValueAndDerivativePerThreadVariables[threadId];
+  return static_cast< NumberOfParametersType >(
+    this->m_Associate->m_MovingTransform->ComputeSparseJacobianWithRespectToParameters( virtualPoint,
+      threadVariables.MovingTransformSparseJacobianWeights.data(),
+      threadVariables.MovingTransformSparseJacobianParameterIndices.data() ) );
+}
+
+template< typename TDomainPartitioner, typename TImageToImageMetricv4 >
+template< typename TDerivativeWRTImage >
+void
+ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >
+::ComputeSparseLocalDerivative( const VirtualPointType & virtualPoint,
+                                const TDerivativeWRTImage & derivativeWRTImage,
+                                DerivativeType & localDerivativeReturn,
+                                const ThreadIdType threadId ) const
+{
+  GetValueAndDerivativePerThreadStruct & threadVariables = this->m_GetValueAndDerivativePerThreadVariables[threadId];
+  const NumberOfParametersType rowSize = this->m_CachedNumberOfSparseJacobianParameters;
+  const NumberOfParametersType numberOfWeights = this->ComputeMovingTransformSparseJacobian( virtualPoint, threadId );
+  threadVariables.MovingTransformSparseJacobianNumberOfWeights = numberOfWeights;
+  threadVariables.LocalDerivativesAreSparse = true;
+
+  /* Clear all the entries first, since a parameter may appear in several rows. */
+  const MovingTransformNumberOfParametersType * parameterIndices =
+    threadVariables.MovingTransformSparseJacobianParameterIndices.data();
+  for ( unsigned int d = 0; d < MovingTransformType::OutputSpaceDimension; ++d )
+    {
+    for ( NumberOfParametersType k = 0; k < numberOfWeights; ++k )
+      {
+      localDerivativeReturn[parameterIndices[d * rowSize + k]] = NumericTraits< DerivativeValueType >::ZeroValue();
+      }
+    }
+  for ( unsigned int d = 0; d < MovingTransformType::OutputSpaceDimension; ++d )
+    {
+    const DerivativeValueType derivativeWRTImageComponent = derivativeWRTImage[d];
+    const MovingTransformParametersValueType * weights =
+      &threadVariables.MovingTransformSparseJacobianWeights[d * rowSize];
+    for ( NumberOfParametersType k = 0; k < numberOfWeights; ++k )
+      {
+      localDerivativeReturn[parameterIndices[d * rowSize + k]] += derivativeWRTImageComponent * weights[k];
+      }
+    }
+}
+
 template< typename TDomainPartitioner, typename TImageToImageMetricv4 >
 bool
 ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImageToImageMetricv4 >
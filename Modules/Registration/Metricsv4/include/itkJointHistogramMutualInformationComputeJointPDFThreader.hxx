@@ -53,6 +53,14 @@ JointHistogramMutualInformationComputeJointPDFThreader< ThreadedIndexedContainer
   using ElementIdentifierType = typename VirtualPointSetType::MeshTraits::PointIdentifier;
   const ElementIdentifierType begin = indexSubRange[0];
   const ElementIdentifierType end   = indexSubRange[1];
+  if( this->m_Associate->GetSampleCacheIsUsed() )
+    {
+    for( ElementIdentifierType i = begin; i <= end; ++i )
+      {
+      this->ProcessCachedSample( i, threadId );
+      }
+    return;
+    }
   for( ElementIdentifierType i = begin; i <= end; ++i )
     {
     virtualPoint = this->m_Associate->m_VirtualSampledPointSet->GetPoint( i );
@@ -75,6 +75,16 @@ protected:
                              const VirtualPointType & virtualPoint,
                              const ThreadIdType threadId );
 
+  /** Called by the sparse \c ThreadedExecution when the metric uses its
+   * sample cache. The fixed image value is read from the cache. */
+  void ProcessCachedSample( const SizeValueType sample, const ThreadIdType threadId );
+
+  /** Add a pair of fixed and moving image values to the joint histogram
+   * of the thread. */
+  void AddToJointHistogram( const typename AssociateType::Superclass::FixedImagePixelType & fixedImageValue,
+                            const typename AssociateType::Superclass::MovingImagePixelType & movingImageValue,
+                            const ThreadIdType threadId );
+
   /** Collect the results per and normalize. */
   void AfterThreadedExecution() override;
 
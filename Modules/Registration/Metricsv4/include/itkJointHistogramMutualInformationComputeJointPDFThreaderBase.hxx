@@ -64,7 +64,7 @@ JointHistogramMutualInformationComputeJointPDFThreaderBase< TDomainPartitioner,
 template< typename TDomainPartitioner, typename TJointHistogramMetric >
 void
 JointHistogramMutualInformationComputeJointPDFThreaderBase< TDomainPartitioner, TJointHistogramMetric >
-::ProcessPoint( const VirtualIndexType & itkNotUsed(virtualIndex),
+::ProcessPoint( const VirtualIndexType & virtualIndex,
                 const VirtualPointType & virtualPoint,
                 const ThreadIdType threadId )
 {
@@ -81,7 +81,7 @@ JointHistogramMutualInformationComputeJointPDFThreaderBase< TDomainPartitioner,
     pointIsValid = this->m_Associate->TransformAndEvaluateFixedPoint( virtualPoint, mappedFixedPoint, fixedImageValue );
     if( pointIsValid )
       {
-      pointIsValid = this->m_Associate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, movingImageValue );
+      pointIsValid = this->m_Associate->TransformAndEvaluateMovingPoint( virtualIndex, virtualPoint, mappedMovingPoint, movingImageValue );
       }
     }
   catch( ExceptionObject & exc )
@@ -96,18 +96,62 @@ JointHistogramMutualInformationComputeJointPDFThreaderBase< TDomainPartitioner,
   /** Add the paired intensity points to the joint histogram */
   if( pointIsValid )
     {
-    JointPDFPointType jointPDFpoint;
-    this->m_Associate->ComputeJointPDFPoint( fixedImageValue, movingImageValue, jointPDFpoint );
-    JointPDFIndexType jointPDFIndex;
-    this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogram->TransformPhysicalPointToIndex( jointPDFpoint, jointPDFIndex );
-    if( this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogram->GetBufferedRegion().IsInside( jointPDFIndex ) )
-      {
-      typename JointHistogramType::PixelType jointHistogramPixel;
-      jointHistogramPixel = this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogram->GetPixel( jointPDFIndex );
-      jointHistogramPixel++;
-      this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogram->SetPixel( jointPDFIndex, jointHistogramPixel );
-      this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogramCount++;
-      }
+    this->AddToJointHistogram( fixedImageValue, movingImageValue, threadId );
+    }
+}
+
+template< typename TDomainPartitioner, typename TJointHistogramMetric >
+void
+JointHistogramMutualInformationComputeJointPDFThreaderBase< TDomainPartitioner, TJointHistogramMetric >
+::ProcessCachedSample( const SizeValueType sample, const ThreadIdType threadId )
+{
+  if( !this->m_Associate->m_SampleCachePointIsValid[sample] )
+    {
+    return;
+    }
+
+  typename AssociateType::Superclass::MovingImagePointType    mappedMovingPoint;
+  typename AssociateType::Superclass::MovingImagePixelType    movingImageValue;
+  bool                                                        pointIsValid = false;
+
+  try
+    {
+    pointIsValid = this->m_Associate->TransformAndEvaluateMovingPoint( this->m_Associate->m_SampleCacheVirtualIndices[sample],
+                                                                       this->m_Associate->m_SampleCacheVirtualPoints[sample],
+                                                                       mappedMovingPoint, movingImageValue );
+    }
+  catch( ExceptionObject & exc )
+    {
+    std::string msg("Caught exception: \n");
+    msg += exc.what();
+    ExceptionObject err(__FILE__, __LINE__, msg);
+    throw err;
+    }
+
+  if( pointIsValid )
+    {
+    this->AddToJointHistogram( this->m_Associate->m_SampleCacheFixedPixelValues[sample], movingImageValue, threadId );
+    }
+}
+
+template< typename TDomainPartitioner, typename TJointHistogramMetric >
+void
+JointHistogramMutualInformationComputeJointPDFThreaderBase< TDomainPartitioner, TJointHistogramMetric >
+::AddToJointHistogram( const typename AssociateType::Superclass::FixedImagePixelType & fixedImageValue,
+                       const typename AssociateType::Superclass::MovingImagePixelType & movingImageValue,
+                       const ThreadIdType threadId )
+{
+  JointPDFPointType jointPDFpoint;
+  this->m_Associate->ComputeJointPDFPoint( fixedImageValue, movingImageValue, jointPDFpoint );
+  JointPDFIndexType jointPDFIndex;
+  this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogram->TransformPhysicalPointToIndex( jointPDFpoint, jointPDFIndex );
+  if( this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogram->GetBufferedRegion().IsInside( jointPDFIndex ) )
+    {
+    typename JointHistogramType::PixelType jointHistogramPixel;
+    jointHistogramPixel = this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogram->GetPixel( jointPDFIndex );
+    jointHistogramPixel++;
+    this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogram->SetPixel( jointPDFIndex, jointHistogramPixel );
+    this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogramCount++;
     }
 }
 
@@ -152,6 +152,18 @@ JointHistogramMutualInformationGetValueAndDerivativeThreader< TDomainPartitioner
     scalingfactor = NumericTraits< InternalComputationValueType >::ZeroValue();
     }
 
+  if( this->GetUseSparseMovingTransformJacobian() )
+    {
+    /* Only visit the parameters of the sparse Jacobian. */
+    FixedArray< InternalComputationValueType, TImageToImageMetric::MovingImageDimension > derivativeWRTImage;
+    for ( SizeValueType dim = 0; dim < TImageToImageMetric::MovingImageDimension; dim++ )
+      {
+      derivativeWRTImage[dim] = scalingfactor * movingImageGradient[dim];
+      }
+    this->ComputeSparseLocalDerivative( virtualPoint, derivativeWRTImage, localDerivativeReturn, threadId );
+    return true;
+    }
+
   /* Use a pre-allocated jacobian object for efficiency */
   using JacobianReferenceType = JacobianType &;
   JacobianReferenceType jacobian = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobian;
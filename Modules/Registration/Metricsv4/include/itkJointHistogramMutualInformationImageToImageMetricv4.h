@@ -182,6 +182,9 @@ protected:
   using JointHistogramMutualInformationSparseGetValueAndDerivativeThreaderType =
       JointHistogramMutualInformationGetValueAndDerivativeThreader< ThreadedIndexedContainerPartitioner, Superclass, Self >;
 
+  /** Clone the metric, copying the number of histogram bins and the joint PDF smoothing variance. */
+  typename LightObject::Pointer InternalClone() const override;
+
   /** Standard PrintSelf method. */
   void PrintSelf(std::ostream & os, Indent indent) const override;
 
@@ -122,6 +122,7 @@ public:
   using MeasureType = typename Superclass::MeasureType;
   using DerivativeType = typename Superclass::DerivativeType;
   using DerivativeValueType = typename DerivativeType::ValueType;
+  using NumberOfParametersType = typename Superclass::NumberOfParametersType;
 
   using FixedImageType = typename Superclass::FixedImageType;
   using FixedImagePointType = typename Superclass::FixedImagePointType;
@@ -183,14 +184,30 @@ public:
   /**
    * Get the internal JointPDFDeriviative image that was used in
    * creating the metric derivative value.
-   * This is only created when a global support transform is used, and
-   * derivatives are requested.
+   * This is only created when a global support transform is used,
+   * derivatives are requested, and UseSparseJointPDFDerivatives is off.
    */
   const typename JointPDFDerivativesType::Pointer GetJointPDFDerivatives () const
     {
     return this->m_JointPDFDerivatives;
     }
 
+  /** Accumulate the derivative with a global support transform without
+   * the joint PDF derivatives image, whose size is the number of bins
+   * squared times the number of parameters. Instead, each thread stores
+   * for each sample its joint PDF index and the Parzen window derivative
+   * weights, and the nonzero inner products of the Jacobian columns with
+   * the moving image gradient, bucketed by block of parameters. Once the
+   * joint PDF is known, the blocks are reduced in parallel into the
+   * derivative. The memory is proportional to the number of samples times
+   * the number of parameters with a nonzero Jacobian at a sample, which
+   * is smaller for a transform with many parameters of small support,
+   * like a BSplineTransform, when the samples are not too many. The derivative is equal to the default one up to the
+   * order of the summation. Off by default. */
+  itkSetMacro(UseSparseJointPDFDerivatives, bool);
+  itkGetConstMacro(UseSparseJointPDFDerivatives, bool);
+  itkBooleanMacro(UseSparseJointPDFDerivatives);
+
   void FinalizeThread( const ThreadIdType threadId ) override;
 
 protected:
@@ -204,6 +221,9 @@ protected:
   using MattesMutualInformationSparseGetValueAndDerivativeThreaderType =
       MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< ThreadedIndexedContainerPartitioner, Superclass, Self >;
 
+  /** Clone the metric, copying the number of histogram bins and the sparse accumulation flag. */
+  typename LightObject::Pointer InternalClone() const override;
+
   void PrintSelf(std::ostream& os, Indent indent) const override;
 
   using JointPDFIndexType = typename JointPDFType::IndexType;
@@ -345,6 +365,39 @@ private:
 
   PDFValueType m_JointPDFSum;
 
+  /** Whether the sparse accumulation is used for the current evaluation. */
+  bool UseSparseAccumulation() const
+    {
+    return this->m_UseSparseJointPDFDerivatives && this->GetComputeDerivative() && !this->HasLocalSupport();
+    }
+
+  /** A sample of the sparse accumulation: the index in the joint PDF of
+   * the first of the four moving image bins of its Parzen window, the
+   * cubic BSpline derivative for each of these bins, and the weight of
+   * the sample once the pRatio is known. */
+  struct SparseDerivativeSample
+    {
+    OffsetValueType JointPDFIndex;
+    PDFValueType    CubicBSplineDerivativeValues[4];
+    PDFValueType    Weight;
+    };
+
+  /** A nonzero inner product of a Jacobian column with the moving image
+   * gradient, for a sample of the same thread. */
+  struct SparseDerivativeEntry
+    {
+    SizeValueType          Sample;
+    NumberOfParametersType Parameter;
+    PDFValueType           Value;
+    };
+
+  /** The samples of each thread, and the entries of each thread and block
+   * of parameters, at threadId * m_NumberOfSparseParameterBlocks + block. */
+  mutable std::vector<std::vector<SparseDerivativeSample> > m_ThreaderSparseDerivativeSamples;
+  std::vector<std::vector<SparseDerivativeEntry> >          m_ThreaderSparseDerivativeEntries;
+  SizeValueType                                             m_NumberOfSparseParameterBlocks;
+  NumberOfParametersType                                    m_SparseParameterBlockSize;
+
   /** Store the per-point local derivative result by parzen window bin.
    * For local-support transforms only. */
   mutable std::vector<DerivativeType>              m_LocalDerivativeByParzenBin;
@@ -353,6 +406,12 @@ private:
   /** Perform the final step in computing results */
   virtual void ComputeResults() const;
 
+  /** Add the sparse derivative contributions to the derivative, in
+   * parallel over the blocks of parameters. */
+  void ReduceSparseDerivatives() const;
+
+  bool m_UseSparseJointPDFDerivatives;
+
 };
 
 } // end namespace itk
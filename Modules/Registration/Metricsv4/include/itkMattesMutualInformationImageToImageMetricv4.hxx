@@ -22,6 +22,7 @@
 #include "itkCompensatedSummation.h"
 #include "itkMutexLock.h"
 #include "itkMutexLockHolder.h"
+#include "itkImageRegion.h"
 
 namespace itk
 {
@@ -51,7 +52,10 @@ MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualI
   // For multi-threading the metric
   m_ThreaderJointPDF(0),
   m_JointPDFDerivatives(nullptr),
-  m_JointPDFSum(0.0)
+  m_JointPDFSum(0.0),
+  m_NumberOfSparseParameterBlocks(0),
+  m_SparseParameterBlockSize(0),
+  m_UseSparseJointPDFDerivatives(false)
 {
   // We have our own GetValueAndDerivativeThreader's that we want
   // ImageToImageMetricv4 to use.
@@ -188,7 +192,7 @@ void
 MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
 ::FinalizeThread( const ThreadIdType threadId )
 {
-  if( this->GetComputeDerivative() && ( !this->HasLocalSupport() ) )
+  if( this->GetComputeDerivative() && ( !this->HasLocalSupport() ) && !this->UseSparseAccumulation() )
     {
     this->m_ThreaderDerivativeManager[threadId].BlockAndReduce();
     }
@@ -283,7 +287,7 @@ MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualI
 
       if( this->GetComputeDerivative() )
         {
-        if( ! this->HasLocalSupport() )
+        if( ! this->HasLocalSupport() && ! this->UseSparseAccumulation() )
           {
           // Collect global derivative contributions
 
@@ -302,7 +306,7 @@ MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualI
         else
           {
           // Collect the pRatio per pdf indecies.
-          // Will be applied subsequently to local-support derivative
+          // Will be applied subsequently to local-support or sparse derivative
           const OffsetValueType index = movingIndex + (fixedIndex * this->m_NumberOfHistogramBins);
           this->m_PRatioArray[index] = pRatio * nFactor;
           }
@@ -329,6 +333,10 @@ MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualI
           }
         }
       }
+    else if( this->UseSparseAccumulation() )
+      {
+      this->ReduceSparseDerivatives();
+      }
     }
 
   // in ITKv4, metrics always minimize
@@ -336,6 +344,66 @@ MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualI
 }
 
 
+template <typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::ReduceSparseDerivatives() const
+{
+  const auto numberOfThreads = static_cast< SizeValueType >( this->m_ThreaderSparseDerivativeSamples.size() );
+  const SizeValueType numberOfBlocks = this->m_NumberOfSparseParameterBlocks;
+  MultiThreaderBase * multiThreader = this->m_UseFixedSampledPointSet
+    ? this->m_SparseGetValueAndDerivativeThreader->GetMultiThreader()
+    : this->m_DenseGetValueAndDerivativeThreader->GetMultiThreader();
+
+  // The weight of each sample: the sum of the pRatio of its four bins,
+  // scaled by the normalization, times the Parzen window derivative.
+  ImageRegion< 1 > threadRegion;
+  threadRegion.SetIndex( 0, 0 );
+  threadRegion.SetSize( 0, numberOfThreads );
+  multiThreader->template ParallelizeImageRegion< 1 >( threadRegion,
+    [this](const ImageRegion< 1 > & region)
+    {
+    const auto first = static_cast< SizeValueType >( region.GetIndex( 0 ) );
+    for( SizeValueType t = first; t < first + region.GetSize( 0 ); ++t )
+      {
+      for( SparseDerivativeSample & sample : this->m_ThreaderSparseDerivativeSamples[t] )
+        {
+        const PRatioType * pRatio = &( this->m_PRatioArray[sample.JointPDFIndex] );
+        sample.Weight = 0.0;
+        for( unsigned int bin = 0; bin < 4; ++bin )
+          {
+          sample.Weight += sample.CubicBSplineDerivativeValues[bin] * pRatio[bin];
+          }
+        }
+      }
+    },
+    nullptr );
+
+  // Each block of parameters is updated by one thread only, with the
+  // entries of all the threads.
+  ImageRegion< 1 > blockRegion;
+  blockRegion.SetIndex( 0, 0 );
+  blockRegion.SetSize( 0, numberOfBlocks );
+  multiThreader->template ParallelizeImageRegion< 1 >( blockRegion,
+    [this, numberOfThreads, numberOfBlocks](const ImageRegion< 1 > & region)
+    {
+    DerivativeType & derivative = *( this->m_DerivativeResult );
+    const auto first = static_cast< SizeValueType >( region.GetIndex( 0 ) );
+    for( SizeValueType block = first; block < first + region.GetSize( 0 ); ++block )
+      {
+      for( SizeValueType t = 0; t < numberOfThreads; ++t )
+        {
+        const std::vector< SparseDerivativeSample > & samples = this->m_ThreaderSparseDerivativeSamples[t];
+        for( const SparseDerivativeEntry & entry : this->m_ThreaderSparseDerivativeEntries[t * numberOfBlocks + block] )
+          {
+          derivative[entry.Parameter] -= samples[entry.Sample].Weight * entry.Value;
+          }
+        }
+      }
+    },
+    nullptr );
+}
+
 template <typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
 void
 MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
@@ -372,12 +440,30 @@ MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualI
 }
 
 
+template <typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+typename LightObject::Pointer
+MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::InternalClone() const
+{
+  typename LightObject::Pointer loPtr = Superclass::InternalClone();
+
+  typename Self::Pointer rval = dynamic_cast<Self *>( loPtr.GetPointer() );
+  if( rval.IsNull() )
+    {
+    itkExceptionMacro(<< "downcast to type " << this->GetNameOfClass() << " failed.");
+    }
+  rval->m_NumberOfHistogramBins = this->m_NumberOfHistogramBins;
+  rval->m_UseSparseJointPDFDerivatives = this->m_UseSparseJointPDFDerivatives;
+  return loPtr;
+}
+
 template <typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
 void
 MattesMutualInformationImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
 ::PrintSelf(std::ostream& os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "UseSparseJointPDFDerivatives: " << this->m_UseSparseJointPDFDerivatives << std::endl;
 }
 
 template <typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
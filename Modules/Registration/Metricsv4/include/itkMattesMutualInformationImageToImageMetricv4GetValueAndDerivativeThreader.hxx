@@ -171,7 +171,35 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
       this->m_MattesAssociate->m_LocalDerivativeByParzenBin[n].Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
       }
     }
-  if(  this->m_MattesAssociate->GetComputeDerivative() && ! this->m_MattesAssociate->HasLocalSupport() )
+  if( this->m_MattesAssociate->UseSparseAccumulation() )
+    {
+    // The pRatio is collected per pdf index, as with local-support
+    this->m_MattesAssociate->m_PRatioArray.assign( this->m_MattesAssociate->m_NumberOfHistogramBins * this->m_MattesAssociate->m_NumberOfHistogramBins, 0.0);
+    this->m_MattesAssociate->m_JointPdfIndex1DArray.resize(0);
+    this->m_MattesAssociate->m_LocalDerivativeByParzenBin.resize(0);
+    this->m_MattesAssociate->m_JointPDFDerivatives = nullptr;
+
+    // One block of parameters per thread for the reduction. The buffers are
+    // cleared, but keep their capacity for the next evaluations.
+    const NumberOfParametersType numberOfParameters = this->GetCachedNumberOfLocalParameters();
+    this->m_MattesAssociate->m_NumberOfSparseParameterBlocks =
+      std::max< SizeValueType >( 1, std::min< SizeValueType >( localNumberOfThreadsUsed, numberOfParameters ) );
+    this->m_MattesAssociate->m_SparseParameterBlockSize =
+      ( numberOfParameters + this->m_MattesAssociate->m_NumberOfSparseParameterBlocks - 1 )
+      / this->m_MattesAssociate->m_NumberOfSparseParameterBlocks;
+    this->m_MattesAssociate->m_ThreaderSparseDerivativeSamples.resize( localNumberOfThreadsUsed );
+    for( auto & samples : this->m_MattesAssociate->m_ThreaderSparseDerivativeSamples )
+      {
+      samples.clear();
+      }
+    this->m_MattesAssociate->m_ThreaderSparseDerivativeEntries.resize(
+      localNumberOfThreadsUsed * this->m_MattesAssociate->m_NumberOfSparseParameterBlocks );
+    for( auto & entries : this->m_MattesAssociate->m_ThreaderSparseDerivativeEntries )
+      {
+      entries.clear();
+      }
+    }
+  else if(  this->m_MattesAssociate->GetComputeDerivative() && ! this->m_MattesAssociate->HasLocalSupport() )
     {
     // Don't need this with global transforms
     this->m_MattesAssociate->m_PRatioArray.resize(0);
@@ -325,10 +353,15 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
       }
     }
 
+  // With the sparse accumulation, a sparse transform Jacobian is used when
+  // the transform provides one.
+  const bool useSparseAccumulation = doComputeDerivative && this->m_MattesAssociate->UseSparseAccumulation();
+  const bool useSparseJacobian = useSparseAccumulation && this->GetUseSparseMovingTransformJacobian();
+
   // Compute the transform Jacobian.
   using JacobianReferenceType = JacobianType &;
   JacobianReferenceType jacobian = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobian;
-  if( doComputeDerivative )
+  if( doComputeDerivative && !useSparseJacobian )
     {
     JacobianReferenceType jacobianPositional = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobianPositional;
     this->m_MattesAssociate->GetMovingTransform()->
@@ -337,6 +370,60 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
                                                               jacobianPositional);
     }
 
+  // With the sparse accumulation, store the sample and the nonzero inner
+  // products of the Jacobian columns with the moving image gradient, which
+  // do not depend on the bin.
+  typename TMattesMutualInformationMetric::SparseDerivativeSample * sparseSample = nullptr;
+  if( useSparseAccumulation )
+    {
+    auto & samples = this->m_MattesAssociate->m_ThreaderSparseDerivativeSamples[threadId];
+    const auto sampleIndex = static_cast< SizeValueType >( samples.size() );
+    samples.emplace_back();
+    sparseSample = &samples.back();
+    sparseSample->JointPDFIndex = pdfMovingIndex + (fixedImageParzenWindowIndex * this->m_MattesAssociate->m_NumberOfHistogramBins);
+
+    const SizeValueType numberOfBlocks = this->m_MattesAssociate->m_NumberOfSparseParameterBlocks;
+    const NumberOfParametersType blockSize = this->m_MattesAssociate->m_SparseParameterBlockSize;
+    auto * entries = &( this->m_MattesAssociate->m_ThreaderSparseDerivativeEntries[threadId * numberOfBlocks] );
+    if( useSparseJacobian )
+      {
+      // The entries are summed, so a parameter may have an entry for each
+      // row of the sparse Jacobian.
+      const NumberOfParametersType rowSize = this->m_CachedNumberOfSparseJacobianParameters;
+      const NumberOfParametersType numberOfWeights = this->ComputeMovingTransformSparseJacobian( virtualPoint, threadId );
+      const auto & weights = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformSparseJacobianWeights;
+      const auto & parameterIndices =
+        this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformSparseJacobianParameterIndices;
+      for( SizeValueType dim = 0, lastDim = this->m_MattesAssociate->MovingImageDimension; dim < lastDim; ++dim )
+        {
+        for( NumberOfParametersType k = 0; k < numberOfWeights; ++k )
+          {
+          const NumberOfParametersType mu = parameterIndices[dim * rowSize + k];
+          const PDFValueType innerProduct = weights[dim * rowSize + k] * movingImageGradient[dim];
+          if( innerProduct != 0.0 )
+            {
+            entries[mu / blockSize].push_back( { sampleIndex, mu, innerProduct } );
+            }
+          }
+        }
+      }
+    else
+      {
+      for( NumberOfParametersType mu = 0, maxElement = this->GetCachedNumberOfLocalParameters(); mu < maxElement; ++mu )
+        {
+        PDFValueType innerProduct = 0.0;
+        for( SizeValueType dim = 0, lastDim = this->m_MattesAssociate->MovingImageDimension; dim < lastDim; ++dim )
+          {
+          innerProduct += jacobian[dim][mu] * movingImageGradient[dim];
+          }
+        if( innerProduct != 0.0 )
+          {
+          entries[mu / blockSize].push_back( { sampleIndex, mu, innerProduct } );
+          }
+        }
+      }
+    }
+
   SizeValueType movingParzenBin = 0;
 
   const bool transformIsDisplacement = this->m_MattesAssociate->m_MovingTransform->GetTransformCategory() == MovingTransformType::DisplacementField;
@@ -352,7 +439,11 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
       const PDFValueType cubicBSplineDerivativeValue = this->m_MattesAssociate->m_CubicBSplineDerivativeKernel->Evaluate(movingImageParzenWindowArg);
 
 
-      if( transformIsDisplacement )
+      if( useSparseAccumulation )
+        {
+        sparseSample->CubicBSplineDerivativeValues[movingParzenBin] = cubicBSplineDerivativeValue;
+        }
+      else if( transformIsDisplacement )
         {
         // Pointer to local derivative partial result container.
         // Not used with global support transforms.
@@ -447,7 +538,8 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
   /* Post-processing that is common the GetValue and GetValueAndDerivative */
   this->m_MattesAssociate->GetValueCommonAfterThreadedExecution();
 
-  if( this->m_MattesAssociate->GetComputeDerivative() && ( !this->m_MattesAssociate->HasLocalSupport() ) )
+  if( this->m_MattesAssociate->GetComputeDerivative() && ( !this->m_MattesAssociate->HasLocalSupport() )
+      && !this->m_MattesAssociate->UseSparseAccumulation() )
     {
     // This entire block of code is used to accumulate the per-thread buffers
     // into 1 thread.
@@ -55,6 +55,25 @@ MeanSquaresImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner
     return true;
     }
 
+  if( this->GetUseSparseMovingTransformJacobian() )
+    {
+    /* Only visit the parameters of the sparse Jacobian. */
+    FixedArray< MeasureType, ImageToImageMetricv4Type::MovingImageDimension > derivativeWRTImage;
+    derivativeWRTImage.Fill( NumericTraits<MeasureType>::ZeroValue() );
+    for ( unsigned int nc = 0; nc < nComponents; nc++ )
+      {
+      MeasureType diffValue = DefaultConvertPixelTraits<FixedImagePixelType>::GetNthComponent(nc,diff);
+      for ( SizeValueType dim = 0; dim < ImageToImageMetricv4Type::MovingImageDimension; dim++ )
+        {
+        derivativeWRTImage[dim] += 2.0 * diffValue *
+          DefaultConvertPixelTraits<MovingImageGradientType>::GetNthComponent(
+            ImageToImageMetricv4Type::FixedImageDimension * nc + dim, movingImageGradient );
+        }
+      }
+    this->ComputeSparseLocalDerivative( virtualPoint, derivativeWRTImage, localDerivativeReturn, threadId );
+    return true;
+    }
+
   /* Use a pre-allocated jacobian object for efficiency */
   using JacobianReferenceType = typename TImageToImageMetric::JacobianType &;
   JacobianReferenceType jacobian = this->m_GetValueAndDerivativePerThreadVariables[threadId].MovingTransformJacobian;
@@ -21,6 +21,9 @@
 
 #include "itkObjectToObjectMetric.h"
 #include "itkArray.h"
+#include "itkMultiThreaderBase.h"
+#include "itkRealTimeClock.h"
+#include <atomic>
 #include <deque>
 
 namespace itk
@@ -87,6 +90,20 @@ namespace itk
   * with a DisplacementFieldTransform, both Image and PointSet metrics will automatically
   * create a matching virtual domain during initialization if one has not been assigned by the user.
   *
+  * With UseConcurrentMetricEvaluation on, the component metrics are evaluated as concurrent
+  * tasks instead of one after another, each metric still using its own threads. The components
+  * then share the transforms and must only read them during evaluation, as the ITK metrics do.
+  * The values and derivatives are the same as with serial evaluation. The wall time of the last
+  * evaluation of each component, and the sum of the times of its evaluations since Initialize(),
+  * are returned by GetMetricEvaluationTimes() and GetAccumulatedMetricEvaluationTimes().
+  *
+  * With UseSharedMappedMovingPoints on, the image metrics which evaluate the same dense virtual
+  * domain with the same moving transform use the moving points of the virtual domain pixels
+  * mapped once by this metric at each evaluation, instead of each mapping them. This saves the
+  * transformation of the points, which dominates with e.g. displacement field or B-spline
+  * transforms, at the cost of one moving point per virtual domain pixel in memory.
+  * \sa ObjectToObjectMetric::SetSharedMappedMovingPoints
+  *
   * \ingroup ITKMetricsv4
   */
 template<unsigned int TFixedDimension, unsigned int TMovingDimension, typename TVirtualImage = Image<double, TFixedDimension>, class TInternalComputationValueType = double >
@@ -118,6 +135,9 @@ public:
   using CoordinateRepresentationType = typename Superclass::CoordinateRepresentationType;
   using MovingTransformType = typename Superclass::MovingTransformType;
   using FixedTransformType = typename Superclass::FixedTransformType;
+  using VirtualImageType = typename Superclass::VirtualImageType;
+  using VirtualRegionType = typename Superclass::VirtualRegionType;
+  using VirtualPointType = typename Superclass::VirtualPointType;
 
   /** type alias related to the metric queue */
   using MetricType = Superclass;
@@ -130,10 +150,30 @@ public:
   using WeightValueType = typename DerivativeType::ValueType;
   using WeightsArrayType = Array<WeightValueType>;
   using MetricValueArrayType = Array<MeasureType>;
+  using TimeStampType = RealTimeClock::TimeStampType;
+  using TimeArrayType = Array<TimeStampType>;
+
+  using MappedMovingPointsContainerType = typename Superclass::MappedMovingPointsContainerType;
 
   itkSetMacro(MetricWeights,WeightsArrayType);
   itkGetMacro(MetricWeights,WeightsArrayType);
 
+  /** Evaluate the component metrics as concurrent tasks. Off by default. */
+  itkSetMacro(UseConcurrentMetricEvaluation, bool);
+  itkGetConstMacro(UseConcurrentMetricEvaluation, bool);
+  itkBooleanMacro(UseConcurrentMetricEvaluation);
+
+  /** Map the virtual domain once for the image metrics which evaluate the
+   * same dense virtual domain with the same moving transform. Off by default.
+   * Takes effect in Initialize(). */
+  itkSetMacro(UseSharedMappedMovingPoints, bool);
+  itkGetConstMacro(UseSharedMappedMovingPoints, bool);
+  itkBooleanMacro(UseSharedMappedMovingPoints);
+
+  /** Number of component metrics which use the shared mapped moving points.
+   * Zero if the points are not shared. Only valid after Initialize(). */
+  SizeValueType GetNumberOfMetricsSharingMappedMovingPoints() const;
+
   /** Add a metric to the queue */
   void AddMetric( MetricType* metric );
 
@@ -187,6 +227,14 @@ public:
    *   assigned weights. It only has meaning after a call to GetValue(), GetDerivative() or GetValueAndDerivative(). */
   MeasureType GetWeightedValue() const;
 
+  /** Returns the wall times in seconds of the last evaluation of each
+   *  component metric. */
+  TimeArrayType GetMetricEvaluationTimes() const;
+
+  /** Returns the sums of the wall times in seconds of the evaluations of
+   *  each component metric since Initialize(). */
+  TimeArrayType GetAccumulatedMetricEvaluationTimes() const;
+
   /** Get the metrics queue */
   const MetricQueueType & GetMetricQueue() const;
 
@@ -206,10 +254,49 @@ protected:
   ~ObjectToObjectMultiMetricv4() override;
   void PrintSelf(std::ostream & os, Indent indent) const override;
 
+  /** Evaluate the component metrics as concurrent tasks. Their derivatives
+   *  are returned if \c derivatives is not nullptr. */
+  void EvaluateMetricsConcurrently( std::vector<DerivativeType> * derivatives ) const;
+
+  /** Evaluate the component metric j, and time it. */
+  void EvaluateMetric( SizeValueType j, DerivativeType * derivative ) const;
+
+  /** Map the virtual domain pixels with the moving transform, and pass the
+   *  points to the metrics sharing them. */
+  void MapSharedMovingPoints() const;
+
+  /** Reset the shared mapped moving points of the metrics sharing them. */
+  void ResetSharedMovingPoints() const;
+
+  /** The component metrics to evaluate, picked up by the threads of the
+   *  concurrent evaluation. */
+  struct ConcurrentEvaluationStruct
+    {
+    const Self *                 Metric;
+    std::vector<DerivativeType> *Derivatives;
+    std::atomic<SizeValueType>   NextMetric;
+    };
+
+  static ITK_THREAD_RETURN_TYPE ConcurrentEvaluationThreaderCallback( void *arg );
+
 private:
   MetricQueueType               m_MetricQueue;
   WeightsArrayType              m_MetricWeights;
   mutable MetricValueArrayType  m_MetricValueArray;
+
+  bool                          m_UseConcurrentMetricEvaluation;
+  MultiThreaderBase::Pointer    m_MetricThreader;
+
+  RealTimeClock::Pointer        m_RealTimeClock;
+  mutable TimeArrayType         m_MetricEvaluationTimes;
+  mutable TimeArrayType         m_AccumulatedMetricEvaluationTimes;
+
+  bool                          m_UseSharedMappedMovingPoints;
+  std::vector<SizeValueType>    m_MetricsSharingMappedMovingPoints;
+  mutable MappedMovingPointsContainerType m_SharedMappedMovingPoints;
+
+  /** Buffers of the component derivatives of the concurrent evaluation. */
+  mutable std::vector<DerivativeType> m_MetricDerivatives;
 };
 
 } //end namespace itk
@@ -20,6 +20,8 @@
 
 #include "itkObjectToObjectMultiMetricv4.h"
 #include "itkCompositeTransform.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -33,6 +35,11 @@ ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TI
 
   //We want the moving transform to be nullptr by default
   this->m_MovingTransform = nullptr;
+
+  this->m_UseConcurrentMetricEvaluation = false;
+  this->m_MetricThreader = MultiThreaderBase::New();
+  this->m_RealTimeClock = RealTimeClock::New();
+  this->m_UseSharedMappedMovingPoints = false;
 }
 
 /** Destructor */
@@ -144,6 +151,10 @@ ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TI
 
   /* resize */
   this->m_MetricValueArray.SetSize( this->GetNumberOfMetrics() );
+  this->m_MetricEvaluationTimes.SetSize( this->GetNumberOfMetrics() );
+  this->m_MetricEvaluationTimes.Fill( NumericTraits<TimeStampType>::ZeroValue() );
+  this->m_AccumulatedMetricEvaluationTimes.SetSize( this->GetNumberOfMetrics() );
+  this->m_AccumulatedMetricEvaluationTimes.Fill( NumericTraits<TimeStampType>::ZeroValue() );
 
   /* Verify the same transform is in all metrics. */
   const MovingTransformType * firstTransform = nullptr;
@@ -225,19 +236,79 @@ ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TI
       }
     }
 
+  /* Find the image metrics which can share the moving points of the virtual
+   * domain: the ones evaluating the same dense virtual domain with the same
+   * moving transform as the first of them. Sharing is only worth it for
+   * two metrics or more. */
+  this->m_MetricsSharingMappedMovingPoints.clear();
+  this->m_SharedMappedMovingPoints.clear();
+  if( this->m_UseSharedMappedMovingPoints )
+    {
+    for (SizeValueType j = 0; j < this->GetNumberOfMetrics(); j++)
+      {
+      const MetricType * metric = this->m_MetricQueue[j];
+      if( ! metric->SupportsSharedMappedMovingPoints() || metric->GetVirtualImage() == nullptr )
+        {
+        continue;
+        }
+      if( ! this->m_MetricsSharingMappedMovingPoints.empty() )
+        {
+        const MetricType * first = this->m_MetricQueue[this->m_MetricsSharingMappedMovingPoints[0]];
+        if( metric->GetMovingTransform() != first->GetMovingTransform()
+            || metric->GetVirtualRegion() != first->GetVirtualRegion()
+            || metric->GetVirtualOrigin() != first->GetVirtualOrigin()
+            || metric->GetVirtualSpacing() != first->GetVirtualSpacing()
+            || metric->GetVirtualDirection() != first->GetVirtualDirection() )
+          {
+          continue;
+          }
+        }
+      this->m_MetricsSharingMappedMovingPoints.push_back( j );
+      }
+    if( this->m_MetricsSharingMappedMovingPoints.size() < 2 )
+      {
+      this->m_MetricsSharingMappedMovingPoints.clear();
+      }
+    }
+
   /* Do this after we've setup local copy of virtual domain */
   Superclass::Initialize();
 }
 
+template<unsigned int TFixedDimension, unsigned int TMovingDimension, typename TVirtualImage, typename TInternalComputationValueType>
+SizeValueType
+ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>
+::GetNumberOfMetricsSharingMappedMovingPoints() const
+{
+  return static_cast<SizeValueType>( this->m_MetricsSharingMappedMovingPoints.size() );
+}
+
 template<unsigned int TFixedDimension, unsigned int TMovingDimension, typename TVirtualImage, typename TInternalComputationValueType>
 typename ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>::MeasureType
 ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>
 ::GetValue() const
 {
-  for (SizeValueType j = 0; j < this->GetNumberOfMetrics(); j++)
+  this->MapSharedMovingPoints();
+  try
     {
-    this->m_MetricValueArray[j] = this->m_MetricQueue[j]->GetValue();
+    if( this->m_UseConcurrentMetricEvaluation && this->GetNumberOfMetrics() > 1 )
+      {
+      this->EvaluateMetricsConcurrently( nullptr );
+      }
+    else
+      {
+      for (SizeValueType j = 0; j < this->GetNumberOfMetrics(); j++)
+        {
+        this->EvaluateMetric( j, nullptr );
+        }
+      }
+    }
+  catch( ... )
+    {
+    this->ResetSharedMovingPoints();
+    throw;
     }
+  this->ResetSharedMovingPoints();
 
   MeasureType firstValue = this->m_MetricValueArray[0];
   this->m_Value = firstValue;
@@ -264,45 +335,177 @@ ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TI
     }
   derivativeResult.Fill( NumericTraits<DerivativeValueType>::ZeroValue() );
 
+  // With concurrent evaluation, all the metrics are evaluated first, and
+  // their derivatives are then combined in the same order as when they are
+  // evaluated one after another.
+  const bool concurrent = this->m_UseConcurrentMetricEvaluation && this->GetNumberOfMetrics() > 1;
   DerivativeType  metricDerivative;
-  MeasureType     metricValue = NumericTraits<MeasureType>::ZeroValue();
 
-  // Loop over metrics
-  DerivativeValueType totalMagnitude = NumericTraits<DerivativeValueType>::ZeroValue();
-  for (SizeValueType j = 0; j < this->GetNumberOfMetrics(); j++)
+  this->MapSharedMovingPoints();
+  try
     {
-    this->m_MetricQueue[j]->GetValueAndDerivative( metricValue, metricDerivative);
-    this->m_MetricValueArray[j] = metricValue;
-
-    DerivativeValueType magnitude = metricDerivative.magnitude();
-    DerivativeValueType weightOverMagnitude = NumericTraits<DerivativeValueType>::ZeroValue();
-    totalMagnitude += magnitude;
+    if( concurrent )
+      {
+      this->m_MetricDerivatives.resize( this->GetNumberOfMetrics() );
+      this->EvaluateMetricsConcurrently( &this->m_MetricDerivatives );
+      }
 
-    if( magnitude > NumericTraits<DerivativeValueType>::epsilon() )
+    // Loop over metrics
+    DerivativeValueType totalMagnitude = NumericTraits<DerivativeValueType>::ZeroValue();
+    for (SizeValueType j = 0; j < this->GetNumberOfMetrics(); j++)
       {
-      weightOverMagnitude = this->m_MetricWeights[j] / magnitude;
+      if( ! concurrent )
+        {
+        this->EvaluateMetric( j, &metricDerivative );
+        }
+      const DerivativeType & derivative = concurrent ? this->m_MetricDerivatives[j] : metricDerivative;
+
+      DerivativeValueType magnitude = derivative.magnitude();
+      DerivativeValueType weightOverMagnitude = NumericTraits<DerivativeValueType>::ZeroValue();
+      totalMagnitude += magnitude;
+
+      if( magnitude > NumericTraits<DerivativeValueType>::epsilon() )
+        {
+        weightOverMagnitude = this->m_MetricWeights[j] / magnitude;
+        }
+      // derivative = \sum_j w_j * (dM_j / ||dM_j||)
+      for( NumberOfParametersType p = 0; p < this->GetNumberOfParameters(); p++ )
+        {
+        // roll our own loop to avoid temporary variable that could be large when using displacement fields.
+        derivativeResult[p] += ( derivative[p] * weightOverMagnitude );
+        }
       }
-    // derivative = \sum_j w_j * (dM_j / ||dM_j||)
+
+    // Scale by totalMagnitude to prevent what amounts to implicit step estimation from magnitude scaling.
+    // This keeps the behavior of this metric the same as a regular metric, with respect to derivative
+    // magnitudes.
+    totalMagnitude /= this->GetNumberOfMetrics();
     for( NumberOfParametersType p = 0; p < this->GetNumberOfParameters(); p++ )
       {
-      // roll our own loop to avoid temporary variable that could be large when using displacement fields.
-      derivativeResult[p] += ( metricDerivative[p] * weightOverMagnitude );
+      derivativeResult[p] *= totalMagnitude;
       }
     }
-
-  // Scale by totalMagnitude to prevent what amounts to implicit step estimation from magnitude scaling.
-  // This keeps the behavior of this metric the same as a regular metric, with respect to derivative
-  // magnitudes.
-  totalMagnitude /= this->GetNumberOfMetrics();
-  for( NumberOfParametersType p = 0; p < this->GetNumberOfParameters(); p++ )
+  catch( ... )
     {
-    derivativeResult[p] *= totalMagnitude;
+    this->ResetSharedMovingPoints();
+    throw;
     }
+  this->ResetSharedMovingPoints();
 
   firstValue = this->m_MetricValueArray[0];
   this->m_Value = firstValue;
 }
 
+template<unsigned int TFixedDimension, unsigned int TMovingDimension, typename TVirtualImage, typename TInternalComputationValueType>
+void
+ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>
+::EvaluateMetric( SizeValueType j, DerivativeType * derivative ) const
+{
+  const TimeStampType start = this->m_RealTimeClock->GetTimeInSeconds();
+  if( derivative != nullptr )
+    {
+    MeasureType metricValue = NumericTraits<MeasureType>::ZeroValue();
+    this->m_MetricQueue[j]->GetValueAndDerivative( metricValue, *derivative );
+    this->m_MetricValueArray[j] = metricValue;
+    }
+  else
+    {
+    this->m_MetricValueArray[j] = this->m_MetricQueue[j]->GetValue();
+    }
+  const TimeStampType time = this->m_RealTimeClock->GetTimeInSeconds() - start;
+  this->m_MetricEvaluationTimes[j] = time;
+  this->m_AccumulatedMetricEvaluationTimes[j] += time;
+}
+
+template<unsigned int TFixedDimension, unsigned int TMovingDimension, typename TVirtualImage, typename TInternalComputationValueType>
+void
+ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>
+::EvaluateMetricsConcurrently( std::vector<DerivativeType> * derivatives ) const
+{
+  // The metrics run their own threads within these ones: with the pool
+  // threader, at least one thread of the pool is left for them, or they
+  // would wait forever.
+  const ThreadIdType numberOfThreads = static_cast<ThreadIdType>( std::min<SizeValueType>(
+    this->GetNumberOfMetrics(), MultiThreaderBase::GetGlobalDefaultNumberOfThreads() ) );
+
+  ConcurrentEvaluationStruct str;
+  str.Metric = this;
+  str.Derivatives = derivatives;
+  str.NextMetric = 0;
+
+  this->m_MetricThreader->SetNumberOfThreads( numberOfThreads );
+  this->m_MetricThreader->SetSingleMethod( this->ConcurrentEvaluationThreaderCallback, &str );
+  this->m_MetricThreader->SingleMethodExecute();
+}
+
+template<unsigned int TFixedDimension, unsigned int TMovingDimension, typename TVirtualImage, typename TInternalComputationValueType>
+ITK_THREAD_RETURN_TYPE
+ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>
+::ConcurrentEvaluationThreaderCallback( void * arg )
+{
+  auto * threadInfo = static_cast<MultiThreaderBase::ThreadInfoStruct *>( arg );
+  auto * str = static_cast<ConcurrentEvaluationStruct *>( threadInfo->UserData );
+
+  /* Pick the metrics one at a time, so that the threads stay busy when the
+   * metrics take different times. */
+  for( SizeValueType j = str->NextMetric++; j < str->Metric->GetNumberOfMetrics(); j = str->NextMetric++ )
+    {
+    str->Metric->EvaluateMetric( j, str->Derivatives != nullptr ? &( *str->Derivatives )[j] : nullptr );
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template<unsigned int TFixedDimension, unsigned int TMovingDimension, typename TVirtualImage, typename TInternalComputationValueType>
+void
+ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>
+::MapSharedMovingPoints() const
+{
+  if( this->m_MetricsSharingMappedMovingPoints.empty() )
+    {
+    return;
+    }
+
+  const MetricType * first = this->m_MetricQueue[this->m_MetricsSharingMappedMovingPoints[0]];
+  const VirtualImageType * virtualImage = first->GetVirtualImage();
+  const MovingTransformType * transform = first->GetMovingTransform();
+  const VirtualRegionType & region = virtualImage->GetBufferedRegion();
+  this->m_SharedMappedMovingPoints.resize( region.GetNumberOfPixels() );
+
+  // Map the points as the image metrics do, converting them to the point
+  // type of the transform first.
+  MappedMovingPointsContainerType & points = this->m_SharedMappedMovingPoints;
+  MultiThreaderBase::Pointer multiThreader = MultiThreaderBase::New();
+  multiThreader->ParallelizeImageRegion<Self::VirtualDimension>( region,
+    [virtualImage, transform, &points](const VirtualRegionType & subRegion)
+      {
+      VirtualPointType virtualPoint;
+      typename MovingTransformType::InputPointType localVirtualPoint;
+      for( ImageRegionConstIteratorWithIndex<VirtualImageType> it( virtualImage, subRegion ); !it.IsAtEnd(); ++it )
+        {
+        virtualImage->TransformIndexToPhysicalPoint( it.GetIndex(), virtualPoint );
+        localVirtualPoint.CastFrom( virtualPoint );
+        points[virtualImage->ComputeOffset( it.GetIndex() )] = transform->TransformPoint( localVirtualPoint );
+        }
+      },
+    nullptr );
+
+  for( SizeValueType j : this->m_MetricsSharingMappedMovingPoints )
+    {
+    this->m_MetricQueue[j]->SetSharedMappedMovingPoints( &this->m_SharedMappedMovingPoints );
+    }
+}
+
+template<unsigned int TFixedDimension, unsigned int TMovingDimension, typename TVirtualImage, typename TInternalComputationValueType>
+void
+ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>
+::ResetSharedMovingPoints() const
+{
+  for( SizeValueType j : this->m_MetricsSharingMappedMovingPoints )
+    {
+    this->m_MetricQueue[j]->SetSharedMappedMovingPoints( nullptr );
+    }
+}
+
 template<unsigned int TFixedDimension, unsigned int TMovingDimension, typename TVirtualImage, typename TInternalComputationValueType>
 typename ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>::MetricValueArrayType
 ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>
@@ -326,6 +529,22 @@ ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TI
   return value;
 }
 
+template<unsigned int TFixedDimension, unsigned int TMovingDimension, typename TVirtualImage, typename TInternalComputationValueType>
+typename ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>::TimeArrayType
+ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>
+::GetMetricEvaluationTimes() const
+{
+  return this->m_MetricEvaluationTimes;
+}
+
+template<unsigned int TFixedDimension, unsigned int TMovingDimension, typename TVirtualImage, typename TInternalComputationValueType>
+typename ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>::TimeArrayType
+ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>
+::GetAccumulatedMetricEvaluationTimes() const
+{
+  return this->m_AccumulatedMetricEvaluationTimes;
+}
+
 template<unsigned int TFixedDimension, unsigned int TMovingDimension, typename TVirtualImage, typename TInternalComputationValueType>
 const typename ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>::MetricQueueType &
 ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TInternalComputationValueType>
@@ -356,6 +575,12 @@ ObjectToObjectMultiMetricv4<TFixedDimension, TMovingDimension, TVirtualImage, TI
 ::PrintSelf(std::ostream & os, Indent indent) const
 {
   os << indent << "Weights of metric derivatives: " << this->m_MetricWeights << std::endl;
+  os << indent << "UseConcurrentMetricEvaluation: " << this->m_UseConcurrentMetricEvaluation << std::endl;
+  os << indent << "UseSharedMappedMovingPoints: " << this->m_UseSharedMappedMovingPoints << std::endl;
+  os << indent << "Number of metrics sharing mapped moving points: "
+     << this->GetNumberOfMetricsSharingMappedMovingPoints() << std::endl;
+  os << indent << "Metric evaluation times: " << this->m_MetricEvaluationTimes << std::endl;
+  os << indent << "Accumulated metric evaluation times: " << this->m_AccumulatedMetricEvaluationTimes << std::endl;
   os << indent << "The multivariate contains the following metrics: " << std::endl << std::endl;
   for (SizeValueType i = 0; i < this->GetNumberOfMetrics(); i++)
     {
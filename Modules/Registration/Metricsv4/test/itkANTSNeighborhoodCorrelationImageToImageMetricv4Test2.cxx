@@ -0,0 +1,186 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkANTSNeighborhoodCorrelationImageToImageMetricv4.h"
+#include "itkAffineTransform.h"
+#include "itkDisplacementFieldTransform.h"
+#include "itkImageMaskSpatialObject.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+
+template< unsigned int VDimension >
+typename itk::Image< float, VDimension >::Pointer
+CreateImage( const itk::Size< VDimension > & size, double shift, GeneratorType * generator )
+{
+  using ImageType = itk::Image< float, VDimension >;
+  typename ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  typename ImageType::SpacingType spacing;
+  for( unsigned int d = 0; d < VDimension; ++d )
+    {
+    spacing[d] = 1.0 + 0.25 * d;
+    }
+  image->SetSpacing( spacing );
+  for( itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetBufferedRegion() ); !it.IsAtEnd(); ++it )
+    {
+    double r2 = 0.0;
+    for( unsigned int d = 0; d < VDimension; ++d )
+      {
+      const double x = it.GetIndex()[d] - 0.5 * size[d] + ( d == 0 ? shift : 0.0 );
+      r2 += x * x;
+      }
+    it.Set( static_cast< float >( 100.0 * std::exp( -r2 / 60.0 ) + 10.0 * generator->GetVariate() ) );
+    }
+  return image;
+}
+
+// Compare the value and the derivative computed with the separable box
+// sums with the ones of the scanning window, for several radii and numbers
+// of threads.
+template< unsigned int VDimension >
+bool TestBoxSums( const itk::Size< VDimension > & size, GeneratorType * generator )
+{
+  using ImageType = itk::Image< float, VDimension >;
+  using MetricType = itk::ANTSNeighborhoodCorrelationImageToImageMetricv4< ImageType, ImageType >;
+  using MaskType = itk::ImageMaskSpatialObject< VDimension >;
+  using MaskImageType = typename MaskType::ImageType;
+
+  const typename ImageType::Pointer fixed = CreateImage< VDimension >( size, 0.0, generator );
+  const typename ImageType::Pointer moving = CreateImage< VDimension >( size, 1.5, generator );
+
+  // a mask of the fixed image, which excludes a block of voxels
+  typename MaskImageType::Pointer maskImage = MaskImageType::New();
+  maskImage->CopyInformation( fixed );
+  maskImage->SetRegions( fixed->GetBufferedRegion() );
+  maskImage->Allocate();
+  for( itk::ImageRegionIteratorWithIndex< MaskImageType > it( maskImage, maskImage->GetBufferedRegion() ); !it.IsAtEnd(); ++it )
+    {
+    it.Set( it.GetIndex()[0] > 4 && it.GetIndex()[0] < 9 && it.GetIndex()[1] < 6 ? 0 : 1 );
+    }
+  typename MaskType::Pointer mask = MaskType::New();
+  mask->SetImage( maskImage );
+
+  // a displacement field transform, and an affine transform
+  using DisplacementFieldTransformType = itk::DisplacementFieldTransform< double, VDimension >;
+  using FieldType = typename DisplacementFieldTransformType::DisplacementFieldType;
+  typename FieldType::Pointer field = FieldType::New();
+  field->CopyInformation( fixed );
+  field->SetRegions( fixed->GetBufferedRegion() );
+  field->Allocate();
+  for( itk::ImageRegionIteratorWithIndex< FieldType > it( field, field->GetBufferedRegion() ); !it.IsAtEnd(); ++it )
+    {
+    typename FieldType::PixelType displacement;
+    for( unsigned int d = 0; d < VDimension; ++d )
+      {
+      displacement[d] = generator->GetVariate() - 0.5;
+      }
+    it.Set( displacement );
+    }
+  typename DisplacementFieldTransformType::Pointer displacementTransform = DisplacementFieldTransformType::New();
+  displacementTransform->SetDisplacementField( field );
+
+  using AffineTransformType = itk::AffineTransform< double, VDimension >;
+  typename AffineTransformType::Pointer affineTransform = AffineTransformType::New();
+  typename AffineTransformType::OutputVectorType translation;
+  translation.Fill( 0.7 );
+  affineTransform->Translate( translation );
+  affineTransform->Rotate2D( 0.05 );
+
+  std::vector< typename MetricType::MovingTransformType * > transforms;
+  transforms.push_back( displacementTransform );
+  transforms.push_back( affineTransform );
+
+  std::vector< typename MetricType::RadiusType > radii( 2 );
+  radii[0].Fill( 2 );
+  for( unsigned int d = 0; d < VDimension; ++d )
+    {
+    radii[1][d] = 3 - d;
+    }
+
+  bool passed = true;
+  for( typename MetricType::MovingTransformType * transform : transforms )
+    {
+    for( const typename MetricType::RadiusType & radius : radii )
+      {
+      for( unsigned int threads = 1; threads < 8; threads += 3 )
+        {
+        typename MetricType::MeasureType values[2];
+        typename MetricType::DerivativeType derivatives[2];
+        for( unsigned int boxSums = 0; boxSums < 2; ++boxSums )
+          {
+          typename MetricType::Pointer metric = MetricType::New();
+          metric->SetFixedImage( fixed );
+          metric->SetMovingImage( moving );
+          metric->SetFixedImageMask( mask );
+          metric->SetMovingTransform( transform );
+          metric->SetRadius( radius );
+          metric->SetMaximumNumberOfThreads( threads );
+          metric->SetUseSeparableBoxSums( boxSums );
+          TRY_EXPECT_NO_EXCEPTION( metric->Initialize() );
+          TRY_EXPECT_NO_EXCEPTION( metric->GetValueAndDerivative( values[boxSums], derivatives[boxSums] ) );
+          if( boxSums )
+            {
+            // the value alone
+            typename MetricType::MeasureType value = 0.0;
+            TRY_EXPECT_NO_EXCEPTION( value = metric->GetValue() );
+            passed = passed && itk::Math::FloatAlmostEqual( value, values[1], 4, 1e-12 );
+            }
+          }
+
+        double maximumDerivative = 0.0;
+        double maximumError = 0.0;
+        for( unsigned int i = 0; i < derivatives[0].Size(); ++i )
+          {
+          maximumDerivative = std::max( maximumDerivative, std::abs( derivatives[0][i] ) );
+          maximumError = std::max( maximumError, std::abs( derivatives[0][i] - derivatives[1][i] ) );
+          }
+        std::cout << VDimension << "D, " << transform->GetNameOfClass() << ", radius " << radius << ", " << threads
+                  << " threads: value " << values[0] << " vs " << values[1] << ", derivative error "
+                  << maximumError << " of " << maximumDerivative << std::endl;
+        passed = passed && itk::Math::FloatAlmostEqual( values[0], values[1], 4, 1e-10 ) && maximumDerivative > 0.0
+                 && maximumError <= 1e-8 * maximumDerivative;
+        }
+      }
+    }
+  return passed;
+}
+}
+
+int itkANTSNeighborhoodCorrelationImageToImageMetricv4Test2( int, char * [] )
+{
+  using MetricType = itk::ANTSNeighborhoodCorrelationImageToImageMetricv4< itk::Image< float, 2 >, itk::Image< float, 2 > >;
+  MetricType::Pointer metric = MetricType::New();
+  TEST_SET_GET_BOOLEAN( metric, UseSeparableBoxSums, false );
+
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 2018 );
+
+  bool passed = true;
+  itk::Size< 2 > size2D = {{ 31, 23 }};
+  passed = TestBoxSums< 2 >( size2D, generator ) && passed;
+  itk::Size< 3 > size3D = {{ 17, 14, 12 }};
+  passed = TestBoxSums< 3 >( size3D, generator ) && passed;
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
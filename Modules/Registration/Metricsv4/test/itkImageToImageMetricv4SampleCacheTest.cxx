@@ -0,0 +1,239 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkANTSNeighborhoodCorrelationImageToImageMetricv4.h"
+#include "itkAffineTransform.h"
+#include "itkCorrelationImageToImageMetricv4.h"
+#include "itkDemonsImageToImageMetricv4.h"
+#include "itkDisplacementFieldTransform.h"
+#include "itkImageMaskSpatialObject.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkJointHistogramMutualInformationImageToImageMetricv4.h"
+#include "itkMattesMutualInformationImageToImageMetricv4.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+#include "itkTranslationTransform.h"
+
+/*
+ * Compare the values and derivatives of the v4 image metrics evaluated on a
+ * sampled point set with and without the sample cache, with a fixed image
+ * mask, with fixed image gradients from a filter or a calculator, after the
+ * fixed transform is modified, and after the point set is updated.
+ */
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+using ImageType = itk::Image< double, Dimension >;
+using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+using PointSetType = itk::PointSet< double, Dimension >;
+using MaskType = itk::ImageMaskSpatialObject< Dimension >;
+using FixedTransformType = itk::TranslationTransform< double, Dimension >;
+
+ImageType::Pointer CreateImage( double shift, GeneratorType * generator )
+{
+  ImageType::SizeType size = {{ 48, 40 }};
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  for( itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetBufferedRegion() ); !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 22.0 + shift;
+    const double y = it.GetIndex()[1] - 18.0;
+    it.Set( 100.0 * std::exp( -( x * x + 2.0 * y * y ) / 200.0 ) + 30.0 * ( x > 4.0 ) + 5.0 * generator->GetVariate() );
+    }
+  return image;
+}
+
+// The mask excludes the voxels with x < 8.
+MaskType::Pointer CreateMask( const ImageType * image )
+{
+  using MaskImageType = MaskType::ImageType;
+  MaskImageType::Pointer maskImage = MaskImageType::New();
+  maskImage->CopyInformation( image );
+  maskImage->SetRegions( image->GetBufferedRegion() );
+  maskImage->Allocate();
+  for( itk::ImageRegionIteratorWithIndex< MaskImageType > it( maskImage, maskImage->GetBufferedRegion() ); !it.IsAtEnd(); ++it )
+    {
+    it.Set( it.GetIndex()[0] < 8 ? 0 : 1 );
+    }
+  MaskType::Pointer mask = MaskType::New();
+  mask->SetImage( maskImage );
+  return mask;
+}
+
+// Points at random positions of the fixed image, some of them outside.
+PointSetType::Pointer CreatePointSet( GeneratorType * generator, itk::SizeValueType numberOfPoints )
+{
+  PointSetType::Pointer pointSet = PointSetType::New();
+  for( itk::SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+    PointSetType::PointType point;
+    point[0] = generator->GetUniformVariate( 0.0, 47.0 );
+    point[1] = generator->GetUniformVariate( 0.0, 39.0 );
+    pointSet->SetPoint( i, point );
+    }
+  return pointSet;
+}
+
+template< typename TMetric >
+bool Compare( const char * name, TMetric * cached, TMetric * uncached )
+{
+  typename TMetric::MeasureType values[2];
+  typename TMetric::DerivativeType derivatives[2];
+  TRY_EXPECT_NO_EXCEPTION( cached->GetValueAndDerivative( values[0], derivatives[0] ) );
+  TRY_EXPECT_NO_EXCEPTION( uncached->GetValueAndDerivative( values[1], derivatives[1] ) );
+
+  double maximumDerivative = 0.0;
+  double maximumError = 0.0;
+  for( unsigned int i = 0; i < derivatives[0].Size(); ++i )
+    {
+    maximumDerivative = std::max( maximumDerivative, std::abs( derivatives[1][i] ) );
+    maximumError = std::max( maximumError, std::abs( derivatives[0][i] - derivatives[1][i] ) );
+    }
+  std::cout << name << ": value " << values[0] << " (" << values[1] << " without the cache), "
+            << cached->GetNumberOfValidPoints() << " valid points, derivative error " << maximumError
+            << " of " << maximumDerivative << std::endl;
+  if( !itk::Math::FloatAlmostEqual( values[0], values[1], 4, 1e-12 ) || maximumDerivative == 0.0
+      || maximumError > 1e-12 * maximumDerivative
+      || cached->GetNumberOfValidPoints() != uncached->GetNumberOfValidPoints() )
+    {
+    std::cerr << name << ": the cached evaluation differs" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+template< typename TMetric >
+bool TestMetric( const char * name, typename TMetric::MovingTransformType * movingTransform, bool useGradientFilter,
+                 const ImageType * fixed, const ImageType * moving, GeneratorType * generator )
+{
+  const MaskType::Pointer mask = CreateMask( fixed );
+  const PointSetType::Pointer pointSet = CreatePointSet( generator, 300 );
+
+  typename TMetric::Pointer metrics[2];
+  FixedTransformType::Pointer fixedTransforms[2];
+  for( unsigned int cache = 0; cache < 2; ++cache )
+    {
+    fixedTransforms[cache] = FixedTransformType::New();
+    fixedTransforms[cache]->SetIdentity();
+    metrics[cache] = TMetric::New();
+    metrics[cache]->SetFixedImage( fixed );
+    metrics[cache]->SetMovingImage( moving );
+    metrics[cache]->SetFixedTransform( fixedTransforms[cache] );
+    metrics[cache]->SetMovingTransform( movingTransform );
+    metrics[cache]->SetFixedImageMask( mask );
+    metrics[cache]->SetFixedSampledPointSet( pointSet );
+    metrics[cache]->SetUseFixedSampledPointSet( true );
+    metrics[cache]->SetUseFixedImageGradientFilter( useGradientFilter );
+    metrics[cache]->SetUseMovingImageGradientFilter( useGradientFilter );
+    metrics[cache]->SetMaximumNumberOfThreads( 3 );
+    metrics[cache]->SetUseSampleCache( cache == 0 );
+    TRY_EXPECT_NO_EXCEPTION( metrics[cache]->Initialize() );
+    }
+
+  std::string label( name );
+  label += useGradientFilter ? " with gradient filters" : " with gradient calculators";
+  bool passed = Compare( label.c_str(), metrics[0].GetPointer(), metrics[1].GetPointer() );
+  // twice, from the same cache
+  passed = Compare( label.c_str(), metrics[0].GetPointer(), metrics[1].GetPointer() ) && passed;
+
+  // The cache follows the fixed transform.
+  FixedTransformType::ParametersType translation( Dimension );
+  translation[0] = 1.25;
+  translation[1] = -0.5;
+  for( unsigned int cache = 0; cache < 2; ++cache )
+    {
+    fixedTransforms[cache]->SetParameters( translation );
+    }
+  passed = Compare( ( label + ", translated fixed transform" ).c_str(), metrics[0].GetPointer(), metrics[1].GetPointer() )
+           && passed;
+
+  // The cache follows the updated point set.
+  const PointSetType::Pointer updatedPointSet = CreatePointSet( generator, 200 );
+  for( unsigned int cache = 0; cache < 2; ++cache )
+    {
+    TRY_EXPECT_NO_EXCEPTION( metrics[cache]->UpdateFixedSampledPointSet( updatedPointSet ) );
+    }
+  passed = Compare( ( label + ", updated point set" ).c_str(), metrics[0].GetPointer(), metrics[1].GetPointer() )
+           && passed;
+
+  return passed;
+}
+}
+
+int itkImageToImageMetricv4SampleCacheTest( int, char * [] )
+{
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 2018 );
+  const ImageType::Pointer fixed = CreateImage( 0.0, generator );
+  const ImageType::Pointer moving = CreateImage( 2.5, generator );
+
+  using MeanSquaresMetricType = itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType >;
+  MeanSquaresMetricType::Pointer metric = MeanSquaresMetricType::New();
+  TEST_SET_GET_BOOLEAN( metric, UseSampleCache, false );
+
+  using AffineTransformType = itk::AffineTransform< double, Dimension >;
+  AffineTransformType::Pointer affine = AffineTransformType::New();
+  AffineTransformType::ParametersType affineParameters( affine->GetNumberOfParameters() );
+  affineParameters[0] = 1.02;
+  affineParameters[1] = 0.05;
+  affineParameters[2] = -0.03;
+  affineParameters[3] = 0.97;
+  affineParameters[4] = 1.5;
+  affineParameters[5] = -0.5;
+  affine->SetParameters( affineParameters );
+
+  // The Demons metric uses the fixed image gradients, with a displacement
+  // field transform.
+  using DisplacementTransformType = itk::DisplacementFieldTransform< double, Dimension >;
+  using FieldType = DisplacementTransformType::DisplacementFieldType;
+  FieldType::Pointer field = FieldType::New();
+  field->CopyInformation( fixed );
+  field->SetRegions( fixed->GetBufferedRegion() );
+  field->Allocate();
+  for( itk::ImageRegionIteratorWithIndex< FieldType > it( field, field->GetBufferedRegion() ); !it.IsAtEnd(); ++it )
+    {
+    FieldType::PixelType displacement;
+    displacement[0] = generator->GetUniformVariate( -1.0, 1.0 );
+    displacement[1] = generator->GetUniformVariate( -1.0, 1.0 );
+    it.Set( displacement );
+    }
+  DisplacementTransformType::Pointer displacementTransform = DisplacementTransformType::New();
+  displacementTransform->SetDisplacementField( field );
+
+  using MattesMetricType = itk::MattesMutualInformationImageToImageMetricv4< ImageType, ImageType >;
+  using JointHistogramMetricType = itk::JointHistogramMutualInformationImageToImageMetricv4< ImageType, ImageType >;
+  using CorrelationMetricType = itk::CorrelationImageToImageMetricv4< ImageType, ImageType >;
+  using ANTSMetricType = itk::ANTSNeighborhoodCorrelationImageToImageMetricv4< ImageType, ImageType >;
+  using DemonsMetricType = itk::DemonsImageToImageMetricv4< ImageType, ImageType >;
+
+  bool passed = true;
+  for( unsigned int filter = 0; filter < 2; ++filter )
+    {
+    passed = TestMetric< MeanSquaresMetricType >( "MeanSquares", affine, filter, fixed, moving, generator ) && passed;
+    passed = TestMetric< MattesMetricType >( "Mattes", affine, filter, fixed, moving, generator ) && passed;
+    passed = TestMetric< JointHistogramMetricType >( "JointHistogram", affine, filter, fixed, moving, generator ) && passed;
+    passed = TestMetric< CorrelationMetricType >( "Correlation", affine, filter, fixed, moving, generator ) && passed;
+    passed = TestMetric< ANTSMetricType >( "ANTSNeighborhoodCorrelation", affine, filter, fixed, moving, generator ) && passed;
+    passed = TestMetric< DemonsMetricType >( "Demons", displacementTransform, filter, fixed, moving, generator ) && passed;
+    }
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
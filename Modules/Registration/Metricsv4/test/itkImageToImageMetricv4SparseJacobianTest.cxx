@@ -0,0 +1,226 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkANTSNeighborhoodCorrelationImageToImageMetricv4.h"
+#include "itkBSplineTransform.h"
+#include "itkCompositeTransform.h"
+#include "itkCorrelationImageToImageMetricv4.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkJointHistogramMutualInformationImageToImageMetricv4.h"
+#include "itkMattesMutualInformationImageToImageMetricv4.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkRegistrationParameterScalesFromJacobian.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Compare the values and derivatives of the metrics, and the scales
+ * estimated from the Jacobian, computed with the sparse Jacobian of a
+ * B-spline transform with the ones computed with its dense Jacobian, when
+ * it is wrapped in a composite transform.
+ */
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+using ImageType = itk::Image< float, Dimension >;
+using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+using BSplineTransformType = itk::BSplineTransform< double, Dimension, 3 >;
+using CompositeTransformType = itk::CompositeTransform< double, Dimension >;
+
+ImageType::Pointer CreateImage( double shift, GeneratorType * generator )
+{
+  ImageType::SizeType size = {{ 48, 40 }};
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.5;
+  spacing[1] = 1.0;
+  image->SetSpacing( spacing );
+  for( itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetBufferedRegion() ); !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 22.0 + shift;
+    const double y = it.GetIndex()[1] - 19.0;
+    it.Set( static_cast< float >( 100.0 * std::exp( -( x * x + 2.0 * y * y ) / 300.0 )
+                                  + 40.0 * ( x > 3.0 ) + 5.0 * generator->GetVariate() ) );
+    }
+  return image;
+}
+
+bool CompareDerivatives( const char * name, double value, double denseValue,
+                         const itk::Array< double > & derivative, const itk::Array< double > & denseDerivative )
+{
+  double maximumDerivative = 0.0;
+  double maximumError = 0.0;
+  for( unsigned int i = 0; i < derivative.Size(); ++i )
+    {
+    maximumDerivative = std::max( maximumDerivative, std::abs( denseDerivative[i] ) );
+    maximumError = std::max( maximumError, std::abs( derivative[i] - denseDerivative[i] ) );
+    }
+  std::cout << name << ": value " << value << ", derivative error " << maximumError << " of "
+            << maximumDerivative << std::endl;
+  if( !itk::Math::FloatAlmostEqual( value, denseValue, 4, 1e-12 ) || maximumDerivative == 0.0
+      || maximumError > 1e-10 * maximumDerivative )
+    {
+    std::cerr << name << ": the sparse and dense Jacobians give different results" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+template< typename TMetric >
+bool TestMetric( const char * name, TMetric * metric, TMetric * denseMetric,
+                 BSplineTransformType * transform, const ImageType * fixed, const ImageType * moving )
+{
+  CompositeTransformType::Pointer composite = CompositeTransformType::New();
+  composite->AddTransform( transform );
+
+  TMetric * metrics[2] = { metric, denseMetric };
+  typename TMetric::MeasureType values[2];
+  typename TMetric::DerivativeType derivatives[2];
+  for( unsigned int dense = 0; dense < 2; ++dense )
+    {
+    metrics[dense]->SetFixedImage( fixed );
+    metrics[dense]->SetMovingImage( moving );
+    if( dense )
+      {
+      metrics[dense]->SetMovingTransform( composite );
+      }
+    else
+      {
+      metrics[dense]->SetMovingTransform( transform );
+      }
+    metrics[dense]->SetMaximumNumberOfThreads( 3 );
+    TRY_EXPECT_NO_EXCEPTION( metrics[dense]->Initialize() );
+    // twice, to reuse the buffers
+    for( unsigned int evaluation = 0; evaluation < 2; ++evaluation )
+      {
+      TRY_EXPECT_NO_EXCEPTION( metrics[dense]->GetValueAndDerivative( values[dense], derivatives[dense] ) );
+      }
+    }
+  return CompareDerivatives( name, values[0], values[1], derivatives[0], derivatives[1] );
+}
+
+bool TestScalesEstimator( BSplineTransformType * transform, const ImageType * fixed, const ImageType * moving )
+{
+  using MetricType = itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType >;
+  using ScalesEstimatorType = itk::RegistrationParameterScalesFromJacobian< MetricType >;
+
+  CompositeTransformType::Pointer composite = CompositeTransformType::New();
+  composite->AddTransform( transform );
+
+  ScalesEstimatorType::ScalesType scales[2];
+  ScalesEstimatorType::FloatType stepScales[2];
+  ScalesEstimatorType::ParametersType step( transform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < step.Size(); ++i )
+    {
+    step[i] = std::sin( 0.1 * i );
+    }
+  for( unsigned int dense = 0; dense < 2; ++dense )
+    {
+    MetricType::Pointer metric = MetricType::New();
+    metric->SetFixedImage( fixed );
+    metric->SetMovingImage( moving );
+    if( dense )
+      {
+      metric->SetMovingTransform( composite );
+      }
+    else
+      {
+      metric->SetMovingTransform( transform );
+      }
+    TRY_EXPECT_NO_EXCEPTION( metric->Initialize() );
+
+    ScalesEstimatorType::Pointer scalesEstimator = ScalesEstimatorType::New();
+    scalesEstimator->SetMetric( metric );
+    scalesEstimator->EstimateScales( scales[dense] );
+    stepScales[dense] = scalesEstimator->EstimateStepScale( step );
+    }
+
+  return CompareDerivatives( "RegistrationParameterScalesFromJacobian", stepScales[0], stepScales[1],
+                             scales[0], scales[1] );
+}
+}
+
+int itkImageToImageMetricv4SparseJacobianTest( int, char * [] )
+{
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 2018 );
+  const ImageType::Pointer fixed = CreateImage( 0.0, generator );
+  const ImageType::Pointer moving = CreateImage( 3.0, generator );
+
+  // The transform domain covers a part of the image only.
+  BSplineTransformType::Pointer transform = BSplineTransformType::New();
+  BSplineTransformType::PhysicalDimensionsType physicalDimensions;
+  BSplineTransformType::MeshSizeType meshSize;
+  BSplineTransformType::OriginType origin;
+  for( unsigned int d = 0; d < Dimension; ++d )
+    {
+    physicalDimensions[d] = 0.8 * fixed->GetSpacing()[d] * ( fixed->GetBufferedRegion().GetSize()[d] - 1 );
+    meshSize[d] = 5 + d;
+    origin[d] = 2.0;
+    }
+  transform->SetTransformDomainOrigin( origin );
+  transform->SetTransformDomainPhysicalDimensions( physicalDimensions );
+  transform->SetTransformDomainMeshSize( meshSize );
+  transform->SetTransformDomainDirection( fixed->GetDirection() );
+  BSplineTransformType::ParametersType parameters( transform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < parameters.Size(); ++i )
+    {
+    parameters[i] = 2.0 * generator->GetVariate() - 1.0;
+    }
+  transform->SetParameters( parameters );
+
+  bool passed = true;
+
+  using MeanSquaresMetricType = itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType >;
+  passed = TestMetric< MeanSquaresMetricType >( "MeanSquares", MeanSquaresMetricType::New(),
+                                                MeanSquaresMetricType::New(), transform, fixed, moving ) && passed;
+
+  MeanSquaresMetricType::Pointer correctedMetric = MeanSquaresMetricType::New();
+  correctedMetric->SetUseFloatingPointCorrection( true );
+  MeanSquaresMetricType::Pointer denseCorrectedMetric = MeanSquaresMetricType::New();
+  denseCorrectedMetric->SetUseFloatingPointCorrection( true );
+  passed = TestMetric< MeanSquaresMetricType >( "MeanSquares with floating point correction", correctedMetric,
+                                                denseCorrectedMetric, transform, fixed, moving ) && passed;
+
+  using CorrelationMetricType = itk::CorrelationImageToImageMetricv4< ImageType, ImageType >;
+  passed = TestMetric< CorrelationMetricType >( "Correlation", CorrelationMetricType::New(),
+                                                CorrelationMetricType::New(), transform, fixed, moving ) && passed;
+
+  using JointHistogramMetricType = itk::JointHistogramMutualInformationImageToImageMetricv4< ImageType, ImageType >;
+  passed = TestMetric< JointHistogramMetricType >( "JointHistogramMutualInformation", JointHistogramMetricType::New(),
+                                                   JointHistogramMetricType::New(), transform, fixed, moving ) && passed;
+
+  using ANTSMetricType = itk::ANTSNeighborhoodCorrelationImageToImageMetricv4< ImageType, ImageType >;
+  passed = TestMetric< ANTSMetricType >( "ANTSNeighborhoodCorrelation", ANTSMetricType::New(),
+                                         ANTSMetricType::New(), transform, fixed, moving ) && passed;
+
+  using MattesMetricType = itk::MattesMutualInformationImageToImageMetricv4< ImageType, ImageType >;
+  MattesMetricType::Pointer mattesMetric = MattesMetricType::New();
+  mattesMetric->SetUseSparseJointPDFDerivatives( true );
+  MattesMetricType::Pointer denseMattesMetric = MattesMetricType::New();
+  denseMattesMetric->SetUseSparseJointPDFDerivatives( true );
+  passed = TestMetric< MattesMetricType >( "MattesMutualInformation", mattesMetric, denseMattesMetric,
+                                           transform, fixed, moving ) && passed;
+
+  passed = TestScalesEstimator( transform, fixed, moving ) && passed;
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
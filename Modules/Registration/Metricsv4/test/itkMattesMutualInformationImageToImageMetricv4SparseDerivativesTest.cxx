@@ -0,0 +1,171 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMattesMutualInformationImageToImageMetricv4.h"
+#include "itkAffineTransform.h"
+#include "itkBSplineTransform.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+using ImageType = itk::Image< float, Dimension >;
+using MetricType = itk::MattesMutualInformationImageToImageMetricv4< ImageType, ImageType >;
+using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+
+ImageType::Pointer CreateImage( double shift, GeneratorType * generator )
+{
+  ImageType::SizeType size = {{ 64, 56 }};
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.5;
+  spacing[1] = 1.0;
+  image->SetSpacing( spacing );
+  for( itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetBufferedRegion() ); !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 30.0 + shift;
+    const double y = it.GetIndex()[1] - 26.0;
+    it.Set( static_cast< float >( 100.0 * std::exp( -( x * x + 2.0 * y * y ) / 400.0 )
+                                  + 40.0 * ( x > 3.0 ) + 5.0 * generator->GetVariate() ) );
+    }
+  return image;
+}
+
+// Compare the value and the derivative computed with the sparse joint PDF
+// derivatives with the default ones, for several numbers of threads, on
+// the whole domain and on a sampled point set.
+bool TestTransform( MetricType::MovingTransformType * transform, const ImageType * fixed, const ImageType * moving )
+{
+  using PointSetType = MetricType::FixedSampledPointSetType;
+  PointSetType::Pointer pointSet = PointSetType::New();
+  itk::SizeValueType count = 0;
+  for( itk::ImageRegionConstIteratorWithIndex< ImageType > it( fixed, fixed->GetBufferedRegion() ); !it.IsAtEnd(); ++it )
+    {
+    if( ( it.GetIndex()[0] + 3 * it.GetIndex()[1] ) % 5 == 0 )
+      {
+      PointSetType::PointType point;
+      fixed->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+      pointSet->SetPoint( count++, point );
+      }
+    }
+
+  bool passed = true;
+  for( unsigned int sampled = 0; sampled < 2; ++sampled )
+    {
+    for( unsigned int threads = 1; threads < 8; threads += 3 )
+      {
+      MetricType::MeasureType values[2];
+      MetricType::DerivativeType derivatives[2];
+      for( unsigned int sparse = 0; sparse < 2; ++sparse )
+        {
+        MetricType::Pointer metric = MetricType::New();
+        metric->SetFixedImage( fixed );
+        metric->SetMovingImage( moving );
+        metric->SetMovingTransform( transform );
+        metric->SetNumberOfHistogramBins( 24 );
+        metric->SetMaximumNumberOfThreads( threads );
+        metric->SetUseFixedSampledPointSet( sampled );
+        if( sampled )
+          {
+          metric->SetFixedSampledPointSet( pointSet );
+          }
+        metric->SetUseSparseJointPDFDerivatives( sparse );
+        TRY_EXPECT_NO_EXCEPTION( metric->Initialize() );
+        // twice, to reuse the buffers
+        for( unsigned int evaluation = 0; evaluation < 2; ++evaluation )
+          {
+          TRY_EXPECT_NO_EXCEPTION( metric->GetValueAndDerivative( values[sparse], derivatives[sparse] ) );
+          }
+        if( sparse && metric->GetJointPDFDerivatives().IsNotNull() )
+          {
+          std::cerr << "The joint PDF derivatives are allocated with the sparse accumulation" << std::endl;
+          passed = false;
+          }
+        }
+
+      double maximumDerivative = 0.0;
+      double maximumError = 0.0;
+      for( unsigned int i = 0; i < derivatives[0].Size(); ++i )
+        {
+        maximumDerivative = std::max( maximumDerivative, std::abs( derivatives[0][i] ) );
+        maximumError = std::max( maximumError, std::abs( derivatives[0][i] - derivatives[1][i] ) );
+        }
+      std::cout << transform->GetNameOfClass() << ( sampled ? ", sampled, " : ", " ) << threads
+                << " threads: value " << values[0] << ", derivative error " << maximumError << " of "
+                << maximumDerivative << std::endl;
+      passed = passed && itk::Math::FloatAlmostEqual( values[0], values[1], 4, 1e-12 ) && maximumDerivative > 0.0
+               && maximumError <= 1e-10 * maximumDerivative;
+      }
+    }
+  return passed;
+}
+}
+
+int itkMattesMutualInformationImageToImageMetricv4SparseDerivativesTest( int, char * [] )
+{
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 2018 );
+  const ImageType::Pointer fixed = CreateImage( 0.0, generator );
+  const ImageType::Pointer moving = CreateImage( 3.0, generator );
+
+  MetricType::Pointer metric = MetricType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( metric, MattesMutualInformationImageToImageMetricv4, ImageToImageMetricv4 );
+  TEST_SET_GET_BOOLEAN( metric, UseSparseJointPDFDerivatives, false );
+
+  bool passed = true;
+
+  using AffineTransformType = itk::AffineTransform< double, Dimension >;
+  AffineTransformType::Pointer affine = AffineTransformType::New();
+  AffineTransformType::ParametersType affineParameters( affine->GetNumberOfParameters() );
+  affineParameters[0] = 1.02;
+  affineParameters[1] = 0.05;
+  affineParameters[2] = -0.03;
+  affineParameters[3] = 0.97;
+  affineParameters[4] = 1.5;
+  affineParameters[5] = -0.5;
+  affine->SetParameters( affineParameters );
+  passed = TestTransform( affine, fixed, moving ) && passed;
+
+  // a B-spline transform, whose parameters have a small support
+  using BSplineTransformType = itk::BSplineTransform< double, Dimension, 3 >;
+  BSplineTransformType::Pointer bspline = BSplineTransformType::New();
+  BSplineTransformType::PhysicalDimensionsType physicalDimensions;
+  BSplineTransformType::MeshSizeType meshSize;
+  for( unsigned int d = 0; d < Dimension; ++d )
+    {
+    physicalDimensions[d] = fixed->GetSpacing()[d] * ( fixed->GetBufferedRegion().GetSize()[d] - 1 );
+    meshSize[d] = 9;
+    }
+  bspline->SetTransformDomainOrigin( fixed->GetOrigin() );
+  bspline->SetTransformDomainPhysicalDimensions( physicalDimensions );
+  bspline->SetTransformDomainMeshSize( meshSize );
+  bspline->SetTransformDomainDirection( fixed->GetDirection() );
+  BSplineTransformType::ParametersType bsplineParameters( bspline->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < bsplineParameters.Size(); ++i )
+    {
+    bsplineParameters[i] = 2.0 * generator->GetVariate() - 1.0;
+    }
+  bspline->SetParameters( bsplineParameters );
+  passed = TestTransform( bspline, fixed, moving ) && passed;
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,261 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkObjectToObjectMultiMetricv4.h"
+#include "itkAffineTransform.h"
+#include "itkANTSNeighborhoodCorrelationImageToImageMetricv4.h"
+#include "itkDisplacementFieldTransform.h"
+#include "itkEuclideanDistancePointSetToPointSetMetricv4.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMattesMutualInformationImageToImageMetricv4.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkTestingMacros.h"
+
+/* Evaluate a multi-metric of image and point set metrics with the
+ * components evaluated one after another and concurrently, with and
+ * without shared mapped moving points, and compare the results. */
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+using ImageType = itk::Image< double, Dimension >;
+using MultiMetricType = itk::ObjectToObjectMultiMetricv4< Dimension, Dimension >;
+using PointSetType = itk::PointSet< unsigned char, Dimension >;
+
+ImageType::Pointer CreateImage( double shift )
+{
+  ImageType::SizeType size = {{ 48, 40 }};
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  for( itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetBufferedRegion() ); !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 24.0 + shift;
+    const double y = it.GetIndex()[1] - 20.0;
+    it.Set( 100.0 * std::exp( -( x * x + 2.0 * y * y ) / 200.0 ) + 20.0 * ( x > 3.0 ) );
+    }
+  return image;
+}
+
+PointSetType::Pointer CreatePointSet( double shift )
+{
+  PointSetType::Pointer pointSet = PointSetType::New();
+  for( unsigned int i = 0; i < 8; ++i )
+    {
+    PointSetType::PointType point;
+    point[0] = 10.0 + 4.0 * i + shift;
+    point[1] = 8.0 + 3.0 * ( i % 3 );
+    pointSet->SetPoint( i, point );
+    }
+  return pointSet;
+}
+
+struct ResultType
+{
+  MultiMetricType::MeasureType              Value;
+  MultiMetricType::MeasureType              ValueOnly;
+  MultiMetricType::MetricValueArrayType     Values;
+  MultiMetricType::DerivativeType           Derivative;
+};
+
+int Evaluate( MultiMetricType::MovingTransformType * transform, bool concurrent, bool shared,
+              itk::SizeValueType expectedSharing, ResultType & result )
+{
+  const ImageType::Pointer fixed = CreateImage( 0.0 );
+  const ImageType::Pointer moving = CreateImage( 2.5 );
+
+  MultiMetricType::Pointer multiMetric = MultiMetricType::New();
+
+  using MeanSquaresType = itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType >;
+  MeanSquaresType::Pointer meanSquares = MeanSquaresType::New();
+  meanSquares->SetFixedImage( fixed );
+  meanSquares->SetMovingImage( moving );
+  meanSquares->SetMaximumNumberOfThreads( 2 );
+  multiMetric->AddMetric( meanSquares );
+
+  using MattesType = itk::MattesMutualInformationImageToImageMetricv4< ImageType, ImageType >;
+  MattesType::Pointer mattes = MattesType::New();
+  mattes->SetFixedImage( fixed );
+  mattes->SetMovingImage( moving );
+  mattes->SetNumberOfHistogramBins( 20 );
+  mattes->SetMaximumNumberOfThreads( 2 );
+  multiMetric->AddMetric( mattes );
+
+  using CorrelationType = itk::ANTSNeighborhoodCorrelationImageToImageMetricv4< ImageType, ImageType >;
+  CorrelationType::Pointer correlation = CorrelationType::New();
+  correlation->SetFixedImage( fixed );
+  correlation->SetMovingImage( moving );
+  CorrelationType::RadiusType radius;
+  radius.Fill( 2 );
+  correlation->SetRadius( radius );
+  correlation->SetMaximumNumberOfThreads( 2 );
+  multiMetric->AddMetric( correlation );
+
+  // a sampled metric, which maps its own points
+  MeanSquaresType::Pointer sampled = MeanSquaresType::New();
+  sampled->SetFixedImage( fixed );
+  sampled->SetMovingImage( moving );
+  MeanSquaresType::FixedSampledPointSetType::Pointer samples = MeanSquaresType::FixedSampledPointSetType::New();
+  for( unsigned int i = 0; i < 200; ++i )
+    {
+    MeanSquaresType::FixedSampledPointSetType::PointType point;
+    point[0] = 4.0 + ( i * 7 ) % 40;
+    point[1] = 3.0 + ( i * 3 ) % 34 + 0.5;
+    samples->SetPoint( i, point );
+    }
+  sampled->SetFixedSampledPointSet( samples );
+  sampled->SetUseFixedSampledPointSet( true );
+  multiMetric->AddMetric( sampled );
+
+  using PointSetMetricType = itk::EuclideanDistancePointSetToPointSetMetricv4< PointSetType >;
+  PointSetMetricType::Pointer pointSetMetric = PointSetMetricType::New();
+  pointSetMetric->SetFixedPointSet( CreatePointSet( 0.0 ) );
+  pointSetMetric->SetMovingPointSet( CreatePointSet( 2.5 ) );
+  multiMetric->AddMetric( pointSetMetric );
+
+  multiMetric->SetMovingTransform( transform );
+  multiMetric->SetUseConcurrentMetricEvaluation( concurrent );
+  multiMetric->SetUseSharedMappedMovingPoints( shared );
+  TRY_EXPECT_NO_EXCEPTION( multiMetric->Initialize() );
+
+  if( multiMetric->GetNumberOfMetricsSharingMappedMovingPoints() != expectedSharing )
+    {
+    std::cerr << "Expected " << expectedSharing << " metrics sharing the mapped moving points, not "
+              << multiMetric->GetNumberOfMetricsSharingMappedMovingPoints() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // twice, to reuse the buffers
+  for( unsigned int evaluation = 0; evaluation < 2; ++evaluation )
+    {
+    TRY_EXPECT_NO_EXCEPTION( multiMetric->GetValueAndDerivative( result.Value, result.Derivative ) );
+    }
+  result.Values = multiMetric->GetValueArray();
+  TRY_EXPECT_NO_EXCEPTION( result.ValueOnly = multiMetric->GetValue() );
+
+  // the components are evaluated alone after the multi-metric
+  MeanSquaresType::MeasureType value;
+  MeanSquaresType::DerivativeType derivative;
+  TRY_EXPECT_NO_EXCEPTION( meanSquares->GetValueAndDerivative( value, derivative ) );
+  if( value != result.Values[0] )
+    {
+    std::cerr << "The value of the first metric alone differs: " << value << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const MultiMetricType::TimeArrayType times = multiMetric->GetMetricEvaluationTimes();
+  const MultiMetricType::TimeArrayType accumulatedTimes = multiMetric->GetAccumulatedMetricEvaluationTimes();
+  for( itk::SizeValueType j = 0; j < multiMetric->GetNumberOfMetrics(); ++j )
+    {
+    if( times[j] < 0.0 || accumulatedTimes[j] < times[j] || accumulatedTimes[j] <= 0.0 )
+      {
+      std::cerr << "Unexpected evaluation times of metric " << j << ": " << times[j] << ", "
+                << accumulatedTimes[j] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::cout << transform->GetNameOfClass() << ( concurrent ? ", concurrent" : "" ) << ( shared ? ", shared" : "" )
+            << ": values " << result.Values << ", times " << accumulatedTimes << std::endl;
+  return EXIT_SUCCESS;
+}
+
+// The values are the same. The derivatives of some components, summed over
+// their threads, may differ in the last bits from one evaluation to another.
+bool SameResults( const ResultType & serial, const ResultType & other )
+{
+  double maximumDerivative = 0.0;
+  double maximumError = 0.0;
+  for( unsigned int i = 0; i < serial.Derivative.Size(); ++i )
+    {
+    maximumDerivative = std::max( maximumDerivative, std::abs( serial.Derivative[i] ) );
+    maximumError = std::max( maximumError, std::abs( serial.Derivative[i] - other.Derivative[i] ) );
+    }
+  const bool passed = serial.Value == other.Value && serial.ValueOnly == other.ValueOnly
+                      && serial.Values == other.Values && other.Derivative.Size() == serial.Derivative.Size()
+                      && maximumDerivative > 0.0 && maximumError <= 1e-12 * maximumDerivative;
+  if( !passed )
+    {
+    std::cerr << "The results differ from the serial ones" << std::endl;
+    }
+  return passed;
+}
+}
+
+int itkObjectToObjectMultiMetricv4ConcurrentTest( int, char * [] )
+{
+  MultiMetricType::Pointer multiMetric = MultiMetricType::New();
+  TEST_SET_GET_BOOLEAN( multiMetric, UseConcurrentMetricEvaluation, false );
+  TEST_SET_GET_BOOLEAN( multiMetric, UseSharedMappedMovingPoints, false );
+
+  bool passed = true;
+
+  using AffineTransformType = itk::AffineTransform< double, Dimension >;
+  AffineTransformType::Pointer affine = AffineTransformType::New();
+  AffineTransformType::ParametersType affineParameters( affine->GetNumberOfParameters() );
+  affineParameters[0] = 1.02;
+  affineParameters[1] = 0.05;
+  affineParameters[2] = -0.03;
+  affineParameters[3] = 0.97;
+  affineParameters[4] = 1.5;
+  affineParameters[5] = -0.5;
+  affine->SetParameters( affineParameters );
+
+  // a displacement field transform, for which the image metrics create a
+  // virtual domain matching the field
+  using DisplacementFieldTransformType = itk::DisplacementFieldTransform< double, Dimension >;
+  using FieldType = DisplacementFieldTransformType::DisplacementFieldType;
+  FieldType::Pointer field = FieldType::New();
+  field->CopyInformation( CreateImage( 0.0 ) );
+  field->SetRegions( CreateImage( 0.0 )->GetBufferedRegion() );
+  field->Allocate();
+  for( itk::ImageRegionIteratorWithIndex< FieldType > it( field, field->GetBufferedRegion() ); !it.IsAtEnd(); ++it )
+    {
+    FieldType::PixelType displacement;
+    displacement[0] = 0.5 * std::sin( 0.2 * it.GetIndex()[1] );
+    displacement[1] = 0.3 * std::cos( 0.15 * it.GetIndex()[0] );
+    it.Set( displacement );
+    }
+  DisplacementFieldTransformType::Pointer displacementTransform = DisplacementFieldTransformType::New();
+  displacementTransform->SetDisplacementField( field );
+
+  std::vector< MultiMetricType::MovingTransformType * > transforms;
+  transforms.push_back( affine );
+  transforms.push_back( displacementTransform );
+  for( MultiMetricType::MovingTransformType * transform : transforms )
+    {
+    ResultType serial;
+    if( Evaluate( transform, false, false, 0, serial ) != EXIT_SUCCESS )
+      {
+      return EXIT_FAILURE;
+      }
+    for( unsigned int mode = 1; mode < 4; ++mode )
+      {
+      const bool concurrent = mode & 1;
+      const bool shared = mode & 2;
+      ResultType result;
+      if( Evaluate( transform, concurrent, shared, shared ? 3 : 0, result ) != EXIT_SUCCESS )
+        {
+        return EXIT_FAILURE;
+        }
+      passed = SameResults( serial, result ) && passed;
+      }
+    }
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
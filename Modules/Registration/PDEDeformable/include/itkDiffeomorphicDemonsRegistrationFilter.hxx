@@ -243,16 +243,19 @@ void
 DiffeomorphicDemonsRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
 ::ApplyUpdate(const TimeStepType& dt)
 {
+  // Use time step if necessary. In many cases
+  // the time step is one so this will be skipped
+  const bool useTimeStep = std::fabs(dt - 1.0) > 1.0e-4;
+
   // If we smooth the update buffer before applying it, then the are
-  // approximating a viscuous problem as opposed to an elastic problem
+  // approximating a viscuous problem as opposed to an elastic problem.
+  // The time step is then applied in the last smoothing pass.
   if ( this->GetSmoothUpdateField() )
     {
-    this->SmoothUpdateField();
+    this->SmoothFieldInPlace( this->GetUpdateBuffer(), this->GetUpdateFieldStandardDeviations(),
+                              nullptr, nullptr, 1.0, nullptr, useTimeStep ? dt : 1.0 );
     }
-
-  // Use time step if necessary. In many cases
-  // the time step is one so this will be skipped
-  if ( std::fabs(dt - 1.0) > 1.0e-4 )
+  else if ( useTimeStep )
     {
     itkDebugMacro("Using timestep: " << dt);
     m_Multiplier->SetInput2(dt);
@@ -264,9 +267,13 @@ DiffeomorphicDemonsRegistrationFilter< TFixedImage, TMovingImage, TDisplacementF
     this->GetUpdateBuffer()->Graft( m_Multiplier->GetOutput() );
     }
 
+  // The field composed with the deformation field
+  DisplacementFieldType *increment;
+
   if ( this->m_UseFirstOrderExp )
     {
     // use s <- s o (Id +u)
+    increment = this->GetUpdateBuffer();
 
     // skip exponential and compose the vector fields
     m_Warper->SetOutputOrigin( this->GetUpdateBuffer()->GetOrigin() );
@@ -314,6 +321,7 @@ DiffeomorphicDemonsRegistrationFilter< TFixedImage, TMovingImage, TDisplacementF
       this->GetOutput()->GetRequestedRegion() );
 
     m_Exponentiator->Update();
+    increment = m_Exponentiator->GetOutput();
 
     // compose the vector fields
     m_Warper->SetOutputOrigin( this->GetUpdateBuffer()->GetOrigin() );
@@ -331,23 +339,29 @@ DiffeomorphicDemonsRegistrationFilter< TFixedImage, TMovingImage, TDisplacementF
       this->GetOutput()->GetRequestedRegion() );
     }
 
-  // Triggers update
-  m_Adder->Update();
+  if ( this->GetSmoothDisplacementField() )
+    {
+    // Add the composed fields in the first pass of the smoothing of the
+    // deformation field.
+    m_Warper->GetOutput()->SetRequestedRegion(
+      this->GetOutput()->GetRequestedRegion() );
+    m_Warper->Update();
+
+    this->SmoothFieldInPlace( this->GetOutput(), this->GetStandardDeviations(),
+                              m_Warper->GetOutput(), increment, 1.0 );
+    }
+  else
+    {
+    // Triggers update
+    m_Adder->Update();
 
-  // Region passing stuff
-  this->GraftOutput( m_Adder->GetOutput() );
+    // Region passing stuff
+    this->GraftOutput( m_Adder->GetOutput() );
+    }
 
   DemonsRegistrationFunctionType *drfp = this->DownCastDifferenceFunctionType();
 
   this->SetRMSChange( drfp->GetRMSChange() );
-
-  /**
-   * Smooth the deformation field
-   */
-  if ( this->GetSmoothDisplacementField() )
-    {
-    this->SmoothDisplacementField();
-    }
 }
 
 template< typename TFixedImage, typename TMovingImage, typename TDisplacementField >
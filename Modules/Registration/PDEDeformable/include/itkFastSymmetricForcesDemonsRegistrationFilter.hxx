@@ -231,34 +231,53 @@ void
 FastSymmetricForcesDemonsRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
 ::ApplyUpdate(const TimeStepType& dt)
 {
-  // If we smooth the update buffer before applying it, then the are
-  // approximating a viscuous problem as opposed to an elastic problem
-  if ( this->GetSmoothUpdateField() )
-    {
-    this->SmoothUpdateField();
-    }
-
   // use time step if necessary
+  TimeStepType timeStep = 1.0;
   if ( std::fabs(dt - 1.0) > 1.0e-4 )
     {
     itkDebugMacro("Using timestep: " << dt);
-    m_Multiplier->SetInput2(dt);
-    m_Multiplier->SetInput( this->GetUpdateBuffer() );
-    m_Multiplier->GraftOutput( this->GetUpdateBuffer() );
-    // in place update
-    m_Multiplier->Update();
-    // graft output back to this->GetUpdateBuffer()
-    this->GetUpdateBuffer()->Graft( m_Multiplier->GetOutput() );
+    timeStep = dt;
     }
 
-  m_Adder->SetInput1( this->GetOutput() );
-  m_Adder->SetInput2( this->GetUpdateBuffer() );
-
-  m_Adder->GetOutput()->SetRequestedRegion( this->GetOutput()->GetRequestedRegion() );
-  m_Adder->Update();
-
-  // Region passing stuff
-  this->GraftOutput( m_Adder->GetOutput() );
+  // If we smooth the update buffer before applying it, then the are
+  // approximating a viscuous problem as opposed to an elastic problem.
+  // The scaled update is then added to the displacement field in the last
+  // smoothing pass. Otherwise, when the deformation field is smoothed, the
+  // scaled update is added to it in the first smoothing pass.
+  bool displacementFieldSmoothed = false;
+  if ( this->GetSmoothUpdateField() )
+    {
+    this->SmoothFieldInPlace( this->GetUpdateBuffer(), this->GetUpdateFieldStandardDeviations(),
+                              nullptr, nullptr, 1.0, this->GetOutput(), timeStep );
+    }
+  else if ( this->GetSmoothDisplacementField() )
+    {
+    this->SmoothFieldInPlace( this->GetOutput(), this->GetStandardDeviations(),
+                              nullptr, this->GetUpdateBuffer(), timeStep );
+    displacementFieldSmoothed = true;
+    }
+  else
+    {
+    if ( Math::NotExactlyEquals(timeStep, 1.0) )
+      {
+      m_Multiplier->SetInput2(timeStep);
+      m_Multiplier->SetInput( this->GetUpdateBuffer() );
+      m_Multiplier->GraftOutput( this->GetUpdateBuffer() );
+      // in place update
+      m_Multiplier->Update();
+      // graft output back to this->GetUpdateBuffer()
+      this->GetUpdateBuffer()->Graft( m_Multiplier->GetOutput() );
+      }
+
+    m_Adder->SetInput1( this->GetOutput() );
+    m_Adder->SetInput2( this->GetUpdateBuffer() );
+
+    m_Adder->GetOutput()->SetRequestedRegion( this->GetOutput()->GetRequestedRegion() );
+    m_Adder->Update();
+
+    // Region passing stuff
+    this->GraftOutput( m_Adder->GetOutput() );
+    }
 
   DemonsRegistrationFunctionType *drfp = this->DownCastDifferenceFunctionType();
 
@@ -267,7 +286,7 @@ FastSymmetricForcesDemonsRegistrationFilter< TFixedImage, TMovingImage, TDisplac
   /*
    * Smooth the deformation field
    */
-  if ( this->GetSmoothDisplacementField() )
+  if ( this->GetSmoothDisplacementField() && !displacementFieldSmoothed )
     {
     this->SmoothDisplacementField();
     }
@@ -54,10 +54,11 @@ namespace itk
  * of smoothing is governed by a set of user defined standard deviations
  * (one for each dimension).
  *
- * In terms of memory, this filter keeps two internal buffers: one for storing
- * the intermediate updates to the field and one for double-buffering when
- * smoothing the displacement field. Both buffers are the same type and size as the
- * output displacement field.
+ * In terms of memory, this filter keeps one internal buffer for storing
+ * the intermediate updates to the field. It is the same type and size as the
+ * output displacement field. The displacement and update fields are smoothed
+ * in place, one dimension at a time, through line buffers that hold a few
+ * adjacent lines of the field at once.
  *
  * This class make use of the finite difference solver hierarchy. Update
  * for each iteration is computed using a PDEDeformableRegistrationFunction.
@@ -233,9 +234,27 @@ protected:
    * UpdateFieldStandardDeviations. */
   virtual void SmoothUpdateField();
 
-  /** This method is called after the solution has been generated. In this case,
-   * the filter release the memory of the internal buffers. */
-  void PostProcessOutput() override;
+  /** Smooth a field in place with a separable Gaussian kernel whose
+   * standard deviations are given in pixel units. The kernel is truncated
+   * as specified by MaximumError and MaximumKernelWidth, and the field is
+   * extended past its buffered region by replicating the border pixels.
+   *
+   * Each pass copies a block of adjacent lines into a line buffer and writes
+   * the filtered lines back, so that no temporary field is allocated.
+   * The neighbouring pixelwise operations can be fused into the passes:
+   * the first pass reads \a input (\a field itself when null), plus
+   * \a addend scaled by \a addendScale when given, and the last pass
+   * scales the smoothed vectors by \a outputScale and either stores them in
+   * \a field or, when \a accumulator is given, adds them to \a accumulator.
+   * In that case \a field is left with the partially smoothed vectors.
+   * All the fields must have the same buffered region. */
+  void SmoothFieldInPlace(DisplacementFieldType *field,
+                          const StandardDeviationsType & standardDeviations,
+                          const DisplacementFieldType *input = nullptr,
+                          const DisplacementFieldType *addend = nullptr,
+                          double addendScale = 1.0,
+                          DisplacementFieldType *accumulator = nullptr,
+                          double outputScale = 1.0);
 
   /** This method is called before iterating the solution. */
   void Initialize() override;
@@ -263,10 +282,6 @@ private:
   bool m_SmoothDisplacementField;
   bool m_SmoothUpdateField;
 
-  /** Temporary displacement field use for smoothing the
-   * the displacement field. */
-  DisplacementFieldPointer m_TempField;
-
 private:
   /** Maximum error for Gaussian operator approximation. */
   double m_MaximumError;
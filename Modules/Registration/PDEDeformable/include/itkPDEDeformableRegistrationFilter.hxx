@@ -21,14 +21,15 @@
 #include "itkPDEDeformableRegistrationFilter.h"
 
 #include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkImageLinearIteratorWithIndex.h"
 #include "itkDataObject.h"
 
 #include "itkGaussianOperator.h"
-#include "itkVectorNeighborhoodOperatorImageFilter.h"
 
 #include "itkMath.h"
-#include "itkMath.h"
+
+#include <algorithm>
 
 namespace itk
 {
@@ -59,7 +60,6 @@ PDEDeformableRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
     m_UpdateFieldStandardDeviations[j] = 1.0;
     }
 
-  m_TempField = DisplacementFieldType::New();
   m_MaximumError = 0.1;
   m_MaximumKernelWidth = 30;
   m_StopRegistrationFlag = false;
@@ -313,18 +313,6 @@ PDEDeformableRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
     }
 }
 
-/*
- * Release memory of internal buffers
- */
-template< typename TFixedImage, typename TMovingImage, typename TDisplacementField >
-void
-PDEDeformableRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
-::PostProcessOutput()
-{
-  this->Superclass::PostProcessOutput();
-  m_TempField->Initialize();
-}
-
 /*
  * Initialize flags
  */
@@ -347,63 +335,7 @@ PDEDeformableRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
 {
   DisplacementFieldPointer field = this->GetOutput();
 
-  // copy field to TempField
-  m_TempField->SetOrigin( field->GetOrigin() );
-  m_TempField->SetSpacing( field->GetSpacing() );
-  m_TempField->SetDirection( field->GetDirection() );
-  m_TempField->SetLargestPossibleRegion(
-    field->GetLargestPossibleRegion() );
-  m_TempField->SetRequestedRegion(
-    field->GetRequestedRegion() );
-  m_TempField->SetBufferedRegion( field->GetBufferedRegion() );
-  m_TempField->Allocate();
-
-  using VectorType = typename DisplacementFieldType::PixelType;
-  using ScalarType = typename VectorType::ValueType;
-  using OperatorType = GaussianOperator< ScalarType, ImageDimension >;
-  using SmootherType = VectorNeighborhoodOperatorImageFilter<
-    DisplacementFieldType,
-    DisplacementFieldType >;
-
-  auto * oper = new OperatorType;
-  typename SmootherType::Pointer smoother = SmootherType::New();
-
-  using PixelContainerPointer = typename DisplacementFieldType::PixelContainerPointer;
-  PixelContainerPointer swapPtr;
-
-  // graft the output field onto the mini-pipeline
-  smoother->GraftOutput(m_TempField);
-
-  for ( unsigned int j = 0; j < ImageDimension; j++ )
-    {
-    // smooth along this dimension
-    oper->SetDirection(j);
-    double variance = itk::Math::sqr(m_StandardDeviations[j]);
-    oper->SetVariance(variance);
-    oper->SetMaximumError(m_MaximumError);
-    oper->SetMaximumKernelWidth(m_MaximumKernelWidth);
-    oper->CreateDirectional();
-
-    // todo: make sure we only smooth within the buffered region
-    smoother->SetOperator(*oper);
-    smoother->SetInput(field);
-    smoother->Update();
-
-    if ( j + 1 < ImageDimension )
-      {
-      // swap the containers
-      swapPtr = smoother->GetOutput()->GetPixelContainer();
-      smoother->GraftOutput(field);
-      field->SetPixelContainer(swapPtr);
-      smoother->Modified();
-      }
-    }
-
-  // graft the output back to this filter
-  m_TempField->SetPixelContainer( field->GetPixelContainer() );
-  this->GraftOutput( smoother->GetOutput() );
-
-  delete oper;
+  this->SmoothFieldInPlace(field, m_StandardDeviations);
 }
 
 /*
@@ -417,52 +349,164 @@ PDEDeformableRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
   // The update buffer will be overwritten with new data.
   DisplacementFieldPointer field = this->GetUpdateBuffer();
 
+  this->SmoothFieldInPlace(field, m_UpdateFieldStandardDeviations);
+}
+
+/*
+ * Smooth a field in place, one dimension at a time, through line buffers
+ */
+template< typename TFixedImage, typename TMovingImage, typename TDisplacementField >
+void
+PDEDeformableRegistrationFilter< TFixedImage, TMovingImage, TDisplacementField >
+::SmoothFieldInPlace(DisplacementFieldType *field,
+                     const StandardDeviationsType & standardDeviations,
+                     const DisplacementFieldType *input,
+                     const DisplacementFieldType *addend,
+                     double addendScale,
+                     DisplacementFieldType *accumulator,
+                     double outputScale)
+{
+  using RegionType = typename DisplacementFieldType::RegionType;
+  using IndexType = typename DisplacementFieldType::IndexType;
   using VectorType = typename DisplacementFieldType::PixelType;
   using ScalarType = typename VectorType::ValueType;
   using OperatorType = GaussianOperator< ScalarType, ImageDimension >;
-  using SmootherType = VectorNeighborhoodOperatorImageFilter<
-    DisplacementFieldType,
-    DisplacementFieldType >;
 
-  OperatorType opers[ImageDimension];
-  typename SmootherType::Pointer smoothers[ImageDimension];
+  // The lines along the first dimension are contiguous in memory. The lines
+  // along the other dimensions are filtered this many at a time, so that
+  // each pixel read from or written to the field brings in the neighbouring
+  // pixels of the same cache line.
+  constexpr SizeValueType blockLength = 16;
+
+  if ( input == nullptr )
+    {
+    input = field;
+    }
+
+  const RegionType region = field->GetBufferedRegion();
+  if ( input->GetBufferedRegion() != region
+       || ( addend && addend->GetBufferedRegion() != region )
+       || ( accumulator && accumulator->GetBufferedRegion() != region ) )
+    {
+    itkExceptionMacro(<< "The fields to smooth, add and accumulate must have the same buffered region");
+    }
+  if ( region.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  const OffsetValueType *offsetTable = field->GetOffsetTable();
 
   for ( unsigned int j = 0; j < ImageDimension; j++ )
     {
-    // smooth along this dimension
-    opers[j].SetDirection(j);
-    double variance = itk::Math::sqr(this->GetUpdateFieldStandardDeviations()[j]);
-    //double variance = itk::Math::sqr( 1.0 );
-    opers[j].SetVariance(variance);
-    opers[j].SetMaximumError( this->GetMaximumError() );
-    opers[j].SetMaximumKernelWidth( this->GetMaximumKernelWidth() );
-    opers[j].CreateDirectional();
-
-    smoothers[j] = SmootherType::New();
-    smoothers[j]->SetOperator(opers[j]);
-    smoothers[j]->ReleaseDataFlagOn();
-
-    if ( j > 0 )
+    OperatorType oper;
+    oper.SetDirection(j);
+    oper.SetVariance( itk::Math::sqr(standardDeviations[j]) );
+    oper.SetMaximumError(m_MaximumError);
+    oper.SetMaximumKernelWidth(m_MaximumKernelWidth);
+    oper.CreateDirectional();
+
+    const std::vector< ScalarType > kernel( oper.Begin(), oper.End() );
+    const SizeValueType             radius = oper.GetRadius(j);
+
+    const bool firstPass = ( j == 0 );
+    const bool lastPass = ( j + 1 == ImageDimension );
+
+    const VectorType *source = firstPass ? input->GetBufferPointer() : field->GetBufferPointer();
+    const VectorType *addendBuffer = ( firstPass && addend ) ? addend->GetBufferPointer() : nullptr;
+    VectorType       *target = field->GetBufferPointer();
+    VectorType       *accumulatorBuffer = ( lastPass && accumulator ) ? accumulator->GetBufferPointer() : nullptr;
+    const ScalarType  addendFactor = static_cast< ScalarType >( addendScale );
+    const ScalarType  outputFactor = static_cast< ScalarType >( lastPass ? outputScale : 1.0 );
+
+    const SizeValueType   lineLength = region.GetSize(j);
+    const OffsetValueType lineStride = offsetTable[j];
+
+    // One line start per line along this dimension.
+    RegionType lineStarts = region;
+    lineStarts.SetSize(j, 1);
+
+    this->GetMultiThreader()->template ParallelizeImageRegion< ImageDimension >(
+      lineStarts,
+      [&](const RegionType & subregion)
       {
-      smoothers[j]->SetInput( smoothers[j - 1]->GetOutput() );
-      }
+        // Along the first dimension, the blocks are made of the adjacent
+        // lines of the subregion.
+        const SizeValueType rowLength = subregion.GetSize(0);
+        RegionType          rows = subregion;
+        rows.SetSize(0, 1);
+
+        const SizeValueType bufferedBlockLength = std::min(blockLength, rowLength);
+        std::vector< VectorType > lineBuffer( ( lineLength + 2 * radius ) * bufferedBlockLength );
+
+        ImageRegionConstIteratorWithIndex< DisplacementFieldType > rowIt(field, rows);
+        for ( rowIt.GoToBegin(); !rowIt.IsAtEnd(); ++rowIt )
+          {
+          const IndexType rowStart = rowIt.GetIndex();
+          for ( SizeValueType blockStart = 0; blockStart < rowLength; blockStart += blockLength )
+            {
+            const SizeValueType   width = std::min(blockLength, rowLength - blockStart);
+            IndexType             blockIndex = rowStart;
+            blockIndex[0] += blockStart;
+            const OffsetValueType blockOffset = field->ComputeOffset(blockIndex);
+
+            // Copy the lines of the block, extended by their border pixels.
+            VectorType *line = lineBuffer.data();
+            for ( SizeValueType i = 0; i < lineLength; i++ )
+              {
+              const OffsetValueType offset = blockOffset + i * lineStride;
+              VectorType           *bufferRow = line + ( i + radius ) * width;
+              for ( SizeValueType b = 0; b < width; b++ )
+                {
+                bufferRow[b] = source[offset + b];
+                if ( addendBuffer )
+                  {
+                  bufferRow[b] += addendBuffer[offset + b] * addendFactor;
+                  }
+                }
+              }
+            for ( SizeValueType r = 0; r < radius; r++ )
+              {
+              for ( SizeValueType b = 0; b < width; b++ )
+                {
+                line[r * width + b] = line[radius * width + b];
+                line[( lineLength + radius + r ) * width + b] = line[( lineLength + radius - 1 ) * width + b];
+                }
+              }
+
+            // Filter the lines back into the field.
+            for ( SizeValueType i = 0; i < lineLength; i++ )
+              {
+              const OffsetValueType offset = blockOffset + i * lineStride;
+              const VectorType     *window = line + i * width;
+              for ( SizeValueType b = 0; b < width; b++ )
+                {
+                VectorType sum = window[b] * kernel[0];
+                for ( SizeValueType k = 1; k < kernel.size(); k++ )
+                  {
+                  sum += window[k * width + b] * kernel[k];
+                  }
+                if ( accumulatorBuffer )
+                  {
+                  accumulatorBuffer[offset + b] += sum * outputFactor;
+                  }
+                else
+                  {
+                  target[offset + b] = sum * outputFactor;
+                  }
+                }
+              }
+            }
+          }
+      },
+      nullptr);
+    }
+
+  field->Modified();
+  if ( accumulator )
+    {
+    accumulator->Modified();
     }
-  smoothers[0]->SetInput(field);
-  smoothers[ImageDimension - 1]->GetOutput()
-  ->SetRequestedRegion( field->GetBufferedRegion() );
-
-  smoothers[ImageDimension - 1]->Update();
-
-  // field to contain the final smoothed data, do the equivalent of a graft
-  field->SetPixelContainer( smoothers[ImageDimension - 1]->GetOutput()
-                            ->GetPixelContainer() );
-  field->SetRequestedRegion( smoothers[ImageDimension - 1]->GetOutput()
-                             ->GetRequestedRegion() );
-  field->SetBufferedRegion( smoothers[ImageDimension - 1]->GetOutput()
-                            ->GetBufferedRegion() );
-  field->SetLargestPossibleRegion( smoothers[ImageDimension - 1]->GetOutput()
-                                   ->GetLargestPossibleRegion() );
-  field->CopyInformation( smoothers[ImageDimension - 1]->GetOutput() );
 }
 } // end namespace itk
 
@@ -150,13 +150,18 @@ SymmetricForcesDemonsRegistrationFilter< TFixedImage, TMovingImage, TDisplacemen
 ::ApplyUpdate(const TimeStepType& dt)
 {
   // If we smooth the update buffer before applying it, then the are
-  // approximating a viscuous problem as opposed to an elastic problem
+  // approximating a viscuous problem as opposed to an elastic problem.
+  // The update is then added to the displacement field in the last
+  // smoothing pass.
   if ( this->GetSmoothUpdateField() )
     {
-    this->SmoothUpdateField();
+    this->SmoothFieldInPlace( this->GetUpdateBuffer(), this->GetUpdateFieldStandardDeviations(),
+                              nullptr, nullptr, 1.0, this->GetOutput(), dt );
+    }
+  else
+    {
+    this->Superclass::ApplyUpdate(dt);
     }
-
-  this->Superclass::ApplyUpdate(dt);
 
   auto * drfp = dynamic_cast< DemonsRegistrationFunctionType * > ( this->GetDifferenceFunction().GetPointer() );
 
@@ -0,0 +1,207 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkGaussianOperator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkPDEDeformableRegistrationFilter.h"
+#include "itkTestingMacros.h"
+#include "itkVectorNeighborhoodOperatorImageFilter.h"
+
+/*
+ * Compare the in place smoothing of PDEDeformableRegistrationFilter, with
+ * and without the fused addition and accumulation, to a pipeline of
+ * VectorNeighborhoodOperatorImageFilter. The field is thinner than the
+ * kernel along the last dimension.
+ */
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using ImageType = itk::Image< float, Dimension >;
+using FieldType = itk::Image< itk::Vector< double, Dimension >, Dimension >;
+using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+
+class SmoothingTestFilter:
+  public itk::PDEDeformableRegistrationFilter< ImageType, ImageType, FieldType >
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(SmoothingTestFilter);
+
+  using Self = SmoothingTestFilter;
+  using Superclass = itk::PDEDeformableRegistrationFilter< ImageType, ImageType, FieldType >;
+  using Pointer = itk::SmartPointer< Self >;
+
+  itkNewMacro(Self);
+
+  using Superclass::SmoothFieldInPlace;
+
+protected:
+  SmoothingTestFilter() = default;
+  ~SmoothingTestFilter() override = default;
+};
+
+FieldType::Pointer CreateField( GeneratorType * generator )
+{
+  FieldType::SizeType size = {{ 37, 11, 4 }};
+  FieldType::IndexType index = {{ 3, -2, 5 }};
+  FieldType::RegionType region( index, size );
+  FieldType::Pointer field = FieldType::New();
+  field->SetRegions( region );
+  field->Allocate();
+  for( itk::ImageRegionIteratorWithIndex< FieldType > it( field, region ); !it.IsAtEnd(); ++it )
+    {
+    FieldType::PixelType vector;
+    for( unsigned int d = 0; d < Dimension; ++d )
+      {
+      vector[d] = generator->GetUniformVariate( -1.0, 1.0 );
+      }
+    it.Set( vector );
+    }
+  return field;
+}
+
+FieldType::Pointer Duplicate( const FieldType * field )
+{
+  FieldType::Pointer copy = FieldType::New();
+  copy->SetRegions( field->GetBufferedRegion() );
+  copy->Allocate();
+  itk::ImageRegionConstIterator< FieldType > it( field, field->GetBufferedRegion() );
+  itk::ImageRegionIterator< FieldType > ot( copy, copy->GetBufferedRegion() );
+  for( ; !it.IsAtEnd(); ++it, ++ot )
+    {
+    ot.Set( it.Get() );
+    }
+  return copy;
+}
+
+// The reference smoothing, as done by a pipeline of neighborhood operator
+// filters.
+FieldType::Pointer Smooth( const FieldType * field, const SmoothingTestFilter::StandardDeviationsType & sigmas,
+                           double maximumError, unsigned int maximumKernelWidth )
+{
+  using OperatorType = itk::GaussianOperator< double, Dimension >;
+  using SmootherType = itk::VectorNeighborhoodOperatorImageFilter< FieldType, FieldType >;
+
+  FieldType::Pointer smoothed = Duplicate( field );
+  for( unsigned int j = 0; j < Dimension; ++j )
+    {
+    OperatorType oper;
+    oper.SetDirection( j );
+    oper.SetVariance( sigmas[j] * sigmas[j] );
+    oper.SetMaximumError( maximumError );
+    oper.SetMaximumKernelWidth( maximumKernelWidth );
+    oper.CreateDirectional();
+
+    SmootherType::Pointer smoother = SmootherType::New();
+    smoother->SetOperator( oper );
+    smoother->SetInput( smoothed );
+    smoother->Update();
+    smoothed = smoother->GetOutput();
+    smoothed->DisconnectPipeline();
+    }
+  return smoothed;
+}
+
+// field = a * field + b * other
+void Combine( FieldType * field, double a, const FieldType * other, double b )
+{
+  itk::ImageRegionIterator< FieldType > it( field, field->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< FieldType > ot( other, other->GetBufferedRegion() );
+  for( ; !it.IsAtEnd(); ++it, ++ot )
+    {
+    it.Set( it.Get() * a + ot.Get() * b );
+    }
+}
+
+bool Compare( const char * name, const FieldType * field, const FieldType * referenceField )
+{
+  double maximumError = 0.0;
+  itk::ImageRegionConstIterator< FieldType > it( field, field->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< FieldType > rt( referenceField, referenceField->GetBufferedRegion() );
+  for( ; !it.IsAtEnd(); ++it, ++rt )
+    {
+    maximumError = std::max( maximumError, ( it.Get() - rt.Get() ).GetNorm() );
+    }
+  std::cout << name << ": maximum difference " << maximumError << std::endl;
+  if( maximumError > 1e-12 )
+    {
+    std::cerr << name << ": the smoothed fields differ" << std::endl;
+    return false;
+    }
+  return true;
+}
+}
+
+int itkPDEDeformableRegistrationFilterSmoothingTest( int, char * [] )
+{
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 2018 );
+
+  SmoothingTestFilter::Pointer filter = SmoothingTestFilter::New();
+  filter->GetMultiThreader()->SetNumberOfThreads( 3 );
+
+  SmoothingTestFilter::StandardDeviationsType sigmas;
+  sigmas[0] = 1.5;
+  sigmas[1] = 0.75;
+  sigmas[2] = 2.5;
+
+  bool passed = true;
+
+  for( unsigned int maximumKernelWidth : { 30u, 5u } )
+    {
+    filter->SetMaximumKernelWidth( maximumKernelWidth );
+    std::cout << "Maximum kernel width " << maximumKernelWidth << std::endl;
+
+    const FieldType::Pointer field = CreateField( generator );
+    const FieldType::Pointer addend = CreateField( generator );
+    const FieldType::Pointer accumulator = CreateField( generator );
+
+    // Smoothing alone
+    FieldType::Pointer smoothed = Duplicate( field );
+    filter->SmoothFieldInPlace( smoothed, sigmas );
+    FieldType::Pointer reference = Smooth( field, sigmas, filter->GetMaximumError(), maximumKernelWidth );
+    passed = Compare( "Smoothing", smoothed, reference ) && passed;
+
+    // Adding in the first pass, and scaling in the last pass
+    smoothed = Duplicate( accumulator );
+    filter->SmoothFieldInPlace( smoothed, sigmas, field, addend, 0.5, nullptr, -2.0 );
+    FieldType::Pointer sum = Duplicate( field );
+    Combine( sum, 1.0, addend, 0.5 );
+    reference = Smooth( sum, sigmas, filter->GetMaximumError(), maximumKernelWidth );
+    Combine( reference, -2.0, reference, 0.0 );
+    passed = Compare( "Adding and scaling", smoothed, reference ) && passed;
+
+    // Accumulating in the last pass
+    smoothed = Duplicate( field );
+    FieldType::Pointer accumulated = Duplicate( accumulator );
+    filter->SmoothFieldInPlace( smoothed, sigmas, nullptr, nullptr, 1.0, accumulated, 0.25 );
+    reference = Smooth( field, sigmas, filter->GetMaximumError(), maximumKernelWidth );
+    Combine( reference, 0.25, accumulator, 1.0 );
+    passed = Compare( "Accumulating", accumulated, reference ) && passed;
+    }
+
+  // The fields must share their buffered region.
+  const FieldType::Pointer field = CreateField( generator );
+  FieldType::Pointer other = FieldType::New();
+  other->SetRegions( field->GetLargestPossibleRegion().GetSize() );
+  other->Allocate();
+  TRY_EXPECT_EXCEPTION( filter->SmoothFieldInPlace( field, sigmas, nullptr, other ) );
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
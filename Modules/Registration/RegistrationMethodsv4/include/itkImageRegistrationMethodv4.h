@@ -20,6 +20,7 @@
 
 #include "itkProcessObject.h"
 
+#include "itkCommand.h"
 #include "itkCompositeTransform.h"
 #include "itkDataObjectDecorator.h"
 #include "itkObjectToObjectMetricBase.h"
@@ -187,8 +188,22 @@ public:
   /** Weights type for the optimizer. */
   using OptimizerWeightsType = typename OptimizerType::ScalesType;
 
-  /** enum type for metric sampling strategy */
-  enum MetricSamplingStrategyType { NONE, REGULAR, RANDOM };
+  /** enum type for metric sampling strategy
+   *
+   * REGULAR and RANDOM draw a set of samples of the virtual domain at each
+   * level, which the image metrics evaluate at each iteration. STOCHASTIC
+   * draws a new small set of samples at each iteration of the optimizer:
+   * the voxels of the virtual domain inside the fixed image mask are listed
+   * at each level, and the sampling percentage of them are drawn, one in
+   * each of as many consecutive strata of the list, at a random position
+   * within the voxel. The samples are drawn in parallel, with random numbers
+   * which depend on the seed, the metric, the iteration and the stratum only,
+   * so that the samples do not depend on the number of threads. It is meant
+   * to be used with a stochastic optimizer, such as
+   * AdaptiveStochasticGradientDescentOptimizerv4. The registration methods
+   * which iterate themselves, instead of with the optimizer, draw one set of
+   * samples at each level. */
+  enum MetricSamplingStrategyType { NONE, REGULAR, RANDOM, STOCHASTIC };
 
   using MetricSamplePointSetType = typename ImageMetricType::FixedSampledPointSetType;
 
@@ -458,6 +473,15 @@ protected:
   /** Get metric samples. */
   virtual void SetMetricSamplePoints();
 
+  /** Draw the samples of the STOCHASTIC sampling strategy for an iteration
+   * of the current level, and pass them to the image metrics. */
+  virtual void SetStochasticMetricSamplePoints( SizeValueType iteration );
+
+  /** Get the virtual domain and the fixed image mask of the samples, and
+   * return the number of metrics to sample. */
+  SizeValueType GetMetricSamplingDomain( const VirtualImageType * & virtualImage,
+                                         const FixedImageMaskType * & fixedImageMask ) const;
+
   SizeValueType                                                   m_CurrentLevel;
   SizeValueType                                                   m_NumberOfLevels;
   SizeValueType                                                   m_CurrentIteration;
@@ -492,6 +516,13 @@ protected:
   int                                                             m_RandomSeed;
   int                                                             m_CurrentRandomSeed;
 
+  /** The offsets in the virtual domain region of the voxels inside the fixed
+   * image mask, from which the STOCHASTIC samples are drawn. Without a mask,
+   * the list is empty and the samples are drawn from all the voxels. */
+  std::vector<SizeValueType>                                      m_StochasticSampleCandidates;
+  SizeValueType                                                   m_NumberOfStochasticSampleCandidates;
+  uint64_t                                                        m_StochasticSamplingSeed;
+  SizeValueType                                                   m_StochasticSamplingIteration;
 
   TransformParametersAdaptorsContainerType                        m_TransformParametersAdaptorsPerLevel;
 
@@ -503,6 +534,16 @@ protected:
 
 
 private:
+  /** Draw the STOCHASTIC samples of the next iteration of the optimizer. */
+  void StochasticSamplingIteration();
+
+  /** Mix the bits of a counter into a random number, with the splitmix64
+   * finalizer. */
+  static uint64_t HashStochasticSamplingCounter( uint64_t counter );
+
+  using StochasticSamplingCommandType = SimpleMemberCommand<Self>;
+  typename StochasticSamplingCommandType::Pointer                 m_StochasticSamplingCommand;
+
   bool                                                            m_InPlace;
 
   bool                                                            m_InitializeCenterOfLinearOutputTransform;
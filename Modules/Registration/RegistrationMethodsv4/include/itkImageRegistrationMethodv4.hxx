@@ -128,6 +128,12 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
   this->m_MetricSamplingStrategy = NONE;
   this->m_MetricSamplingPercentagePerLevel.SetSize( this->m_NumberOfLevels );
   this->m_MetricSamplingPercentagePerLevel.Fill( 1.0 );
+
+  this->m_NumberOfStochasticSampleCandidates = 0;
+  this->m_StochasticSamplingSeed = 0;
+  this->m_StochasticSamplingIteration = 0;
+  this->m_StochasticSamplingCommand = StochasticSamplingCommandType::New();
+  this->m_StochasticSamplingCommand->SetCallbackFunction( this, &Self::StochasticSamplingIteration );
 }
 
 template<typename TFixedImage, typename TMovingImage, typename TTransform, typename TVirtualImage, typename TPointSet>
@@ -801,7 +807,29 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
 
     this->m_Metric->Initialize();
 
-    this->m_Optimizer->StartOptimization();
+    // Draw new samples after each iteration of the optimizer.
+    const bool drawStochasticSamples = ( this->m_MetricSamplingStrategy == STOCHASTIC );
+    unsigned long stochasticSamplingTag = 0;
+    if( drawStochasticSamples )
+      {
+      stochasticSamplingTag = this->m_Optimizer->AddObserver( IterationEvent(), this->m_StochasticSamplingCommand );
+      }
+    try
+      {
+      this->m_Optimizer->StartOptimization();
+      }
+    catch( ... )
+      {
+      if( drawStochasticSamples )
+        {
+        this->m_Optimizer->RemoveObserver( stochasticSamplingTag );
+        }
+      throw;
+      }
+    if( drawStochasticSamples )
+      {
+      this->m_Optimizer->RemoveObserver( stochasticSamplingTag );
+      }
     }
 }
 
@@ -876,22 +904,19 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
 }
 
 /**
- * Get the metric samples
+ * Get the virtual domain and the fixed mask of the metric samples
  */
 template<typename TFixedImage, typename TMovingImage, typename TTransform, typename TVirtualImage, typename TPointSet>
-void
+SizeValueType
 ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage, TPointSet>
-::SetMetricSamplePoints()
+::GetMetricSamplingDomain( const VirtualImageType * & virtualImage, const FixedImageMaskType * & fixedMaskImage ) const
 {
-  using VirtualDomainImageType = typename ImageMetricType::VirtualImageType;
-  using VirtualDomainRegionType = typename VirtualDomainImageType::RegionType;
-
-  const VirtualDomainImageType * virtualImage = nullptr;
-  const FixedImageMaskType * fixedMaskImage = nullptr;
+  virtualImage = nullptr;
+  fixedMaskImage = nullptr;
 
   SizeValueType numberOfLocalMetrics = 1;
 
-  typename MultiMetricType::Pointer multiMetric = dynamic_cast<MultiMetricType *>( this->m_Metric.GetPointer() );
+  const auto * multiMetric = dynamic_cast<const MultiMetricType *>( this->m_Metric.GetPointer() );
   if( multiMetric )
     {
     numberOfLocalMetrics = multiMetric->GetNumberOfMetrics();
@@ -901,8 +926,8 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
       }
     else
       {
-      typename ImageMetricType::Pointer firstMetric = dynamic_cast<ImageMetricType *>( multiMetric->GetMetricQueue()[0].GetPointer() );
-      if( firstMetric.IsNotNull() )
+      const auto * firstMetric = dynamic_cast<const ImageMetricType *>( multiMetric->GetMetricQueue()[0].GetPointer() );
+      if( firstMetric != nullptr )
         {
         virtualImage = firstMetric->GetVirtualImage();
         fixedMaskImage = firstMetric->GetFixedImageMask();
@@ -915,8 +940,8 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
     }
   else
     {
-    typename ImageMetricType::Pointer singleMetric = dynamic_cast<ImageMetricType *>( this->m_Metric.GetPointer() );
-    if( singleMetric.IsNotNull() )
+    const auto * singleMetric = dynamic_cast<const ImageMetricType *>( this->m_Metric.GetPointer() );
+    if( singleMetric != nullptr )
       {
       virtualImage = singleMetric->GetVirtualImage();
       fixedMaskImage = singleMetric->GetFixedImageMask();
@@ -926,18 +951,83 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
       itkExceptionMacro( "Invalid metric conversion." );
       }
     }
+  return numberOfLocalMetrics;
+}
+
+/**
+ * Get the metric samples
+ */
+template<typename TFixedImage, typename TMovingImage, typename TTransform, typename TVirtualImage, typename TPointSet>
+void
+ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage, TPointSet>
+::SetMetricSamplePoints()
+{
+  using VirtualDomainImageType = typename ImageMetricType::VirtualImageType;
+  using VirtualDomainRegionType = typename VirtualDomainImageType::RegionType;
+
+  const VirtualDomainImageType * virtualImage = nullptr;
+  const FixedImageMaskType * fixedMaskImage = nullptr;
+
+  const SizeValueType numberOfLocalMetrics = this->GetMetricSamplingDomain( virtualImage, fixedMaskImage );
+
+  typename MultiMetricType::Pointer multiMetric = dynamic_cast<MultiMetricType *>( this->m_Metric.GetPointer() );
 
   const VirtualDomainRegionType & virtualDomainRegion = virtualImage->GetRequestedRegion();
   const typename VirtualDomainImageType::SpacingType oneThirdVirtualSpacing = virtualImage->GetSpacing() / 3.0;
 
+  using SamplePointType = typename MetricSamplePointSetType::PointType;
+
+  using RandomizerType = Statistics::MersenneTwisterRandomVariateGenerator;
+
+  if( this->m_MetricSamplingStrategy == STOCHASTIC )
+    {
+    // List the voxels inside the mask once per level, and draw the samples
+    // of the first iteration.
+    this->m_StochasticSampleCandidates.clear();
+    if( fixedMaskImage )
+      {
+      SizeValueType offset = 0;
+      ImageRegionConstIteratorWithIndex<VirtualDomainImageType> It( virtualImage, virtualDomainRegion );
+      for( It.GoToBegin(); !It.IsAtEnd(); ++It, ++offset )
+        {
+        SamplePointType point;
+        virtualImage->TransformIndexToPhysicalPoint( It.GetIndex(), point );
+        if( fixedMaskImage->IsInside( point ) )
+          {
+          this->m_StochasticSampleCandidates.push_back( offset );
+          }
+        }
+      this->m_NumberOfStochasticSampleCandidates = this->m_StochasticSampleCandidates.size();
+      }
+    else
+      {
+      this->m_NumberOfStochasticSampleCandidates = virtualDomainRegion.GetNumberOfPixels();
+      }
+    if( this->m_NumberOfStochasticSampleCandidates == 0 )
+      {
+      itkExceptionMacro( "There are no voxels of the virtual domain inside the fixed image mask." );
+      }
+
+    typename RandomizerType::Pointer randomizer = RandomizerType::New();
+    if (m_ReseedIterator)
+      {
+      randomizer->SetSeed( );
+      }
+    else
+      {
+      randomizer->SetSeed( m_CurrentRandomSeed++ );
+      }
+    this->m_StochasticSamplingSeed = randomizer->GetIntegerVariate();
+    this->m_StochasticSamplingIteration = 0;
+    this->SetStochasticMetricSamplePoints( this->m_StochasticSamplingIteration );
+    return;
+    }
+
   for( SizeValueType n = 0; n < numberOfLocalMetrics; n++ )
     {
     typename MetricSamplePointSetType::Pointer samplePointSet = MetricSamplePointSetType::New();
     samplePointSet->Initialize();
 
-    using SamplePointType = typename MetricSamplePointSetType::PointType;
-
-    using RandomizerType = Statistics::MersenneTwisterRandomVariateGenerator;
     typename RandomizerType::Pointer randomizer = RandomizerType::New();
     if (m_ReseedIterator)
       {
@@ -1035,6 +1125,128 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
     }
 }
 
+/**
+ * Draw the stochastic metric samples of an iteration
+ */
+template<typename TFixedImage, typename TMovingImage, typename TTransform, typename TVirtualImage, typename TPointSet>
+void
+ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage, TPointSet>
+::SetStochasticMetricSamplePoints( SizeValueType iteration )
+{
+  using VirtualDomainImageType = typename ImageMetricType::VirtualImageType;
+  using VirtualDomainRegionType = typename VirtualDomainImageType::RegionType;
+  using SamplePointType = typename MetricSamplePointSetType::PointType;
+  using SamplePointsContainerType = typename MetricSamplePointSetType::PointsContainer;
+
+  const VirtualDomainImageType * virtualImage = nullptr;
+  const FixedImageMaskType * fixedMaskImage = nullptr;
+
+  const SizeValueType numberOfLocalMetrics = this->GetMetricSamplingDomain( virtualImage, fixedMaskImage );
+
+  typename MultiMetricType::Pointer multiMetric = dynamic_cast<MultiMetricType *>( this->m_Metric.GetPointer() );
+
+  const VirtualDomainRegionType & virtualDomainRegion = virtualImage->GetRequestedRegion();
+
+  const SizeValueType numberOfCandidates = this->m_NumberOfStochasticSampleCandidates;
+  const SizeValueType numberOfSamples = std::max( NumericTraits<SizeValueType>::OneValue(),
+    std::min( numberOfCandidates, static_cast<SizeValueType>(
+      this->m_MetricSamplingPercentagePerLevel[this->m_CurrentLevel] * numberOfCandidates ) ) );
+
+  // One sample is drawn in each stratum of consecutive candidates.
+  ImageRegion<1> strata;
+  strata.SetSize( 0, numberOfSamples );
+
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+
+  for( SizeValueType n = 0; n < numberOfLocalMetrics; n++ )
+    {
+    ImageMetricType * imageMetric = dynamic_cast<ImageMetricType *>( multiMetric ?
+      multiMetric->GetMetricQueue()[n].GetPointer() : this->m_Metric.GetPointer() );
+    if( imageMetric == nullptr )
+      {
+      continue;
+      }
+
+    // The random numbers are a hash of the seed, the metric, the iteration
+    // and the stratum, so that they do not depend on the threads.
+    const uint64_t counter = HashStochasticSamplingCounter(
+      HashStochasticSamplingCounter( this->m_StochasticSamplingSeed + n ) + iteration );
+
+    typename SamplePointsContainerType::Pointer points = SamplePointsContainerType::New();
+    points->Reserve( numberOfSamples );
+
+    multiThreader->ParallelizeImageRegion<1>( strata,
+      [&]( const ImageRegion<1> & subStrata )
+        {
+        const SizeValueType firstStratum = subStrata.GetIndex( 0 );
+        for( SizeValueType stratum = firstStratum; stratum < firstStratum + subStrata.GetSize( 0 ); ++stratum )
+          {
+          // the 53 upper bits of the random numbers give uniform values in [0, 1)
+          uint64_t random = HashStochasticSamplingCounter( counter + stratum );
+          const SizeValueType begin = stratum * numberOfCandidates / numberOfSamples;
+          const SizeValueType end = ( stratum + 1 ) * numberOfCandidates / numberOfSamples;
+          SizeValueType offset = begin + std::min( end - begin - 1, static_cast<SizeValueType>(
+            ( random >> 11 ) * ( 1.0 / 9007199254740992.0 ) * ( end - begin ) ) );
+          if( fixedMaskImage )
+            {
+            offset = this->m_StochasticSampleCandidates[offset];
+            }
+
+          // a random position within the voxel
+          typename VirtualDomainImageType::IndexType index;
+          ContinuousIndex<double, ImageDimension> continuousIndex;
+          for( unsigned int d = 0; d < ImageDimension; d++ )
+            {
+            index[d] = virtualDomainRegion.GetIndex( d ) + static_cast<IndexValueType>( offset % virtualDomainRegion.GetSize( d ) );
+            offset /= virtualDomainRegion.GetSize( d );
+            random = HashStochasticSamplingCounter( random );
+            continuousIndex[d] = index[d] + ( random >> 11 ) * ( 1.0 / 9007199254740992.0 ) - 0.5;
+            }
+          SamplePointType point;
+          virtualImage->TransformContinuousIndexToPhysicalPoint( continuousIndex, point );
+          if( fixedMaskImage && !fixedMaskImage->IsInside( point ) )
+            {
+            virtualImage->TransformIndexToPhysicalPoint( index, point );
+            }
+          points->ElementAt( stratum ) = point;
+          }
+        }, nullptr );
+
+    typename MetricSamplePointSetType::Pointer samplePointSet = MetricSamplePointSetType::New();
+    samplePointSet->SetPoints( points );
+
+    // The metric is initialized after the samples of the first iteration.
+    if( iteration == 0 )
+      {
+      imageMetric->SetFixedSampledPointSet( samplePointSet );
+      imageMetric->SetUseFixedSampledPointSet( true );
+      }
+    else
+      {
+      imageMetric->UpdateFixedSampledPointSet( samplePointSet );
+      }
+    }
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TTransform, typename TVirtualImage, typename TPointSet>
+void
+ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage, TPointSet>
+::StochasticSamplingIteration()
+{
+  this->SetStochasticMetricSamplePoints( ++this->m_StochasticSamplingIteration );
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TTransform, typename TVirtualImage, typename TPointSet>
+uint64_t
+ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage, TPointSet>
+::HashStochasticSamplingCounter( uint64_t counter )
+{
+  counter += 0x9E3779B97F4A7C15ULL;
+  counter = ( counter ^ ( counter >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+  counter = ( counter ^ ( counter >> 27 ) ) * 0x94D049BB133111EBULL;
+  return counter ^ ( counter >> 31 );
+}
+
 template<typename TFixedImage, typename TMovingImage, typename TTransform, typename TVirtualImage, typename TPointSet>
 void
 ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage, TPointSet>
@@ -1161,6 +1373,7 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
   os << indent << "ReseedIterator: " << m_ReseedIterator << std::endl;
   os << indent << "RandomSeed: " << m_RandomSeed << std::endl;
   os << indent << "CurrentRandomSeed: " << m_CurrentRandomSeed << std::endl;
+  os << indent << "NumberOfStochasticSampleCandidates: " << m_NumberOfStochasticSampleCandidates << std::endl;
 
   os << indent << "InPlace: " << ( this->m_InPlace ? "On" : "Off" ) << std::endl;
 
@@ -56,6 +56,26 @@ namespace itk
  * The method evolved since that time with crucial contributions from Gang Song and
  * Nick Tustison. Though similar in spirit, this implementation is not identical.
  *
+ * Lean memory mode
+ *
+ * By default, each iteration allocates new vector fields for the metric
+ * gradients, the smoothed and scaled update fields, the composed and
+ * smoothed total fields and the inverse fields, through the corresponding
+ * filters. With \c UseLeanMemory on, one update field per side is allocated
+ * at each level and reused at each iteration, and the metric derivative is
+ * stored directly in its buffer. The update fields are smoothed and scaled
+ * in place, the composition with the total fields is fused with the first
+ * pass of the separable smoothing of the total fields, and the inverse
+ * fields and the total fields are estimated in place with the same
+ * fixed-point scheme as InvertDisplacementFieldImageFilter. The results
+ * match the default mode up to round-off. The fields are stored with the
+ * scalar type of the output transform, so single precision fields are
+ * obtained with e.g. a DisplacementFieldTransform<float, 3> output
+ * transform; the lean kernels accumulate in
+ * NumericTraits<RealType>::AccumulateType. Subclasses which override
+ * StartOptimization, e.g. BSplineSyNImageRegistrationMethod, do not use
+ * this mode.
+ *
  * \todo Need to allow the fixed image to have a composite transform.
  *
  * \author Nick Tustison
@@ -187,6 +207,14 @@ public:
   itkSetMacro( GaussianSmoothingVarianceForTheTotalField, RealType );
   itkGetConstReferenceMacro( GaussianSmoothingVarianceForTheTotalField, RealType );
 
+  /**
+   * Get/Set whether to reuse preallocated field buffers and update the fields
+   * in place at each iteration. See the main documentation. Default = false.
+   */
+  itkSetMacro( UseLeanMemory, bool );
+  itkGetConstMacro( UseLeanMemory, bool );
+  itkBooleanMacro( UseLeanMemory );
+
   /** Get modifiable FixedToMiddle and MovingToMidle transforms to save the current state of the registration. */
   itkGetModifiableObjectMacro( FixedToMiddleTransform, OutputTransformType );
   itkGetModifiableObjectMacro( MovingToMiddleTransform, OutputTransformType );
@@ -220,10 +248,32 @@ protected:
     const PointSetsContainerType, const TransformBaseType *, const FixedImageMasksContainerType,
     const MovingImageMasksContainerType, MeasureType & );
 
+  /** Set the objects, transforms and masks of the metric for the computation of a metric gradient field,
+   * and initialize it. */
+  void InitializeMetricForGradientField( const FixedImagesContainerType, const PointSetsContainerType,
+    const TransformBaseType *, const MovingImagesContainerType, const PointSetsContainerType,
+    const TransformBaseType *, const FixedImageMasksContainerType, const MovingImageMasksContainerType );
+
+  /** Lean memory version of ComputeUpdateField, which computes the smoothed and scaled update field in the
+   * buffer of the given field. */
+  virtual void ComputeUpdateFieldInPlace( const FixedImagesContainerType, const PointSetsContainerType,
+    const TransformBaseType *, const MovingImagesContainerType, const PointSetsContainerType,
+    const TransformBaseType *, const FixedImageMasksContainerType, const MovingImageMasksContainerType,
+    DisplacementFieldType *, MeasureType & );
+
   virtual DisplacementFieldPointer ScaleUpdateField( const DisplacementFieldType * );
   virtual DisplacementFieldPointer GaussianSmoothDisplacementField( const DisplacementFieldType *, const RealType );
   virtual DisplacementFieldPointer InvertDisplacementField( const DisplacementFieldType *, const DisplacementFieldType * = nullptr );
 
+  /** Smooth the field in place, one line at a time, as GaussianSmoothDisplacementField. If an update field is
+   * given, the field is first replaced by the composition of the update field with the field, in the first
+   * smoothing pass. */
+  virtual void GaussianSmoothDisplacementFieldInPlace( DisplacementFieldType *, const RealType,
+    const DisplacementFieldType * updateField = nullptr );
+
+  /** Improve the estimate of the inverse of the field in place, as InvertDisplacementField. */
+  virtual void InvertDisplacementFieldInPlace( const DisplacementFieldType *, DisplacementFieldType * );
+
   RealType                                                        m_LearningRate;
 
   OutputTransformPointer                                          m_MovingToMiddleTransform;
@@ -235,6 +285,13 @@ protected:
   NumberOfIterationsArrayType                                     m_NumberOfIterationsPerLevel;
   bool                                                            m_DownsampleImagesForMetricDerivatives;
   bool                                                            m_AverageMidPointGradients;
+  bool                                                            m_UseLeanMemory;
+
+  /** Field buffers of the lean memory mode, allocated at each level. */
+  DisplacementFieldPointer                                        m_FixedToMiddleUpdateField;
+  DisplacementFieldPointer                                        m_MovingToMiddleUpdateField;
+  DisplacementFieldPointer                                        m_LeanSmoothingField;
+  DisplacementFieldTransformPointer                               m_IdentityDisplacementFieldTransform;
 
 private:
   RealType                                                        m_GaussianSmoothingVarianceForTheUpdateField;
@@ -22,11 +22,16 @@
 
 #include "itkComposeDisplacementFieldsImageFilter.h"
 #include "itkGaussianOperator.h"
+#include "itkImageAlgorithm.h"
+#include "itkImageLinearIteratorWithIndex.h"
 #include "itkImageMaskSpatialObject.h"
 #include "itkImportImageFilter.h"
 #include "itkInvertDisplacementFieldImageFilter.h"
 #include "itkIterationReporter.h"
 #include "itkMultiplyImageFilter.h"
+#include "itkMutexLockHolder.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkVectorLinearInterpolateImageFunction.h"
 #include "itkVectorNeighborhoodOperatorImageFilter.h"
 #include "itkWindowConvergenceMonitoringFunction.h"
 
@@ -50,6 +55,7 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
   this->m_NumberOfIterationsPerLevel[2] = 40;
   this->m_DownsampleImagesForMetricDerivatives = true;
   this->m_AverageMidPointGradients = false;
+  this->m_UseLeanMemory = false;
   this->m_FixedToMiddleTransform = nullptr;
   this->m_MovingToMiddleTransform = nullptr;
 }
@@ -162,6 +168,29 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
 
   IterationReporter reporter( this, 0, 1 );
 
+  if( this->m_UseLeanMemory )
+    {
+    // Allocate the update field buffers of the level, which are reused at each iteration.
+    DisplacementFieldPointer * updateFields[2] = { &this->m_FixedToMiddleUpdateField, &this->m_MovingToMiddleUpdateField };
+    for( auto updateField : updateFields )
+      {
+      if( updateField->IsNull() || (*updateField)->GetLargestPossibleRegion() != virtualDomainImage->GetLargestPossibleRegion() )
+        {
+        *updateField = nullptr;
+        *updateField = DisplacementFieldType::New();
+        (*updateField)->CopyInformation( virtualDomainImage );
+        (*updateField)->SetRegions( virtualDomainImage->GetLargestPossibleRegion() );
+        (*updateField)->Allocate();
+        }
+      else
+        {
+        (*updateField)->CopyInformation( virtualDomainImage );
+        }
+      }
+    this->m_LeanSmoothingField = nullptr;
+    this->m_IdentityDisplacementFieldTransform = nullptr;
+    }
+
   while( this->m_CurrentIteration++ < this->m_NumberOfIterationsPerLevel[this->m_CurrentLevel] && !this->m_IsConverged )
     {
     typename CompositeTransformType::Pointer fixedComposite = CompositeTransformType::New();
@@ -184,15 +213,35 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
     MeasureType fixedMetricValue = 0.0;
     MeasureType movingMetricValue = 0.0;
 
-    DisplacementFieldPointer fixedToMiddleSmoothUpdateField = this->ComputeUpdateField(
-      this->m_FixedSmoothImages, this->m_FixedPointSets, fixedComposite,
-      this->m_MovingSmoothImages, this->m_MovingPointSets, movingComposite,
-      this->m_FixedImageMasks, this->m_MovingImageMasks, movingMetricValue );
+    DisplacementFieldPointer fixedToMiddleSmoothUpdateField;
+    DisplacementFieldPointer movingToMiddleSmoothUpdateField;
 
-    DisplacementFieldPointer movingToMiddleSmoothUpdateField = this->ComputeUpdateField(
-      this->m_MovingSmoothImages, this->m_MovingPointSets, movingComposite,
-      this->m_FixedSmoothImages, this->m_FixedPointSets, fixedComposite,
-      this->m_MovingImageMasks, this->m_FixedImageMasks, fixedMetricValue );
+    if( this->m_UseLeanMemory )
+      {
+      fixedToMiddleSmoothUpdateField = this->m_FixedToMiddleUpdateField;
+      this->ComputeUpdateFieldInPlace(
+        this->m_FixedSmoothImages, this->m_FixedPointSets, fixedComposite,
+        this->m_MovingSmoothImages, this->m_MovingPointSets, movingComposite,
+        this->m_FixedImageMasks, this->m_MovingImageMasks, fixedToMiddleSmoothUpdateField, movingMetricValue );
+
+      movingToMiddleSmoothUpdateField = this->m_MovingToMiddleUpdateField;
+      this->ComputeUpdateFieldInPlace(
+        this->m_MovingSmoothImages, this->m_MovingPointSets, movingComposite,
+        this->m_FixedSmoothImages, this->m_FixedPointSets, fixedComposite,
+        this->m_MovingImageMasks, this->m_FixedImageMasks, movingToMiddleSmoothUpdateField, fixedMetricValue );
+      }
+    else
+      {
+      fixedToMiddleSmoothUpdateField = this->ComputeUpdateField(
+        this->m_FixedSmoothImages, this->m_FixedPointSets, fixedComposite,
+        this->m_MovingSmoothImages, this->m_MovingPointSets, movingComposite,
+        this->m_FixedImageMasks, this->m_MovingImageMasks, movingMetricValue );
+
+      movingToMiddleSmoothUpdateField = this->ComputeUpdateField(
+        this->m_MovingSmoothImages, this->m_MovingPointSets, movingComposite,
+        this->m_FixedSmoothImages, this->m_FixedPointSets, fixedComposite,
+        this->m_MovingImageMasks, this->m_FixedImageMasks, fixedMetricValue );
+      }
 
     if ( this->m_AverageMidPointGradients )
       {
@@ -204,40 +253,63 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
         }
       }
 
-    // Add the update field to both displacement fields (from fixed/moving to middle image) and then smooth
+    if( this->m_UseLeanMemory )
+      {
+      // Compose the update fields with the total fields and smooth them, then estimate the inverse fields
+      // and the total fields again, in place.
+      OutputTransformType * middleTransforms[2] = { this->m_FixedToMiddleTransform, this->m_MovingToMiddleTransform };
+      const DisplacementFieldType * updateFields[2] = { fixedToMiddleSmoothUpdateField, movingToMiddleSmoothUpdateField };
+      for( unsigned int n = 0; n < 2; n++ )
+        {
+        DisplacementFieldType * totalField = middleTransforms[n]->GetModifiableDisplacementField();
+        DisplacementFieldType * inverseField = middleTransforms[n]->GetModifiableInverseDisplacementField();
+
+        this->GaussianSmoothDisplacementFieldInPlace( totalField, this->m_GaussianSmoothingVarianceForTheTotalField, updateFields[n] );
+        this->InvertDisplacementFieldInPlace( totalField, inverseField );
+        this->InvertDisplacementFieldInPlace( inverseField, totalField );
+
+        totalField->Modified();
+        inverseField->Modified();
+        middleTransforms[n]->Modified();
+        }
+      }
+    else
+      {
+      // Add the update field to both displacement fields (from fixed/moving to middle image) and then smooth
 
-    using ComposerType = ComposeDisplacementFieldsImageFilter<DisplacementFieldType>;
+      using ComposerType = ComposeDisplacementFieldsImageFilter<DisplacementFieldType>;
 
-    typename ComposerType::Pointer fixedComposer = ComposerType::New();
-    fixedComposer->SetDisplacementField( fixedToMiddleSmoothUpdateField );
-    fixedComposer->SetWarpingField( this->m_FixedToMiddleTransform->GetDisplacementField() );
-    fixedComposer->Update();
+      typename ComposerType::Pointer fixedComposer = ComposerType::New();
+      fixedComposer->SetDisplacementField( fixedToMiddleSmoothUpdateField );
+      fixedComposer->SetWarpingField( this->m_FixedToMiddleTransform->GetDisplacementField() );
+      fixedComposer->Update();
 
-    DisplacementFieldPointer fixedToMiddleSmoothTotalFieldTmp = this->GaussianSmoothDisplacementField(
-      fixedComposer->GetOutput(), this->m_GaussianSmoothingVarianceForTheTotalField );
+      DisplacementFieldPointer fixedToMiddleSmoothTotalFieldTmp = this->GaussianSmoothDisplacementField(
+        fixedComposer->GetOutput(), this->m_GaussianSmoothingVarianceForTheTotalField );
 
-    typename ComposerType::Pointer movingComposer = ComposerType::New();
-    movingComposer->SetDisplacementField( movingToMiddleSmoothUpdateField );
-    movingComposer->SetWarpingField( this->m_MovingToMiddleTransform->GetDisplacementField() );
-    movingComposer->Update();
+      typename ComposerType::Pointer movingComposer = ComposerType::New();
+      movingComposer->SetDisplacementField( movingToMiddleSmoothUpdateField );
+      movingComposer->SetWarpingField( this->m_MovingToMiddleTransform->GetDisplacementField() );
+      movingComposer->Update();
 
-    DisplacementFieldPointer movingToMiddleSmoothTotalFieldTmp = this->GaussianSmoothDisplacementField(
-      movingComposer->GetOutput(), this->m_GaussianSmoothingVarianceForTheTotalField );
+      DisplacementFieldPointer movingToMiddleSmoothTotalFieldTmp = this->GaussianSmoothDisplacementField(
+        movingComposer->GetOutput(), this->m_GaussianSmoothingVarianceForTheTotalField );
 
-    // Iteratively estimate the inverse fields.
+      // Iteratively estimate the inverse fields.
 
-    DisplacementFieldPointer fixedToMiddleSmoothTotalFieldInverse = this->InvertDisplacementField( fixedToMiddleSmoothTotalFieldTmp, this->m_FixedToMiddleTransform->GetInverseDisplacementField() );
-    DisplacementFieldPointer fixedToMiddleSmoothTotalField = this->InvertDisplacementField( fixedToMiddleSmoothTotalFieldInverse, fixedToMiddleSmoothTotalFieldTmp );
+      DisplacementFieldPointer fixedToMiddleSmoothTotalFieldInverse = this->InvertDisplacementField( fixedToMiddleSmoothTotalFieldTmp, this->m_FixedToMiddleTransform->GetInverseDisplacementField() );
+      DisplacementFieldPointer fixedToMiddleSmoothTotalField = this->InvertDisplacementField( fixedToMiddleSmoothTotalFieldInverse, fixedToMiddleSmoothTotalFieldTmp );
 
-    DisplacementFieldPointer movingToMiddleSmoothTotalFieldInverse = this->InvertDisplacementField( movingToMiddleSmoothTotalFieldTmp, this->m_MovingToMiddleTransform->GetInverseDisplacementField() );
-    DisplacementFieldPointer movingToMiddleSmoothTotalField = this->InvertDisplacementField( movingToMiddleSmoothTotalFieldInverse, movingToMiddleSmoothTotalFieldTmp );
+      DisplacementFieldPointer movingToMiddleSmoothTotalFieldInverse = this->InvertDisplacementField( movingToMiddleSmoothTotalFieldTmp, this->m_MovingToMiddleTransform->GetInverseDisplacementField() );
+      DisplacementFieldPointer movingToMiddleSmoothTotalField = this->InvertDisplacementField( movingToMiddleSmoothTotalFieldInverse, movingToMiddleSmoothTotalFieldTmp );
 
-    // Assign the displacement fields and their inverses to the proper transforms.
-    this->m_FixedToMiddleTransform->SetDisplacementField( fixedToMiddleSmoothTotalField );
-    this->m_FixedToMiddleTransform->SetInverseDisplacementField( fixedToMiddleSmoothTotalFieldInverse );
+      // Assign the displacement fields and their inverses to the proper transforms.
+      this->m_FixedToMiddleTransform->SetDisplacementField( fixedToMiddleSmoothTotalField );
+      this->m_FixedToMiddleTransform->SetInverseDisplacementField( fixedToMiddleSmoothTotalFieldInverse );
 
-    this->m_MovingToMiddleTransform->SetDisplacementField( movingToMiddleSmoothTotalField );
-    this->m_MovingToMiddleTransform->SetInverseDisplacementField( movingToMiddleSmoothTotalFieldInverse );
+      this->m_MovingToMiddleTransform->SetDisplacementField( movingToMiddleSmoothTotalField );
+      this->m_MovingToMiddleTransform->SetInverseDisplacementField( movingToMiddleSmoothTotalFieldInverse );
+      }
 
     this->m_CurrentMetricValue = 0.5 * ( movingMetricValue + fixedMetricValue );
 
@@ -273,12 +345,93 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
 }
 
 template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
-typename SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>::DisplacementFieldPointer
+void
 SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
-::ComputeMetricGradientField( const FixedImagesContainerType fixedImages, const PointSetsContainerType fixedPointSets,
+::ComputeUpdateFieldInPlace( const FixedImagesContainerType fixedImages, const PointSetsContainerType fixedPointSets,
   const TransformBaseType * fixedTransform, const MovingImagesContainerType movingImages, const PointSetsContainerType movingPointSets,
   const TransformBaseType * movingTransform, const FixedImageMasksContainerType fixedImageMasks, const MovingImageMasksContainerType movingImageMasks,
-  MeasureType & value )
+  DisplacementFieldType * updateField, MeasureType & value )
+{
+  this->InitializeMetricForGradientField( fixedImages, fixedPointSets, fixedTransform, movingImages, movingPointSets,
+    movingTransform, fixedImageMasks, movingImageMasks );
+
+  // The metric derivative is stored in the buffer of the update field, which
+  // holds ImageDimension values of type RealType per pixel.
+  using MetricDerivativeType = typename ImageMetricType::DerivativeType;
+  using MetricDerivativeValueType = typename MetricDerivativeType::ValueType;
+  static_assert( std::is_same<MetricDerivativeValueType, RealType>::value,
+    "The metric derivative and the displacement field must have the same value type." );
+
+  const SizeValueType metricDerivativeSize = updateField->GetLargestPossibleRegion().GetNumberOfPixels() * ImageDimension;
+  auto * updateFieldBuffer = reinterpret_cast<MetricDerivativeValueType *>( updateField->GetBufferPointer() );
+
+  const DisplacementVectorType zeroVector( 0.0 );
+  updateField->FillBuffer( zeroVector );
+
+  MetricDerivativeType metricDerivative;
+  metricDerivative.SetData( updateFieldBuffer, metricDerivativeSize, false );
+  this->m_Metric->GetValueAndDerivative( value, metricDerivative );
+
+  if( metricDerivative.data_block() != updateFieldBuffer )
+    {
+    // The metric resized the derivative.
+    std::copy_n( metricDerivative.data_block(), std::min( metricDerivativeSize, static_cast<SizeValueType>( metricDerivative.Size() ) ),
+      updateFieldBuffer );
+    }
+
+  if( !this->m_OptimizerWeightsAreIdentity && this->m_OptimizerWeights.Size() == ImageDimension )
+    {
+    for( SizeValueType i = 0; i < metricDerivativeSize; i += ImageDimension )
+      {
+      for( unsigned int d = 0; d < ImageDimension; d++ )
+        {
+        updateFieldBuffer[i + d] *= this->m_OptimizerWeights[d];
+        }
+      }
+    }
+
+  this->GaussianSmoothDisplacementFieldInPlace( updateField, this->m_GaussianSmoothingVarianceForTheUpdateField );
+
+  // Scale the update field in place, as ScaleUpdateField.
+  typename DisplacementFieldType::SpacingType spacing = updateField->GetSpacing();
+  ImageRegionIterator<DisplacementFieldType> ItF( updateField, updateField->GetLargestPossibleRegion() );
+
+  RealType maxNorm = NumericTraits<RealType>::NonpositiveMin();
+  for( ItF.GoToBegin(); !ItF.IsAtEnd(); ++ItF )
+    {
+    const DisplacementVectorType & vector = ItF.Value();
+
+    RealType localNorm = 0;
+    for( SizeValueType d = 0; d < ImageDimension; d++ )
+      {
+      localNorm += itk::Math::sqr( vector[d] / spacing[d] );
+      }
+    localNorm = std::sqrt( localNorm );
+
+    if( localNorm > maxNorm )
+      {
+      maxNorm = localNorm;
+      }
+    }
+
+  RealType scale = this->m_LearningRate;
+  if( maxNorm > NumericTraits<RealType>::ZeroValue() )
+    {
+    scale /= maxNorm;
+    }
+
+  for( ItF.GoToBegin(); !ItF.IsAtEnd(); ++ItF )
+    {
+    ItF.Value() *= scale;
+    }
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+void
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::InitializeMetricForGradientField( const FixedImagesContainerType fixedImages, const PointSetsContainerType fixedPointSets,
+  const TransformBaseType * fixedTransform, const MovingImagesContainerType movingImages, const PointSetsContainerType movingPointSets,
+  const TransformBaseType * movingTransform, const FixedImageMasksContainerType fixedImageMasks, const MovingImageMasksContainerType movingImageMasks )
 {
   typename MultiMetricType::Pointer multiMetric = dynamic_cast<MultiMetricType *>( this->m_Metric.GetPointer() );
 
@@ -498,17 +651,33 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
 
   if( this->m_DownsampleImagesForMetricDerivatives && this->m_Metric->GetMetricCategory() != MetricType::POINT_SET_METRIC )
     {
-    const DisplacementVectorType zeroVector( 0.0 );
+    DisplacementFieldTransformPointer identityDisplacementFieldTransform;
+    if( this->m_UseLeanMemory && this->m_IdentityDisplacementFieldTransform.IsNotNull()
+      && this->m_IdentityDisplacementFieldTransform->GetDisplacementField()->GetLargestPossibleRegion() ==
+        virtualDomainImage->GetLargestPossibleRegion() )
+      {
+      // The identity transform of the level is reused at each iteration.
+      identityDisplacementFieldTransform = this->m_IdentityDisplacementFieldTransform;
+      }
+    else
+      {
+      const DisplacementVectorType zeroVector( 0.0 );
 
-    typename DisplacementFieldType::Pointer identityField = DisplacementFieldType::New();
-    identityField->CopyInformation( virtualDomainImage );
-    identityField->SetRegions( virtualDomainImage->GetLargestPossibleRegion() );
-    identityField->Allocate();
-    identityField->FillBuffer( zeroVector );
+      typename DisplacementFieldType::Pointer identityField = DisplacementFieldType::New();
+      identityField->CopyInformation( virtualDomainImage );
+      identityField->SetRegions( virtualDomainImage->GetLargestPossibleRegion() );
+      identityField->Allocate();
+      identityField->FillBuffer( zeroVector );
 
-    DisplacementFieldTransformPointer identityDisplacementFieldTransform = DisplacementFieldTransformType::New();
-    identityDisplacementFieldTransform->SetDisplacementField( identityField );
-    identityDisplacementFieldTransform->SetInverseDisplacementField( identityField );
+      identityDisplacementFieldTransform = DisplacementFieldTransformType::New();
+      identityDisplacementFieldTransform->SetDisplacementField( identityField );
+      identityDisplacementFieldTransform->SetInverseDisplacementField( identityField );
+
+      if( this->m_UseLeanMemory )
+        {
+        this->m_IdentityDisplacementFieldTransform = identityDisplacementFieldTransform;
+        }
+      }
 
     if( this->m_Metric->GetMetricCategory() == MetricType::MULTI_METRIC )
       {
@@ -523,6 +692,20 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
     }
 
   this->m_Metric->Initialize();
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+typename SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>::DisplacementFieldPointer
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::ComputeMetricGradientField( const FixedImagesContainerType fixedImages, const PointSetsContainerType fixedPointSets,
+  const TransformBaseType * fixedTransform, const MovingImagesContainerType movingImages, const PointSetsContainerType movingPointSets,
+  const TransformBaseType * movingTransform, const FixedImageMasksContainerType fixedImageMasks, const MovingImageMasksContainerType movingImageMasks,
+  MeasureType & value )
+{
+  this->InitializeMetricForGradientField( fixedImages, fixedPointSets, fixedTransform, movingImages, movingPointSets,
+    movingTransform, fixedImageMasks, movingImageMasks );
+
+  VirtualImageBaseConstPointer virtualDomainImage = this->GetCurrentLevelVirtualDomainImage();
 
   using MetricDerivativeType = typename ImageMetricType::DerivativeType;
   const typename MetricDerivativeType::SizeValueType metricDerivativeSize = virtualDomainImage->GetLargestPossibleRegion().GetNumberOfPixels() * ImageDimension;
@@ -728,6 +911,319 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
   return smoothField;
 }
 
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+void
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::GaussianSmoothDisplacementFieldInPlace( DisplacementFieldType * field, const RealType variance,
+  const DisplacementFieldType * updateField )
+{
+  using AccumulateType = typename NumericTraits<RealType>::AccumulateType;
+  using AccumulateVectorType = Vector<AccumulateType, ImageDimension>;
+  using RegionType = typename DisplacementFieldType::RegionType;
+  using InterpolatorType = VectorLinearInterpolateImageFunction<DisplacementFieldType, RealType>;
+
+  if( variance <= 0.0 && updateField == nullptr )
+    {
+    return;
+    }
+
+  const RegionType region = field->GetLargestPossibleRegion();
+  const typename DisplacementFieldType::SizeType size = region.GetSize();
+  const typename DisplacementFieldType::IndexType startIndex = region.GetIndex();
+  const DisplacementVectorType zeroVector( 0.0 );
+
+  typename InterpolatorType::Pointer interpolator;
+  if( updateField != nullptr )
+    {
+    interpolator = InterpolatorType::New();
+    interpolator->SetInputImage( updateField );
+    }
+
+  // The one-dimensional kernels of the separable smoothing, or a single
+  // composition pass without smoothing.
+  std::vector<std::vector<AccumulateType> > kernels;
+  if( variance > 0.0 )
+    {
+    using GaussianSmoothingOperatorType = GaussianOperator<RealType, ImageDimension>;
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      GaussianSmoothingOperatorType gaussianSmoothingOperator;
+      gaussianSmoothingOperator.SetDirection( d );
+      gaussianSmoothingOperator.SetVariance( variance );
+      gaussianSmoothingOperator.SetMaximumError( 0.001 );
+      gaussianSmoothingOperator.SetMaximumKernelWidth( size[d] );
+      gaussianSmoothingOperator.CreateDirectional();
+      kernels.emplace_back( gaussianSmoothingOperator.Begin(), gaussianSmoothingOperator.End() );
+      }
+    }
+  else
+    {
+    kernels.emplace_back( 1, NumericTraits<AccumulateType>::OneValue() );
+    }
+
+  // Weights of the smoothed and the unsmoothed field, as in GaussianSmoothDisplacementField.
+  RealType weight1 = 1.0;
+  if( variance < 0.5 )
+    {
+    weight1 = 1.0 - 1.0 * ( variance / 0.5 );
+    }
+  const RealType weight2 = 1.0 - weight1;
+
+  const bool blendWithUnsmoothedField = ( variance > 0.0 && weight2 > 0.0 );
+  if( blendWithUnsmoothedField )
+    {
+    if( updateField != nullptr )
+      {
+      // The composed field is needed for the blending, so compose first.
+      this->GaussianSmoothDisplacementFieldInPlace( field, 0.0, updateField );
+      interpolator = nullptr;
+      }
+    if( this->m_LeanSmoothingField.IsNull() || this->m_LeanSmoothingField->GetLargestPossibleRegion() != region )
+      {
+      this->m_LeanSmoothingField = DisplacementFieldType::New();
+      this->m_LeanSmoothingField->CopyInformation( field );
+      this->m_LeanSmoothingField->SetRegions( region );
+      this->m_LeanSmoothingField->Allocate();
+      }
+    ImageAlgorithm::Copy( field, this->m_LeanSmoothingField.GetPointer(), region, region );
+    }
+  const DisplacementFieldType * unsmoothedField = blendWithUnsmoothedField ? this->m_LeanSmoothingField.GetPointer() : nullptr;
+
+  for( unsigned int pass = 0; pass < kernels.size(); pass++ )
+    {
+    const std::vector<AccumulateType> & kernel = kernels[pass];
+    const InterpolatorType * composer = ( pass == 0 ) ? interpolator.GetPointer() : nullptr;
+    const bool isLastSmoothingPass = ( variance > 0.0 && pass + 1 == kernels.size() );
+
+    // Each work unit processes the lines along the pass direction which start
+    // in its region.
+    RegionType lineStartRegion = region;
+    lineStartRegion.SetSize( pass, 1 );
+
+    this->GetMultiThreader()->template ParallelizeImageRegion<ImageDimension>( lineStartRegion,
+      [&]( const RegionType & lineStartRegionForThread )
+      {
+      RegionType lineRegion = lineStartRegionForThread;
+      lineRegion.SetIndex( pass, startIndex[pass] );
+      lineRegion.SetSize( pass, size[pass] );
+
+      const auto lineLength = static_cast<IndexValueType>( size[pass] );
+      const auto radius = static_cast<IndexValueType>( kernel.size() / 2 );
+      std::vector<DisplacementVectorType> line( lineLength );
+
+      ImageLinearIteratorWithIndex<DisplacementFieldType> It( field, lineRegion );
+      It.SetDirection( pass );
+      for( It.GoToBegin(); !It.IsAtEnd(); It.NextLine() )
+        {
+        for( IndexValueType i = 0; !It.IsAtEndOfLine(); ++It, ++i )
+          {
+          line[i] = It.Get();
+          if( composer != nullptr )
+            {
+            typename DisplacementFieldType::PointType pointIn1;
+            field->TransformIndexToPhysicalPoint( It.GetIndex(), pointIn1 );
+
+            typename DisplacementFieldType::PointType pointIn2;
+            for( unsigned int d = 0; d < ImageDimension; d++ )
+              {
+              pointIn2[d] = pointIn1[d] + line[i][d];
+              }
+            if( composer->IsInsideBuffer( pointIn2 ) )
+              {
+              const typename InterpolatorType::OutputType displacement = composer->Evaluate( pointIn2 );
+              for( unsigned int d = 0; d < ImageDimension; d++ )
+                {
+                line[i][d] += displacement[d];
+                }
+              }
+            }
+          }
+
+        It.GoToBeginOfLine();
+        for( IndexValueType i = 0; !It.IsAtEndOfLine(); ++It, ++i )
+          {
+          // Convolve with a zero flux Neumann boundary condition, as
+          // VectorNeighborhoodOperatorImageFilter.
+          AccumulateVectorType sum( NumericTraits<AccumulateType>::ZeroValue() );
+          for( IndexValueType k = 0; k < static_cast<IndexValueType>( kernel.size() ); k++ )
+            {
+            const IndexValueType j = std::min( std::max( i + k - radius, IndexValueType( 0 ) ), lineLength - 1 );
+            for( unsigned int d = 0; d < ImageDimension; d++ )
+              {
+              sum[d] += kernel[k] * line[j][d];
+              }
+            }
+
+          DisplacementVectorType smoothed;
+          for( unsigned int d = 0; d < ImageDimension; d++ )
+            {
+            smoothed[d] = static_cast<RealType>( sum[d] );
+            }
+
+          if( isLastSmoothingPass )
+            {
+            // Make sure the boundary does not move.
+            const typename DisplacementFieldType::IndexType index = It.GetIndex();
+            bool isOnBoundary = false;
+            for( unsigned int d = 0; d < ImageDimension; d++ )
+              {
+              if( index[d] == startIndex[d] || index[d] == static_cast<IndexValueType>( size[d] ) - startIndex[d] - 1 )
+                {
+                isOnBoundary = true;
+                break;
+                }
+              }
+            if( isOnBoundary )
+              {
+              smoothed = zeroVector;
+              }
+            else if( unsmoothedField != nullptr )
+              {
+              smoothed = smoothed * weight1 + unsmoothedField->GetPixel( index ) * weight2;
+              }
+            }
+          It.Set( smoothed );
+          }
+        }
+      }, nullptr );
+    }
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+void
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::InvertDisplacementFieldInPlace( const DisplacementFieldType * field, DisplacementFieldType * inverseField )
+{
+  using AccumulateType = typename NumericTraits<RealType>::AccumulateType;
+  using RegionType = typename DisplacementFieldType::RegionType;
+  using InterpolatorType = VectorLinearInterpolateImageFunction<DisplacementFieldType, RealType>;
+
+  // The same parameters as InvertDisplacementField.
+  const unsigned int maximumNumberOfIterations = 20;
+  const RealType meanErrorToleranceThreshold = 0.001;
+  const RealType maxErrorToleranceThreshold = 0.1;
+
+  typename InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetInputImage( field );
+
+  const RegionType region = inverseField->GetLargestPossibleRegion();
+  const typename DisplacementFieldType::SizeType size = region.GetSize();
+  const typename DisplacementFieldType::IndexType startIndex = region.GetIndex();
+  const DisplacementVectorType zeroVector( 0.0 );
+
+  DisplacementVectorType inverseSpacing;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    inverseSpacing[d] = 1.0 / field->GetSpacing()[d];
+    }
+
+  // The error of the inverse at a pixel, i.e. the negated composition of the
+  // field with the inverse field, and its norm in voxels. It only depends on
+  // the inverse at the same pixel, so the inverse is updated in place.
+  auto computeError = [&]( const typename DisplacementFieldType::IndexType & index,
+    const DisplacementVectorType & inverse, DisplacementVectorType & error ) -> RealType
+    {
+    typename DisplacementFieldType::PointType pointIn1;
+    inverseField->TransformIndexToPhysicalPoint( index, pointIn1 );
+
+    typename DisplacementFieldType::PointType pointIn2;
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      pointIn2[d] = pointIn1[d] + inverse[d];
+      }
+
+    typename InterpolatorType::OutputType displacement( 0.0 );
+    if( interpolator->IsInsideBuffer( pointIn2 ) )
+      {
+      displacement = interpolator->Evaluate( pointIn2 );
+      }
+
+    RealType scaledNorm = 0.0;
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      error[d] = -( ( pointIn2[d] + displacement[d] ) - pointIn1[d] );
+      scaledNorm += itk::Math::sqr( error[d] * inverseSpacing[d] );
+      }
+    return std::sqrt( scaledNorm );
+    };
+
+  RealType maxErrorNorm = NumericTraits<RealType>::max();
+  RealType meanErrorNorm = NumericTraits<RealType>::max();
+  unsigned int iteration = 0;
+
+  SimpleFastMutexLock mutex;
+
+  while( iteration++ < maximumNumberOfIterations &&
+    maxErrorNorm > maxErrorToleranceThreshold && meanErrorNorm > meanErrorToleranceThreshold )
+    {
+    AccumulateType errorNormSum = NumericTraits<AccumulateType>::ZeroValue();
+    maxErrorNorm = NumericTraits<RealType>::ZeroValue();
+
+    this->GetMultiThreader()->template ParallelizeImageRegion<ImageDimension>( region,
+      [&]( const RegionType & regionForThread )
+      {
+      AccumulateType localSum = NumericTraits<AccumulateType>::ZeroValue();
+      RealType localMax = NumericTraits<RealType>::ZeroValue();
+
+      DisplacementVectorType error;
+      ImageRegionConstIteratorWithIndex<DisplacementFieldType> ItI( inverseField, regionForThread );
+      for( ItI.GoToBegin(); !ItI.IsAtEnd(); ++ItI )
+        {
+        const RealType scaledNorm = computeError( ItI.GetIndex(), ItI.Get(), error );
+        localSum += scaledNorm;
+        if( localMax < scaledNorm )
+          {
+          localMax = scaledNorm;
+          }
+        }
+
+      MutexLockHolder<SimpleFastMutexLock> holder( mutex );
+      errorNormSum += localSum;
+      if( maxErrorNorm < localMax )
+        {
+        maxErrorNorm = localMax;
+        }
+      }, nullptr );
+
+    meanErrorNorm = static_cast<RealType>( errorNormSum / static_cast<AccumulateType>( region.GetNumberOfPixels() ) );
+
+    const RealType epsilon = ( iteration == 1 ) ? 0.75 : 0.5;
+
+    this->GetMultiThreader()->template ParallelizeImageRegion<ImageDimension>( region,
+      [&]( const RegionType & regionForThread )
+      {
+      DisplacementVectorType update;
+      ImageRegionIteratorWithIndex<DisplacementFieldType> ItI( inverseField, regionForThread );
+      for( ItI.GoToBegin(); !ItI.IsAtEnd(); ++ItI )
+        {
+        const typename DisplacementFieldType::IndexType index = ItI.GetIndex();
+
+        bool isOnBoundary = false;
+        for( unsigned int d = 0; d < ImageDimension; d++ )
+          {
+          if( index[d] == startIndex[d] || index[d] == static_cast<IndexValueType>( size[d] ) - startIndex[d] - 1 )
+            {
+            isOnBoundary = true;
+            break;
+            }
+          }
+        if( isOnBoundary )
+          {
+          ItI.Set( zeroVector );
+          continue;
+          }
+
+        const RealType scaledNorm = computeError( index, ItI.Get(), update );
+        if( scaledNorm > epsilon * maxErrorNorm )
+          {
+          update *= ( epsilon * maxErrorNorm / scaledNorm );
+          }
+        ItI.Set( ItI.Get() + update * epsilon );
+        }
+      }, nullptr );
+    }
+}
+
 /*
  * Start the registration
  */
@@ -768,6 +1264,11 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
   this->m_OutputTransform->SetDisplacementField( composer->GetOutput() );
   this->m_OutputTransform->SetInverseDisplacementField( inverseComposer->GetOutput() );
 
+  this->m_FixedToMiddleUpdateField = nullptr;
+  this->m_MovingToMiddleUpdateField = nullptr;
+  this->m_LeanSmoothingField = nullptr;
+  this->m_IdentityDisplacementFieldTransform = nullptr;
+
   this->GetTransformOutput()->Set(this->m_OutputTransform);
 }
 
@@ -787,6 +1288,7 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
   os << indent << "Convergence window size: " << this->m_ConvergenceWindowSize << std::endl;
   os << indent << "Gaussian smoothing variance for the update field: " << this->m_GaussianSmoothingVarianceForTheUpdateField << std::endl;
   os << indent << "Gaussian smoothing variance for the total field: " << this->m_GaussianSmoothingVarianceForTheTotalField << std::endl;
+  os << indent << "Use lean memory: " << ( this->m_UseLeanMemory ? "On" : "Off" ) << std::endl;
 }
 
 } // end namespace itk
@@ -0,0 +1,231 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageRegistrationMethodv4.h"
+#include "itkAdaptiveStochasticGradientDescentOptimizerv4.h"
+#include "itkImageMaskSpatialObject.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkRegistrationParameterScalesFromPhysicalShift.h"
+#include "itkTestingMacros.h"
+#include "itkTranslationTransform.h"
+
+/*
+ * Register a translation with a new set of samples drawn at each iteration
+ * of an adaptive stochastic gradient descent, with different numbers of
+ * threads, and check the samples.
+ */
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+using ImageType = itk::Image< double, Dimension >;
+using TransformType = itk::TranslationTransform< double, Dimension >;
+using RegistrationType = itk::ImageRegistrationMethodv4< ImageType, ImageType, TransformType >;
+using MetricType = itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType >;
+using OptimizerType = itk::AdaptiveStochasticGradientDescentOptimizerv4;
+using MaskType = itk::ImageMaskSpatialObject< Dimension >;
+
+ImageType::Pointer CreateImage( double shiftX, double shiftY )
+{
+  ImageType::SizeType size = {{ 64, 64 }};
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  for( itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetBufferedRegion() ); !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 36.0 - shiftX;
+    const double y = it.GetIndex()[1] - 30.0 - shiftY;
+    it.Set( 100.0 * std::exp( -( x * x + 2.0 * y * y ) / 120.0 )
+            + 50.0 * std::exp( -( ( x + 12.0 ) * ( x + 12.0 ) + ( y - 10.0 ) * ( y - 10.0 ) ) / 40.0 ) );
+    }
+  return image;
+}
+
+// The mask excludes the voxels with x < 12.
+MaskType::Pointer CreateMask( const ImageType * image )
+{
+  using MaskImageType = MaskType::ImageType;
+  MaskImageType::Pointer maskImage = MaskImageType::New();
+  maskImage->CopyInformation( image );
+  maskImage->SetRegions( image->GetBufferedRegion() );
+  maskImage->Allocate();
+  for( itk::ImageRegionIteratorWithIndex< MaskImageType > it( maskImage, maskImage->GetBufferedRegion() ); !it.IsAtEnd(); ++it )
+    {
+    it.Set( it.GetIndex()[0] < 12 ? 0 : 1 );
+    }
+  MaskType::Pointer mask = MaskType::New();
+  mask->SetImage( maskImage );
+  return mask;
+}
+
+// Check the samples at each iteration.
+class SamplesObserver : public itk::Command
+{
+public:
+  using Self = SamplesObserver;
+  using Superclass = itk::Command;
+  using Pointer = itk::SmartPointer< Self >;
+  itkNewMacro( Self );
+
+  void Execute( itk::Object *caller, const itk::EventObject & event ) override
+    {
+    Execute( (const itk::Object *)caller, event );
+    }
+
+  void Execute( const itk::Object *, const itk::EventObject & event ) override
+    {
+    if( !itk::IterationEvent().CheckEvent( &event ) )
+      {
+      return;
+      }
+    const MetricType::FixedSampledPointSetType * samples = m_Metric->GetFixedSampledPointSet();
+    if( samples->GetNumberOfPoints() != m_ExpectedNumberOfSamples )
+      {
+      std::cerr << "Unexpected number of samples " << samples->GetNumberOfPoints() << std::endl;
+      m_Passed = false;
+      }
+    for( itk::SizeValueType i = 0; i < samples->GetNumberOfPoints(); ++i )
+      {
+      if( !m_Mask->IsInside( samples->GetPoint( i ) ) )
+        {
+        std::cerr << "The sample " << samples->GetPoint( i ) << " is outside the mask" << std::endl;
+        m_Passed = false;
+        }
+      }
+    if( samples->GetPoints()->CastToSTLConstContainer() != m_PreviousSamples )
+      {
+      ++m_NumberOfNewSamples;
+      }
+    m_PreviousSamples = samples->GetPoints()->CastToSTLConstContainer();
+    }
+
+  const MetricType *                                                     m_Metric{ nullptr };
+  const MaskType *                                                       m_Mask{ nullptr };
+  itk::SizeValueType                                                     m_ExpectedNumberOfSamples{ 0 };
+  itk::SizeValueType                                                     m_NumberOfNewSamples{ 0 };
+  MetricType::FixedSampledPointSetType::PointsContainer::STLContainerType m_PreviousSamples;
+  bool                                                                   m_Passed{ true };
+
+protected:
+  SamplesObserver() = default;
+};
+
+int Register( itk::ThreadIdType numberOfThreads, TransformType::ParametersType & parameters )
+{
+  const ImageType::Pointer fixed = CreateImage( 0.0, 0.0 );
+  const ImageType::Pointer moving = CreateImage( 3.0, -2.0 );
+  const MaskType::Pointer mask = CreateMask( fixed );
+
+  MetricType::Pointer metric = MetricType::New();
+  metric->SetFixedImageMask( mask );
+  // the sums of the metric do not depend on the threads
+  metric->SetMaximumNumberOfThreads( 1 );
+
+  using ScalesEstimatorType = itk::RegistrationParameterScalesFromPhysicalShift< MetricType >;
+  ScalesEstimatorType::Pointer scalesEstimator = ScalesEstimatorType::New();
+  scalesEstimator->SetMetric( metric );
+
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->SetNumberOfIterations( 200 );
+  optimizer->SetScalesEstimator( scalesEstimator );
+
+  RegistrationType::Pointer registration = RegistrationType::New();
+  registration->SetFixedImage( fixed );
+  registration->SetMovingImage( moving );
+  registration->SetMetric( metric );
+  registration->SetOptimizer( optimizer );
+  registration->SetNumberOfLevels( 1 );
+  RegistrationType::ShrinkFactorsArrayType shrinkFactors( 1 );
+  shrinkFactors[0] = 1;
+  registration->SetShrinkFactorsPerLevel( shrinkFactors );
+  RegistrationType::SmoothingSigmasArrayType smoothingSigmas( 1 );
+  smoothingSigmas[0] = 0.0;
+  registration->SetSmoothingSigmasPerLevel( smoothingSigmas );
+  registration->SetMetricSamplingStrategy( RegistrationType::STOCHASTIC );
+  registration->SetMetricSamplingPercentage( 0.05 );
+  registration->MetricSamplingReinitializeSeed( 2018 );
+  registration->SetNumberOfThreads( numberOfThreads );
+
+  SamplesObserver::Pointer observer = SamplesObserver::New();
+  observer->m_Metric = metric;
+  observer->m_Mask = mask;
+  // 5% of the 52 x 64 voxels inside the mask
+  observer->m_ExpectedNumberOfSamples = 166;
+  const unsigned long tag = optimizer->AddObserver( itk::IterationEvent(), observer );
+
+  TRY_EXPECT_NO_EXCEPTION( registration->Update() );
+
+  parameters = registration->GetOutput()->Get()->GetParameters();
+  std::cout << numberOfThreads << " threads: translation " << parameters << ", " << observer->m_NumberOfNewSamples
+            << " sets of samples, time " << optimizer->GetCurrentTime() << ", learning rate "
+            << optimizer->GetCurrentLearningRate() << std::endl;
+  if( !observer->m_Passed )
+    {
+    return EXIT_FAILURE;
+    }
+  if( observer->m_NumberOfNewSamples != optimizer->GetNumberOfIterations() )
+    {
+    std::cerr << "Expected new samples at each iteration" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The registration removed its observer of the optimizer.
+  optimizer->RemoveObserver( tag );
+  if( optimizer->HasObserver( itk::IterationEvent() ) )
+    {
+    std::cerr << "The registration did not remove its observer" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The metric evaluates the last samples as if it was initialized with them.
+  const MetricType::MeasureType value = metric->GetValue();
+  TRY_EXPECT_NO_EXCEPTION( metric->Initialize() );
+  TEST_EXPECT_EQUAL( metric->GetValue(), value );
+
+  return EXIT_SUCCESS;
+}
+}
+
+int itkImageRegistrationStochasticSamplingTest( int, char *[] )
+{
+  TransformType::ParametersType serial;
+  if( Register( 1, serial ) != EXIT_SUCCESS )
+    {
+    return EXIT_FAILURE;
+    }
+  if( std::abs( serial[0] - 3.0 ) > 0.2 || std::abs( serial[1] + 2.0 ) > 0.2 )
+    {
+    std::cerr << "The translation was not recovered" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The samples do not depend on the number of threads.
+  TransformType::ParametersType threaded;
+  if( Register( 4, threaded ) != EXIT_SUCCESS )
+    {
+    return EXIT_FAILURE;
+    }
+  if( threaded != serial )
+    {
+    std::cerr << "The registration depends on the number of threads" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,200 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkDisplacementFieldTransformParametersAdaptor.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkShrinkImageFilter.h"
+#include "itkSyNImageRegistrationMethod.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Register two synthetic images with SyN, with and without the lean memory
+ * mode, and compare the resulting displacement fields and their inverses.
+ * The lean memory mode is also run with single precision fields.
+ */
+
+namespace
+{
+constexpr unsigned int ImageDimension = 2;
+using ImageType = itk::Image<float, ImageDimension>;
+using FieldType = itk::Image<itk::Vector<double, ImageDimension>, ImageDimension>;
+
+ImageType::Pointer CreateImage( double radiusX, double radiusY )
+{
+  ImageType::SizeType size = {{ 64, 56 }};
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  for( itk::ImageRegionIteratorWithIndex<ImageType> It( image, image->GetBufferedRegion() ); !It.IsAtEnd(); ++It )
+    {
+    const double x = ( It.GetIndex()[0] - 31.0 ) / radiusX;
+    const double y = ( It.GetIndex()[1] - 27.0 ) / radiusY;
+    It.Set( static_cast<float>( 100.0 / ( 1.0 + std::exp( 8.0 * ( std::sqrt( x * x + y * y ) - 1.0 ) ) ) ) );
+    }
+  return image;
+}
+
+template<typename TField>
+FieldType::Pointer CastField( const TField * field )
+{
+  FieldType::Pointer output = FieldType::New();
+  output->CopyInformation( field );
+  output->SetRegions( field->GetBufferedRegion() );
+  output->Allocate();
+  itk::ImageRegionConstIterator<TField> ItF( field, field->GetBufferedRegion() );
+  itk::ImageRegionIterator<FieldType> ItO( output, output->GetBufferedRegion() );
+  for( ; !ItF.IsAtEnd(); ++ItF, ++ItO )
+    {
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      ItO.Value()[d] = ItF.Get()[d];
+      }
+    }
+  return output;
+}
+
+template<typename TRealType>
+bool Register( const ImageType * fixedImage, const ImageType * movingImage, bool useLeanMemory,
+               double varianceForTheTotalField, FieldType::Pointer & field, FieldType::Pointer & inverseField )
+{
+  using OutputTransformType = itk::DisplacementFieldTransform<TRealType, ImageDimension>;
+  using RegistrationType = itk::SyNImageRegistrationMethod<ImageType, ImageType, OutputTransformType>;
+  typename RegistrationType::Pointer registration = RegistrationType::New();
+
+  using DisplacementFieldType = typename OutputTransformType::DisplacementFieldType;
+  typename DisplacementFieldType::Pointer displacementField = DisplacementFieldType::New();
+  displacementField->CopyInformation( fixedImage );
+  displacementField->SetRegions( fixedImage->GetBufferedRegion() );
+  displacementField->Allocate();
+  displacementField->FillBuffer( typename DisplacementFieldType::PixelType( 0.0 ) );
+
+  typename OutputTransformType::Pointer outputTransform = OutputTransformType::New();
+  outputTransform->SetDisplacementField( displacementField );
+
+  constexpr unsigned int numberOfLevels = 2;
+  typename RegistrationType::ShrinkFactorsArrayType shrinkFactorsPerLevel( numberOfLevels );
+  shrinkFactorsPerLevel[0] = 2;
+  shrinkFactorsPerLevel[1] = 1;
+  typename RegistrationType::SmoothingSigmasArrayType smoothingSigmasPerLevel( numberOfLevels );
+  smoothingSigmasPerLevel[0] = 1;
+  smoothingSigmasPerLevel[1] = 0;
+  typename RegistrationType::NumberOfIterationsArrayType numberOfIterationsPerLevel( numberOfLevels );
+  numberOfIterationsPerLevel[0] = 10;
+  numberOfIterationsPerLevel[1] = 5;
+
+  using AdaptorType = itk::DisplacementFieldTransformParametersAdaptor<OutputTransformType>;
+  typename RegistrationType::TransformParametersAdaptorsContainerType adaptors;
+  for( unsigned int level = 0; level < numberOfLevels; level++ )
+    {
+    using ShrinkFilterType = itk::ShrinkImageFilter<DisplacementFieldType, DisplacementFieldType>;
+    typename ShrinkFilterType::Pointer shrinkFilter = ShrinkFilterType::New();
+    shrinkFilter->SetShrinkFactors( shrinkFactorsPerLevel[level] );
+    shrinkFilter->SetInput( displacementField );
+    shrinkFilter->Update();
+
+    typename AdaptorType::Pointer adaptor = AdaptorType::New();
+    adaptor->SetRequiredSpacing( shrinkFilter->GetOutput()->GetSpacing() );
+    adaptor->SetRequiredSize( shrinkFilter->GetOutput()->GetBufferedRegion().GetSize() );
+    adaptor->SetRequiredDirection( shrinkFilter->GetOutput()->GetDirection() );
+    adaptor->SetRequiredOrigin( shrinkFilter->GetOutput()->GetOrigin() );
+    adaptor->SetTransform( outputTransform );
+    adaptors.push_back( adaptor );
+    }
+
+  using MetricType = itk::MeanSquaresImageToImageMetricv4<ImageType, ImageType, ImageType, TRealType>;
+  typename MetricType::Pointer metric = MetricType::New();
+
+  registration->SetFixedImage( fixedImage );
+  registration->SetMovingImage( movingImage );
+  registration->SetInitialTransform( outputTransform );
+  registration->InPlaceOn();
+  registration->SetMetric( metric );
+  registration->SetNumberOfLevels( numberOfLevels );
+  registration->SetShrinkFactorsPerLevel( shrinkFactorsPerLevel );
+  registration->SetSmoothingSigmasPerLevel( smoothingSigmasPerLevel );
+  registration->SetNumberOfIterationsPerLevel( numberOfIterationsPerLevel );
+  registration->SetTransformParametersAdaptorsPerLevel( adaptors );
+  registration->SetLearningRate( 0.5 );
+  registration->SetGaussianSmoothingVarianceForTheUpdateField( 3.0 );
+  registration->SetGaussianSmoothingVarianceForTheTotalField( varianceForTheTotalField );
+  registration->SetUseLeanMemory( useLeanMemory );
+
+  TRY_EXPECT_NO_EXCEPTION( registration->Update() );
+
+  field = CastField( outputTransform->GetDisplacementField() );
+  inverseField = CastField( outputTransform->GetInverseDisplacementField() );
+  return true;
+}
+
+bool Compare( const char * name, const FieldType * field, const FieldType * referenceField, double tolerance )
+{
+  double maximumDisplacement = 0.0;
+  double maximumError = 0.0;
+  itk::ImageRegionConstIterator<FieldType> ItF( field, field->GetBufferedRegion() );
+  itk::ImageRegionConstIterator<FieldType> ItR( referenceField, referenceField->GetBufferedRegion() );
+  for( ; !ItF.IsAtEnd(); ++ItF, ++ItR )
+    {
+    maximumDisplacement = std::max( maximumDisplacement, ItR.Get().GetNorm() );
+    maximumError = std::max( maximumError, ( ItF.Get() - ItR.Get() ).GetNorm() );
+    }
+  std::cout << name << ": maximum displacement " << maximumDisplacement << ", maximum difference " << maximumError
+            << std::endl;
+  if( maximumDisplacement < 0.5 || maximumError > tolerance * maximumDisplacement )
+    {
+    std::cerr << name << ": the fields differ" << std::endl;
+    return false;
+    }
+  return true;
+}
+}
+
+int itkSyNImageRegistrationLeanMemoryTest( int, char * [] )
+{
+  const ImageType::Pointer fixedImage = CreateImage( 14.0, 12.0 );
+  const ImageType::Pointer movingImage = CreateImage( 18.0, 10.0 );
+
+  using RegistrationType = itk::SyNImageRegistrationMethod<ImageType, ImageType>;
+  RegistrationType::Pointer registration = RegistrationType::New();
+  TEST_SET_GET_BOOLEAN( registration, UseLeanMemory, false );
+
+  bool passed = true;
+
+  // The default variance of the total field, and a smaller one, for which the
+  // smoothed total field is blended with the composed field.
+  const double variancesForTheTotalField[2] = { 0.5, 0.25 };
+  for( double varianceForTheTotalField : variancesForTheTotalField )
+    {
+    std::cout << "Variance for the total field " << varianceForTheTotalField << std::endl;
+
+    FieldType::Pointer fields[2];
+    FieldType::Pointer inverseFields[2];
+    Register<double>( fixedImage, movingImage, false, varianceForTheTotalField, fields[0], inverseFields[0] );
+    Register<double>( fixedImage, movingImage, true, varianceForTheTotalField, fields[1], inverseFields[1] );
+    passed = Compare( "Lean memory field", fields[1], fields[0], 1e-6 ) && passed;
+    passed = Compare( "Lean memory inverse field", inverseFields[1], inverseFields[0], 1e-6 ) && passed;
+
+    FieldType::Pointer floatField;
+    FieldType::Pointer floatInverseField;
+    Register<float>( fixedImage, movingImage, true, varianceForTheTotalField, floatField, floatInverseField );
+    passed = Compare( "Single precision lean memory field", floatField, fields[0], 1e-3 ) && passed;
+    passed = Compare( "Single precision lean memory inverse field", floatInverseField, inverseFields[0], 1e-3 ) && passed;
+    }
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,180 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkStreamingConnectedComponentImageFilter_h
+#define itkStreamingConnectedComponentImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkImage.h"
+#include <vector>
+
+namespace itk
+{
+/**
+ * \class StreamingConnectedComponentImageFilter
+ * \brief Label the objects in a binary image, one slab at a time
+ *
+ * StreamingConnectedComponentImageFilter produces the same labels as
+ * ConnectedComponentImageFilter: the labels start with 1, skip the
+ * BackgroundValue, are consecutive, and objects reached earlier by a
+ * raster order scan have a lower label. The input and the output never
+ * have to be in memory as a whole.
+ *
+ * The image is divided in NumberOfStreamDivisions slabs along its last
+ * dimension. In a first pass, the input is streamed slab by slab, each
+ * slab is labeled by a ConnectedComponentImageFilter, and the labels of
+ * the last slice of a slab are linked to the labels of the first slice of
+ * the next one in a union-find structure. Only the labels of one slice
+ * are kept between the slabs, and the union-find structure holds one
+ * entry per component of each slab. The components are then numbered in
+ * the order of the slabs and of their labels in the slab, which is the
+ * raster order of the whole image.
+ *
+ * The first pass is only run again when the input or the parameters are
+ * modified. The output can then be requested by pieces along its last
+ * dimension, for example by an ImageFileWriter or a StreamingImageFilter
+ * with several stream divisions: each piece is produced by labeling again
+ * the slabs it overlaps and replacing their labels.
+ *
+ * After the filter is executed, ObjectCount holds the number of connected
+ * components.
+ *
+ * \sa ConnectedComponentImageFilter
+ *
+ * \ingroup Streamed
+ * \ingroup ITKConnectedComponents
+ */
+template< typename TInputImage, typename TOutputImage, typename TMaskImage = TInputImage >
+class ITK_TEMPLATE_EXPORT StreamingConnectedComponentImageFilter:
+  public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(StreamingConnectedComponentImageFilter);
+
+  /** Standard class type aliases. */
+  using Self = StreamingConnectedComponentImageFilter;
+  using Superclass = ImageToImageFilter< TInputImage, TOutputImage >;
+  using Pointer = SmartPointer< Self >;
+  using ConstPointer = SmartPointer< const Self >;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(StreamingConnectedComponentImageFilter, ImageToImageFilter);
+
+  /** Image type alias support */
+  using InputImageType = TInputImage;
+  using MaskImageType = TMaskImage;
+  using OutputImageType = TOutputImage;
+  using InputPixelType = typename TInputImage::PixelType;
+  using MaskPixelType = typename TMaskImage::PixelType;
+  using OutputPixelType = typename TOutputImage::PixelType;
+  using OutputImagePixelType = typename TOutputImage::PixelType;
+  using RegionType = typename TOutputImage::RegionType;
+  using IndexType = typename TOutputImage::IndexType;
+  using SizeType = typename TOutputImage::SizeType;
+  using OffsetType = typename TOutputImage::OffsetType;
+
+  static constexpr unsigned int ImageDimension = TOutputImage::ImageDimension;
+  static constexpr unsigned int InputImageDimension = TInputImage::ImageDimension;
+
+  /** Type used as identifier of the different component labels. */
+  using LabelType = IdentifierType;
+
+  /** The type of the labels of a slab. */
+  using SlabLabelImageType = Image< LabelType, ImageDimension >;
+
+  /**
+   * Set/Get whether the connected components are defined strictly by
+   * face connectivity or by face+edge+vertex connectivity.  Default is
+   * FullyConnectedOff.
+   */
+  itkSetMacro(FullyConnected, bool);
+  itkGetConstReferenceMacro(FullyConnected, bool);
+  itkBooleanMacro(FullyConnected);
+
+  /**
+   * Set the pixel intensity to be used for background (non-object)
+   * regions of the image in the output. Note that this does NOT set
+   * the background value to be used in the input image.
+   */
+  itkSetMacro(BackgroundValue, OutputImagePixelType);
+  itkGetConstMacro(BackgroundValue, OutputImagePixelType);
+
+  /** Set/Get the number of slabs along the last dimension in which the
+   * input is labeled. The result does not depend on it. Default is 10. */
+  itkSetClampMacro(NumberOfStreamDivisions, unsigned int, 1, NumericTraits< unsigned int >::max());
+  itkGetConstMacro(NumberOfStreamDivisions, unsigned int);
+
+  // only set after completion
+  itkGetConstReferenceMacro(ObjectCount, LabelType);
+
+  itkSetInputMacro(MaskImage, MaskImageType);
+  itkGetInputMacro(MaskImage, MaskImageType);
+
+  // Concept checking -- input and output dimensions must be the same
+  itkConceptMacro( SameDimension,
+                   ( Concept::SameDimension< Self::InputImageDimension,
+                                             Self::ImageDimension > ) );
+  itkConceptMacro( OutputImagePixelTypeIsInteger, ( Concept::IsInteger< OutputImagePixelType > ) );
+
+protected:
+  StreamingConnectedComponentImageFilter();
+  ~StreamingConnectedComponentImageFilter() override {}
+  void PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Only the first slab overlapping the output requested region is
+   * requested from the input; the others are requested during
+   * GenerateData(). */
+  void GenerateInputRequestedRegion() override;
+
+  /** The output requested region is enlarged to whole slices. */
+  void EnlargeOutputRequestedRegion(DataObject *output) override;
+
+  void GenerateData() override;
+
+  /** The slabs of the largest possible region. */
+  std::vector< RegionType > GetSlabs() const;
+
+  /** Update the inputs on a slab and label it. The labels of the
+   * components of the slab start at 1. */
+  typename SlabLabelImageType::Pointer LabelSlab(const RegionType & slab, LabelType & numberOfComponents);
+
+  /** Label the slabs and link their components, to set the output label
+   * of the components of all the slabs. */
+  void ComputeEquivalences(const std::vector< RegionType > & slabs);
+
+private:
+  bool                 m_FullyConnected;
+  OutputImagePixelType m_BackgroundValue;
+  unsigned int         m_NumberOfStreamDivisions;
+  LabelType            m_ObjectCount;
+
+  // the output label of the components of the slabs, and the index of
+  // the first component of each slab in it
+  std::vector< LabelType > m_Labels;
+  std::vector< LabelType > m_FirstComponent;
+  TimeStamp                m_EquivalenceTime;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkStreamingConnectedComponentImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,401 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkStreamingConnectedComponentImageFilter_hxx
+#define itkStreamingConnectedComponentImageFilter_hxx
+
+#include "itkStreamingConnectedComponentImageFilter.h"
+#include "itkConnectedComponentImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageAlgorithm.h"
+
+namespace itk
+{
+template< typename TInputImage, typename TOutputImage, typename TMaskImage >
+StreamingConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
+::StreamingConnectedComponentImageFilter() :
+  m_FullyConnected( false ),
+  m_BackgroundValue( NumericTraits< OutputImagePixelType >::ZeroValue() ),
+  m_NumberOfStreamDivisions( 10 ),
+  m_ObjectCount( 0 )
+{
+  //  #1 "MaskImage" optional
+  Self::AddOptionalInputName("MaskImage",1);
+}
+
+template< typename TInputImage, typename TOutputImage, typename TMaskImage >
+std::vector< typename StreamingConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >::RegionType >
+StreamingConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
+::GetSlabs() const
+{
+  const RegionType     largest = this->GetInput()->GetLargestPossibleRegion();
+  constexpr unsigned int SlabDimension = ImageDimension - 1;
+  const SizeValueType  size = largest.GetSize( SlabDimension );
+  const SizeValueType  numberOfSlabs = std::min( static_cast< SizeValueType >( m_NumberOfStreamDivisions ), size );
+
+  std::vector< RegionType > slabs;
+  for ( SizeValueType i = 0; i < numberOfSlabs; ++i )
+    {
+    const SizeValueType begin = i * size / numberOfSlabs;
+    const SizeValueType end = ( i + 1 ) * size / numberOfSlabs;
+    RegionType          slab = largest;
+    slab.SetIndex( SlabDimension, largest.GetIndex( SlabDimension ) + static_cast< IndexValueType >( begin ) );
+    slab.SetSize( SlabDimension, end - begin );
+    slabs.push_back( slab );
+    }
+  return slabs;
+}
+
+template< typename TInputImage, typename TOutputImage, typename TMaskImage >
+void
+StreamingConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  auto * input = const_cast< InputImageType * >( this->GetInput() );
+  if ( !input )
+    {
+    return;
+    }
+
+  // the first slab which is labeled
+  const std::vector< RegionType > slabs = this->GetSlabs();
+  RegionType                      slab = slabs.front();
+  if ( m_EquivalenceTime.GetMTime() > this->GetMTime() )
+    {
+    const RegionType requested = this->GetOutput()->GetRequestedRegion();
+    for ( const RegionType & candidate : slabs )
+      {
+      RegionType overlap = candidate;
+      if ( overlap.Crop( requested ) )
+        {
+        slab = candidate;
+        break;
+        }
+      }
+    }
+  input->SetRequestedRegion( slab );
+
+  auto * mask = const_cast< MaskImageType * >( this->GetMaskImage() );
+  if ( mask )
+    {
+    mask->SetRequestedRegion( slab );
+    }
+}
+
+template< typename TInputImage, typename TOutputImage, typename TMaskImage >
+void
+StreamingConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
+::EnlargeOutputRequestedRegion(DataObject *output)
+{
+  Superclass::EnlargeOutputRequestedRegion(output);
+
+  // whole slices, but any number of them
+  OutputImageType * image = this->GetOutput();
+  const RegionType  largest = image->GetLargestPossibleRegion();
+  RegionType        requested = image->GetRequestedRegion();
+  for ( unsigned int d = 0; d + 1 < ImageDimension; ++d )
+    {
+    requested.SetIndex( d, largest.GetIndex( d ) );
+    requested.SetSize( d, largest.GetSize( d ) );
+    }
+  image->SetRequestedRegion( requested );
+}
+
+template< typename TInputImage, typename TOutputImage, typename TMaskImage >
+typename StreamingConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >::SlabLabelImageType::Pointer
+StreamingConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
+::LabelSlab(const RegionType & slab, LabelType & numberOfComponents)
+{
+  // update the inputs on the slab
+  auto * input = const_cast< InputImageType * >( this->GetInput() );
+  input->SetRequestedRegion( slab );
+  input->PropagateRequestedRegion();
+  input->UpdateOutputData();
+
+  auto * mask = const_cast< MaskImageType * >( this->GetMaskImage() );
+  if ( mask )
+    {
+    mask->SetRequestedRegion( slab );
+    mask->PropagateRequestedRegion();
+    mask->UpdateOutputData();
+    }
+
+  // the slab is copied in an image of its own, because the input may be
+  // buffered on a larger region, and ConnectedComponentImageFilter labels
+  // the largest possible region
+  typename InputImageType::Pointer slabInput = InputImageType::New();
+  slabInput->CopyInformation( input );
+  slabInput->SetRegions( slab );
+  slabInput->Allocate();
+  ImageAlgorithm::Copy( input, slabInput.GetPointer(), slab, slab );
+
+  using LabelFilterType = ConnectedComponentImageFilter< InputImageType, SlabLabelImageType, MaskImageType >;
+  typename LabelFilterType::Pointer labelFilter = LabelFilterType::New();
+  labelFilter->SetInput( slabInput );
+  labelFilter->SetFullyConnected( m_FullyConnected );
+  labelFilter->SetBackgroundValue( 0 );
+  labelFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  typename MaskImageType::Pointer slabMask;
+  if ( mask )
+    {
+    slabMask = MaskImageType::New();
+    slabMask->CopyInformation( mask );
+    slabMask->SetRegions( slab );
+    slabMask->Allocate();
+    ImageAlgorithm::Copy( mask, slabMask.GetPointer(), slab, slab );
+    labelFilter->SetMaskImage( slabMask );
+    }
+
+  labelFilter->Update();
+  numberOfComponents = labelFilter->GetObjectCount();
+  return labelFilter->GetOutput();
+}
+
+template< typename TInputImage, typename TOutputImage, typename TMaskImage >
+void
+StreamingConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
+::ComputeEquivalences(const std::vector< RegionType > & slabs)
+{
+  constexpr unsigned int SlabDimension = ImageDimension - 1;
+
+  // the neighbors in the previous slice of a pixel
+  std::vector< OffsetType > offsets;
+  OffsetType                offset;
+  offset.Fill( 0 );
+  if ( m_FullyConnected )
+    {
+    for ( unsigned int d = 0; d < SlabDimension; ++d )
+      {
+      offset[d] = -1;
+      }
+    bool done = false;
+    while ( !done )
+      {
+      offsets.push_back( offset );
+      done = true;
+      for ( unsigned int d = 0; d < SlabDimension && done; ++d )
+        {
+        if ( offset[d] < 1 )
+          {
+          ++offset[d];
+          done = false;
+          }
+        else
+          {
+          offset[d] = -1;
+          }
+        }
+      }
+    }
+  else
+    {
+    offsets.push_back( offset );
+    }
+
+  // the union-find structure of the components of all the slabs. The
+  // root of a set is its smallest component.
+  std::vector< LabelType > parents( 1, 0 );
+  auto lookup = [&parents]( LabelType label )
+    {
+    while ( parents[label] != label )
+      {
+      parents[label] = parents[parents[label]];
+      label = parents[label];
+      }
+    return label;
+    };
+
+  m_FirstComponent.assign( 1, 1 );
+  std::vector< LabelType > previousSlice;
+  RegionType               previousSliceRegion;
+  for ( unsigned int i = 0; i < slabs.size(); ++i )
+    {
+    const RegionType & slab = slabs[i];
+    LabelType          numberOfComponents = 0;
+    typename SlabLabelImageType::Pointer labels = this->LabelSlab( slab, numberOfComponents );
+
+    const LabelType first = m_FirstComponent.back();
+    for ( LabelType label = 0; label < numberOfComponents; ++label )
+      {
+      parents.push_back( first + label );
+      }
+    m_FirstComponent.push_back( first + numberOfComponents );
+
+    // link the components of the first slice to the ones of the last slice
+    // of the previous slab
+    if ( i > 0 )
+      {
+      RegionType sliceRegion = slab;
+      sliceRegion.SetSize( SlabDimension, 1 );
+      ImageRegionConstIteratorWithIndex< SlabLabelImageType > it( labels, sliceRegion );
+      for ( ; !it.IsAtEnd(); ++it )
+        {
+        if ( it.Get() == 0 )
+          {
+          continue;
+          }
+        const IndexType index = it.GetIndex();
+        for ( const OffsetType & sliceOffset : offsets )
+          {
+          IndexType neighbor = index + sliceOffset;
+          neighbor[SlabDimension] = previousSliceRegion.GetIndex( SlabDimension );
+          if ( !previousSliceRegion.IsInside( neighbor ) )
+            {
+            continue;
+            }
+          SizeValueType position = 0;
+          SizeValueType stride = 1;
+          for ( unsigned int d = 0; d < SlabDimension; ++d )
+            {
+            position += ( neighbor[d] - previousSliceRegion.GetIndex( d ) ) * stride;
+            stride *= previousSliceRegion.GetSize( d );
+            }
+          if ( previousSlice[position] == 0 )
+            {
+            continue;
+            }
+          const LabelType root1 = lookup( previousSlice[position] );
+          const LabelType root2 = lookup( first + it.Get() - 1 );
+          if ( root1 < root2 )
+            {
+            parents[root2] = root1;
+            }
+          else if ( root2 < root1 )
+            {
+            parents[root1] = root2;
+            }
+          }
+        }
+      }
+
+    // keep the components of the last slice
+    previousSliceRegion = slab;
+    previousSliceRegion.SetIndex( SlabDimension, slab.GetIndex( SlabDimension ) + slab.GetSize( SlabDimension ) - 1 );
+    previousSliceRegion.SetSize( SlabDimension, 1 );
+    previousSlice.assign( previousSliceRegion.GetNumberOfPixels(), 0 );
+    ImageRegionConstIterator< SlabLabelImageType > it( labels, previousSliceRegion );
+    for ( auto previous = previousSlice.begin(); !it.IsAtEnd(); ++it, ++previous )
+      {
+      if ( it.Get() != 0 )
+        {
+        *previous = first + it.Get() - 1;
+        }
+      }
+
+    this->UpdateProgress( 0.5f * ( i + 1 ) / slabs.size() );
+    }
+
+  // consecutive labels in the order of the roots, as in
+  // ConnectedComponentImageFilter
+  m_Labels.assign( parents.size(), 0 );
+  LabelType label = 0;
+  m_ObjectCount = 0;
+  for ( LabelType component = 1; component < parents.size(); ++component )
+    {
+    const LabelType root = lookup( component );
+    if ( root == component )
+      {
+      if ( label == static_cast< LabelType >( m_BackgroundValue ) )
+        {
+        ++label;
+        }
+      m_Labels[component] = label;
+      ++label;
+      ++m_ObjectCount;
+      }
+    else
+      {
+      m_Labels[component] = m_Labels[root];
+      }
+    }
+
+  if ( m_ObjectCount > static_cast< SizeValueType >( NumericTraits< OutputPixelType >::max() ) )
+    {
+    itkExceptionMacro( << "Number of objects greater than maximum of output pixel type " );
+    }
+  m_EquivalenceTime.Modified();
+}
+
+template< typename TInputImage, typename TOutputImage, typename TMaskImage >
+void
+StreamingConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
+::GenerateData()
+{
+  const std::vector< RegionType > slabs = this->GetSlabs();
+
+  // the first pass, when the input or the parameters are modified
+  const InputImageType * input = this->GetInput();
+  const MaskImageType *  mask = this->GetMaskImage();
+  ModifiedTimeType       time = std::max( this->GetMTime(), input->GetPipelineMTime() );
+  if ( mask )
+    {
+    time = std::max( time, mask->GetPipelineMTime() );
+    }
+  const bool computed = m_EquivalenceTime.GetMTime() > time && m_FirstComponent.size() == slabs.size() + 1;
+  if ( !computed )
+    {
+    this->ComputeEquivalences( slabs );
+    }
+
+  // the second pass, on the slabs overlapping the requested region
+  this->AllocateOutputs();
+  OutputImageType * output = this->GetOutput();
+  const RegionType  requested = output->GetRequestedRegion();
+  const float       progressStart = computed ? 0.0f : 0.5f;
+  for ( unsigned int i = 0; i < slabs.size(); ++i )
+    {
+    RegionType overlap = slabs[i];
+    if ( !overlap.Crop( requested ) )
+      {
+      continue;
+      }
+    LabelType numberOfComponents = 0;
+    typename SlabLabelImageType::Pointer labels = this->LabelSlab( slabs[i], numberOfComponents );
+
+    const LabelType                               first = m_FirstComponent[i] - 1;
+    ImageRegionConstIterator< SlabLabelImageType > it( labels, overlap );
+    ImageRegionIterator< OutputImageType >         oit( output, overlap );
+    for ( ; !it.IsAtEnd(); ++it, ++oit )
+      {
+      const LabelType label = it.Get();
+      oit.Set( label == 0 ? m_BackgroundValue : static_cast< OutputPixelType >( m_Labels[first + label] ) );
+      }
+
+    this->UpdateProgress( progressStart + ( 1.0f - progressStart ) * ( i + 1 ) / slabs.size() );
+    }
+}
+
+template< typename TInputImage, typename TOutputImage, typename TMaskImage >
+void
+StreamingConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
+  os << indent << "ObjectCount: "  << m_ObjectCount << std::endl;
+  os << indent << "BackgroundValue: "
+     << static_cast< typename NumericTraits< OutputImagePixelType >::PrintType >( m_BackgroundValue ) << std::endl;
+  os << indent << "NumberOfStreamDivisions: " << m_NumberOfStreamDivisions << std::endl;
+}
+} // end namespace itk
+
+#endif
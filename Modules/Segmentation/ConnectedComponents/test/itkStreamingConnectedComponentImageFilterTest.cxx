@@ -0,0 +1,167 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkStreamingConnectedComponentImageFilter.h"
+#include "itkConnectedComponentImageFilter.h"
+#include "itkCastImageFilter.h"
+#include "itkStreamingImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+template< typename TImage >
+bool SameLabels( const TImage * expected, const TImage * labels, const char * name )
+{
+  itk::ImageRegionConstIterator< TImage > it1( expected, expected->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage > it2( labels, expected->GetLargestPossibleRegion() );
+  unsigned int differences = 0;
+  for( ; !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    differences += ( it1.Get() != it2.Get() );
+    }
+  std::cout << name << ": " << differences << " differences" << std::endl;
+  return differences == 0;
+}
+}
+
+// Compare the streamed labels with the labels of the in-memory filter.
+template< unsigned int VDimension >
+int StreamingConnectedComponent( const typename itk::Image< unsigned char, VDimension >::SizeType & size,
+                                 double fraction )
+{
+  using ImageType = itk::Image< unsigned char, VDimension >;
+  using LabelImageType = itk::Image< unsigned short, VDimension >;
+
+  // noise, close to the percolation threshold to get many components
+  // crossing the slabs, and a mask
+  typename ImageType::Pointer input = ImageType::New();
+  input->SetRegions( size );
+  input->Allocate();
+  typename ImageType::Pointer mask = ImageType::New();
+  mask->SetRegions( size );
+  mask->Allocate();
+  using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+  itk::ImageRegionIterator< ImageType > iIt( input, input->GetBufferedRegion() );
+  itk::ImageRegionIterator< ImageType > mIt( mask, mask->GetBufferedRegion() );
+  for( ; !iIt.IsAtEnd(); ++iIt, ++mIt )
+    {
+    iIt.Set( generator->GetVariate() < fraction ? 255 : 0 );
+    mIt.Set( generator->GetVariate() < 0.9 ? 1 : 0 );
+    }
+
+  // cast filters, to check that the inputs are streamed
+  using CastType = itk::CastImageFilter< ImageType, ImageType >;
+  typename CastType::Pointer cast = CastType::New();
+  cast->SetInput( input );
+  cast->InPlaceOff();
+  typename CastType::Pointer maskCast = CastType::New();
+  maskCast->SetInput( mask );
+  maskCast->InPlaceOff();
+
+  using ReferenceType = itk::ConnectedComponentImageFilter< ImageType, LabelImageType >;
+  typename ReferenceType::Pointer reference = ReferenceType::New();
+  reference->SetInput( input );
+
+  using FilterType = itk::StreamingConnectedComponentImageFilter< ImageType, LabelImageType >;
+  typename FilterType::Pointer filter = FilterType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( filter, StreamingConnectedComponentImageFilter, ImageToImageFilter );
+  TEST_SET_GET_BOOLEAN( filter, FullyConnected, false );
+  filter->SetNumberOfStreamDivisions( 0 );
+  TEST_SET_GET_VALUE( 1u, filter->GetNumberOfStreamDivisions() );
+  filter->SetBackgroundValue( 3 );
+  TEST_SET_GET_VALUE( 3, filter->GetBackgroundValue() );
+  filter->SetInput( cast->GetOutput() );
+
+  using StreamerType = itk::StreamingImageFilter< LabelImageType, LabelImageType >;
+  typename StreamerType::Pointer streamer = StreamerType::New();
+  streamer->SetInput( filter->GetOutput() );
+
+  const char * names[] = { "face connected", "fully connected", "masked", "background 3" };
+  bool passed = true;
+  for( unsigned int test = 0; test < 4; test++ )
+    {
+    reference->SetFullyConnected( test == 1 );
+    filter->SetFullyConnected( test == 1 );
+    reference->SetMaskImage( test == 2 ? mask.GetPointer() : nullptr );
+    filter->SetMaskImage( test == 2 ? maskCast->GetOutput() : nullptr );
+    reference->SetBackgroundValue( test == 3 ? 3 : 0 );
+    filter->SetBackgroundValue( test == 3 ? 3 : 0 );
+    TRY_EXPECT_NO_EXCEPTION( reference->Update() );
+
+    for( unsigned int divisions = 1; divisions < 12; divisions += 5 )
+      {
+      filter->SetNumberOfStreamDivisions( divisions );
+      cast->Modified();
+      maskCast->Modified();
+
+      // the whole output at once
+      TRY_EXPECT_NO_EXCEPTION( filter->UpdateLargestPossibleRegion() );
+      TEST_EXPECT_EQUAL( filter->GetObjectCount(), reference->GetObjectCount() );
+      std::cout << divisions << " divisions, ";
+      passed &= SameLabels( reference->GetOutput(), filter->GetOutput(), names[test] );
+      if( divisions > 1 )
+        {
+        // only the last slab remains
+        TEST_EXPECT_TRUE( cast->GetOutput()->GetBufferedRegion().GetNumberOfPixels()
+                          < input->GetBufferedRegion().GetNumberOfPixels() );
+        }
+
+      // the output by pieces which are not aligned with the slabs
+      streamer->SetNumberOfStreamDivisions( 4 );
+      TRY_EXPECT_NO_EXCEPTION( streamer->Update() );
+      std::cout << divisions << " divisions, 4 pieces, ";
+      passed &= SameLabels( reference->GetOutput(), streamer->GetOutput(), names[test] );
+      streamer->Modified();
+      }
+    }
+  std::cout << "Object count: " << filter->GetObjectCount() << std::endl;
+
+  // too many objects for the output pixel type
+  using SmallLabelImageType = itk::Image< unsigned char, VDimension >;
+  using SmallFilterType = itk::StreamingConnectedComponentImageFilter< ImageType, SmallLabelImageType >;
+  typename SmallFilterType::Pointer smallFilter = SmallFilterType::New();
+  smallFilter->SetInput( input );
+  smallFilter->SetNumberOfStreamDivisions( 3 );
+  if( reference->GetObjectCount() > 255 )
+    {
+    TRY_EXPECT_EXCEPTION( smallFilter->Update() );
+    }
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int itkStreamingConnectedComponentImageFilterTest( int, char * [] )
+{
+  itk::Size< 2 > size2D = {{ 157, 133 }};
+  if( StreamingConnectedComponent< 2 >( size2D, 0.55 ) == EXIT_FAILURE )
+    {
+    std::cerr << "2D Fails" << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::Size< 3 > size3D = {{ 41, 37, 29 }};
+  if( StreamingConnectedComponent< 3 >( size3D, 0.28 ) == EXIT_FAILURE )
+    {
+    std::cerr << "3D Fails" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
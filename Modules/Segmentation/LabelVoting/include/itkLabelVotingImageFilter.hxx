@@ -22,6 +22,8 @@
 
 #include "itkImageRegionIterator.h"
 #include "itkProgressReporter.h"
+#include "itkMutexLockHolder.h"
+#include "itkSimpleFastMutexLock.h"
 
 #include "itkMath.h"
 
@@ -48,14 +50,26 @@ LabelVotingImageFilter< TInputImage, TOutputImage >
   // Record the number of indexed inputs
   const size_t numberOfInputIndexes = this->GetNumberOfIndexedInputs();
 
+  SimpleFastMutexLock mutex;
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
   for ( size_t i = 0; i < numberOfInputIndexes; ++i )
     {
     const InputImageType *inputImage =  this->GetInput(i);
-    IteratorType          it( inputImage, inputImage->GetBufferedRegion() );
-    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
-      {
-      maxLabel = std::max( maxLabel, it.Get() );
-      }
+    multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+    multiThreader->template ParallelizeImageRegion< InputImageDimension >(
+      inputImage->GetBufferedRegion(),
+      [&](const typename InputImageType::RegionType & region)
+        {
+        InputPixelType localMaxLabel = 0;
+        IteratorType   it( inputImage, region );
+        for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+          {
+          localMaxLabel = std::max( localMaxLabel, it.Get() );
+          }
+        MutexLockHolder< SimpleFastMutexLock > mutexHolder( mutex );
+        maxLabel = std::max( maxLabel, localMaxLabel );
+        },
+      nullptr);
     }
 
   return maxLabel;
@@ -101,54 +115,65 @@ LabelVotingImageFilter< TInputImage, TOutputImage >
   const size_t numberOfInputIndexes = this->GetNumberOfIndexedInputs();
 
   // Create and initialize all input image iterators
-  auto * it = new IteratorType[numberOfInputIndexes];
+  std::vector< IteratorType > it;
   for ( size_t i = 0; i < numberOfInputIndexes; ++i )
     {
-    it[i] = IteratorType(this->GetInput(i),
-                         outputRegionForThread);
+    it.push_back( IteratorType(this->GetInput(i),
+                               outputRegionForThread) );
     }
 
-  auto * votesByLabel = new unsigned int[this->m_TotalLabelCount];
+  // the votes are only read and reset for the labels of the inputs, so
+  // that the work per pixel does not depend on the number of labels
+  std::vector< unsigned int >   votesByLabel( this->m_TotalLabelCount, 0 );
+  std::vector< InputPixelType > labels( numberOfInputIndexes );
 
   OutIteratorType out = OutIteratorType(output, outputRegionForThread);
   for ( out.GoToBegin(); !out.IsAtEnd(); ++out )
     {
-    // Reset number of votes per label for all labels
-    std::fill_n( votesByLabel, this->m_TotalLabelCount, 0 );
-
     // count number of votes for the labels
     for ( unsigned int i = 0; i < numberOfInputIndexes; ++i )
       {
-      const InputPixelType label = it[i].Get();
-      if ( NumericTraits<InputPixelType>::IsNonnegative( label ) )
+      labels[i] = it[i].Get();
+      if ( NumericTraits<InputPixelType>::IsNonnegative( labels[i] ) )
         {
-        ++votesByLabel[label];
+        ++votesByLabel[labels[i]];
         }
       ++( it[i] );
       }
 
-    // Determine the label with the most votes for this pixel
-    out.Set(0);
-    unsigned int maxVotes = votesByLabel[0];
-    for ( size_t l = 1; l < this->m_TotalLabelCount; ++l )
+    // Determine the label with the most votes for this pixel, which must
+    // be unique
+    unsigned int   maxVotes = 0;
+    InputPixelType winningLabel = 0;
+    bool           isUndecided = ( this->m_TotalLabelCount > 1 );
+    for ( unsigned int i = 0; i < numberOfInputIndexes; ++i )
       {
-      if ( votesByLabel[l] > maxVotes )
-        {
-        maxVotes = votesByLabel[l];
-        out.Set(static_cast<OutputPixelType>(l));
-        }
-      else
+      if ( NumericTraits<InputPixelType>::IsNonnegative( labels[i] ) )
         {
-        if ( votesByLabel[l] == maxVotes )
+        const unsigned int votes = votesByLabel[labels[i]];
+        if ( votes > maxVotes )
           {
-          out.Set(this->m_LabelForUndecidedPixels);
+          maxVotes = votes;
+          winningLabel = labels[i];
+          isUndecided = false;
+          }
+        else if ( votes == maxVotes && labels[i] != winningLabel )
+          {
+          isUndecided = true;
           }
         }
       }
-    }
+    out.Set( isUndecided ? this->m_LabelForUndecidedPixels : static_cast<OutputPixelType>( winningLabel ) );
 
-  delete[] it;
-  delete[] votesByLabel;
+    // Reset number of votes per label for the labels of this pixel
+    for ( unsigned int i = 0; i < numberOfInputIndexes; ++i )
+      {
+      if ( NumericTraits<InputPixelType>::IsNonnegative( labels[i] ) )
+        {
+        votesByLabel[labels[i]] = 0;
+        }
+      }
+    }
 }
 
 template< typename TInputImage, typename TOutputImage >
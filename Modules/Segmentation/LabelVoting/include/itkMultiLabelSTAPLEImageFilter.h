@@ -28,6 +28,7 @@
 #include "itkArray.h"
 #include "itkArray2D.h"
 #include "itkNumericTraits.h"
+#include "itkSimpleFastMutexLock.h"
 
 namespace itk
 {
@@ -103,6 +104,16 @@ namespace itk
  * after a smaller number of iterations if the termination threshold criterion
  * is satisfied.
  *
+ * The pixels where all the input segmentations have the same label are
+ * processed together: the E-step is computed once for each label, and its
+ * result is weighted by the number of these pixels. If
+ * ExcludeConsensusPixels is on, these pixels are instead assigned their
+ * common label in the output, and take no part in the estimation of the
+ * prior probabilities and of the confusion matrices, which are estimated
+ * from the pixels where the segmentations disagree only. The other pixels
+ * are processed in parallel, each thread accumulating its part of the
+ * updated confusion matrices.
+ *
  * \par EVENTS
  * This filter invokes IterationEvent() at each iteration of the E-M
  * algorithm. Setting the AbortGenerateData() flag will cause the algorithm to
@@ -159,6 +170,7 @@ public:
   using WeightsType = TWeights;
   using ConfusionMatrixType = Array2D<WeightsType>;
   using PriorProbabilitiesType = Array<WeightsType>;
+  using WeightsRealType = typename NumericTraits< WeightsType >::RealType;
 
   /** Get the number of elapsed iterations of the iterative E-M algorithm. */
   itkGetConstMacro(ElapsedNumberOfIterations, unsigned int);
@@ -192,6 +204,14 @@ public:
   itkSetMacro(TerminationUpdateThreshold, TWeights);
   itkGetConstMacro(TerminationUpdateThreshold, TWeights);
 
+  /** Set/Get whether the pixels where all the inputs have the same label
+   * are assigned this label without taking part in the estimation of the
+   * performance parameters. Default is off.
+   */
+  itkSetMacro(ExcludeConsensusPixels, bool);
+  itkGetConstMacro(ExcludeConsensusPixels, bool);
+  itkBooleanMacro(ExcludeConsensusPixels);
+
   /** Set label value for undecided pixels.
     */
   void SetLabelForUndecidedPixels( const OutputPixelType l )
@@ -276,7 +296,8 @@ protected:
     m_HasMaximumNumberOfIterations(false),
     m_MaximumNumberOfIterations(0),
     m_ElapsedNumberOfIterations(0u),
-    m_TerminationUpdateThreshold(1e-5)
+    m_TerminationUpdateThreshold(1e-5),
+    m_ExcludeConsensusPixels(false)
   {
   }
   ~MultiLabelSTAPLEImageFilter() override {}
@@ -316,6 +337,39 @@ private:
   unsigned int m_ElapsedNumberOfIterations;
 
   TWeights m_TerminationUpdateThreshold;
+
+  bool m_ExcludeConsensusPixels;
+
+  /** Run a function on ranges of the pixels of the output, in parallel. */
+  template< typename TFunction >
+  void ParallelizePixels( SizeValueType numberOfPixels, const TFunction & function );
+
+  /** Get the labels of the inputs at a pixel, and whether they are all the
+   * same. */
+  bool GetPixelLabels( SizeValueType pixel, InputPixelType * labels ) const;
+
+  /** Count the consensus pixels of each label, and list the other ones. */
+  void ClassifyPixels();
+
+  /** Compute the class weights of a pixel with the current confusion
+   * matrices, the E step. The weights are products of one probability per
+   * input, which are computed in the real type of the weights to avoid
+   * underflows and denormal numbers with many inputs. */
+  void ComputeWeights( const InputPixelType * labels, WeightsRealType * W ) const;
+
+  /** The label with the maximum weight, or an undecided label. */
+  OutputPixelType ComputeWinningLabel( const WeightsRealType * W ) const;
+
+  /** Add the weights of the pixels, once per pixel, to the updated
+   * confusion matrices. */
+  void AccumulateUpdatedConfusionMatrices();
+
+  // the input buffers, the number of consensus pixels of each label, and
+  // the offsets of the other pixels in the buffers
+  std::vector< const InputPixelType * > m_InputBuffers;
+  std::vector< SizeValueType >          m_ConsensusCounts;
+  std::vector< SizeValueType >          m_DisagreementPixels;
+  SimpleFastMutexLock                   m_Mutex;
 };
 
 } // end namespace itk
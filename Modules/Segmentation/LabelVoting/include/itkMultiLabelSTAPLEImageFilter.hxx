@@ -20,9 +20,9 @@
 
 #include "itkMultiLabelSTAPLEImageFilter.h"
 
-#include "itkLabelVotingImageFilter.h"
-
 #include "itkMath.h"
+#include "itkMutexLockHolder.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -50,6 +50,8 @@ MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
      << m_ElapsedNumberOfIterations << std::endl;
   os << indent << "TerminationUpdateThreshold = "
      << this->m_TerminationUpdateThreshold << std::endl;
+  os << indent << "ExcludeConsensusPixels = "
+     << this->m_ExcludeConsensusPixels << std::endl;
 }
 
 template < typename TInputImage, typename TOutputImage, typename TWeights>
@@ -75,6 +77,32 @@ MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
   data->SetRequestedRegionToLargestPossibleRegion();
 }
 
+template< typename TInputImage, typename TOutputImage, typename TWeights >
+template< typename TFunction >
+void
+MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
+::ParallelizePixels( SizeValueType numberOfPixels, const TFunction & function )
+{
+  if ( numberOfPixels == 0 )
+    {
+    return;
+    }
+  ImageRegion< 1 > pixels;
+  pixels.SetIndex( 0, 0 );
+  pixels.SetSize( 0, numberOfPixels );
+
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+  multiThreader->template ParallelizeImageRegion< 1 >(
+    pixels,
+    [&](const ImageRegion< 1 > & range)
+      {
+      function( static_cast< SizeValueType >( range.GetIndex(0) ),
+                static_cast< SizeValueType >( range.GetIndex(0) ) + range.GetSize(0) );
+      },
+    nullptr);
+}
+
 template< typename TInputImage, typename TOutputImage, typename TWeights >
 typename TInputImage::PixelType
 MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
@@ -87,12 +115,19 @@ MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
 
   for ( size_t k = 0; k < numberOfInputs; ++k )
     {
-    InputConstIteratorType it( this->GetInput( k ), this->GetInput( k )->GetBufferedRegion() );
-
-    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
-      {
-      maxLabel = std::max( maxLabel, it.Get() );
-      }
+    const InputImageType * input = this->GetInput( k );
+    const InputPixelType * buffer = input->GetBufferPointer();
+    this->ParallelizePixels( input->GetBufferedRegion().GetNumberOfPixels(),
+      [&](SizeValueType begin, SizeValueType end)
+        {
+        InputPixelType localMaxLabel = 0;
+        for ( SizeValueType i = begin; i < end; ++i )
+          {
+          localMaxLabel = std::max( localMaxLabel, buffer[i] );
+          }
+        MutexLockHolder< SimpleFastMutexLock > mutexHolder( m_Mutex );
+        maxLabel = std::max( maxLabel, localMaxLabel );
+        } );
     }
 
   return maxLabel;
@@ -126,44 +161,145 @@ MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
 }
 
 template< typename TInputImage, typename TOutputImage, typename TWeights >
-void
+bool
 MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
-::InitializeConfusionMatrixArrayFromVoting()
+::GetPixelLabels( SizeValueType pixel, InputPixelType * labels ) const
 {
-  const auto numberOfInputs = static_cast<const unsigned int>( this->GetNumberOfInputs() );
-
-  using LabelVotingFilterType = LabelVotingImageFilter<TInputImage, TOutputImage>;
-  using LabelVotingFilterPointer = typename LabelVotingFilterType::Pointer;
+  bool isConsensus = true;
+  for ( size_t k = 0; k < m_InputBuffers.size(); ++k )
+    {
+    labels[k] = m_InputBuffers[k][pixel];
+    isConsensus = isConsensus && labels[k] == labels[0];
+    }
+  return isConsensus;
+}
 
-  typename OutputImageType::Pointer votingOutput;
+template< typename TInputImage, typename TOutputImage, typename TWeights >
+void
+MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
+::ClassifyPixels()
+{
+  const size_t numberOfInputs = this->GetNumberOfInputs();
+  const SizeValueType numberOfPixels = this->GetOutput()->GetRequestedRegion().GetNumberOfPixels();
 
-  { // begin scope for local filter allocation
-  LabelVotingFilterPointer votingFilter = LabelVotingFilterType::New();
+  m_ConsensusCounts.assign( this->m_TotalLabelCount, 0 );
+  m_DisagreementPixels.clear();
 
-  for ( unsigned int k = 0; k < numberOfInputs; ++k )
+  // the disagreement pixels of each range, in the order of the ranges
+  std::vector< std::pair< SizeValueType, std::vector< SizeValueType > > > disagreementPixels;
+  this->ParallelizePixels( numberOfPixels,
+    [&](SizeValueType begin, SizeValueType end)
+      {
+      std::vector< SizeValueType > localConsensusCounts( this->m_TotalLabelCount, 0 );
+      std::vector< SizeValueType > localDisagreementPixels;
+      std::vector< InputPixelType > labels( numberOfInputs );
+      for ( SizeValueType i = begin; i < end; ++i )
+        {
+        if ( this->GetPixelLabels( i, labels.data() ) )
+          {
+          ++localConsensusCounts[labels[0]];
+          }
+        else
+          {
+          localDisagreementPixels.push_back( i );
+          }
+        }
+      MutexLockHolder< SimpleFastMutexLock > mutexHolder( m_Mutex );
+      for ( size_t l = 0; l < this->m_TotalLabelCount; ++l )
+        {
+        m_ConsensusCounts[l] += localConsensusCounts[l];
+        }
+      disagreementPixels.emplace_back( begin, std::move( localDisagreementPixels ) );
+      } );
+
+  std::sort( disagreementPixels.begin(), disagreementPixels.end(),
+             [](const std::pair< SizeValueType, std::vector< SizeValueType > > & a,
+                const std::pair< SizeValueType, std::vector< SizeValueType > > & b)
+               {
+               return a.first < b.first;
+               } );
+  for ( const auto & range : disagreementPixels )
     {
-    votingFilter->SetInput( k, this->GetInput( k ) );
+    m_DisagreementPixels.insert( m_DisagreementPixels.end(), range.second.begin(), range.second.end() );
     }
-  votingFilter->Update();
-  votingOutput = votingFilter->GetOutput();
-  } // begin scope for local filter allocation; de-allocate filter
+}
 
-  OutputIteratorType out =
-    OutputIteratorType( votingOutput, votingOutput->GetRequestedRegion() );
+template< typename TInputImage, typename TOutputImage, typename TWeights >
+void
+MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
+::InitializeConfusionMatrixArrayFromVoting()
+{
+  const auto numberOfInputs = static_cast<const unsigned int>( this->GetNumberOfInputs() );
+  const size_t labelCount = this->m_TotalLabelCount;
 
   for ( unsigned int k = 0; k < numberOfInputs; ++k )
     {
     this->m_ConfusionMatrixArray[k].Fill( 0.0 );
+    }
 
-    InputConstIteratorType in =
-      InputConstIteratorType( this->GetInput( k ), votingOutput->GetRequestedRegion() );
-
-    for ( out.GoToBegin(); ! out.IsAtEnd(); ++out, ++in )
+  // the consensus pixels vote for their label
+  if ( !this->m_ExcludeConsensusPixels )
+    {
+    for ( size_t l = 0; l < labelCount; ++l )
       {
-      ++(this->m_ConfusionMatrixArray[k][in.Get()][out.Get()]);
+      for ( unsigned int k = 0; k < numberOfInputs; ++k )
+        {
+        this->m_ConfusionMatrixArray[k][l][l] += m_ConsensusCounts[l];
+        }
       }
     }
 
+  // the label with the most votes at the other pixels, as done by
+  // LabelVotingImageFilter; the undecided pixels are not counted
+  this->ParallelizePixels( m_DisagreementPixels.size(),
+    [&](SizeValueType begin, SizeValueType end)
+      {
+      std::vector< SizeValueType > counts( numberOfInputs * ( labelCount + 1 ) * labelCount, 0 );
+      std::vector< InputPixelType > labels( numberOfInputs );
+      for ( SizeValueType i = begin; i < end; ++i )
+        {
+        this->GetPixelLabels( m_DisagreementPixels[i], labels.data() );
+        unsigned int maximumVotes = 0;
+        bool         isUndecided = false;
+        InputPixelType winningLabel = 0;
+        for ( unsigned int k = 0; k < numberOfInputs; ++k )
+          {
+          unsigned int votes = 0;
+          for ( unsigned int m = 0; m < numberOfInputs; ++m )
+            {
+            votes += ( labels[m] == labels[k] );
+            }
+          if ( votes > maximumVotes )
+            {
+            maximumVotes = votes;
+            winningLabel = labels[k];
+            isUndecided = false;
+            }
+          else if ( votes == maximumVotes && labels[k] != winningLabel )
+            {
+            isUndecided = true;
+            }
+          }
+        if ( !isUndecided )
+          {
+          for ( unsigned int k = 0; k < numberOfInputs; ++k )
+            {
+            ++counts[( k * ( labelCount + 1 ) + labels[k] ) * labelCount + winningLabel];
+            }
+          }
+        }
+      MutexLockHolder< SimpleFastMutexLock > mutexHolder( m_Mutex );
+      for ( unsigned int k = 0; k < numberOfInputs; ++k )
+        {
+        const SizeValueType * matrixCounts = counts.data() + k * ( labelCount + 1 ) * labelCount;
+        WeightsType *         matrix = this->m_ConfusionMatrixArray[k].data_block();
+        for ( size_t e = 0; e < ( labelCount + 1 ) * labelCount; ++e )
+          {
+          matrix[e] += matrixCounts[e];
+          }
+        }
+      } );
+
   // normalize matrix rows to unit probability sum
   for ( unsigned int k = 0; k < numberOfInputs; ++k )
     {
@@ -208,123 +344,225 @@ MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
     this->m_PriorProbabilities.Fill( 0.0 );
 
     const size_t numberOfInputs = this->GetNumberOfInputs();
-    for (size_t k = 0; k < numberOfInputs; ++k )
+    if ( !this->m_ExcludeConsensusPixels )
       {
-      InputConstIteratorType in = InputConstIteratorType( this->GetInput( k ), this->GetOutput()->GetRequestedRegion() );
-      for ( in.GoToBegin(); ! in.IsAtEnd(); ++in )
+      for ( size_t l = 0; l < this->m_TotalLabelCount; ++l )
         {
-        ++(this->m_PriorProbabilities[in.Get()]);
+        this->m_PriorProbabilities[l] += static_cast< WeightsType >( numberOfInputs * m_ConsensusCounts[l] );
         }
       }
+    this->ParallelizePixels( m_DisagreementPixels.size(),
+      [&](SizeValueType begin, SizeValueType end)
+        {
+        std::vector< SizeValueType > counts( this->m_TotalLabelCount, 0 );
+        for ( SizeValueType i = begin; i < end; ++i )
+          {
+          for ( size_t k = 0; k < numberOfInputs; ++k )
+            {
+            ++counts[m_InputBuffers[k][m_DisagreementPixels[i]]];
+            }
+          }
+        MutexLockHolder< SimpleFastMutexLock > mutexHolder( m_Mutex );
+        for ( size_t l = 0; l < this->m_TotalLabelCount; ++l )
+          {
+          this->m_PriorProbabilities[l] += counts[l];
+          }
+        } );
 
     WeightsType totalProbMass = 0.0;
     for ( InputPixelType l = 0; l < this->m_TotalLabelCount; ++l )
       totalProbMass += this->m_PriorProbabilities[l];
-    for ( InputPixelType l = 0; l < this->m_TotalLabelCount; ++l )
-      this->m_PriorProbabilities[l] /= totalProbMass;
+    // when the consensus pixels are excluded and the inputs agree
+    // everywhere, no label was counted: use uniform priors instead
+    if ( totalProbMass > 0 )
+      {
+      for ( InputPixelType l = 0; l < this->m_TotalLabelCount; ++l )
+        this->m_PriorProbabilities[l] /= totalProbMass;
+      }
+    else
+      {
+      for ( InputPixelType l = 0; l < this->m_TotalLabelCount; ++l )
+        this->m_PriorProbabilities[l] = 1.0 / static_cast< WeightsType >( this->m_TotalLabelCount );
+      }
     }
 }
 
 template< typename TInputImage, typename TOutputImage, typename TWeights >
 void
 MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
-::GenerateData()
+::ComputeWeights( const InputPixelType * labels, WeightsRealType * W ) const
 {
-  // determine the maximum label in all input images
-  this->m_TotalLabelCount =
-    static_cast<size_t>(this->ComputeMaximumInputValue()) + 1;
-
-  if ( ! this->m_HasLabelForUndecidedPixels )
+  for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
     {
-    this->m_LabelForUndecidedPixels = static_cast<OutputPixelType>( this->m_TotalLabelCount );
+    W[ci] = this->m_PriorProbabilities[ci];
     }
+  for ( size_t k = 0; k < m_InputBuffers.size(); ++k )
+    {
+    const WeightsType * row = this->m_ConfusionMatrixArray[k][labels[k]];
+    for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
+      {
+      W[ci] *= row[ci];
+      }
+    }
+}
 
-  // allocate and initialize the confusion matrices
-  this->AllocateConfusionMatrixArray();
-  this->InitializeConfusionMatrixArrayFromVoting();
-
-  // test existing or allocate and initialize new array with prior class
-  // probabilities
-  this->InitializePriorProbabilities();
-
-  // Allocate the output image.
-  typename TOutputImage::Pointer output = this->GetOutput();
-  output->SetBufferedRegion( output->GetRequestedRegion() );
-  output->Allocate();
-
-  // Record the number of input files.
-  const size_t numberOfInputs = this->GetNumberOfInputs();
-
-  // create and initialize all input image iterators
-  auto * it = new InputConstIteratorType[numberOfInputs];
-  for (size_t k = 0; k < numberOfInputs; ++k )
+template< typename TInputImage, typename TOutputImage, typename TWeights >
+typename MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >::OutputPixelType
+MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
+::ComputeWinningLabel( const WeightsRealType * W ) const
+{
+  auto winningLabel = static_cast<OutputPixelType>( this->m_TotalLabelCount );
+  WeightsRealType winningLabelW = 0;
+  for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
     {
-    it[k] = InputConstIteratorType
-      ( this->GetInput( k ), output->GetRequestedRegion() );
+    if ( W[ci] > winningLabelW )
+      {
+      winningLabelW = W[ci];
+      winningLabel = ci;
+      }
+    else if ( ! ( W[ci] < winningLabelW ) )
+      {
+      winningLabel = static_cast<OutputPixelType>( this->m_TotalLabelCount );
+      }
     }
+  return winningLabel;
+}
 
-  // allocate array for pixel class weights
-  auto * W = new WeightsType[ this->m_TotalLabelCount ];
+template< typename TInputImage, typename TOutputImage, typename TWeights >
+void
+MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
+::AccumulateUpdatedConfusionMatrices()
+{
+  const size_t numberOfInputs = this->GetNumberOfInputs();
+  const size_t labelCount = this->m_TotalLabelCount;
+  const size_t matrixSize = ( labelCount + 1 ) * labelCount;
 
-  unsigned int iteration = 0;
-  for (; (!this->m_HasMaximumNumberOfIterations) || (iteration < this->m_MaximumNumberOfIterations); ++iteration )
+  // the following is the E step, and the M step is the normalization
+  // of the weights and their accumulation
+  const auto accumulate = [&](const InputPixelType * labels, WeightsRealType * W, WeightsRealType count,
+                              WeightsType * updated)
     {
-    // reset updated confusion matrix
-    for ( unsigned int k = 0; k < numberOfInputs; ++k )
+    this->ComputeWeights( labels, W );
+    WeightsRealType sumW = W[0];
+    for ( OutputPixelType ci = 1; ci < labelCount; ++ci )
       {
-      this->m_UpdatedConfusionMatrixArray[k].Fill( 0.0 );
+      sumW += W[ci];
       }
-
-    // reset all input iterators to start
-    for ( unsigned int k = 0; k < numberOfInputs; ++k )
+    const WeightsRealType scale = sumW ? count / sumW : count;
+    for ( size_t k = 0; k < numberOfInputs; ++k )
       {
-      it[k].GoToBegin();
+      WeightsType * row = updated + k * matrixSize + labels[k] * labelCount;
+      for ( OutputPixelType ci = 0; ci < labelCount; ++ci )
+        {
+        row[ci] += static_cast< WeightsType >( W[ci] * scale );
+        }
       }
+    };
 
-    // use it[0] as indicator for image pixel count
-    while ( ! it[0].IsAtEnd() )
+  // each thread accumulates its pixels in its own matrices
+  this->ParallelizePixels( m_DisagreementPixels.size(),
+    [&](SizeValueType begin, SizeValueType end)
       {
-      // the following is the E step
-      for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
+      std::vector< WeightsType > updated( numberOfInputs * matrixSize, 0.0 );
+      std::vector< InputPixelType > labels( numberOfInputs );
+      std::vector< WeightsRealType > W( labelCount );
+      for ( SizeValueType i = begin; i < end; ++i )
         {
-        W[ci] = this->m_PriorProbabilities[ci];
+        this->GetPixelLabels( m_DisagreementPixels[i], labels.data() );
+        accumulate( labels.data(), W.data(), 1.0, updated.data() );
         }
-      for ( unsigned int k = 0; k < numberOfInputs; ++k )
+      MutexLockHolder< SimpleFastMutexLock > mutexHolder( m_Mutex );
+      for ( size_t k = 0; k < numberOfInputs; ++k )
         {
-        const InputPixelType j = it[k].Get();
-        for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
+        WeightsType * matrix = this->m_UpdatedConfusionMatrixArray[k].data_block();
+        for ( size_t e = 0; e < matrixSize; ++e )
           {
-          W[ci] *= this->m_ConfusionMatrixArray[k][j][ci];
+          matrix[e] += updated[k * matrixSize + e];
           }
         }
+      } );
 
-      // the following is the M step
-      WeightsType sumW = W[0];
-      for ( OutputPixelType ci = 1; ci < this->m_TotalLabelCount; ++ci )
+  // all the consensus pixels of a label have the same weights
+  if ( !this->m_ExcludeConsensusPixels )
+    {
+    std::vector< WeightsType > updated( numberOfInputs * matrixSize, 0.0 );
+    std::vector< InputPixelType > labels( numberOfInputs );
+    std::vector< WeightsRealType > W( labelCount );
+    for ( size_t l = 0; l < labelCount; ++l )
+      {
+      if ( m_ConsensusCounts[l] > 0 )
         {
-        sumW += W[ci];
+        std::fill( labels.begin(), labels.end(), static_cast< InputPixelType >( l ) );
+        accumulate( labels.data(), W.data(), static_cast< WeightsRealType >( m_ConsensusCounts[l] ), updated.data() );
         }
-
-      if ( sumW )
+      }
+    for ( size_t k = 0; k < numberOfInputs; ++k )
+      {
+      WeightsType * matrix = this->m_UpdatedConfusionMatrixArray[k].data_block();
+      for ( size_t e = 0; e < matrixSize; ++e )
         {
-        for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
-          {
-          W[ci] /= sumW;
-          }
+        matrix[e] += updated[k * matrixSize + e];
         }
+      }
+    }
+}
 
-      for ( unsigned int k = 0; k < numberOfInputs; ++k )
-        {
-        const InputPixelType j = it[k].Get();
-        for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
-          {
-          this->m_UpdatedConfusionMatrixArray[k][j][ci] += W[ci];
-          }
+template< typename TInputImage, typename TOutputImage, typename TWeights >
+void
+MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
+::GenerateData()
+{
+  // Allocate the output image.
+  typename TOutputImage::Pointer output = this->GetOutput();
+  output->SetBufferedRegion( output->GetRequestedRegion() );
+  output->Allocate();
 
-        // we're now done with this input pixel, so update.
-        ++(it[k]);
-        }
+  // Record the number of input files.
+  const size_t numberOfInputs = this->GetNumberOfInputs();
+
+  // the inputs are read directly from their buffers
+  m_InputBuffers.clear();
+  for ( size_t k = 0; k < numberOfInputs; ++k )
+    {
+    const InputImageType * input = this->GetInput( k );
+    if ( input->GetBufferedRegion() != output->GetRequestedRegion() )
+      {
+      itkExceptionMacro( "Input " << k << " buffered region " << input->GetBufferedRegion()
+                         << " is not the output region " << output->GetRequestedRegion() );
       }
+    m_InputBuffers.push_back( input->GetBufferPointer() );
+    }
+
+  // determine the maximum label in all input images
+  this->m_TotalLabelCount =
+    static_cast<size_t>(this->ComputeMaximumInputValue()) + 1;
+
+  if ( ! this->m_HasLabelForUndecidedPixels )
+    {
+    this->m_LabelForUndecidedPixels = static_cast<OutputPixelType>( this->m_TotalLabelCount );
+    }
+
+  // find the pixels where the inputs disagree
+  this->ClassifyPixels();
+
+  // allocate and initialize the confusion matrices
+  this->AllocateConfusionMatrixArray();
+  this->InitializeConfusionMatrixArrayFromVoting();
+
+  // test existing or allocate and initialize new array with prior class
+  // probabilities
+  this->InitializePriorProbabilities();
+
+  unsigned int iteration = 0;
+  for (; (!this->m_HasMaximumNumberOfIterations) || (iteration < this->m_MaximumNumberOfIterations); ++iteration )
+    {
+    // reset updated confusion matrix
+    for ( unsigned int k = 0; k < numberOfInputs; ++k )
+      {
+      this->m_UpdatedConfusionMatrixArray[k].Fill( 0.0 );
+      }
+
+    this->AccumulateUpdatedConfusionMatrices();
 
     // Normalize matrix elements of each of the updated confusion matrices
     // with sum over all expert decisions.
@@ -388,57 +626,43 @@ MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
     } // end for ( iteration )
 
   // now we'll build the combined output image based on the estimated
-  // confusion matrices
-
-  // reset all input iterators to start
-  for ( unsigned int k = 0; k < numberOfInputs; ++k )
+  // confusion matrices, by repeating the E step from above; the consensus
+  // pixels of a label all get the same output label
+  std::vector< OutputPixelType > consensusLabels( this->m_TotalLabelCount );
+  std::vector< InputPixelType >  labels( numberOfInputs );
+  std::vector< WeightsRealType > W( this->m_TotalLabelCount );
+  for ( size_t l = 0; l < this->m_TotalLabelCount; ++l )
     {
-    it[k].GoToBegin();
+    std::fill( labels.begin(), labels.end(), static_cast< InputPixelType >( l ) );
+    this->ComputeWeights( labels.data(), W.data() );
+    consensusLabels[l] = this->m_ExcludeConsensusPixels ? static_cast< OutputPixelType >( l )
+                                                         : this->ComputeWinningLabel( W.data() );
     }
 
-  // reset output iterator to start
-  OutputIteratorType out = OutputIteratorType( output, output->GetRequestedRegion() );
-  for ( out.GoToBegin(); !out.IsAtEnd(); ++out )
-    {
-    // basically, we'll repeat the E step from above
-    for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
-      {
-      W[ci] = this->m_PriorProbabilities[ci];
-      }
-
-    for ( unsigned int k = 0; k < numberOfInputs; ++k )
+  OutputPixelType * outputBuffer = output->GetBufferPointer();
+  this->ParallelizePixels( output->GetRequestedRegion().GetNumberOfPixels(),
+    [&](SizeValueType begin, SizeValueType end)
       {
-      const InputPixelType j = it[k].Get();
-      for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
+      std::vector< InputPixelType > threadLabels( numberOfInputs );
+      std::vector< WeightsRealType > threadW( this->m_TotalLabelCount );
+      for ( SizeValueType i = begin; i < end; ++i )
         {
-        W[ci] *= this->m_ConfusionMatrixArray[k][j][ci];
-        }
-      ++it[k];
-      }
-
-    // now determine the label with the maximum W
-    auto winningLabel = static_cast<OutputPixelType>( this->m_TotalLabelCount );
-    WeightsType winningLabelW = 0;
-    for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
-      {
-      if ( W[ci] > winningLabelW )
-        {
-        winningLabelW = W[ci];
-        winningLabel = ci;
-        }
-      else if ( ! ( W[ci] < winningLabelW ) )
-        {
-        winningLabel = static_cast<OutputPixelType>( this->m_TotalLabelCount );
+        if ( this->GetPixelLabels( i, threadLabels.data() ) )
+          {
+          outputBuffer[i] = consensusLabels[threadLabels[0]];
+          }
+        else
+          {
+          this->ComputeWeights( threadLabels.data(), threadW.data() );
+          outputBuffer[i] = this->ComputeWinningLabel( threadW.data() );
+          }
         }
-      }
-
-    out.Set( winningLabel );
-    }
+      } );
 
   m_ElapsedNumberOfIterations = iteration;
 
-  delete[] W;
-  delete[] it;
+  m_InputBuffers.clear();
+  std::vector< SizeValueType >().swap( m_DisagreementPixels );
 }
 
 } // end namespace itk
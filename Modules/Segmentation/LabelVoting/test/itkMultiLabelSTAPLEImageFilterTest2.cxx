@@ -0,0 +1,336 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMultiLabelSTAPLEImageFilter.h"
+#include "itkLabelVotingImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+#include <numeric>
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+using ImageType = itk::Image< unsigned char, Dimension >;
+using FilterType = itk::MultiLabelSTAPLEImageFilter< ImageType, ImageType, double >;
+using LabelsType = std::vector< std::vector< unsigned int > >;
+
+// The label with a unique maximum number of votes, or labelCount.
+unsigned int Vote( const std::vector< unsigned int > & labels, unsigned int labelCount )
+{
+  std::vector< unsigned int > votes( labelCount, 0 );
+  for( unsigned int label : labels )
+    {
+    ++votes[label];
+    }
+  unsigned int winner = labelCount;
+  unsigned int maximumVotes = 0;
+  for( unsigned int l = 0; l < labelCount; ++l )
+    {
+    if( votes[l] > maximumVotes )
+      {
+      maximumVotes = votes[l];
+      winner = l;
+      }
+    else if( votes[l] == maximumVotes && maximumVotes > 0 )
+      {
+      winner = labelCount;
+      }
+    }
+  return winner;
+}
+
+// The E-M iterations of the multi-label STAPLE, one pixel at a time, on
+// the labels of the pixels of each input.
+std::vector< unsigned int > Reference( const LabelsType & inputs, unsigned int labelCount,
+                                       unsigned int iterations, bool excludeConsensus,
+                                       std::vector< std::vector< double > > & matrices )
+{
+  const size_t numberOfInputs = inputs.size();
+  const size_t numberOfPixels = inputs[0].size();
+  std::vector< bool > isUsed( numberOfPixels, true );
+  std::vector< std::vector< unsigned int > > pixels( numberOfPixels );
+  for( size_t i = 0; i < numberOfPixels; ++i )
+    {
+    for( size_t k = 0; k < numberOfInputs; ++k )
+      {
+      pixels[i].push_back( inputs[k][i] );
+      }
+    isUsed[i] = !excludeConsensus
+                || std::count( pixels[i].begin(), pixels[i].end(), pixels[i][0] ) != static_cast< int >( numberOfInputs );
+    }
+  const auto at = [labelCount](size_t j, size_t c) { return j * labelCount + c; };
+
+  // the voting, and the priors
+  matrices.assign( numberOfInputs, std::vector< double >( ( labelCount + 1 ) * labelCount, 0.0 ) );
+  std::vector< double > priors( labelCount, 0.0 );
+  double total = 0.0;
+  for( size_t i = 0; i < numberOfPixels; ++i )
+    {
+    if( !isUsed[i] )
+      {
+      continue;
+      }
+    const unsigned int winner = Vote( pixels[i], labelCount );
+    for( size_t k = 0; k < numberOfInputs; ++k )
+      {
+      if( winner < labelCount )
+        {
+        matrices[k][at( pixels[i][k], winner )] += 1.0;
+        }
+      priors[pixels[i][k]] += 1.0;
+      total += 1.0;
+      }
+    }
+  for( unsigned int l = 0; l < labelCount; ++l )
+    {
+    priors[l] /= total;
+    }
+  for( size_t k = 0; k < numberOfInputs; ++k )
+    {
+    for( unsigned int j = 0; j <= labelCount; ++j )
+      {
+      double sum = 0.0;
+      for( unsigned int c = 0; c < labelCount; ++c )
+        {
+        sum += matrices[k][at( j, c )];
+        }
+      for( unsigned int c = 0; c < labelCount && sum > 0; ++c )
+        {
+        matrices[k][at( j, c )] /= sum;
+        }
+      }
+    }
+
+  const auto weights = [&](const std::vector< unsigned int > & labels)
+    {
+    std::vector< double > W( priors );
+    for( size_t k = 0; k < numberOfInputs; ++k )
+      {
+      for( unsigned int c = 0; c < labelCount; ++c )
+        {
+        W[c] *= matrices[k][at( labels[k], c )];
+        }
+      }
+    return W;
+    };
+
+  for( unsigned int iteration = 0; iteration < iterations; ++iteration )
+    {
+    std::vector< std::vector< double > > updated( numberOfInputs,
+                                                  std::vector< double >( ( labelCount + 1 ) * labelCount, 0.0 ) );
+    for( size_t i = 0; i < numberOfPixels; ++i )
+      {
+      if( !isUsed[i] )
+        {
+        continue;
+        }
+      std::vector< double > W = weights( pixels[i] );
+      const double sum = std::accumulate( W.begin(), W.end(), 0.0 );
+      for( size_t k = 0; k < numberOfInputs; ++k )
+        {
+        for( unsigned int c = 0; c < labelCount; ++c )
+          {
+          updated[k][at( pixels[i][k], c )] += sum > 0 ? W[c] / sum : 0.0;
+          }
+        }
+      }
+    for( size_t k = 0; k < numberOfInputs; ++k )
+      {
+      for( unsigned int c = 0; c < labelCount; ++c )
+        {
+        double sum = 0.0;
+        for( unsigned int j = 0; j <= labelCount; ++j )
+          {
+          sum += updated[k][at( j, c )];
+          }
+        for( unsigned int j = 0; j <= labelCount && sum > 0; ++j )
+          {
+          updated[k][at( j, c )] /= sum;
+          }
+        }
+      }
+    matrices.swap( updated );
+    }
+
+  std::vector< unsigned int > output( numberOfPixels );
+  for( size_t i = 0; i < numberOfPixels; ++i )
+    {
+    if( !isUsed[i] )
+      {
+      output[i] = pixels[i][0];
+      continue;
+      }
+    const std::vector< double > W = weights( pixels[i] );
+    output[i] = labelCount;
+    double maximum = 0.0;
+    for( unsigned int c = 0; c < labelCount; ++c )
+      {
+      if( W[c] > maximum )
+        {
+        maximum = W[c];
+        output[i] = c;
+        }
+      else if( !( W[c] < maximum ) )
+        {
+        output[i] = labelCount;
+        }
+      }
+    }
+  return output;
+}
+
+std::vector< unsigned int > Labels( const ImageType * image )
+{
+  std::vector< unsigned int > labels;
+  itk::ImageRegionConstIterator< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    labels.push_back( it.Get() );
+    }
+  return labels;
+}
+}
+
+// Compare the multi-label STAPLE and the voting with a computation one
+// pixel at a time, for several numbers of threads, on noisy copies of a
+// segmentation which agree on most pixels.
+int itkMultiLabelSTAPLEImageFilterTest2( int, char * [] )
+{
+  constexpr unsigned int labelCount = 6;
+  constexpr unsigned int numberOfInputs = 5;
+  constexpr unsigned int iterations = 8;
+  ImageType::SizeType size = {{ 61, 47 }};
+
+  using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+
+  FilterType::Pointer filter = FilterType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( filter, MultiLabelSTAPLEImageFilter, ImageToImageFilter );
+  TEST_SET_GET_BOOLEAN( filter, ExcludeConsensusPixels, false );
+  filter->SetMaximumNumberOfIterations( iterations );
+  filter->SetTerminationUpdateThreshold( 0.0 );
+
+  using VotingType = itk::LabelVotingImageFilter< ImageType >;
+  VotingType::Pointer voting = VotingType::New();
+
+  LabelsType inputs;
+  for( unsigned int k = 0; k < numberOfInputs; ++k )
+    {
+    ImageType::Pointer input = ImageType::New();
+    input->SetRegions( size );
+    input->Allocate();
+    itk::ImageRegionIteratorWithIndex< ImageType > it( input, input->GetBufferedRegion() );
+    const double errorRate = 0.05 + 0.05 * k;
+    for( ; !it.IsAtEnd(); ++it )
+      {
+      const unsigned int truth = ( it.GetIndex()[0] / 11 + it.GetIndex()[1] / 13 ) % labelCount;
+      it.Set( generator->GetVariate() < errorRate ? generator->GetIntegerVariate( labelCount - 1 ) : truth );
+      }
+    filter->SetInput( k, input );
+    voting->SetInput( k, input );
+    inputs.push_back( Labels( input ) );
+    }
+
+  bool passed = true;
+  for( unsigned int exclude = 0; exclude < 2; ++exclude )
+    {
+    std::vector< std::vector< double > > matrices;
+    const std::vector< unsigned int > expected = Reference( inputs, labelCount, iterations, exclude, matrices );
+
+    filter->SetExcludeConsensusPixels( exclude );
+    for( unsigned int threads = 1; threads < 8; threads += 3 )
+      {
+      filter->SetNumberOfThreads( threads );
+      TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+      TEST_EXPECT_EQUAL( filter->GetElapsedNumberOfIterations(), iterations );
+
+      const std::vector< unsigned int > output = Labels( filter->GetOutput() );
+      const auto differences = static_cast< unsigned int >(
+        output.size() - std::inner_product( output.begin(), output.end(), expected.begin(), size_t( 0 ),
+                                             std::plus< size_t >(), std::equal_to< unsigned int >() ) );
+      double maximumError = 0.0;
+      for( unsigned int k = 0; k < numberOfInputs; ++k )
+        {
+        for( unsigned int j = 0; j <= labelCount; ++j )
+          {
+          for( unsigned int c = 0; c < labelCount; ++c )
+            {
+            maximumError = std::max( maximumError, std::abs( filter->GetConfusionMatrix( k )[j][c]
+                                                             - matrices[k][j * labelCount + c] ) );
+            }
+          }
+        }
+      std::cout << ( exclude ? "consensus excluded, " : "" ) << threads << " threads: " << differences
+                << " differences, confusion matrix error " << maximumError << std::endl;
+      passed &= ( differences == 0 && maximumError < 1e-9 );
+      filter->Modified();
+      }
+    }
+
+  // inputs which agree everywhere, with the consensus pixels excluded:
+  // there is no pixel to estimate the priors from, which are uniform
+  FilterType::Pointer consensusFilter = FilterType::New();
+  consensusFilter->SetExcludeConsensusPixels( true );
+  consensusFilter->SetMaximumNumberOfIterations( iterations );
+  for( unsigned int k = 0; k < numberOfInputs; ++k )
+    {
+    consensusFilter->SetInput( k, filter->GetInput( 0 ) );
+    }
+  TRY_EXPECT_NO_EXCEPTION( consensusFilter->Update() );
+  const std::vector< unsigned int > consensusOutput = Labels( consensusFilter->GetOutput() );
+  unsigned int consensusDifferences = 0;
+  for( size_t i = 0; i < consensusOutput.size(); ++i )
+    {
+    consensusDifferences += ( consensusOutput[i] != inputs[0][i] );
+    }
+  const FilterType::PriorProbabilitiesType & priors = consensusFilter->GetPriorProbabilities();
+  bool areUniform = true;
+  for( unsigned int l = 0; l < labelCount; ++l )
+    {
+    areUniform &= itk::Math::FloatAlmostEqual( priors[l], 1.0 / labelCount );
+    }
+  std::cout << "consensus excluded, all consensus: " << consensusDifferences << " differences, priors "
+            << priors << std::endl;
+  passed &= ( consensusDifferences == 0 && areUniform );
+
+  // the voting
+  for( unsigned int threads = 1; threads < 8; threads += 3 )
+    {
+    voting->SetNumberOfThreads( threads );
+    voting->Modified();
+    TRY_EXPECT_NO_EXCEPTION( voting->Update() );
+    const std::vector< unsigned int > output = Labels( voting->GetOutput() );
+    unsigned int differences = 0;
+    for( size_t i = 0; i < output.size(); ++i )
+      {
+      std::vector< unsigned int > labels;
+      for( unsigned int k = 0; k < numberOfInputs; ++k )
+        {
+        labels.push_back( inputs[k][i] );
+        }
+      differences += ( output[i] != Vote( labels, labelCount ) );
+      }
+    std::cout << "voting, " << threads << " threads: " << differences << " differences" << std::endl;
+    passed &= ( differences == 0 );
+    }
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -28,6 +28,7 @@
 #include "itkConstNeighborhoodIterator.h"
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkSize.h"
+#include "itkFixedArray.h"
 
 namespace itk
 {
@@ -116,6 +117,11 @@ namespace itk
  * higher dimension is set to unity. This should be overridden by custom
  * weights after filter initialization.
  *
+ * When UseColoredUpdate is on, the pixels are instead visited color by
+ * color, where no two pixels of a color are in the neighborhood of each
+ * other, so the pixels of a color are updated in parallel. See
+ * SetUseColoredUpdate().
+ *
  * \ingroup MRFFilters
  * \sa Neighborhood \sa ImageIterator \sa NeighborhoodIterator
  * \sa Classifier
@@ -243,6 +249,23 @@ public:
   itkSetMacro(SmoothingFactor, double);
   itkGetConstMacro(SmoothingFactor, double);
 
+  /** Set/Get whether the ICM updates the pixels color by color instead of
+   * in raster order. When only the neighbors at an odd city block distance
+   * have a non zero weight, such as the face neighbors, the pixels are
+   * colored as a checkerboard, otherwise with the product over the
+   * dimensions of (radius + 1) colors. The pixels of a color are updated in
+   * parallel, and the result does not depend on the number of threads.
+   * After the first iteration, only the pixels with a neighbor whose label
+   * has changed since their last visit are reexamined. A pixel counts as
+   * changed for the ErrorTolerance when its label, or the label of a
+   * neighbor of a later color, has changed in the iteration. The
+   * membership values of the pixels are computed once and kept for all the
+   * iterations, which takes NumberOfClasses doubles per pixel, and
+   * DoNeighborhoodOperation is not called. Off by default. */
+  itkSetMacro(UseColoredUpdate, bool);
+  itkGetConstMacro(UseColoredUpdate, bool);
+  itkBooleanMacro(UseColoredUpdate);
+
   /** Set the neighborhood radius */
   void SetNeighborhoodRadius(const NeighborhoodRadiusType &);
 
@@ -372,6 +395,7 @@ private:
   double *          m_ClassProbability;         //Class liklihood
   unsigned int      m_NumberOfIterations;
   StopConditionType m_StopCondition;
+  bool              m_UseColoredUpdate;
 
   LabelStatusImagePointer m_LabelStatusImage;
 
@@ -380,6 +404,21 @@ private:
   std::vector< double > m_MahalanobisDistance;
   std::vector< double > m_DummyVector;
 
+  /** The buffer offsets and the weights of the neighbors with a non zero
+   * weight, the number of colors of each dimension, and for each color,
+   * the offsets of the neighbors with a later color, for the colored
+   * update. */
+  std::vector< OffsetValueType >                  m_WeightedNeighborOffsets;
+  std::vector< double >                           m_WeightedNeighborWeights;
+  bool                                            m_IsCheckerboard;
+  FixedArray< unsigned int, InputImageDimension > m_NumberOfColorsPerDimension;
+  std::vector< std::vector< OffsetValueType > >   m_LaterNeighborOffsets;
+
+  /** The membership values of the pixels, by class, and whether their label
+   * has changed in the current iteration, for the colored update. */
+  std::vector< double >        m_PixelMembershipValues;
+  std::vector< unsigned char > m_IsLabelChanged;
+
   /** Pointer to the classifier to be used for the MRF labelling. */
   typename ClassifierType::Pointer m_ClassifierPtr;
 
@@ -390,6 +429,17 @@ private:
 
   //Function implementing the ICM algorithm to label the images
   void ApplyICMLabeller();
+
+  /** Set up the colors and the neighbor offsets, and compute the
+   * membership values of the pixels, for the colored update. */
+  void InitializeColoredUpdate();
+
+  /** The color of a pixel of the labelled image. */
+  unsigned int GetColor(const LabelledImageIndexType & index) const;
+
+  /** Update the labels of the pixels of each color in parallel, then the
+   * label status of the pixels. */
+  void ApplyColoredICMLabeller();
 }; // class MRFImageFilter
 } // namespace itk
 
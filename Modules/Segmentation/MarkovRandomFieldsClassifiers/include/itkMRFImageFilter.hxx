@@ -18,6 +18,9 @@
 #ifndef itkMRFImageFilter_hxx
 #define itkMRFImageFilter_hxx
 #include "itkMRFImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkMutexLockHolder.h"
+#include "itkSimpleFastMutexLock.h"
 
 namespace itk
 {
@@ -35,6 +38,8 @@ MRFImageFilter< TInputImage, TClassifiedImage >
   m_ClassProbability(nullptr),
   m_NumberOfIterations(0),
   m_StopCondition(MaximumNumberOfIterations),
+  m_UseColoredUpdate(false),
+  m_IsCheckerboard(false),
   m_ClassifierPtr(nullptr)
 {
   if ( (int)InputImageDimension != (int)ClassifiedImageDimension )
@@ -97,6 +102,9 @@ MRFImageFilter< TInputImage, TClassifiedImage >
 
   os << indent << " Number of iterations: "
      << m_NumberOfIterations << std::endl;
+
+  os << indent << " Use colored update: "
+     << ( m_UseColoredUpdate ? "On" : "Off" ) << std::endl;
 } // end PrintSelf
 
 /*
@@ -181,11 +189,12 @@ MRFImageFilter< TInputImage, TClassifiedImage >
   //--------------------------------------------------------------------
   //Copy labelling result to the output buffer
   //--------------------------------------------------------------------
-  // Set the iterators to the processed image
+  // Set the iterators to the processed image, whose region has the size
+  // of the output region but starts at a zero index
   //--------------------------------------------------------------------
   LabelledImageRegionIterator
   labelledImageIt( m_ClassifierPtr->GetClassifiedImage(),
-                   outputPtr->GetRequestedRegion() );
+                   m_ClassifierPtr->GetClassifiedImage()->GetBufferedRegion() );
 
   //--------------------------------------------------------------------
   // Set the iterators to the output image buffer
@@ -400,6 +409,8 @@ MRFImageFilter< TInputImage, TClassifiedImage >
   //---------------------------------------------------------------------
   //Get the number of valid pixels in the output MRF image
   //---------------------------------------------------------------------
+  m_TotalNumberOfPixelsInInputImage = 1;
+  m_TotalNumberOfValidPixelsInOutputImage = 1;
   int tmp;
   for ( unsigned int i = 0; i < InputImageDimension; i++ )
     {
@@ -424,15 +435,8 @@ MRFImageFilter< TInputImage, TClassifiedImage >
   m_LabelStatusImage->SetBufferedRegion(region);
   m_LabelStatusImage->Allocate();
 
-  LabelStatusImageIterator rIter( m_LabelStatusImage,
-                                  m_LabelStatusImage->GetBufferedRegion() );
-
   //Initialize the label status image to 1
-  while ( !rIter.IsAtEnd() )
-    {
-    rIter.Set(1);
-    ++rIter;
-    }
+  m_LabelStatusImage->FillBuffer(1);
 } // Allocate
 
 //-------------------------------------------------------
@@ -458,6 +462,14 @@ MRFImageFilter< TInputImage, TClassifiedImage >
   auto maxNumPixelError = Math::Round< int >(m_ErrorTolerance
                                             * m_TotalNumberOfValidPixelsInOutputImage);
 
+  if ( m_UseColoredUpdate )
+    {
+    this->InitializeColoredUpdate();
+    }
+
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+
   m_NumberOfIterations = 0;
   do
     {
@@ -468,15 +480,23 @@ MRFImageFilter< TInputImage, TClassifiedImage >
     m_ErrorCounter = m_TotalNumberOfValidPixelsInOutputImage
                      - totalNumberOfPixelsInInputImage;
 
-    LabelStatusImageIterator rIter( m_LabelStatusImage,
-                                    m_LabelStatusImage->GetBufferedRegion() );
-
-    //Initialize the label status image to 1
-    while ( !rIter.IsAtEnd() )
+    //Count the pixels with a label status of 1, in parallel
+    SizeValueType       numberOfChangedPixels = 0;
+    SimpleFastMutexLock mutex;
+    multiThreader->template ParallelizeImageRegion< InputImageDimension >(
+      m_LabelStatusImage->GetBufferedRegion(),
+      [&](const LabelStatusRegionType & region)
       {
-      if ( rIter.Get() == 1 ) { m_ErrorCounter += 1; }
-      ++rIter;
-      }
+        SizeValueType count = 0;
+        for ( LabelStatusImageIterator rIter( m_LabelStatusImage, region ); !rIter.IsAtEnd(); ++rIter )
+          {
+          if ( rIter.Get() == 1 ) { count += 1; }
+          }
+        MutexLockHolder< SimpleFastMutexLock > holder( mutex );
+        numberOfChangedPixels += count;
+      },
+      nullptr );
+    m_ErrorCounter += static_cast< int >( numberOfChangedPixels );
     }
   while ( ( m_NumberOfIterations < m_MaximumNumberOfIterations )
           && ( m_ErrorCounter > maxNumPixelError ) );
@@ -490,6 +510,10 @@ MRFImageFilter< TInputImage, TClassifiedImage >
     {
     m_StopCondition = ErrorTolerance;
     }
+
+  //Release the memory of the colored update
+  std::vector< double >().swap(m_PixelMembershipValues);
+  std::vector< unsigned char >().swap(m_IsLabelChanged);
 } // ApplyMRFImageFilter
 
 //-------------------------------------------------------
@@ -503,7 +527,14 @@ MRFImageFilter< TInputImage, TClassifiedImage >
 ::MinimizeFunctional()
 {
   //This implementation uses the ICM algorithm
-  ApplyICMLabeller();
+  if ( m_UseColoredUpdate )
+    {
+    this->ApplyColoredICMLabeller();
+    }
+  else
+    {
+    this->ApplyICMLabeller();
+    }
 }
 
 //-------------------------------------------------------
@@ -595,6 +626,298 @@ MRFImageFilter< TInputImage, TClassifiedImage >
     }
 } //ApplyICMlabeller
 
+//-------------------------------------------------------
+//-------------------------------------------------------
+//Set up the colored update
+//-------------------------------------------------------
+template< typename TInputImage, typename TClassifiedImage >
+void
+MRFImageFilter< TInputImage, TClassifiedImage >
+::InitializeColoredUpdate()
+{
+  LabelledImagePointer labelledImage = m_ClassifierPtr->GetClassifiedImage();
+  const OffsetValueType *offsetTable = labelledImage->GetOffsetTable();
+
+  //The neighbors with a non zero weight, in the order of the weights
+  Neighborhood< char, InputImageDimension > neighborhood;
+  neighborhood.SetRadius(m_LabelledImageNeighborhoodRadius);
+  if ( m_NeighborhoodSize > static_cast< int >( neighborhood.Size() ) )
+    {
+    itkExceptionMacro(<< "The " << m_NeighborhoodSize << " neighborhood weights do not fit in a neighborhood of radius "
+                      << m_LabelledImageNeighborhoodRadius);
+    }
+
+  m_WeightedNeighborOffsets.clear();
+  m_WeightedNeighborWeights.clear();
+  std::vector< LabelledImageOffsetType > weightedNeighbors;
+  m_IsCheckerboard = true;
+  for ( int i = 0; i < m_NeighborhoodSize; ++i )
+    {
+    if ( Math::NotExactlyEquals(m_MRFNeighborhoodWeight[i], 0.0) )
+      {
+      const LabelledImageOffsetType neighbor = neighborhood.GetOffset(i);
+      OffsetValueType offset = 0;
+      OffsetValueType distance = 0;
+      for ( unsigned int d = 0; d < InputImageDimension; ++d )
+        {
+        offset += neighbor[d] * offsetTable[d];
+        distance += std::abs(neighbor[d]);
+        }
+      m_WeightedNeighborOffsets.push_back(offset);
+      m_WeightedNeighborWeights.push_back(m_MRFNeighborhoodWeight[i]);
+      if ( distance > 0 )
+        {
+        weightedNeighbors.push_back(neighbor);
+        m_IsCheckerboard = m_IsCheckerboard && ( distance % 2 == 1 );
+        }
+      }
+    }
+
+  //The colors: two pixels of a color are at an even city block distance,
+  //or at a multiple of radius + 1 along each dimension
+  unsigned int numberOfColors = 1;
+  for ( unsigned int d = 0; d < InputImageDimension; ++d )
+    {
+    m_NumberOfColorsPerDimension[d] = m_IsCheckerboard ? 2 : static_cast< unsigned int >(
+      m_LabelledImageNeighborhoodRadius[d] + 1 );
+    numberOfColors *= m_NumberOfColorsPerDimension[d];
+    }
+  if ( m_IsCheckerboard )
+    {
+    numberOfColors = 2;
+    }
+
+  //For each color, the neighbors with a later color, from a pixel of the
+  //color far enough from the origin
+  m_LaterNeighborOffsets.assign( numberOfColors, std::vector< OffsetValueType >() );
+  for ( unsigned int color = 0; color < numberOfColors; ++color )
+    {
+    LabelledImageIndexType index;
+    unsigned int           digits = color;
+    for ( unsigned int d = 0; d < InputImageDimension; ++d )
+      {
+      const unsigned int colors = m_NumberOfColorsPerDimension[d];
+      index[d] = colors * m_LabelledImageNeighborhoodRadius[d] + ( m_IsCheckerboard ? 0 : digits % colors );
+      digits /= colors;
+      }
+    if ( m_IsCheckerboard )
+      {
+      index[0] += color;
+      }
+    for ( const LabelledImageOffsetType & neighbor : weightedNeighbors )
+      {
+      if ( this->GetColor(index + neighbor) > color )
+        {
+        OffsetValueType offset = 0;
+        for ( unsigned int d = 0; d < InputImageDimension; ++d )
+          {
+          offset += neighbor[d] * offsetTable[d];
+          }
+        m_LaterNeighborOffsets[color].push_back(offset);
+        }
+      }
+    }
+
+  //The membership values of the pixels, which do not depend on the labels
+  const unsigned int           numberOfClasses = m_NumberOfClasses;
+  const LabelledImageRegionType interior =
+    LabelledImageFacesCalculator()( labelledImage, labelledImage->GetBufferedRegion(),
+                                    m_LabelledImageNeighborhoodRadius ).front();
+  m_PixelMembershipValues.assign(labelledImage->GetBufferedRegion().GetNumberOfPixels() * numberOfClasses, 0.0);
+  m_IsLabelChanged.assign(labelledImage->GetBufferedRegion().GetNumberOfPixels(), 0);
+  if ( interior.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  InputImageConstPointer        inputImage = this->GetInput();
+  const LabelledImageOffsetType shift =
+    inputImage->GetBufferedRegion().GetIndex() - labelledImage->GetBufferedRegion().GetIndex();
+  MultiThreaderBase *multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+  multiThreader->template ParallelizeImageRegion< InputImageDimension >(
+    interior,
+    [&](const LabelledImageRegionType & region)
+    {
+      InputImageRegionType inputRegion = region;
+      inputRegion.SetIndex( region.GetIndex() + shift );
+      for ( ImageRegionConstIteratorWithIndex< TInputImage > it( inputImage, inputRegion ); !it.IsAtEnd(); ++it )
+        {
+        const std::vector< double > pixelMembershipValue = m_ClassifierPtr->GetPixelMembershipValue( it.Get() );
+        std::copy( pixelMembershipValue.begin(), pixelMembershipValue.end(),
+                   m_PixelMembershipValues.begin() + labelledImage->ComputeOffset( it.GetIndex() - shift ) * numberOfClasses );
+        }
+    },
+    nullptr );
+} // InitializeColoredUpdate
+
+template< typename TInputImage, typename TClassifiedImage >
+unsigned int
+MRFImageFilter< TInputImage, TClassifiedImage >
+::GetColor(const LabelledImageIndexType & index) const
+{
+  unsigned int color = 0;
+  if ( m_IsCheckerboard )
+    {
+    for ( unsigned int d = 0; d < InputImageDimension; ++d )
+      {
+      color += static_cast< unsigned int >( index[d] );
+      }
+    return color % 2;
+    }
+  //The residues are non-negative, since the index may be negative
+  for ( unsigned int d = InputImageDimension; d > 0; --d )
+    {
+    const auto numberOfColors = static_cast< IndexValueType >( m_NumberOfColorsPerDimension[d - 1] );
+    color = color * m_NumberOfColorsPerDimension[d - 1]
+            + static_cast< unsigned int >( ( ( index[d - 1] % numberOfColors ) + numberOfColors ) % numberOfColors );
+    }
+  return color;
+} // GetColor
+
+//-------------------------------------------------------
+//-------------------------------------------------------
+//The ICM algorithm, color by color
+//-------------------------------------------------------
+template< typename TInputImage, typename TClassifiedImage >
+void
+MRFImageFilter< TInputImage, TClassifiedImage >
+::ApplyColoredICMLabeller()
+{
+  LabelledImagePointer          labelledImage = m_ClassifierPtr->GetClassifiedImage();
+  const LabelledImageRegionType interior =
+    LabelledImageFacesCalculator()( labelledImage, labelledImage->GetBufferedRegion(),
+                                    m_LabelledImageNeighborhoodRadius ).front();
+  if ( interior.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  //The rows of the interior, from which each thread visits the pixels of
+  //the current color
+  LabelledImageRegionType rows = interior;
+  rows.SetSize(0, 1);
+  const IndexValueType firstX = interior.GetIndex(0);
+  const IndexValueType endX = firstX + static_cast< IndexValueType >( interior.GetSize(0) );
+  const IndexValueType step = m_NumberOfColorsPerDimension[0];
+
+  LabelledImagePixelType *labels = labelledImage->GetBufferPointer();
+  const unsigned int      numberOfClasses = m_NumberOfClasses;
+  const auto              numberOfColors = static_cast< unsigned int >( m_LaterNeighborOffsets.size() );
+  const auto              numberOfNeighbors = static_cast< unsigned int >( m_WeightedNeighborOffsets.size() );
+
+  //After the first iteration, the flags of the neighbors of a pixel with
+  //an earlier color are those of this iteration, and those of the
+  //neighbors with a later color those of the previous iteration, so a
+  //pixel without a changed neighbor keeps its label
+  const bool isFirstIteration = ( m_NumberOfIterations == 0 );
+
+  MultiThreaderBase *multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  for ( unsigned int color = 0; color < numberOfColors; ++color )
+    {
+    multiThreader->template ParallelizeImageRegion< InputImageDimension >(
+      rows,
+      [&](const LabelledImageRegionType & region)
+      {
+        std::vector< double > neighborInfluence(numberOfClasses);
+        for ( ImageRegionConstIteratorWithIndex< TClassifiedImage > it( labelledImage, region ); !it.IsAtEnd(); ++it )
+          {
+          //The first pixel of the color in the row, if any
+          LabelledImageIndexType index = it.GetIndex();
+          while ( index[0] < firstX + step && this->GetColor(index) != color )
+            {
+            ++index[0];
+            }
+          if ( index[0] == firstX + step )
+            {
+            continue;
+            }
+          const OffsetValueType rowOffset = labelledImage->ComputeOffset(index) - index[0];
+
+          for ( ; index[0] < endX; index[0] += step )
+            {
+            const OffsetValueType offset = rowOffset + index[0];
+
+            if ( !isFirstIteration )
+              {
+              unsigned char isNeighborChanged = 0;
+              for ( unsigned int n = 0; n < numberOfNeighbors; ++n )
+                {
+                isNeighborChanged |= m_IsLabelChanged[offset + m_WeightedNeighborOffsets[n]];
+                }
+              if ( !isNeighborChanged )
+                {
+                m_IsLabelChanged[offset] = 0;
+                continue;
+                }
+              }
+
+            //The influence of the neighbors, and the distance to each class
+            std::fill(neighborInfluence.begin(), neighborInfluence.end(), 0.0);
+            for ( unsigned int n = 0; n < numberOfNeighbors; ++n )
+              {
+              neighborInfluence[static_cast< unsigned int >( labels[offset + m_WeightedNeighborOffsets[n]] )] +=
+                m_WeightedNeighborWeights[n];
+              }
+            const double *pixelMembershipValue = &m_PixelMembershipValues[offset * numberOfClasses];
+            double        maximumDistance = -1e+20;
+            int           pixLabel = -1;
+            for ( unsigned int classIndex = 0; classIndex < numberOfClasses; ++classIndex )
+              {
+              const double pixDistance = neighborInfluence[classIndex] - pixelMembershipValue[classIndex];
+              if ( pixDistance > maximumDistance )
+                {
+                maximumDistance = pixDistance;
+                pixLabel = classIndex;
+                }
+              }
+
+            const bool isLabelChanged = ( pixLabel != static_cast< int >( labels[offset] ) );
+            if ( isLabelChanged )
+              {
+              labels[offset] = static_cast< LabelledImagePixelType >( pixLabel );
+              }
+            m_IsLabelChanged[offset] = isLabelChanged;
+            }
+          }
+      },
+      nullptr );
+    }
+
+  //A pixel is to be reexamined when its label, or the label of a neighbor
+  //visited after it, has changed
+  int *labelStatus = m_LabelStatusImage->GetBufferPointer();
+  multiThreader->template ParallelizeImageRegion< InputImageDimension >(
+    rows,
+    [&](const LabelledImageRegionType & region)
+    {
+      std::vector< unsigned int > rowColors(step);
+      for ( ImageRegionConstIteratorWithIndex< TClassifiedImage > it( labelledImage, region ); !it.IsAtEnd(); ++it )
+        {
+        //The colors along the row repeat every step pixels
+        LabelledImageIndexType index = it.GetIndex();
+        for ( IndexValueType i = 0; i < step; ++i, ++index[0] )
+          {
+          rowColors[i] = this->GetColor(index);
+          }
+        const OffsetValueType rowOffset = labelledImage->ComputeOffset( it.GetIndex() ) - firstX;
+        for ( IndexValueType x = firstX, i = 0; x < endX; ++x, i = ( i + 1 == step ? 0 : i + 1 ) )
+          {
+          const OffsetValueType offset = rowOffset + x;
+          unsigned char         isChanged = m_IsLabelChanged[offset];
+          for ( OffsetValueType neighborOffset : m_LaterNeighborOffsets[rowColors[i]] )
+            {
+            isChanged |= m_IsLabelChanged[offset + neighborOffset];
+            }
+          labelStatus[offset] = isChanged ? 1 : 0;
+          }
+        }
+    },
+    nullptr );
+} // ApplyColoredICMLabeller
+
 //-------------------------------------------------------
 //-------------------------------------------------------
 //Function that performs the MRF operation with each neighborhood
@@ -0,0 +1,215 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMRFImageFilter.h"
+#include "itkMahalanobisDistanceMembershipFunction.h"
+#include "itkMinimumDecisionRule.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+constexpr unsigned int NumberOfClasses = 3;
+
+// Label noisy images of blocks of 3 classes with the colored update, for
+// several numbers of threads, and compare with the ICM computed color by
+// color, one pixel at a time. The region may start at a negative index.
+template< unsigned int VDimension >
+bool TestColoredUpdate( const itk::Index< VDimension > & start, const itk::Size< VDimension > & size,
+                        const std::vector< double > & weights, bool isCheckerboard )
+{
+  using VectorType = itk::Vector< double, 1 >;
+  using InputImageType = itk::Image< VectorType, VDimension >;
+  using LabelImageType = itk::Image< unsigned short, VDimension >;
+  using IndexType = typename LabelImageType::IndexType;
+
+  // the input
+  typename InputImageType::RegionType region( start, size );
+  auto input = InputImageType::New();
+  input->SetRegions( region );
+  input->Allocate();
+  using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  typename GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 2018 );
+  const double means[NumberOfClasses] = { 0.0, 10.0, 20.0 };
+  for( itk::ImageRegionIteratorWithIndex< InputImageType > it( input, region ); !it.IsAtEnd(); ++it )
+    {
+    itk::IndexValueType sum = 0;
+    for( unsigned int d = 0; d < VDimension; ++d )
+      {
+      sum += ( it.GetIndex()[d] - start[d] ) / 7;
+      }
+    VectorType value;
+    value[0] = means[sum % NumberOfClasses] + 7.0 * generator->GetNormalVariate();
+    it.Set( value );
+    }
+
+  // the classifier
+  using MembershipFunctionType = itk::Statistics::MahalanobisDistanceMembershipFunction< VectorType >;
+  using ClassifierType = itk::ImageClassifierBase< InputImageType, LabelImageType >;
+  typename ClassifierType::Pointer classifier = ClassifierType::New();
+  classifier->SetNumberOfClasses( NumberOfClasses );
+  classifier->SetDecisionRule( itk::Statistics::MinimumDecisionRule::New() );
+  std::vector< typename MembershipFunctionType::Pointer > membershipFunctions;
+  for( double mean : means )
+    {
+    typename MembershipFunctionType::Pointer membershipFunction = MembershipFunctionType::New();
+    typename MembershipFunctionType::MeanVectorType meanVector;
+    meanVector[0] = mean;
+    membershipFunction->SetMean( meanVector );
+    typename MembershipFunctionType::CovarianceMatrixType covariance( 1, 1 );
+    covariance( 0, 0 ) = 36.0;
+    membershipFunction->SetCovariance( covariance );
+    membershipFunctions.push_back( membershipFunction );
+    classifier->AddMembershipFunction( membershipFunction );
+    }
+
+  using FilterType = itk::MRFImageFilter< InputImageType, LabelImageType >;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( input );
+  filter->SetNumberOfClasses( NumberOfClasses );
+  filter->SetMaximumNumberOfIterations( 20 );
+  filter->SetErrorTolerance( 0.0 );
+  filter->SetNeighborhoodRadius( 1 );
+  filter->SetMRFNeighborhoodWeight( weights );
+  filter->SetClassifier( classifier );
+  filter->UseColoredUpdateOn();
+  const std::vector< double > neighborhoodWeight = filter->GetMRFNeighborhoodWeight();
+
+  // the reference: the membership values, the initial labels, and the
+  // labels of the pixels of each color updated in raster order
+  typename LabelImageType::Pointer expected = LabelImageType::New();
+  expected->SetRegions( region );
+  expected->Allocate();
+  itk::ImageRegionConstIteratorWithIndex< InputImageType > inIt( input, region );
+  for( ; !inIt.IsAtEnd(); ++inIt )
+    {
+    unsigned int label = 0;
+    for( unsigned int c = 1; c < NumberOfClasses; ++c )
+      {
+      if( membershipFunctions[c]->Evaluate( inIt.Get() ) < membershipFunctions[label]->Evaluate( inIt.Get() ) )
+        {
+        label = c;
+        }
+      }
+    expected->SetPixel( inIt.GetIndex(), label );
+    }
+  typename LabelImageType::RegionType interior = region;
+  interior.ShrinkByRadius( 1 );
+  // the colors are relative to the start of the region
+  const auto color = [&](const IndexType & index)
+    {
+    unsigned int value = 0;
+    for( unsigned int d = VDimension; d > 0; --d )
+      {
+      const auto residue = static_cast< unsigned int >( ( index[d - 1] - start[d - 1] ) % 2 );
+      value = isCheckerboard ? value + residue : 2 * value + residue;
+      }
+    return isCheckerboard ? value % 2 : value;
+    };
+  unsigned int expectedIterations = 0;
+  bool isChanged = true;
+  while( isChanged && expectedIterations < filter->GetMaximumNumberOfIterations() )
+    {
+    isChanged = false;
+    for( unsigned int c = 0; c < ( isCheckerboard ? 2u : 1u << VDimension ); ++c )
+      {
+      itk::ImageRegionIteratorWithIndex< LabelImageType > it( expected, interior );
+      for( ; !it.IsAtEnd(); ++it )
+        {
+        if( color( it.GetIndex() ) != c )
+          {
+          continue;
+          }
+        std::vector< double > distances( NumberOfClasses, 0.0 );
+        for( unsigned int i = 0; i < neighborhoodWeight.size(); ++i )
+          {
+          IndexType neighbor = it.GetIndex();
+          unsigned int position = i;
+          for( unsigned int d = 0; d < VDimension; ++d )
+            {
+            neighbor[d] += static_cast< itk::IndexValueType >( position % 3 ) - 1;
+            position /= 3;
+            }
+          distances[expected->GetPixel( neighbor )] += neighborhoodWeight[i];
+          }
+        for( unsigned int k = 0; k < NumberOfClasses; ++k )
+          {
+          distances[k] -= membershipFunctions[k]->Evaluate( input->GetPixel( it.GetIndex() ) );
+          }
+        const auto label = static_cast< unsigned short >(
+          std::max_element( distances.begin(), distances.end() ) - distances.begin() );
+        isChanged = isChanged || label != it.Get();
+        it.Set( label );
+        }
+      }
+    ++expectedIterations;
+    }
+
+  bool passed = true;
+  for( unsigned int threads = 1; threads < 8; threads += 3 )
+    {
+    filter->SetNumberOfThreads( threads );
+    filter->Modified();
+    TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+    unsigned int differences = 0;
+    itk::ImageRegionConstIteratorWithIndex< LabelImageType > eIt( expected, region );
+    for( ; !eIt.IsAtEnd(); ++eIt )
+      {
+      differences += ( filter->GetOutput()->GetPixel( eIt.GetIndex() ) != eIt.Get() );
+      }
+    std::cout << VDimension << "D, start " << start << ", " << threads << " threads: " << filter->GetNumberOfIterations()
+              << " iterations, " << differences << " differences" << std::endl;
+    passed = passed && differences == 0 && filter->GetNumberOfIterations() == expectedIterations
+             && filter->GetStopCondition() == ( isChanged ? FilterType::MaximumNumberOfIterations
+                                                           : FilterType::ErrorTolerance );
+    }
+  return passed;
+}
+}
+
+int itkMRFImageFilterTest2( int, char * [] )
+{
+  using FilterType = itk::MRFImageFilter< itk::Image< itk::Vector< double, 1 >, 3 >, itk::Image< unsigned short, 3 > >;
+  FilterType::Pointer filter = FilterType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( filter, MRFImageFilter, ImageToImageFilter );
+  TEST_SET_GET_BOOLEAN( filter, UseColoredUpdate, false );
+
+  bool passed = true;
+
+  // the default weights, on the 26 neighbors: 8 colors
+  itk::Index< 3 > start3D = {{ 0, 0, 0 }};
+  itk::Size< 3 > size3D = {{ 23, 19, 16 }};
+  passed = TestColoredUpdate< 3 >( start3D, size3D, std::vector< double >(), false ) && passed;
+
+  // the weights of the 4 neighbors: a checkerboard
+  itk::Index< 2 > start2D = {{ 0, 0 }};
+  itk::Size< 2 > size2D = {{ 41, 37 }};
+  const std::vector< double > weights = { 0.0, 1.2, 0.0, 1.2, 0.0, 1.2, 0.0, 1.2, 0.0 };
+  passed = TestColoredUpdate< 2 >( start2D, size2D, weights, true ) && passed;
+
+  // regions with a negative index
+  start3D[0] = -7;
+  start3D[2] = -12;
+  passed = TestColoredUpdate< 3 >( start3D, size3D, std::vector< double >(), false ) && passed;
+  start2D[1] = -5;
+  passed = TestColoredUpdate< 2 >( start2D, size2D, weights, true ) && passed;
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
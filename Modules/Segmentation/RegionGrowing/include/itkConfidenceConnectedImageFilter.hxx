@@ -25,9 +25,11 @@
 #include "itkMeanImageFunction.h"
 #include "itkSumOfSquaresImageFunction.h"
 #include "itkBinaryThresholdImageFunction.h"
-#include "itkFloodFilledImageFunctionConditionalIterator.h"
+#include "itkScanlineFloodFiller.h"
 #include "itkProgressReporter.h"
 
+#include <mutex>
+
 namespace itk
 {
 /**
@@ -139,10 +141,8 @@ ConfidenceConnectedImageFilter< TInputImage, TOutputImage >
 ::GenerateData()
 {
   using FunctionType = BinaryThresholdImageFunction< InputImageType, double >;
-  using SecondFunctionType = BinaryThresholdImageFunction< OutputImageType, double >;
 
-  using IteratorType = FloodFilledImageFunctionConditionalIterator< OutputImageType, FunctionType >;
-  using SecondIteratorType = FloodFilledImageFunctionConditionalConstIterator< InputImageType, SecondFunctionType >;
+  using FillerType = ScanlineFloodFiller< OutputImageType >;
 
   unsigned int loop;
 
@@ -300,51 +300,64 @@ ConfidenceConnectedImageFilter< TInputImage, TOutputImage >
     << "\nLower intensity = " << lower << ", Upper intensity = " << upper << "\nmean = " << m_Mean
     << " , std::sqrt(variance) = " << std::sqrt(m_Variance) );
 
-  // Segment the image, the iterator walks the output image (so Set()
-  // writes into the output image), starting at the seed point.  As
-  // the iterator walks, if the corresponding pixel in the input image
-  // (accessed via the "function" assigned to the iterator) is within
-  // the [lower, upper] bounds prescribed, the pixel is added to the
-  // output segmentation and its neighbors become candidates for the
-  // iterator to walk.
-  IteratorType it = IteratorType (outputImage, function, m_Seeds);
-  it.GoToBegin();
-  while ( !it.IsAtEnd() )
-    {
-    it.Set(m_ReplaceValue);
-    ++it;
-    }
+  // Segment the image, the filler fills the output image starting at
+  // the seed points.  If the corresponding pixel in the input image
+  // (accessed via the "function" used as condition) is within the
+  // [lower, upper] bounds prescribed, the pixel is added to the output
+  // segmentation and its neighbors become candidates for the fill.
+  typename FillerType::Pointer filler = FillerType::New();
+  filler->SetMultiThreader( this->GetMultiThreader() );
+  filler->SetNumberOfThreads( this->GetNumberOfThreads() );
+  filler->SetReplaceValue( m_ReplaceValue );
+  auto condition = [&function]( const IndexType & index ) { return function->EvaluateAtIndex( index ); };
+  filler->Fill( outputImage, m_Seeds, condition );
 
-  ProgressReporter progress(this, 0, region.GetNumberOfPixels() * m_NumberOfIterations);
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+  std::mutex          mutex;
+
+  ProgressReporter progress(this, 0, m_NumberOfIterations);
 
   for ( loop = 0; loop < m_NumberOfIterations; ++loop )
     {
     // Now that we have an initial segmentation, let's recalculate the
     // statistics.  Since we have already labelled the output, we visit
     // pixels in the input image that have been set in the output image.
-    // Essentially, we flip the iterator around, so we walk the input
-    // image (so Get() will get pixel values from the input) and constrain
-    // iterator such it only visits pixels that were set in the output.
-    typename SecondFunctionType::Pointer secondFunction = SecondFunctionType::New();
-    secondFunction->SetInputImage (outputImage);
-    secondFunction->ThresholdBetween(m_ReplaceValue, m_ReplaceValue);
-
+    // All of them are connected to the seeds, so they are found in one
+    // pass over the region, split between the threads.
     typename NumericTraits< typename InputImageType::PixelType >::RealType sum, sumOfSquares;
     sum = NumericTraits< InputRealType >::ZeroValue();
     sumOfSquares = NumericTraits< InputRealType >::ZeroValue();
     typename TOutputImage::SizeValueType numberOfSamples = 0;
 
-    SecondIteratorType sit =
-      SecondIteratorType (inputImage, secondFunction, m_Seeds);
-    sit.GoToBegin();
-    while ( !sit.IsAtEnd() )
-      {
-      const auto value = static_cast< InputRealType >( sit.Get() );
-      sum += value;
-      sumOfSquares += value * value;
-      ++numberOfSamples;
-      ++sit;
-      }
+    multiThreader->template ParallelizeImageRegion< OutputImageType::ImageDimension >(
+      region,
+      [&]( const OutputImageRegionType & subRegion )
+        {
+        InputRealType threadSum = NumericTraits< InputRealType >::ZeroValue();
+        InputRealType threadSumOfSquares = NumericTraits< InputRealType >::ZeroValue();
+        SizeValueType threadNumberOfSamples = 0;
+
+        ImageRegionConstIterator< InputImageType > iIt( inputImage, subRegion );
+        ImageRegionConstIterator< OutputImageType > oIt( outputImage, subRegion );
+        for ( ; !oIt.IsAtEnd(); ++iIt, ++oIt )
+          {
+          if ( oIt.Get() == m_ReplaceValue )
+            {
+            const auto value = static_cast< InputRealType >( iIt.Get() );
+            threadSum += value;
+            threadSumOfSquares += value * value;
+            ++threadNumberOfSamples;
+            }
+          }
+
+        std::lock_guard< std::mutex > lock( mutex );
+        sum += threadSum;
+        sumOfSquares += threadSumOfSquares;
+        numberOfSamples += threadNumberOfSamples;
+        },
+      nullptr );
+
     m_Mean      = sum / double(numberOfSamples);
     m_Variance  = ( sumOfSquares - ( sum * sum / double(numberOfSamples) ) ) / ( double(numberOfSamples) - 1.0 );
     // if the variance is zero, there is no point in continuing
@@ -396,24 +409,12 @@ ConfidenceConnectedImageFilter< TInputImage, TOutputImage >
                    << " , std::sqrt(variance) = " << std::sqrt(m_Variance) );
     itkDebugMacro(<< "\nsum = " << sum << ", sumOfSquares = " << sumOfSquares << "\nnum = " << numberOfSamples);
 
-    // Rerun the segmentation, the iterator walks the output image,
-    // starting at the seed point.  As the iterator walks, if the
-    // corresponding pixel in the input image (accessed via the
-    // "function" assigned to the iterator) is within the [lower,
-    // upper] bounds prescribed, the pixel is added to the output
-    // segmentation and its neighbors become candidates for the
-    // iterator to walk.
+    // Rerun the segmentation with the new bounds.
     outputImage->FillBuffer (NumericTraits< OutputImagePixelType >::ZeroValue());
-    IteratorType thirdIt = IteratorType (outputImage, function, m_Seeds);
-    thirdIt.GoToBegin();
+    filler->Fill( outputImage, m_Seeds, condition );
     try
       {
-      while ( !thirdIt.IsAtEnd() )
-        {
-        thirdIt.Set(m_ReplaceValue);
-        ++thirdIt;
-        progress.CompletedPixel();  // potential exception thrown here
-        }
+      progress.CompletedPixel();  // potential exception thrown here
       }
     catch ( ProcessAborted & )
       {
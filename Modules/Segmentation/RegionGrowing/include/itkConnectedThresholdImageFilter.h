@@ -30,6 +30,9 @@ namespace itk
  * connected to an initial Seed AND lie within a Lower and Upper
  * threshold range.
  *
+ * The pixels are filled by spans along the first dimension, and the spans
+ * of the front are processed by several threads. See ScanlineFloodFiller.
+ *
  * \ingroup RegionGrowingSegmentation
  * \ingroup ITKRegionGrowing
  */
@@ -20,10 +20,8 @@
 
 #include "itkConnectedThresholdImageFilter.h"
 #include "itkBinaryThresholdImageFunction.h"
-#include "itkFloodFilledImageFunctionConditionalIterator.h"
+#include "itkScanlineFloodFiller.h"
 #include "itkProgressReporter.h"
-
-#include "itkShapedFloodFilledImageFunctionConditionalIterator.h"
 #include "itkMath.h"
 
 namespace itk
@@ -264,40 +262,19 @@ ConnectedThresholdImageFilter< TInputImage, TOutputImage >
   function->SetInputImage( inputImage );
   function->ThresholdBetween( lower, upper );
 
-  ProgressReporter progress( this, 0, region.GetNumberOfPixels() );
-
-  if ( this->m_Connectivity == FaceConnectivity )
-    {
-    using IteratorType = FloodFilledImageFunctionConditionalIterator< OutputImageType, FunctionType >;
-    IteratorType it (outputImage, function, m_Seeds);
-    it.GoToBegin();
-
-    while ( !it.IsAtEnd() )
-      {
-      it.Set(m_ReplaceValue);
-      ++it;
-      progress.CompletedPixel();  // potential exception thrown here
-      }
-    }
-  else if ( this->m_Connectivity == FullConnectivity )
-    {
-    // Use the fully connected iterator here. The fully connected iterator
-    // below is a superset of the above. However, it is reported to be 20%
-    // slower. Hence we use this "if" block to use the old iterator when
-    // we don't need full connectivity.
-
-    using IteratorType = ShapedFloodFilledImageFunctionConditionalIterator< OutputImageType, FunctionType >;
-    IteratorType it (outputImage, function, m_Seeds);
-    it.FullyConnectedOn();
-    it.GoToBegin();
-
-    while ( !it.IsAtEnd() )
-      {
-      it.Set(m_ReplaceValue);
-      ++it;
-      progress.CompletedPixel();  // potential exception thrown here
-      }
-    }
+  // Fill the pixels from the seeds by spans, in parallel. The fully
+  // connected flood is a superset of the face connected one.
+  using FillerType = ScanlineFloodFiller< OutputImageType >;
+  typename FillerType::Pointer filler = FillerType::New();
+  filler->SetMultiThreader( this->GetMultiThreader() );
+  filler->SetNumberOfThreads( this->GetNumberOfThreads() );
+  filler->SetReplaceValue( m_ReplaceValue );
+  filler->SetFullyConnected( this->m_Connectivity == FullConnectivity );
+
+  ProgressReporter progress( this, 0, 1 );
+  filler->Fill( outputImage, m_Seeds,
+                [&function]( const IndexType & index ) { return function->EvaluateAtIndex( index ); } );
+  progress.CompletedPixel();
 }
 
 template< typename TInputImage, typename TOutputImage >
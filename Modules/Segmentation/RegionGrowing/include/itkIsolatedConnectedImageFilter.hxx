@@ -20,7 +20,7 @@
 
 #include "itkIsolatedConnectedImageFilter.h"
 #include "itkBinaryThresholdImageFunction.h"
-#include "itkFloodFilledImageFunctionConditionalIterator.h"
+#include "itkScanlineFloodFiller.h"
 #include "itkProgressReporter.h"
 #include "itkIterationReporter.h"
 #include "itkMath.h"
@@ -217,16 +217,25 @@ IsolatedConnectedImageFilter< TInputImage, TOutputImage >
   outputImage->FillBuffer (NumericTraits< OutputImagePixelType >::ZeroValue());
 
   using FunctionType = BinaryThresholdImageFunction< InputImageType >;
-  using IteratorType = FloodFilledImageFunctionConditionalIterator< OutputImageType, FunctionType >;
+  using FillerType = ScanlineFloodFiller< OutputImageType >;
 
   typename FunctionType::Pointer function = FunctionType::New();
   function->SetInputImage (inputImage);
 
   float             progressWeight = 0.0f;
   float             cumulatedProgress = 0.0f;
-  IteratorType      it = IteratorType (outputImage, function, m_Seeds1);
   IterationReporter iterate(this, 0, 1);
 
+  // The same filler, and its set of visited pixels, is used for all the
+  // fills. During the search, a fill is stopped as soon as it reaches the
+  // first of the second seeds.
+  typename FillerType::Pointer filler = FillerType::New();
+  filler->SetMultiThreader( this->GetMultiThreader() );
+  filler->SetNumberOfThreads( this->GetNumberOfThreads() );
+  filler->SetReplaceValue( m_ReplaceValue );
+  filler->SetStopIndex( *m_Seeds2.begin() );
+  auto condition = [&function]( const IndexType & index ) { return function->EvaluateAtIndex( index ); };
+
   // If the upper threshold has not been set, find it.
   if ( m_FindUpperThreshold )
     {
@@ -245,21 +254,13 @@ IsolatedConnectedImageFilter< TInputImage, TOutputImage >
 
     while ( lower + m_IsolatedValueTolerance < guess )
       {
-      ProgressReporter progress(this, 0, region.GetNumberOfPixels(), 100, cumulatedProgress, progressWeight);
+      ProgressReporter progress(this, 0, 1, 100, cumulatedProgress, progressWeight);
       cumulatedProgress += progressWeight;
       outputImage->FillBuffer (NumericTraits< OutputImagePixelType >::ZeroValue());
       function->ThresholdBetween ( m_Lower, static_cast< InputImagePixelType >( guess ) );
-      it.GoToBegin();
-      while ( !it.IsAtEnd() )
-        {
-        it.Set(m_ReplaceValue);
-        if ( it.GetIndex() == *m_Seeds2.begin() )
-          {
-          break;
-          }
-        ++it;
-        progress.CompletedPixel(); // potential exception thrown here
-        }
+      filler->StopAtIndexOn();
+      filler->Fill( outputImage, m_Seeds1, condition );
+      progress.CompletedPixel(); // potential exception thrown here
       // If any of second seeds are included, decrease the upper bound.
       // Find the sum of the intensities in m_Seeds2.  If the second
       // seeds are not included, the sum should be zero.  Otherwise,
@@ -310,21 +311,13 @@ IsolatedConnectedImageFilter< TInputImage, TOutputImage >
 
     while ( guess < upper - m_IsolatedValueTolerance )
       {
-      ProgressReporter progress(this, 0, region.GetNumberOfPixels(), 100, cumulatedProgress, progressWeight);
+      ProgressReporter progress(this, 0, 1, 100, cumulatedProgress, progressWeight);
       cumulatedProgress += progressWeight;
       outputImage->FillBuffer (NumericTraits< OutputImagePixelType >::ZeroValue());
       function->ThresholdBetween (static_cast< InputImagePixelType >( guess ), m_Upper);
-      it.GoToBegin();
-      while ( !it.IsAtEnd() )
-        {
-        it.Set(m_ReplaceValue);
-        if ( it.GetIndex() == *m_Seeds2.begin() )
-          {
-          break;
-          }
-        ++it;
-        progress.CompletedPixel(); // potential exception thrown here
-        }
+      filler->StopAtIndexOn();
+      filler->Fill( outputImage, m_Seeds1, condition );
+      progress.CompletedPixel(); // potential exception thrown here
       // If any of second seeds are included, increase the lower bound.
       // Find the sum of the intensities in m_Seeds2.  If the second
       // seeds are not included, the sum should be zero.  Otherwise,
@@ -360,7 +353,7 @@ IsolatedConnectedImageFilter< TInputImage, TOutputImage >
     }
 
   // now rerun the algorithm with the thresholds that separate the seeds.
-  ProgressReporter progress(this, 0, region.GetNumberOfPixels(), 100, cumulatedProgress, progressWeight);
+  ProgressReporter progress(this, 0, 1, 100, cumulatedProgress, progressWeight);
 
   outputImage->FillBuffer (NumericTraits< OutputImagePixelType >::ZeroValue());
   if ( m_FindUpperThreshold )
@@ -371,13 +364,9 @@ IsolatedConnectedImageFilter< TInputImage, TOutputImage >
     {
     function->ThresholdBetween (m_IsolatedValue, m_Upper);
     }
-  it.GoToBegin();
-  while ( !it.IsAtEnd() )
-    {
-    it.Set(m_ReplaceValue);
-    ++it;
-    progress.CompletedPixel(); // potential exception thrown here
-    }
+  filler->StopAtIndexOff();
+  filler->Fill( outputImage, m_Seeds1, condition );
+  progress.CompletedPixel(); // potential exception thrown here
 
   // If any of the second seeds are included or some of the first
   // seeds are not included, the algorithm could not find any threshold
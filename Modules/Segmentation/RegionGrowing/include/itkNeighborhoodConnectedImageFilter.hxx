@@ -20,7 +20,7 @@
 
 #include "itkNeighborhoodConnectedImageFilter.h"
 #include "itkNeighborhoodBinaryThresholdImageFunction.h"
-#include "itkFloodFilledImageFunctionConditionalIterator.h"
+#include "itkScanlineFloodFiller.h"
 #include "itkProgressReporter.h"
 
 namespace itk
@@ -126,22 +126,24 @@ NeighborhoodConnectedImageFilter< TInputImage, TOutputImage >
   outputImage->FillBuffer (NumericTraits< OutputImagePixelType >::ZeroValue());
 
   using FunctionType = NeighborhoodBinaryThresholdImageFunction< InputImageType >;
-  using IteratorType = FloodFilledImageFunctionConditionalIterator< OutputImageType, FunctionType >;
+  using FillerType = ScanlineFloodFiller< OutputImageType >;
 
   typename FunctionType::Pointer function = FunctionType::New();
   function->SetInputImage (inputImage);
   function->ThresholdBetween (m_Lower, m_Upper);
   function->SetRadius (m_Radius);
-  IteratorType it = IteratorType (outputImage, function, m_Seeds);
 
-  ProgressReporter progress( this, 0,
-                             outputImage->GetRequestedRegion().GetNumberOfPixels() );
-  while ( !it.IsAtEnd() )
-    {
-    it.Set(m_ReplaceValue);
-    ++it;
-    progress.CompletedPixel();
-    }
+  // The seeds are filled whether or not their neighborhood is in the range
+  typename FillerType::Pointer filler = FillerType::New();
+  filler->SetMultiThreader( this->GetMultiThreader() );
+  filler->SetNumberOfThreads( this->GetNumberOfThreads() );
+  filler->SetReplaceValue( m_ReplaceValue );
+  filler->TestSeedsOff();
+
+  ProgressReporter progress( this, 0, 1 );
+  filler->Fill( outputImage, m_Seeds,
+                [&function]( const IndexType & index ) { return function->EvaluateAtIndex( index ); } );
+  progress.CompletedPixel();
 }
 } // end namespace itk
 
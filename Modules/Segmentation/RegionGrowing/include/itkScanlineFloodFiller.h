@@ -0,0 +1,178 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScanlineFloodFiller_h
+#define itkScanlineFloodFiller_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreaderBase.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace itk
+{
+/** \class ScanlineFloodFiller
+ * \brief Fills the pixels connected to seeds which satisfy a condition.
+ *
+ * ScanlineFloodFiller sets to ReplaceValue the pixels of an image which
+ * satisfy a condition and are connected to one of the seeds through
+ * pixels which also satisfy it. It produces the same pixels as
+ * FloodFilledImageFunctionConditionalIterator, with face connectivity,
+ * and as ShapedFloodFilledImageFunctionConditionalIterator, with full
+ * connectivity, but:
+ *
+ * \li the pixels are filled by spans along the first dimension, and the
+ *   spans of the neighbor lines are searched once per span instead of once
+ *   per pixel;
+ * \li the pixels which have already been tested are stored in a set with
+ *   one bit per pixel instead of a temporary image, and this set is kept
+ *   from one call to the next;
+ * \li the spans of the front are processed concurrently. Each pixel is
+ *   tested by the thread which first sets its bit, so the condition is
+ *   evaluated once per pixel, and the filled pixels do not depend on the
+ *   number of threads.
+ *
+ * The condition is a callable taking the index of a pixel and returning
+ * whether the pixel can be filled, for example the EvaluateAtIndex() method
+ * of an image function. It is called concurrently, so it must be thread
+ * safe.
+ *
+ * \sa FloodFilledImageFunctionConditionalIterator
+ * \sa ShapedFloodFilledImageFunctionConditionalIterator
+ *
+ * \ingroup RegionGrowingSegmentation
+ * \ingroup ITKRegionGrowing
+ */
+template< typename TImage >
+class ITK_TEMPLATE_EXPORT ScanlineFloodFiller:
+  public Object
+{
+public:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ScanlineFloodFiller);
+
+  /** Standard class type aliases. */
+  using Self = ScanlineFloodFiller;
+  using Superclass = Object;
+  using Pointer = SmartPointer< Self >;
+  using ConstPointer = SmartPointer< const Self >;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ScanlineFloodFiller, Object);
+
+  using ImageType = TImage;
+  using PixelType = typename ImageType::PixelType;
+  using IndexType = typename ImageType::IndexType;
+  using OffsetType = typename ImageType::OffsetType;
+  using RegionType = typename ImageType::RegionType;
+  using SeedContainerType = std::vector< IndexType >;
+
+  static constexpr unsigned int ImageDimension = ImageType::ImageDimension;
+
+  /** Set/Get the value of the filled pixels. Default is 1. */
+  itkSetMacro(ReplaceValue, PixelType);
+  itkGetConstMacro(ReplaceValue, PixelType);
+
+  /** Set/Get whether the pixels are connected through their faces only, or
+   * through their faces, edges and vertices. Default is false. */
+  itkSetMacro(FullyConnected, bool);
+  itkGetConstReferenceMacro(FullyConnected, bool);
+  itkBooleanMacro(FullyConnected);
+
+  /** Set/Get whether the seeds are filled only when they satisfy the
+   * condition. When false, the seeds are always filled, and the fill starts
+   * from them. Default is true. */
+  itkSetMacro(TestSeeds, bool);
+  itkGetConstReferenceMacro(TestSeeds, bool);
+  itkBooleanMacro(TestSeeds);
+
+  /** Set/Get an index where the fill is stopped as soon as it is filled.
+   * The other pixels filled at this point are undefined. Only used when
+   * StopAtIndex is true. */
+  itkSetMacro(StopIndex, IndexType);
+  itkGetConstReferenceMacro(StopIndex, IndexType);
+  itkSetMacro(StopAtIndex, bool);
+  itkGetConstReferenceMacro(StopAtIndex, bool);
+  itkBooleanMacro(StopAtIndex);
+
+  /** Set/Get the multithreader and the number of threads used to fill. By
+   * default, a new multithreader with its default number of threads is
+   * used. */
+  itkSetObjectMacro(MultiThreader, MultiThreaderBase);
+  itkGetModifiableObjectMacro(MultiThreader, MultiThreaderBase);
+  itkSetMacro(NumberOfThreads, ThreadIdType);
+  itkGetConstMacro(NumberOfThreads, ThreadIdType);
+
+  /** Fill the pixels of the buffered region of image connected to the seeds
+   * which satisfy condition. The other pixels are not modified. Returns the
+   * number of filled pixels. */
+  template< typename TCondition >
+  SizeValueType Fill( ImageType * image, const SeedContainerType & seeds, const TCondition & condition );
+
+protected:
+  ScanlineFloodFiller();
+  ~ScanlineFloodFiller() override {}
+
+  void PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** A run of filled pixels along the first dimension, from m_Start to
+   * m_Last included. */
+  struct Span
+  {
+    IndexType      m_Start;
+    IndexValueType m_Last;
+  };
+  using SpanContainerType = std::vector< Span >;
+
+  /** Set the bit of a pixel. Returns true if the bit was not already set. */
+  bool Claim( OffsetValueType offset )
+  {
+    const std::uint64_t bit = std::uint64_t( 1 ) << ( offset & 63 );
+    std::atomic< std::uint64_t > & word = m_Visited[offset >> 6];
+    if ( word.load( std::memory_order_relaxed ) & bit )
+      {
+      return false;
+      }
+    return !( word.fetch_or( bit, std::memory_order_relaxed ) & bit );
+  }
+
+private:
+  PixelType   m_ReplaceValue;
+  bool        m_FullyConnected;
+  bool        m_TestSeeds;
+  IndexType   m_StopIndex;
+  bool        m_StopAtIndex;
+
+  MultiThreaderBase::Pointer m_MultiThreader;
+  ThreadIdType               m_NumberOfThreads;
+
+  std::unique_ptr< std::atomic< std::uint64_t >[] > m_Visited;
+  SizeValueType                                     m_VisitedSize;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkScanlineFloodFiller.hxx"
+#endif
+
+#endif
@@ -0,0 +1,304 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScanlineFloodFiller_hxx
+#define itkScanlineFloodFiller_hxx
+
+#include "itkScanlineFloodFiller.h"
+#include "itkNumericTraits.h"
+
+#include <mutex>
+
+namespace itk
+{
+template< typename TImage >
+ScanlineFloodFiller< TImage >
+::ScanlineFloodFiller() :
+  m_ReplaceValue( NumericTraits< PixelType >::OneValue() ),
+  m_FullyConnected( false ),
+  m_TestSeeds( true ),
+  m_StopAtIndex( false ),
+  m_MultiThreader( MultiThreaderBase::New() ),
+  m_VisitedSize( 0 )
+{
+  m_StopIndex.Fill( 0 );
+  m_NumberOfThreads = m_MultiThreader->GetNumberOfThreads();
+}
+
+template< typename TImage >
+template< typename TCondition >
+SizeValueType
+ScanlineFloodFiller< TImage >
+::Fill( ImageType * image, const SeedContainerType & seeds, const TCondition & condition )
+{
+  const RegionType region = image->GetBufferedRegion();
+  const SizeValueType numberOfPixels = region.GetNumberOfPixels();
+  if ( numberOfPixels == 0 )
+    {
+    return 0;
+    }
+
+  // one bit per pixel, cleared at each fill
+  const SizeValueType numberOfWords = ( numberOfPixels + 63 ) / 64;
+  if ( m_VisitedSize != numberOfWords )
+    {
+    m_Visited.reset( new std::atomic< std::uint64_t >[numberOfWords] );
+    m_VisitedSize = numberOfWords;
+    }
+  for ( SizeValueType i = 0; i < numberOfWords; ++i )
+    {
+    m_Visited[i].store( 0, std::memory_order_relaxed );
+    }
+
+  PixelType * const     buffer = image->GetBufferPointer();
+  const PixelType       replaceValue = m_ReplaceValue;
+  const IndexValueType  firstX = region.GetIndex( 0 );
+  const IndexValueType  lastX = firstX + static_cast< IndexValueType >( region.GetSize( 0 ) ) - 1;
+  const bool            stopAtIndex = m_StopAtIndex && region.IsInside( m_StopIndex );
+  const OffsetValueType stopOffset = stopAtIndex ? image->ComputeOffset( m_StopIndex ) : -1;
+  std::atomic< bool >   stop( false );
+
+  // the neighbor lines of a span, and how much they extend it along the
+  // first dimension
+  std::vector< OffsetType > lineOffsets;
+  const IndexValueType      extension = m_FullyConnected ? 1 : 0;
+  if ( m_FullyConnected )
+    {
+    OffsetType offset;
+    offset.Fill( -1 );
+    offset[0] = 0;
+    bool done = ( ImageDimension == 1 );
+    while ( !done )
+      {
+      bool isCenter = true;
+      for ( unsigned int d = 1; d < ImageDimension; ++d )
+        {
+        isCenter = isCenter && ( offset[d] == 0 );
+        }
+      if ( !isCenter )
+        {
+        lineOffsets.push_back( offset );
+        }
+      done = true;
+      for ( unsigned int d = 1; d < ImageDimension && done; ++d )
+        {
+        if ( offset[d] < 1 )
+          {
+          ++offset[d];
+          done = false;
+          }
+        else
+          {
+          offset[d] = -1;
+          }
+        }
+      }
+    }
+  else
+    {
+    for ( unsigned int d = 1; d < ImageDimension; ++d )
+      {
+      OffsetType offset;
+      offset.Fill( 0 );
+      offset[d] = -1;
+      lineOffsets.push_back( offset );
+      offset[d] = 1;
+      lineOffsets.push_back( offset );
+      }
+    }
+
+  // fill a claimed pixel, and record whether the fill must stop
+  auto fillPixel = [&]( OffsetValueType offset )
+    {
+    buffer[offset] = replaceValue;
+    if ( offset == stopOffset )
+      {
+      stop.store( true, std::memory_order_relaxed );
+      }
+    };
+
+  // fill the span of the pixels which can be claimed and satisfy the
+  // condition around a filled pixel
+  auto expand = [&]( IndexType index, OffsetValueType offset, SizeValueType & count ) -> Span
+    {
+    const IndexValueType x = index[0];
+    IndexValueType       start = x;
+    while ( start > firstX && this->Claim( offset - ( x - start ) - 1 ) )
+      {
+      index[0] = start - 1;
+      if ( !condition( index ) )
+        {
+        break;
+        }
+      --start;
+      fillPixel( offset - ( x - start ) );
+      ++count;
+      }
+    IndexValueType last = x;
+    while ( last < lastX && this->Claim( offset + ( last - x ) + 1 ) )
+      {
+      index[0] = last + 1;
+      if ( !condition( index ) )
+        {
+        break;
+        }
+      ++last;
+      fillPixel( offset + ( last - x ) );
+      ++count;
+      }
+    Span span;
+    span.m_Start = index;
+    span.m_Start[0] = start;
+    span.m_Last = last;
+    return span;
+    };
+
+  // fill the spans of the neighbor lines of a span
+  auto processSpan = [&]( const Span & span, SpanContainerType & spans, SizeValueType & count )
+    {
+    for ( const OffsetType & lineOffset : lineOffsets )
+      {
+      IndexType index = span.m_Start + lineOffset;
+      bool      isInside = true;
+      for ( unsigned int d = 1; d < ImageDimension; ++d )
+        {
+        isInside = isInside && ( index[d] >= region.GetIndex( d ) )
+          && ( index[d] < region.GetIndex( d ) + static_cast< IndexValueType >( region.GetSize( d ) ) );
+        }
+      if ( !isInside )
+        {
+        continue;
+        }
+      const IndexValueType first = std::max( span.m_Start[0] - extension, firstX );
+      const IndexValueType last = std::min( span.m_Last + extension, lastX );
+      index[0] = first;
+      const OffsetValueType firstOffset = image->ComputeOffset( index );
+      for ( IndexValueType x = first; x <= last; ++x )
+        {
+        const OffsetValueType offset = firstOffset + ( x - first );
+        if ( !this->Claim( offset ) )
+          {
+          continue;
+          }
+        index[0] = x;
+        if ( !condition( index ) )
+          {
+          continue;
+          }
+        fillPixel( offset );
+        ++count;
+        const Span newSpan = expand( index, offset, count );
+        spans.push_back( newSpan );
+        x = newSpan.m_Last + 1;
+        }
+      }
+    };
+
+  // the seeds
+  SizeValueType     count = 0;
+  SpanContainerType front;
+  std::vector< std::pair< IndexType, OffsetValueType > > filledSeeds;
+  for ( const IndexType & seed : seeds )
+    {
+    if ( !region.IsInside( seed ) )
+      {
+      continue;
+      }
+    const OffsetValueType offset = image->ComputeOffset( seed );
+    if ( this->Claim( offset ) && ( !m_TestSeeds || condition( seed ) ) )
+      {
+      fillPixel( offset );
+      ++count;
+      filledSeeds.push_back( std::make_pair( seed, offset ) );
+      }
+    }
+  for ( const auto & seed : filledSeeds )
+    {
+    front.push_back( expand( seed.first, seed.second, count ) );
+    }
+
+  // the front is processed in rounds. In each round, the spans are split
+  // between the threads, which fill from them until a number of spans is
+  // processed, and return the remaining spans for the next round.
+  constexpr SizeValueType SpansPerRound = 4096;
+  MultiThreaderBase *     multiThreader = m_MultiThreader;
+  multiThreader->SetNumberOfThreads( m_NumberOfThreads );
+  std::mutex              mutex;
+  while ( !front.empty() && !stop.load( std::memory_order_relaxed ) )
+    {
+    if ( m_NumberOfThreads < 2 || front.size() < m_NumberOfThreads )
+      {
+      // a single stack, until there are enough spans for the threads
+      while ( !front.empty() && !stop.load( std::memory_order_relaxed )
+              && ( m_NumberOfThreads < 2 || front.size() < m_NumberOfThreads ) )
+        {
+        const Span span = front.back();
+        front.pop_back();
+        processSpan( span, front, count );
+        }
+      continue;
+      }
+
+    SpanContainerType nextFront;
+    ImageRegion< 1 > spanRegion;
+    spanRegion.SetIndex( 0, 0 );
+    spanRegion.SetSize( 0, front.size() );
+    multiThreader->template ParallelizeImageRegion< 1 >(
+      spanRegion,
+      [&]( const ImageRegion< 1 > & subRegion )
+        {
+        const SizeValueType begin = subRegion.GetIndex( 0 );
+        const SizeValueType end = begin + subRegion.GetSize( 0 );
+        SpanContainerType   spans( front.begin() + begin, front.begin() + end );
+        SizeValueType       localCount = 0;
+        SizeValueType       processed = 0;
+        while ( !spans.empty() && processed < SpansPerRound && !stop.load( std::memory_order_relaxed ) )
+          {
+          const Span span = spans.back();
+          spans.pop_back();
+          processSpan( span, spans, localCount );
+          ++processed;
+          }
+        std::lock_guard< std::mutex > lock( mutex );
+        count += localCount;
+        nextFront.insert( nextFront.end(), spans.begin(), spans.end() );
+        },
+      nullptr );
+    front.swap( nextFront );
+    }
+
+  return count;
+}
+
+template< typename TImage >
+void
+ScanlineFloodFiller< TImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "ReplaceValue: "
+     << static_cast< typename NumericTraits< PixelType >::PrintType >( m_ReplaceValue ) << std::endl;
+  os << indent << "FullyConnected: " << m_FullyConnected << std::endl;
+  os << indent << "TestSeeds: " << m_TestSeeds << std::endl;
+  os << indent << "StopIndex: " << m_StopIndex << std::endl;
+  os << indent << "StopAtIndex: " << m_StopAtIndex << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "MultiThreader: " << m_MultiThreader.GetPointer() << std::endl;
+}
+} // end namespace itk
+
+#endif
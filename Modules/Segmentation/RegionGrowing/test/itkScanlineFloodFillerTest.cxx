@@ -0,0 +1,248 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkScanlineFloodFiller.h"
+#include "itkBinaryThresholdImageFunction.h"
+#include "itkFloodFilledImageFunctionConditionalIterator.h"
+#include "itkShapedFloodFilledImageFunctionConditionalIterator.h"
+#include "itkConnectedThresholdImageFilter.h"
+#include "itkConfidenceConnectedImageFilter.h"
+#include "itkIsolatedConnectedImageFilter.h"
+#include "itkNeighborhoodConnectedImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+template< typename TImage >
+bool SameImages( const TImage * image1, const TImage * image2, const char * name )
+{
+  itk::ImageRegionConstIterator< TImage > it1( image1, image1->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< TImage > it2( image2, image2->GetBufferedRegion() );
+  unsigned int differences = 0;
+  unsigned int filled = 0;
+  for( ; !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    differences += ( it1.Get() != it2.Get() );
+    filled += ( it1.Get() != 0 );
+    }
+  std::cout << name << ": " << filled << " filled pixels, " << differences << " differences" << std::endl;
+  return differences == 0;
+}
+
+template< typename TFilter, typename TImage >
+bool SameForAllThreads( TFilter * filter, const char * name )
+{
+  filter->SetNumberOfThreads( 1 );
+  TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+  typename TImage::Pointer serial = filter->GetOutput();
+  serial->DisconnectPipeline();
+
+  filter->SetNumberOfThreads( 4 );
+  TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+  return SameImages( serial.GetPointer(), filter->GetOutput(), name );
+}
+}
+
+template< unsigned int VDimension >
+int ScanlineFloodFiller( const typename itk::Image< unsigned char, VDimension >::SizeType & size,
+                         double fraction )
+{
+  using ImageType = itk::Image< unsigned char, VDimension >;
+  using IndexType = typename ImageType::IndexType;
+
+  // noise, close to the percolation threshold to get many components with
+  // complex shapes
+  typename ImageType::Pointer input = ImageType::New();
+  input->SetRegions( size );
+  input->Allocate();
+  using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+  itk::ImageRegionIterator< ImageType > iIt( input, input->GetBufferedRegion() );
+  for( ; !iIt.IsAtEnd(); ++iIt )
+    {
+    iIt.Set( static_cast< unsigned char >( generator->GetIntegerVariate( 255 ) ) );
+    }
+  const auto upper = static_cast< unsigned char >( 255 * fraction );
+
+  // seeds in the range, and one out of it
+  std::vector< IndexType > seeds;
+  while( seeds.size() < 5 )
+    {
+    IndexType seed;
+    for( unsigned int d = 0; d < VDimension; d++ )
+      {
+      seed[d] = generator->GetIntegerVariate( size[d] - 1 );
+      }
+    if( ( input->GetPixel( seed ) <= upper ) == ( seeds.size() < 4 ) )
+      {
+      seeds.push_back( seed );
+      }
+    }
+  IndexType outside;
+  outside.Fill( -1 );
+  seeds.push_back( outside );
+
+  using FunctionType = itk::BinaryThresholdImageFunction< ImageType >;
+  typename FunctionType::Pointer function = FunctionType::New();
+  function->SetInputImage( input );
+  function->ThresholdBetween( 0, upper );
+  auto condition = [&function]( const IndexType & index ) { return function->EvaluateAtIndex( index ); };
+
+  using FillerType = itk::ScanlineFloodFiller< ImageType >;
+  typename FillerType::Pointer filler = FillerType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( filler, ScanlineFloodFiller, Object );
+  TEST_SET_GET_BOOLEAN( filler, FullyConnected, false );
+  TEST_SET_GET_BOOLEAN( filler, TestSeeds, true );
+  TEST_SET_GET_BOOLEAN( filler, StopAtIndex, false );
+  filler->SetReplaceValue( 7 );
+  TEST_SET_GET_VALUE( 7, filler->GetReplaceValue() );
+
+  bool passed = true;
+  for( unsigned int test = 0; test < 3; test++ )
+    {
+    // the flood filled iterators
+    typename ImageType::Pointer expected = ImageType::New();
+    expected->SetRegions( size );
+    expected->Allocate( true );
+    if( test == 0 )
+      {
+      itk::FloodFilledImageFunctionConditionalIterator< ImageType, FunctionType > it( expected, function, seeds );
+      for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+        {
+        it.Set( 7 );
+        }
+      }
+    else if( test == 1 )
+      {
+      itk::ShapedFloodFilledImageFunctionConditionalIterator< ImageType, FunctionType > it( expected, function, seeds );
+      it.FullyConnectedOn();
+      for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+        {
+        it.Set( 7 );
+        }
+      }
+    else
+      {
+      // the seeds are not tested without GoToBegin()
+      itk::FloodFilledImageFunctionConditionalIterator< ImageType, FunctionType > it( expected, function, seeds );
+      for( ; !it.IsAtEnd(); ++it )
+        {
+        it.Set( 7 );
+        }
+      }
+
+    const char * names[] = { "face connected", "fully connected", "untested seeds" };
+    for( unsigned int threads = 1; threads < 6; threads += 3 )
+      {
+      typename ImageType::Pointer output = ImageType::New();
+      output->SetRegions( size );
+      output->Allocate( true );
+      filler->SetFullyConnected( test == 1 );
+      filler->SetTestSeeds( test != 2 );
+      filler->SetNumberOfThreads( threads );
+      const itk::SizeValueType count = filler->Fill( output, seeds, condition );
+      if( !SameImages( expected.GetPointer(), output.GetPointer(), names[test] ) )
+        {
+        std::cerr << "The filler differs from the iterator with " << threads << " threads" << std::endl;
+        passed = false;
+        }
+      itk::SizeValueType expectedCount = 0;
+      itk::ImageRegionConstIterator< ImageType > eIt( expected, expected->GetBufferedRegion() );
+      for( ; !eIt.IsAtEnd(); ++eIt )
+        {
+        expectedCount += ( eIt.Get() != 0 );
+        }
+      TEST_EXPECT_EQUAL( count, expectedCount );
+      }
+    }
+
+  // a fill stopped at an index fills it
+  typename ImageType::Pointer output = ImageType::New();
+  output->SetRegions( size );
+  output->Allocate( true );
+  filler->SetFullyConnected( false );
+  filler->SetTestSeeds( true );
+  filler->SetStopIndex( seeds[0] );
+  filler->StopAtIndexOn();
+  filler->Fill( output, seeds, condition );
+  TEST_EXPECT_EQUAL( static_cast< int >( output->GetPixel( seeds[0] ) ), 7 );
+  filler->StopAtIndexOff();
+
+  // the filters do not depend on the number of threads
+  using ConnectedThresholdType = itk::ConnectedThresholdImageFilter< ImageType, ImageType >;
+  typename ConnectedThresholdType::Pointer connectedThreshold = ConnectedThresholdType::New();
+  connectedThreshold->SetInput( input );
+  connectedThreshold->SetLower( 0 );
+  connectedThreshold->SetUpper( upper );
+  connectedThreshold->SetSeed( seeds[0] );
+  connectedThreshold->AddSeed( seeds[1] );
+  connectedThreshold->SetConnectivity( ConnectedThresholdType::FullConnectivity );
+  passed &= SameForAllThreads< ConnectedThresholdType, ImageType >( connectedThreshold, "ConnectedThreshold" );
+
+  using NeighborhoodConnectedType = itk::NeighborhoodConnectedImageFilter< ImageType, ImageType >;
+  typename NeighborhoodConnectedType::Pointer neighborhoodConnected = NeighborhoodConnectedType::New();
+  neighborhoodConnected->SetInput( input );
+  neighborhoodConnected->SetLower( 0 );
+  neighborhoodConnected->SetUpper( 220 );
+  neighborhoodConnected->SetSeed( seeds[0] );
+  neighborhoodConnected->SetReplaceValue( 255 );
+  passed &= SameForAllThreads< NeighborhoodConnectedType, ImageType >( neighborhoodConnected, "NeighborhoodConnected" );
+
+  using ConfidenceConnectedType = itk::ConfidenceConnectedImageFilter< ImageType, ImageType >;
+  typename ConfidenceConnectedType::Pointer confidenceConnected = ConfidenceConnectedType::New();
+  confidenceConnected->SetInput( input );
+  confidenceConnected->SetSeed( seeds[0] );
+  confidenceConnected->AddSeed( seeds[2] );
+  confidenceConnected->SetInitialNeighborhoodRadius( 1 );
+  confidenceConnected->SetMultiplier( 1.0 );
+  confidenceConnected->SetNumberOfIterations( 3 );
+  confidenceConnected->SetReplaceValue( 255 );
+  passed &= SameForAllThreads< ConfidenceConnectedType, ImageType >( confidenceConnected, "ConfidenceConnected" );
+
+  using IsolatedConnectedType = itk::IsolatedConnectedImageFilter< ImageType, ImageType >;
+  typename IsolatedConnectedType::Pointer isolatedConnected = IsolatedConnectedType::New();
+  isolatedConnected->SetInput( input );
+  isolatedConnected->SetSeed1( seeds[0] );
+  isolatedConnected->SetSeed2( seeds[1] );
+  isolatedConnected->SetLower( 0 );
+  isolatedConnected->SetUpper( 255 );
+  passed &= SameForAllThreads< IsolatedConnectedType, ImageType >( isolatedConnected, "IsolatedConnected" );
+  std::cout << "Isolated value: " << static_cast< int >( isolatedConnected->GetIsolatedValue() ) << std::endl;
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int itkScanlineFloodFillerTest( int, char * [] )
+{
+  itk::Size< 2 > size2D = {{ 157, 133 }};
+  if( ScanlineFloodFiller< 2 >( size2D, 0.6 ) == EXIT_FAILURE )
+    {
+    std::cerr << "2D Fails" << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::Size< 3 > size3D = {{ 41, 37, 29 }};
+  if( ScanlineFloodFiller< 3 >( size3D, 0.36 ) == EXIT_FAILURE )
+    {
+    std::cerr << "3D Fails" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
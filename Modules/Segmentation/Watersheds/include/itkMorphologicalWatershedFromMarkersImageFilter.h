@@ -19,6 +19,9 @@
 #define itkMorphologicalWatershedFromMarkersImageFilter_h
 
 #include "itkImageToImageFilter.h"
+#include "itkMath.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -64,6 +67,29 @@ namespace itk
  * Chapter 9.2 of Pierre Soille's book "Morphological Image Analysis:
  * Principles and Applications", Second Edition, Springer, 2003.
  *
+ * The flooding is single threaded by default. When ParallelFlooding is on,
+ * the image is split into blocks of BlockSize pixels along each dimension
+ * which are flooded concurrently, each from its own markers and from the
+ * pixels of its neighbor blocks found in the previous round. The rounds are
+ * repeated until the borders of the blocks do not change anymore. The
+ * result does not depend on the blocks or the number of threads, and is
+ * the one of the serial algorithm in which the pixels reached at the same
+ * level and in the same flooding wave are processed in a fixed order
+ * instead of the order of insertion in the queue:
+ *
+ * \li RASTER_ORDER processes them in the order of their indices;
+ * \li LABEL_ORDER processes first those reached from the lowest labels, and
+ *   then in the order of their indices, which favors the lowest labels on
+ *   the plateaus.
+ *
+ * The order is selected with SetTieBreak(), and only matters where two
+ * fronts meet in the same wave. The parallel flooding pays off when
+ * there are many markers, since a front crosses one block border per
+ * round. When watershed lines are marked, the fronts stopped by a line on
+ * a block border are withdrawn from the neighbor blocks; if the blocks do
+ * not settle in a number of rounds proportional to their number along each
+ * dimension, they are merged by two along each dimension.
+ *
  * This code was contributed in the Insight Journal paper:
  * "The watershed transform in ITK - discussion and new developments"
  * by Beare R., Lehmann G.
@@ -158,6 +184,31 @@ public:
   itkGetConstReferenceMacro(MarkWatershedLine, bool);
   itkBooleanMacro(MarkWatershedLine);
 
+  /**
+   * Set/Get whether the flooding is split in blocks processed by several
+   * threads. Default is false.
+   */
+  itkSetMacro(ParallelFlooding, bool);
+  itkGetConstReferenceMacro(ParallelFlooding, bool);
+  itkBooleanMacro(ParallelFlooding);
+
+  /** Order of the pixels reached in the same flooding wave, used by the
+   * parallel flooding. */
+  enum TieBreakType {
+    RASTER_ORDER = 0,
+    LABEL_ORDER = 1
+  };
+
+  /** Set/Get the order of the pixels reached in the same flooding wave.
+   * Default is RASTER_ORDER. */
+  itkSetMacro(TieBreak, int);
+  itkGetConstMacro(TieBreak, int);
+
+  /** Set/Get the size of the blocks of the parallel flooding along each
+   * dimension. The default, 0, uses blocks of about 32768 pixels. */
+  itkSetMacro(BlockSize, unsigned int);
+  itkGetConstMacro(BlockSize, unsigned int);
+
 protected:
   MorphologicalWatershedFromMarkersImageFilter();
   ~MorphologicalWatershedFromMarkersImageFilter() override {}
@@ -173,13 +224,51 @@ protected:
    * \sa ProcessObject::EnlargeOutputRequestedRegion() */
   void EnlargeOutputRequestedRegion( DataObject *itkNotUsed(output) ) override;
 
-  /** The filter is single threaded. */
+  /** The filter is single threaded unless ParallelFlooding is on. */
   void GenerateData() override;
 
+  /** Level and wave at which a pixel is reached by the parallel flooding,
+   * and its label. The offset of the first pixel of its block reached by
+   * the same front, and the neighbor from which it has been reached, are
+   * used to withdraw the fronts coming back from a neighbor block. */
+  using WaveType = unsigned int;
+  struct FloodPixel
+  {
+    InputImagePixelType m_Level;
+    WaveType            m_Wave;
+    LabelImagePixelType m_Label;
+    OffsetValueType     m_Entry;
+    unsigned char       m_Neighbor;
+
+    bool operator==(const FloodPixel & other) const
+    {
+      return Math::ExactlyEquals( m_Level, other.m_Level ) && m_Wave == other.m_Wave && m_Label == other.m_Label
+             && m_Entry == other.m_Entry && m_Neighbor == other.m_Neighbor;
+    }
+  };
+  using FloodPixelVectorType = std::vector< FloodPixel >;
+
+  /** Flood the image by blocks in several threads. */
+  void ParallelFlood();
+
+  /** Flood a block from its markers and from the pixels around it, and
+   * store the result in flood. */
+  void FloodBlock(const LabelImageRegionType & block, const FloodPixelVectorType & halo, FloodPixelVectorType & flood);
+
+  /** Offsets in the output buffer of the pixels around a block, in raster
+   * order. */
+  void ComputeHaloOffsets(const LabelImageRegionType & block, std::vector< OffsetValueType > & offsets) const;
+
 private:
   bool m_FullyConnected;
 
   bool m_MarkWatershedLine;
+
+  bool m_ParallelFlooding;
+
+  int m_TieBreak;
+
+  unsigned int m_BlockSize;
 }; // end of class
 } // end namespace itk
 
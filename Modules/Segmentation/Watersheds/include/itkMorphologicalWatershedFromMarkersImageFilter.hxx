@@ -19,6 +19,8 @@
 #define itkMorphologicalWatershedFromMarkersImageFilter_hxx
 
 #include <algorithm>
+#include <cmath>
+#include <functional>
 #include <queue>
 #include <list>
 #include "itkMorphologicalWatershedFromMarkersImageFilter.h"
@@ -29,6 +31,7 @@
 #include "itkConstantBoundaryCondition.h"
 #include "itkSize.h"
 #include "itkConnectedComponentAlgorithm.h"
+#include "itkMultiThreaderBase.h"
 
 namespace itk
 {
@@ -37,7 +40,10 @@ template< typename TInputImage, typename TLabelImage >
 MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
 ::MorphologicalWatershedFromMarkersImageFilter():
   m_FullyConnected( false ),
-  m_MarkWatershedLine( true )
+  m_MarkWatershedLine( true ),
+  m_ParallelFlooding( false ),
+  m_TieBreak( RASTER_ORDER ),
+  m_BlockSize( 0 )
 
 {
   this->SetNumberOfRequiredInputs(2);
@@ -120,6 +126,12 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
     itkExceptionMacro(<< "Marker and input must have the same size.");
     }
 
+  if ( m_ParallelFlooding )
+    {
+    this->ParallelFlood();
+    return;
+    }
+
   // FAH (in french: File d'Attente Hierarchique)
   using QueueType = std::queue< IndexType >;
   using MapType = std::map< InputImagePixelType, QueueType >;
@@ -446,6 +458,491 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
 }
 
 
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::ParallelFlood()
+{
+  static const LabelImagePixelType bgLabel =
+    NumericTraits< LabelImagePixelType >::ZeroValue();
+  const WaveType unreached = NumericTraits< WaveType >::max();
+
+  const LabelImageType *       markerImage = this->GetMarkerImage();
+  const InputImagePixelType *  input = this->GetInput()->GetBufferPointer();
+  const LabelImagePixelType *  marker = markerImage->GetBufferPointer();
+  LabelImageType *             outputImage = this->GetOutput();
+  LabelImagePixelType *        output = outputImage->GetBufferPointer();
+  const LabelImageRegionType   region = outputImage->GetRequestedRegion();
+  const SizeValueType          numberOfPixels = region.GetNumberOfPixels();
+
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  // the markers are reached before all the other pixels. In Meyer's
+  // algorithm, their neighbors are queued at their own level.
+  FloodPixelVectorType flood( numberOfPixels );
+  ImageRegion< 1 >     pixelRange;
+  pixelRange.SetSize( 0, numberOfPixels );
+  multiThreader->template ParallelizeImageRegion< 1 >(
+    pixelRange,
+    [&](const ImageRegion< 1 > & range)
+      {
+      const SizeValueType end = range.GetIndex(0) + range.GetSize(0);
+      for ( SizeValueType i = range.GetIndex(0); i < end; i++ )
+        {
+        FloodPixel & pixel = flood[i];
+        pixel.m_Label = marker[i];
+        pixel.m_Level = m_MarkWatershedLine ? NumericTraits< InputImagePixelType >::NonpositiveMin() : input[i];
+        pixel.m_Wave = ( pixel.m_Label != bgLabel ) ? 0 : unreached;
+        pixel.m_Entry = -1;
+        pixel.m_Neighbor = 0;
+        }
+      },
+    nullptr);
+
+  // split the image in blocks
+  unsigned int blockSize = m_BlockSize;
+  if ( blockSize == 0 )
+    {
+    blockSize = static_cast< unsigned int >( std::pow( 32768.0, 1.0 / ImageDimension ) );
+    }
+  Size< ImageDimension > grid;
+  auto blockRegion = [&](SizeValueType b)
+    {
+    LabelImageRegionType block;
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      const SizeValueType start = ( b % grid[d] ) * blockSize;
+      b /= grid[d];
+      block.SetIndex( d, region.GetIndex(d) + static_cast< IndexValueType >( start ) );
+      block.SetSize( d, std::min( static_cast< SizeValueType >( blockSize ), region.GetSize(d) - start ) );
+      }
+    return block;
+    };
+
+  // Flood the blocks whose surroundings have changed, until none changes.
+  // When the border of a block becomes a watershed line, the fronts which
+  // went through it have to be withdrawn from the other blocks, and may
+  // bounce between the blocks for a long time. If the blocks do not settle
+  // in a number of rounds proportional to their number along each
+  // dimension, they are merged by two along each dimension.
+  for ( bool settled = false; !settled; blockSize *= 2 )
+    {
+    SizeValueType numberOfBlocks = 1;
+    SizeValueType maximumNumberOfRounds = 8;
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      grid[d] = ( region.GetSize(d) + blockSize - 1 ) / blockSize;
+      numberOfBlocks *= grid[d];
+      maximumNumberOfRounds += 2 * grid[d];
+      }
+
+    std::vector< FloodPixelVectorType > halos( numberOfBlocks );
+    std::vector< unsigned char >        changed( numberOfBlocks, 1 );
+    ImageRegion< 1 >                    blockRange;
+    blockRange.SetSize( 0, numberOfBlocks );
+    for ( SizeValueType round = 0; round < maximumNumberOfRounds || numberOfBlocks == 1; round++ )
+      {
+      multiThreader->template ParallelizeImageRegion< 1 >(
+        blockRange,
+        [&](const ImageRegion< 1 > & range)
+          {
+          std::vector< OffsetValueType > offsets;
+          FloodPixelVectorType           halo;
+          const SizeValueType            end = range.GetIndex(0) + range.GetSize(0);
+          for ( SizeValueType b = range.GetIndex(0); b < end; b++ )
+            {
+            this->ComputeHaloOffsets( blockRegion(b), offsets );
+            halo.resize( offsets.size() );
+            for ( size_t i = 0; i < offsets.size(); i++ )
+              {
+              halo[i] = flood[offsets[i]];
+              }
+            changed[b] = ( round == 0 || halo != halos[b] );
+            if ( changed[b] )
+              {
+              halos[b].swap( halo );
+              }
+            }
+          },
+        nullptr);
+
+      std::vector< SizeValueType > blocks;
+      for ( SizeValueType b = 0; b < numberOfBlocks; b++ )
+        {
+        if ( changed[b] )
+          {
+          blocks.push_back( b );
+          }
+        }
+      if ( blocks.empty() )
+        {
+        settled = true;
+        break;
+        }
+
+      ImageRegion< 1 > changedRange;
+      changedRange.SetSize( 0, blocks.size() );
+      multiThreader->template ParallelizeImageRegion< 1 >(
+        changedRange,
+        [&](const ImageRegion< 1 > & range)
+          {
+          const SizeValueType end = range.GetIndex(0) + range.GetSize(0);
+          for ( SizeValueType i = range.GetIndex(0); i < end; i++ )
+            {
+            this->FloodBlock( blockRegion( blocks[i] ), halos[blocks[i]], flood );
+            }
+          },
+        nullptr);
+      }
+    }
+
+  multiThreader->template ParallelizeImageRegion< 1 >(
+    pixelRange,
+    [&](const ImageRegion< 1 > & range)
+      {
+      const SizeValueType end = range.GetIndex(0) + range.GetSize(0);
+      for ( SizeValueType i = range.GetIndex(0); i < end; i++ )
+        {
+        output[i] = flood[i].m_Label;
+        }
+      },
+    nullptr);
+  this->UpdateProgress( 1.0f );
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::ComputeHaloOffsets(const LabelImageRegionType & block, std::vector< OffsetValueType > & offsets) const
+{
+  const LabelImageType * outputImage = this->GetOutput();
+
+  offsets.clear();
+  LabelImageRegionType halo = block;
+  halo.PadByRadius( 1 );
+  halo.Crop( outputImage->GetRequestedRegion() );
+
+  // only the ends of the lines crossing the block are outside of it
+  const IndexValueType  begin = halo.GetIndex(0);
+  const IndexValueType  end = begin + static_cast< IndexValueType >( halo.GetSize(0) );
+  const IndexValueType  blockBegin = block.GetIndex(0);
+  const IndexValueType  blockEnd = blockBegin + static_cast< IndexValueType >( block.GetSize(0) );
+  const SizeValueType   numberOfLines = halo.GetNumberOfPixels() / halo.GetSize(0);
+  IndexType             idx = halo.GetIndex();
+  for ( SizeValueType l = 0; l < numberOfLines; l++ )
+    {
+    bool crossesBlock = true;
+    for ( unsigned int d = 1; d < ImageDimension; d++ )
+      {
+      crossesBlock = crossesBlock && idx[d] >= block.GetIndex(d)
+                     && idx[d] < block.GetIndex(d) + static_cast< IndexValueType >( block.GetSize(d) );
+      }
+    const OffsetValueType lineOffset = outputImage->ComputeOffset( idx ) - begin;
+    if ( crossesBlock )
+      {
+      if ( begin < blockBegin )
+        {
+        offsets.push_back( lineOffset + begin );
+        }
+      if ( end > blockEnd )
+        {
+        offsets.push_back( lineOffset + end - 1 );
+        }
+      }
+    else
+      {
+      for ( IndexValueType x = begin; x < end; x++ )
+        {
+        offsets.push_back( lineOffset + x );
+        }
+      }
+
+    // next line
+    for ( unsigned int d = 1; d < ImageDimension; d++ )
+      {
+      if ( ++idx[d] < halo.GetIndex(d) + static_cast< IndexValueType >( halo.GetSize(d) ) )
+        {
+        break;
+        }
+      idx[d] = halo.GetIndex(d);
+      }
+    }
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::FloodBlock(const LabelImageRegionType & block, const FloodPixelVectorType & halo, FloodPixelVectorType & flood)
+{
+  static const LabelImagePixelType bgLabel =
+    NumericTraits< LabelImagePixelType >::ZeroValue();
+  const WaveType unreached = NumericTraits< WaveType >::max();
+
+  const LabelImageType *       outputImage = this->GetOutput();
+  const LabelImageRegionType & region = outputImage->GetRequestedRegion();
+  const InputImagePixelType *  input = this->GetInput()->GetBufferPointer();
+  const LabelImagePixelType *  marker = this->GetMarkerImage()->GetBufferPointer();
+
+  // state of the pixels of the local copy
+  enum { OUTSIDE, HALO, MARKER, FREE, QUEUED, DONE };
+
+  // copy of the block, surrounded by the pixels of the neighbor blocks and by
+  // a layer of pixels never processed, so that no bound checking is needed
+  LabelImageRegionType local = block;
+  local.PadByRadius( 2 );
+  LabelImageRegionType haloRegion = block;
+  haloRegion.PadByRadius( 1 );
+  const SizeValueType localSize = local.GetNumberOfPixels();
+
+  FloodPixelVectorType               pixels( localSize );
+  std::vector< InputImagePixelType > values( localSize );
+  std::vector< unsigned char >       state( localSize, OUTSIDE );
+
+  // neighbors in the local copy and in the output buffer
+  OffsetValueType localStride[ImageDimension];
+  localStride[0] = 1;
+  for ( unsigned int d = 1; d < ImageDimension; d++ )
+    {
+    localStride[d] = localStride[d - 1] * local.GetSize(d - 1);
+    }
+  std::vector< OffsetValueType > localOffsets;
+  std::vector< OffsetValueType > imageOffsets;
+  Offset< ImageDimension >       neighbor;
+  neighbor.Fill( -1 );
+  for ( bool done = false; !done; )
+    {
+    unsigned int nonZero = 0;
+    OffsetValueType localOffset = 0;
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      nonZero += ( neighbor[d] != 0 );
+      localOffset += neighbor[d] * localStride[d];
+      }
+    if ( nonZero == 1 || ( nonZero > 1 && m_FullyConnected ) )
+      {
+      localOffsets.push_back( localOffset );
+      imageOffsets.push_back( outputImage->ComputeOffset( region.GetIndex() + neighbor )
+                              - outputImage->ComputeOffset( region.GetIndex() ) );
+      }
+    done = true;
+    for ( unsigned int d = 0; d < ImageDimension && done; d++ )
+      {
+      if ( ++neighbor[d] <= 1 )
+        {
+        done = false;
+        }
+      else
+        {
+        neighbor[d] = -1;
+        }
+      }
+    }
+
+  // a pixel is processed before the pixels with a larger entry
+  struct FloodEntry
+  {
+    InputImagePixelType m_Level;
+    WaveType            m_Wave;
+    LabelImagePixelType m_Tie;
+    OffsetValueType     m_Index;
+    SizeValueType       m_Position;
+
+    bool operator>(const FloodEntry & other) const
+    {
+      if ( m_Level != other.m_Level )
+        {
+        return m_Level > other.m_Level;
+        }
+      if ( m_Wave != other.m_Wave )
+        {
+        return m_Wave > other.m_Wave;
+        }
+      if ( m_Tie != other.m_Tie )
+        {
+        return m_Tie > other.m_Tie;
+        }
+      return m_Index > other.m_Index;
+    }
+  };
+  using QueueType = std::priority_queue< FloodEntry, std::vector< FloodEntry >, std::greater< FloodEntry > >;
+  QueueType queue;
+
+  const bool labelOrder = ( m_TieBreak == LABEL_ORDER );
+  auto entry = [&](const FloodPixel & pixel, LabelImagePixelType label, OffsetValueType index, SizeValueType position)
+    {
+    return FloodEntry{ pixel.m_Level, pixel.m_Wave, labelOrder ? label : bgLabel, index, position };
+    };
+
+  // fill the local copy
+  std::vector< std::pair< SizeValueType, OffsetValueType > > inside;
+  inside.reserve( block.GetNumberOfPixels() );
+  std::vector< SizeValueType > markers;
+  auto                         haloIt = halo.begin();
+  IndexType                    idx = local.GetIndex();
+  for ( SizeValueType pos = 0; pos < localSize; pos++ )
+    {
+    if ( block.IsInside( idx ) )
+      {
+      const OffsetValueType i = outputImage->ComputeOffset( idx );
+      inside.emplace_back( pos, i );
+      values[pos] = input[i];
+      pixels[pos] = flood[i];
+      if ( marker[i] != bgLabel )
+        {
+        state[pos] = MARKER;
+        markers.push_back( inside.size() - 1 );
+        }
+      else
+        {
+        state[pos] = FREE;
+        pixels[pos].m_Wave = unreached;
+        pixels[pos].m_Label = bgLabel;
+        pixels[pos].m_Entry = -1;
+        }
+      }
+    else if ( haloRegion.IsInside( idx ) && region.IsInside( idx ) )
+      {
+      state[pos] = HALO;
+      values[pos] = input[outputImage->ComputeOffset( idx )];
+      pixels[pos] = *haloIt++;
+      const FloodPixel & pixel = pixels[pos];
+      if ( pixel.m_Label != bgLabel && pixel.m_Wave != unreached )
+        {
+        queue.push( entry( pixel, pixel.m_Label, outputImage->ComputeOffset( idx ), pos ) );
+        }
+      }
+
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      if ( ++idx[d] < local.GetIndex(d) + static_cast< IndexValueType >( local.GetSize(d) ) )
+        {
+        break;
+        }
+      idx[d] = local.GetIndex(d);
+      }
+    }
+
+  // only the markers with a free neighbor have to be flooded from
+  for ( SizeValueType m : markers )
+    {
+    const SizeValueType pos = inside[m].first;
+    for ( OffsetValueType o : localOffsets )
+      {
+      if ( state[pos + o] == FREE )
+        {
+        queue.push( entry( pixels[pos], pixels[pos].m_Label, inside[m].second, pos ) );
+        break;
+        }
+      }
+    }
+
+  while ( !queue.empty() )
+    {
+    const FloodEntry current = queue.top();
+    queue.pop();
+    FloodPixel & pixel = pixels[current.m_Position];
+
+    if ( state[current.m_Position] == HALO && m_MarkWatershedLine && pixel.m_Entry >= 0 )
+      {
+      // a front which entered the neighbor block from this block is
+      // withdrawn if the pixel it came from does not reach it anymore
+      const IndexType entryIndex = outputImage->ComputeIndex( pixel.m_Entry );
+      if ( haloRegion.IsInside( entryIndex ) )
+        {
+        SizeValueType e = 0;
+        for ( unsigned int d = 0; d < ImageDimension; d++ )
+          {
+          e += ( entryIndex[d] - local.GetIndex(d) ) * localStride[d];
+          }
+        const FloodPixel &  entryPixel = pixels[e];
+        const SizeValueType source = e - localOffsets[entryPixel.m_Neighbor];
+        const FloodPixel &  sourcePixel = pixels[source];
+        if ( state[source] != HALO && state[source] != OUTSIDE
+             && ( sourcePixel.m_Label != entryPixel.m_Label
+                  || ( values[e] > sourcePixel.m_Level
+                       ? ( entryPixel.m_Wave != 0 || Math::NotExactlyEquals( entryPixel.m_Level, values[e] ) )
+                       : ( entryPixel.m_Wave != sourcePixel.m_Wave + 1
+                           || Math::NotExactlyEquals( entryPixel.m_Level, sourcePixel.m_Level ) ) ) ) )
+          {
+          pixel.m_Label = bgLabel;
+          continue;
+          }
+        }
+      }
+
+    if ( state[current.m_Position] == QUEUED )
+      {
+      // Meyer's algorithm: the pixel gets the label of its neighbors flooded
+      // before it if they all have the same one, and is a watershed pixel
+      // otherwise
+      state[current.m_Position] = DONE;
+      LabelImagePixelType label = bgLabel;
+      bool                collision = false;
+      for ( size_t k = 0; k < localOffsets.size() && !collision; k++ )
+        {
+        const SizeValueType n = current.m_Position + localOffsets[k];
+        const FloodPixel &  other = pixels[n];
+        if ( other.m_Label == bgLabel
+             || ( state[n] == HALO
+                  && entry( other, other.m_Label, current.m_Index + imageOffsets[k], n ) > current ) )
+          {
+          continue;
+          }
+        collision = ( label != bgLabel && other.m_Label != label );
+        label = other.m_Label;
+        }
+      if ( collision )
+        {
+        continue;
+        }
+      pixel.m_Label = label;
+      }
+
+    // propagate to the free neighbors. In Beucher's algorithm, the neighbors
+    // get the label when they are queued.
+    for ( size_t k = 0; k < localOffsets.size(); k++ )
+      {
+      const SizeValueType n = current.m_Position + localOffsets[k];
+      if ( state[n] != FREE )
+        {
+        continue;
+        }
+      FloodPixel & other = pixels[n];
+      if ( values[n] > pixel.m_Level )
+        {
+        other.m_Level = values[n];
+        other.m_Wave = 0;
+        }
+      else
+        {
+        other.m_Level = pixel.m_Level;
+        other.m_Wave = pixel.m_Wave + 1;
+        }
+      other.m_Neighbor = static_cast< unsigned char >( k );
+      other.m_Entry = ( state[current.m_Position] == HALO ) ? current.m_Index + imageOffsets[k] : pixel.m_Entry;
+      if ( m_MarkWatershedLine )
+        {
+        state[n] = QUEUED;
+        }
+      else
+        {
+        state[n] = DONE;
+        other.m_Label = pixel.m_Label;
+        }
+      queue.push( entry( other, pixel.m_Label, current.m_Index + imageOffsets[k], n ) );
+      }
+    }
+
+  for ( const auto & p : inside )
+    {
+    flood[p.second] = pixels[p.first];
+    }
+}
+
+
 template< typename TInputImage, typename TLabelImage >
 void
 MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
@@ -455,6 +952,9 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
 
   os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
   os << indent << "MarkWatershedLine: "  << m_MarkWatershedLine << std::endl;
+  os << indent << "ParallelFlooding: "  << m_ParallelFlooding << std::endl;
+  os << indent << "TieBreak: "  << m_TieBreak << std::endl;
+  os << indent << "BlockSize: "  << m_BlockSize << std::endl;
 }
 
 } // end namespace itk
@@ -102,6 +102,23 @@ public:
   itkGetConstReferenceMacro(MarkWatershedLine, bool);
   itkBooleanMacro(MarkWatershedLine);
 
+  /**
+   * Set/Get whether the flooding is split in blocks processed by several
+   * threads. Default is false.
+   * \sa MorphologicalWatershedFromMarkersImageFilter
+   */
+  itkSetMacro(ParallelFlooding, bool);
+  itkGetConstReferenceMacro(ParallelFlooding, bool);
+  itkBooleanMacro(ParallelFlooding);
+
+  /**
+   * Set/Get the order of the pixels reached in the same flooding wave by
+   * the parallel flooding. Default is RASTER_ORDER.
+   * \sa MorphologicalWatershedFromMarkersImageFilter::TieBreakType
+   */
+  itkSetMacro(TieBreak, int);
+  itkGetConstMacro(TieBreak, int);
+
   /**
    */
   itkSetMacro(Level, InputImagePixelType);
@@ -129,6 +146,10 @@ private:
 
   bool m_MarkWatershedLine;
 
+  bool m_ParallelFlooding;
+
+  int m_TieBreak;
+
   InputImagePixelType m_Level;
 }; // end of class
 } // end namespace itk
@@ -33,6 +33,8 @@ MorphologicalWatershedImageFilter< TInputImage, TOutputImage >
 ::MorphologicalWatershedImageFilter():
   m_FullyConnected( false ),
   m_MarkWatershedLine( true ),
+  m_ParallelFlooding( false ),
+  m_TieBreak( MorphologicalWatershedFromMarkersImageFilter< TInputImage, TOutputImage >::RASTER_ORDER ),
   m_Level( NumericTraits< InputImagePixelType >::ZeroValue() )
 {
 }
@@ -109,6 +111,8 @@ MorphologicalWatershedImageFilter< TInputImage, TOutputImage >
   wshed->SetMarkerImage( label->GetOutput() );
   wshed->SetFullyConnected(m_FullyConnected);
   wshed->SetMarkWatershedLine(m_MarkWatershedLine);
+  wshed->SetParallelFlooding(m_ParallelFlooding);
+  wshed->SetTieBreak(m_TieBreak);
 
   if ( m_Level != NumericTraits< InputImagePixelType >::ZeroValue() )
     {
@@ -157,6 +161,8 @@ MorphologicalWatershedImageFilter< TInputImage, TOutputImage >
 
   os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
   os << indent << "MarkWatershedLine: "  << m_MarkWatershedLine << std::endl;
+  os << indent << "ParallelFlooding: "  << m_ParallelFlooding << std::endl;
+  os << indent << "TieBreak: "  << m_TieBreak << std::endl;
   os << indent << "Level: "
      << static_cast< typename NumericTraits< InputImagePixelType >::PrintType >( m_Level )
      << std::endl;
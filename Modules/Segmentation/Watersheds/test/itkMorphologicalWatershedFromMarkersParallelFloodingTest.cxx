@@ -0,0 +1,203 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+
+using GeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+
+// Random relief with the given number of levels, and markers made of
+// single pixels and small boxes.
+template< typename TInputImage, typename TLabelImage >
+void MakeImages( TInputImage * input, TLabelImage * markers, unsigned int levels, unsigned int numberOfMarkers )
+{
+  constexpr unsigned int Dimension = TInputImage::ImageDimension;
+
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 5678 );
+
+  itk::ImageRegionIteratorWithIndex< TInputImage > it( input, input->GetLargestPossibleRegion() );
+  for ( ; !it.IsAtEnd(); ++it )
+    {
+    if ( levels == 0 )
+      {
+      it.Set( generator->GetUniformVariate( 0.0, 1.0 ) );
+      }
+    else
+      {
+      it.Set( generator->GetIntegerVariate( levels - 1 ) );
+      }
+    }
+
+  markers->FillBuffer( 0 );
+  const typename TInputImage::SizeType size = input->GetLargestPossibleRegion().GetSize();
+  for ( unsigned int m = 1; m <= numberOfMarkers; ++m )
+    {
+    typename TLabelImage::RegionType box;
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      box.SetIndex( d, generator->GetIntegerVariate( size[d] - 1 ) );
+      box.SetSize( d, ( m % 3 ) ? 1 : 3 );
+      }
+    box.Crop( markers->GetLargestPossibleRegion() );
+    itk::ImageRegionIterator< TLabelImage > mIt( markers, box );
+    for ( ; !mIt.IsAtEnd(); ++mIt )
+      {
+      mIt.Set( m );
+      }
+    }
+}
+
+template< typename TInputImage, typename TLabelImage >
+typename TLabelImage::Pointer
+Watershed( TInputImage * input, TLabelImage * markers, bool markWatershedLine, bool fullyConnected,
+           bool parallel, int tieBreak, unsigned int blockSize, unsigned int numberOfThreads )
+{
+  using FilterType = itk::MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( input );
+  filter->SetMarkerImage( markers );
+  filter->SetMarkWatershedLine( markWatershedLine );
+  filter->SetFullyConnected( fullyConnected );
+  filter->SetParallelFlooding( parallel );
+  filter->SetTieBreak( tieBreak );
+  filter->SetBlockSize( blockSize );
+  filter->SetNumberOfThreads( numberOfThreads );
+  filter->Update();
+  return filter->GetOutput();
+}
+
+template< typename TLabelImage >
+itk::SizeValueType CountDifferences( const TLabelImage * a, const TLabelImage * b )
+{
+  itk::SizeValueType differences = 0;
+  itk::ImageRegionConstIterator< TLabelImage > aIt( a, a->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TLabelImage > bIt( b, b->GetLargestPossibleRegion() );
+  for ( ; !aIt.IsAtEnd(); ++aIt, ++bIt )
+    {
+    differences += ( aIt.Get() != bIt.Get() );
+    }
+  return differences;
+}
+
+}
+
+int itkMorphologicalWatershedFromMarkersParallelFloodingTest( int, char *[] )
+{
+  using LabelImageType2D = itk::Image< unsigned short, 2 >;
+  using FloatImageType = itk::Image< float, 2 >;
+  using LabelImageType3D = itk::Image< unsigned short, 3 >;
+  using CharImageType = itk::Image< unsigned char, 3 >;
+
+  using FilterType = itk::MorphologicalWatershedFromMarkersImageFilter< FloatImageType, LabelImageType2D >;
+  FilterType::Pointer filter = FilterType::New();
+  TEST_SET_GET_BOOLEAN( filter, ParallelFlooding, false );
+  TEST_SET_GET_VALUE( static_cast< int >( FilterType::RASTER_ORDER ), filter->GetTieBreak() );
+  TEST_SET_GET_VALUE( 0u, filter->GetBlockSize() );
+
+  // without ties, the parallel flooding gives the result of the serial one
+  FloatImageType::SizeType size2D;
+  size2D[0] = 97;
+  size2D[1] = 83;
+  FloatImageType::Pointer relief = FloatImageType::New();
+  relief->SetRegions( size2D );
+  relief->Allocate();
+  LabelImageType2D::Pointer markers2D = LabelImageType2D::New();
+  markers2D->SetRegions( size2D );
+  markers2D->Allocate();
+  MakeImages( relief.GetPointer(), markers2D.GetPointer(), 0, 40 );
+
+  for ( bool markWatershedLine : { false, true } )
+    {
+    for ( bool fullyConnected : { false, true } )
+      {
+      LabelImageType2D::Pointer serial =
+        Watershed( relief.GetPointer(), markers2D.GetPointer(), markWatershedLine, fullyConnected, false,
+                   FilterType::RASTER_ORDER, 0, 1 );
+      for ( unsigned int blockSize : { 0u, 7u, 16u } )
+        {
+        LabelImageType2D::Pointer parallel =
+          Watershed( relief.GetPointer(), markers2D.GetPointer(), markWatershedLine, fullyConnected, true,
+                     FilterType::RASTER_ORDER, blockSize, 4 );
+        const itk::SizeValueType differences = CountDifferences( serial.GetPointer(), parallel.GetPointer() );
+        if ( differences != 0 )
+          {
+          std::cerr << "Parallel flooding with MarkWatershedLine " << markWatershedLine << ", FullyConnected "
+                    << fullyConnected << " and block size " << blockSize << ": " << differences
+                    << " pixels differ from the serial flooding" << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+
+  // with plateaus, the result depends only on the tie break order
+  CharImageType::SizeType size3D;
+  size3D[0] = 31;
+  size3D[1] = 27;
+  size3D[2] = 23;
+  CharImageType::Pointer plateaus = CharImageType::New();
+  plateaus->SetRegions( size3D );
+  plateaus->Allocate();
+  LabelImageType3D::Pointer markers3D = LabelImageType3D::New();
+  markers3D->SetRegions( size3D );
+  markers3D->Allocate();
+  MakeImages( plateaus.GetPointer(), markers3D.GetPointer(), 4, 30 );
+
+  for ( bool markWatershedLine : { false, true } )
+    {
+    for ( bool fullyConnected : { false, true } )
+      {
+      LabelImageType3D::Pointer serial =
+        Watershed( plateaus.GetPointer(), markers3D.GetPointer(), markWatershedLine, fullyConnected, false,
+                   FilterType::RASTER_ORDER, 0, 1 );
+      for ( int tieBreak : { FilterType::RASTER_ORDER, FilterType::LABEL_ORDER } )
+        {
+        LabelImageType3D::Pointer reference =
+          Watershed( plateaus.GetPointer(), markers3D.GetPointer(), markWatershedLine, fullyConnected, true,
+                     tieBreak, 100, 1 );
+        for ( unsigned int blockSize : { 4u, 9u } )
+          {
+          LabelImageType3D::Pointer parallel =
+            Watershed( plateaus.GetPointer(), markers3D.GetPointer(), markWatershedLine, fullyConnected, true,
+                       tieBreak, blockSize, 3 );
+          const itk::SizeValueType differences = CountDifferences( reference.GetPointer(), parallel.GetPointer() );
+          if ( differences != 0 )
+            {
+            std::cerr << "Parallel flooding with MarkWatershedLine " << markWatershedLine << ", FullyConnected "
+                      << fullyConnected << ", tie break " << tieBreak << " and block size " << blockSize << ": "
+                      << differences << " pixels differ from the flooding in a single block" << std::endl;
+            return EXIT_FAILURE;
+            }
+          }
+        std::cout << "MarkWatershedLine " << markWatershedLine << ", FullyConnected " << fullyConnected
+                  << ", tie break " << tieBreak << ": "
+                  << CountDifferences( serial.GetPointer(), reference.GetPointer() )
+                  << " pixels differ from the serial flooding" << std::endl;
+        }
+      }
+    }
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}